@@ -5,8 +5,16 @@
 
 #define _POSIX_C_SOURCE 199309L
 
+#include "cel/cel_activation.h"
+#include "cel/cel_columnar.h"
+#include "cel/cel_incremental.h"
 #include "cel/cel_value.h"
 #include "cel/cel_program.h"
+#include "cel/cel_program_cache.h"
+#include "cel/cel_pool.h"
+#include "cel/cel_ruleset.h"
+#include "cel/cel_serialize.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -67,51 +75,1398 @@ static void bench_value_creation(void)
 	       elapsed, ITERATIONS / 10, (ITERATIONS / 10) / (elapsed / 1000.0));
 }
 
+/**
+ * @brief 使用指定编译选项编译并计时表达式
+ *
+ * @return 耗时 (毫秒)，编译失败返回负数
+ */
+static double bench_compiled(const char *expr,
+			     const cel_compile_options_t *options,
+			     cel_context_t *ctx)
+{
+	cel_compile_result_t compile_result = cel_compile_with_options(expr, options);
+	if (compile_result.has_errors || !compile_result.program) {
+		cel_compile_result_destroy(&compile_result);
+		return -1.0;
+	}
+
+	/* Warmup */
+	for (int i = 0; i < WARMUP; i++) {
+		cel_execute_result_t result = cel_execute(compile_result.program, ctx);
+		cel_execute_result_destroy(&result);
+	}
+
+	double start = get_time_ms();
+	for (int i = 0; i < ITERATIONS; i++) {
+		cel_execute_result_t result = cel_execute(compile_result.program, ctx);
+		cel_execute_result_destroy(&result);
+	}
+	double elapsed = get_time_ms() - start;
+
+	cel_compile_result_destroy(&compile_result);
+	return elapsed;
+}
+
+/**
+ * @brief 使用指定执行引擎编译并计时表达式
+ */
+static double bench_program(const char *expr, cel_engine_e engine,
+			    cel_context_t *ctx)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = engine;
+	return bench_compiled(expr, &options, ctx);
+}
+
 static void bench_expression_eval(void)
 {
-	printf("\n=== Expression Evaluation Benchmark ===\n");
+	printf("\n=== Expression Evaluation Benchmark (tree-walk vs bytecode) ===\n");
 
 	const char *expressions[] = {
 		"1 + 2",
 		"1 + 2 * 3",
 		"x + y",
 		"x > 0 && y < 100",
+		"x * 2 + y * 3 - (x - y) / 2",
+		"x > y ? x - y : y - x",
+		"size(s) > 3 && s.startsWith(\"he\")",
+		"l[1] + size(l)",
+	};
+	int num_exprs = sizeof(expressions) / sizeof(expressions[0]);
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t x = cel_value_int(42);
+	cel_value_t y = cel_value_int(10);
+	cel_value_t s = cel_value_string("hello world");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "y", &y);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	cel_list_t *list = cel_list_create(3);
+	for (int i = 1; i <= 3; i++) {
+		cel_value_t v = cel_value_int(i);
+		cel_list_append(list, &v);
+	}
+	cel_value_t l = cel_value_list(list);
+	cel_context_add_variable(ctx, "l", &l);
+	cel_value_destroy(&l);
+
+	for (int e = 0; e < num_exprs; e++) {
+		double tree = bench_program(expressions[e], CEL_ENGINE_TREE_WALK, ctx);
+		double vm = bench_program(expressions[e], CEL_ENGINE_BYTECODE, ctx);
+		if (tree < 0 || vm < 0) {
+			printf("Failed to compile: %s\n", expressions[e]);
+			continue;
+		}
+
+		printf("\"%s\": tree-walk %.2f ms, bytecode %.2f ms for %d ops "
+		       "(%.0f ops/sec, %.2fx)\n",
+		       expressions[e], tree, vm, ITERATIONS,
+		       ITERATIONS / (vm / 1000.0), tree / vm);
+	}
+
+	cel_context_destroy(ctx);
+}
+
+static void bench_activation(void)
+{
+	printf("\n=== Variable Binding Benchmark (context vs slots) ===\n");
+
+	const char *expr = "age >= 18 && country == \"CN\" && score > 0.5";
+
+	cel_schema_t *schema = cel_schema_create();
+	size_t age_slot, country_slot, score_slot;
+	cel_schema_add_variable(schema, "age", &age_slot);
+	cel_schema_add_variable(schema, "country", &country_slot);
+	cel_schema_add_variable(schema, "score", &score_slot);
+
+	cel_compile_options_t options = cel_default_compile_options();
+	cel_compile_result_t by_name = cel_compile_with_options(expr, &options);
+	options.schema = schema;
+	cel_compile_result_t by_slot = cel_compile_with_options(expr, &options);
+	if (by_name.has_errors || by_slot.has_errors) {
+		printf("Failed to compile: %s\n", expr);
+		goto cleanup;
+	}
+
+	cel_value_t age = cel_value_int(30);
+	cel_value_t country = cel_value_string("CN");
+	cel_value_t score = cel_value_double(0.9);
+
+	/* 每个请求重新填充变量 */
+	cel_context_t *ctx = cel_context_create();
+	double start = get_time_ms();
+	for (int i = 0; i < ITERATIONS; i++) {
+		cel_context_add_variable(ctx, "age", &age);
+		cel_context_add_variable(ctx, "country", &country);
+		cel_context_add_variable(ctx, "score", &score);
+		cel_execute_result_t result = cel_execute(by_name.program, ctx);
+		cel_execute_result_destroy(&result);
+	}
+	double by_name_ms = get_time_ms() - start;
+
+	cel_activation_t *activation = cel_activation_create(schema);
+	start = get_time_ms();
+	for (int i = 0; i < ITERATIONS; i++) {
+		cel_activation_set(activation, age_slot, &age);
+		cel_activation_set(activation, country_slot, &country);
+		cel_activation_set(activation, score_slot, &score);
+		cel_execute_result_t result =
+			cel_execute_with_activation(by_slot.program, ctx, activation);
+		cel_execute_result_destroy(&result);
+		cel_activation_clear(activation);
+	}
+	double by_slot_ms = get_time_ms() - start;
+
+	printf("\"%s\": context %.2f ms, activation %.2f ms for %d ops "
+	       "(%.0f ops/sec, %.2fx)\n",
+	       expr, by_name_ms, by_slot_ms, ITERATIONS,
+	       ITERATIONS / (by_slot_ms / 1000.0), by_name_ms / by_slot_ms);
+
+	cel_activation_destroy(activation);
+	cel_context_destroy(ctx);
+	cel_value_destroy(&country);
+
+cleanup:
+	cel_compile_result_destroy(&by_name);
+	cel_compile_result_destroy(&by_slot);
+	cel_schema_destroy(schema);
+}
+
+static void bench_batch(void)
+{
+	printf("\n=== Batch Execution Benchmark (single-shot vs batch) ===\n");
+
+	enum { ROWS = 1024 };
+	const char *expr = "age >= 18 && score > 0.5";
+
+	cel_schema_t *schema = cel_schema_create();
+	size_t age_slot, score_slot;
+	cel_schema_add_variable(schema, "age", &age_slot);
+	cel_schema_add_variable(schema, "score", &score_slot);
+
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	cel_compile_result_t compiled = cel_compile_with_options(expr, &options);
+	if (compiled.has_errors) {
+		printf("Failed to compile: %s\n", expr);
+		cel_compile_result_destroy(&compiled);
+		cel_schema_destroy(schema);
+		return;
+	}
+
+	cel_activation_t *activations[ROWS];
+	for (int i = 0; i < ROWS; i++) {
+		cel_value_t age = cel_value_int(i % 40);
+		cel_value_t score = cel_value_double((i % 10) / 10.0);
+		activations[i] = cel_activation_create(schema);
+		cel_activation_set(activations[i], age_slot, &age);
+		cel_activation_set(activations[i], score_slot, &score);
+	}
+	const cel_activation_t *const *rows =
+		(const cel_activation_t *const *)activations;
+
+	cel_context_t *ctx = cel_context_create();
+	cel_execute_result_t *results = malloc(sizeof(cel_execute_result_t) * ROWS);
+	uint64_t selection[CEL_SELECTION_WORDS(ROWS)];
+	int rounds = ITERATIONS / ROWS;
+	size_t total = (size_t)rounds * ROWS;
+
+	double start = get_time_ms();
+	for (int r = 0; r < rounds; r++) {
+		for (int i = 0; i < ROWS; i++) {
+			cel_execute_result_t result = cel_execute_with_activation(
+				compiled.program, ctx, activations[i]);
+			cel_execute_result_destroy(&result);
+		}
+	}
+	double single_ms = get_time_ms() - start;
+
+	start = get_time_ms();
+	for (int r = 0; r < rounds; r++) {
+		cel_execute_batch(compiled.program, ctx, rows, ROWS, results);
+		for (int i = 0; i < ROWS; i++) {
+			cel_execute_result_destroy(&results[i]);
+		}
+	}
+	double batch_ms = get_time_ms() - start;
+
+	start = get_time_ms();
+	for (int r = 0; r < rounds; r++) {
+		cel_execute_batch_select(compiled.program, ctx, rows, ROWS,
+					 selection);
+	}
+	double select_ms = get_time_ms() - start;
+
+	printf("\"%s\" (%zu rows): single-shot %.1f ns/row, batch %.1f ns/row "
+	       "(%.2fx), batch select %.1f ns/row (%.2fx)\n",
+	       expr, total, single_ms * 1e6 / total, batch_ms * 1e6 / total,
+	       single_ms / batch_ms, select_ms * 1e6 / total,
+	       single_ms / select_ms);
+
+	free(results);
+	cel_context_destroy(ctx);
+	for (int i = 0; i < ROWS; i++) {
+		cel_activation_destroy(activations[i]);
+	}
+	cel_compile_result_destroy(&compiled);
+	cel_schema_destroy(schema);
+}
+
+static void bench_columnar(void)
+{
+	printf("\n=== Columnar Execution Benchmark (batch select vs columnar, %s) ===\n",
+	       cel_columnar_simd_level());
+
+	enum { ROWS = 4096 };
+	const char *expr = "a > 10 && b < 3.5";
+
+	cel_schema_t *schema = cel_schema_create();
+	size_t a_slot, b_slot;
+	cel_schema_add_variable(schema, "a", &a_slot);
+	cel_schema_add_variable(schema, "b", &b_slot);
+
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	cel_compile_result_t compiled = cel_compile_with_options(expr, &options);
+	cel_columnar_program_t *columnar =
+		compiled.has_errors ? NULL : cel_columnar_compile(compiled.program);
+	if (!columnar) {
+		printf("Failed to compile: %s\n", expr);
+		cel_compile_result_destroy(&compiled);
+		cel_schema_destroy(schema);
+		return;
+	}
+
+	int64_t *a = malloc(sizeof(int64_t) * ROWS);
+	double *b = malloc(sizeof(double) * ROWS);
+	cel_activation_t **activations = malloc(sizeof(cel_activation_t *) * ROWS);
+	for (int i = 0; i < ROWS; i++) {
+		a[i] = i % 20;
+		b[i] = (i % 8) * 0.75;
+		cel_value_t va = cel_value_int(a[i]);
+		cel_value_t vb = cel_value_double(b[i]);
+		activations[i] = cel_activation_create(schema);
+		cel_activation_set(activations[i], a_slot, &va);
+		cel_activation_set(activations[i], b_slot, &vb);
+	}
+
+	cel_column_t columns[2];
+	columns[a_slot] = (cel_column_t){CEL_COLUMN_INT, a};
+	columns[b_slot] = (cel_column_t){CEL_COLUMN_DOUBLE, b};
+
+	cel_context_t *ctx = cel_context_create();
+	uint64_t bitmap[CEL_SELECTION_WORDS(ROWS)];
+	uint32_t *selection = malloc(sizeof(uint32_t) * ROWS);
+	int rounds = ITERATIONS * 10 / ROWS;
+	size_t total = (size_t)rounds * ROWS;
+
+	double start = get_time_ms();
+	for (int r = 0; r < rounds; r++) {
+		cel_execute_batch_select(compiled.program, ctx,
+					 (const cel_activation_t *const *)activations,
+					 ROWS, bitmap);
+	}
+	double batch_ms = get_time_ms() - start;
+
+	start = get_time_ms();
+	for (int r = 0; r < rounds; r++) {
+		cel_columnar_select(columnar, ctx, columns, ROWS, selection);
+	}
+	double columnar_ms = get_time_ms() - start;
+
+	printf("\"%s\" (%zu rows): batch select %.2f ns/row, columnar %.2f ns/row "
+	       "(%.1fx)\n",
+	       expr, total, batch_ms * 1e6 / total, columnar_ms * 1e6 / total,
+	       batch_ms / columnar_ms);
+
+	free(selection);
+	cel_context_destroy(ctx);
+	for (int i = 0; i < ROWS; i++) {
+		cel_activation_destroy(activations[i]);
+	}
+	free(activations);
+	free(b);
+	free(a);
+	cel_columnar_destroy(columnar);
+	cel_compile_result_destroy(&compiled);
+	cel_schema_destroy(schema);
+}
+
+static void bench_ruleset(void)
+{
+	printf("\n=== Rule Set Benchmark (per-program vs shared DAG) ===\n");
+
+	enum { RULES = 1000, ROUNDS = 200 };
+
+	/* req = {"user": {"email": "...", "level": 3}} */
+	cel_map_t *user = cel_map_create(4);
+	cel_value_t key = cel_value_string("email");
+	cel_value_t value = cel_value_string("bob@example.com");
+	cel_map_put(user, &key, &value);
+	cel_value_destroy(&key);
+	cel_value_destroy(&value);
+	key = cel_value_string("level");
+	value = cel_value_int(3);
+	cel_map_put(user, &key, &value);
+	cel_value_destroy(&key);
+	cel_map_t *req = cel_map_create(4);
+	key = cel_value_string("user");
+	value = cel_value_map(user);
+	cel_map_put(req, &key, &value);
+	cel_value_destroy(&key);
+	cel_value_destroy(&value);
+
+	cel_context_t *ctx = cel_context_create();
+	value = cel_value_map(req);
+	cel_context_add_variable(ctx, "req", &value);
+	cel_value_destroy(&value);
+
+	/* 规则共享 email 后缀检查与 level 字段，只有阈值不同 */
+	cel_program_t **programs = malloc(sizeof(cel_program_t *) * RULES);
+	cel_ruleset_t *ruleset = cel_ruleset_create(NULL);
+	for (int i = 0; i < RULES; i++) {
+		char expr[128];
+		snprintf(expr, sizeof(expr),
+			 "req.user.email.endsWith(\"@example.com\") && "
+			 "req.user.level * 100 > %d",
+			 i);
+		cel_compile_result_t compiled = cel_compile(expr);
+		programs[i] = compiled.program;
+		compiled.program = NULL;
+		cel_compile_result_destroy(&compiled);
+		cel_ruleset_add(ruleset, programs[i], 0, NULL);
+	}
+
+	size_t *matches = malloc(sizeof(size_t) * RULES);
+	size_t expected = 0, matched = 0;
+
+	double start = get_time_ms();
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int i = 0; i < RULES; i++) {
+			cel_execute_result_t result = cel_execute(programs[i], ctx);
+			expected += result.success && result.value.value.bool_value;
+			cel_execute_result_destroy(&result);
+		}
+	}
+	double programs_ms = get_time_ms() - start;
+
+	start = get_time_ms();
+	for (int r = 0; r < ROUNDS; r++) {
+		matched += cel_ruleset_evaluate(ruleset, ctx, NULL,
+						CEL_RULESET_ALL_MATCH, matches);
+	}
+	double ruleset_ms = get_time_ms() - start;
+
+	printf("%d rules, %zu DAG nodes: per-program %.1f us/request, rule set "
+	       "%.1f us/request (%.2fx)%s\n",
+	       RULES, cel_ruleset_node_count(ruleset),
+	       programs_ms * 1000.0 / ROUNDS, ruleset_ms * 1000.0 / ROUNDS,
+	       programs_ms / ruleset_ms,
+	       expected == matched ? "" : " MISMATCH");
+
+	free(matches);
+	cel_ruleset_destroy(ruleset);
+	for (int i = 0; i < RULES; i++) {
+		cel_program_destroy(programs[i]);
+	}
+	free(programs);
+	cel_context_destroy(ctx);
+}
+
+static void bench_ruleset_index(void)
+{
+	printf("\n=== Rule Set Predicate Index Benchmark ===\n");
+
+	enum { TENANTS = 1000, ROUNDS = 2000 };
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t tenant = cel_value_string("t500");
+	cel_context_add_variable(ctx, "tenant", &tenant);
+	cel_value_destroy(&tenant);
+	cel_value_t status = cel_value_int(3);
+	cel_context_add_variable(ctx, "status", &status);
+
+	/* 每个租户一条规则，外加按状态码阈值划分的规则 */
+	cel_program_t **programs = malloc(sizeof(cel_program_t *) * TENANTS * 2);
+	cel_ruleset_t *ruleset = cel_ruleset_create(NULL);
+	for (int i = 0; i < TENANTS * 2; i++) {
+		char expr[128];
+		if (i < TENANTS) {
+			snprintf(expr, sizeof(expr),
+				 "tenant == \"t%d\" && status != %d", i, i);
+		} else {
+			snprintf(expr, sizeof(expr),
+				 "status >= %d && tenant.startsWith(\"t\")", i - TENANTS);
+		}
+		cel_compile_result_t compiled = cel_compile(expr);
+		programs[i] = compiled.program;
+		compiled.program = NULL;
+		cel_compile_result_destroy(&compiled);
+		cel_ruleset_add(ruleset, programs[i], 0, NULL);
+	}
+
+	size_t *matches = malloc(sizeof(size_t) * TENANTS * 2);
+	size_t expected = 0, matched = 0;
+
+	double start = get_time_ms();
+	for (int r = 0; r < ROUNDS / 10; r++) {
+		for (int i = 0; i < TENANTS * 2; i++) {
+			cel_execute_result_t result = cel_execute(programs[i], ctx);
+			expected += result.success && result.value.value.bool_value;
+			cel_execute_result_destroy(&result);
+		}
+	}
+	double programs_ms = (get_time_ms() - start) * 10.0;
+	expected *= 10;
+
+	start = get_time_ms();
+	for (int r = 0; r < ROUNDS; r++) {
+		matched += cel_ruleset_evaluate(ruleset, ctx, NULL,
+						CEL_RULESET_ALL_MATCH, matches);
+	}
+	double ruleset_ms = get_time_ms() - start;
+
+	printf("%d rules, %zu indexed: per-program %.1f us/request, indexed rule "
+	       "set %.1f us/request (%.2fx)%s\n",
+	       TENANTS * 2, cel_ruleset_indexed_count(ruleset),
+	       programs_ms * 1000.0 / ROUNDS, ruleset_ms * 1000.0 / ROUNDS,
+	       programs_ms / ruleset_ms,
+	       expected == matched ? "" : " MISMATCH");
+
+	free(matches);
+	cel_ruleset_destroy(ruleset);
+	for (int i = 0; i < TENANTS * 2; i++) {
+		cel_program_destroy(programs[i]);
+	}
+	free(programs);
+	cel_context_destroy(ctx);
+}
+
+/**
+ * @brief 多线程基准的工作线程参数
+ */
+typedef struct {
+	const cel_program_t *program;
+	cel_context_t *ctx;
+	const cel_schema_t *schema;
+	size_t x_slot;
+	int iterations;
+	int64_t checksum;
+} thread_bench_t;
+
+static void *thread_bench_main(void *arg)
+{
+	thread_bench_t *bench = arg;
+	cel_exec_state_t *state = cel_exec_state_create();
+	cel_activation_t *activation = cel_activation_create(bench->schema);
+
+	for (int i = 0; i < bench->iterations; i++) {
+		cel_value_t x = cel_value_int(i);
+		cel_activation_set(activation, bench->x_slot, &x);
+		cel_execute_result_t result = cel_execute_with_state(
+			bench->program, bench->ctx, activation, state);
+		bench->checksum += result.value.value.int_value;
+		cel_execute_result_destroy(&result);
+	}
+
+	cel_activation_destroy(activation);
+	cel_exec_state_destroy(state);
+	return NULL;
+}
+
+static void bench_threads(void)
+{
+	printf("\n=== Multi-Threaded Execution Benchmark (shared program) ===\n");
+
+	enum { MAX_THREADS = 8, PER_THREAD = ITERATIONS * 5 };
+
+	cel_schema_t *schema = cel_schema_create();
+	size_t x_slot;
+	cel_schema_add_variable(schema, "x", &x_slot);
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t limit = cel_value_int(1000);
+	cel_context_add_variable(ctx, "limit", &limit);
+
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	cel_compile_result_t compiled = cel_compile_with_options(
+		"x % 7 == 0 && x < limit ? x * 2 + 1 : x - 3", &options);
+
+	/* 每个线程执行相同次数，理想情况下耗时不随线程数增加 */
+	double single_ms = 0.0;
+	for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+		pthread_t ids[MAX_THREADS];
+		thread_bench_t benches[MAX_THREADS];
+
+		double start = get_time_ms();
+		for (int t = 0; t < threads; t++) {
+			benches[t] = (thread_bench_t){compiled.program, ctx, schema,
+						      x_slot, PER_THREAD, 0};
+			pthread_create(&ids[t], NULL, thread_bench_main, &benches[t]);
+		}
+		for (int t = 0; t < threads; t++) {
+			pthread_join(ids[t], NULL);
+		}
+		double elapsed = get_time_ms() - start;
+		if (threads == 1) {
+			single_ms = elapsed;
+		}
+
+		double total = (double)PER_THREAD * threads;
+		printf("%d thread(s): %.2f ms, %.0f ops/sec (%.2fx of 1 thread)\n",
+		       threads, elapsed, total / (elapsed / 1000.0),
+		       single_ms * threads / elapsed);
+	}
+
+	cel_compile_result_destroy(&compiled);
+	cel_context_destroy(ctx);
+	cel_schema_destroy(schema);
+}
+
+static void bench_budget(void)
+{
+	printf("\n=== Execution Budget Overhead Benchmark ===\n");
+
+	const char *expressions[] = {
+		"x + y",
+		"size(s) > 3 && s.startsWith(\"he\")",
 	};
 	int num_exprs = sizeof(expressions) / sizeof(expressions[0]);
 
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t x = cel_value_int(42);
+	cel_value_t y = cel_value_int(10);
+	cel_value_t s = cel_value_string("hello world");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "y", &y);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	/* 只设代价上限 / 同时设超时 (每次执行读取一次时钟)，与不设限制对比 */
+	cel_execute_options_t limits[3];
+	for (int k = 0; k < 3; k++) {
+		limits[k] = cel_default_execute_options();
+	}
+	limits[1].max_cost = 1000;
+	limits[2].max_cost = 1000;
+	limits[2].timeout_ms = 1000;
+
 	for (int e = 0; e < num_exprs; e++) {
-		cel_compile_result_t compile_result = cel_compile(expressions[e]);
-		if (compile_result.has_errors || !compile_result.program) {
+		cel_compile_result_t compiled = cel_compile(expressions[e]);
+		if (compiled.has_errors) {
 			printf("Failed to compile: %s\n", expressions[e]);
-			cel_compile_result_destroy(&compile_result);
+			cel_compile_result_destroy(&compiled);
 			continue;
 		}
 
+		double elapsed[3];
+		for (int k = 0; k < 3; k++) {
+			double start = get_time_ms();
+			for (int i = 0; i < ITERATIONS; i++) {
+				cel_execute_result_t result = cel_execute_with_options(
+					compiled.program, ctx, &limits[k]);
+				cel_execute_result_destroy(&result);
+			}
+			elapsed[k] = get_time_ms() - start;
+		}
+
+		printf("\"%s\": unlimited %.2f ms, cost limit %.2f ms, "
+		       "cost+timeout %.2f ms\n",
+		       expressions[e], elapsed[0], elapsed[1], elapsed[2]);
+		cel_compile_result_destroy(&compiled);
+	}
+
+	cel_context_destroy(ctx);
+}
+
+/**
+ * @brief 构造 range.all(x, P) (解析器不展开宏，手工构造推导式)
+ */
+static cel_ast_node_t *bench_all_ast(cel_ast_node_t *predicate)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_comprehension(
+		"x", 1, NULL, 0, cel_ast_create_ident("range", 5, loc),
+		"@result", 7, cel_ast_create_literal(cel_value_bool(true), loc),
+		cel_ast_create_ident("@result", 7, loc),
+		cel_ast_create_binary(CEL_BINARY_AND,
+				      cel_ast_create_ident("@result", 7, loc),
+				      predicate, loc),
+		cel_ast_create_ident("@result", 7, loc), loc);
+}
+
+static void bench_parallel(void)
+{
+	printf("\n=== Parallel Comprehension Benchmark (range.all over 200k) ===\n");
+
+	enum { MAX_THREADS = 8, RANGE = 200000, RUNS = 20 };
+
+	cel_context_t *ctx = cel_context_create();
+	cel_list_t *list = cel_list_create(RANGE);
+	for (int i = 0; i < RANGE; i++) {
+		char text[32];
+		snprintf(text, sizeof(text), "item-%d", i);
+		cel_value_t element = cel_value_string(text);
+		cel_list_append(list, &element);
+		cel_value_destroy(&element);
+	}
+	cel_value_t range = cel_value_list(list);
+	cel_context_add_variable(ctx, "range", &range);
+	cel_value_destroy(&range);
+
+	/* range.all(x, x.startsWith("item") && !x.contains("--")) */
+	cel_token_location_t loc = {0};
+	cel_ast_node_t **starts_args = malloc(sizeof(cel_ast_node_t *));
+	starts_args[0] = cel_ast_create_literal(cel_value_string("item"), loc);
+	cel_ast_node_t **contains_args = malloc(sizeof(cel_ast_node_t *));
+	contains_args[0] = cel_ast_create_literal(cel_value_string("--"), loc);
+	cel_program_t program = {
+		.ast = bench_all_ast(cel_ast_create_binary(
+			CEL_BINARY_AND,
+			cel_ast_create_call("startsWith", 10,
+					    cel_ast_create_ident("x", 1, loc),
+					    starts_args, 1, loc),
+			cel_ast_create_unary(
+				CEL_UNARY_NOT,
+				cel_ast_create_call("contains", 8,
+						    cel_ast_create_ident("x", 1, loc),
+						    contains_args, 1, loc),
+				loc),
+			loc)),
+	};
+
+	/* 1 个线程为顺序执行 */
+	double single_ms = 0.0;
+	for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+		cel_thread_pool_t *pool = threads > 1 ?
+			cel_thread_pool_create((size_t)threads) : NULL;
+		if (threads > 1 && !pool) {
+			printf("thread pool unavailable (CEL_THREAD_SAFE disabled)\n");
+			break;
+		}
+		cel_execute_options_t options = cel_default_execute_options();
+		options.pool = pool;
+
+		double start = get_time_ms();
+		for (int i = 0; i < RUNS; i++) {
+			cel_execute_result_t result =
+				cel_execute_with_options(&program, ctx, &options);
+			cel_execute_result_destroy(&result);
+		}
+		double elapsed = (get_time_ms() - start) / RUNS;
+		if (threads == 1) {
+			single_ms = elapsed;
+		}
+
+		printf("%d thread(s): %.2f ms per execution (%.2fx)\n", threads,
+		       elapsed, single_ms / elapsed);
+		cel_thread_pool_destroy(pool);
+	}
+
+	cel_ast_destroy(program.ast);
+	cel_context_destroy(ctx);
+}
+
+static void bench_map_append(void)
+{
+	printf("\n=== Map Comprehension Benchmark (range.map(x, x * 2)) ===\n");
+
+	const int sizes[] = {1000, 10000, 50000};
+	int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+	cel_token_location_t loc = {0};
+
+	for (int n = 0; n < num_sizes; n++) {
 		cel_context_t *ctx = cel_context_create();
-		cel_value_t x = cel_value_int(42);
-		cel_value_t y = cel_value_int(10);
-		cel_context_add_variable(ctx, "x", &x);
-		cel_context_add_variable(ctx, "y", &y);
-
-		/* Warmup */
-		for (int i = 0; i < WARMUP; i++) {
-			cel_execute_result_t result = cel_execute(compile_result.program, ctx);
+		cel_list_t *list = cel_list_create((size_t)sizes[n]);
+		for (int i = 0; i < sizes[n]; i++) {
+			cel_value_t v = cel_value_int(i);
+			cel_list_append(list, &v);
+		}
+		cel_value_t range = cel_value_list(list);
+		cel_context_add_variable(ctx, "range", &range);
+		cel_value_destroy(&range);
+
+		/* 解析器不展开宏，手工构造 map 推导式: @result + [x * 2] */
+		cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+		elements[0] = cel_ast_create_binary(
+			CEL_BINARY_MUL, cel_ast_create_ident("x", 1, loc),
+			cel_ast_create_literal(cel_value_int(2), loc), loc);
+		cel_program_t program = {
+			.ast = cel_ast_create_comprehension(
+				"x", 1, NULL, 0, cel_ast_create_ident("range", 5, loc),
+				"@result", 7, cel_ast_create_list(NULL, 0, loc),
+				cel_ast_create_literal(cel_value_bool(true), loc),
+				cel_ast_create_binary(
+					CEL_BINARY_ADD,
+					cel_ast_create_ident("@result", 7, loc),
+					cel_ast_create_list(elements, 1, loc), loc),
+				cel_ast_create_ident("@result", 7, loc), loc),
+		};
+
+		/* 先树遍历求值，再编译为字节码 */
+		double elapsed[2];
+		for (int engine = 0; engine < 2; engine++) {
+			if (engine == 1) {
+				program.bytecode = cel_bytecode_compile(program.ast, NULL);
+			}
+			int runs = 2000000 / sizes[n];
+			double start = get_time_ms();
+			for (int i = 0; i < runs; i++) {
+				cel_execute_result_t result = cel_execute(&program, ctx);
+				cel_execute_result_destroy(&result);
+			}
+			elapsed[engine] = (get_time_ms() - start) / runs;
+		}
+
+		printf("%d elements: tree-walk %.3f ms (%.1f ns/elem), "
+		       "bytecode %.3f ms (%.1f ns/elem)\n",
+		       sizes[n], elapsed[0], elapsed[0] * 1e6 / sizes[n],
+		       elapsed[1], elapsed[1] * 1e6 / sizes[n]);
+
+		cel_bytecode_destroy(program.bytecode);
+		cel_ast_destroy(program.ast);
+		cel_context_destroy(ctx);
+	}
+}
+
+static void bench_scratch(void)
+{
+	printf("\n=== Scratch Arena Benchmark (heap vs per-execution arena) ===\n");
+
+	const char *expressions[] = {
+		"s + \"!\" == \"hello world!\"",
+		"string(x) + \":\" + s != \"\"",
+		"[s, s + \"?\", string(y)].size() == 3",
+		"{\"name\": s, \"id\": string(x)}[\"id\"] == \"42\"",
+	};
+	int num_exprs = sizeof(expressions) / sizeof(expressions[0]);
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t x = cel_value_int(42);
+	cel_value_t y = cel_value_int(10);
+	cel_value_t s = cel_value_string("hello world");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "y", &y);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	arena_t *arena = arena_create(0);
+	cel_exec_state_t *states[2] = {cel_exec_state_create(),
+				       cel_exec_state_create()};
+	cel_execute_options_t options = cel_default_execute_options();
+	options.scratch = arena;
+	cel_exec_state_set_options(states[1], &options);
+
+	for (int e = 0; e < num_exprs; e++) {
+		cel_compile_result_t compiled = cel_compile(expressions[e]);
+		if (compiled.has_errors) {
+			printf("Failed to compile: %s\n", expressions[e]);
+			cel_compile_result_destroy(&compiled);
+			continue;
+		}
+
+		double elapsed[2];
+		for (int k = 0; k < 2; k++) {
+			double start = get_time_ms();
+			for (int i = 0; i < ITERATIONS; i++) {
+				cel_execute_result_t result = cel_execute_with_state(
+					compiled.program, ctx, NULL, states[k]);
+				cel_execute_result_destroy(&result);
+			}
+			elapsed[k] = get_time_ms() - start;
+		}
+
+		printf("\"%s\": heap %.2f ms, scratch %.2f ms (%.2fx)\n",
+		       expressions[e], elapsed[0], elapsed[1],
+		       elapsed[0] / elapsed[1]);
+		cel_compile_result_destroy(&compiled);
+	}
+
+	cel_exec_state_destroy(states[0]);
+	cel_exec_state_destroy(states[1]);
+	arena_destroy(arena);
+	cel_context_destroy(ctx);
+}
+
+static void bench_error_path(void)
+{
+	printf("\n=== Error Path Benchmark (failing vs succeeding execution) ===\n");
+
+	/* 同一形状的表达式，一个字段存在，一个字段不存在 */
+	const char *expressions[][2] = {
+		{"m.present == 1", "m.absent == 1"},
+		{"x + 1 > 0", "missing + 1 > 0"},
+		{"x / 2 > 0", "x / (y - 10) > 0"},
+	};
+	int num_exprs = sizeof(expressions) / sizeof(expressions[0]);
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t x = cel_value_int(42);
+	cel_value_t y = cel_value_int(10);
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "y", &y);
+	cel_map_t *map = cel_map_create(1);
+	cel_value_t key = cel_value_string("present");
+	cel_value_t one = cel_value_int(1);
+	cel_map_put(map, &key, &one);
+	cel_value_destroy(&key);
+	cel_value_t m = cel_value_map(map);
+	cel_context_add_variable(ctx, "m", &m);
+	cel_value_destroy(&m);
+
+	cel_exec_state_t *state = cel_exec_state_create();
+	for (int e = 0; e < num_exprs; e++) {
+		double elapsed[2];
+		for (int k = 0; k < 2; k++) {
+			cel_compile_result_t compiled = cel_compile(expressions[e][k]);
+			if (compiled.has_errors) {
+				printf("Failed to compile: %s\n", expressions[e][k]);
+				cel_compile_result_destroy(&compiled);
+				elapsed[k] = 0;
+				continue;
+			}
+
+			double start = get_time_ms();
+			for (int i = 0; i < ITERATIONS; i++) {
+				cel_execute_result_t result = cel_execute_with_state(
+					compiled.program, ctx, NULL, state);
+				cel_execute_result_destroy(&result);
+			}
+			elapsed[k] = get_time_ms() - start;
+			cel_compile_result_destroy(&compiled);
+		}
+
+		printf("\"%s\": ok %.2f ms, \"%s\": error %.2f ms\n",
+		       expressions[e][0], elapsed[0], expressions[e][1],
+		       elapsed[1]);
+	}
+
+	cel_exec_state_destroy(state);
+	cel_context_destroy(ctx);
+}
+
+static void bench_partial_eval(void)
+{
+	printf("\n=== Partial Evaluation Benchmark (full vs residual program) ===\n");
+
+	/* 租户配置已知，请求字段在执行时给出 */
+	const char *expressions[] = {
+		"request.amount < tenant.limit * 2 && request.region in tenant.regions",
+		"size(tenant.regions) > 1 && string(tenant.limit) != \"0\" && "
+		"request.amount > 0",
+		"request.amount > tenant.limit ? tenant.regions[0] + \"-high\" : "
+		"tenant.regions[1] + \"-low\"",
+	};
+	int num_exprs = sizeof(expressions) / sizeof(expressions[0]);
+
+	cel_list_t *regions = cel_list_create(2);
+	cel_value_t eu = cel_value_string("eu");
+	cel_value_t us = cel_value_string("us");
+	cel_list_append(regions, &eu);
+	cel_list_append(regions, &us);
+	cel_value_destroy(&eu);
+	cel_value_destroy(&us);
+	cel_map_t *tenant = cel_map_create(2);
+	cel_value_t key = cel_value_string("limit");
+	cel_value_t value = cel_value_int(100);
+	cel_map_put(tenant, &key, &value);
+	cel_value_destroy(&key);
+	key = cel_value_string("regions");
+	value = cel_value_list(regions);
+	cel_map_put(tenant, &key, &value);
+	cel_value_destroy(&key);
+	cel_value_destroy(&value);
+	cel_value_t tenant_value = cel_value_map(tenant);
+
+	cel_map_t *request = cel_map_create(2);
+	key = cel_value_string("amount");
+	value = cel_value_int(42);
+	cel_map_put(request, &key, &value);
+	cel_value_destroy(&key);
+	key = cel_value_string("region");
+	value = cel_value_string("us");
+	cel_map_put(request, &key, &value);
+	cel_value_destroy(&key);
+	cel_value_destroy(&value);
+	cel_value_t request_value = cel_value_map(request);
+
+	cel_context_t *known = cel_context_create();
+	cel_context_add_variable(known, "tenant", &tenant_value);
+	cel_context_t *ctx = cel_context_create();
+	cel_context_add_variable(ctx, "tenant", &tenant_value);
+	cel_context_add_variable(ctx, "request", &request_value);
+	cel_value_destroy(&tenant_value);
+	cel_value_destroy(&request_value);
+
+	cel_exec_state_t *state = cel_exec_state_create();
+	for (int e = 0; e < num_exprs; e++) {
+		cel_compile_result_t compiled = cel_compile(expressions[e]);
+		if (compiled.has_errors) {
+			printf("Failed to compile: %s\n", expressions[e]);
+			cel_compile_result_destroy(&compiled);
+			continue;
+		}
+		cel_program_t *residual = cel_partial_eval(compiled.program, known);
+		if (!residual) {
+			printf("Failed to partially evaluate: %s\n", expressions[e]);
+			cel_compile_result_destroy(&compiled);
+			continue;
+		}
+
+		const cel_program_t *programs[2] = {compiled.program, residual};
+		double elapsed[2];
+		for (int k = 0; k < 2; k++) {
+			double start = get_time_ms();
+			for (int i = 0; i < ITERATIONS; i++) {
+				cel_execute_result_t result = cel_execute_with_state(
+					programs[k], ctx, NULL, state);
+				cel_execute_result_destroy(&result);
+			}
+			elapsed[k] = get_time_ms() - start;
+		}
+
+		printf("%s\n  full: %.2f ms, residual: %.2f ms (%.1fx)\n",
+		       expressions[e], elapsed[0], elapsed[1],
+		       elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+		cel_program_destroy(residual);
+		cel_compile_result_destroy(&compiled);
+	}
+
+	cel_exec_state_destroy(state);
+	cel_context_destroy(ctx);
+	cel_context_destroy(known);
+}
+
+static void bench_incremental(void)
+{
+	printf("\n=== Incremental Evaluation Benchmark (one of 20 variables changes) ===\n");
+
+	/* [s0 检查, s1 检查, ..., s19 检查]，每项依赖一个变量 */
+	enum { VARS = 20 };
+	char source[4096] = "[";
+	for (int v = 0; v < VARS; v++) {
+		char term[160];
+		snprintf(term, sizeof(term),
+			 "%ss%d.startsWith(\"ab\") && s%d.contains(\"needle\") && "
+			 "s%d.endsWith(\"z\")",
+			 v ? ", " : "", v, v, v);
+		strcat(source, term);
+	}
+	strcat(source, "]");
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t values[2] = {
+		cel_value_string("ab-with-a-needle-in-the-middle-z"),
+		cel_value_string("ab-without-anything-in-the-middle-y"),
+	};
+	char names[VARS][8];
+	for (int v = 0; v < VARS; v++) {
+		snprintf(names[v], sizeof(names[v]), "s%d", v);
+		cel_context_add_variable(ctx, names[v], &values[0]);
+	}
+
+	cel_compile_result_t compiled = cel_compile(source);
+	if (compiled.has_errors) {
+		printf("Failed to compile incremental benchmark expression\n");
+		cel_compile_result_destroy(&compiled);
+		cel_value_destroy(&values[0]);
+		cel_value_destroy(&values[1]);
+		cel_context_destroy(ctx);
+		return;
+	}
+	cel_incremental_t *inc = cel_incremental_create(compiled.program);
+
+	uint64_t costs[2] = {0, 0};
+	double elapsed[2];
+	for (int k = 0; k < 2; k++) {
+		double start = get_time_ms();
+		for (int i = 0; i < ITERATIONS / 10; i++) {
+			cel_context_add_variable(ctx, names[i % VARS],
+						 &values[(i / VARS) % 2]);
+			cel_execute_result_t result =
+				k == 0 ? cel_execute(compiled.program, ctx) :
+					 cel_incremental_evaluate(inc, ctx);
+			costs[k] += result.cost;
 			cel_execute_result_destroy(&result);
 		}
+		elapsed[k] = get_time_ms() - start;
+	}
+
+	printf("%d cache points, %d evaluations\n",
+	       (int)cel_incremental_cache_count(inc), ITERATIONS / 10);
+	printf("  full:        %.2f ms (cost %llu)\n", elapsed[0],
+	       (unsigned long long)costs[0]);
+	printf("  incremental: %.2f ms (cost %llu, %.1fx)\n", elapsed[1],
+	       (unsigned long long)costs[1],
+	       elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+
+	cel_incremental_destroy(inc);
+	cel_compile_result_destroy(&compiled);
+	cel_value_destroy(&values[0]);
+	cel_value_destroy(&values[1]);
+	cel_context_destroy(ctx);
+}
+
+static void bench_program_cache(void)
+{
+	printf("\n=== Program Cache Benchmark (cel_eval_expression on repeated rules) ===\n");
 
+	/* 200 条租户规则反复到达 */
+	enum { RULES = 200 };
+	char rules[RULES][96];
+	for (int r = 0; r < RULES; r++) {
+		snprintf(rules[r], sizeof(rules[r]),
+			 "tenant == \"t%d\" && amount > %d && "
+			 "region.startsWith(\"eu\")",
+			 r, r * 10);
+	}
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t tenant = cel_value_string("t7");
+	cel_value_t amount = cel_value_int(500);
+	cel_value_t region = cel_value_string("eu-west");
+	cel_context_add_variable(ctx, "tenant", &tenant);
+	cel_context_add_variable(ctx, "amount", &amount);
+	cel_context_add_variable(ctx, "region", &region);
+	cel_value_destroy(&tenant);
+	cel_value_destroy(&region);
+
+	cel_program_cache_t *cache = cel_program_cache_create(4096);
+	double elapsed[2];
+	for (int k = 0; k < 2; k++) {
+		cel_program_cache_install(k == 1 ? cache : NULL);
 		double start = get_time_ms();
 		for (int i = 0; i < ITERATIONS; i++) {
-			cel_execute_result_t result = cel_execute(compile_result.program, ctx);
+			cel_execute_result_t result =
+				cel_eval_expression(rules[i % RULES], ctx);
 			cel_execute_result_destroy(&result);
 		}
-		double elapsed = get_time_ms() - start;
-		printf("\"%s\": %.2f ms for %d ops (%.0f ops/sec)\n",
-		       expressions[e], elapsed, ITERATIONS,
-		       ITERATIONS / (elapsed / 1000.0));
+		elapsed[k] = get_time_ms() - start;
+	}
+	cel_program_cache_install(NULL);
 
-		cel_context_destroy(ctx);
-		cel_compile_result_destroy(&compile_result);
+	cel_program_cache_stats_t stats;
+	cel_program_cache_stats(cache, &stats);
+	printf("%d rules, %d evaluations\n", RULES, ITERATIONS);
+	printf("  compile every call: %.2f ms\n", elapsed[0]);
+	printf("  program cache:      %.2f ms (%.1fx, hits %llu, misses %llu)\n",
+	       elapsed[1], elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0,
+	       (unsigned long long)stats.hits,
+	       (unsigned long long)stats.misses);
+
+	cel_program_cache_destroy(cache);
+	cel_context_destroy(ctx);
+}
+
+static void bench_serialize(void)
+{
+	printf("\n=== Serialization Benchmark (cold start from source vs bundle) ===\n");
+
+	enum { RULES = 20000 };
+	static const char *path = "bench_rules.celb";
+	char source[256];
+	cel_program_t **programs = calloc(RULES, sizeof(cel_program_t *));
+	cel_program_t **loaded = calloc(RULES, sizeof(cel_program_t *));
+	if (!programs || !loaded) {
+		free(programs);
+		free(loaded);
+		return;
+	}
+
+	/* 冷启动: 从源代码编译全部规则 */
+	double start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		snprintf(source, sizeof(source),
+			 "tenant == \"t%d\" && amount > %d && "
+			 "region in [\"eu-west\", \"us-east\", \"ap-%d\"] && "
+			 "size(user.name) < %d",
+			 r, r * 10, r % 7, 16 + r % 32);
+		cel_compile_result_t result = cel_compile(source);
+		programs[r] = result.program;
+		result.program = NULL;
+		cel_compile_result_destroy(&result);
+	}
+	double compile_ms = get_time_ms() - start;
+
+	if (cel_bundle_write(path, programs, RULES) != CEL_OK) {
+		printf("  bundle write failed\n");
+	} else {
+		/* 打开程序包并加载全部规则 */
+		start = get_time_ms();
+		cel_bundle_t *bundle = cel_bundle_open(path);
+		for (int r = 0; r < RULES; r++) {
+			loaded[r] = cel_bundle_load(bundle, (size_t)r, NULL);
+		}
+		cel_bundle_close(bundle);
+		double load_ms = get_time_ms() - start;
+
+		FILE *file = fopen(path, "rb");
+		long size = 0;
+		if (file && fseek(file, 0, SEEK_END) == 0) {
+			size = ftell(file);
+		}
+		if (file) {
+			fclose(file);
+		}
+
+		printf("%d rules, bundle %.1f KB (%.0f bytes/rule)\n", RULES,
+		       size / 1024.0, (double)size / RULES);
+		printf("  compile from source: %.2f ms\n", compile_ms);
+		printf("  load from bundle:    %.2f ms (%.1fx)\n", load_ms,
+		       load_ms > 0 ? compile_ms / load_ms : 0.0);
+	}
+
+	for (int r = 0; r < RULES; r++) {
+		cel_program_destroy(programs[r]);
+		cel_program_destroy(loaded[r]);
+	}
+	free(programs);
+	free(loaded);
+	remove(path);
+}
+
+static void bench_ast_arena(void)
+{
+	printf("\n=== AST Arena Benchmark (parse + teardown, heap vs arena) ===\n");
+
+	enum { RULES = 20000 };
+	char (*sources)[256] = malloc(RULES * sizeof(*sources));
+	cel_parse_result_t *parsed = calloc(RULES, sizeof(cel_parse_result_t));
+	cel_ast_arena_t **arenas = calloc(RULES, sizeof(cel_ast_arena_t *));
+	cel_program_t **programs = calloc(RULES, sizeof(cel_program_t *));
+	if (!sources || !parsed || !arenas || !programs) {
+		free(sources);
+		free(parsed);
+		free(arenas);
+		free(programs);
+		return;
+	}
+	for (int r = 0; r < RULES; r++) {
+		snprintf(sources[r], sizeof(sources[r]),
+			 "tenant == \"t%d\" && amount > %d && "
+			 "region in [\"eu-west\", \"us-east\", \"ap-%d\", \"sa\", \"af\"] && "
+			 "size(user.name) < %d && {\"tier\": %d}[\"tier\"] > 0",
+			 r, r * 10, r % 7, 16 + r % 32, r % 3);
+	}
+
+	/* 每个节点与数组单独 malloc，销毁时遍历整棵树 */
+	double start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		parsed[r] = cel_parse(sources[r]);
+	}
+	double heap_parse = get_time_ms() - start;
+	start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		cel_parse_result_destroy(&parsed[r]);
 	}
+	double heap_teardown = get_time_ms() - start;
+
+	/* 每条规则一个分配区，销毁时释放分配区 */
+	size_t used = 0;
+	start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		arenas[r] = cel_ast_arena_create(32 * strlen(sources[r]));
+		cel_ast_arena_t *previous = cel_ast_arena_enter(arenas[r]);
+		parsed[r] = cel_parse(sources[r]);
+		cel_ast_arena_leave(previous);
+	}
+	double arena_parse = get_time_ms() - start;
+	for (int r = 0; r < RULES; r++) {
+		used += cel_ast_arena_used(arenas[r]);
+	}
+	start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		cel_parse_result_destroy(&parsed[r]);
+		cel_ast_arena_destroy(arenas[r]);
+	}
+	double arena_teardown = get_time_ms() - start;
+
+	/* 完整编译 (解析、优化与字节码) 与销毁程序 */
+	start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		cel_compile_result_t result = cel_compile(sources[r]);
+		programs[r] = result.program;
+	}
+	double compile_ms = get_time_ms() - start;
+	start = get_time_ms();
+	for (int r = 0; r < RULES; r++) {
+		cel_program_destroy(programs[r]);
+	}
+	double destroy_ms = get_time_ms() - start;
+
+	printf("%d rules, %.0f AST bytes/rule in arena\n", RULES,
+	       (double)used / RULES);
+	printf("  heap  parse: %.2f ms, teardown: %.2f ms\n", heap_parse,
+	       heap_teardown);
+	printf("  arena parse: %.2f ms (%.1fx), teardown: %.2f ms (%.1fx)\n",
+	       arena_parse, arena_parse > 0 ? heap_parse / arena_parse : 0.0,
+	       arena_teardown,
+	       arena_teardown > 0 ? heap_teardown / arena_teardown : 0.0);
+	printf("  compile: %.2f ms (%.0f programs/s), destroy: %.2f ms\n",
+	       compile_ms, compile_ms > 0 ? RULES * 1000.0 / compile_ms : 0.0,
+	       destroy_ms);
+
+	free(sources);
+	free(parsed);
+	free(arenas);
+	free(programs);
+}
+
+static void bench_compact_ast(void)
+{
+	printf("\n=== Compact AST Benchmark (pointer AST vs index-based nodes) ===\n");
+
+	enum { RULES = 20000, PASSES = 20 };
+	cel_program_t **tree = calloc(RULES, sizeof(cel_program_t *));
+	cel_program_t **compact = calloc(RULES, sizeof(cel_program_t *));
+	if (!tree || !compact) {
+		free(tree);
+		free(compact);
+		return;
+	}
+
+	/* 每条规则都完整求值 (没有短路) */
+	cel_compile_options_t tree_options = cel_default_compile_options();
+	tree_options.engine = CEL_ENGINE_TREE_WALK;
+	cel_compile_options_t compact_options = cel_default_compile_options();
+	compact_options.engine = CEL_ENGINE_COMPACT;
+	size_t tree_bytes = 0, compact_bytes = 0, nodes = 0;
+	for (int r = 0; r < RULES; r++) {
+		char source[256];
+		snprintf(source, sizeof(source),
+			 "amount >= %d && region in [\"eu-west\", \"us-east\", \"ap-%d\"] && "
+			 "size(user.name) < %d && user.tier + %d > 0 && tenant != \"t%d\"",
+			 r, r % 7, 16 + r % 32, r % 3, r);
+		cel_compile_result_t result = cel_compile_with_options(source,
+								       &tree_options);
+		tree[r] = result.program;
+		result = cel_compile_with_options(source, &compact_options);
+		compact[r] = result.program;
+		if (!tree[r] || !compact[r] || !compact[r]->compact) {
+			printf("Failed to compile: %.40s\n", source);
+			goto cleanup;
+		}
+		tree_bytes += cel_ast_arena_used(tree[r]->ast_arena);
+		compact_bytes += compact[r]->compact->size;
+		nodes += compact[r]->compact->node_count;
+	}
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t amount = cel_value_int(1000000);
+	cel_value_t region = cel_value_string("us-east");
+	cel_value_t tenant = cel_value_string("t-none");
+	cel_map_t *user_map = cel_map_create(4);
+	cel_value_t name_key = cel_value_string("name");
+	cel_value_t name = cel_value_string("alice");
+	cel_value_t tier_key = cel_value_string("tier");
+	cel_value_t tier = cel_value_int(2);
+	cel_map_put(user_map, &name_key, &name);
+	cel_map_put(user_map, &tier_key, &tier);
+	cel_value_t user = cel_value_map(user_map);
+	cel_context_add_variable(ctx, "amount", &amount);
+	cel_context_add_variable(ctx, "region", &region);
+	cel_context_add_variable(ctx, "tenant", &tenant);
+	cel_context_add_variable(ctx, "user", &user);
+	cel_value_destroy(&region);
+	cel_value_destroy(&tenant);
+	cel_value_destroy(&name_key);
+	cel_value_destroy(&name);
+	cel_value_destroy(&tier_key);
+	cel_value_destroy(&user);
+
+	/* 每遍依次执行全部规则，工作集大于缓存 */
+	double elapsed[2];
+	int matched[2] = {0, 0};
+	for (int engine = 0; engine < 2; engine++) {
+		cel_program_t **programs = engine == 0 ? tree : compact;
+		double start = get_time_ms();
+		for (int pass = 0; pass < PASSES; pass++) {
+			for (int r = 0; r < RULES; r++) {
+				cel_execute_result_t result =
+					cel_execute(programs[r], ctx);
+				matched[engine] += result.success &&
+						   result.value.value.bool_value;
+				cel_execute_result_destroy(&result);
+			}
+		}
+		elapsed[engine] = get_time_ms() - start;
+	}
+	cel_context_destroy(ctx);
+
+	printf("%d rules, %zu nodes (%.1f per rule), matched %d / %d\n", RULES,
+	       nodes, (double)nodes / RULES, matched[0] / PASSES,
+	       matched[1] / PASSES);
+	printf("  pointer AST: %.1f bytes/node (%zu-byte nodes, arena), %.2f MB\n",
+	       (double)tree_bytes / nodes, sizeof(cel_ast_node_t),
+	       tree_bytes / (1024.0 * 1024.0));
+	printf("  compact AST: %.1f bytes/node (%zu-byte nodes + %zu-byte locations + tables), "
+	       "%.2f MB (%.1fx smaller)\n",
+	       (double)compact_bytes / nodes, sizeof(cel_compact_node_t),
+	       sizeof(cel_compact_loc_t), compact_bytes / (1024.0 * 1024.0),
+	       compact_bytes > 0 ? (double)tree_bytes / compact_bytes : 0.0);
+	printf("  eval %d x %d rules: tree walk %.2f ms, compact %.2f ms (%.2fx)\n",
+	       PASSES, RULES, elapsed[0], elapsed[1],
+	       elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+
+cleanup:
+	for (int r = 0; r < RULES; r++) {
+		cel_program_destroy(tree[r]);
+		cel_program_destroy(compact[r]);
+	}
+	free(tree);
+	free(compact);
+}
+
+static void bench_constant_folding(void)
+{
+	printf("\n=== Constant Folding Benchmark (unfolded vs folded) ===\n");
+
+	/* 200 项的白名单 */
+	char allow_list[4096];
+	size_t length = (size_t)snprintf(allow_list, sizeof(allow_list),
+					 "s in [");
+	for (int i = 0; i < 200; i++) {
+		length += (size_t)snprintf(allow_list + length,
+					   sizeof(allow_list) - length,
+					   "%s\"v%d\"", i ? ", " : "", i);
+	}
+	snprintf(allow_list + length, sizeof(allow_list) - length, "]");
+
+	const char *expressions[] = {
+		"x < 1024 * 1024",
+		"{\"k\": 1, \"n\": 2}[s] == 1",
+		allow_list,
+	};
+	int num_exprs = sizeof(expressions) / sizeof(expressions[0]);
+
+	cel_context_t *ctx = cel_context_create();
+	cel_value_t x = cel_value_int(42);
+	cel_value_t s = cel_value_string("k");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	cel_compile_options_t options = cel_default_compile_options();
+	for (int e = 0; e < num_exprs; e++) {
+		options.fold_constants = false;
+		double unfolded = bench_compiled(expressions[e], &options, ctx);
+		options.fold_constants = true;
+		double folded = bench_compiled(expressions[e], &options, ctx);
+		if (unfolded < 0 || folded < 0) {
+			printf("Failed to compile: %.40s\n", expressions[e]);
+			continue;
+		}
+
+		printf("\"%.40s\": unfolded %.2f ms, folded %.2f ms for %d ops "
+		       "(%.0f ops/sec, %.2fx)\n",
+		       expressions[e], unfolded, folded, ITERATIONS,
+		       ITERATIONS / (folded / 1000.0), unfolded / folded);
+	}
+
+	cel_context_destroy(ctx);
 }
 
 static void bench_string_ops(void)
@@ -208,6 +1563,24 @@ int main(void)
 	bench_list_ops();
 	bench_map_ops();
 	bench_expression_eval();
+	bench_activation();
+	bench_batch();
+	bench_columnar();
+	bench_ruleset();
+	bench_ruleset_index();
+	bench_threads();
+	bench_budget();
+	bench_parallel();
+	bench_map_append();
+	bench_scratch();
+	bench_error_path();
+	bench_constant_folding();
+	bench_partial_eval();
+	bench_incremental();
+	bench_program_cache();
+	bench_serialize();
+	bench_ast_arena();
+	bench_compact_ast();
 
 	printf("\n=== Benchmark Complete ===\n");
 	return 0;
@@ -0,0 +1,171 @@
+/**
+ * @file cel_activation.h
+ * @brief CEL 变量布局 (schema) 与激活记录 (activation)
+ *
+ * schema 声明程序可使用的变量并为每个变量分配固定的槽位编号。
+ * 以 schema 编译的程序在编译期将标识符解析为槽位，执行时直接
+ * 从激活记录的值数组中读取变量，不再按名称查找上下文。
+ *
+ * 典型用法:
+ *   1. 创建 schema 并声明变量 (只需一次)
+ *   2. 以 schema 编译程序
+ *   3. 每个请求填充一个激活记录并执行 (激活记录可以清空后复用)
+ */
+
+#ifndef CEL_ACTIVATION_H
+#define CEL_ACTIVATION_H
+
+#include "cel/cel_error.h"
+#include "cel/cel_value.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 前向声明 */
+typedef struct cel_schema cel_schema_t;
+
+/**
+ * @brief 激活记录
+ *
+ * 按槽位编号存放变量值的平坦数组，槽位与创建时的 schema 对应。
+ * 未设置的槽位在执行时回退到上下文按名称查找。
+ */
+typedef struct cel_activation {
+	const cel_schema_t *schema;  /* 所属 schema (不持有) */
+	cel_value_t *values;         /* 槽位值 (激活记录持有引用) */
+	bool *bound;                 /* 槽位是否已设置 */
+	size_t count;                /* 槽位数量 */
+} cel_activation_t;
+
+/* ========== Schema API ========== */
+
+/**
+ * @brief 创建空的变量布局
+ *
+ * @return 新创建的 schema，失败返回 NULL
+ */
+cel_schema_t *cel_schema_create(void);
+
+/**
+ * @brief 销毁变量布局
+ *
+ * schema 必须比以它编译的程序和以它创建的激活记录存活更久。
+ *
+ * @param schema 要销毁的 schema (可以为 NULL)
+ */
+void cel_schema_destroy(cel_schema_t *schema);
+
+/**
+ * @brief 声明变量
+ *
+ * 为变量分配下一个槽位。变量已声明时返回已有的槽位。
+ * 槽位一经分配不会改变，因此可以在编译程序后继续声明变量。
+ *
+ * @param schema 变量布局
+ * @param name 变量名
+ * @param slot 输出槽位编号 (可以为 NULL)
+ * @return CEL_OK 成功，其他值表示错误
+ */
+cel_error_code_e cel_schema_add_variable(cel_schema_t *schema, const char *name,
+					  size_t *slot);
+
+/**
+ * @brief 按名称查找槽位
+ *
+ * @param schema 变量布局
+ * @param name 变量名 (不要求 null 结尾)
+ * @param length 变量名长度
+ * @param slot 输出槽位编号
+ * @return true 已声明, false 未声明
+ */
+bool cel_schema_find(const cel_schema_t *schema, const char *name,
+		     size_t length, size_t *slot);
+
+/**
+ * @brief 获取已声明变量的数量
+ *
+ * @param schema 变量布局
+ * @return 变量数量
+ */
+size_t cel_schema_size(const cel_schema_t *schema);
+
+/**
+ * @brief 获取槽位对应的变量名
+ *
+ * @param schema 变量布局
+ * @param slot 槽位编号
+ * @return 变量名 (schema 持有)，槽位无效返回 NULL
+ */
+const char *cel_schema_get_name(const cel_schema_t *schema, size_t slot);
+
+/* ========== Activation API ========== */
+
+/**
+ * @brief 创建激活记录
+ *
+ * 槽位数量为创建时 schema 中已声明的变量数量。
+ *
+ * @param schema 变量布局
+ * @return 新创建的激活记录，失败返回 NULL
+ */
+cel_activation_t *cel_activation_create(const cel_schema_t *schema);
+
+/**
+ * @brief 销毁激活记录
+ *
+ * @param activation 要销毁的激活记录 (可以为 NULL)
+ */
+void cel_activation_destroy(cel_activation_t *activation);
+
+/**
+ * @brief 设置槽位的值
+ *
+ * 激活记录持有 value 的一个新引用，旧值被释放。
+ *
+ * @param activation 激活记录
+ * @param slot 槽位编号
+ * @param value 变量值
+ * @return CEL_OK 成功，槽位无效返回 CEL_ERROR_OUT_OF_RANGE
+ */
+cel_error_code_e cel_activation_set(cel_activation_t *activation, size_t slot,
+				     const cel_value_t *value);
+
+/**
+ * @brief 按名称设置变量的值
+ *
+ * @param activation 激活记录
+ * @param name 变量名
+ * @param value 变量值
+ * @return CEL_OK 成功，变量未声明返回 CEL_ERROR_NOT_FOUND
+ */
+cel_error_code_e cel_activation_set_variable(cel_activation_t *activation,
+					      const char *name,
+					      const cel_value_t *value);
+
+/**
+ * @brief 获取槽位的值
+ *
+ * @param activation 激活记录
+ * @param slot 槽位编号
+ * @return 变量值 (激活记录持有)，未设置或槽位无效返回 NULL
+ */
+const cel_value_t *cel_activation_get(const cel_activation_t *activation,
+				      size_t slot);
+
+/**
+ * @brief 清空所有槽位
+ *
+ * 释放所有值并将槽位标记为未设置，用于在请求之间复用激活记录。
+ *
+ * @param activation 激活记录
+ */
+void cel_activation_clear(cel_activation_t *activation);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_ACTIVATION_H */
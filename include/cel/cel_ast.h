@@ -102,7 +102,8 @@ typedef enum {
  * @brief 字面量节点
  */
 typedef struct {
-	cel_value_t value; /* 字面量值 */
+	cel_value_t value;    /* 字面量值 */
+	cel_ast_node_t *next; /* 同一分配区中的下一个字面量 (分配区销毁时释放其值) */
 } cel_ast_literal_t;
 
 /**
@@ -252,6 +253,7 @@ typedef struct {
  */
 struct cel_ast_node {
 	cel_ast_node_type_e type; /* 节点类型 */
+	bool in_arena;            /* 节点位于 AST 分配区 (随分配区释放) */
 	cel_token_location_t loc; /* 源码位置 */
 
 	union {
@@ -270,8 +272,102 @@ struct cel_ast_node {
 	} as;
 };
 
+/* ========== AST 分配区 ========== */
+
+/*
+ * 在当前线程安装 AST 分配区后，该线程创建的节点与子节点数组从分配区
+ * 中顺序分配，销毁单个节点不归还内存；字面量值在分配区销毁时一并释放。
+ * 编译时程序安装自己的分配区，销毁程序只需销毁分配区，不再遍历 AST。
+ * 分配区中的节点只能引用同一分配区中的节点。
+ */
+
+/**
+ * @brief AST 分配区 (不透明指针)
+ */
+typedef struct cel_ast_arena cel_ast_arena_t;
+
+/**
+ * @brief 创建 AST 分配区
+ *
+ * @param block_size 内存块大小 (0 表示使用默认值，限制在 512 字节到
+ *                   64KB 之间；按预计的 AST 大小选择可以使一般的程序
+ *                   只占用一个块)
+ * @return 分配区，内存不足时返回 NULL
+ */
+cel_ast_arena_t *cel_ast_arena_create(size_t block_size);
+
+/**
+ * @brief 销毁 AST 分配区 (释放其中所有节点与字面量值)
+ *
+ * @param arena 分配区 (可以为 NULL)
+ */
+void cel_ast_arena_destroy(cel_ast_arena_t *arena);
+
+/**
+ * @brief 安装当前线程的 AST 分配区
+ *
+ * @param arena 分配区 (NULL 表示恢复为堆分配)
+ * @return 之前安装的分配区，供 cel_ast_arena_leave() 恢复
+ */
+cel_ast_arena_t *cel_ast_arena_enter(cel_ast_arena_t *arena);
+
+/**
+ * @brief 恢复之前的 AST 分配区
+ *
+ * @param previous cel_ast_arena_enter() 的返回值
+ */
+void cel_ast_arena_leave(cel_ast_arena_t *previous);
+
+/**
+ * @brief 获取分配区已使用的字节数
+ *
+ * @param arena 分配区
+ * @return 已使用字节数
+ */
+size_t cel_ast_arena_used(const cel_ast_arena_t *arena);
+
+/**
+ * @brief 分配 AST 的存储 (零初始化)
+ *
+ * 当前线程安装了分配区时从中分配，否则使用 calloc。
+ * 用于构造节点的子节点数组，与节点一起由 cel_ast_destroy() 释放。
+ *
+ * @param size 字节数
+ * @return 内存指针，失败返回 NULL
+ */
+void *cel_ast_alloc(size_t size);
+
+/**
+ * @brief 扩大 cel_ast_alloc() 分配的数组 (新增部分未初始化)
+ *
+ * @param ptr 原数组 (可以为 NULL)
+ * @param old_size 原大小
+ * @param size 新大小
+ * @return 新数组，失败返回 NULL (原数组不变)
+ */
+void *cel_ast_grow(void *ptr, size_t old_size, size_t size);
+
+/**
+ * @brief 释放 cel_ast_alloc() 分配的存储 (分配区中的存储不单独释放)
+ *
+ * 必须在分配时相同的分配区设置下调用。
+ *
+ * @param ptr 内存指针 (可以为 NULL)
+ */
+void cel_ast_free(void *ptr);
+
 /* ========== AST 创建 API ========== */
 
+/**
+ * @brief 创建空节点 (字段全部为零，由调用者填写)
+ *
+ * @param type 节点类型
+ * @param loc 源码位置
+ * @return 节点，失败返回 NULL
+ */
+cel_ast_node_t *cel_ast_create_node(cel_ast_node_type_e type,
+				     cel_token_location_t loc);
+
 cel_ast_node_t *cel_ast_create_literal(cel_value_t value,
 					cel_token_location_t loc);
 cel_ast_node_t *cel_ast_create_ident(const char *name, size_t length,
@@ -320,8 +416,32 @@ cel_ast_node_t *cel_ast_create_comprehension(
 	cel_ast_node_t *result,
 	cel_token_location_t loc);
 
+/* ========== AST 复制 API ========== */
+
+/**
+ * @brief 深复制 AST
+ *
+ * 字面量值共享引用。名称 (标识符、字段名、函数名等) 不复制: 位于
+ * [source, source + source_length] 内的名称改为指向 new_source 中的
+ * 相同偏移，使副本引用自己的源代码副本；其余名称 (例如宏生成的
+ * "@result") 与原 AST 共享。
+ *
+ * @param node AST 根节点
+ * @param source 原 AST 的名称所在的源代码 (可为 NULL)
+ * @param source_length 源代码长度
+ * @param new_source 副本使用的源代码 (NULL 表示名称全部共享)
+ * @return 新 AST，失败返回 NULL
+ */
+cel_ast_node_t *cel_ast_copy(const cel_ast_node_t *node, const char *source,
+			     size_t source_length, const char *new_source);
+
 /* ========== AST 销毁 API ========== */
 
+/**
+ * @brief 销毁 AST (分配区中的节点随分配区释放，这里不做任何事)
+ *
+ * @param node AST 根节点 (可以为 NULL)
+ */
 void cel_ast_destroy(cel_ast_node_t *node);
 
 /* ========== AST 辅助函数 ========== */
@@ -0,0 +1,230 @@
+/**
+ * @file cel_bytecode.h
+ * @brief CEL 字节码与寄存器虚拟机
+ *
+ * 将 AST 编译为线性的寄存器指令序列，执行时不再递归遍历 AST。
+ * 常量、变量名与函数调用点在编译期收集到独立的表中，
+ * 推导式的循环变量与累加器在编译期绑定到寄存器，
+ * 执行时无需创建子上下文。以 schema 编译时，已声明的变量
+ * 在编译期解析为激活记录的槽位。
+ */
+
+#ifndef CEL_BYTECODE_H
+#define CEL_BYTECODE_H
+
+#include "cel/cel_activation.h"
+#include "cel/cel_ast.h"
+#include "cel/cel_context.h"
+#include "cel/cel_regex.h"
+#include "cel/cel_value.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 操作码 ========== */
+
+/*
+ * 记号说明: R[x] 为寄存器，K[x] 为常量表，imm 为指令立即数。
+ */
+typedef enum {
+	/* 加载与移动 */
+	CEL_OP_LOAD_CONST,     /* R[dst] = K[imm] */
+	CEL_OP_LOAD_VAR,       /* R[dst] = 上下文变量 names[imm] */
+	CEL_OP_LOAD_SLOT,      /* R[dst] = 激活记录槽位 imm (未设置时按 names[a] 查找上下文) */
+	CEL_OP_MOVE,           /* R[dst] = R[a] */
+
+	/* 一元运算: R[dst] = op R[a] */
+	CEL_OP_NEG,
+	CEL_OP_NOT,
+
+	/* 二元运算: R[dst] = R[a] op R[b] */
+	CEL_OP_ADD,
+	CEL_OP_SUB,
+	CEL_OP_MUL,
+	CEL_OP_DIV,
+	CEL_OP_MOD,
+	CEL_OP_EQ,
+	CEL_OP_NE,
+	CEL_OP_LT,
+	CEL_OP_LE,
+	CEL_OP_GT,
+	CEL_OP_GE,
+	CEL_OP_IN,
+
+	/* 控制流 (flags 选择类型错误信息，见 cel_bool_check_e) */
+	CEL_OP_JUMP,           /* pc = imm */
+	CEL_OP_JUMP_IF_FALSE,  /* R[a] 必须为 bool，为 false 时 pc = imm */
+	CEL_OP_JUMP_IF_TRUE,   /* R[a] 必须为 bool，为 true 时 pc = imm */
+	CEL_OP_CHECK_BOOL,     /* R[a] 必须为 bool */
+
+	/* 访问与构造 */
+	CEL_OP_SELECT,         /* R[dst] = R[a].K[imm] (flags: 可选访问) */
+	CEL_OP_INDEX,          /* R[dst] = R[a][R[b]] (flags: 可选访问) */
+	CEL_OP_LIST,           /* R[dst] = [R[a], ..., R[a + imm - 1]] */
+	CEL_OP_MAP,            /* R[dst] = {R[a]: R[a + 1], ...} (imm 个条目) */
+	CEL_OP_CALL,           /* R[dst] = 上下文函数 calls[imm](R[a], ..., R[a + b - 1]) */
+	CEL_OP_CALL_BUILTIN,   /* R[dst] = 内置函数 imm (cel_function_id_e)(R[a], ...) */
+	CEL_OP_MATCH,          /* R[dst] = R[a].matches(regexes[imm]) (字面量模式，b = 模式长度) */
+
+	/* 推导式迭代 */
+	CEL_OP_ITER_INIT,      /* 检查 R[a] 可迭代，R[dst] = R[dst + 1] = 0 (迭代游标) */
+	CEL_OP_ITER_NEXT,      /* R[dst] = R[a] 的下一个元素 (Map 为键)，游标为 R[b] 与
+	                        * R[b + 1]，迭代结束时 pc = imm (flags 见 CEL_ITER_PAIR) */
+	CEL_OP_APPEND,         /* R[dst] = R[dst] + [R[a]] (R[dst] 为累加器，唯一引用时原地追加) */
+
+	CEL_OP_RETURN,         /* 返回 R[a] */
+} cel_opcode_e;
+
+/**
+ * @brief 布尔检查的错误类别 (存放在指令 flags 中)
+ */
+typedef enum {
+	CEL_BOOL_CHECK_LOGICAL,  /* && 与 || 的操作数 */
+	CEL_BOOL_CHECK_TERNARY,  /* 三元条件 */
+	CEL_BOOL_CHECK_LOOP,     /* 推导式循环条件 */
+} cel_bool_check_e;
+
+/* 访问指令的可选标志 */
+#define CEL_INSTR_OPTIONAL 0x01
+
+/* ITER_NEXT 的双变量标志: R[dst] = 下标 (Map 为键)，R[dst + 1] = 元素 (Map 为值) */
+#define CEL_ITER_PAIR 0x01
+
+/* ========== 字节码结构 ========== */
+
+/**
+ * @brief 指令 (定长 12 字节)
+ */
+typedef struct {
+	uint8_t op;      /* 操作码 (cel_opcode_e) */
+	uint8_t flags;   /* 操作标志 */
+	uint16_t dst;    /* 目标寄存器 */
+	uint16_t a;      /* 第一个操作数寄存器 */
+	uint16_t b;      /* 第二个操作数寄存器 */
+	uint32_t imm;    /* 立即数 (常量索引、跳转目标、数量等) */
+} cel_instr_t;
+
+/**
+ * @brief 指令的源码位置 (只在执行失败时读取，用于错误报告)
+ */
+typedef struct {
+	uint32_t line;   /* 行号 (1-based，0 = 未知) */
+	uint32_t column; /* 列号 (1-based) */
+} cel_instr_loc_t;
+
+/**
+ * @brief 函数调用点 (编译期未解析为内置函数的调用)
+ */
+typedef struct {
+	char *name;          /* 函数名 (null 结尾，字节码持有) */
+	size_t name_length;  /* 函数名长度 */
+	bool has_target;     /* 是否为方法调用 (接收者位于第一个参数) */
+} cel_call_site_t;
+
+/**
+ * @brief 编译后的字节码
+ *
+ * 编译完成后只读，可以在多次执行之间共享。
+ */
+typedef struct cel_bytecode {
+	cel_instr_t *code;           /* 指令序列 */
+	size_t code_length;          /* 指令数量 */
+	cel_instr_loc_t *locs;       /* 各指令对应表达式的源码位置 (与 code 等长) */
+
+	cel_value_t *constants;      /* 常量表 (字节码持有引用) */
+	size_t constant_count;       /* 常量数量 */
+
+	char **names;                /* 变量名表 (null 结尾) */
+	size_t name_count;           /* 变量名数量 */
+
+	cel_call_site_t *calls;      /* 函数调用点表 */
+	size_t call_count;           /* 调用点数量 */
+
+	cel_regex_t **regexes;       /* 预编译的正则表达式 (字节码持有引用) */
+	uint32_t *patterns;          /* 各正则表达式的模式在常量表中的下标 (用于序列化) */
+	size_t regex_count;          /* 正则表达式数量 */
+
+	const cel_schema_t *schema;  /* 编译时使用的变量布局 (不持有，可为 NULL) */
+
+	size_t register_count;       /* 执行所需寄存器数量 */
+	bool borrowed;               /* 指令、源码位置与名称位于外部内存 (见 cel_serialize.h)，不释放 */
+} cel_bytecode_t;
+
+/**
+ * @brief 虚拟机寄存器文件
+ *
+ * 由调用者持有，在多次执行之间复用 (例如批量执行的各行之间)，
+ * 避免每次执行分配与初始化寄存器。零初始化 ({0}) 即可使用，
+ * 每次执行结束后所有寄存器均为 null。一个寄存器文件同一时刻
+ * 只能被一个线程使用。
+ */
+typedef struct {
+	cel_value_t *registers;      /* 寄存器数组 */
+	size_t capacity;             /* 寄存器容量 */
+} cel_vm_frame_t;
+
+/* ========== 编译 API ========== */
+
+/**
+ * @brief 将 AST 编译为字节码
+ *
+ * 字节码不引用 AST，编译后可以独立于 AST 使用。
+ * 在 schema 中声明的标识符编译为槽位访问 (推导式变量优先)。
+ *
+ * @param ast AST 根节点
+ * @param schema 变量布局 (可以为 NULL)
+ * @return 字节码，AST 包含不支持的节点或内存不足时返回 NULL
+ */
+cel_bytecode_t *cel_bytecode_compile(const cel_ast_node_t *ast,
+				     const cel_schema_t *schema);
+
+/**
+ * @brief 销毁字节码
+ *
+ * @param bytecode 字节码
+ */
+void cel_bytecode_destroy(cel_bytecode_t *bytecode);
+
+/* ========== 执行 API ========== */
+
+/**
+ * @brief 在虚拟机中执行字节码
+ *
+ * 语义与 cel_eval() 一致。
+ *
+ * @param bytecode 字节码
+ * @param ctx 求值上下文
+ * @param activation 激活记录 (可以为 NULL，非 NULL 时必须属于编译时的 schema)
+ * @param result 输出结果 (调用者持有，需要 cel_value_destroy)
+ * @return true 成功，false 失败
+ */
+bool cel_vm_execute(const cel_bytecode_t *bytecode, cel_context_t *ctx,
+		    const cel_activation_t *activation, cel_value_t *result);
+
+/**
+ * @brief 使用调用者提供的寄存器文件执行字节码
+ *
+ * 与 cel_vm_execute() 相同，寄存器文件按需扩容后复用。
+ *
+ * @param frame 寄存器文件
+ */
+bool cel_vm_execute_frame(const cel_bytecode_t *bytecode, cel_context_t *ctx,
+			  const cel_activation_t *activation,
+			  cel_vm_frame_t *frame, cel_value_t *result);
+
+/**
+ * @brief 释放寄存器文件
+ *
+ * @param frame 寄存器文件 (结构体本身由调用者持有)
+ */
+void cel_vm_frame_destroy(cel_vm_frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_BYTECODE_H */
@@ -0,0 +1,108 @@
+/**
+ * @file cel_columnar.h
+ * @brief CEL 列式 (向量化) 执行
+ *
+ * 输入以列的形式提供 (int64 / double / bool 数组)，算术、比较与
+ * 逻辑运算一次处理一整段行 (SIMD 内核)，输出满足谓词的行号
+ * (选择向量)。
+ *
+ * 不支持向量化的子表达式 (字符串、函数调用、三元表达式等) 编译为
+ * 字节码逐行求值；某段行出现错误 (例如除零) 或类型不一致时，该段
+ * 整体回退到逐行执行，因此结果与逐行调用 cel_execute_batch_select()
+ * 完全一致。
+ *
+ * 典型用法:
+ *   1. 以 schema 编译程序 (列 i 对应 schema 槽位 i)
+ *   2. cel_columnar_compile() 生成列式执行计划 (只需一次)
+ *   3. 对每批列数据调用 cel_columnar_select()
+ */
+
+#ifndef CEL_COLUMNAR_H
+#define CEL_COLUMNAR_H
+
+#include "cel/cel_context.h"
+#include "cel/cel_program.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 列定义 ========== */
+
+/**
+ * @brief 列类型
+ */
+typedef enum {
+	CEL_COLUMN_INT,              /* int64_t 数组 */
+	CEL_COLUMN_DOUBLE,           /* double 数组 */
+	CEL_COLUMN_BOOL,             /* bool 数组 */
+} cel_column_type_e;
+
+/**
+ * @brief 输入列 (数据由调用者持有)
+ *
+ * data 为 NULL 的列视为未提供，对应变量回退到上下文中按名称查找。
+ */
+typedef struct {
+	cel_column_type_e type;      /* 列类型 */
+	const void *data;            /* 列数据 (row_count 个元素) */
+} cel_column_t;
+
+/* 前向声明 */
+typedef struct cel_columnar_program cel_columnar_program_t;
+
+/* ========== 编译 API ========== */
+
+/**
+ * @brief 生成列式执行计划
+ *
+ * @param program 以 schema 编译的程序 (必须比执行计划存活更久)
+ * @return 执行计划，程序没有 schema 或内存不足时返回 NULL
+ */
+cel_columnar_program_t *cel_columnar_compile(const cel_program_t *program);
+
+/**
+ * @brief 销毁执行计划
+ *
+ * @param columnar 执行计划 (可以为 NULL)
+ */
+void cel_columnar_destroy(cel_columnar_program_t *columnar);
+
+/**
+ * @brief 表达式是否完全向量化 (不包含逐行求值的子表达式)
+ */
+bool cel_columnar_is_vectorized(const cel_columnar_program_t *columnar);
+
+/**
+ * @brief 获取编译时启用的 SIMD 指令集 ("avx2", "sse4.2" 或 "scalar")
+ */
+const char *cel_columnar_simd_level(void);
+
+/* ========== 执行 API ========== */
+
+/**
+ * @brief 对列数据执行谓词，输出满足条件的行号
+ *
+ * 结果为 true 的行号按升序写入 selection；结果为 false、不是 bool
+ * 或执行失败的行不被选中。执行计划只读，可以在多个线程中并发调用
+ * (各线程使用自己的上下文)。
+ *
+ * @param columnar 执行计划
+ * @param ctx 执行上下文 (提供函数与未以列提供的变量)
+ * @param columns 列数组 (按 schema 槽位索引，元素数量为编译时的 schema 大小)
+ * @param row_count 行数
+ * @param selection 输出选择向量 (至少 row_count 个元素)
+ * @return 被选中的行数
+ */
+size_t cel_columnar_select(const cel_columnar_program_t *columnar,
+			   cel_context_t *ctx, const cel_column_t *columns,
+			   size_t row_count, uint32_t *selection);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_COLUMNAR_H */
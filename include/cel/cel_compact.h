@@ -0,0 +1,137 @@
+/**
+ * @file cel_compact.h
+ * @brief CEL 紧凑 AST (按下标引用的连续节点数组)
+ *
+ * cel_ast_node_t 是包含 64 位子节点指针与完整源码位置的大联合体，
+ * 节点分散在堆上。紧凑 AST 将节点按前序连续存放在一个数组中，
+ * 每个节点 16 字节，子节点以 32 位下标引用；源码位置移到与节点
+ * 平行的旁表中，只在出错时读取。名称去重后 null 结尾存放，
+ * 字段名预先转换为字符串值，内置函数在转换时解析为重载编号。
+ *
+ * 紧凑 AST 不引用原 AST 与源代码，转换后可以释放原 AST。
+ * 以 CEL_ENGINE_COMPACT 编译的程序只保留紧凑 AST (见 cel_program.h)。
+ */
+
+#ifndef CEL_COMPACT_H
+#define CEL_COMPACT_H
+
+#include "cel/cel_ast.h"
+#include "cel/cel_context.h"
+#include "cel/cel_value.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 节点编码 ========== */
+
+/* 空下标 (没有子节点或第二个循环变量) */
+#define CEL_COMPACT_NONE UINT32_MAX
+
+/* 节点标志 */
+#define CEL_COMPACT_OPTIONAL 0x1u  /* 可选访问 (.? / [?]) */
+#define CEL_COMPACT_BUILTIN  0x2u  /* 内置函数调用 (c 为重载编号) */
+
+/*
+ * 各类节点的字段含义 (N[x] 为节点下标，C[x] 为 children 中的位置，
+ * V[x] 为 values 下标，S[x] 为 names 中的偏移):
+ *
+ *   LITERAL        a = V[值]
+ *   IDENT          a = S[名称]
+ *   UNARY          op, a = N[操作数]
+ *   BINARY         op, a = N[左], b = N[右]
+ *   TERNARY        a = N[条件], b = N[真分支], c = N[假分支]
+ *   SELECT         a = N[对象], b = V[字段名字符串], OPTIONAL
+ *   INDEX          a = N[容器], b = N[索引], OPTIONAL
+ *   CALL           a = C[接收者与参数], b = 数量,
+ *                  c = 重载编号 (BUILTIN) 或 S[函数名]
+ *   LIST           a = C[元素], b = 数量
+ *   MAP            a = C[键, 值, ...], b = 条目数量
+ *   STRUCT         (不支持，求值时报错)
+ *   COMPREHENSION  a = C[范围, 初始值, 条件, 步骤, 结果, S[第二个循环变量]],
+ *                  b = S[循环变量], c = S[累加器]
+ *
+ * 同名的名称偏移相同，推导式变量按偏移比较。
+ */
+
+/**
+ * @brief 紧凑 AST 节点 (16 字节)
+ */
+typedef struct {
+	uint8_t type;                /* 节点类型 (cel_ast_node_type_e) */
+	uint8_t op;                  /* 运算符 (cel_unary_op_e / cel_binary_op_e) */
+	uint16_t flags;              /* 节点标志 */
+	uint32_t a;                  /* 字段含义见节点编码 */
+	uint32_t b;
+	uint32_t c;
+} cel_compact_node_t;
+
+/**
+ * @brief 节点的源码位置 (旁表)
+ */
+typedef struct {
+	uint32_t line;               /* 行号 */
+	uint32_t column;             /* 列号 */
+} cel_compact_loc_t;
+
+/**
+ * @brief 紧凑 AST
+ *
+ * 所有表位于同一次分配中，根节点下标为 0。
+ * 构造完成后不再修改，可以在多个线程间共享。
+ */
+typedef struct {
+	cel_compact_node_t *nodes;   /* 节点 (前序) */
+	cel_compact_loc_t *locs;     /* 源码位置 (与 nodes 平行) */
+	uint32_t node_count;         /* 节点数量 */
+	uint32_t *children;          /* 可变数量的子节点下标 */
+	uint32_t child_count;        /* children 长度 */
+	cel_value_t *values;         /* 字面量与字段名 (持有引用) */
+	uint32_t value_count;        /* 值数量 */
+	char *names;                 /* 名称 (去重，null 结尾) */
+	uint32_t names_length;       /* 名称表字节数 */
+	size_t size;                 /* 占用的字节数 (不含值引用的字符串与容器) */
+} cel_compact_ast_t;
+
+/* ========== 构造 API ========== */
+
+/**
+ * @brief 将 AST 转换为紧凑 AST
+ *
+ * 字面量值共享引用。
+ *
+ * @param ast AST 根节点
+ * @return 紧凑 AST，节点或表超过 32 位下标范围或内存不足时返回 NULL
+ */
+cel_compact_ast_t *cel_compact_ast_build(const cel_ast_node_t *ast);
+
+/**
+ * @brief 销毁紧凑 AST
+ *
+ * @param ast 紧凑 AST (可以为 NULL)
+ */
+void cel_compact_ast_destroy(cel_compact_ast_t *ast);
+
+/* ========== 求值 API ========== */
+
+/**
+ * @brief 对紧凑 AST 求值
+ *
+ * 语义、代价统计与错误信息与 cel_eval() 一致 (不支持并行推导式)。
+ *
+ * @param ast 紧凑 AST
+ * @param ctx 求值上下文
+ * @param result 输出结果 (调用者持有，需要 cel_value_destroy)
+ * @return true 成功，false 失败
+ */
+bool cel_compact_eval(const cel_compact_ast_t *ast, cel_context_t *ctx,
+		      cel_value_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_COMPACT_H */
@@ -12,6 +12,7 @@
 #include "cel/cel_value.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -146,6 +147,20 @@ cel_error_code_e cel_context_add_variable(cel_context_t *ctx, const char *name,
 cel_value_t *cel_context_get_variable(const cel_context_t *ctx,
 				       const char *name);
 
+/**
+ * @brief 获取变量的版本
+ *
+ * 每次通过 cel_context_add_variable() 赋值都会赋予变量新的版本，
+ * 版本在所有上下文之间唯一，因此版本相同意味着变量未被重新赋值。
+ * 用于检测变量变化 (见 cel_incremental.h)。
+ *
+ * @param ctx 执行上下文 (在父上下文链中查找)
+ * @param name 变量名
+ * @return 版本，变量不存在或由 resolver 提供时返回 0
+ */
+uint64_t cel_context_get_variable_version(const cel_context_t *ctx,
+					  const char *name);
+
 /**
  * @brief 检查变量是否存在
  *
@@ -245,6 +260,8 @@ void cel_context_set_resolver(cel_context_t *ctx, cel_var_resolver_fn resolver,
 /**
  * @brief 设置最大递归深度
  *
+ * 执行选项未指定递归深度时使用该设置 (执行时只读取，不修改上下文)。
+ *
  * @param ctx 执行上下文
  * @param max_depth 最大递归深度 (默认 100)
  */
@@ -261,6 +278,9 @@ size_t cel_context_get_max_recursion(const cel_context_t *ctx);
 /**
  * @brief 获取当前递归深度
  *
+ * 执行不修改上下文，求值的递归深度记录在执行预算中
+ * (见 cel_exec_budget_t)，因此该值始终为 0。
+ *
  * @param ctx 执行上下文
  * @return 当前递归深度
  */
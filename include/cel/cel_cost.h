@@ -0,0 +1,93 @@
+/**
+ * @file cel_cost.h
+ * @brief CEL 静态代价估算
+ *
+ * 在不执行程序的情况下根据 AST 计算执行代价的上下界，代价模型与
+ * 执行预算 (cel_exec_budget_t) 相同：
+ *   - 每次函数调用 / 正则匹配计 CEL_COST_CALL，参数中的字符串、
+ *     列表等每 CEL_COST_SIZE_UNIT 个字节或元素再计 1
+ *   - 推导式每次迭代计 CEL_COST_ITERATION
+ *
+ * 输入的长度由调用者声明 (变量名或字段路径 -> 最大长度)，未声明的
+ * 输入使用默认最大长度；默认值为无上界，此时依赖该输入长度的代价
+ * 上界为 UINT64_MAX。推导式按迭代范围的最大长度展开，嵌套推导式的
+ * 代价相乘。
+ *
+ * 典型用法 (准入检查):
+ *   cel_size_hint_t hints[] = {{"request.path", 256}, {"tags", 16}};
+ *   cel_cost_options_t options = cel_default_cost_options();
+ *   options.hints = hints;
+ *   options.hint_count = 2;
+ *   options.default_max_size = 1024;
+ *
+ *   cel_cost_estimate_t estimate;
+ *   cel_program_estimate_cost(program, &options, &estimate);
+ *   if (estimate.max > budget) { 拒绝规则 }
+ */
+
+#ifndef CEL_COST_H
+#define CEL_COST_H
+
+#include "cel/cel_error.h"
+#include "cel/cel_program.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 类型定义 ========== */
+
+/**
+ * @brief 输入长度声明
+ */
+typedef struct {
+	const char *name;     /* 变量名或字段路径 (例如 "request.path") */
+	uint64_t max_size;    /* 最大长度 (字符串/字节为字节数，列表/映射为元素数) */
+} cel_size_hint_t;
+
+/**
+ * @brief 代价估算选项
+ */
+typedef struct {
+	const cel_size_hint_t *hints;  /* 输入长度声明 (可以为 NULL) */
+	size_t hint_count;             /* 声明数量 */
+	uint64_t default_max_size;     /* 未声明输入 (以及上下文函数结果) 的最大长度 */
+} cel_cost_options_t;
+
+/**
+ * @brief 代价估算结果
+ */
+typedef struct {
+	uint64_t min;    /* 最小代价 (假设求值成功) */
+	uint64_t max;    /* 最大代价 (UINT64_MAX 表示无上界) */
+} cel_cost_estimate_t;
+
+/* ========== 代价估算 API ========== */
+
+/**
+ * @brief 获取默认估算选项 (没有声明，未声明的输入长度无上界)
+ */
+cel_cost_options_t cel_default_cost_options(void);
+
+/**
+ * @brief 估算程序的执行代价
+ *
+ * 对任意满足长度声明的输入，执行程序消耗的代价 (cel_execute_result_t.cost)
+ * 不超过 estimate->max；求值成功时不少于 estimate->min。
+ *
+ * @param program 程序对象
+ * @param options 估算选项 (NULL 使用默认选项)
+ * @param estimate 输出代价上下界
+ * @return CEL_OK 成功，参数无效返回 CEL_ERROR_INVALID_ARGUMENT
+ */
+cel_error_code_e cel_program_estimate_cost(const cel_program_t *program,
+					   const cel_cost_options_t *options,
+					   cel_cost_estimate_t *estimate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_COST_H */
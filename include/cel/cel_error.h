@@ -34,6 +34,8 @@ typedef enum {
 	CEL_ERROR_NOT_FOUND,           /* 未找到 */
 	CEL_ERROR_ALREADY_EXISTS,      /* 已存在 */
 	CEL_ERROR_UNSUPPORTED,         /* 不支持的操作 */
+	CEL_ERROR_TIMEOUT,             /* 执行超时 */
+	CEL_ERROR_COST_LIMIT,          /* 超出代价预算 */
 	CEL_ERROR_INTERNAL,            /* 内部错误 */
 	CEL_ERROR_UNKNOWN              /* 未知错误 */
 } cel_error_code_e;
@@ -11,8 +11,10 @@
 #include "cel/cel_ast.h"
 #include "cel/cel_context.h"
 #include "cel/cel_error.h"
+#include "cel/cel_pool.h"
 #include "cel/cel_value.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +33,282 @@ extern "C" {
 bool cel_eval(const cel_ast_node_t *ast, cel_context_t *ctx,
 	      cel_value_t *result);
 
+/* ========== 值级运算 API ========== */
+
+/*
+ * 以下函数对已求值的操作数执行单个运算，供树遍历求值器与字节码
+ * 虚拟机共用。操作数由调用者持有，写入 result 的值为新引用，
+ * 调用者使用完毕后需要调用 cel_value_destroy。
+ */
+
+/**
+ * @brief 一元运算 (-x, !x)
+ */
+bool cel_eval_unary_op(cel_context_t *ctx, cel_unary_op_e op,
+		       const cel_value_t *operand, cel_value_t *result);
+
+/**
+ * @brief 二元运算
+ *
+ * && 与 || 在此处按严格求值处理 (两侧均需为 bool)，
+ * 短路语义由调用者负责。
+ */
+bool cel_eval_binary_op(cel_context_t *ctx, cel_binary_op_e op,
+			const cel_value_t *left, const cel_value_t *right,
+			cel_value_t *result);
+
+/**
+ * @brief 向推导式累加器追加元素 (accu = accu + [element])
+ *
+ * accu 由调用者持有并原地更新。accu 是列表的唯一引用时直接追加，
+ * 被共享时 (例如初始值为常量 []) 先复制一次，之后的追加即为原地
+ * 追加，因此 map / filter 的累加是均摊 O(1) 的。accu 不是列表时
+ * 与 cel_eval_binary_op 的 + 运算结果相同。
+ */
+bool cel_eval_list_append(cel_context_t *ctx, cel_value_t *accu,
+			  cel_value_t *element);
+
+/**
+ * @brief 字段访问 (obj.field, obj.?field)
+ *
+ * @param field 字段名 (string 值)
+ * @param optional 是否可选访问，字段不存在时返回 null
+ */
+bool cel_eval_select_field(cel_context_t *ctx, const cel_value_t *operand,
+			   const cel_value_t *field, bool optional,
+			   cel_value_t *result);
+
+/**
+ * @brief 索引访问 (list[i], map[key])
+ */
+bool cel_eval_index_value(cel_context_t *ctx, const cel_value_t *operand,
+			  const cel_value_t *index, bool optional,
+			  cel_value_t *result);
+
+/**
+ * @brief 函数调用
+ *
+ * 先按名称、调用形式与参数数量解析内置函数，再查找上下文中注册的函数。
+ *
+ * @param name 函数名 (不要求 null 结尾)
+ * @param name_length 函数名长度
+ * @param args 参数 (方法调用时 args[0] 为接收者)
+ * @param arg_count 参数数量 (包括接收者)
+ * @param has_target 是否为方法调用形式
+ */
+bool cel_eval_call_function(cel_context_t *ctx, const char *name,
+			    size_t name_length, cel_value_t *args,
+			    size_t arg_count, bool has_target,
+			    cel_value_t *result);
+
+/**
+ * @brief 调用上下文中注册的函数
+ *
+ * 用于编译期未解析为内置函数的调用点。
+ *
+ * @param name 函数名 (null 结尾)
+ * @param args 参数 (方法调用时 args[0] 为接收者)
+ * @param arg_count 参数数量 (包括接收者)
+ */
+bool cel_eval_call_context_function(cel_context_t *ctx, const char *name,
+				    cel_value_t *args, size_t arg_count,
+				    cel_value_t *result);
+
+/* ========== 错误通道 API ========== */
+
+/*
+ * 求值错误写入当前线程安装的错误通道 (与执行预算一样在执行期间安装，
+ * 嵌套执行时保存并恢复外层通道)。报告错误只记录错误码、静态描述与
+ * 一段复制的附加信息 (例如变量名)，不分配内存也不输出；出错位置在
+ * 失败返回时由最内层的节点 (或指令) 补充。完整消息只在调用者需要时
+ * 由 cel_eval_error_format() 格式化。没有安装通道时错误被丢弃。
+ * 通道内容只在求值失败时有意义。
+ */
+
+/* 附加信息的最大长度 (包括结尾的 '\0'，超长时截断) */
+#define CEL_EVAL_ERROR_DETAIL 64
+
+/**
+ * @brief 求值错误
+ */
+typedef struct {
+	cel_error_code_e code;               /* 错误码 (CEL_OK = 无错误) */
+	const char *message;                 /* 错误描述 (静态字符串) */
+	char detail[CEL_EVAL_ERROR_DETAIL];  /* 附加信息 (可为空串) */
+	size_t line;                         /* 出错表达式的行号 (1-based，0 = 未知) */
+	size_t column;                       /* 出错表达式的列号 (1-based) */
+} cel_eval_error_t;
+
+/**
+ * @brief 清空错误并安装为当前线程的错误通道
+ *
+ * @param error 错误通道 (由调用者持有，通常位于栈上；NULL 表示丢弃错误)
+ * @return 之前安装的通道 (传给 cel_eval_error_leave 恢复)
+ */
+cel_eval_error_t *cel_eval_error_enter(cel_eval_error_t *error);
+
+/**
+ * @brief 恢复之前安装的错误通道
+ */
+void cel_eval_error_leave(cel_eval_error_t *previous);
+
+/**
+ * @brief 报告求值错误
+ *
+ * @param code 错误码
+ * @param message 错误描述 (必须是静态字符串，只保存指针)
+ */
+void cel_eval_report_error(cel_context_t *ctx, cel_error_code_e code,
+			   const char *message);
+
+/**
+ * @brief 报告带附加信息的求值错误
+ *
+ * @param detail 附加信息 (复制到通道中，不要求 null 结尾)
+ * @param detail_length 附加信息长度
+ */
+void cel_eval_report_error_detail(cel_context_t *ctx, cel_error_code_e code,
+				  const char *message, const char *detail,
+				  size_t detail_length);
+
+/**
+ * @brief 为当前错误补充出错位置 (已有位置时不修改)
+ *
+ * 求值失败返回时调用，因此记录的是最内层出错的表达式。
+ */
+void cel_eval_error_locate(size_t line, size_t column);
+
+/**
+ * @brief 格式化错误消息
+ *
+ * 格式为 "描述[: 附加信息][ (line L, column C)]"。
+ *
+ * @param error 求值错误
+ * @param buffer 输出缓冲区 (消息超长时截断，总是 null 结尾)
+ * @param size 缓冲区大小
+ * @return 完整消息的长度 (与 snprintf 相同，不包括结尾的 '\0')
+ */
+size_t cel_eval_error_format(const cel_eval_error_t *error, char *buffer,
+			     size_t size);
+
+/* ========== 执行预算 API ========== */
+
+/*
+ * 代价模型: 每个函数调用点 (包括 matches) 与每次推导式迭代计为
+ * CEL_COST_CALL / CEL_COST_ITERATION，函数调用另按 string/bytes 参数
+ * 的长度与 list/map 参数的元素数量每 CEL_COST_SIZE_UNIT 计 1。
+ * 代价只依赖于表达式与输入，同一输入的代价总是相同。
+ *
+ * 预算在执行期间安装在当前线程上 (嵌套执行时保存并恢复外层预算)，
+ * 求值器与虚拟机只在调用点与推导式迭代处检查，没有安装预算时检查
+ * 只是一次判空。
+ *
+ * 预算同时限制树遍历求值器 (cel_eval / cel_compact_eval) 的递归深度:
+ * 每层节点递归消耗一层深度。解析器循环构造的左结合链 (二元运算、
+ * 字段与索引访问) 按循环求值，不随链长增加深度。虚拟机不递归，不受
+ * 深度限制。
+ */
+
+#define CEL_COST_CALL 1
+#define CEL_COST_ITERATION 1
+#define CEL_COST_SIZE_UNIT 64
+
+/**
+ * @brief 执行预算
+ */
+typedef struct {
+	uint64_t cost;                 /* 已消耗的代价 */
+	uint64_t cost_limit;           /* 代价上限 (无限时为 UINT64_MAX，触发限制后为 0) */
+	uint64_t deadline_ns;          /* 截止时间 (单调时钟纳秒, 0 = 无限) */
+	uint32_t clock_countdown;      /* 距离下次检查时钟的检查次数 */
+	cel_error_code_e exhausted;    /* 触发的限制 (CEL_OK = 未触发) */
+	size_t depth_left;             /* 剩余的递归深度 (SIZE_MAX = 无限，安装后可以修改) */
+} cel_exec_budget_t;
+
+/**
+ * @brief 初始化执行预算并安装在当前线程上
+ *
+ * @param budget 执行预算 (由调用者持有，通常位于栈上)
+ * @param cost_limit 代价上限 (0 = 无限)
+ * @param timeout_ms 超时时间 (毫秒, 0 = 无限)
+ * @return 之前安装的预算 (传给 cel_exec_budget_leave 恢复)
+ */
+cel_exec_budget_t *cel_exec_budget_enter(cel_exec_budget_t *budget,
+					 uint64_t cost_limit,
+					 uint64_t timeout_ms);
+
+/**
+ * @brief 恢复之前安装的执行预算
+ */
+void cel_exec_budget_leave(cel_exec_budget_t *previous);
+
+/**
+ * @brief 当前线程安装的执行预算
+ *
+ * @return 预算，没有执行时返回 NULL
+ */
+cel_exec_budget_t *cel_exec_budget_current(void);
+
+/**
+ * @brief 消耗代价并检查限制
+ *
+ * @return 未超出限制返回 true；超出时报告错误并返回 false
+ */
+bool cel_exec_budget_charge(cel_context_t *ctx, uint64_t cost);
+
+/**
+ * @brief 消耗一次函数调用的代价
+ *
+ * @param args 参数 (方法调用时包括接收者)
+ * @param arg_count 参数数量
+ */
+bool cel_exec_budget_charge_call(cel_context_t *ctx, const cel_value_t *args,
+				 size_t arg_count);
+
+/* ========== 并行推导式 API ========== */
+
+/*
+ * 迭代范围是列表且元素数量不少于阈值时，以下形式的推导式 (宏展开
+ * 得到的 all / exists / map / filter) 在线程池上并行求值:
+ *   all:    loop_cond = @result,  loop_step = @result && P
+ *   exists: loop_cond = !@result, loop_step = @result || P
+ *   map / filter: loop_cond = true,
+ *           loop_step = @result + [E] 或 F ? @result + [E] : @result
+ * 要求 P / E / F 不引用累加器，且只调用内置函数 (上下文函数可能
+ * 有副作用)。各线程分块领取元素；all / exists 遇到决定结果的元素、
+ * map / filter 遇到错误时，其后的元素不再求值，随后从该元素起顺序
+ * 执行，因此结果、错误与 map / filter 的元素顺序都与顺序执行相同。
+ * 代价为实际执行的迭代的代价之和。
+ *
+ * 并行设置与执行预算一样安装在当前线程上；工作线程内不再嵌套并行。
+ * 未以 CEL_THREAD_SAFE 编译时设置被忽略。
+ */
+
+/* 默认并行阈值 (迭代范围的元素数量) */
+#define CEL_PARALLEL_THRESHOLD 4096
+
+/**
+ * @brief 并行推导式设置
+ */
+typedef struct {
+	cel_thread_pool_t *pool;  /* 线程池 (NULL 表示顺序执行) */
+	size_t threshold;         /* 并行所需的最少元素数量 (0 使用默认阈值) */
+} cel_eval_parallel_t;
+
+/**
+ * @brief 为当前线程安装并行设置
+ *
+ * @param parallel 并行设置 (调用者持有，直到 leave；NULL 表示顺序执行)
+ * @return 之前安装的设置，传给 cel_eval_parallel_leave() 恢复
+ */
+const cel_eval_parallel_t *cel_eval_parallel_enter(
+	const cel_eval_parallel_t *parallel);
+
+/**
+ * @brief 恢复之前的并行设置
+ */
+void cel_eval_parallel_leave(const cel_eval_parallel_t *previous);
+
 #ifdef __cplusplus
 }
 #endif
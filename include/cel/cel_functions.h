@@ -0,0 +1,136 @@
+/**
+ * @file cel_functions.h
+ * @brief CEL 内置函数表
+ *
+ * 内置函数按 (名称, 调用形式, 参数数量) 注册为重载，每个重载有
+ * 固定的编号。编译器在编译期将调用解析为重载编号，执行时按编号
+ * 直接索引函数表，无需比较函数名。接收者的具体类型 (例如 string
+ * 与 list 的 contains) 在重载实现内部按值类型分派。
+ */
+
+#ifndef CEL_FUNCTIONS_H
+#define CEL_FUNCTIONS_H
+
+#include "cel/cel_context.h"
+#include "cel/cel_value.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 函数编号 ========== */
+
+/**
+ * @brief 内置函数重载编号
+ */
+typedef enum {
+	/* 字符串与容器 */
+	CEL_FUNC_SIZE,               /* size(x), x.size() */
+	CEL_FUNC_CONTAINS,           /* contains(x, y), x.contains(y) */
+	CEL_FUNC_STARTS_WITH,        /* startsWith(s, p), s.startsWith(p) */
+	CEL_FUNC_ENDS_WITH,          /* endsWith(s, p), s.endsWith(p) */
+	CEL_FUNC_MATCHES,            /* matches(s, re), s.matches(re) (需要 PCRE2) */
+
+	/* 类型转换 */
+	CEL_FUNC_INT,                /* int(x) */
+	CEL_FUNC_UINT,               /* uint(x) */
+	CEL_FUNC_DOUBLE,             /* double(x) */
+	CEL_FUNC_STRING,             /* string(x) */
+	CEL_FUNC_TYPE,               /* type(x) */
+
+	/* 时间 */
+	CEL_FUNC_TIMESTAMP,          /* timestamp(x) */
+	CEL_FUNC_DURATION,           /* duration(s) */
+	CEL_FUNC_GET_FULL_YEAR,      /* t.getFullYear() */
+	CEL_FUNC_GET_MONTH,          /* t.getMonth() */
+	CEL_FUNC_GET_DAY_OF_MONTH,   /* t.getDayOfMonth() */
+	CEL_FUNC_GET_DAY_OF_WEEK,    /* t.getDayOfWeek() */
+	CEL_FUNC_GET_DAY_OF_YEAR,    /* t.getDayOfYear() */
+	CEL_FUNC_GET_HOURS,          /* t.getHours() */
+	CEL_FUNC_GET_MINUTES,        /* t.getMinutes() */
+	CEL_FUNC_GET_SECONDS,        /* t.getSeconds() */
+	CEL_FUNC_GET_MILLISECONDS,   /* t.getMilliseconds() */
+
+	CEL_FUNC_COUNT               /* 重载数量 */
+} cel_function_id_e;
+
+/**
+ * @brief 调用形式 (可组合)
+ */
+typedef enum {
+	CEL_CALL_GLOBAL = 0x01,      /* f(x, ...) */
+	CEL_CALL_METHOD = 0x02,      /* x.f(...) */
+	CEL_CALL_ANY = 0x03,         /* 两种形式均可 */
+} cel_call_style_e;
+
+/**
+ * @brief 内置函数实现
+ *
+ * 参数数量由重载保证 (方法调用时 args[0] 为接收者)。参数由调用者
+ * 持有；写入 result 的值为新引用。
+ */
+typedef bool (*cel_builtin_fn)(cel_context_t *ctx, const cel_value_t *args,
+			       cel_value_t *result);
+
+/**
+ * @brief 内置函数重载
+ */
+typedef struct {
+	const char *name;            /* 函数名 */
+	size_t name_length;          /* 函数名长度 */
+	unsigned styles;             /* 允许的调用形式 (cel_call_style_e) */
+	size_t arg_count;            /* 参数数量 (包含接收者) */
+	cel_builtin_fn fn;           /* 实现 (未启用时为 NULL) */
+} cel_builtin_t;
+
+/* ========== 解析与调用 API ========== */
+
+/**
+ * @brief 解析内置函数调用
+ *
+ * @param name 函数名 (不要求 null 结尾)
+ * @param name_length 函数名长度
+ * @param has_target 是否为方法调用
+ * @param arg_count 参数数量 (包含接收者)
+ * @param id 输出重载编号
+ * @return true 找到匹配的重载, false 没有匹配的重载
+ */
+bool cel_builtin_resolve(const char *name, size_t name_length, bool has_target,
+			 size_t arg_count, cel_function_id_e *id);
+
+/**
+ * @brief 检查名称是否为内置函数 (不考虑重载)
+ *
+ * @param name 函数名 (不要求 null 结尾)
+ * @param name_length 函数名长度
+ * @return true 是内置函数名
+ */
+bool cel_builtin_exists(const char *name, size_t name_length);
+
+/**
+ * @brief 获取重载描述
+ *
+ * @param id 重载编号
+ * @return 重载描述，编号无效返回 NULL
+ */
+const cel_builtin_t *cel_builtin_get(cel_function_id_e id);
+
+/**
+ * @brief 调用已解析的内置函数
+ *
+ * @param id 重载编号 (必须由 cel_builtin_resolve 得到)
+ * @param ctx 求值上下文
+ * @param args 参数数组 (数量与重载一致)
+ * @param result 输出结果 (调用者持有)
+ * @return true 成功，false 失败
+ */
+bool cel_builtin_call(cel_function_id_e id, cel_context_t *ctx,
+		      const cel_value_t *args, cel_value_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_FUNCTIONS_H */
@@ -0,0 +1,111 @@
+/**
+ * @file cel_incremental.h
+ * @brief CEL 增量求值 (按变量依赖缓存子树结果)
+ *
+ * 同一程序在输入变化后反复求值时，多数子表达式的结果并未改变。
+ * 增量求值句柄在创建时分析程序 AST，记录每个子树依赖的自由变量，
+ * 并在依赖集合发生变化的位置设置缓存点 (例如 size(a) + size(b) 中的
+ * size(a) 与 size(b))。求值时通过变量版本
+ * (cel_context_get_variable_version()) 找出自上次求值以来被重新赋值
+ * 的变量，只重新计算依赖这些变量的缓存点，其余缓存点直接使用上次
+ * 的结果，因此重新求值的代价与变化的范围成正比。
+ *
+ * 以下子树不缓存，每次求值都重新计算：
+ * - 调用上下文函数的子树 (函数可能有副作用或依赖外部状态)
+ * - 引用外层推导式变量的子树 (循环体中与循环变量无关的部分仍可缓存)
+ * - 依赖第 64 个之后的变量的子树
+ *
+ * 典型用法:
+ *   cel_incremental_t *inc = cel_incremental_create(program);
+ *   for (;;) {
+ *       cel_context_add_variable(ctx, "price", &price);
+ *       cel_execute_result_t r = cel_incremental_evaluate(inc, ctx);
+ *       ...
+ *       cel_execute_result_destroy(&r);
+ *   }
+ *   cel_incremental_destroy(inc);
+ */
+
+#ifndef CEL_INCREMENTAL_H
+#define CEL_INCREMENTAL_H
+
+#include "cel/cel_context.h"
+#include "cel/cel_program.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 前向声明 */
+typedef struct cel_incremental cel_incremental_t;
+
+/* ========== 增量求值 API ========== */
+
+/**
+ * @brief 创建增量求值句柄
+ *
+ * 句柄持有程序 AST 与源代码的副本，创建后可以立即销毁程序。
+ * 句柄保存每次求值的缓存，不能在多个线程间共享。
+ *
+ * @param program 程序对象
+ * @return 新创建的句柄，参数无效或内存不足时返回 NULL
+ */
+cel_incremental_t *cel_incremental_create(const cel_program_t *program);
+
+/**
+ * @brief 销毁增量求值句柄
+ *
+ * @param incremental 句柄 (可以为 NULL)
+ */
+void cel_incremental_destroy(cel_incremental_t *incremental);
+
+/**
+ * @brief 求值 (只重新计算依赖已变化变量的子树)
+ *
+ * 结果与 cel_execute() 相同 (使用树遍历求值)。需要重新计算的缓存点
+ * 先于整个表达式求值，即使原表达式会因短路而跳过它们；缓存点求值
+ * 失败时不缓存，错误在整个表达式求值时按原语义报告。result.cost 为
+ * 本次实际求值的代价，所有变量都未变化时为 0。
+ *
+ * 不同上下文中的变量版本互不相同，换用上下文求值时所有依赖变量都
+ * 视为已变化。由 resolver 提供的变量没有版本，每次都视为已变化。
+ *
+ * @param incremental 句柄
+ * @param ctx 执行上下文
+ * @return 执行结果 (需使用 cel_execute_result_destroy() 释放)
+ */
+cel_execute_result_t cel_incremental_evaluate(cel_incremental_t *incremental,
+					      cel_context_t *ctx);
+
+/**
+ * @brief 丢弃所有缓存结果
+ *
+ * 变量版本无法反映的变化 (例如修改了变量所引用的列表) 之后调用，
+ * 下一次求值重新计算所有缓存点。
+ *
+ * @param incremental 句柄
+ */
+void cel_incremental_invalidate(cel_incremental_t *incremental);
+
+/**
+ * @brief 获取缓存点数量
+ */
+size_t cel_incremental_cache_count(const cel_incremental_t *incremental);
+
+/**
+ * @brief 获取程序依赖的自由变量数量
+ */
+size_t cel_incremental_variable_count(const cel_incremental_t *incremental);
+
+/**
+ * @brief 获取上一次求值重新计算的缓存点数量
+ */
+size_t cel_incremental_recomputed_count(const cel_incremental_t *incremental);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_INCREMENTAL_H */
@@ -80,6 +80,51 @@ void arena_destroy(arena_t *arena);
 void arena_stats(const arena_t *arena, size_t *total_allocated,
 		 size_t *total_used, size_t *block_count);
 
+/* ========== 执行期临时分配 ========== */
+
+/*
+ * 在当前线程安装临时分配区后，该线程创建的字符串、字节数组、列表与
+ * Map (连同列表与 Map 的内部存储) 从 arena 中顺序分配，释放时只减少
+ * 引用计数、不归还内存，由 arena_reset() 一次性回收。
+ * 对象记录自身是否来自临时分配区 (scratch 字段)，与堆上的对象可以
+ * 互相引用。临时分配区只被安装它的线程分配。
+ */
+
+/**
+ * @brief 安装当前线程的临时分配区
+ *
+ * @param arena 临时分配区 (NULL 表示恢复为堆分配)
+ * @return 之前安装的临时分配区，供 arena_scratch_leave() 恢复
+ */
+arena_t *arena_scratch_enter(arena_t *arena);
+
+/**
+ * @brief 恢复之前的临时分配区
+ *
+ * @param previous arena_scratch_enter() 的返回值
+ */
+void arena_scratch_leave(arena_t *previous);
+
+/**
+ * @brief 分配值的存储
+ *
+ * 当前线程安装了临时分配区时从中分配，否则 (或临时分配区分配失败时)
+ * 使用 malloc。
+ *
+ * @param size 要分配的字节数
+ * @param scratch 输出是否从临时分配区分配
+ * @return 分配的内存指针 (失败返回 NULL)
+ */
+void *arena_scratch_alloc(size_t size, bool *scratch);
+
+/**
+ * @brief 释放值的存储 (临时分配区的内存不单独释放)
+ *
+ * @param ptr arena_scratch_alloc() 返回的指针 (可以为 NULL)
+ * @param scratch 是否从临时分配区分配
+ */
+void arena_scratch_free(void *ptr, bool scratch);
+
 /* ========== 便捷宏 ========== */
 
 /**
@@ -0,0 +1,78 @@
+/**
+ * @file cel_optimizer.h
+ * @brief CEL AST 优化器
+ *
+ * 在编译期对 AST 进行改写，减少每次执行时的重复工作。
+ */
+
+#ifndef CEL_OPTIMIZER_H
+#define CEL_OPTIMIZER_H
+
+#include "cel/cel_ast.h"
+#include "cel/cel_context.h"
+#include "cel/cel_error.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 优化 API ========== */
+
+/**
+ * @brief 常量折叠
+ *
+ * 将纯常量子树 (只由字面量、运算符、列表/Map 字面量与内置函数调用
+ * 组成) 在编译期求值一次，替换为字面量节点。常量列表与 Map 因此
+ * 只构造一次，由 AST 持有并在每次执行时共享 (只读)。
+ *
+ * 条件为常量的三元表达式替换为被选中的分支，
+ * `false && x` 与 `true || x` 分别折叠为 false 与 true。
+ *
+ * 求值失败的子树 (例如 1 / 0) 保持原样，由执行时报告错误。
+ *
+ * @param ast AST 根节点的地址 (根节点可能被替换)
+ * @return CEL_OK 成功，CEL_ERROR_OUT_OF_MEMORY 内存不足 (AST 仍然有效)
+ */
+cel_error_code_e cel_optimize_fold_constants(cel_ast_node_t **ast);
+
+/**
+ * @brief 融合链式推导式
+ *
+ * 迭代范围是 map / filter 推导式 (宏展开形式) 的推导式改写为直接
+ * 迭代内层范围的单个推导式: 内层的过滤条件成为守卫，外层循环变量
+ * 替换为内层的元素表达式，不再构造中间列表。例如
+ *   items.filter(x, x.active).map(x, x.id).exists(id, id in blocked)
+ * 改写为对 items 的一次迭代，exists 一旦满足即结束。
+ *
+ * 外层循环变量出现多次时，只有元素表达式是标识符或字段访问才融合
+ * (避免重复求值)；外层循环条件只能是 true、@result 或 !@result。
+ * 融合后不再对被跳过的元素求值，原来在这些元素上发生的错误不再
+ * 报告。
+ *
+ * @param ast AST 根节点的地址
+ * @return CEL_OK 成功，CEL_ERROR_OUT_OF_MEMORY 内存不足 (AST 仍然有效)
+ */
+cel_error_code_e cel_optimize_fuse_comprehensions(cel_ast_node_t **ast);
+
+/**
+ * @brief 部分求值
+ *
+ * 以 known 中变量的值替换 AST 中引用这些变量的自由标识符 (推导式
+ * 变量遮蔽的除外)，再进行常量折叠；迭代范围已知的推导式也整体求值。
+ * 引用其余变量 (未知变量) 或上下文函数的子树保持原样，留待执行时
+ * 求值。与常量折叠相同，求值失败的子树保持原样。
+ *
+ * @param ast AST 根节点的地址 (根节点可能被替换)
+ * @param known 已知变量 (只读取变量，不使用其中的函数)
+ * @return CEL_OK 成功，CEL_ERROR_OUT_OF_MEMORY 内存不足 (AST 仍然有效，
+ *         但可能只替换了部分变量)
+ */
+cel_error_code_e cel_optimize_partial_eval(cel_ast_node_t **ast,
+					   const cel_context_t *known);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_OPTIMIZER_H */
@@ -0,0 +1,76 @@
+/**
+ * @file cel_pool.h
+ * @brief CEL 工作线程池
+ *
+ * 线程池由调用者创建并在多次执行之间复用，用于并行求值大范围的
+ * 推导式 (见 cel_execute_options_t.pool)。一个线程池同一时刻只执行
+ * 一个任务；任务提交时线程池正忙 (例如另一个线程正在使用) 则提交
+ * 失败，调用者应改为顺序执行，因此多个线程共享线程池不会死锁。
+ *
+ * 需要以 CEL_THREAD_SAFE 编译 (引用计数必须是原子的)，否则
+ * cel_thread_pool_create() 返回 NULL。
+ */
+
+#ifndef CEL_POOL_H
+#define CEL_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 类型定义 ========== */
+
+/* 前向声明 */
+typedef struct cel_thread_pool cel_thread_pool_t;
+
+/**
+ * @brief 线程池任务
+ *
+ * 每个参与线程 (包括提交任务的线程) 各调用一次，任务自行领取工作。
+ *
+ * @param arg 任务参数
+ * @param worker 参与线程编号 (0 为提交任务的线程)
+ */
+typedef void (*cel_pool_task_fn)(void *arg, size_t worker);
+
+/* ========== 线程池 API ========== */
+
+/**
+ * @brief 创建线程池
+ *
+ * @param threads 参与线程总数 (包括提交任务的线程，至少为 1)
+ * @return 新创建的线程池，失败或未启用 CEL_THREAD_SAFE 时返回 NULL
+ */
+cel_thread_pool_t *cel_thread_pool_create(size_t threads);
+
+/**
+ * @brief 销毁线程池 (等待工作线程退出)
+ *
+ * @param pool 线程池 (可以为 NULL)
+ */
+void cel_thread_pool_destroy(cel_thread_pool_t *pool);
+
+/**
+ * @brief 获取参与线程总数
+ */
+size_t cel_thread_pool_threads(const cel_thread_pool_t *pool);
+
+/**
+ * @brief 在所有参与线程上执行任务并等待完成
+ *
+ * @param pool 线程池
+ * @param task 任务
+ * @param arg 任务参数
+ * @return true 已执行，false 线程池正忙或参数无效 (任务未执行)
+ */
+bool cel_thread_pool_run(cel_thread_pool_t *pool, cel_pool_task_fn task,
+			 void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_POOL_H */
@@ -3,33 +3,75 @@
  * @brief CEL 程序对象 API
  *
  * 提供编译和执行 CEL 表达式的高层 API。
+ *
+ * 线程安全约定:
+ * - 编译后的程序不可变，执行 API 只读取程序，同一程序可以在多个线程
+ *   中并发执行，不需要加锁。
+ * - 每次执行的可变状态 (寄存器文件、递归深度限制) 保存在调用者提供的
+ *   cel_exec_state_t 中，每个线程使用自己的执行状态。
+ * - 执行不修改上下文。执行期间没有线程修改上下文时，多个线程可以共享
+ *   同一上下文；共享值的引用计数需要以 CEL_THREAD_SAFE 构建 (默认开启)。
+ *   注册到上下文的自定义函数需要自行保证线程安全。
  */
 
 #ifndef CEL_PROGRAM_H
 #define CEL_PROGRAM_H
 
+#include "cel/cel_activation.h"
 #include "cel/cel_ast.h"
+#include "cel/cel_bytecode.h"
+#include "cel/cel_compact.h"
 #include "cel/cel_context.h"
 #include "cel/cel_error.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_memory.h"
 #include "cel/cel_parser.h"
+#include "cel/cel_pool.h"
 #include "cel/cel_value.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* 前向声明 (见 cel_serialize.h) */
+typedef struct cel_bundle cel_bundle_t;
+
 /* ========== 程序对象 ========== */
 
+/**
+ * @brief 执行引擎
+ */
+typedef enum {
+	CEL_ENGINE_BYTECODE,           /* 字节码虚拟机 (默认) */
+	CEL_ENGINE_TREE_WALK,          /* 树遍历求值器 (参考实现) */
+	CEL_ENGINE_COMPACT,            /* 紧凑 AST 求值器 (只保留紧凑 AST，见 cel_compact.h) */
+} cel_engine_e;
+
 /**
  * @brief CEL 编译后的程序对象
  *
- * 包含解析后的 AST，可以多次执行。
+ * 包含解析后的 AST 与编译后的字节码，可以多次执行。
+ * 编译完成后不再修改 (引用计数除外)，可以在多个线程间共享。
+ * 以 CEL_ENGINE_COMPACT 编译的程序用紧凑 AST 代替 AST，需要 AST 的
+ * 接口 (部分求值、序列化、代价估算、规则集等) 不接受这样的程序。
  */
 typedef struct cel_program {
-	cel_ast_node_t *ast;           /* 解析后的 AST */
-	char *source;                  /* 源代码副本 (用于错误报告) */
-	size_t source_length;          /* 源代码长度 */
+	cel_ast_node_t *ast;           /* 解析后的 AST (紧凑引擎的程序为 NULL) */
+	cel_ast_arena_t *ast_arena;    /* AST 所在的分配区 (为 NULL 时 AST 位于堆上) */
+	cel_bytecode_t *bytecode;      /* 字节码 (为 NULL 时使用树遍历求值) */
+	cel_compact_ast_t *compact;    /* 紧凑 AST (不为 NULL 时 ast 为 NULL) */
+	size_t eval_depth;             /* AST 深度 (不限制执行，只作为加载时的解码深度上限) */
+	const cel_schema_t *schema;    /* 编译时使用的变量布局 (不持有，可为 NULL) */
+	char *source;                  /* 源代码副本 (AST 中的名称指向副本) */
+	size_t source_length;          /* 源代码长度 (加载的程序包括其后的名称表) */
+	cel_bundle_t *bundle;          /* 程序所在的程序包 (不为 NULL 时 source 位于其中，持有引用) */
+#ifdef CEL_THREAD_SAFE
+	atomic_int ref_count;          /* 引用计数 (见 cel_program_retain) */
+#else
+	int ref_count;                 /* 引用计数 (见 cel_program_retain) */
+#endif
 } cel_program_t;
 
 /**
@@ -38,14 +80,22 @@ typedef struct cel_program {
 typedef struct {
 	size_t max_recursion_depth;    /* 最大解析递归深度 (默认 100) */
 	bool enable_macros;            /* 是否启用宏 (默认 true) */
+	cel_engine_e engine;           /* 执行引擎 (默认 CEL_ENGINE_BYTECODE) */
+	const cel_schema_t *schema;    /* 变量布局 (默认 NULL，见 cel_activation.h) */
+	bool fold_constants;           /* 是否折叠常量子树 (默认 true，见 cel_optimizer.h) */
+	bool fuse_comprehensions;      /* 是否融合链式推导式 (默认 true，见 cel_optimizer.h) */
 } cel_compile_options_t;
 
 /**
  * @brief 执行选项
  */
 typedef struct {
-	size_t max_eval_recursion;     /* 最大求值递归深度 (默认 100) */
+	size_t max_eval_recursion;     /* 树遍历求值的最大递归深度 (默认 100，0 = 使用上下文的设置) */
 	size_t timeout_ms;             /* 超时时间 (毫秒, 0 = 无限) */
+	uint64_t max_cost;             /* 代价上限 (0 = 无限，代价模型见 cel_eval.h) */
+	cel_thread_pool_t *pool;       /* 并行推导式的线程池 (默认 NULL，见 cel_eval.h) */
+	size_t parallel_threshold;     /* 并行所需的最少元素数量 (0 = CEL_PARALLEL_THRESHOLD) */
+	arena_t *scratch;              /* 中间值的临时分配区 (默认 NULL，见 cel_execute_with_options) */
 } cel_execute_options_t;
 
 /**
@@ -60,11 +110,18 @@ typedef struct {
 
 /**
  * @brief 执行结果
+ *
+ * 失败时 eval_error.code 总是错误码。求值错误 (包括超时与超出代价
+ * 上限与递归深度超限) 只记录在 eval_error 中，不分配内存；参数错误
+ * (程序、上下文或激活记录无效) 另外在 error 中给出消息。完整消息
+ * 由 cel_execute_result_message() 按需格式化。
  */
 typedef struct {
 	cel_value_t value;             /* 执行结果值 */
-	cel_error_t *error;            /* 错误信息 */
+	cel_error_t *error;            /* 参数错误 (动态分配，求值错误时为 NULL) */
 	bool success;                  /* 是否成功 */
+	uint64_t cost;                 /* 消耗的代价 (函数调用与推导式迭代) */
+	cel_eval_error_t eval_error;   /* 错误码与出错位置 (成功时 code 为 CEL_OK) */
 } cel_execute_result_t;
 
 /* ========== 编译 API ========== */
@@ -73,6 +130,7 @@ typedef struct {
  * @brief 编译 CEL 表达式
  *
  * 将 CEL 源代码编译为可执行的程序对象。
+ * 默认编译为字节码；AST 包含字节码不支持的节点时回退到树遍历求值。
  *
  * @param source 源代码字符串
  * @return 编译结果
@@ -109,7 +167,20 @@ void cel_compile_result_destroy(cel_compile_result_t *result);
 /* ========== 程序管理 ========== */
 
 /**
- * @brief 销毁程序对象
+ * @brief 增加程序的引用计数
+ *
+ * 编译得到的程序持有一个引用。共享程序的各方 (例如程序缓存与正在
+ * 执行它的线程) 各自持有引用，并各自调用 cel_program_destroy() 释放。
+ *
+ * @param program 程序对象
+ * @return program
+ */
+cel_program_t *cel_program_retain(cel_program_t *program);
+
+/**
+ * @brief 释放程序对象的一个引用
+ *
+ * 最后一个引用释放时销毁程序。
  *
  * @param program 程序对象
  */
@@ -123,6 +194,32 @@ void cel_program_destroy(cel_program_t *program);
  */
 const char *cel_program_get_source(const cel_program_t *program);
 
+/* ========== 部分求值 API ========== */
+
+/**
+ * @brief 部分求值
+ *
+ * 以 known 中已知变量的值对程序求值，生成只依赖其余 (未知) 变量的
+ * 剩余程序：引用已知变量的子树被替换为其结果，迭代范围已知的推导式
+ * 被整体求值 (见 cel_optimize_partial_eval())。剩余程序与原程序使用
+ * 相同的变量布局和执行引擎，在包含全部变量的上下文中执行的结果与原
+ * 程序相同，但执行代价更低；所有变量都已知时剩余程序是单个字面量。
+ *
+ * 剩余程序独立于原程序 (可以先销毁原程序)，需使用
+ * cel_program_destroy() 释放。known 中的值被剩余程序共享 (引用计数)。
+ *
+ * @example
+ *   // 每个租户的配置只需代入一次
+ *   cel_program_t *residual = cel_partial_eval(program, tenant_ctx);
+ *   cel_execute_result_t r = cel_execute(residual, request_ctx);
+ *
+ * @param program 程序对象
+ * @param known 已知变量 (只读取变量)
+ * @return 剩余程序，参数无效或内存不足时返回 NULL
+ */
+cel_program_t *cel_partial_eval(const cel_program_t *program,
+				const cel_context_t *known);
+
 /* ========== 执行 API ========== */
 
 /**
@@ -148,6 +245,18 @@ cel_execute_result_t cel_execute(const cel_program_t *program, cel_context_t *ct
 /**
  * @brief 执行程序 (带选项)
  *
+ * 选项只作用于本次执行，不修改上下文。超时或超出代价上限时执行
+ * 失败，错误码分别为 CEL_ERROR_TIMEOUT 与 CEL_ERROR_COST_LIMIT；
+ * 时间与代价在函数调用点与推导式迭代处检查。
+ *
+ * 设置线程池时使用树遍历求值 (并行推导式只在树遍历求值中实现)，
+ * 变量解析器 (cel_context_set_resolver) 可能被多个线程同时调用。
+ *
+ * 设置临时分配区时，执行期间创建的中间值从中分配 (见 cel_memory.h)，
+ * 结果值返回前复制到堆上，执行结束后重置临时分配区，重复执行时
+ * 几乎不再调用 malloc。临时分配区同一时刻只能被一次执行使用；
+ * 变量解析器与自定义函数不能在执行结束后保留执行期间创建的值。
+ *
  * @param program 程序对象
  * @param ctx 执行上下文
  * @param options 执行选项
@@ -157,6 +266,168 @@ cel_execute_result_t cel_execute_with_options(const cel_program_t *program,
 					       cel_context_t *ctx,
 					       const cel_execute_options_t *options);
 
+/**
+ * @brief 使用激活记录执行程序
+ *
+ * 程序必须以激活记录所属的 schema 编译。已设置的槽位直接按槽位
+ * 读取，未设置的槽位与未声明的变量在 ctx 中按名称查找。
+ *
+ * @param program 程序对象
+ * @param ctx 执行上下文 (提供函数与其余变量)
+ * @param activation 激活记录 (可以为 NULL，等同于 cel_execute)
+ * @return 执行结果
+ *
+ * @example
+ *   cel_schema_t *schema = cel_schema_create();
+ *   size_t age_slot;
+ *   cel_schema_add_variable(schema, "age", &age_slot);
+ *
+ *   cel_compile_options_t options = cel_default_compile_options();
+ *   options.schema = schema;
+ *   cel_compile_result_t compiled = cel_compile_with_options("age >= 18", &options);
+ *
+ *   cel_activation_t *activation = cel_activation_create(schema);
+ *   cel_value_t age = cel_value_int(25);
+ *   cel_activation_set(activation, age_slot, &age);
+ *   cel_execute_result_t result =
+ *       cel_execute_with_activation(compiled.program, ctx, activation);
+ */
+cel_execute_result_t cel_execute_with_activation(const cel_program_t *program,
+						  cel_context_t *ctx,
+						  const cel_activation_t *activation);
+
+/* ========== 执行状态 API ========== */
+
+/* 前向声明 */
+typedef struct cel_exec_state cel_exec_state_t;
+
+/**
+ * @brief 创建执行状态
+ *
+ * 执行状态保存一次执行的全部可变状态，可以在多次执行之间复用：
+ * 寄存器文件按需扩容后保留，之后执行字节码程序不再为执行状态分配
+ * 内存。执行状态不能被多个线程同时使用。
+ *
+ * @return 新创建的执行状态 (使用默认执行选项)，失败返回 NULL
+ */
+cel_exec_state_t *cel_exec_state_create(void);
+
+/**
+ * @brief 销毁执行状态
+ *
+ * @param state 执行状态 (可以为 NULL)
+ */
+void cel_exec_state_destroy(cel_exec_state_t *state);
+
+/**
+ * @brief 设置执行选项
+ *
+ * @param state 执行状态
+ * @param options 执行选项 (NULL 恢复默认选项)
+ */
+void cel_exec_state_set_options(cel_exec_state_t *state,
+				const cel_execute_options_t *options);
+
+/**
+ * @brief 使用执行状态执行程序
+ *
+ * 结果与 cel_execute_with_activation() 相同。程序与上下文只被读取，
+ * 多个线程可以使用各自的执行状态并发执行同一程序。
+ *
+ * @param program 程序对象
+ * @param ctx 执行上下文
+ * @param activation 激活记录 (可以为 NULL)
+ * @param state 执行状态
+ * @return 执行结果
+ *
+ * @example
+ *   // 每个工作线程
+ *   cel_exec_state_t *state = cel_exec_state_create();
+ *   for (;;) {
+ *       cel_execute_result_t result =
+ *           cel_execute_with_state(program, ctx, activation, state);
+ *       // 使用 result.value
+ *       cel_execute_result_destroy(&result);
+ *   }
+ *   cel_exec_state_destroy(state);
+ */
+cel_execute_result_t cel_execute_with_state(const cel_program_t *program,
+					     cel_context_t *ctx,
+					     const cel_activation_t *activation,
+					     cel_exec_state_t *state);
+
+/* ========== 批量执行 API ========== */
+
+/**
+ * @brief 选择位图所需的 uint64_t 数量
+ */
+#define CEL_SELECTION_WORDS(count) (((count) + 63) / 64)
+
+/**
+ * @brief 对一组激活记录批量执行程序
+ *
+ * 结果与逐行调用 cel_execute_with_activation() 相同，但参数检查只
+ * 进行一次，各行之间复用同一寄存器文件。
+ *
+ * @param program 程序对象
+ * @param ctx 执行上下文 (各行共享，提供函数与其余变量)
+ * @param activations 激活记录数组 (元素可以为 NULL)
+ * @param count 行数
+ * @param results 输出结果数组 (count 个元素，每个元素需要调用
+ *                cel_execute_result_destroy)
+ * @return 执行成功的行数
+ *
+ * @example
+ *   cel_execute_result_t results[256];
+ *   cel_execute_batch(program, ctx, activations, 256, results);
+ *   for (size_t i = 0; i < 256; i++) {
+ *       // 使用 results[i]
+ *       cel_execute_result_destroy(&results[i]);
+ *   }
+ */
+size_t cel_execute_batch(const cel_program_t *program, cel_context_t *ctx,
+			 const cel_activation_t *const *activations,
+			 size_t count, cel_execute_result_t *results);
+
+/**
+ * @brief 批量执行谓词并输出选择位图
+ *
+ * 结果为 true 的行在位图中置位 (第 i 行对应 selection[i / 64] 的
+ * 第 i % 64 位)；结果为 false、不是 bool 或执行失败的行不置位。
+ * 不为每行构造结果对象，适合过滤场景。
+ *
+ * @param program 程序对象
+ * @param ctx 执行上下文
+ * @param activations 激活记录数组 (元素可以为 NULL)
+ * @param count 行数
+ * @param selection 输出位图 (至少 CEL_SELECTION_WORDS(count) 个元素)
+ * @return 被选中的行数
+ */
+size_t cel_execute_batch_select(const cel_program_t *program,
+				cel_context_t *ctx,
+				const cel_activation_t *const *activations,
+				size_t count, uint64_t *selection);
+
+/**
+ * @brief 格式化执行失败的错误消息
+ *
+ * 消息只在调用时格式化，失败的执行本身不构造消息。
+ *
+ * @param result 执行结果
+ * @param buffer 输出缓冲区 (消息超长时截断，总是 null 结尾)
+ * @param size 缓冲区大小
+ * @return 完整消息的长度 (成功的结果为 0)
+ *
+ * @example
+ *   if (!result.success) {
+ *       char message[256];
+ *       cel_execute_result_message(&result, message, sizeof(message));
+ *       // 例如 "Undefined variable: user (line 1, column 1)"
+ *   }
+ */
+size_t cel_execute_result_message(const cel_execute_result_t *result,
+				  char *buffer, size_t size);
+
 /**
  * @brief 销毁执行结果
  *
@@ -172,7 +443,8 @@ void cel_execute_result_destroy(cel_execute_result_t *result);
  * @brief 编译并执行表达式 (一步完成)
  *
  * 这是最简单的使用方式，适合一次性求值。
- * 如果需要多次执行同一表达式，请使用 cel_compile() + cel_execute()。
+ * 如果需要多次执行同一表达式，请使用 cel_compile() + cel_execute()，
+ * 或者安装程序缓存 (见 cel_program_cache.h)，此时重复的表达式只编译一次。
  *
  * @param source 源代码字符串
  * @param ctx 执行上下文
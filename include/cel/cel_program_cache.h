@@ -0,0 +1,138 @@
+/**
+ * @file cel_program_cache.h
+ * @brief CEL 程序缓存 (按源代码与编译选项复用编译结果)
+ *
+ * 以字符串形式到达的表达式 (例如租户规则) 往往反复出现。程序缓存
+ * 将源代码与编译选项映射到共享的程序对象，命中时省去词法分析、
+ * 解析、优化与字节码编译。
+ *
+ * 缓存按键的哈希分为 CEL_PROGRAM_CACHE_SHARDS 个分片，每个分片有
+ * 自己的锁与 LRU 顺序，不同分片上的查找互不阻塞。编译在锁外进行。
+ * 缓存条目与调用者各自持有程序的引用 (见 cel_program_retain())，
+ * 被淘汰的程序在调用者释放之前仍然有效。
+ *
+ * 典型用法:
+ *   cel_program_cache_t *cache = cel_program_cache_create(4096);
+ *   cel_compile_result_t r = cel_program_cache_get(cache, source, NULL);
+ *   if (!r.has_errors) {
+ *       cel_execute_result_t e = cel_execute(r.program, ctx);
+ *       ...
+ *   }
+ *   cel_compile_result_destroy(&r);    // 释放调用者的引用
+ *
+ * cel_eval_expression() 在安装了缓存 (cel_program_cache_install()) 时
+ * 通过缓存取得程序，调用方式不变。
+ */
+
+#ifndef CEL_PROGRAM_CACHE_H
+#define CEL_PROGRAM_CACHE_H
+
+#include "cel/cel_program.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 分片数量
+ */
+#ifndef CEL_PROGRAM_CACHE_SHARDS
+#define CEL_PROGRAM_CACHE_SHARDS 16
+#endif
+
+/* 前向声明 */
+typedef struct cel_program_cache cel_program_cache_t;
+
+/**
+ * @brief 缓存统计 (所有分片之和)
+ */
+typedef struct {
+	uint64_t hits;                 /* 命中次数 */
+	uint64_t misses;               /* 未命中次数 (包括编译失败) */
+	uint64_t evictions;            /* 淘汰的条目数量 */
+	size_t size;                   /* 当前缓存的程序数量 */
+	size_t capacity;               /* 容量 (各分片容量之和) */
+} cel_program_cache_stats_t;
+
+/* ========== 程序缓存 API ========== */
+
+/**
+ * @brief 创建程序缓存
+ *
+ * 每个分片最多缓存 capacity / CEL_PROGRAM_CACHE_SHARDS (向上取整)
+ * 个程序，超出时淘汰该分片中最久未使用的程序。
+ *
+ * @param capacity 容量 (0 表示不缓存，每次都重新编译)
+ * @return 新创建的缓存，失败返回 NULL
+ */
+cel_program_cache_t *cel_program_cache_create(size_t capacity);
+
+/**
+ * @brief 销毁程序缓存
+ *
+ * 释放缓存持有的引用；调用者持有的程序不受影响。
+ *
+ * @param cache 程序缓存 (可以为 NULL)
+ */
+void cel_program_cache_destroy(cel_program_cache_t *cache);
+
+/**
+ * @brief 获取 (必要时编译并缓存) 程序
+ *
+ * 结果与 cel_compile_with_options() 相同。成功时 result.program 是
+ * 调用者持有的引用，使用 cel_compile_result_destroy() 或
+ * cel_program_destroy() 释放；编译错误不缓存。
+ * 编译选项中的 schema 按指针比较，缓存期间必须保持有效。
+ * 可以在多个线程中并发调用。
+ *
+ * @param cache 程序缓存
+ * @param source 源代码字符串
+ * @param options 编译选项 (为 NULL 时使用默认选项)
+ * @return 编译结果
+ */
+cel_compile_result_t cel_program_cache_get(cel_program_cache_t *cache,
+					   const char *source,
+					   const cel_compile_options_t *options);
+
+/**
+ * @brief 获取缓存统计
+ *
+ * @param cache 程序缓存
+ * @param stats 输出统计
+ */
+void cel_program_cache_stats(cel_program_cache_t *cache,
+			     cel_program_cache_stats_t *stats);
+
+/**
+ * @brief 清空缓存 (不重置统计)
+ *
+ * @param cache 程序缓存
+ */
+void cel_program_cache_clear(cel_program_cache_t *cache);
+
+/**
+ * @brief 安装 cel_eval_expression() 使用的程序缓存
+ *
+ * 安装后 cel_eval_expression() 以默认编译选项通过该缓存取得程序。
+ * 缓存必须在卸载 (安装 NULL) 且正在进行的 cel_eval_expression()
+ * 调用全部结束之后才能销毁。
+ *
+ * @param cache 程序缓存 (NULL 表示不使用缓存)
+ * @return 之前安装的缓存
+ */
+cel_program_cache_t *cel_program_cache_install(cel_program_cache_t *cache);
+
+/**
+ * @brief 获取当前安装的程序缓存
+ *
+ * @return 程序缓存，未安装时返回 NULL
+ */
+cel_program_cache_t *cel_program_cache_installed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_PROGRAM_CACHE_H */
@@ -0,0 +1,119 @@
+/**
+ * @file cel_regex.h
+ * @brief CEL 正则表达式 (matches) 编译与缓存
+ *
+ * 正则表达式编译一次后可在多个线程中并发匹配 (启用 PCRE2 JIT)。
+ * 匹配使用线程私有的匹配数据，匹配过程不分配内存。
+ *
+ * - 字面量模式在程序编译期编译，由字节码持有。
+ * - 动态模式经过全局 LRU 缓存 (线程安全)，避免每次求值重新编译。
+ *
+ * 未启用 CEL_ENABLE_REGEX 时所有编译函数均返回 NULL。
+ */
+
+#ifndef CEL_REGEX_H
+#define CEL_REGEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 配置 ========== */
+
+/**
+ * @brief 动态模式缓存的默认容量
+ */
+#ifndef CEL_REGEX_CACHE_CAPACITY
+#define CEL_REGEX_CACHE_CAPACITY 128
+#endif
+
+/* 前向声明 */
+typedef struct cel_regex cel_regex_t;
+
+/* ========== 编译与匹配 API ========== */
+
+/**
+ * @brief 编译正则表达式
+ *
+ * @param pattern 模式 (不要求 null 结尾)
+ * @param length 模式长度
+ * @param error 输出错误信息 (可以为 NULL)
+ * @param error_size 错误缓冲区大小
+ * @return 编译后的正则表达式 (引用计数为 1)，失败返回 NULL
+ */
+cel_regex_t *cel_regex_compile(const char *pattern, size_t length,
+			       char *error, size_t error_size);
+
+/**
+ * @brief 增加引用计数
+ *
+ * @param regex 正则表达式
+ * @return regex
+ */
+cel_regex_t *cel_regex_retain(cel_regex_t *regex);
+
+/**
+ * @brief 释放引用，引用计数归零时销毁
+ *
+ * @param regex 正则表达式 (可以为 NULL)
+ */
+void cel_regex_release(cel_regex_t *regex);
+
+/**
+ * @brief 执行匹配 (部分匹配，与 CEL matches() 语义一致)
+ *
+ * 可在多个线程中对同一正则表达式并发调用。
+ *
+ * @param regex 正则表达式
+ * @param subject 目标字符串 (不要求 null 结尾)
+ * @param length 目标字符串长度
+ * @param matched 输出是否匹配
+ * @return true 成功，false 匹配出错 (例如内存不足或回溯超限)
+ */
+bool cel_regex_match(const cel_regex_t *regex, const char *subject,
+		     size_t length, bool *matched);
+
+/* ========== 缓存 API ========== */
+
+/**
+ * @brief 从缓存中获取正则表达式，未命中时编译并加入缓存
+ *
+ * 缓存满时淘汰最久未使用的模式。返回的引用由调用者释放，
+ * 因此被淘汰的模式在使用中仍然有效。
+ *
+ * @param pattern 模式 (不要求 null 结尾)
+ * @param length 模式长度
+ * @param error 输出错误信息 (可以为 NULL)
+ * @param error_size 错误缓冲区大小
+ * @return 正则表达式 (新引用)，编译失败返回 NULL
+ */
+cel_regex_t *cel_regex_cache_get(const char *pattern, size_t length,
+				 char *error, size_t error_size);
+
+/**
+ * @brief 设置缓存容量 (0 表示禁用缓存)
+ *
+ * 超出新容量的模式立即被淘汰。
+ *
+ * @param capacity 最多缓存的模式数量
+ */
+void cel_regex_cache_set_capacity(size_t capacity);
+
+/**
+ * @brief 获取缓存中的模式数量
+ */
+size_t cel_regex_cache_size(void);
+
+/**
+ * @brief 清空缓存
+ */
+void cel_regex_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_REGEX_H */
@@ -0,0 +1,124 @@
+/**
+ * @file cel_ruleset.h
+ * @brief CEL 规则集 (多程序共享子表达式求值)
+ *
+ * 将多个程序的 AST 合并为一个有向无环图 (DAG)：结构相同的子表达式
+ * (例如多条规则共同引用的 request.auth.claims.email) 只保留一个节点。
+ * 求值时每个节点在一次求值中最多计算一次，结果被所有引用它的规则
+ * 共享；短路求值与三元表达式的语义与逐条执行程序一致。
+ *
+ * 相同参数的上下文函数调用同样被合并，因此在一次求值中只调用一次。
+ * 推导式不参与合并，按字节码独立求值。
+ *
+ * 规则顶层合取项中形如 tenant == "acme" 或 status >= 500 的守卫
+ * (字段与字面量比较) 被放入等值 / 范围索引。求值时先根据字段值
+ * 找出守卫可能成立的候选规则，其余规则不求值。
+ *
+ * 典型用法:
+ *   cel_ruleset_t *rules = cel_ruleset_create(schema);
+ *   cel_ruleset_add(rules, program_a, 10, &id_a);
+ *   cel_ruleset_add(rules, program_b, 0, &id_b);
+ *
+ *   size_t matches[2];
+ *   size_t n = cel_ruleset_evaluate(rules, ctx, activation,
+ *                                   CEL_RULESET_ALL_MATCH, matches);
+ */
+
+#ifndef CEL_RULESET_H
+#define CEL_RULESET_H
+
+#include "cel/cel_activation.h"
+#include "cel/cel_context.h"
+#include "cel/cel_error.h"
+#include "cel/cel_program.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ========== 类型定义 ========== */
+
+/**
+ * @brief 匹配模式
+ */
+typedef enum {
+	CEL_RULESET_ALL_MATCH,       /* 报告所有匹配的规则 (按规则编号升序) */
+	CEL_RULESET_FIRST_MATCH,     /* 只报告优先级最高的匹配规则 */
+} cel_ruleset_mode_e;
+
+/* 前向声明 */
+typedef struct cel_ruleset cel_ruleset_t;
+
+/* ========== 规则集 API ========== */
+
+/**
+ * @brief 创建规则集
+ *
+ * @param schema 变量布局 (可以为 NULL，加入的程序必须以相同 schema 编译)
+ * @return 新创建的规则集，失败返回 NULL
+ */
+cel_ruleset_t *cel_ruleset_create(const cel_schema_t *schema);
+
+/**
+ * @brief 销毁规则集
+ *
+ * @param ruleset 规则集 (可以为 NULL)
+ */
+void cel_ruleset_destroy(cel_ruleset_t *ruleset);
+
+/**
+ * @brief 加入一条规则
+ *
+ * 程序的 AST 被合并到规则集的 DAG 中，规则集不引用程序，
+ * 加入后可以立即销毁程序。
+ *
+ * @param ruleset 规则集
+ * @param program 规则程序 (结果为 true 时规则匹配)
+ * @param priority 优先级 (越大越优先，相同优先级先加入者优先)
+ * @param rule_id 输出规则编号 (从 0 开始连续分配，可以为 NULL)
+ * @return CEL_OK 成功，schema 不一致返回 CEL_ERROR_INVALID_ARGUMENT
+ */
+cel_error_code_e cel_ruleset_add(cel_ruleset_t *ruleset,
+				 const cel_program_t *program, int priority,
+				 size_t *rule_id);
+
+/**
+ * @brief 获取规则数量
+ */
+size_t cel_ruleset_rule_count(const cel_ruleset_t *ruleset);
+
+/**
+ * @brief 获取 DAG 节点数量 (合并公共子表达式之后)
+ */
+size_t cel_ruleset_node_count(const cel_ruleset_t *ruleset);
+
+/**
+ * @brief 获取按守卫索引的规则数量 (其余规则每次求值都需要检查)
+ */
+size_t cel_ruleset_indexed_count(const cel_ruleset_t *ruleset);
+
+/**
+ * @brief 对一个激活记录求值所有规则
+ *
+ * 结果为 true 的规则匹配；结果不是 bool 或求值失败的规则不匹配。
+ * 规则集只读，可以在多个线程中并发求值 (各线程使用自己的上下文)。
+ *
+ * @param ruleset 规则集
+ * @param ctx 执行上下文
+ * @param activation 激活记录 (可以为 NULL，必须属于规则集的 schema)
+ * @param mode 匹配模式
+ * @param matches 输出匹配的规则编号 (ALL_MATCH 模式至少 rule_count 个元素，
+ *                FIRST_MATCH 模式至少 1 个)
+ * @return 匹配的规则数量
+ */
+size_t cel_ruleset_evaluate(const cel_ruleset_t *ruleset, cel_context_t *ctx,
+			    const cel_activation_t *activation,
+			    cel_ruleset_mode_e mode, size_t *matches);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_RULESET_H */
@@ -0,0 +1,155 @@
+/**
+ * @file cel_serialize.h
+ * @brief CEL 程序序列化与程序包 (mmap 加载)
+ *
+ * 编译后的程序可以序列化为定长头部加若干节的二进制映像:
+ * - 文本节: 源代码 (null 结尾)，其后是源代码之外的名称与字符串常量
+ * - AST 节: 按前序排列的 32 位字流，名称以文本节中的偏移表示
+ * - 字节码节: 指令与源码位置 (原样存放)、常量、变量名、调用点与
+ *   正则表达式模式
+ *
+ * 多个程序映像可以写入一个程序包文件 (cel_bundle_write())。打开程序包
+ * 时以只读方式 mmap 整个文件，加载的程序直接使用映射中的源代码、
+ * 名称、指令与源码位置，不复制；只有 AST 节点、常量值与正则表达式在
+ * 加载时重建。同一程序包被多个进程打开时共享相同的物理页。
+ *
+ * 映像按本机字节序与结构布局写入，头部记录格式版本、字节序与指令
+ * 大小，不匹配时拒绝加载。程序包假定由可信的一方生成，加载时检查
+ * 各节边界，但不验证指令语义。
+ *
+ * 典型用法:
+ *   // 构建阶段
+ *   cel_bundle_write("rules.celb", programs, count);
+ *
+ *   // 每个工作进程
+ *   cel_bundle_t *bundle = cel_bundle_open("rules.celb");
+ *   for (size_t i = 0; i < cel_bundle_count(bundle); i++) {
+ *       programs[i] = cel_bundle_load(bundle, i, NULL);
+ *   }
+ *   cel_bundle_close(bundle);          // 程序各自持有程序包的引用
+ */
+
+#ifndef CEL_SERIALIZE_H
+#define CEL_SERIALIZE_H
+
+#include "cel/cel_activation.h"
+#include "cel/cel_error.h"
+#include "cel/cel_program.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 程序映像格式版本
+ *
+ * AST、值或指令的编码 (包括操作码与内置函数编号) 变化时递增。
+ */
+#define CEL_PROGRAM_FORMAT_VERSION 1
+
+/* ========== 程序序列化 API ========== */
+
+/**
+ * @brief 序列化程序
+ *
+ * 与 snprintf 相同，总是返回映像的完整大小，只有 size 足够时才写入
+ * buffer。可以先以 (NULL, 0) 调用取得所需大小。
+ * 常量与字面量只支持 null、bool、int、uint、double、string、bytes、
+ * timestamp、duration 以及由它们组成的 list 与 map。
+ *
+ * @param program 程序对象
+ * @param buffer 输出缓冲区 (按 8 字节对齐，可以为 NULL)
+ * @param size 缓冲区大小
+ * @return 映像大小，程序无效或包含无法序列化的值时返回 0
+ */
+size_t cel_program_serialize(const cel_program_t *program, void *buffer,
+			     size_t size);
+
+/**
+ * @brief 从映像加载程序 (复制)
+ *
+ * 映像被复制到程序持有的内存中，调用后 data 可以释放。
+ * 序列化的程序使用了 schema 时必须提供变量声明顺序相同的 schema，
+ * 否则必须为 NULL。
+ *
+ * @param data 映像
+ * @param size 映像大小
+ * @param schema 变量布局 (可以为 NULL)
+ * @return 程序 (使用 cel_program_destroy() 释放)，映像无效、版本不匹配、
+ *         schema 不匹配或内存不足时返回 NULL
+ */
+cel_program_t *cel_program_deserialize(const void *data, size_t size,
+				       const cel_schema_t *schema);
+
+/* ========== 程序包 API ========== */
+
+/**
+ * @brief 将程序写入程序包文件
+ *
+ * 先写入同一目录下的临时文件再重命名，已经打开旧文件的进程不受影响。
+ *
+ * @param path 文件路径
+ * @param programs 程序数组
+ * @param count 程序数量
+ * @return CEL_OK 成功；程序无法序列化返回 CEL_ERROR_UNSUPPORTED，
+ *         文件无法写入返回 CEL_ERROR_INVALID_ARGUMENT
+ */
+cel_error_code_e cel_bundle_write(const char *path,
+				  cel_program_t *const *programs,
+				  size_t count);
+
+/**
+ * @brief 打开 (只读映射) 程序包
+ *
+ * @param path 文件路径
+ * @return 程序包，文件不存在、格式或版本不匹配时返回 NULL
+ */
+cel_bundle_t *cel_bundle_open(const char *path);
+
+/**
+ * @brief 增加程序包的引用计数
+ *
+ * @param bundle 程序包
+ * @return bundle
+ */
+cel_bundle_t *cel_bundle_retain(cel_bundle_t *bundle);
+
+/**
+ * @brief 释放程序包的一个引用
+ *
+ * 从程序包加载的程序各自持有引用，映射在最后一个程序销毁后解除。
+ *
+ * @param bundle 程序包 (可以为 NULL)
+ */
+void cel_bundle_close(cel_bundle_t *bundle);
+
+/**
+ * @brief 获取程序包中的程序数量
+ *
+ * @param bundle 程序包
+ * @return 程序数量
+ */
+size_t cel_bundle_count(const cel_bundle_t *bundle);
+
+/**
+ * @brief 从程序包加载程序 (零复制)
+ *
+ * 程序的源代码、名称、指令与源码位置指向映射，程序持有程序包的引用。
+ * 每次调用都创建新的程序对象。schema 的要求与 cel_program_deserialize()
+ * 相同。
+ *
+ * @param bundle 程序包
+ * @param index 程序下标
+ * @param schema 变量布局 (可以为 NULL)
+ * @return 程序 (使用 cel_program_destroy() 释放)，失败返回 NULL
+ */
+cel_program_t *cel_bundle_load(cel_bundle_t *bundle, size_t index,
+			       const cel_schema_t *schema);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CEL_SERIALIZE_H */
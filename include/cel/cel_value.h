@@ -56,6 +56,7 @@ typedef struct {
 #else
 	int ref_count;
 #endif
+	bool scratch;     /* 是否来自临时分配区 (见 cel_memory.h) */
 	size_t length;    /* 字符串长度 (字节数，不含 \0) */
 	char data[];      /* 柔性数组 (以 \0 结尾) */
 } cel_string_t;
@@ -71,6 +72,7 @@ typedef struct {
 #else
 	int ref_count;
 #endif
+	bool scratch;          /* 是否来自临时分配区 (见 cel_memory.h) */
 	size_t length;         /* 字节数组长度 */
 	unsigned char data[];  /* 柔性数组 */
 } cel_bytes_t;
@@ -118,6 +120,7 @@ typedef struct {
 #else
 	int ref_count;
 #endif
+	bool scratch;               /* 是否来自临时分配区 (见 cel_memory.h) */
 	size_t length;              /* 元素数量 */
 	size_t capacity;            /* 分配的容量 */
 	struct cel_value **items;   /* cel_value_t 指针数组 */
@@ -140,6 +143,7 @@ typedef struct {
 #else
 	int ref_count;
 #endif
+	bool scratch;               /* 是否来自临时分配区 (见 cel_memory.h) */
 	size_t size;                /* 键值对数量 */
 	size_t bucket_count;        /* 桶数量 */
 	cel_map_entry_t **buckets;  /* 哈希桶数组 */
@@ -252,6 +256,29 @@ cel_value_t cel_value_duration(int64_t seconds, int32_t nanoseconds);
  */
 void cel_value_destroy(cel_value_t *value);
 
+/**
+ * @brief 共享值 (增加引用计数)
+ *
+ * 返回值的浅拷贝。对于引用计数类型 (string, bytes, list, map)，
+ * 增加引用计数，调用者需要对返回值调用 cel_value_destroy。
+ *
+ * @param value 要共享的值
+ * @return 持有新引用的值
+ */
+cel_value_t cel_value_retain(const cel_value_t *value);
+
+/**
+ * @brief 将值中来自临时分配区的部分复制到堆上
+ *
+ * 值 (包括列表元素与 Map 的键值) 引用了临时分配区中的对象时，
+ * 以堆上的副本替换并释放原值；完全位于堆上的部分直接共享。
+ * 之后重置临时分配区不会影响该值 (见 cel_memory.h)。
+ *
+ * @param value 要提升的值 (原地替换)
+ * @return true 成功，false 内存不足 (值保持不变)
+ */
+bool cel_value_promote(cel_value_t *value);
+
 /* ========== 值访问 API ========== */
 
 /**
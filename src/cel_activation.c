@@ -0,0 +1,238 @@
+/**
+ * @file cel_activation.c
+ * @brief CEL 变量布局与激活记录实现
+ */
+
+#include "cel/cel_activation.h"
+#include "uthash/uthash.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 变量声明 (uthash, 按名称索引)
+ */
+typedef struct {
+	char *name;          /* 键 (变量名) */
+	size_t slot;         /* 槽位编号 */
+	UT_hash_handle hh;   /* uthash 句柄 */
+} cel_schema_entry_t;
+
+/**
+ * @brief 变量布局结构 (内部实现)
+ */
+struct cel_schema {
+	cel_schema_entry_t *index;    /* 名称 -> 槽位 (uthash 哈希表) */
+	cel_schema_entry_t **slots;   /* 槽位 -> 声明 */
+	size_t count;                 /* 已声明变量数量 */
+	size_t capacity;              /* 槽位数组容量 */
+};
+
+/* ========== Schema ========== */
+
+cel_schema_t *cel_schema_create(void)
+{
+	return calloc(1, sizeof(cel_schema_t));
+}
+
+void cel_schema_destroy(cel_schema_t *schema)
+{
+	if (!schema) {
+		return;
+	}
+
+	cel_schema_entry_t *entry, *tmp;
+	HASH_ITER(hh, schema->index, entry, tmp)
+	{
+		HASH_DEL(schema->index, entry);
+		free(entry->name);
+		free(entry);
+	}
+
+	free(schema->slots);
+	free(schema);
+}
+
+cel_error_code_e cel_schema_add_variable(cel_schema_t *schema, const char *name,
+					  size_t *slot)
+{
+	if (!schema || !name) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	size_t length = strlen(name);
+	cel_schema_entry_t *entry = NULL;
+	HASH_FIND(hh, schema->index, name, length, entry);
+	if (entry) {
+		if (slot) {
+			*slot = entry->slot;
+		}
+		return CEL_OK;
+	}
+
+	if (schema->count == schema->capacity) {
+		size_t new_capacity = schema->capacity ? schema->capacity * 2 : 8;
+		cel_schema_entry_t **new_slots =
+			realloc(schema->slots,
+				new_capacity * sizeof(cel_schema_entry_t *));
+		if (!new_slots) {
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+		schema->slots = new_slots;
+		schema->capacity = new_capacity;
+	}
+
+	entry = malloc(sizeof(cel_schema_entry_t));
+	if (!entry) {
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+
+	entry->name = malloc(length + 1);
+	if (!entry->name) {
+		free(entry);
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+	memcpy(entry->name, name, length + 1);
+	entry->slot = schema->count;
+
+	schema->slots[schema->count++] = entry;
+	HASH_ADD_KEYPTR(hh, schema->index, entry->name, length, entry);
+
+	if (slot) {
+		*slot = entry->slot;
+	}
+	return CEL_OK;
+}
+
+bool cel_schema_find(const cel_schema_t *schema, const char *name,
+		     size_t length, size_t *slot)
+{
+	if (!schema || !name) {
+		return false;
+	}
+
+	cel_schema_entry_t *entry = NULL;
+	HASH_FIND(hh, schema->index, name, length, entry);
+	if (!entry) {
+		return false;
+	}
+
+	if (slot) {
+		*slot = entry->slot;
+	}
+	return true;
+}
+
+size_t cel_schema_size(const cel_schema_t *schema)
+{
+	return schema ? schema->count : 0;
+}
+
+const char *cel_schema_get_name(const cel_schema_t *schema, size_t slot)
+{
+	if (!schema || slot >= schema->count) {
+		return NULL;
+	}
+	return schema->slots[slot]->name;
+}
+
+/* ========== Activation ========== */
+
+cel_activation_t *cel_activation_create(const cel_schema_t *schema)
+{
+	if (!schema) {
+		return NULL;
+	}
+
+	cel_activation_t *activation = calloc(1, sizeof(cel_activation_t));
+	if (!activation) {
+		return NULL;
+	}
+
+	activation->schema = schema;
+	activation->count = schema->count;
+
+	if (activation->count > 0) {
+		activation->values = calloc(activation->count, sizeof(cel_value_t));
+		activation->bound = calloc(activation->count, sizeof(bool));
+		if (!activation->values || !activation->bound) {
+			cel_activation_destroy(activation);
+			return NULL;
+		}
+	}
+
+	return activation;
+}
+
+void cel_activation_destroy(cel_activation_t *activation)
+{
+	if (!activation) {
+		return;
+	}
+
+	if (activation->values && activation->bound) {
+		cel_activation_clear(activation);
+	}
+	free(activation->values);
+	free(activation->bound);
+	free(activation);
+}
+
+cel_error_code_e cel_activation_set(cel_activation_t *activation, size_t slot,
+				     const cel_value_t *value)
+{
+	if (!activation || !value) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+	if (slot >= activation->count) {
+		return CEL_ERROR_OUT_OF_RANGE;
+	}
+
+	/* 先持有新值再释放旧值，允许设置为槽位自身的值 */
+	cel_value_t new_value = cel_value_retain(value);
+	cel_value_destroy(&activation->values[slot]);
+	activation->values[slot] = new_value;
+	activation->bound[slot] = true;
+	return CEL_OK;
+}
+
+cel_error_code_e cel_activation_set_variable(cel_activation_t *activation,
+					      const char *name,
+					      const cel_value_t *value)
+{
+	if (!activation || !name) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	size_t slot;
+	if (!cel_schema_find(activation->schema, name, strlen(name), &slot)) {
+		return CEL_ERROR_NOT_FOUND;
+	}
+
+	return cel_activation_set(activation, slot, value);
+}
+
+const cel_value_t *cel_activation_get(const cel_activation_t *activation,
+				      size_t slot)
+{
+	if (!activation || slot >= activation->count ||
+	    !activation->bound[slot]) {
+		return NULL;
+	}
+	return &activation->values[slot];
+}
+
+void cel_activation_clear(cel_activation_t *activation)
+{
+	if (!activation) {
+		return;
+	}
+
+	for (size_t i = 0; i < activation->count; i++) {
+		if (activation->bound[i]) {
+			cel_value_destroy(&activation->values[i]);
+			activation->bound[i] = false;
+		}
+	}
+}
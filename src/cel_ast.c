@@ -4,6 +4,7 @@
  */
 
 #include "cel/cel_ast.h"
+#include "cel/cel_memory.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -89,18 +90,142 @@ const char *cel_binary_op_name(cel_binary_op_e op)
 	}
 }
 
+/* ========== AST 分配区 ========== */
+
+/* 分配区的内存块大小 (默认值与范围) */
+#define AST_ARENA_BLOCK_SIZE 2048
+#define AST_ARENA_MIN_BLOCK 512
+#define AST_ARENA_MAX_BLOCK (64 * 1024)
+
+/**
+ * @brief AST 分配区 (位于自身的第一个内存块中)
+ */
+struct cel_ast_arena {
+	arena_t *arena;            /* 节点与数组的存储 */
+	cel_ast_node_t *literals;  /* 字面量节点链表 */
+};
+
+/* 当前线程安装的 AST 分配区 (没有时为 NULL) */
+static _Thread_local cel_ast_arena_t *current_arena = NULL;
+
+cel_ast_arena_t *cel_ast_arena_create(size_t block_size)
+{
+	if (block_size == 0) {
+		block_size = AST_ARENA_BLOCK_SIZE;
+	} else if (block_size < AST_ARENA_MIN_BLOCK) {
+		block_size = AST_ARENA_MIN_BLOCK;
+	} else if (block_size > AST_ARENA_MAX_BLOCK) {
+		block_size = AST_ARENA_MAX_BLOCK;
+	}
+
+	arena_t *arena = arena_create(block_size);
+	cel_ast_arena_t *ast_arena = ARENA_ALLOC(arena, cel_ast_arena_t);
+	if (!ast_arena) {
+		arena_destroy(arena);
+		return NULL;
+	}
+	ast_arena->arena = arena;
+	ast_arena->literals = NULL;
+	return ast_arena;
+}
+
+void cel_ast_arena_destroy(cel_ast_arena_t *arena)
+{
+	if (!arena) {
+		return;
+	}
+
+	for (cel_ast_node_t *node = arena->literals; node;
+	     node = node->as.literal.next) {
+		cel_value_destroy(&node->as.literal.value);
+	}
+	arena_destroy(arena->arena);
+}
+
+cel_ast_arena_t *cel_ast_arena_enter(cel_ast_arena_t *arena)
+{
+	cel_ast_arena_t *previous = current_arena;
+	current_arena = arena;
+	return previous;
+}
+
+void cel_ast_arena_leave(cel_ast_arena_t *previous)
+{
+	current_arena = previous;
+}
+
+size_t cel_ast_arena_used(const cel_ast_arena_t *arena)
+{
+	size_t used = 0;
+	if (arena) {
+		arena_stats(arena->arena, NULL, &used, NULL);
+	}
+	return used;
+}
+
+void *cel_ast_alloc(size_t size)
+{
+	if (!current_arena) {
+		return calloc(1, size);
+	}
+
+	void *ptr = arena_alloc(current_arena->arena, size);
+	if (ptr) {
+		memset(ptr, 0, size);
+	}
+	return ptr;
+}
+
+void *cel_ast_grow(void *ptr, size_t old_size, size_t size)
+{
+	if (!current_arena) {
+		return realloc(ptr, size);
+	}
+
+	/* 分配区中的旧数组随分配区释放 */
+	void *grown = arena_alloc(current_arena->arena, size);
+	if (grown && ptr) {
+		memcpy(grown, ptr, old_size);
+	}
+	return grown;
+}
+
+void cel_ast_free(void *ptr)
+{
+	if (!current_arena) {
+		free(ptr);
+	}
+}
+
 /* ========== AST 创建函数 ========== */
 
+cel_ast_node_t *cel_ast_create_node(cel_ast_node_type_e type,
+				     cel_token_location_t loc)
+{
+	cel_ast_node_t *node = cel_ast_alloc(sizeof(cel_ast_node_t));
+	if (!node) {
+		return NULL;
+	}
+
+	node->type = type;
+	node->loc = loc;
+	node->in_arena = current_arena != NULL;
+	if (type == CEL_AST_LITERAL && current_arena) {
+		node->as.literal.next = current_arena->literals;
+		current_arena->literals = node;
+	}
+
+	return node;
+}
+
 cel_ast_node_t *cel_ast_create_literal(cel_value_t value,
 					cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_LITERAL, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_LITERAL;
-	node->loc = loc;
 	node->as.literal.value = value;
 
 	return node;
@@ -109,13 +234,11 @@ cel_ast_node_t *cel_ast_create_literal(cel_value_t value,
 cel_ast_node_t *cel_ast_create_ident(const char *name, size_t length,
 				      cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_IDENT, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_IDENT;
-	node->loc = loc;
 	node->as.ident.name = name;
 	node->as.ident.length = length;
 
@@ -126,13 +249,11 @@ cel_ast_node_t *cel_ast_create_unary(cel_unary_op_e op,
 				      cel_ast_node_t *operand,
 				      cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_UNARY, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_UNARY;
-	node->loc = loc;
 	node->as.unary.op = op;
 	node->as.unary.operand = operand;
 
@@ -144,13 +265,11 @@ cel_ast_node_t *cel_ast_create_binary(cel_binary_op_e op,
 				       cel_ast_node_t *right,
 				       cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_BINARY, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_BINARY;
-	node->loc = loc;
 	node->as.binary.op = op;
 	node->as.binary.left = left;
 	node->as.binary.right = right;
@@ -163,13 +282,11 @@ cel_ast_node_t *cel_ast_create_ternary(cel_ast_node_t *condition,
 					cel_ast_node_t *if_false,
 					cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_TERNARY, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_TERNARY;
-	node->loc = loc;
 	node->as.ternary.condition = condition;
 	node->as.ternary.if_true = if_true;
 	node->as.ternary.if_false = if_false;
@@ -181,13 +298,11 @@ cel_ast_node_t *cel_ast_create_select(cel_ast_node_t *operand,
 				       const char *field, size_t field_length,
 				       bool optional, cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_SELECT, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_SELECT;
-	node->loc = loc;
 	node->as.select.operand = operand;
 	node->as.select.field = field;
 	node->as.select.field_length = field_length;
@@ -200,13 +315,11 @@ cel_ast_node_t *cel_ast_create_index(cel_ast_node_t *operand,
 				      cel_ast_node_t *index, bool optional,
 				      cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_INDEX, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_INDEX;
-	node->loc = loc;
 	node->as.index.operand = operand;
 	node->as.index.index = index;
 	node->as.index.optional = optional;
@@ -220,13 +333,11 @@ cel_ast_node_t *cel_ast_create_call(const char *function,
 				     cel_ast_node_t **args, size_t arg_count,
 				     cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_CALL, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_CALL;
-	node->loc = loc;
 	node->as.call.function = function;
 	node->as.call.function_length = function_length;
 	node->as.call.target = target;
@@ -240,13 +351,11 @@ cel_ast_node_t *cel_ast_create_list(cel_ast_node_t **elements,
 				     size_t element_count,
 				     cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_LIST, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_LIST;
-	node->loc = loc;
 	node->as.list.elements = elements;
 	node->as.list.element_count = element_count;
 
@@ -257,13 +366,11 @@ cel_ast_node_t *cel_ast_create_map(cel_ast_map_entry_t *entries,
 				    size_t entry_count,
 				    cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_MAP, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_MAP;
-	node->loc = loc;
 	node->as.map.entries = entries;
 	node->as.map.entry_count = entry_count;
 
@@ -276,13 +383,11 @@ cel_ast_node_t *cel_ast_create_struct(const char *type_name,
 				       size_t field_count,
 				       cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_STRUCT, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_STRUCT;
-	node->loc = loc;
 	node->as.struct_lit.type_name = type_name;
 	node->as.struct_lit.type_name_length = type_name_length;
 	node->as.struct_lit.fields = fields;
@@ -302,13 +407,11 @@ cel_ast_node_t *cel_ast_create_comprehension(
 	cel_ast_node_t *result,
 	cel_token_location_t loc)
 {
-	cel_ast_node_t *node = malloc(sizeof(cel_ast_node_t));
+	cel_ast_node_t *node = cel_ast_create_node(CEL_AST_COMPREHENSION, loc);
 	if (!node) {
 		return NULL;
 	}
 
-	node->type = CEL_AST_COMPREHENSION;
-	node->loc = loc;
 	node->as.comprehension.iter_var = iter_var;
 	node->as.comprehension.iter_var_length = iter_var_length;
 	node->as.comprehension.iter_var2 = iter_var2;
@@ -324,11 +427,234 @@ cel_ast_node_t *cel_ast_create_comprehension(
 	return node;
 }
 
+/* ========== AST 复制函数 ========== */
+
+/**
+ * @brief 名称重定位 (原源代码区间 -> 新源代码)
+ */
+typedef struct {
+	uintptr_t from;   /* 原源代码起始地址 (0 表示不重定位) */
+	size_t length;    /* 原源代码长度 */
+	const char *to;   /* 新源代码 */
+} rebase_t;
+
+static cel_ast_node_t *copy_node(const cel_ast_node_t *node,
+				 const rebase_t *rebase);
+
+static const char *rebase_name(const char *name, const rebase_t *rebase)
+{
+	uintptr_t address = (uintptr_t)name;
+	if (name && rebase->from && address >= rebase->from &&
+	    address <= rebase->from + rebase->length) {
+		return rebase->to + (address - rebase->from);
+	}
+	return name;
+}
+
+/**
+ * @brief 复制子节点数组 (元素初始化为 NULL，失败时数组仍可被销毁)
+ */
+static bool copy_nodes(cel_ast_node_t ***copy, cel_ast_node_t *const *nodes,
+		       size_t count, const rebase_t *rebase)
+{
+	*copy = NULL;
+	if (count == 0) {
+		return true;
+	}
+
+	*copy = cel_ast_alloc(count * sizeof(cel_ast_node_t *));
+	if (!*copy) {
+		return false;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (!((*copy)[i] = copy_node(nodes[i], rebase))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief 复制可选子节点 (NULL 复制为 NULL)
+ */
+static bool copy_child(cel_ast_node_t **copy, const cel_ast_node_t *node,
+		       const rebase_t *rebase)
+{
+	*copy = node ? copy_node(node, rebase) : NULL;
+	return !node || *copy;
+}
+
+static cel_ast_node_t *copy_node(const cel_ast_node_t *node,
+				 const rebase_t *rebase)
+{
+	cel_ast_node_t *copy = cel_ast_create_node(node->type, node->loc);
+	if (!copy) {
+		return NULL;
+	}
+
+	/* 先浅复制，再逐个替换子节点 (替换前置空，失败时可直接销毁) */
+	if (node->type != CEL_AST_LITERAL) {
+		copy->as = node->as;
+	}
+	if (node->loc.source) {
+		copy->loc.source = rebase_name(node->loc.source, rebase);
+	}
+
+	bool ok = true;
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		copy->as.literal.value = cel_value_retain(&node->as.literal.value);
+		break;
+
+	case CEL_AST_IDENT:
+		copy->as.ident.name = rebase_name(node->as.ident.name, rebase);
+		break;
+
+	case CEL_AST_UNARY:
+		ok = copy_child(&copy->as.unary.operand, node->as.unary.operand,
+				rebase);
+		break;
+
+	case CEL_AST_BINARY:
+		copy->as.binary.right = NULL;
+		ok = copy_child(&copy->as.binary.left, node->as.binary.left,
+				rebase) &&
+		     copy_child(&copy->as.binary.right, node->as.binary.right,
+				rebase);
+		break;
+
+	case CEL_AST_TERNARY:
+		copy->as.ternary.if_true = NULL;
+		copy->as.ternary.if_false = NULL;
+		ok = copy_child(&copy->as.ternary.condition,
+				node->as.ternary.condition, rebase) &&
+		     copy_child(&copy->as.ternary.if_true,
+				node->as.ternary.if_true, rebase) &&
+		     copy_child(&copy->as.ternary.if_false,
+				node->as.ternary.if_false, rebase);
+		break;
+
+	case CEL_AST_SELECT:
+		copy->as.select.field = rebase_name(node->as.select.field, rebase);
+		ok = copy_child(&copy->as.select.operand, node->as.select.operand,
+				rebase);
+		break;
+
+	case CEL_AST_INDEX:
+		copy->as.index.index = NULL;
+		ok = copy_child(&copy->as.index.operand, node->as.index.operand,
+				rebase) &&
+		     copy_child(&copy->as.index.index, node->as.index.index,
+				rebase);
+		break;
+
+	case CEL_AST_CALL:
+		copy->as.call.function = rebase_name(node->as.call.function,
+						     rebase);
+		copy->as.call.args = NULL;
+		ok = copy_child(&copy->as.call.target, node->as.call.target,
+				rebase) &&
+		     copy_nodes(&copy->as.call.args, node->as.call.args,
+				node->as.call.arg_count, rebase);
+		if (!copy->as.call.args) {
+			copy->as.call.arg_count = 0;
+		}
+		break;
+
+	case CEL_AST_LIST:
+		ok = copy_nodes(&copy->as.list.elements, node->as.list.elements,
+				node->as.list.element_count, rebase);
+		if (!copy->as.list.elements) {
+			copy->as.list.element_count = 0;
+		}
+		break;
+
+	case CEL_AST_MAP: {
+		size_t count = node->as.map.entry_count;
+		copy->as.map.entries = count ?
+			cel_ast_alloc(count * sizeof(cel_ast_map_entry_t)) : NULL;
+		ok = !count || copy->as.map.entries;
+		for (size_t i = 0; ok && i < count; i++) {
+			ok = copy_child(&copy->as.map.entries[i].key,
+					node->as.map.entries[i].key, rebase) &&
+			     copy_child(&copy->as.map.entries[i].value,
+					node->as.map.entries[i].value, rebase);
+		}
+		if (!copy->as.map.entries) {
+			copy->as.map.entry_count = 0;
+		}
+		break;
+	}
+
+	case CEL_AST_STRUCT: {
+		size_t count = node->as.struct_lit.field_count;
+		copy->as.struct_lit.type_name =
+			rebase_name(node->as.struct_lit.type_name, rebase);
+		copy->as.struct_lit.fields = count ?
+			cel_ast_alloc(count * sizeof(cel_ast_struct_field_t)) :
+			NULL;
+		ok = !count || copy->as.struct_lit.fields;
+		for (size_t i = 0; ok && i < count; i++) {
+			copy->as.struct_lit.fields[i].name = rebase_name(
+				node->as.struct_lit.fields[i].name, rebase);
+			copy->as.struct_lit.fields[i].name_length =
+				node->as.struct_lit.fields[i].name_length;
+			ok = copy_child(&copy->as.struct_lit.fields[i].value,
+					node->as.struct_lit.fields[i].value,
+					rebase);
+		}
+		if (!copy->as.struct_lit.fields) {
+			copy->as.struct_lit.field_count = 0;
+		}
+		break;
+	}
+
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *comp = &node->as.comprehension;
+		cel_ast_comprehension_t *out = &copy->as.comprehension;
+		out->iter_var = rebase_name(comp->iter_var, rebase);
+		out->iter_var2 = rebase_name(comp->iter_var2, rebase);
+		out->accu_var = rebase_name(comp->accu_var, rebase);
+		out->accu_init = NULL;
+		out->loop_cond = NULL;
+		out->loop_step = NULL;
+		out->result = NULL;
+		ok = copy_child(&out->iter_range, comp->iter_range, rebase) &&
+		     copy_child(&out->accu_init, comp->accu_init, rebase) &&
+		     copy_child(&out->loop_cond, comp->loop_cond, rebase) &&
+		     copy_child(&out->loop_step, comp->loop_step, rebase) &&
+		     copy_child(&out->result, comp->result, rebase);
+		break;
+	}
+	}
+
+	if (!ok) {
+		cel_ast_destroy(copy);
+		return NULL;
+	}
+	return copy;
+}
+
+cel_ast_node_t *cel_ast_copy(const cel_ast_node_t *node, const char *source,
+			     size_t source_length, const char *new_source)
+{
+	if (!node) {
+		return NULL;
+	}
+
+	rebase_t rebase = {
+		.from = new_source ? (uintptr_t)source : 0,
+		.length = source_length,
+		.to = new_source,
+	};
+	return copy_node(node, &rebase);
+}
+
 /* ========== AST 销毁函数 ========== */
 
 void cel_ast_destroy(cel_ast_node_t *node)
 {
-	if (!node) {
+	if (!node || node->in_arena) {
 		return;
 	}
 
@@ -0,0 +1,883 @@
+/**
+ * @file cel_bytecode.c
+ * @brief CEL 字节码编译器实现
+ *
+ * 寄存器按栈方式分配: 每个子表达式使用当前最高的空闲寄存器，
+ * 子表达式编译完成后释放其临时寄存器。推导式变量通过编译期
+ * 作用域表解析为寄存器编号。
+ */
+
+#include "cel/cel_bytecode.h"
+#include "cel/cel_functions.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* 寄存器编号上限 (指令中寄存器字段为 16 位) */
+#define MAX_REGISTERS 65535
+
+/* ========== 编译器状态 ========== */
+
+/**
+ * @brief 编译期作用域条目 (推导式变量 -> 寄存器)
+ */
+typedef struct {
+	const char *name;  /* 变量名 */
+	size_t length;     /* 变量名长度 */
+	uint16_t reg;      /* 绑定的寄存器 */
+} scope_entry_t;
+
+/**
+ * @brief 编译器状态
+ */
+typedef struct {
+	cel_bytecode_t *bc;        /* 正在构建的字节码 */
+	size_t code_capacity;      /* 指令容量 */
+	size_t loc_capacity;       /* 源码位置表容量 */
+	cel_instr_loc_t loc;       /* 正在编译的表达式的源码位置 */
+	size_t constant_capacity;  /* 常量表容量 */
+	size_t name_capacity;      /* 变量名表容量 */
+	size_t call_capacity;      /* 调用点表容量 */
+	size_t regex_capacity;     /* 正则表达式表容量 */
+	size_t pattern_capacity;   /* 模式下标表容量 */
+
+	scope_entry_t *scopes;     /* 作用域栈 */
+	size_t scope_count;        /* 作用域条目数量 */
+	size_t scope_capacity;     /* 作用域容量 */
+
+	size_t next_reg;           /* 下一个空闲寄存器 */
+} compiler_t;
+
+static bool compile_expr(compiler_t *c, const cel_ast_node_t *node,
+			 uint16_t dst);
+
+/* ========== 表管理 ========== */
+
+/**
+ * @brief 确保动态数组容量
+ */
+static bool ensure_capacity(void **items, size_t *capacity, size_t needed,
+			    size_t item_size)
+{
+	if (needed <= *capacity) {
+		return true;
+	}
+
+	size_t new_capacity = *capacity ? *capacity * 2 : 8;
+	while (new_capacity < needed) {
+		new_capacity *= 2;
+	}
+
+	void *new_items = realloc(*items, new_capacity * item_size);
+	if (!new_items) {
+		return false;
+	}
+
+	*items = new_items;
+	*capacity = new_capacity;
+	return true;
+}
+
+/**
+ * @brief 追加指令，返回指令位置
+ */
+static bool emit(compiler_t *c, cel_opcode_e op, uint16_t dst, uint16_t a,
+		 uint16_t b, uint32_t imm, uint8_t flags, size_t *pos)
+{
+	cel_bytecode_t *bc = c->bc;
+	if (!ensure_capacity((void **)&bc->code, &c->code_capacity,
+			     bc->code_length + 1, sizeof(cel_instr_t)) ||
+	    !ensure_capacity((void **)&bc->locs, &c->loc_capacity,
+			     bc->code_length + 1, sizeof(cel_instr_loc_t))) {
+		return false;
+	}
+
+	cel_instr_t *instr = &bc->code[bc->code_length];
+	instr->op = (uint8_t)op;
+	instr->flags = flags;
+	instr->dst = dst;
+	instr->a = a;
+	instr->b = b;
+	instr->imm = imm;
+	bc->locs[bc->code_length] = c->loc;
+
+	if (pos) {
+		*pos = bc->code_length;
+	}
+	bc->code_length++;
+	return true;
+}
+
+/**
+ * @brief 回填跳转目标为当前位置
+ */
+static void patch_jump(compiler_t *c, size_t pos)
+{
+	c->bc->code[pos].imm = (uint32_t)c->bc->code_length;
+}
+
+/**
+ * @brief 添加常量 (常量表持有新引用)
+ */
+static bool add_constant(compiler_t *c, const cel_value_t *value,
+			 uint32_t *index)
+{
+	cel_bytecode_t *bc = c->bc;
+	if (!ensure_capacity((void **)&bc->constants, &c->constant_capacity,
+			     bc->constant_count + 1, sizeof(cel_value_t))) {
+		return false;
+	}
+
+	bc->constants[bc->constant_count] = cel_value_retain(value);
+	*index = (uint32_t)bc->constant_count++;
+	return true;
+}
+
+/**
+ * @brief 复制名称为 null 结尾的字符串
+ */
+static char *copy_name(const char *name, size_t length)
+{
+	char *copy = malloc(length + 1);
+	if (copy) {
+		memcpy(copy, name, length);
+		copy[length] = '\0';
+	}
+	return copy;
+}
+
+/**
+ * @brief 添加变量名 (相同名称复用同一条目)
+ */
+static bool add_name(compiler_t *c, const char *name, size_t length,
+		     uint32_t *index)
+{
+	cel_bytecode_t *bc = c->bc;
+	for (size_t i = 0; i < bc->name_count; i++) {
+		if (strlen(bc->names[i]) == length &&
+		    memcmp(bc->names[i], name, length) == 0) {
+			*index = (uint32_t)i;
+			return true;
+		}
+	}
+
+	if (!ensure_capacity((void **)&bc->names, &c->name_capacity,
+			     bc->name_count + 1, sizeof(char *))) {
+		return false;
+	}
+
+	char *copy = copy_name(name, length);
+	if (!copy) {
+		return false;
+	}
+
+	bc->names[bc->name_count] = copy;
+	*index = (uint32_t)bc->name_count++;
+	return true;
+}
+
+/**
+ * @brief 添加函数调用点
+ */
+static bool add_call_site(compiler_t *c, const cel_ast_call_t *call,
+			  uint32_t *index)
+{
+	cel_bytecode_t *bc = c->bc;
+	if (!ensure_capacity((void **)&bc->calls, &c->call_capacity,
+			     bc->call_count + 1, sizeof(cel_call_site_t))) {
+		return false;
+	}
+
+	char *name = copy_name(call->function, call->function_length);
+	if (!name) {
+		return false;
+	}
+
+	cel_call_site_t *site = &bc->calls[bc->call_count];
+	site->name = name;
+	site->name_length = call->function_length;
+	site->has_target = call->target != NULL;
+
+	*index = (uint32_t)bc->call_count++;
+	return true;
+}
+
+/**
+ * @brief 添加预编译的正则表达式 (接管 regex 的引用，失败时释放)
+ *
+ * 模式本身加入常量表，序列化的字节码在加载时据此重新编译。
+ */
+static bool add_regex(compiler_t *c, cel_regex_t *regex,
+		      const cel_value_t *pattern, uint32_t *index)
+{
+	cel_bytecode_t *bc = c->bc;
+	uint32_t constant;
+	if (!ensure_capacity((void **)&bc->regexes, &c->regex_capacity,
+			     bc->regex_count + 1, sizeof(cel_regex_t *)) ||
+	    !ensure_capacity((void **)&bc->patterns, &c->pattern_capacity,
+			     bc->regex_count + 1, sizeof(uint32_t)) ||
+	    !add_constant(c, pattern, &constant)) {
+		cel_regex_release(regex);
+		return false;
+	}
+
+	bc->regexes[bc->regex_count] = regex;
+	bc->patterns[bc->regex_count] = constant;
+	*index = (uint32_t)bc->regex_count++;
+	return true;
+}
+
+/* ========== 寄存器与作用域 ========== */
+
+/**
+ * @brief 分配 count 个连续的临时寄存器
+ */
+static bool alloc_regs(compiler_t *c, size_t count, uint16_t *first)
+{
+	if (c->next_reg + count > MAX_REGISTERS) {
+		return false;
+	}
+
+	*first = (uint16_t)c->next_reg;
+	c->next_reg += count;
+	if (c->next_reg > c->bc->register_count) {
+		c->bc->register_count = c->next_reg;
+	}
+	return true;
+}
+
+static bool push_scope(compiler_t *c, const char *name, size_t length,
+		       uint16_t reg)
+{
+	if (!ensure_capacity((void **)&c->scopes, &c->scope_capacity,
+			     c->scope_count + 1, sizeof(scope_entry_t))) {
+		return false;
+	}
+
+	c->scopes[c->scope_count].name = name;
+	c->scopes[c->scope_count].length = length;
+	c->scopes[c->scope_count].reg = reg;
+	c->scope_count++;
+	return true;
+}
+
+/**
+ * @brief 查找推导式变量绑定的寄存器 (内层优先)
+ */
+static bool lookup_scope(const compiler_t *c, const char *name, size_t length,
+			 uint16_t *reg)
+{
+	for (size_t i = c->scope_count; i > 0; i--) {
+		const scope_entry_t *entry = &c->scopes[i - 1];
+		if (entry->length == length &&
+		    memcmp(entry->name, name, length) == 0) {
+			*reg = entry->reg;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief 编译操作数，返回保存结果的寄存器
+ *
+ * 推导式变量直接使用其绑定的寄存器，避免多余的 MOVE。
+ */
+static bool compile_operand(compiler_t *c, const cel_ast_node_t *node,
+			    uint16_t *reg)
+{
+	if (node && node->type == CEL_AST_IDENT &&
+	    lookup_scope(c, node->as.ident.name, node->as.ident.length, reg)) {
+		return true;
+	}
+
+	return alloc_regs(c, 1, reg) && compile_expr(c, node, *reg);
+}
+
+/* ========== 节点编译 ========== */
+
+/**
+ * @brief 编译标识符
+ *
+ * 解析顺序: 推导式变量 (寄存器) > schema 槽位 > 上下文变量 (按名称)。
+ */
+static bool compile_ident(compiler_t *c, const cel_ast_ident_t *ident,
+			  uint16_t dst)
+{
+	uint16_t reg;
+	uint32_t index;
+	size_t slot;
+
+	if (lookup_scope(c, ident->name, ident->length, &reg)) {
+		return emit(c, CEL_OP_MOVE, dst, reg, 0, 0, 0, NULL);
+	}
+
+	if (!add_name(c, ident->name, ident->length, &index)) {
+		return false;
+	}
+
+	/* 槽位指令的 a 字段保存名称索引，供未设置槽位时回退查找 */
+	if (cel_schema_find(c->bc->schema, ident->name, ident->length, &slot) &&
+	    index <= UINT16_MAX && slot <= UINT32_MAX) {
+		return emit(c, CEL_OP_LOAD_SLOT, dst, (uint16_t)index, 0,
+			    (uint32_t)slot, 0, NULL);
+	}
+
+	return emit(c, CEL_OP_LOAD_VAR, dst, 0, 0, index, 0, NULL);
+}
+
+static cel_opcode_e binary_opcode(cel_binary_op_e op)
+{
+	switch (op) {
+	case CEL_BINARY_ADD:
+		return CEL_OP_ADD;
+	case CEL_BINARY_SUB:
+		return CEL_OP_SUB;
+	case CEL_BINARY_MUL:
+		return CEL_OP_MUL;
+	case CEL_BINARY_DIV:
+		return CEL_OP_DIV;
+	case CEL_BINARY_MOD:
+		return CEL_OP_MOD;
+	case CEL_BINARY_EQ:
+		return CEL_OP_EQ;
+	case CEL_BINARY_NE:
+		return CEL_OP_NE;
+	case CEL_BINARY_LT:
+		return CEL_OP_LT;
+	case CEL_BINARY_LE:
+		return CEL_OP_LE;
+	case CEL_BINARY_GT:
+		return CEL_OP_GT;
+	case CEL_BINARY_GE:
+		return CEL_OP_GE;
+	default:
+		return CEL_OP_IN;
+	}
+}
+
+static bool compile_binary(compiler_t *c, const cel_ast_binary_t *binary,
+			   uint16_t dst)
+{
+	/* 短路求值: 左操作数写入 dst，满足短路条件时直接跳过右操作数 */
+	if (binary->op == CEL_BINARY_AND || binary->op == CEL_BINARY_OR) {
+		cel_opcode_e jump = binary->op == CEL_BINARY_AND ?
+					    CEL_OP_JUMP_IF_FALSE :
+					    CEL_OP_JUMP_IF_TRUE;
+		size_t end;
+
+		if (!compile_expr(c, binary->left, dst) ||
+		    !emit(c, jump, 0, dst, 0, 0, CEL_BOOL_CHECK_LOGICAL, &end) ||
+		    !compile_expr(c, binary->right, dst) ||
+		    !emit(c, CEL_OP_CHECK_BOOL, 0, dst, 0, 0,
+			  CEL_BOOL_CHECK_LOGICAL, NULL)) {
+			return false;
+		}
+
+		patch_jump(c, end);
+		return true;
+	}
+
+	size_t saved = c->next_reg;
+	uint16_t left, right;
+	if (!compile_operand(c, binary->left, &left) ||
+	    !compile_operand(c, binary->right, &right)) {
+		return false;
+	}
+	c->next_reg = saved;
+
+	return emit(c, binary_opcode(binary->op), dst, left, right, 0, 0, NULL);
+}
+
+static bool compile_ternary(compiler_t *c, const cel_ast_ternary_t *ternary,
+			    uint16_t dst)
+{
+	size_t saved = c->next_reg;
+	uint16_t cond;
+	size_t else_pos, end_pos;
+
+	if (!compile_operand(c, ternary->condition, &cond)) {
+		return false;
+	}
+	c->next_reg = saved;
+
+	if (!emit(c, CEL_OP_JUMP_IF_FALSE, 0, cond, 0, 0,
+		  CEL_BOOL_CHECK_TERNARY, &else_pos) ||
+	    !compile_expr(c, ternary->if_true, dst) ||
+	    !emit(c, CEL_OP_JUMP, 0, 0, 0, 0, 0, &end_pos)) {
+		return false;
+	}
+
+	patch_jump(c, else_pos);
+	if (!compile_expr(c, ternary->if_false, dst)) {
+		return false;
+	}
+	patch_jump(c, end_pos);
+	return true;
+}
+
+/**
+ * @brief 编译模式为字符串字面量的 matches() 调用
+ *
+ * 模式在编译期编译一次，执行时直接匹配。
+ *
+ * @param handled 输出是否已生成指令 (模式不是字面量或编译失败时为
+ *                false，由调用者按普通内置函数调用处理，使执行时
+ *                报告相同的错误)
+ */
+static bool compile_literal_match(compiler_t *c, const cel_ast_call_t *call,
+				  uint16_t dst, bool *handled)
+{
+	const cel_ast_node_t *subject = call->target ? call->target
+						     : call->args[0];
+	const cel_ast_node_t *pattern = call->args[call->target ? 0 : 1];
+
+	*handled = false;
+	if (pattern->type != CEL_AST_LITERAL ||
+	    pattern->as.literal.value.type != CEL_TYPE_STRING) {
+		return true;
+	}
+
+	const cel_value_t *value = &pattern->as.literal.value;
+	cel_regex_t *regex = cel_regex_compile(value->value.string_value->data,
+					       cel_string_length(value), NULL, 0);
+	if (!regex) {
+		return true;
+	}
+
+	/* 模式长度用于执行时计算调用代价 */
+	size_t length = cel_string_length(value);
+	uint16_t pattern_length = length > UINT16_MAX ? UINT16_MAX :
+							(uint16_t)length;
+
+	*handled = true;
+	size_t saved = c->next_reg;
+	uint32_t index;
+	uint16_t a;
+	bool ok = add_regex(c, regex, value, &index) &&
+		  compile_operand(c, subject, &a);
+	c->next_reg = saved;
+	return ok && emit(c, CEL_OP_MATCH, dst, a, pattern_length, index, 0,
+			  NULL);
+}
+
+static bool compile_call(compiler_t *c, const cel_ast_call_t *call,
+			 uint16_t dst)
+{
+	size_t saved = c->next_reg;
+	size_t arg_count = call->arg_count + (call->target ? 1 : 0);
+	uint16_t first = 0;
+	uint32_t site;
+
+	/* 内置函数在编译期解析为重载编号 */
+	cel_function_id_e id;
+	bool builtin = cel_builtin_resolve(call->function, call->function_length,
+					   call->target != NULL, arg_count, &id);
+	if (builtin && id == CEL_FUNC_MATCHES) {
+		bool handled;
+		bool ok = compile_literal_match(c, call, dst, &handled);
+		if (handled || !ok) {
+			return ok;
+		}
+	}
+
+	/* 接收者与参数放入连续寄存器 */
+	if (arg_count > 0 && !alloc_regs(c, arg_count, &first)) {
+		return false;
+	}
+
+	size_t slot = first;
+	if (call->target && !compile_expr(c, call->target, (uint16_t)slot++)) {
+		return false;
+	}
+	for (size_t i = 0; i < call->arg_count; i++) {
+		if (!compile_expr(c, call->args[i], (uint16_t)slot++)) {
+			return false;
+		}
+	}
+	c->next_reg = saved;
+
+	if (arg_count > UINT16_MAX) {
+		return false;
+	}
+
+	if (builtin) {
+		return emit(c, CEL_OP_CALL_BUILTIN, dst, first,
+			    (uint16_t)arg_count, (uint32_t)id, 0, NULL);
+	}
+
+	return add_call_site(c, call, &site) &&
+	       emit(c, CEL_OP_CALL, dst, first, (uint16_t)arg_count, site, 0,
+		    NULL);
+}
+
+static bool compile_list(compiler_t *c, const cel_ast_list_t *list,
+			 uint16_t dst)
+{
+	size_t saved = c->next_reg;
+	uint16_t first = 0;
+
+	if (list->element_count > 0 &&
+	    !alloc_regs(c, list->element_count, &first)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < list->element_count; i++) {
+		if (!compile_expr(c, list->elements[i], (uint16_t)(first + i))) {
+			return false;
+		}
+	}
+	c->next_reg = saved;
+
+	return emit(c, CEL_OP_LIST, dst, first, 0,
+		    (uint32_t)list->element_count, 0, NULL);
+}
+
+static bool compile_map(compiler_t *c, const cel_ast_map_t *map, uint16_t dst)
+{
+	size_t saved = c->next_reg;
+	uint16_t first = 0;
+
+	if (map->entry_count > 0 &&
+	    !alloc_regs(c, map->entry_count * 2, &first)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < map->entry_count; i++) {
+		if (!compile_expr(c, map->entries[i].key,
+				  (uint16_t)(first + 2 * i)) ||
+		    !compile_expr(c, map->entries[i].value,
+				  (uint16_t)(first + 2 * i + 1))) {
+			return false;
+		}
+	}
+	c->next_reg = saved;
+
+	return emit(c, CEL_OP_MAP, dst, first, 0, (uint32_t)map->entry_count,
+		    0, NULL);
+}
+
+/**
+ * @brief 编译推导式
+ *
+ * 生成的代码结构:
+ *       R[range] = iter_range
+ *       ITER_INIT R[cursor], R[range]
+ *       R[accu] = accu_init
+ *   loop:
+ *       ITER_NEXT R[iter], R[range], R[cursor] -> exit
+ *       (双变量形式时 R[iter + 1] 为第二个循环变量)
+ *       R[t] = loop_cond
+ *       JUMP_IF_FALSE R[t] -> exit
+ *       R[t] = loop_step
+ *       MOVE R[accu], R[t]
+ *       JUMP loop
+ *   exit:
+ *       R[dst] = result
+ */
+/**
+ * @brief 检查节点是否为绑定到 reg 的推导式变量
+ */
+static bool is_scope_reg(const compiler_t *c, const cel_ast_node_t *node,
+			 uint16_t reg)
+{
+	uint16_t bound;
+	return node && node->type == CEL_AST_IDENT &&
+	       lookup_scope(c, node->as.ident.name, node->as.ident.length,
+			    &bound) &&
+	       bound == reg;
+}
+
+/**
+ * @brief 编译追加形式的循环步骤 ([G ?] @result + [E] [: @result])
+ *
+ * map / filter 宏展开的形式编译为 APPEND 指令，累加器原地追加，
+ * 不再每次迭代复制整个列表。
+ *
+ * @param handled 输出循环步骤是否为追加形式 (否则未生成指令)
+ */
+static bool compile_append(compiler_t *c, const cel_ast_node_t *step,
+			   uint16_t accu, bool *handled)
+{
+	const cel_ast_node_t *guard = NULL;
+	size_t saved = c->next_reg;
+	size_t skip_pos = 0;
+	uint16_t reg;
+
+	*handled = false;
+	if (step && step->type == CEL_AST_TERNARY &&
+	    is_scope_reg(c, step->as.ternary.if_false, accu)) {
+		guard = step->as.ternary.condition;
+		step = step->as.ternary.if_true;
+	}
+	if (!step || step->type != CEL_AST_BINARY ||
+	    step->as.binary.op != CEL_BINARY_ADD ||
+	    !is_scope_reg(c, step->as.binary.left, accu) ||
+	    step->as.binary.right->type != CEL_AST_LIST ||
+	    step->as.binary.right->as.list.element_count != 1 ||
+	    is_scope_reg(c, step->as.binary.right->as.list.elements[0], accu)) {
+		/* 追加累加器自身时元素与累加器是同一寄存器，按普通步骤编译 */
+		return true;
+	}
+	*handled = true;
+
+	if (guard) {
+		if (!compile_operand(c, guard, &reg) ||
+		    !emit(c, CEL_OP_JUMP_IF_FALSE, 0, reg, 0, 0,
+			  CEL_BOOL_CHECK_TERNARY, &skip_pos)) {
+			return false;
+		}
+		c->next_reg = saved;
+	}
+
+	if (!compile_operand(c, step->as.binary.right->as.list.elements[0],
+			     &reg) ||
+	    !emit(c, CEL_OP_APPEND, accu, reg, 0, 0, 0, NULL)) {
+		return false;
+	}
+	c->next_reg = saved;
+
+	if (guard) {
+		patch_jump(c, skip_pos);
+	}
+	return true;
+}
+
+static bool compile_comprehension(compiler_t *c,
+				  const cel_ast_comprehension_t *comp,
+				  uint16_t dst)
+{
+	size_t saved = c->next_reg;
+	size_t saved_scope = c->scope_count;
+	uint16_t range, cursor, accu, iter, value;
+	size_t loop_pos, next_pos, cond_pos;
+	bool pair = comp->iter_var2 != NULL;
+
+	if (!alloc_regs(c, 1, &range) ||
+	    !compile_expr(c, comp->iter_range, range) ||
+	    !alloc_regs(c, 2, &cursor) ||
+	    !emit(c, CEL_OP_ITER_INIT, cursor, range, 0, 0, 0, NULL) ||
+	    !alloc_regs(c, 1, &accu) ||
+	    !compile_expr(c, comp->accu_init, accu) ||
+	    !alloc_regs(c, pair ? 2 : 1, &iter)) {
+		return false;
+	}
+
+	/* 累加器在循环体与结果表达式中可见 */
+	if (!push_scope(c, comp->accu_var, comp->accu_var_length, accu)) {
+		return false;
+	}
+
+	loop_pos = c->bc->code_length;
+	if (!emit(c, CEL_OP_ITER_NEXT, iter, range, cursor, 0,
+		  pair ? CEL_ITER_PAIR : 0, &next_pos)) {
+		return false;
+	}
+
+	/* 循环变量仅在循环条件与循环步骤中可见 */
+	if (!push_scope(c, comp->iter_var, comp->iter_var_length, iter) ||
+	    (pair && !push_scope(c, comp->iter_var2, comp->iter_var2_length,
+				 (uint16_t)(iter + 1)))) {
+		return false;
+	}
+
+	size_t body_reg = c->next_reg;
+	if (!compile_operand(c, comp->loop_cond, &value) ||
+	    !emit(c, CEL_OP_JUMP_IF_FALSE, 0, value, 0, 0,
+		  CEL_BOOL_CHECK_LOOP, &cond_pos)) {
+		return false;
+	}
+	c->next_reg = body_reg;
+
+	bool appended;
+	if (!compile_append(c, comp->loop_step, accu, &appended)) {
+		return false;
+	}
+	if (!appended) {
+		if (!compile_operand(c, comp->loop_step, &value)) {
+			return false;
+		}
+		c->next_reg = body_reg;
+
+		if (value != accu &&
+		    !emit(c, CEL_OP_MOVE, accu, value, 0, 0, 0, NULL)) {
+			return false;
+		}
+	}
+	if (!emit(c, CEL_OP_JUMP, 0, 0, 0, (uint32_t)loop_pos, 0, NULL)) {
+		return false;
+	}
+
+	c->scope_count -= pair ? 2 : 1;
+	patch_jump(c, next_pos);
+	patch_jump(c, cond_pos);
+
+	bool ok;
+	if (comp->result) {
+		ok = compile_expr(c, comp->result, dst);
+	} else {
+		ok = emit(c, CEL_OP_MOVE, dst, accu, 0, 0, 0, NULL);
+	}
+
+	c->scope_count = saved_scope;
+	c->next_reg = saved;
+	return ok;
+}
+
+static bool compile_node(compiler_t *c, const cel_ast_node_t *node,
+			 uint16_t dst)
+{
+	if (!node) {
+		return false;
+	}
+
+	size_t saved = c->next_reg;
+	uint32_t index;
+	uint16_t a, b;
+	bool ok;
+
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		return add_constant(c, &node->as.literal.value, &index) &&
+		       emit(c, CEL_OP_LOAD_CONST, dst, 0, 0, index, 0, NULL);
+
+	case CEL_AST_IDENT:
+		return compile_ident(c, &node->as.ident, dst);
+
+	case CEL_AST_UNARY:
+		ok = compile_operand(c, node->as.unary.operand, &a);
+		c->next_reg = saved;
+		return ok && emit(c, node->as.unary.op == CEL_UNARY_NEG ?
+					     CEL_OP_NEG : CEL_OP_NOT,
+				  dst, a, 0, 0, 0, NULL);
+
+	case CEL_AST_BINARY:
+		return compile_binary(c, &node->as.binary, dst);
+
+	case CEL_AST_TERNARY:
+		return compile_ternary(c, &node->as.ternary, dst);
+
+	case CEL_AST_SELECT: {
+		const cel_ast_select_t *select = &node->as.select;
+		cel_value_t field = cel_value_string_n(select->field,
+						       select->field_length);
+		ok = field.type == CEL_TYPE_STRING &&
+		     add_constant(c, &field, &index);
+		cel_value_destroy(&field);
+
+		ok = ok && compile_operand(c, select->operand, &a);
+		c->next_reg = saved;
+		return ok && emit(c, CEL_OP_SELECT, dst, a, 0, index,
+				  select->optional ? CEL_INSTR_OPTIONAL : 0,
+				  NULL);
+	}
+
+	case CEL_AST_INDEX:
+		ok = compile_operand(c, node->as.index.operand, &a) &&
+		     compile_operand(c, node->as.index.index, &b);
+		c->next_reg = saved;
+		return ok && emit(c, CEL_OP_INDEX, dst, a, b, 0,
+				  node->as.index.optional ?
+					  CEL_INSTR_OPTIONAL : 0,
+				  NULL);
+
+	case CEL_AST_CALL:
+		return compile_call(c, &node->as.call, dst);
+
+	case CEL_AST_LIST:
+		return compile_list(c, &node->as.list, dst);
+
+	case CEL_AST_MAP:
+		return compile_map(c, &node->as.map, dst);
+
+	case CEL_AST_COMPREHENSION:
+		return compile_comprehension(c, &node->as.comprehension, dst);
+
+	case CEL_AST_STRUCT:
+	default:
+		/* 不支持的节点，由调用者回退到树遍历求值 */
+		return false;
+	}
+}
+
+static bool compile_expr(compiler_t *c, const cel_ast_node_t *node,
+			 uint16_t dst)
+{
+	/* 指令记录产生它的最内层表达式的位置，宏展开的合成节点沿用外层位置 */
+	cel_instr_loc_t saved = c->loc;
+	if (node && node->loc.line) {
+		c->loc.line = (uint32_t)node->loc.line;
+		c->loc.column = (uint32_t)node->loc.column;
+	}
+
+	bool ok = compile_node(c, node, dst);
+	c->loc = saved;
+	return ok;
+}
+
+/* ========== 编译 API ========== */
+
+cel_bytecode_t *cel_bytecode_compile(const cel_ast_node_t *ast,
+				     const cel_schema_t *schema)
+{
+	if (!ast) {
+		return NULL;
+	}
+
+	cel_bytecode_t *bc = calloc(1, sizeof(cel_bytecode_t));
+	if (!bc) {
+		return NULL;
+	}
+
+	bc->schema = schema;
+
+	compiler_t c;
+	memset(&c, 0, sizeof(c));
+	c.bc = bc;
+
+	uint16_t result;
+	bool ok = alloc_regs(&c, 1, &result) &&
+		  compile_expr(&c, ast, result) &&
+		  emit(&c, CEL_OP_RETURN, 0, result, 0, 0, 0, NULL);
+
+	free(c.scopes);
+
+	if (!ok) {
+		cel_bytecode_destroy(bc);
+		return NULL;
+	}
+
+	return bc;
+}
+
+void cel_bytecode_destroy(cel_bytecode_t *bytecode)
+{
+	if (!bytecode) {
+		return;
+	}
+
+	for (size_t i = 0; i < bytecode->constant_count; i++) {
+		cel_value_destroy(&bytecode->constants[i]);
+	}
+	free(bytecode->constants);
+
+	/* 借用的名称、指令与源码位置由外部持有，只释放指针表 */
+	if (!bytecode->borrowed) {
+		for (size_t i = 0; i < bytecode->name_count; i++) {
+			free(bytecode->names[i]);
+		}
+		for (size_t i = 0; i < bytecode->call_count; i++) {
+			free(bytecode->calls[i].name);
+		}
+		free(bytecode->code);
+		free(bytecode->locs);
+	}
+	free(bytecode->names);
+	free(bytecode->calls);
+
+	for (size_t i = 0; i < bytecode->regex_count; i++) {
+		cel_regex_release(bytecode->regexes[i]);
+	}
+	free(bytecode->regexes);
+	free(bytecode->patterns);
+	free(bytecode);
+}
@@ -0,0 +1,947 @@
+/**
+ * @file cel_columnar.c
+ * @brief CEL 列式 (向量化) 执行实现
+ *
+ * AST 按后序展开为向量节点数组，执行时每次处理 COLUMNAR_CHUNK 行:
+ * 依次计算每个节点的结果向量，向量类型在每段开始时由操作数类型
+ * 决定 (与逐行求值的类型规则一致)。列节点直接引用输入数据，
+ * 常量节点在执行开始时广播一次。
+ */
+
+#include "cel/cel_columnar.h"
+#include "cel/cel_eval.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COLUMNAR_SIMD_LEVEL "avx2"
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define COLUMNAR_SIMD_LEVEL "sse4.2"
+#else
+#define COLUMNAR_SIMD_LEVEL "scalar"
+#endif
+
+/* 每段处理的行数 */
+#define COLUMNAR_CHUNK 1024
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 向量节点类型
+ */
+typedef enum {
+	VNODE_COLUMN,      /* 输入列 */
+	VNODE_CONST,       /* 常量 (广播) */
+	VNODE_UNARY,       /* 一元运算 */
+	VNODE_BINARY,      /* 二元运算 */
+	VNODE_ROW,         /* 逐行求值的子表达式 */
+} vnode_kind_e;
+
+/**
+ * @brief 向量节点
+ */
+typedef struct {
+	vnode_kind_e kind;           /* 节点类型 */
+	cel_unary_op_e unary;        /* 一元运算符 (VNODE_UNARY) */
+	cel_binary_op_e binary;      /* 二元运算符 (VNODE_BINARY) */
+	size_t a, b;                 /* 操作数节点编号 */
+	size_t slot;                 /* 列槽位 (VNODE_COLUMN) */
+	cel_value_t constant;        /* 常量值 (VNODE_CONST) */
+	cel_bytecode_t *bytecode;    /* 子表达式字节码 (VNODE_ROW) */
+} vnode_t;
+
+/**
+ * @brief 列式执行计划
+ */
+struct cel_columnar_program {
+	const cel_program_t *program;  /* 源程序 (不持有) */
+	size_t column_count;           /* 列数量 (schema 大小) */
+	vnode_t *nodes;                /* 向量节点 (后序，最后一个为根) */
+	size_t node_count;             /* 节点数量 */
+	size_t node_capacity;          /* 节点容量 */
+	bool vectorized;               /* 是否不含逐行节点 */
+};
+
+/**
+ * @brief 一段行的结果向量
+ */
+typedef struct {
+	cel_type_e type;             /* CEL_TYPE_INT / DOUBLE / BOOL */
+	const void *data;            /* 向量数据 */
+} vector_t;
+
+/**
+ * @brief 一次执行的状态
+ */
+typedef struct {
+	const cel_columnar_program_t *columnar;
+	cel_context_t *ctx;
+	const cel_column_t *columns;
+	cel_activation_t *activation;  /* 逐行求值使用 (按需创建) */
+	cel_vm_frame_t frame;          /* 逐行求值的寄存器文件 */
+	unsigned char *scratch;        /* 每个节点一段结果缓冲区 */
+	double *convert[2];            /* int -> double 转换缓冲区 */
+	vector_t *vectors;             /* 当前段各节点的结果向量 */
+} exec_t;
+
+/* ========== 计划构建 ========== */
+
+/**
+ * @brief 计划构建结果
+ */
+typedef enum {
+	PLAN_OK,           /* 生成了向量节点 */
+	PLAN_UNSUPPORTED,  /* 无法表示为向量 (由父节点整体逐行求值) */
+	PLAN_ERROR,        /* 内存不足或编译失败 */
+} plan_result_e;
+
+static plan_result_e plan_node(cel_columnar_program_t *cp,
+			       const cel_ast_node_t *node, size_t *index);
+
+static bool add_node(cel_columnar_program_t *cp, const vnode_t *node,
+		     size_t *index)
+{
+	if (cp->node_count == cp->node_capacity) {
+		size_t new_capacity = cp->node_capacity ? cp->node_capacity * 2 : 8;
+		vnode_t *new_nodes = realloc(cp->nodes,
+					     new_capacity * sizeof(vnode_t));
+		if (!new_nodes) {
+			return false;
+		}
+		cp->nodes = new_nodes;
+		cp->node_capacity = new_capacity;
+	}
+
+	cp->nodes[cp->node_count] = *node;
+	*index = cp->node_count++;
+	return true;
+}
+
+/**
+ * @brief 删除 mark 之后的节点 (父节点改为逐行求值时丢弃子节点)
+ */
+static void truncate_nodes(cel_columnar_program_t *cp, size_t mark)
+{
+	while (cp->node_count > mark) {
+		cel_bytecode_destroy(cp->nodes[--cp->node_count].bytecode);
+	}
+}
+
+/**
+ * @brief 将子表达式编译为逐行求值节点
+ */
+static plan_result_e plan_row(cel_columnar_program_t *cp,
+			      const cel_ast_node_t *node, size_t *index)
+{
+	vnode_t row = {.kind = VNODE_ROW, .constant = cel_value_null()};
+	row.bytecode = cel_bytecode_compile(node, cp->program->schema);
+	if (!row.bytecode) {
+		return PLAN_ERROR;
+	}
+	if (!add_node(cp, &row, index)) {
+		cel_bytecode_destroy(row.bytecode);
+		return PLAN_ERROR;
+	}
+
+	cp->vectorized = false;
+	return PLAN_OK;
+}
+
+static bool is_vector_binary(cel_binary_op_e op)
+{
+	return op != CEL_BINARY_IN;
+}
+
+static plan_result_e plan_node(cel_columnar_program_t *cp,
+			       const cel_ast_node_t *node, size_t *index)
+{
+	vnode_t vnode = {.constant = cel_value_null()};
+	size_t mark = cp->node_count;
+	plan_result_e result = PLAN_OK;
+
+	switch (node->type) {
+	case CEL_AST_LITERAL: {
+		cel_type_e type = node->as.literal.value.type;
+		if (type != CEL_TYPE_INT && type != CEL_TYPE_DOUBLE &&
+		    type != CEL_TYPE_BOOL) {
+			return PLAN_UNSUPPORTED;
+		}
+		vnode.kind = VNODE_CONST;
+		vnode.constant = node->as.literal.value;
+		return add_node(cp, &vnode, index) ? PLAN_OK : PLAN_ERROR;
+	}
+
+	case CEL_AST_IDENT:
+		/* 未声明的变量类型未知，由父节点逐行求值 */
+		if (!cel_schema_find(cp->program->schema, node->as.ident.name,
+				     node->as.ident.length, &vnode.slot)) {
+			return PLAN_UNSUPPORTED;
+		}
+		vnode.kind = VNODE_COLUMN;
+		return add_node(cp, &vnode, index) ? PLAN_OK : PLAN_ERROR;
+
+	case CEL_AST_UNARY:
+		vnode.kind = VNODE_UNARY;
+		vnode.unary = node->as.unary.op;
+		result = plan_node(cp, node->as.unary.operand, &vnode.a);
+		break;
+
+	case CEL_AST_BINARY:
+		vnode.kind = VNODE_BINARY;
+		vnode.binary = node->as.binary.op;
+		if (!is_vector_binary(vnode.binary)) {
+			result = PLAN_UNSUPPORTED;
+			break;
+		}
+		result = plan_node(cp, node->as.binary.left, &vnode.a);
+		if (result == PLAN_OK) {
+			result = plan_node(cp, node->as.binary.right, &vnode.b);
+		}
+		break;
+
+	default:
+		result = PLAN_UNSUPPORTED;
+		break;
+	}
+
+	if (result == PLAN_ERROR) {
+		return PLAN_ERROR;
+	}
+	if (result == PLAN_UNSUPPORTED) {
+		truncate_nodes(cp, mark);
+		return plan_row(cp, node, index);
+	}
+
+	return add_node(cp, &vnode, index) ? PLAN_OK : PLAN_ERROR;
+}
+
+/* ========== 计划 API ========== */
+
+cel_columnar_program_t *cel_columnar_compile(const cel_program_t *program)
+{
+	if (!program || !program->ast || !program->schema) {
+		return NULL;
+	}
+
+	cel_columnar_program_t *cp = calloc(1, sizeof(cel_columnar_program_t));
+	if (!cp) {
+		return NULL;
+	}
+
+	cp->program = program;
+	cp->column_count = cel_schema_size(program->schema);
+	cp->vectorized = true;
+
+	size_t root;
+	if (plan_node(cp, program->ast, &root) == PLAN_ERROR) {
+		cel_columnar_destroy(cp);
+		return NULL;
+	}
+
+	return cp;
+}
+
+void cel_columnar_destroy(cel_columnar_program_t *columnar)
+{
+	if (!columnar) {
+		return;
+	}
+
+	/* 常量值由 AST 持有，这里只释放字节码 */
+	for (size_t i = 0; i < columnar->node_count; i++) {
+		cel_bytecode_destroy(columnar->nodes[i].bytecode);
+	}
+	free(columnar->nodes);
+	free(columnar);
+}
+
+bool cel_columnar_is_vectorized(const cel_columnar_program_t *columnar)
+{
+	return columnar && columnar->vectorized;
+}
+
+const char *cel_columnar_simd_level(void)
+{
+	return COLUMNAR_SIMD_LEVEL;
+}
+
+/* ========== SIMD 内核 ========== */
+
+/*
+ * 比较内核: AVX2 / SSE4.2 每次比较 4 / 2 个元素，比较掩码展开为 bool
+ * 字节后写出，剩余元素 (以及未启用 SIMD 时的全部元素) 由标量循环处理。
+ * 运算符分派在循环外完成，标量循环可以被编译器自动向量化。算术与逻辑
+ * 内核同样是无分支的简单循环。
+ */
+
+/* 标量比较循环 (从第 i 个元素开始) */
+#define SCALAR_COMPARE(op, l, r, out, i, n)                              \
+	do {                                                             \
+		switch (op) {                                            \
+		case CEL_BINARY_EQ:                                      \
+			for (; i < n; i++) out[i] = l[i] == r[i];        \
+			break;                                           \
+		case CEL_BINARY_NE:                                      \
+			for (; i < n; i++) out[i] = l[i] != r[i];        \
+			break;                                           \
+		case CEL_BINARY_LT:                                      \
+			for (; i < n; i++) out[i] = l[i] < r[i];         \
+			break;                                           \
+		case CEL_BINARY_LE:                                      \
+			for (; i < n; i++) out[i] = l[i] <= r[i];        \
+			break;                                           \
+		case CEL_BINARY_GT:                                      \
+			for (; i < n; i++) out[i] = l[i] > r[i];         \
+			break;                                           \
+		default:                                                 \
+			for (; i < n; i++) out[i] = l[i] >= r[i];        \
+			break;                                           \
+		}                                                        \
+	} while (0)
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+/**
+ * @brief 将 4 位比较掩码展开为 4 个 bool 字节 (x86 为小端序)
+ */
+static inline void store_mask4(bool *out, int mask)
+{
+	uint32_t bytes = ((uint32_t)mask * 0x00204081u) & 0x01010101u;
+	memcpy(out, &bytes, sizeof(bytes));
+}
+
+/**
+ * @brief 将 2 位比较掩码展开为 2 个 bool 字节
+ */
+static inline void store_mask2(bool *out, int mask)
+{
+	uint16_t bytes = (uint16_t)(((unsigned)mask * 0x81u) & 0x0101u);
+	memcpy(out, &bytes, sizeof(bytes));
+}
+
+/**
+ * @brief 整数比较规约为 x > y 或 x == y (必要时交换操作数、结果取反)
+ */
+typedef struct {
+	bool swap;                   /* 交换左右操作数 */
+	bool equal;                  /* 使用相等比较 (否则为大于) */
+	bool invert;                 /* 结果取反 */
+} compare_plan_t;
+
+static compare_plan_t plan_compare(cel_binary_op_e op)
+{
+	switch (op) {
+	case CEL_BINARY_EQ:
+		return (compare_plan_t){false, true, false};
+	case CEL_BINARY_NE:
+		return (compare_plan_t){false, true, true};
+	case CEL_BINARY_LT:
+		return (compare_plan_t){true, false, false};
+	case CEL_BINARY_LE:
+		return (compare_plan_t){false, false, true};
+	case CEL_BINARY_GT:
+		return (compare_plan_t){false, false, false};
+	default:
+		return (compare_plan_t){true, false, true};
+	}
+}
+#endif
+
+static void kernel_compare_int(cel_binary_op_e op, const int64_t *l,
+			       const int64_t *r, bool *out, size_t n)
+{
+	size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+	compare_plan_t plan = plan_compare(op);
+	const int64_t *x = plan.swap ? r : l;
+	const int64_t *y = plan.swap ? l : r;
+#endif
+
+#if defined(__AVX2__)
+	int invert = plan.invert ? 0xF : 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(x + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(y + i));
+		__m256i cmp = plan.equal ? _mm256_cmpeq_epi64(a, b)
+					 : _mm256_cmpgt_epi64(a, b);
+		store_mask4(out + i,
+			    _mm256_movemask_pd(_mm256_castsi256_pd(cmp)) ^ invert);
+	}
+#elif defined(__SSE4_2__)
+	int invert = plan.invert ? 0x3 : 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(x + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(y + i));
+		__m128i cmp = plan.equal ? _mm_cmpeq_epi64(a, b)
+					 : _mm_cmpgt_epi64(a, b);
+		store_mask2(out + i,
+			    _mm_movemask_pd(_mm_castsi128_pd(cmp)) ^ invert);
+	}
+#endif
+
+	SCALAR_COMPARE(op, l, r, out, i, n);
+}
+
+#if defined(__AVX2__)
+#define SIMD_COMPARE_PD(pred)                                                \
+	for (; i + 4 <= n; i += 4) {                                         \
+		__m256d cmp = _mm256_cmp_pd(_mm256_loadu_pd(l + i),          \
+					    _mm256_loadu_pd(r + i), pred);   \
+		store_mask4(out + i, _mm256_movemask_pd(cmp));               \
+	}
+#elif defined(__SSE4_2__)
+#define SIMD_COMPARE_PD(fn)                                                  \
+	for (; i + 2 <= n; i += 2) {                                         \
+		__m128d cmp = fn(_mm_loadu_pd(l + i), _mm_loadu_pd(r + i));  \
+		store_mask2(out + i, _mm_movemask_pd(cmp));                  \
+	}
+#endif
+
+static void kernel_compare_double(cel_binary_op_e op, const double *l,
+				  const double *r, bool *out, size_t n)
+{
+	size_t i = 0;
+
+	/* 浮点比较需要保持 NaN 语义，不能像整数一样取反规约 */
+#if defined(__AVX2__)
+	switch (op) {
+	case CEL_BINARY_EQ:
+		SIMD_COMPARE_PD(_CMP_EQ_OQ);
+		break;
+	case CEL_BINARY_NE:
+		SIMD_COMPARE_PD(_CMP_NEQ_UQ);
+		break;
+	case CEL_BINARY_LT:
+		SIMD_COMPARE_PD(_CMP_LT_OQ);
+		break;
+	case CEL_BINARY_LE:
+		SIMD_COMPARE_PD(_CMP_LE_OQ);
+		break;
+	case CEL_BINARY_GT:
+		SIMD_COMPARE_PD(_CMP_GT_OQ);
+		break;
+	default:
+		SIMD_COMPARE_PD(_CMP_GE_OQ);
+		break;
+	}
+#elif defined(__SSE4_2__)
+	switch (op) {
+	case CEL_BINARY_EQ:
+		SIMD_COMPARE_PD(_mm_cmpeq_pd);
+		break;
+	case CEL_BINARY_NE:
+		SIMD_COMPARE_PD(_mm_cmpneq_pd);
+		break;
+	case CEL_BINARY_LT:
+		SIMD_COMPARE_PD(_mm_cmplt_pd);
+		break;
+	case CEL_BINARY_LE:
+		SIMD_COMPARE_PD(_mm_cmple_pd);
+		break;
+	case CEL_BINARY_GT:
+		SIMD_COMPARE_PD(_mm_cmpgt_pd);
+		break;
+	default:
+		SIMD_COMPARE_PD(_mm_cmpge_pd);
+		break;
+	}
+#endif
+
+	SCALAR_COMPARE(op, l, r, out, i, n);
+}
+
+/**
+ * @brief int64 算术 (按补码回绕，避免有符号溢出的未定义行为)
+ *
+ * @return false 除数为零 (由调用者回退到逐行执行以报告错误)
+ */
+static bool kernel_arith_int(cel_binary_op_e op, const int64_t *restrict l,
+			     const int64_t *restrict r, int64_t *restrict out,
+			     size_t n)
+{
+	switch (op) {
+	case CEL_BINARY_ADD:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = (int64_t)((uint64_t)l[i] + (uint64_t)r[i]);
+		}
+		return true;
+	case CEL_BINARY_SUB:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = (int64_t)((uint64_t)l[i] - (uint64_t)r[i]);
+		}
+		return true;
+	case CEL_BINARY_MUL:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = (int64_t)((uint64_t)l[i] * (uint64_t)r[i]);
+		}
+		return true;
+	default:
+		break;
+	}
+
+	/* 除法与取模: 除数为零或 INT64_MIN / -1 时交给逐行执行 */
+	for (size_t i = 0; i < n; i++) {
+		if (r[i] == 0 || (r[i] == -1 && l[i] == INT64_MIN)) {
+			return false;
+		}
+		out[i] = op == CEL_BINARY_DIV ? l[i] / r[i] : l[i] % r[i];
+	}
+	return true;
+}
+
+static bool kernel_arith_double(cel_binary_op_e op, const double *restrict l,
+				const double *restrict r, double *restrict out,
+				size_t n)
+{
+	switch (op) {
+	case CEL_BINARY_ADD:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] + r[i];
+		}
+		return true;
+	case CEL_BINARY_SUB:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] - r[i];
+		}
+		return true;
+	case CEL_BINARY_MUL:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] * r[i];
+		}
+		return true;
+	default:
+		break;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (r[i] == 0.0) {
+			return false;
+		}
+		out[i] = op == CEL_BINARY_DIV ? l[i] / r[i] : fmod(l[i], r[i]);
+	}
+	return true;
+}
+
+static void kernel_logical(cel_binary_op_e op, const bool *restrict l,
+			   const bool *restrict r, bool *restrict out,
+			   size_t n)
+{
+	switch (op) {
+	case CEL_BINARY_AND:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] & r[i];
+		}
+		break;
+	case CEL_BINARY_OR:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] | r[i];
+		}
+		break;
+	case CEL_BINARY_EQ:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] == r[i];
+		}
+		break;
+	default:
+		for (size_t i = 0; i < n; i++) {
+			out[i] = l[i] != r[i];
+		}
+		break;
+	}
+}
+
+/* ========== 向量运算 ========== */
+
+static void *node_buffer(exec_t *e, size_t index)
+{
+	return e->scratch + index * COLUMNAR_CHUNK * sizeof(int64_t);
+}
+
+/**
+ * @brief 将数值向量转换为 double 向量
+ */
+static const double *as_double(exec_t *e, const vector_t *v, int which,
+			       size_t n)
+{
+	if (v->type == CEL_TYPE_DOUBLE) {
+		return v->data;
+	}
+
+	const int64_t *src = v->data;
+	double *dst = e->convert[which];
+	for (size_t i = 0; i < n; i++) {
+		dst[i] = (double)src[i];
+	}
+	return dst;
+}
+
+static bool is_numeric(cel_type_e type)
+{
+	return type == CEL_TYPE_INT || type == CEL_TYPE_DOUBLE;
+}
+
+static bool run_unary(exec_t *e, const vnode_t *node, size_t index, size_t n)
+{
+	const vector_t *v = &e->vectors[node->a];
+	vector_t *out = &e->vectors[index];
+	void *buffer = node_buffer(e, index);
+
+	if (node->unary == CEL_UNARY_NOT && v->type == CEL_TYPE_BOOL) {
+		const bool *src = v->data;
+		bool *dst = buffer;
+		for (size_t i = 0; i < n; i++) {
+			dst[i] = !src[i];
+		}
+	} else if (node->unary == CEL_UNARY_NEG && v->type == CEL_TYPE_INT) {
+		const int64_t *src = v->data;
+		int64_t *dst = buffer;
+		for (size_t i = 0; i < n; i++) {
+			dst[i] = (int64_t)(0 - (uint64_t)src[i]);
+		}
+	} else if (node->unary == CEL_UNARY_NEG && v->type == CEL_TYPE_DOUBLE) {
+		const double *src = v->data;
+		double *dst = buffer;
+		for (size_t i = 0; i < n; i++) {
+			dst[i] = -src[i];
+		}
+	} else {
+		return false;
+	}
+
+	out->type = v->type;
+	out->data = buffer;
+	return true;
+}
+
+static bool run_binary(exec_t *e, const vnode_t *node, size_t index, size_t n)
+{
+	const vector_t *l = &e->vectors[node->a];
+	const vector_t *r = &e->vectors[node->b];
+	vector_t *out = &e->vectors[index];
+	void *buffer = node_buffer(e, index);
+	cel_binary_op_e op = node->binary;
+
+	out->data = buffer;
+
+	/* 逻辑运算 */
+	if (op == CEL_BINARY_AND || op == CEL_BINARY_OR) {
+		if (l->type != CEL_TYPE_BOOL || r->type != CEL_TYPE_BOOL) {
+			return false;
+		}
+		kernel_logical(op, l->data, r->data, buffer, n);
+		out->type = CEL_TYPE_BOOL;
+		return true;
+	}
+
+	/* 算术运算 */
+	if (op >= CEL_BINARY_ADD && op <= CEL_BINARY_MOD) {
+		if (l->type == CEL_TYPE_INT && r->type == CEL_TYPE_INT) {
+			out->type = CEL_TYPE_INT;
+			return kernel_arith_int(op, l->data, r->data, buffer, n);
+		}
+		if (!is_numeric(l->type) || !is_numeric(r->type)) {
+			return false;
+		}
+		out->type = CEL_TYPE_DOUBLE;
+		return kernel_arith_double(op, as_double(e, l, 0, n),
+					   as_double(e, r, 1, n), buffer, n);
+	}
+
+	/* 比较运算 */
+	out->type = CEL_TYPE_BOOL;
+	if (l->type != r->type && (op == CEL_BINARY_EQ || op == CEL_BINARY_NE)) {
+		/* 不同类型的值不相等 */
+		memset(buffer, op == CEL_BINARY_NE, n * sizeof(bool));
+		return true;
+	}
+	if (l->type == CEL_TYPE_BOOL && r->type == CEL_TYPE_BOOL) {
+		if (op != CEL_BINARY_EQ && op != CEL_BINARY_NE) {
+			return false;
+		}
+		kernel_logical(op, l->data, r->data, buffer, n);
+		return true;
+	}
+	if (l->type == CEL_TYPE_INT && r->type == CEL_TYPE_INT) {
+		kernel_compare_int(op, l->data, r->data, buffer, n);
+		return true;
+	}
+	if (!is_numeric(l->type) || !is_numeric(r->type)) {
+		return false;
+	}
+	kernel_compare_double(op, as_double(e, l, 0, n), as_double(e, r, 1, n),
+			      buffer, n);
+	return true;
+}
+
+/* ========== 逐行求值 ========== */
+
+/**
+ * @brief 将第 row 行的列值写入激活记录
+ */
+static void bind_row(exec_t *e, size_t row)
+{
+	for (size_t slot = 0; slot < e->columnar->column_count; slot++) {
+		const cel_column_t *column = &e->columns[slot];
+		if (!column->data) {
+			continue;
+		}
+
+		cel_value_t value;
+		switch (column->type) {
+		case CEL_COLUMN_INT:
+			value = cel_value_int(((const int64_t *)column->data)[row]);
+			break;
+		case CEL_COLUMN_DOUBLE:
+			value = cel_value_double(((const double *)column->data)[row]);
+			break;
+		default:
+			value = cel_value_bool(((const bool *)column->data)[row]);
+			break;
+		}
+		cel_activation_set(e->activation, slot, &value);
+	}
+}
+
+/**
+ * @brief 逐行执行字节码
+ */
+static bool run_row_value(exec_t *e, const cel_bytecode_t *bytecode,
+			  size_t row, cel_value_t *value)
+{
+	bind_row(e, row);
+	if (bytecode) {
+		return cel_vm_execute_frame(bytecode, e->ctx, e->activation,
+					    &e->frame, value);
+	}
+
+	/* 树遍历程序 */
+	cel_execute_result_t result = cel_execute_with_activation(
+		e->columnar->program, e->ctx, e->activation);
+	*value = result.value;
+	result.value = cel_value_null();
+	bool success = result.success;
+	cel_execute_result_destroy(&result);
+	return success;
+}
+
+/**
+ * @brief 逐行求值子表达式，结果必须为同一标量类型
+ */
+static bool run_row_node(exec_t *e, const vnode_t *node, size_t index,
+			 size_t start, size_t n)
+{
+	vector_t *out = &e->vectors[index];
+	void *buffer = node_buffer(e, index);
+	out->data = buffer;
+
+	for (size_t i = 0; i < n; i++) {
+		cel_value_t value;
+		if (!run_row_value(e, node->bytecode, start + i, &value)) {
+			return false;
+		}
+		if (i == 0) {
+			out->type = value.type;
+		}
+		if (value.type != out->type) {
+			cel_value_destroy(&value);
+			return false;
+		}
+
+		switch (value.type) {
+		case CEL_TYPE_INT:
+			((int64_t *)buffer)[i] = value.value.int_value;
+			break;
+		case CEL_TYPE_DOUBLE:
+			((double *)buffer)[i] = value.value.double_value;
+			break;
+		case CEL_TYPE_BOOL:
+			((bool *)buffer)[i] = value.value.bool_value;
+			break;
+		default:
+			cel_value_destroy(&value);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief 整段逐行执行整个程序 (向量执行失败时使用)
+ */
+static size_t select_rows(exec_t *e, size_t start, size_t n,
+			  uint32_t *selection)
+{
+	size_t selected = 0;
+	for (size_t i = 0; i < n; i++) {
+		cel_value_t value;
+		if (!run_row_value(e, e->columnar->program->bytecode, start + i,
+				   &value)) {
+			continue;
+		}
+		if (value.type == CEL_TYPE_BOOL) {
+			if (value.value.bool_value) {
+				selection[selected++] = (uint32_t)(start + i);
+			}
+		} else {
+			cel_value_destroy(&value);
+		}
+	}
+	return selected;
+}
+
+/* ========== 执行 ========== */
+
+/**
+ * @brief 向量执行一段行
+ *
+ * @return false 需要回退到逐行执行
+ */
+static bool run_chunk(exec_t *e, size_t start, size_t n)
+{
+	const cel_columnar_program_t *cp = e->columnar;
+
+	for (size_t i = 0; i < cp->node_count; i++) {
+		const vnode_t *node = &cp->nodes[i];
+		vector_t *v = &e->vectors[i];
+		bool ok = true;
+
+		switch (node->kind) {
+		case VNODE_COLUMN: {
+			const cel_column_t *column = &e->columns[node->slot];
+			if (!column->data) {
+				return false;
+			}
+			switch (column->type) {
+			case CEL_COLUMN_INT:
+				v->type = CEL_TYPE_INT;
+				v->data = (const int64_t *)column->data + start;
+				break;
+			case CEL_COLUMN_DOUBLE:
+				v->type = CEL_TYPE_DOUBLE;
+				v->data = (const double *)column->data + start;
+				break;
+			default:
+				v->type = CEL_TYPE_BOOL;
+				v->data = (const bool *)column->data + start;
+				break;
+			}
+			break;
+		}
+
+		case VNODE_CONST:
+			/* 执行开始时已广播 */
+			break;
+
+		case VNODE_UNARY:
+			ok = run_unary(e, node, i, n);
+			break;
+
+		case VNODE_BINARY:
+			ok = run_binary(e, node, i, n);
+			break;
+
+		case VNODE_ROW:
+			ok = run_row_node(e, node, i, start, n);
+			break;
+		}
+
+		if (!ok) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief 广播常量节点
+ */
+static void broadcast_constants(exec_t *e)
+{
+	const cel_columnar_program_t *cp = e->columnar;
+
+	for (size_t i = 0; i < cp->node_count; i++) {
+		const vnode_t *node = &cp->nodes[i];
+		if (node->kind != VNODE_CONST) {
+			continue;
+		}
+
+		void *buffer = node_buffer(e, i);
+		e->vectors[i].type = node->constant.type;
+		e->vectors[i].data = buffer;
+		for (size_t k = 0; k < COLUMNAR_CHUNK; k++) {
+			switch (node->constant.type) {
+			case CEL_TYPE_INT:
+				((int64_t *)buffer)[k] = node->constant.value.int_value;
+				break;
+			case CEL_TYPE_DOUBLE:
+				((double *)buffer)[k] = node->constant.value.double_value;
+				break;
+			default:
+				((bool *)buffer)[k] = node->constant.value.bool_value;
+				break;
+			}
+		}
+	}
+}
+
+size_t cel_columnar_select(const cel_columnar_program_t *columnar,
+			   cel_context_t *ctx, const cel_column_t *columns,
+			   size_t row_count, uint32_t *selection)
+{
+	if (!columnar || !ctx || !columns || !selection ||
+	    columnar->node_count == 0) {
+		return 0;
+	}
+
+	size_t node_count = columnar->node_count;
+	size_t selected = 0;
+	exec_t e = {
+		.columnar = columnar,
+		.ctx = ctx,
+		.columns = columns,
+	};
+	e.scratch = malloc(node_count * COLUMNAR_CHUNK * sizeof(int64_t));
+	e.convert[0] = malloc(2 * COLUMNAR_CHUNK * sizeof(double));
+	e.vectors = malloc(node_count * sizeof(vector_t));
+	e.activation = cel_activation_create(columnar->program->schema);
+	if (!e.scratch || !e.convert[0] || !e.vectors || !e.activation) {
+		goto cleanup;
+	}
+	e.convert[1] = e.convert[0] + COLUMNAR_CHUNK;
+
+	broadcast_constants(&e);
+
+	const vector_t *root = &e.vectors[node_count - 1];
+	for (size_t start = 0; start < row_count; start += COLUMNAR_CHUNK) {
+		size_t n = row_count - start;
+		if (n > COLUMNAR_CHUNK) {
+			n = COLUMNAR_CHUNK;
+		}
+
+		if (!run_chunk(&e, start, n)) {
+			selected += select_rows(&e, start, n, selection + selected);
+			continue;
+		}
+
+		/* 非 bool 结果不选中任何行 */
+		if (root->type != CEL_TYPE_BOOL) {
+			continue;
+		}
+		const bool *match = root->data;
+		for (size_t i = 0; i < n; i++) {
+			selection[selected] = (uint32_t)(start + i);
+			selected += match[i];
+		}
+	}
+
+cleanup:
+	cel_vm_frame_destroy(&e.frame);
+	cel_activation_destroy(e.activation);
+	free(e.vectors);
+	free(e.convert[0]);
+	free(e.scratch);
+	return selected;
+}
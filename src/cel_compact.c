@@ -0,0 +1,1149 @@
+/**
+ * @file cel_compact.c
+ * @brief CEL 紧凑 AST 实现
+ *
+ * 转换分两遍: 第一遍统计节点、子节点下标、值的数量并对名称去重，
+ * 第二遍按前序写入一次分配的各个表。求值器按下标遍历节点，
+ * 值级运算复用树遍历求值器的实现 (见 cel_eval.h)。
+ */
+
+#include "cel/cel_compact.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include "uthash/uthash.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* 函数参数的栈上缓冲区大小，超过时使用堆分配 */
+#define COMPACT_INLINE_ARGS 8
+
+/* 推导式在 children 中的各项 */
+enum {
+	COMP_RANGE,
+	COMP_INIT,
+	COMP_COND,
+	COMP_STEP,
+	COMP_RESULT,
+	COMP_ITER_VAR2,
+	COMP_SLOTS,
+};
+
+/* 左深链的栈上缓冲区大小 (链上的节点数)，超过时使用堆分配 */
+#define EVAL_INLINE_CHAIN 16
+
+/* ========== 转换 ========== */
+
+/**
+ * @brief 名称表条目 (uthash, 按名称索引)
+ */
+typedef struct {
+	const char *name;            /* 名称 (指向原 AST) */
+	size_t length;               /* 名称长度 */
+	uint32_t offset;             /* 名称表中的偏移 */
+	UT_hash_handle hh;           /* uthash 句柄 */
+} name_entry_t;
+
+/**
+ * @brief 转换状态
+ */
+typedef struct {
+	/* 第一遍统计 */
+	size_t node_count;           /* 节点数量 */
+	size_t child_count;          /* 子节点下标数量 */
+	size_t value_count;          /* 值数量 */
+	size_t names_length;         /* 名称表字节数 */
+	name_entry_t *names;         /* 已去重的名称 */
+
+	/* 第二遍写入 */
+	cel_compact_ast_t *out;      /* 输出 */
+	uint32_t next_node;          /* 下一个节点下标 */
+	uint32_t next_child;         /* 下一个子节点位置 */
+	bool failed;                 /* 内存不足 */
+} builder_t;
+
+static void intern_name(builder_t *b, const char *name, size_t length)
+{
+	name_entry_t *entry = NULL;
+	HASH_FIND(hh, b->names, name, length, entry);
+	if (entry) {
+		return;
+	}
+
+	entry = malloc(sizeof(name_entry_t));
+	if (!entry) {
+		b->failed = true;
+		return;
+	}
+	entry->name = name;
+	entry->length = length;
+	entry->offset = (uint32_t)b->names_length;
+	b->names_length += length + 1;
+	HASH_ADD_KEYPTR(hh, b->names, entry->name, entry->length, entry);
+}
+
+static uint32_t name_offset(const builder_t *b, const char *name, size_t length)
+{
+	name_entry_t *entry = NULL;
+	HASH_FIND(hh, b->names, name, length, entry);
+	return entry ? entry->offset : CEL_COMPACT_NONE;
+}
+
+/**
+ * @brief 解析内置函数 (转换的两遍使用相同的结果)
+ */
+static bool resolve_builtin(const cel_ast_call_t *call, cel_function_id_e *id)
+{
+	size_t arg_count = call->arg_count + (call->target ? 1 : 0);
+	return cel_builtin_resolve(call->function, call->function_length,
+				   call->target != NULL, arg_count, id);
+}
+
+/**
+ * @brief 第一遍: 统计表的大小并收集名称
+ */
+static void count_node(builder_t *b, const cel_ast_node_t *node)
+{
+	if (!node || b->failed) {
+		return;
+	}
+
+	b->node_count++;
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		b->value_count++;
+		break;
+
+	case CEL_AST_IDENT:
+		intern_name(b, node->as.ident.name, node->as.ident.length);
+		break;
+
+	case CEL_AST_UNARY:
+		count_node(b, node->as.unary.operand);
+		break;
+
+	case CEL_AST_BINARY:
+		count_node(b, node->as.binary.left);
+		count_node(b, node->as.binary.right);
+		break;
+
+	case CEL_AST_TERNARY:
+		count_node(b, node->as.ternary.condition);
+		count_node(b, node->as.ternary.if_true);
+		count_node(b, node->as.ternary.if_false);
+		break;
+
+	case CEL_AST_SELECT:
+		b->value_count++;
+		count_node(b, node->as.select.operand);
+		break;
+
+	case CEL_AST_INDEX:
+		count_node(b, node->as.index.operand);
+		count_node(b, node->as.index.index);
+		break;
+
+	case CEL_AST_CALL: {
+		const cel_ast_call_t *call = &node->as.call;
+		cel_function_id_e id;
+		if (!resolve_builtin(call, &id)) {
+			intern_name(b, call->function, call->function_length);
+		}
+		b->child_count += call->arg_count + (call->target ? 1 : 0);
+		count_node(b, call->target);
+		for (size_t i = 0; i < call->arg_count; i++) {
+			count_node(b, call->args[i]);
+		}
+		break;
+	}
+
+	case CEL_AST_LIST:
+		b->child_count += node->as.list.element_count;
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			count_node(b, node->as.list.elements[i]);
+		}
+		break;
+
+	case CEL_AST_MAP:
+		b->child_count += 2 * node->as.map.entry_count;
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			count_node(b, node->as.map.entries[i].key);
+			count_node(b, node->as.map.entries[i].value);
+		}
+		break;
+
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *comp = &node->as.comprehension;
+		intern_name(b, comp->iter_var, comp->iter_var_length);
+		if (comp->iter_var2) {
+			intern_name(b, comp->iter_var2, comp->iter_var2_length);
+		}
+		intern_name(b, comp->accu_var, comp->accu_var_length);
+		b->child_count += COMP_SLOTS;
+		count_node(b, comp->iter_range);
+		count_node(b, comp->accu_init);
+		count_node(b, comp->loop_cond);
+		count_node(b, comp->loop_step);
+		count_node(b, comp->result);
+		break;
+	}
+
+	default:
+		/* 结构体字面量不支持求值，不转换其字段 */
+		break;
+	}
+}
+
+/**
+ * @brief 第二遍: 按前序写入节点
+ *
+ * @return 节点下标 (node 为 NULL 时返回 CEL_COMPACT_NONE)
+ */
+static uint32_t emit_node(builder_t *b, const cel_ast_node_t *node)
+{
+	if (!node || b->failed) {
+		return CEL_COMPACT_NONE;
+	}
+
+	cel_compact_ast_t *out = b->out;
+	uint32_t index = b->next_node++;
+	cel_compact_node_t compact = {.type = (uint8_t)node->type};
+	out->locs[index].line = (uint32_t)node->loc.line;
+	out->locs[index].column = (uint32_t)node->loc.column;
+
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		compact.a = out->value_count;
+		out->values[out->value_count++] =
+			cel_value_retain(&node->as.literal.value);
+		break;
+
+	case CEL_AST_IDENT:
+		compact.a = name_offset(b, node->as.ident.name,
+					node->as.ident.length);
+		break;
+
+	case CEL_AST_UNARY:
+		compact.op = (uint8_t)node->as.unary.op;
+		compact.a = emit_node(b, node->as.unary.operand);
+		break;
+
+	case CEL_AST_BINARY:
+		compact.op = (uint8_t)node->as.binary.op;
+		compact.a = emit_node(b, node->as.binary.left);
+		compact.b = emit_node(b, node->as.binary.right);
+		break;
+
+	case CEL_AST_TERNARY:
+		compact.a = emit_node(b, node->as.ternary.condition);
+		compact.b = emit_node(b, node->as.ternary.if_true);
+		compact.c = emit_node(b, node->as.ternary.if_false);
+		break;
+
+	case CEL_AST_SELECT: {
+		/* 字段名在转换时构造为字符串值 */
+		cel_value_t field = cel_value_string_n(node->as.select.field,
+						       node->as.select.field_length);
+		if (field.type != CEL_TYPE_STRING) {
+			b->failed = true;
+			break;
+		}
+		compact.flags = node->as.select.optional ? CEL_COMPACT_OPTIONAL : 0;
+		compact.b = out->value_count;
+		out->values[out->value_count++] = field;
+		compact.a = emit_node(b, node->as.select.operand);
+		break;
+	}
+
+	case CEL_AST_INDEX:
+		compact.flags = node->as.index.optional ? CEL_COMPACT_OPTIONAL : 0;
+		compact.a = emit_node(b, node->as.index.operand);
+		compact.b = emit_node(b, node->as.index.index);
+		break;
+
+	case CEL_AST_CALL: {
+		const cel_ast_call_t *call = &node->as.call;
+		cel_function_id_e id;
+		if (resolve_builtin(call, &id)) {
+			compact.flags = CEL_COMPACT_BUILTIN;
+			compact.c = (uint32_t)id;
+		} else {
+			compact.c = name_offset(b, call->function,
+						call->function_length);
+		}
+
+		/* 先预留连续的子节点位置，再依次写入子树 */
+		uint32_t first = b->next_child;
+		uint32_t count = (uint32_t)(call->arg_count + (call->target ? 1 : 0));
+		b->next_child += count;
+		uint32_t slot = first;
+		if (call->target) {
+			out->children[slot++] = emit_node(b, call->target);
+		}
+		for (size_t i = 0; i < call->arg_count; i++) {
+			out->children[slot++] = emit_node(b, call->args[i]);
+		}
+		compact.a = first;
+		compact.b = count;
+		break;
+	}
+
+	case CEL_AST_LIST: {
+		uint32_t first = b->next_child;
+		uint32_t count = (uint32_t)node->as.list.element_count;
+		b->next_child += count;
+		for (uint32_t i = 0; i < count; i++) {
+			out->children[first + i] =
+				emit_node(b, node->as.list.elements[i]);
+		}
+		compact.a = first;
+		compact.b = count;
+		break;
+	}
+
+	case CEL_AST_MAP: {
+		uint32_t first = b->next_child;
+		uint32_t count = (uint32_t)node->as.map.entry_count;
+		b->next_child += 2 * count;
+		for (uint32_t i = 0; i < count; i++) {
+			out->children[first + 2 * i] =
+				emit_node(b, node->as.map.entries[i].key);
+			out->children[first + 2 * i + 1] =
+				emit_node(b, node->as.map.entries[i].value);
+		}
+		compact.a = first;
+		compact.b = count;
+		break;
+	}
+
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *comp = &node->as.comprehension;
+		uint32_t first = b->next_child;
+		uint32_t *slots = &out->children[first];
+		b->next_child += COMP_SLOTS;
+		slots[COMP_RANGE] = emit_node(b, comp->iter_range);
+		slots[COMP_INIT] = emit_node(b, comp->accu_init);
+		slots[COMP_COND] = emit_node(b, comp->loop_cond);
+		slots[COMP_STEP] = emit_node(b, comp->loop_step);
+		slots[COMP_RESULT] = emit_node(b, comp->result);
+		slots[COMP_ITER_VAR2] = comp->iter_var2 ?
+			name_offset(b, comp->iter_var2, comp->iter_var2_length) :
+			CEL_COMPACT_NONE;
+		compact.a = first;
+		compact.b = name_offset(b, comp->iter_var, comp->iter_var_length);
+		compact.c = name_offset(b, comp->accu_var, comp->accu_var_length);
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	out->nodes[index] = compact;
+	return index;
+}
+
+/**
+ * @brief 在一次分配中布置各个表 (值在前，满足对齐)
+ */
+static cel_compact_ast_t *allocate(const builder_t *b)
+{
+	size_t values_size = b->value_count * sizeof(cel_value_t);
+	size_t nodes_size = b->node_count * sizeof(cel_compact_node_t);
+	size_t locs_size = b->node_count * sizeof(cel_compact_loc_t);
+	size_t children_size = b->child_count * sizeof(uint32_t);
+	size_t size = sizeof(cel_compact_ast_t) + values_size + nodes_size +
+		      locs_size + children_size + b->names_length;
+
+	char *block = calloc(1, size);
+	if (!block) {
+		return NULL;
+	}
+
+	cel_compact_ast_t *ast = (cel_compact_ast_t *)block;
+	char *p = block + sizeof(cel_compact_ast_t);
+	ast->values = (cel_value_t *)p;
+	p += values_size;
+	ast->nodes = (cel_compact_node_t *)p;
+	p += nodes_size;
+	ast->locs = (cel_compact_loc_t *)p;
+	p += locs_size;
+	ast->children = (uint32_t *)p;
+	p += children_size;
+	ast->names = p;
+
+	ast->node_count = (uint32_t)b->node_count;
+	ast->child_count = (uint32_t)b->child_count;
+	ast->names_length = (uint32_t)b->names_length;
+	ast->size = size;
+	return ast;
+}
+
+cel_compact_ast_t *cel_compact_ast_build(const cel_ast_node_t *ast)
+{
+	if (!ast) {
+		return NULL;
+	}
+
+	builder_t b;
+	memset(&b, 0, sizeof(b));
+	count_node(&b, ast);
+
+	/* CEL_COMPACT_NONE 保留为空下标 */
+	if (!b.failed && b.node_count < CEL_COMPACT_NONE &&
+	    b.child_count < CEL_COMPACT_NONE &&
+	    b.value_count < CEL_COMPACT_NONE &&
+	    b.names_length < CEL_COMPACT_NONE) {
+		b.out = allocate(&b);
+	}
+
+	if (b.out) {
+		name_entry_t *entry, *tmp;
+		HASH_ITER(hh, b.names, entry, tmp) {
+			memcpy(b.out->names + entry->offset, entry->name,
+			       entry->length);
+		}
+		emit_node(&b, ast);
+	}
+
+	name_entry_t *entry, *tmp;
+	HASH_ITER(hh, b.names, entry, tmp) {
+		HASH_DEL(b.names, entry);
+		free(entry);
+	}
+
+	if (b.out && b.failed) {
+		cel_compact_ast_destroy(b.out);
+		return NULL;
+	}
+	return b.out;
+}
+
+void cel_compact_ast_destroy(cel_compact_ast_t *ast)
+{
+	if (!ast) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < ast->value_count; i++) {
+		cel_value_destroy(&ast->values[i]);
+	}
+	free(ast);
+}
+
+/* ========== 推导式变量帧 ========== */
+
+/**
+ * @brief 推导式变量帧 (与树遍历求值器相同，名称以偏移比较)
+ */
+typedef struct compact_frame {
+	uint32_t iter_var;                  /* 循环变量名 */
+	uint32_t iter_var2;                 /* 第二个循环变量名 (可为 CEL_COMPACT_NONE) */
+	uint32_t accu_var;                  /* 累加器变量名 */
+	const cel_value_t *iter_value;      /* 当前元素或键 (NULL 表示不可见) */
+	const cel_value_t *iter_value2;     /* 当前元素或 Map 的值 */
+	cel_value_t index;                  /* 双变量列表迭代的当前下标 */
+	cel_value_t accu_value;             /* 累加器的值 (帧持有) */
+	const struct compact_frame *parent; /* 外层推导式的帧 */
+} compact_frame_t;
+
+/**
+ * @brief 求值状态
+ */
+typedef struct {
+	const cel_compact_ast_t *ast;  /* 紧凑 AST */
+	cel_context_t *ctx;            /* 求值上下文 */
+	const compact_frame_t *frame;  /* 最内层推导式的帧 */
+	cel_exec_budget_t *budget;     /* 执行预算 (限制递归深度，可为 NULL) */
+} compact_eval_t;
+
+static const cel_value_t *frame_lookup(const compact_frame_t *frame,
+				       uint32_t name)
+{
+	for (; frame; frame = frame->parent) {
+		if (frame->iter_value) {
+			if (frame->iter_var2 == name) {
+				return frame->iter_value2;
+			}
+			if (frame->iter_var == name) {
+				return frame->iter_value;
+			}
+		}
+		if (frame->accu_var == name) {
+			return &frame->accu_value;
+		}
+	}
+	return NULL;
+}
+
+/* ========== 节点求值 ========== */
+
+static bool eval_node(compact_eval_t *ev, uint32_t index, cel_value_t *result);
+
+/**
+ * @brief 求值必须为 bool 的操作数
+ *
+ * @param value 输出 bool 值
+ */
+static bool eval_bool(compact_eval_t *ev, uint32_t index, const char *message,
+		      bool *value)
+{
+	cel_value_t operand;
+	if (!eval_node(ev, index, &operand)) {
+		return false;
+	}
+	if (operand.type != CEL_TYPE_BOOL) {
+		cel_value_destroy(&operand);
+		cel_eval_report_error(ev->ctx, CEL_ERROR_TYPE_MISMATCH, message);
+		return false;
+	}
+	*value = operand.value.bool_value;
+	return true;
+}
+
+static bool eval_ident(compact_eval_t *ev, const cel_compact_node_t *node,
+		       cel_value_t *result)
+{
+	const cel_value_t *bound = frame_lookup(ev->frame, node->a);
+	if (bound) {
+		*result = cel_value_retain(bound);
+		return true;
+	}
+
+	/* 名称表中的名称已经 null 结尾 */
+	const char *name = ev->ast->names + node->a;
+	cel_value_t *value = cel_context_get_variable(ev->ctx, name);
+	if (!value) {
+		cel_eval_report_error_detail(ev->ctx,
+					     CEL_ERROR_UNKNOWN_IDENTIFIER,
+					     "Undefined variable", name,
+					     strlen(name));
+		return false;
+	}
+
+	*result = cel_value_retain(value);
+	return true;
+}
+
+static bool eval_unary(compact_eval_t *ev, const cel_compact_node_t *node,
+		       cel_value_t *result)
+{
+	cel_value_t operand;
+	if (!eval_node(ev, node->a, &operand)) {
+		return false;
+	}
+
+	bool success = cel_eval_unary_op(ev->ctx, (cel_unary_op_e)node->op,
+					 &operand, result);
+	cel_value_destroy(&operand);
+	return success;
+}
+
+/* 左深链 (与树遍历求值器相同，沿左操作数 a 收集后按循环求值) */
+
+/**
+ * @brief 链上的节点下标 (links[0] 为链头，最后一个持有最左的操作数)
+ */
+typedef struct {
+	uint32_t local[EVAL_INLINE_CHAIN];
+	uint32_t *links;
+	size_t count;
+} compact_chain_t;
+
+static bool is_logical(uint8_t op)
+{
+	return op == CEL_BINARY_AND || op == CEL_BINARY_OR;
+}
+
+/**
+ * @brief 节点是否延续以 head 开头的链 (左操作数均为 a)
+ */
+static bool chain_continues(const cel_compact_node_t *nodes,
+			    const cel_compact_node_t *head, uint32_t index)
+{
+	if (index == CEL_COMPACT_NONE) {
+		return false;
+	}
+	const cel_compact_node_t *node = &nodes[index];
+	if (head->type == CEL_AST_BINARY && is_logical(head->op)) {
+		return node->type == CEL_AST_BINARY && node->op == head->op;
+	}
+	return (node->type == CEL_AST_BINARY && !is_logical(node->op)) ||
+	       node->type == CEL_AST_SELECT || node->type == CEL_AST_INDEX;
+}
+
+static void chain_release(compact_chain_t *chain)
+{
+	if (chain->links != chain->local) {
+		free(chain->links);
+	}
+}
+
+/**
+ * @brief 收集以 head 开头的链 (成功时调用者负责 chain_release)
+ */
+static bool chain_collect(compact_eval_t *ev, compact_chain_t *chain,
+			  const cel_compact_node_t *head)
+{
+	const cel_compact_node_t *nodes = ev->ast->nodes;
+	size_t capacity = EVAL_INLINE_CHAIN;
+	chain->links = chain->local;
+	chain->count = 0;
+
+	uint32_t link = (uint32_t)(head - nodes);
+	do {
+		if (chain->count == capacity) {
+			capacity *= 2;
+			uint32_t *grown = chain->links == chain->local ?
+				malloc(capacity * sizeof(*grown)) :
+				realloc(chain->links, capacity * sizeof(*grown));
+			if (!grown) {
+				chain_release(chain);
+				cel_eval_report_error(ev->ctx,
+						      CEL_ERROR_OUT_OF_MEMORY,
+						      "Out of memory");
+				return false;
+			}
+			if (chain->links == chain->local) {
+				memcpy(grown, chain->local, sizeof(chain->local));
+			}
+			chain->links = grown;
+		}
+		chain->links[chain->count++] = link;
+		link = nodes[link].a;
+	} while (chain_continues(nodes, head, link));
+	return true;
+}
+
+/**
+ * @brief 短路求值 && / || 链
+ */
+static bool eval_logical(compact_eval_t *ev, const cel_compact_node_t *node,
+			 cel_value_t *result)
+{
+	static const char *const message =
+		"Logical operator requires boolean operands";
+	const cel_compact_node_t *nodes = ev->ast->nodes;
+	bool decisive = node->op == CEL_BINARY_OR;  /* 决定结果的操作数值 */
+
+	compact_chain_t chain;
+	if (!chain_collect(ev, &chain, node)) {
+		return false;
+	}
+
+	size_t count = chain.count;
+	bool success = true, value = !decisive;
+	for (size_t i = 0; i <= count && value != decisive; i++) {
+		uint32_t owner = chain.links[i ? count - i : count - 1];
+		if (!eval_bool(ev, i ? nodes[owner].b : nodes[owner].a,
+			       message, &value)) {
+			/* 操作数类型错误时位置为操作数所属的节点 */
+			cel_eval_error_locate(ev->ast->locs[owner].line,
+					      ev->ast->locs[owner].column);
+			success = false;
+			break;
+		}
+	}
+
+	chain_release(&chain);
+	if (success) {
+		*result = cel_value_bool(value);
+	}
+	return success;
+}
+
+/**
+ * @brief 以已求值的左操作数完成链上的一个节点
+ */
+static bool eval_link(compact_eval_t *ev, const cel_compact_node_t *link,
+		      const cel_value_t *operand, cel_value_t *result)
+{
+	bool optional = (link->flags & CEL_COMPACT_OPTIONAL) != 0;
+	if (link->type == CEL_AST_SELECT) {
+		return cel_eval_select_field(ev->ctx, operand,
+					     &ev->ast->values[link->b],
+					     optional, result);
+	}
+
+	cel_value_t right;
+	if (!eval_node(ev, link->b, &right)) {
+		return false;
+	}
+	bool success = link->type == CEL_AST_INDEX ?
+		cel_eval_index_value(ev->ctx, operand, &right, optional,
+				     result) :
+		cel_eval_binary_op(ev->ctx, (cel_binary_op_e)link->op,
+				   operand, &right, result);
+	cel_value_destroy(&right);
+	return success;
+}
+
+/**
+ * @brief 求值二元运算 (&& / || 除外)、字段与索引访问的链
+ */
+static bool eval_chain(compact_eval_t *ev, const cel_compact_node_t *node,
+		       cel_value_t *result)
+{
+	const cel_compact_node_t *nodes = ev->ast->nodes;
+	compact_chain_t chain;
+	if (!chain_collect(ev, &chain, node)) {
+		return false;
+	}
+
+	cel_value_t value;
+	bool success = eval_node(ev, nodes[chain.links[chain.count - 1]].a,
+				 &value);
+	for (size_t i = chain.count; success && i-- > 0;) {
+		uint32_t link = chain.links[i];
+		cel_value_t next;
+		success = eval_link(ev, &nodes[link], &value, &next);
+		cel_value_destroy(&value);
+		if (success) {
+			value = next;
+		} else {
+			cel_eval_error_locate(ev->ast->locs[link].line,
+					      ev->ast->locs[link].column);
+		}
+	}
+
+	chain_release(&chain);
+	if (success) {
+		*result = value;
+	}
+	return success;
+}
+
+static bool eval_ternary(compact_eval_t *ev, const cel_compact_node_t *node,
+			 cel_value_t *result)
+{
+	bool condition;
+	if (!eval_bool(ev, node->a, "Ternary condition must be boolean",
+		       &condition)) {
+		return false;
+	}
+	return eval_node(ev, condition ? node->b : node->c, result);
+}
+
+static bool eval_call(compact_eval_t *ev, const cel_compact_node_t *node,
+		      cel_value_t *result)
+{
+	const uint32_t *children = &ev->ast->children[node->a];
+	size_t arg_count = node->b;
+
+	cel_value_t local_args[COMPACT_INLINE_ARGS];
+	cel_value_t *args = local_args;
+	if (arg_count > COMPACT_INLINE_ARGS) {
+		args = malloc(sizeof(cel_value_t) * arg_count);
+		if (!args) {
+			cel_eval_report_error(ev->ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Out of memory");
+			return false;
+		}
+	}
+
+	/* 求值接收者与参数 */
+	bool success = false;
+	size_t evaluated = 0;
+	for (; evaluated < arg_count; evaluated++) {
+		if (!eval_node(ev, children[evaluated], &args[evaluated])) {
+			goto cleanup;
+		}
+	}
+
+	if (node->flags & CEL_COMPACT_BUILTIN) {
+		success = cel_exec_budget_charge_call(ev->ctx, args, arg_count) &&
+			  cel_builtin_call((cel_function_id_e)node->c, ev->ctx,
+					   args, result);
+	} else {
+		success = cel_exec_budget_charge_call(ev->ctx, args, arg_count) &&
+			  cel_eval_call_context_function(
+				  ev->ctx, ev->ast->names + node->c, args,
+				  arg_count, result);
+	}
+
+cleanup:
+	for (size_t i = 0; i < evaluated; i++) {
+		cel_value_destroy(&args[i]);
+	}
+	if (args != local_args) {
+		free(args);
+	}
+	return success;
+}
+
+static bool eval_list(compact_eval_t *ev, const cel_compact_node_t *node,
+		      cel_value_t *result)
+{
+	cel_list_t *list = cel_list_create(node->b);
+	if (!list) {
+		cel_eval_report_error(ev->ctx, CEL_ERROR_OUT_OF_MEMORY,
+				      "Failed to create list");
+		return false;
+	}
+
+	const uint32_t *children = &ev->ast->children[node->a];
+	for (uint32_t i = 0; i < node->b; i++) {
+		cel_value_t element;
+		if (!eval_node(ev, children[i], &element)) {
+			cel_list_release(list);
+			return false;
+		}
+
+		bool appended = cel_list_append(list, &element);
+		cel_value_destroy(&element);
+		if (!appended) {
+			cel_list_release(list);
+			cel_eval_report_error(ev->ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Failed to append to list");
+			return false;
+		}
+	}
+
+	result->type = CEL_TYPE_LIST;
+	result->value.list_value = list;
+	return true;
+}
+
+static bool eval_map(compact_eval_t *ev, const cel_compact_node_t *node,
+		     cel_value_t *result)
+{
+	cel_map_t *map = cel_map_create(node->b > 0 ? node->b : 16);
+	if (!map) {
+		cel_eval_report_error(ev->ctx, CEL_ERROR_OUT_OF_MEMORY,
+				      "Failed to create map");
+		return false;
+	}
+
+	const uint32_t *children = &ev->ast->children[node->a];
+	for (uint32_t i = 0; i < node->b; i++) {
+		cel_value_t key, value;
+		if (!eval_node(ev, children[2 * i], &key)) {
+			cel_map_release(map);
+			return false;
+		}
+		if (!eval_node(ev, children[2 * i + 1], &value)) {
+			cel_value_destroy(&key);
+			cel_map_release(map);
+			return false;
+		}
+
+		bool stored = cel_map_put(map, &key, &value);
+		cel_value_destroy(&key);
+		cel_value_destroy(&value);
+		if (!stored) {
+			cel_map_release(map);
+			cel_eval_report_error(ev->ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Failed to set map entry");
+			return false;
+		}
+	}
+
+	result->type = CEL_TYPE_MAP;
+	result->value.map_value = map;
+	return true;
+}
+
+/* ========== 推导式求值 ========== */
+
+/**
+ * @brief 追加形式的循环步骤 ([G ?] @result + [E] [: @result])
+ *
+ * 与树遍历求值器相同，累加器为列表时原地追加。
+ */
+typedef struct {
+	uint32_t guard;              /* 过滤条件 (可为 CEL_COMPACT_NONE) */
+	uint32_t element;            /* 追加的元素 */
+} append_step_t;
+
+static bool is_accu(const cel_compact_ast_t *ast, uint32_t index,
+		    uint32_t accu_var)
+{
+	return index != CEL_COMPACT_NONE &&
+	       ast->nodes[index].type == CEL_AST_IDENT &&
+	       ast->nodes[index].a == accu_var;
+}
+
+static bool match_append(const cel_compact_ast_t *ast,
+			 const cel_compact_node_t *comp, const uint32_t *slots,
+			 append_step_t *append)
+{
+	uint32_t step = slots[COMP_STEP];
+	if (step == CEL_COMPACT_NONE || comp->b == comp->c ||
+	    slots[COMP_ITER_VAR2] == comp->c) {
+		/* 循环变量遮蔽累加器时步骤中的标识符不是累加器 */
+		return false;
+	}
+
+	append->guard = CEL_COMPACT_NONE;
+	const cel_compact_node_t *node = &ast->nodes[step];
+	if (node->type == CEL_AST_TERNARY && is_accu(ast, node->c, comp->c)) {
+		append->guard = node->a;
+		if (node->b == CEL_COMPACT_NONE) {
+			return false;
+		}
+		node = &ast->nodes[node->b];
+	}
+	if (node->type != CEL_AST_BINARY || node->op != CEL_BINARY_ADD ||
+	    !is_accu(ast, node->a, comp->c) || node->b == CEL_COMPACT_NONE ||
+	    ast->nodes[node->b].type != CEL_AST_LIST ||
+	    ast->nodes[node->b].b != 1) {
+		return false;
+	}
+	append->element = ast->children[ast->nodes[node->b].a];
+	return true;
+}
+
+static bool eval_append(compact_eval_t *ev, const append_step_t *append,
+			compact_frame_t *frame)
+{
+	if (append->guard != CEL_COMPACT_NONE) {
+		bool guard;
+		if (!eval_bool(ev, append->guard,
+			       "Ternary condition must be boolean", &guard)) {
+			return false;
+		}
+		if (!guard) {
+			return true;
+		}
+	}
+
+	cel_value_t element;
+	if (!eval_node(ev, append->element, &element)) {
+		return false;
+	}
+	bool success = cel_eval_list_append(ev->ctx, &frame->accu_value,
+					    &element);
+	cel_value_destroy(&element);
+	return success;
+}
+
+/**
+ * @brief 执行推导式的一次迭代 (循环变量已绑定到帧中)
+ *
+ * @param stop 输出循环条件为 false，迭代应结束
+ */
+static bool eval_iteration(compact_eval_t *ev, const uint32_t *slots,
+			   const append_step_t *append, compact_frame_t *frame,
+			   bool *stop)
+{
+	if (!cel_exec_budget_charge(ev->ctx, CEL_COST_ITERATION)) {
+		return false;
+	}
+
+	bool condition;
+	if (!eval_bool(ev, slots[COMP_COND], "Loop condition must be boolean",
+		       &condition)) {
+		return false;
+	}
+	if (!condition) {
+		*stop = true;
+		return true;
+	}
+
+	if (append && frame->accu_value.type == CEL_TYPE_LIST) {
+		return eval_append(ev, append, frame);
+	}
+
+	/* 求值循环步骤，原地覆盖累加器 */
+	cel_value_t accu;
+	if (!eval_node(ev, slots[COMP_STEP], &accu)) {
+		return false;
+	}
+	cel_value_destroy(&frame->accu_value);
+	frame->accu_value = accu;
+	return true;
+}
+
+/**
+ * @brief 对推导式求值 (执行模型见 cel_eval.c)
+ */
+static bool eval_comprehension(compact_eval_t *ev,
+			       const cel_compact_node_t *node,
+			       cel_value_t *result)
+{
+	const uint32_t *slots = &ev->ast->children[node->a];
+
+	cel_value_t range;
+	if (!eval_node(ev, slots[COMP_RANGE], &range)) {
+		return false;
+	}
+	if (range.type != CEL_TYPE_LIST && range.type != CEL_TYPE_MAP) {
+		cel_eval_report_error(ev->ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "Comprehension iter_range must be a list or map");
+		cel_value_destroy(&range);
+		return false;
+	}
+
+	/* 累加器初始值中循环变量与累加器尚不可见 */
+	compact_frame_t frame = {
+		.iter_var = node->b,
+		.iter_var2 = slots[COMP_ITER_VAR2],
+		.accu_var = node->c,
+		.iter_value = NULL,
+		.iter_value2 = NULL,
+		.parent = ev->frame,
+	};
+	if (!eval_node(ev, slots[COMP_INIT], &frame.accu_value)) {
+		cel_value_destroy(&range);
+		return false;
+	}
+
+	bool success = false;
+	bool stop = false;
+	bool has_iter_var2 = frame.iter_var2 != CEL_COMPACT_NONE;
+	append_step_t append_step;
+	const append_step_t *append =
+		match_append(ev->ast, node, slots, &append_step) ?
+			&append_step : NULL;
+	ev->frame = &frame;
+
+	if (range.type == CEL_TYPE_LIST) {
+		cel_list_t *list = range.value.list_value;
+		size_t size = cel_list_size(list);
+		for (size_t i = 0; i < size && !stop; i++) {
+			const cel_value_t *element = list->items[i];
+			if (has_iter_var2) {
+				frame.index = cel_value_int((int64_t)i);
+				frame.iter_value = &frame.index;
+				frame.iter_value2 = element;
+			} else {
+				frame.iter_value = element;
+			}
+			if (!eval_iteration(ev, slots, append, &frame, &stop)) {
+				goto cleanup;
+			}
+		}
+	} else {
+		cel_map_t *map = range.value.map_value;
+		for (size_t b = 0; b < map->bucket_count && !stop; b++) {
+			for (cel_map_entry_t *entry = map->buckets[b];
+			     entry && !stop; entry = entry->next) {
+				frame.iter_value = entry->key;
+				frame.iter_value2 = entry->value;
+				if (!eval_iteration(ev, slots, append, &frame,
+						    &stop)) {
+					goto cleanup;
+				}
+			}
+		}
+	}
+
+	/* 结果表达式中循环变量不可见 */
+	frame.iter_value = NULL;
+
+	if (slots[COMP_RESULT] != CEL_COMPACT_NONE) {
+		if (!eval_node(ev, slots[COMP_RESULT], result)) {
+			goto cleanup;
+		}
+	} else {
+		*result = frame.accu_value;
+		frame.accu_value = cel_value_null();
+	}
+	success = true;
+
+cleanup:
+	ev->frame = frame.parent;
+	cel_value_destroy(&frame.accu_value);
+	cel_value_destroy(&range);
+	return success;
+}
+
+/* ========== 求值主函数 ========== */
+
+static bool eval_node_kind(compact_eval_t *ev, const cel_compact_node_t *node,
+			   cel_value_t *result)
+{
+	switch ((cel_ast_node_type_e)node->type) {
+	case CEL_AST_LITERAL:
+		*result = cel_value_retain(&ev->ast->values[node->a]);
+		return true;
+
+	case CEL_AST_IDENT:
+		return eval_ident(ev, node, result);
+
+	case CEL_AST_UNARY:
+		return eval_unary(ev, node, result);
+
+	case CEL_AST_BINARY:
+		if (is_logical(node->op)) {
+			return eval_logical(ev, node, result);
+		}
+		return eval_chain(ev, node, result);
+
+	case CEL_AST_TERNARY:
+		return eval_ternary(ev, node, result);
+
+	case CEL_AST_SELECT:
+	case CEL_AST_INDEX:
+		return eval_chain(ev, node, result);
+
+	case CEL_AST_CALL:
+		return eval_call(ev, node, result);
+
+	case CEL_AST_LIST:
+		return eval_list(ev, node, result);
+
+	case CEL_AST_MAP:
+		return eval_map(ev, node, result);
+
+	case CEL_AST_STRUCT:
+		cel_eval_report_error(ev->ctx, CEL_ERROR_UNSUPPORTED,
+				      "Struct literals not yet implemented");
+		return false;
+
+	case CEL_AST_COMPREHENSION:
+		return eval_comprehension(ev, node, result);
+
+	default:
+		cel_eval_report_error(ev->ctx, CEL_ERROR_INTERNAL,
+				      "Unknown AST node type");
+		return false;
+	}
+}
+
+static bool eval_node(compact_eval_t *ev, uint32_t index, cel_value_t *result)
+{
+	if (index == CEL_COMPACT_NONE) {
+		cel_eval_report_error(ev->ctx, CEL_ERROR_INTERNAL,
+				      "NULL AST node");
+		return false;
+	}
+
+	/* 每层递归消耗一层深度 (没有安装预算时不限制) */
+	cel_exec_budget_t *budget = ev->budget;
+	bool success;
+	if (!budget) {
+		success = eval_node_kind(ev, &ev->ast->nodes[index], result);
+	} else if (budget->depth_left == 0) {
+		cel_eval_report_error(ev->ctx, CEL_ERROR_OUT_OF_RANGE,
+				      "Maximum recursion depth exceeded");
+		success = false;
+	} else {
+		budget->depth_left--;
+		success = eval_node_kind(ev, &ev->ast->nodes[index], result);
+		budget->depth_left++;
+	}
+	if (success) {
+		return true;
+	}
+
+	/* 最内层失败的节点记录出错位置 */
+	cel_eval_error_locate(ev->ast->locs[index].line,
+			      ev->ast->locs[index].column);
+	return false;
+}
+
+bool cel_compact_eval(const cel_compact_ast_t *ast, cel_context_t *ctx,
+		      cel_value_t *result)
+{
+	if (!ast || !ctx || !result) {
+		return false;
+	}
+
+	compact_eval_t ev = {
+		.ast = ast,
+		.ctx = ctx,
+		.frame = NULL,
+		.budget = cel_exec_budget_current(),
+	};
+	return eval_node(&ev, 0, result);
+}
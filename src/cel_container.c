@@ -4,6 +4,7 @@
  */
 
 #include "cel/cel_value.h"
+#include "cel/cel_memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -84,11 +85,34 @@ static size_t cel_value_hash(const cel_value_t *value)
 	}
 }
 
+/**
+ * @brief 分配容器的内部存储 (与容器本身的分配方式一致)
+ *
+ * 临时分配区的容器只在安装了该分配区的线程上修改 (见 cel_memory.h)，
+ * 其内部存储同样从临时分配区分配，无法从中分配时返回 NULL。
+ */
+static void *storage_alloc(bool scratch, size_t size)
+{
+	if (!scratch) {
+		return malloc(size);
+	}
+
+	bool from_scratch;
+	void *ptr = arena_scratch_alloc(size, &from_scratch);
+	if (ptr && !from_scratch) {
+		free(ptr);
+		return NULL;
+	}
+	return ptr;
+}
+
 /* ========== 列表实现 ========== */
 
 cel_list_t *cel_list_create(size_t initial_capacity)
 {
-	cel_list_t *list = (cel_list_t *)malloc(sizeof(cel_list_t));
+	bool scratch;
+	cel_list_t *list =
+		(cel_list_t *)arena_scratch_alloc(sizeof(cel_list_t), &scratch);
 	if (!list) {
 		return NULL;
 	}
@@ -97,14 +121,15 @@ cel_list_t *cel_list_create(size_t initial_capacity)
 		initial_capacity = CEL_LIST_DEFAULT_CAPACITY;
 	}
 
-	list->items =
-		(cel_value_t **)malloc(initial_capacity * sizeof(cel_value_t *));
+	list->items = (cel_value_t **)storage_alloc(
+		scratch, initial_capacity * sizeof(cel_value_t *));
 	if (!list->items) {
-		free(list);
+		arena_scratch_free(list, scratch);
 		return NULL;
 	}
 
 	list->ref_count = 1;
+	list->scratch = scratch;
 	list->length = 0;
 	list->capacity = initial_capacity;
 
@@ -143,16 +168,17 @@ void cel_list_release(cel_list_t *list)
 	}
 #endif
 
-	/* 释放所有元素 */
+	/* 释放所有元素 (临时分配区的存储只释放元素的引用) */
+	bool scratch = list->scratch;
 	for (size_t i = 0; i < list->length; i++) {
 		if (list->items[i]) {
 			cel_value_destroy(list->items[i]);
-			free(list->items[i]);
+			arena_scratch_free(list->items[i], scratch);
 		}
 	}
 
-	free(list->items);
-	free(list);
+	arena_scratch_free(list->items, scratch);
+	arena_scratch_free(list, scratch);
 }
 
 bool cel_list_append(cel_list_t *list, cel_value_t *value)
@@ -164,8 +190,19 @@ bool cel_list_append(cel_list_t *list, cel_value_t *value)
 	/* 检查容量，需要时扩容 */
 	if (list->length >= list->capacity) {
 		size_t new_capacity = list->capacity * 2;
-		cel_value_t **new_items = (cel_value_t **)realloc(
-			list->items, new_capacity * sizeof(cel_value_t *));
+		cel_value_t **new_items;
+		if (list->scratch) {
+			/* 临时分配区不能扩展原有分配，复制到新的存储 */
+			new_items = (cel_value_t **)storage_alloc(
+				true, new_capacity * sizeof(cel_value_t *));
+			if (new_items) {
+				memcpy(new_items, list->items,
+				       list->length * sizeof(cel_value_t *));
+			}
+		} else {
+			new_items = (cel_value_t **)realloc(
+				list->items, new_capacity * sizeof(cel_value_t *));
+		}
 		if (!new_items) {
 			return false;
 		}
@@ -174,7 +211,8 @@ bool cel_list_append(cel_list_t *list, cel_value_t *value)
 	}
 
 	/* 创建值的副本 */
-	cel_value_t *copy = (cel_value_t *)malloc(sizeof(cel_value_t));
+	cel_value_t *copy =
+		(cel_value_t *)storage_alloc(list->scratch, sizeof(cel_value_t));
 	if (!copy) {
 		return false;
 	}
@@ -222,12 +260,14 @@ bool cel_list_set(cel_list_t *list, size_t index, cel_value_t *value)
 	cel_value_t *old_value = list->items[index];
 	if (old_value) {
 		cel_value_destroy(old_value);
-		free(old_value);
+		arena_scratch_free(old_value, list->scratch);
 	}
 
 	/* 创建新值的副本 */
-	cel_value_t *copy = (cel_value_t *)malloc(sizeof(cel_value_t));
+	cel_value_t *copy =
+		(cel_value_t *)storage_alloc(list->scratch, sizeof(cel_value_t));
 	if (!copy) {
+		list->items[index] = NULL;
 		return false;
 	}
 
@@ -264,7 +304,9 @@ size_t cel_list_size(const cel_list_t *list)
 
 cel_map_t *cel_map_create(size_t initial_bucket_count)
 {
-	cel_map_t *map = (cel_map_t *)malloc(sizeof(cel_map_t));
+	bool scratch;
+	cel_map_t *map =
+		(cel_map_t *)arena_scratch_alloc(sizeof(cel_map_t), &scratch);
 	if (!map) {
 		return NULL;
 	}
@@ -273,14 +315,16 @@ cel_map_t *cel_map_create(size_t initial_bucket_count)
 		initial_bucket_count = CEL_MAP_DEFAULT_BUCKET_COUNT;
 	}
 
-	map->buckets = (cel_map_entry_t **)calloc(initial_bucket_count,
-						   sizeof(cel_map_entry_t *));
+	map->buckets = (cel_map_entry_t **)storage_alloc(
+		scratch, initial_bucket_count * sizeof(cel_map_entry_t *));
 	if (!map->buckets) {
-		free(map);
+		arena_scratch_free(map, scratch);
 		return NULL;
 	}
+	memset(map->buckets, 0, initial_bucket_count * sizeof(cel_map_entry_t *));
 
 	map->ref_count = 1;
+	map->scratch = scratch;
 	map->size = 0;
 	map->bucket_count = initial_bucket_count;
 
@@ -320,6 +364,7 @@ void cel_map_release(cel_map_t *map)
 #endif
 
 	/* 释放所有桶中的条目 */
+	bool scratch = map->scratch;
 	for (size_t i = 0; i < map->bucket_count; i++) {
 		cel_map_entry_t *entry = map->buckets[i];
 		while (entry) {
@@ -328,20 +373,20 @@ void cel_map_release(cel_map_t *map)
 			/* 释放键和值 */
 			if (entry->key) {
 				cel_value_destroy(entry->key);
-				free(entry->key);
+				arena_scratch_free(entry->key, scratch);
 			}
 			if (entry->value) {
 				cel_value_destroy(entry->value);
-				free(entry->value);
+				arena_scratch_free(entry->value, scratch);
 			}
 
-			free(entry);
+			arena_scratch_free(entry, scratch);
 			entry = next;
 		}
 	}
 
-	free(map->buckets);
-	free(map);
+	arena_scratch_free(map->buckets, scratch);
+	arena_scratch_free(map, scratch);
 }
 
 bool cel_map_put(cel_map_t *map, cel_value_t *key, cel_value_t *value)
@@ -362,12 +407,12 @@ bool cel_map_put(cel_map_t *map, cel_value_t *key, cel_value_t *value)
 			cel_value_t *old_value = entry->value;
 			if (old_value) {
 				cel_value_destroy(old_value);
-				free(old_value);
+				arena_scratch_free(old_value, map->scratch);
 			}
 
 			/* 创建新值的副本 */
-			entry->value =
-				(cel_value_t *)malloc(sizeof(cel_value_t));
+			entry->value = (cel_value_t *)storage_alloc(
+				map->scratch, sizeof(cel_value_t));
 			if (!entry->value) {
 				return false;
 			}
@@ -397,16 +442,17 @@ bool cel_map_put(cel_map_t *map, cel_value_t *key, cel_value_t *value)
 	}
 
 	/* 键不存在，创建新条目 */
-	cel_map_entry_t *new_entry =
-		(cel_map_entry_t *)malloc(sizeof(cel_map_entry_t));
+	cel_map_entry_t *new_entry = (cel_map_entry_t *)storage_alloc(
+		map->scratch, sizeof(cel_map_entry_t));
 	if (!new_entry) {
 		return false;
 	}
 
 	/* 创建键的副本 */
-	new_entry->key = (cel_value_t *)malloc(sizeof(cel_value_t));
+	new_entry->key = (cel_value_t *)storage_alloc(map->scratch,
+						      sizeof(cel_value_t));
 	if (!new_entry->key) {
-		free(new_entry);
+		arena_scratch_free(new_entry, map->scratch);
 		return false;
 	}
 	memcpy(new_entry->key, key, sizeof(cel_value_t));
@@ -430,11 +476,12 @@ bool cel_map_put(cel_map_t *map, cel_value_t *key, cel_value_t *value)
 	}
 
 	/* 创建值的副本 */
-	new_entry->value = (cel_value_t *)malloc(sizeof(cel_value_t));
+	new_entry->value = (cel_value_t *)storage_alloc(map->scratch,
+							sizeof(cel_value_t));
 	if (!new_entry->value) {
 		cel_value_destroy(new_entry->key);
-		free(new_entry->key);
-		free(new_entry);
+		arena_scratch_free(new_entry->key, map->scratch);
+		arena_scratch_free(new_entry, map->scratch);
 		return false;
 	}
 	memcpy(new_entry->value, value, sizeof(cel_value_t));
@@ -514,14 +561,14 @@ bool cel_map_remove(cel_map_t *map, const cel_value_t *key)
 			/* 释放键和值 */
 			if (entry->key) {
 				cel_value_destroy(entry->key);
-				free(entry->key);
+				arena_scratch_free(entry->key, map->scratch);
 			}
 			if (entry->value) {
 				cel_value_destroy(entry->value);
-				free(entry->value);
+				arena_scratch_free(entry->value, map->scratch);
 			}
 
-			free(entry);
+			arena_scratch_free(entry, map->scratch);
 			map->size--;
 			return true;
 		}
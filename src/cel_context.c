@@ -114,6 +114,7 @@ static void cel_value_release_internal(cel_value_t *value)
 typedef struct {
 	char *name;	     /* 键 (变量名) */
 	cel_value_t *value;  /* 值 */
+	uint64_t version;    /* 版本 (每次赋值递增) */
 	UT_hash_handle hh;   /* uthash 句柄 */
 } cel_variable_entry_t;
 
@@ -147,6 +148,13 @@ struct cel_context {
 	size_t current_depth;	    /* 当前递归深度 */
 };
 
+/* 变量版本计数器 (所有上下文共享，版本不会重复) */
+#ifdef CEL_THREAD_SAFE
+static atomic_uint_fast64_t variable_version = 1;
+#else
+static uint64_t variable_version = 1;
+#endif
+
 /* ========== 辅助函数 ========== */
 
 static char *strdup_safe(const char *s)
@@ -298,6 +306,11 @@ cel_error_code_e cel_context_add_variable(cel_context_t *ctx, const char *name,
 				strlen(entry->name), entry);
 	}
 
+#ifdef CEL_THREAD_SAFE
+	entry->version = atomic_fetch_add(&variable_version, 1);
+#else
+	entry->version = variable_version++;
+#endif
 	return CEL_OK;
 }
 
@@ -328,6 +341,23 @@ cel_value_t *cel_context_get_variable(const cel_context_t *ctx,
 	return NULL;
 }
 
+uint64_t cel_context_get_variable_version(const cel_context_t *ctx,
+					  const char *name)
+{
+	if (!ctx || !name) {
+		return 0;
+	}
+
+	for (; ctx; ctx = ctx->parent) {
+		cel_variable_entry_t *entry = NULL;
+		HASH_FIND_STR(ctx->variables, name, entry);
+		if (entry) {
+			return entry->version;
+		}
+	}
+	return 0;
+}
+
 bool cel_context_has_variable(const cel_context_t *ctx, const char *name)
 {
 	return cel_context_get_variable(ctx, name) != NULL;
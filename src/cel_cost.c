@@ -0,0 +1,586 @@
+/**
+ * @file cel_cost.c
+ * @brief CEL 静态代价估算实现
+ *
+ * 对 AST 做一次抽象求值：每个节点得到代价区间以及结果长度区间
+ * (字符串/字节的字节数，列表/映射的元素数；标量为 0)。调用的代价由
+ * 参数长度区间得出，因此字符串函数的代价与声明的输入长度成正比；
+ * 推导式的代价为迭代次数乘以每次迭代的代价。
+ *
+ * 列表与映射另外记录元素 (映射的键与值) 的长度区间，来自字面量元素
+ * 与 map / filter 追加的元素表达式，推导式的循环变量按迭代范围的
+ * 元素长度估算；来源未知时使用默认最大长度。
+ *
+ * 推导式的累加器在迭代中可能增长 (例如 map 每次追加一个元素)。
+ * 先以初始值长度估算一次循环步骤，得到每次迭代的增长量，再以
+ * 增长后的最大长度重新估算，使依赖累加器长度的调用代价保持上界。
+ *
+ * 所有运算均为饱和运算，UINT64_MAX 表示无上界。
+ */
+
+#include "cel/cel_cost.h"
+#include "cel/cel_ast.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include <string.h>
+
+/* 字段路径的最大长度 (更长的路径不匹配任何声明) */
+#define COST_PATH_MAX 256
+
+/* string() 转换非字符串值时结果的最大长度 */
+#define COST_STRING_CONVERSION 32
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 区间 [min, max]
+ */
+typedef struct {
+	uint64_t min;
+	uint64_t max;
+} range_t;
+
+/**
+ * @brief 节点估算结果
+ */
+typedef struct {
+	range_t cost;    /* 求值代价 */
+	range_t size;    /* 结果长度 */
+	range_t element; /* 列表元素与映射键值的长度 (其他类型为 0) */
+} estimate_t;
+
+/**
+ * @brief 推导式变量作用域 (栈上链表)
+ */
+typedef struct scope {
+	const char *name;
+	size_t length;
+	range_t size;
+	range_t element;
+	const struct scope *parent;
+} scope_t;
+
+/**
+ * @brief 估算状态
+ */
+typedef struct {
+	const cel_cost_options_t *options;
+} estimator_t;
+
+static estimate_t estimate_node(const estimator_t *est,
+				const cel_ast_node_t *node,
+				const scope_t *scope);
+
+/* ========== 饱和运算 ========== */
+
+static uint64_t sat_add(uint64_t a, uint64_t b)
+{
+	return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+static uint64_t sat_mul(uint64_t a, uint64_t b)
+{
+	if (a == 0 || b == 0) {
+		return 0;
+	}
+	return a > UINT64_MAX / b ? UINT64_MAX : a * b;
+}
+
+static range_t range_add(range_t a, range_t b)
+{
+	return (range_t){sat_add(a.min, b.min), sat_add(a.max, b.max)};
+}
+
+static range_t range_exact(uint64_t value)
+{
+	return (range_t){value, value};
+}
+
+static uint64_t min_u64(uint64_t a, uint64_t b)
+{
+	return a < b ? a : b;
+}
+
+static uint64_t max_u64(uint64_t a, uint64_t b)
+{
+	return a > b ? a : b;
+}
+
+/**
+ * @brief 同时包含两个区间的最小区间
+ */
+static range_t range_union(range_t a, range_t b)
+{
+	return (range_t){min_u64(a.min, b.min), max_u64(a.max, b.max)};
+}
+
+/* ========== 输入长度 ========== */
+
+/**
+ * @brief 将标识符与字段访问链写成点分路径
+ *
+ * @return 路径长度，不是字段路径或超出缓冲区时返回 0
+ */
+static size_t field_path(const cel_ast_node_t *node, char *buffer,
+			 size_t capacity)
+{
+	if (node->type == CEL_AST_IDENT) {
+		size_t length = node->as.ident.length;
+		if (length >= capacity) {
+			return 0;
+		}
+		memcpy(buffer, node->as.ident.name, length);
+		return length;
+	}
+	if (node->type != CEL_AST_SELECT) {
+		return 0;
+	}
+
+	const cel_ast_select_t *select = &node->as.select;
+	size_t length = field_path(select->operand, buffer, capacity);
+	if (length == 0 || length + 1 + select->field_length >= capacity) {
+		return 0;
+	}
+	buffer[length++] = '.';
+	memcpy(buffer + length, select->field, select->field_length);
+	return length + select->field_length;
+}
+
+/**
+ * @brief 来源未知的长度 (默认最大长度)
+ */
+static range_t unknown_size(const estimator_t *est)
+{
+	return (range_t){0, est->options->default_max_size};
+}
+
+/**
+ * @brief 查找输入长度声明，未声明时使用默认最大长度
+ */
+static range_t declared_size(const estimator_t *est, const char *path,
+			     size_t length)
+{
+	const cel_cost_options_t *options = est->options;
+	for (size_t i = 0; i < options->hint_count; i++) {
+		const cel_size_hint_t *hint = &options->hints[i];
+		if (hint->name && strlen(hint->name) == length &&
+		    memcmp(hint->name, path, length) == 0) {
+			return (range_t){0, hint->max_size};
+		}
+	}
+	return unknown_size(est);
+}
+
+/**
+ * @brief 字面量值的长度
+ */
+static uint64_t value_size(const cel_value_t *value)
+{
+	switch (value->type) {
+	case CEL_TYPE_STRING:
+		return value->value.string_value->length;
+	case CEL_TYPE_BYTES:
+		return value->value.bytes_value->length;
+	case CEL_TYPE_LIST:
+		return value->value.list_value->length;
+	case CEL_TYPE_MAP:
+		return value->value.map_value->size;
+	default:
+		return 0;
+	}
+}
+
+/* 空区间 (与任一区间合并后为该区间) */
+static const range_t empty_range = {UINT64_MAX, 0};
+
+/**
+ * @brief 元素长度的合并结果 (没有元素时为 0)
+ */
+static range_t element_result(range_t element)
+{
+	return element.min > element.max ? range_exact(0) : element;
+}
+
+/**
+ * @brief 字面量列表元素与映射键值的长度
+ */
+static range_t value_element_size(const cel_value_t *value)
+{
+	range_t element = empty_range;
+	if (value->type == CEL_TYPE_LIST) {
+		const cel_list_t *list = value->value.list_value;
+		for (size_t i = 0; i < list->length; i++) {
+			element = range_union(
+				element, range_exact(value_size(list->items[i])));
+		}
+	} else if (value->type == CEL_TYPE_MAP) {
+		const cel_map_t *map = value->value.map_value;
+		for (size_t i = 0; i < map->bucket_count; i++) {
+			for (const cel_map_entry_t *entry = map->buckets[i]; entry;
+			     entry = entry->next) {
+				element = range_union(
+					element, range_exact(value_size(entry->key)));
+				element = range_union(
+					element, range_exact(value_size(entry->value)));
+			}
+		}
+	}
+	return element_result(element);
+}
+
+/* ========== 节点估算 ========== */
+
+static estimate_t estimate_ident(const estimator_t *est,
+				 const cel_ast_ident_t *ident,
+				 const scope_t *scope)
+{
+	estimate_t result = {range_exact(0), range_exact(0), range_exact(0)};
+
+	/* 推导式变量遮蔽同名输入 */
+	for (; scope; scope = scope->parent) {
+		if (scope->length == ident->length &&
+		    memcmp(scope->name, ident->name, ident->length) == 0) {
+			result.size = scope->size;
+			result.element = scope->element;
+			return result;
+		}
+	}
+
+	result.size = declared_size(est, ident->name, ident->length);
+	result.element = unknown_size(est);
+	return result;
+}
+
+static estimate_t estimate_select(const estimator_t *est,
+				  const cel_ast_node_t *node,
+				  const scope_t *scope)
+{
+	estimate_t result = estimate_node(est, node->as.select.operand, scope);
+
+	/* 根标识符为推导式变量时路径声明不适用 */
+	const cel_ast_node_t *root = node;
+	while (root->type == CEL_AST_SELECT) {
+		root = root->as.select.operand;
+	}
+	bool shadowed = false;
+	if (root->type == CEL_AST_IDENT) {
+		for (const scope_t *s = scope; s; s = s->parent) {
+			if (s->length == root->as.ident.length &&
+			    memcmp(s->name, root->as.ident.name, s->length) == 0) {
+				shadowed = true;
+				break;
+			}
+		}
+	}
+
+	char path[COST_PATH_MAX];
+	size_t length = shadowed ? 0 : field_path(node, path, sizeof(path));
+	result.size = length ? declared_size(est, path, length)
+			     : unknown_size(est);
+	result.element = unknown_size(est);
+	return result;
+}
+
+static estimate_t estimate_binary(const estimator_t *est,
+				  const cel_ast_binary_t *binary,
+				  const scope_t *scope)
+{
+	estimate_t left = estimate_node(est, binary->left, scope);
+	estimate_t right = estimate_node(est, binary->right, scope);
+	estimate_t result = {range_add(left.cost, right.cost), range_exact(0),
+			     range_exact(0)};
+
+	switch (binary->op) {
+	case CEL_BINARY_AND:
+	case CEL_BINARY_OR:
+		/* 短路时右操作数不求值 */
+		result.cost.min = left.cost.min;
+		break;
+	case CEL_BINARY_ADD:
+		/* 字符串 / 列表拼接 */
+		result.size = range_add(left.size, right.size);
+		result.element = range_union(left.element, right.element);
+		break;
+	default:
+		break;
+	}
+	return result;
+}
+
+static estimate_t estimate_ternary(const estimator_t *est,
+				   const cel_ast_ternary_t *ternary,
+				   const scope_t *scope)
+{
+	estimate_t condition = estimate_node(est, ternary->condition, scope);
+	estimate_t if_true = estimate_node(est, ternary->if_true, scope);
+	estimate_t if_false = estimate_node(est, ternary->if_false, scope);
+
+	range_t branch_cost = {min_u64(if_true.cost.min, if_false.cost.min),
+			       max_u64(if_true.cost.max, if_false.cost.max)};
+	estimate_t result;
+	result.cost = range_add(condition.cost, branch_cost);
+	result.size = range_union(if_true.size, if_false.size);
+	result.element = range_union(if_true.element, if_false.element);
+	return result;
+}
+
+/**
+ * @brief 调用结果的长度
+ *
+ * 内置函数除 string() 外都返回标量；上下文函数的结果与元素长度
+ * 未知，使用默认最大长度。
+ */
+static void call_result_size(const estimator_t *est,
+			     const cel_ast_call_t *call, size_t arg_count,
+			     const estimate_t *first, estimate_t *result)
+{
+	cel_function_id_e id;
+	if (!cel_builtin_resolve(call->function, call->function_length,
+				 call->target != NULL, arg_count, &id)) {
+		result->size = unknown_size(est);
+		result->element = unknown_size(est);
+	} else if (id == CEL_FUNC_STRING) {
+		result->size = (range_t){0, max_u64(first->size.max,
+						    COST_STRING_CONVERSION)};
+	}
+}
+
+static estimate_t estimate_call(const estimator_t *est,
+				const cel_ast_call_t *call,
+				const scope_t *scope)
+{
+	estimate_t result = {range_exact(CEL_COST_CALL), range_exact(0),
+			     range_exact(0)};
+	range_t arg_size = range_exact(0);
+	estimate_t first = {range_exact(0), range_exact(0), range_exact(0)};
+	size_t arg_count = call->arg_count;
+
+	/* 接收者作为第一个参数 */
+	if (call->target) {
+		first = estimate_node(est, call->target, scope);
+		result.cost = range_add(result.cost, first.cost);
+		arg_size = range_add(arg_size, first.size);
+		arg_count++;
+	}
+
+	for (size_t i = 0; i < call->arg_count; i++) {
+		estimate_t arg = estimate_node(est, call->args[i], scope);
+		if (i == 0 && !call->target) {
+			first = arg;
+		}
+		result.cost = range_add(result.cost, arg.cost);
+		arg_size = range_add(arg_size, arg.size);
+	}
+
+	/* 参数长度的代价 (正则匹配的模式是字面量参数，同样计入) */
+	result.cost.min = sat_add(result.cost.min,
+				  arg_size.min / CEL_COST_SIZE_UNIT);
+	result.cost.max = sat_add(result.cost.max,
+				  arg_size.max == UINT64_MAX
+					  ? UINT64_MAX
+					  : arg_size.max / CEL_COST_SIZE_UNIT);
+
+	call_result_size(est, call, arg_count, &first, &result);
+	return result;
+}
+
+/**
+ * @brief 估算推导式中依赖累加器的部分
+ */
+static void estimate_loop(const estimator_t *est,
+			  const cel_ast_comprehension_t *comp,
+			  const scope_t *outer, const scope_t *iter_scope,
+			  range_t accu_size, range_t accu_element,
+			  estimate_t *condition, estimate_t *step,
+			  estimate_t *result)
+{
+	scope_t accu = {comp->accu_var, comp->accu_var_length, accu_size,
+			accu_element, iter_scope};
+	*condition = estimate_node(est, comp->loop_cond, &accu);
+	*step = estimate_node(est, comp->loop_step, &accu);
+	/* 结果表达式中只有累加器可见 */
+	accu.parent = outer;
+	*result = estimate_node(est, comp->result, &accu);
+}
+
+static estimate_t estimate_comprehension(const estimator_t *est,
+					 const cel_ast_comprehension_t *comp,
+					 const scope_t *scope)
+{
+	estimate_t range = estimate_node(est, comp->iter_range, scope);
+	estimate_t init = estimate_node(est, comp->accu_init, scope);
+
+	/*
+	 * 循环变量为迭代范围的元素、映射的键或值 (双变量迭代列表时第一个
+	 * 变量为下标)，长度不超过迭代范围的元素长度；元素的元素长度未知
+	 */
+	range_t element = {0, range.element.max};
+	scope_t iter2 = {comp->iter_var2, comp->iter_var2_length, element,
+			 unknown_size(est), scope};
+	scope_t iter = {comp->iter_var, comp->iter_var_length, element,
+			unknown_size(est), comp->iter_var2 ? &iter2 : scope};
+
+	/* 循环条件可能提前结束迭代，只有恒为 true 时才一定遍历全部元素 */
+	const cel_ast_node_t *cond = comp->loop_cond;
+	bool always = cond->type == CEL_AST_LITERAL &&
+		      cond->as.literal.value.type == CEL_TYPE_BOOL &&
+		      cond->as.literal.value.value.bool_value;
+	range_t iterations = {always ? range.size.min : 0, range.size.max};
+
+	estimate_t condition, step, result;
+	estimate_loop(est, comp, scope, &iter, init.size, init.element,
+		      &condition, &step, &result);
+
+	/*
+	 * 累加器增长: 按每次迭代的增长量放大、元素长度合并追加的元素后
+	 * 重新估算；追加的元素依赖累加器时元素长度仍可能增长，按无上界处理
+	 */
+	if (step.size.max > init.size.max || step.element.max > init.element.max) {
+		uint64_t growth = step.size.max > init.size.max ?
+					  step.size.max - init.size.max :
+					  0;
+		range_t accu_size = {min_u64(init.size.min, step.size.min),
+				     sat_add(init.size.max,
+					     sat_mul(iterations.max, growth))};
+		range_t accu_element = range_union(init.element, step.element);
+		estimate_loop(est, comp, scope, &iter, accu_size, accu_element,
+			      &condition, &step, &result);
+		if (step.element.max > accu_element.max) {
+			accu_element.max = UINT64_MAX;
+			estimate_loop(est, comp, scope, &iter, accu_size,
+				      accu_element, &condition, &step, &result);
+		}
+	}
+
+	range_t per_iteration = range_add(range_exact(CEL_COST_ITERATION),
+					  range_add(condition.cost, step.cost));
+
+	estimate_t total;
+	total.cost = range_add(range.cost, init.cost);
+	total.cost.min = sat_add(total.cost.min,
+				 sat_mul(iterations.min, per_iteration.min));
+	total.cost.max = sat_add(total.cost.max,
+				 sat_mul(iterations.max, per_iteration.max));
+	total.cost = range_add(total.cost, result.cost);
+	total.size = result.size;
+	total.element = result.element;
+	return total;
+}
+
+static estimate_t estimate_node(const estimator_t *est,
+				const cel_ast_node_t *node,
+				const scope_t *scope)
+{
+	estimate_t result = {range_exact(0), range_exact(0), range_exact(0)};
+	if (!node) {
+		return result;
+	}
+
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		result.size = range_exact(value_size(&node->as.literal.value));
+		result.element = value_element_size(&node->as.literal.value);
+		return result;
+
+	case CEL_AST_IDENT:
+		return estimate_ident(est, &node->as.ident, scope);
+
+	case CEL_AST_UNARY:
+		result.cost = estimate_node(est, node->as.unary.operand, scope).cost;
+		return result;
+
+	case CEL_AST_BINARY:
+		return estimate_binary(est, &node->as.binary, scope);
+
+	case CEL_AST_TERNARY:
+		return estimate_ternary(est, &node->as.ternary, scope);
+
+	case CEL_AST_SELECT:
+		return estimate_select(est, node, scope);
+
+	case CEL_AST_INDEX: {
+		estimate_t operand = estimate_node(est, node->as.index.operand, scope);
+		estimate_t index = estimate_node(est, node->as.index.index, scope);
+		result.cost = range_add(operand.cost, index.cost);
+		result.size = (range_t){0, operand.element.max};
+		result.element = unknown_size(est);
+		return result;
+	}
+
+	case CEL_AST_CALL:
+		return estimate_call(est, &node->as.call, scope);
+
+	case CEL_AST_LIST: {
+		range_t element = empty_range;
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			estimate_t item =
+				estimate_node(est, node->as.list.elements[i], scope);
+			result.cost = range_add(result.cost, item.cost);
+			element = range_union(element, item.size);
+		}
+		result.size = range_exact(node->as.list.element_count);
+		result.element = element_result(element);
+		return result;
+	}
+
+	case CEL_AST_MAP: {
+		range_t element = empty_range;
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			const cel_ast_map_entry_t *entry = &node->as.map.entries[i];
+			estimate_t key = estimate_node(est, entry->key, scope);
+			estimate_t value = estimate_node(est, entry->value, scope);
+			result.cost = range_add(result.cost, key.cost);
+			result.cost = range_add(result.cost, value.cost);
+			element = range_union(element, key.size);
+			element = range_union(element, value.size);
+		}
+		result.size = range_exact(node->as.map.entry_count);
+		result.element = element_result(element);
+		return result;
+	}
+
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			result.cost = range_add(
+				result.cost,
+				estimate_node(est, node->as.struct_lit.fields[i].value,
+					      scope).cost);
+		}
+		result.size = range_exact(node->as.struct_lit.field_count);
+		return result;
+
+	case CEL_AST_COMPREHENSION:
+		return estimate_comprehension(est, &node->as.comprehension, scope);
+	}
+
+	return result;
+}
+
+/* ========== 代价估算 API ========== */
+
+cel_cost_options_t cel_default_cost_options(void)
+{
+	cel_cost_options_t options = {
+		.hints = NULL,
+		.hint_count = 0,
+		.default_max_size = UINT64_MAX,
+	};
+	return options;
+}
+
+cel_error_code_e cel_program_estimate_cost(const cel_program_t *program,
+					   const cel_cost_options_t *options,
+					   cel_cost_estimate_t *estimate)
+{
+	if (!program || !program->ast || !estimate) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	cel_cost_options_t defaults = cel_default_cost_options();
+	estimator_t est = {options ? options : &defaults};
+
+	estimate_t result = estimate_node(&est, program->ast, NULL);
+	estimate->min = result.cost.min;
+	estimate->max = result.cost.max;
+	return CEL_OK;
+}
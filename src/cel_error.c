@@ -76,6 +76,10 @@ const char *cel_error_code_string(cel_error_code_e code)
 		return "CEL_ERROR_ALREADY_EXISTS";
 	case CEL_ERROR_UNSUPPORTED:
 		return "CEL_ERROR_UNSUPPORTED";
+	case CEL_ERROR_TIMEOUT:
+		return "CEL_ERROR_TIMEOUT";
+	case CEL_ERROR_COST_LIMIT:
+		return "CEL_ERROR_COST_LIMIT";
 	case CEL_ERROR_INTERNAL:
 		return "CEL_ERROR_INTERNAL";
 	case CEL_ERROR_UNKNOWN:
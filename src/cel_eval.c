@@ -1,20 +1,23 @@
 /**
  * @file cel_eval.c
  * @brief CEL 求值器实现
+ *
+ * 所有求值函数写入 result 的值都由调用者持有 (新引用)，
+ * 调用者使用完毕后需要对其调用 cel_value_destroy。
  */
 
-#define _GNU_SOURCE  /* for timegm */
+#define _GNU_SOURCE  /* for strndup */
 
 #include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#ifdef CEL_ENABLE_REGEX
-#define PCRE2_CODE_UNIT_WIDTH 8
-#include <pcre2.h>
+#ifdef CEL_THREAD_SAFE
+#include <stdatomic.h>
 #endif
 
 /* strndup 可能不在某些平台上可用 */
@@ -34,20 +37,91 @@ static char *strndup(const char *s, size_t n)
 }
 #endif
 
+/* 函数调用参数的栈上缓冲区大小，超过时使用堆分配 */
+#define EVAL_INLINE_ARGS 8
+
+/* 变量名与函数名的栈上缓冲区大小，超过时使用堆分配 */
+#define EVAL_INLINE_NAME 64
+
+/* 左深链的栈上缓冲区大小 (链上的节点数)，超过时使用堆分配 */
+#define EVAL_INLINE_CHAIN 16
+
+/* 设置截止时间时，每隔多少次预算检查读取一次时钟 */
+#define BUDGET_CLOCK_INTERVAL 64
+
+/* 并行推导式中工作线程每次领取的元素数量 */
+#define PARALLEL_CHUNK 256
+
+/* ========== 推导式变量帧 ========== */
+
+/**
+ * @brief 推导式变量帧
+ *
+ * 循环变量与累加器绑定在推导式求值函数栈上的帧中，每次迭代原地
+ * 覆盖，不创建子上下文，也不复制变量名。嵌套推导式的帧通过线程
+ * 局部链表串联，内层遮蔽外层；标识符求值时先于上下文变量查找。
+ */
+typedef struct eval_frame {
+	const char *iter_var;            /* 循环变量名 */
+	size_t iter_var_length;          /* 循环变量名长度 */
+	const cel_value_t *iter_value;   /* 当前元素或键 (由迭代范围持有，NULL 表示不可见) */
+	const char *iter_var2;           /* 第二个循环变量名 (可为 NULL) */
+	size_t iter_var2_length;         /* 第二个循环变量名长度 */
+	const cel_value_t *iter_value2;  /* 当前元素或 Map 的值 */
+	cel_value_t index;               /* 双变量列表迭代的当前下标 */
+	const char *accu_var;            /* 累加器变量名 */
+	size_t accu_var_length;          /* 累加器变量名长度 */
+	cel_value_t accu_value;          /* 累加器的值 (帧持有) */
+	const struct eval_frame *parent; /* 外层推导式的帧 */
+} eval_frame_t;
+
+static _Thread_local const eval_frame_t *current_frame = NULL;
+
+/**
+ * @brief 在推导式帧中查找变量
+ *
+ * @return 绑定的值，不是推导式变量时返回 NULL
+ */
+static const cel_value_t *frame_lookup(const char *name, size_t length)
+{
+	for (const eval_frame_t *frame = current_frame; frame;
+	     frame = frame->parent) {
+		if (frame->iter_value) {
+			if (frame->iter_var2 && frame->iter_var2_length == length &&
+			    memcmp(frame->iter_var2, name, length) == 0) {
+				return frame->iter_value2;
+			}
+			if (frame->iter_var_length == length &&
+			    memcmp(frame->iter_var, name, length) == 0) {
+				return frame->iter_value;
+			}
+		}
+		if (frame->accu_var_length == length &&
+		    memcmp(frame->accu_var, name, length) == 0) {
+			return &frame->accu_value;
+		}
+	}
+	return NULL;
+}
+
 /* ========== 前向声明 ========== */
 
 static bool eval_node(const cel_ast_node_t *node, cel_context_t *ctx,
 		      cel_value_t *result);
+static bool eval_ident(const cel_ast_ident_t *ident, cel_context_t *ctx,
+		       cel_value_t *result);
 static bool eval_unary(const cel_ast_unary_t *unary, cel_context_t *ctx,
 			cel_value_t *result);
-static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
+static bool eval_logical(const cel_ast_node_t *node, cel_context_t *ctx,
 			 cel_value_t *result);
+static bool eval_chain(const cel_ast_node_t *node, cel_context_t *ctx,
+		       cel_value_t *result);
 static bool eval_ternary(const cel_ast_ternary_t *ternary, cel_context_t *ctx,
 			  cel_value_t *result);
-static bool eval_select(const cel_ast_select_t *select, cel_context_t *ctx,
-			 cel_value_t *result);
-static bool eval_index(const cel_ast_index_t *index, cel_context_t *ctx,
-			cel_value_t *result);
+static bool select_link(const cel_ast_select_t *select, cel_context_t *ctx,
+			const cel_value_t *operand, cel_value_t *result);
+static bool index_link(const cel_ast_index_t *index, cel_context_t *ctx,
+		       const cel_value_t *operand, cel_value_t *result);
 static bool eval_call(const cel_ast_call_t *call, cel_context_t *ctx,
 		      cel_value_t *result);
 static bool eval_list(const cel_ast_list_t *list, cel_context_t *ctx,
@@ -56,8 +130,21 @@ static bool eval_map(const cel_ast_map_t *map, cel_context_t *ctx,
 		     cel_value_t *result);
 static bool eval_comprehension(const cel_ast_comprehension_t *comp,
 				 cel_context_t *ctx, cel_value_t *result);
+static bool eval_parallel(const cel_ast_comprehension_t *comp,
+			  cel_context_t *ctx, eval_frame_t *frame,
+			  cel_list_t *list, size_t *resume);
 
-static void set_error(cel_context_t *ctx, const char *message);
+/* 当前线程的错误通道 (NULL 表示丢弃错误) */
+static _Thread_local cel_eval_error_t *current_error = NULL;
+
+/* 当前线程正在执行的预算 (没有执行时为 NULL) */
+static _Thread_local cel_exec_budget_t *current_budget = NULL;
+
+static void set_error(cel_context_t *ctx, cel_error_code_e code,
+		      const char *message);
+static void set_error_detail(cel_context_t *ctx, cel_error_code_e code,
+			     const char *message, const char *detail,
+			     size_t detail_length);
 
 /* ========== 求值主函数 ========== */
 
@@ -70,66 +157,49 @@ bool cel_eval(const cel_ast_node_t *ast, cel_context_t *ctx,
 
 	/* TODO: 添加错误清除逻辑 */
 
-	return eval_node(ast, ctx, result);
+	/* 外层求值 (例如上下文函数内部嵌套的求值) 的推导式变量不可见 */
+	const eval_frame_t *outer = current_frame;
+	current_frame = NULL;
+	bool success = eval_node(ast, ctx, result);
+	current_frame = outer;
+	return success;
 }
 
 /* ========== 节点求值 ========== */
 
-static bool eval_node(const cel_ast_node_t *node, cel_context_t *ctx,
-		      cel_value_t *result)
+static bool eval_node_kind(const cel_ast_node_t *node, cel_context_t *ctx,
+			   cel_value_t *result)
 {
 	if (!node) {
-		set_error(ctx, "NULL AST node");
+		set_error(ctx, CEL_ERROR_INTERNAL, "NULL AST node");
 		return false;
 	}
 
 	switch (node->type) {
 	case CEL_AST_LITERAL:
-		/* 字面量直接返回值 */
-		*result = node->as.literal.value;
+		/* 字面量返回共享引用 */
+		*result = cel_value_retain(&node->as.literal.value);
 		return true;
 
-	case CEL_AST_IDENT: {
-		/* 标识符查找变量 */
-		/* 构造 null 结尾的变量名 */
-		char *var_name = strndup(node->as.ident.name, node->as.ident.length);
-		if (!var_name) {
-			set_error(ctx, "Out of memory");
-			return false;
-		}
-
-		cel_value_t *value = cel_context_get_variable(ctx, var_name);
-		free(var_name);
-
-		if (!value) {
-			char error_msg[256];
-			snprintf(error_msg, sizeof(error_msg),
-				 "Undefined variable: %.*s",
-				 (int)node->as.ident.length,
-				 node->as.ident.name);
-			set_error(ctx, error_msg);
-			return false;
-		}
-
-		/* 复制值 */
-		*result = *value;
-		return true;
-	}
+	case CEL_AST_IDENT:
+		return eval_ident(&node->as.ident, ctx, result);
 
 	case CEL_AST_UNARY:
 		return eval_unary(&node->as.unary, ctx, result);
 
 	case CEL_AST_BINARY:
-		return eval_binary(&node->as.binary, ctx, result);
+		if (node->as.binary.op == CEL_BINARY_AND ||
+		    node->as.binary.op == CEL_BINARY_OR) {
+			return eval_logical(node, ctx, result);
+		}
+		return eval_chain(node, ctx, result);
 
 	case CEL_AST_TERNARY:
 		return eval_ternary(&node->as.ternary, ctx, result);
 
 	case CEL_AST_SELECT:
-		return eval_select(&node->as.select, ctx, result);
-
 	case CEL_AST_INDEX:
-		return eval_index(&node->as.index, ctx, result);
+		return eval_chain(node, ctx, result);
 
 	case CEL_AST_CALL:
 		return eval_call(&node->as.call, ctx, result);
@@ -141,114 +211,282 @@ static bool eval_node(const cel_ast_node_t *node, cel_context_t *ctx,
 		return eval_map(&node->as.map, ctx, result);
 
 	case CEL_AST_STRUCT:
-		set_error(ctx, "Struct literals not yet implemented");
+		set_error(ctx, CEL_ERROR_UNSUPPORTED,
+			  "Struct literals not yet implemented");
 		return false;
 
 	case CEL_AST_COMPREHENSION:
 		return eval_comprehension(&node->as.comprehension, ctx, result);
 
 	default:
-		set_error(ctx, "Unknown AST node type");
+		set_error(ctx, CEL_ERROR_INTERNAL, "Unknown AST node type");
 		return false;
 	}
 }
 
-/* ========== 一元运算求值 ========== */
+static bool eval_node(const cel_ast_node_t *node, cel_context_t *ctx,
+		      cel_value_t *result)
+{
+	/* 每层递归消耗一层深度 (没有安装预算时不限制) */
+	cel_exec_budget_t *budget = current_budget;
+	bool success;
+	if (!budget) {
+		success = eval_node_kind(node, ctx, result);
+	} else if (budget->depth_left == 0) {
+		set_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+			  "Maximum recursion depth exceeded");
+		success = false;
+	} else {
+		budget->depth_left--;
+		success = eval_node_kind(node, ctx, result);
+		budget->depth_left++;
+	}
+	if (success) {
+		return true;
+	}
+
+	/* 最内层失败的节点记录出错位置 */
+	if (node) {
+		cel_eval_error_locate(node->loc.line, node->loc.column);
+	}
+	return false;
+}
+
+/* ========== 标识符求值 ========== */
 
-static bool eval_unary(const cel_ast_unary_t *unary, cel_context_t *ctx,
-			cel_value_t *result)
+static bool eval_ident(const cel_ast_ident_t *ident, cel_context_t *ctx,
+		       cel_value_t *result)
 {
-	cel_value_t operand;
-	if (!eval_node(unary->operand, ctx, &operand)) {
+	/* 推导式变量遮蔽上下文变量 */
+	const cel_value_t *bound = frame_lookup(ident->name, ident->length);
+	if (bound) {
+		*result = cel_value_retain(bound);
+		return true;
+	}
+
+	/* 构造 null 结尾的变量名 (短名称使用栈缓冲区) */
+	char local_name[EVAL_INLINE_NAME];
+	char *var_name = local_name;
+	if (ident->length < sizeof(local_name)) {
+		memcpy(local_name, ident->name, ident->length);
+		local_name[ident->length] = '\0';
+	} else {
+		var_name = strndup(ident->name, ident->length);
+		if (!var_name) {
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Out of memory");
+			return false;
+		}
+	}
+
+	cel_value_t *value = cel_context_get_variable(ctx, var_name);
+	if (var_name != local_name) {
+		free(var_name);
+	}
+
+	if (!value) {
+		set_error_detail(ctx, CEL_ERROR_UNKNOWN_IDENTIFIER,
+				 "Undefined variable", ident->name,
+				 ident->length);
 		return false;
 	}
 
-	switch (unary->op) {
+	/* 共享变量值 */
+	*result = cel_value_retain(value);
+	return true;
+}
+
+/* ========== 一元运算 ========== */
+
+bool cel_eval_unary_op(cel_context_t *ctx, cel_unary_op_e op,
+		       const cel_value_t *operand, cel_value_t *result)
+{
+	switch (op) {
 	case CEL_UNARY_NEG:
 		/* 取负 */
-		if (operand.type == CEL_TYPE_INT) {
-			*result = cel_value_int(-operand.value.int_value);
+		if (operand->type == CEL_TYPE_INT) {
+			*result = cel_value_int(-operand->value.int_value);
 			return true;
-		} else if (operand.type == CEL_TYPE_DOUBLE) {
-			*result = cel_value_double(-operand.value.double_value);
+		} else if (operand->type == CEL_TYPE_DOUBLE) {
+			*result = cel_value_double(-operand->value.double_value);
 			return true;
 		} else {
-			set_error(ctx, "Negation requires numeric operand");
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "Negation requires numeric operand");
 			return false;
 		}
 
 	case CEL_UNARY_NOT:
 		/* 逻辑非 */
-		if (operand.type == CEL_TYPE_BOOL) {
-			*result = cel_value_bool(!operand.value.bool_value);
+		if (operand->type == CEL_TYPE_BOOL) {
+			*result = cel_value_bool(!operand->value.bool_value);
 			return true;
 		} else {
-			set_error(ctx, "Logical NOT requires boolean operand");
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "Logical NOT requires boolean operand");
 			return false;
 		}
 
 	default:
-		set_error(ctx, "Unknown unary operator");
+		set_error(ctx, CEL_ERROR_INTERNAL, "Unknown unary operator");
+		return false;
+	}
+}
+
+static bool eval_unary(const cel_ast_unary_t *unary, cel_context_t *ctx,
+			cel_value_t *result)
+{
+	cel_value_t operand;
+	if (!eval_node(unary->operand, ctx, &operand)) {
 		return false;
 	}
+
+	bool success = cel_eval_unary_op(ctx, unary->op, &operand, result);
+	cel_value_destroy(&operand);
+	return success;
 }
 
-/* ========== 二元运算求值 ========== */
+/* ========== 二元运算 ========== */
 
-static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
-			 cel_value_t *result)
+/**
+ * @brief 列表连接
+ */
+static bool list_concat(cel_context_t *ctx, cel_list_t *left_list,
+			cel_list_t *right_list, cel_value_t *result)
 {
-	cel_value_t left, right;
+	/* 创建新列表 */
+	size_t left_size = cel_list_size(left_list);
+	size_t right_size = cel_list_size(right_list);
+	cel_list_t *new_list = cel_list_create(left_size + right_size);
+
+	if (!new_list) {
+		set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+			  "Failed to create list for concatenation");
+		return false;
+	}
 
-	/* 短路求值 */
-	if (binary->op == CEL_BINARY_AND || binary->op == CEL_BINARY_OR) {
-		if (!eval_node(binary->left, ctx, &left)) {
+	/* 复制左列表元素 */
+	for (size_t i = 0; i < left_size; i++) {
+		cel_value_t *elem = cel_list_get(left_list, i);
+		if (!elem) {
+			cel_list_release(new_list);
+			set_error(ctx, CEL_ERROR_INTERNAL,
+				  "Failed to get element from left list");
 			return false;
 		}
-
-		if (left.type != CEL_TYPE_BOOL) {
-			set_error(ctx, "Logical operator requires boolean operands");
+		if (!cel_list_append(new_list, elem)) {
+			cel_list_release(new_list);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Failed to append element to new list");
 			return false;
 		}
+	}
 
-		/* 短路 */
-		if (binary->op == CEL_BINARY_AND && !left.value.bool_value) {
-			*result = cel_value_bool(false);
-			return true;
+	/* 复制右列表元素 */
+	for (size_t i = 0; i < right_size; i++) {
+		cel_value_t *elem = cel_list_get(right_list, i);
+		if (!elem) {
+			cel_list_release(new_list);
+			set_error(ctx, CEL_ERROR_INTERNAL,
+				  "Failed to get element from right list");
+			return false;
 		}
-		if (binary->op == CEL_BINARY_OR && left.value.bool_value) {
-			*result = cel_value_bool(true);
-			return true;
+		if (!cel_list_append(new_list, elem)) {
+			cel_list_release(new_list);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Failed to append element to new list");
+			return false;
 		}
+	}
+
+	result->type = CEL_TYPE_LIST;
+	result->value.list_value = new_list;
+	return true;
+}
 
-		if (!eval_node(binary->right, ctx, &right)) {
+bool cel_eval_list_append(cel_context_t *ctx, cel_value_t *accu,
+			  cel_value_t *element)
+{
+	if (accu->type != CEL_TYPE_LIST) {
+		/* 非列表累加器按通用的 + 运算处理 */
+		cel_list_t *single = cel_list_create(1);
+		if (!single || !cel_list_append(single, element)) {
+			cel_list_release(single);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Failed to create list for concatenation");
 			return false;
 		}
-
-		if (right.type != CEL_TYPE_BOOL) {
-			set_error(ctx, "Logical operator requires boolean operands");
+		cel_value_t right = cel_value_list(single);
+		cel_value_t sum;
+		bool success = cel_eval_binary_op(ctx, CEL_BINARY_ADD, accu, &right,
+						  &sum);
+		cel_value_destroy(&right);
+		if (success) {
+			cel_value_destroy(accu);
+			*accu = sum;
+		}
+		return success;
+	}
+
+	/* 累加器被共享时复制一次，此后独占 */
+	cel_list_t *list = accu->value.list_value;
+	if (list->ref_count != 1) {
+		size_t size = cel_list_size(list);
+		cel_list_t *copy = cel_list_create(size * 2 + 1);
+		if (!copy) {
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Failed to create list for concatenation");
 			return false;
 		}
-
-		*result = cel_value_bool(right.value.bool_value);
-		return true;
+		for (size_t i = 0; i < size; i++) {
+			if (!cel_list_append(copy, list->items[i])) {
+				cel_list_release(copy);
+				set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+					  "Failed to append element to new list");
+				return false;
+			}
+		}
+		cel_value_destroy(accu);
+		*accu = cel_value_list(copy);
+		list = copy;
 	}
 
-	/* 普通二元运算 */
-	if (!eval_node(binary->left, ctx, &left)) {
+	if (!cel_list_append(list, element)) {
+		set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+			  "Failed to append element to new list");
 		return false;
 	}
-	if (!eval_node(binary->right, ctx, &right)) {
-		return false;
+	return true;
+}
+
+bool cel_eval_binary_op(cel_context_t *ctx, cel_binary_op_e op,
+			const cel_value_t *left, const cel_value_t *right,
+			cel_value_t *result)
+{
+	/* 逻辑运算 (两侧均已求值) */
+	if (op == CEL_BINARY_AND || op == CEL_BINARY_OR) {
+		if (left->type != CEL_TYPE_BOOL || right->type != CEL_TYPE_BOOL) {
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "Logical operator requires boolean operands");
+			return false;
+		}
+		if (op == CEL_BINARY_AND) {
+			*result = cel_value_bool(left->value.bool_value &&
+						 right->value.bool_value);
+		} else {
+			*result = cel_value_bool(left->value.bool_value ||
+						 right->value.bool_value);
+		}
+		return true;
 	}
 
 	/* 算术运算 */
-	if (binary->op >= CEL_BINARY_ADD && binary->op <= CEL_BINARY_MOD) {
-		if (left.type == CEL_TYPE_INT && right.type == CEL_TYPE_INT) {
-			int64_t l = left.value.int_value;
-			int64_t r = right.value.int_value;
+	if (op >= CEL_BINARY_ADD && op <= CEL_BINARY_MOD) {
+		if (left->type == CEL_TYPE_INT && right->type == CEL_TYPE_INT) {
+			int64_t l = left->value.int_value;
+			int64_t r = right->value.int_value;
 
-			switch (binary->op) {
+			switch (op) {
 			case CEL_BINARY_ADD:
 				*result = cel_value_int(l + r);
 				return true;
@@ -260,14 +498,26 @@ static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
 				return true;
 			case CEL_BINARY_DIV:
 				if (r == 0) {
-					set_error(ctx, "Division by zero");
+					set_error(ctx, CEL_ERROR_DIVISION_BY_ZERO,
+						  "Division by zero");
+					return false;
+				}
+				if (r == -1 && l == INT64_MIN) {
+					set_error(ctx, CEL_ERROR_OVERFLOW,
+						  "Integer overflow");
 					return false;
 				}
 				*result = cel_value_int(l / r);
 				return true;
 			case CEL_BINARY_MOD:
 				if (r == 0) {
-					set_error(ctx, "Modulo by zero");
+					set_error(ctx, CEL_ERROR_DIVISION_BY_ZERO,
+						  "Modulo by zero");
+					return false;
+				}
+				if (r == -1 && l == INT64_MIN) {
+					set_error(ctx, CEL_ERROR_OVERFLOW,
+						  "Integer overflow");
 					return false;
 				}
 				*result = cel_value_int(l % r);
@@ -275,16 +525,16 @@ static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
 			default:
 				break;
 			}
-		} else if (left.type == CEL_TYPE_DOUBLE ||
-			   right.type == CEL_TYPE_DOUBLE) {
-			double l = (left.type == CEL_TYPE_DOUBLE) ?
-					   left.value.double_value :
-					   (double)left.value.int_value;
-			double r = (right.type == CEL_TYPE_DOUBLE) ?
-					   right.value.double_value :
-					   (double)right.value.int_value;
-
-			switch (binary->op) {
+		} else if (left->type == CEL_TYPE_DOUBLE ||
+			   right->type == CEL_TYPE_DOUBLE) {
+			double l = (left->type == CEL_TYPE_DOUBLE) ?
+					   left->value.double_value :
+					   (double)left->value.int_value;
+			double r = (right->type == CEL_TYPE_DOUBLE) ?
+					   right->value.double_value :
+					   (double)right->value.int_value;
+
+			switch (op) {
 			case CEL_BINARY_ADD:
 				*result = cel_value_double(l + r);
 				return true;
@@ -296,14 +546,16 @@ static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
 				return true;
 			case CEL_BINARY_DIV:
 				if (r == 0.0) {
-					set_error(ctx, "Division by zero");
+					set_error(ctx, CEL_ERROR_DIVISION_BY_ZERO,
+						  "Division by zero");
 					return false;
 				}
 				*result = cel_value_double(l / r);
 				return true;
 			case CEL_BINARY_MOD:
 				if (r == 0.0) {
-					set_error(ctx, "Modulo by zero");
+					set_error(ctx, CEL_ERROR_DIVISION_BY_ZERO,
+						  "Modulo by zero");
 					return false;
 				}
 				*result = cel_value_double(fmod(l, r));
@@ -311,85 +563,42 @@ static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
 			default:
 				break;
 			}
-		} else if (binary->op == CEL_BINARY_ADD &&
-			   left.type == CEL_TYPE_STRING &&
-			   right.type == CEL_TYPE_STRING) {
+		} else if (op == CEL_BINARY_ADD &&
+			   left->type == CEL_TYPE_STRING &&
+			   right->type == CEL_TYPE_STRING) {
 			/* 字符串连接 */
-			*result = cel_string_concat(&left, &right);
+			*result = cel_string_concat(left, right);
 			return true;
-		} else if (binary->op == CEL_BINARY_ADD &&
-			   left.type == CEL_TYPE_LIST &&
-			   right.type == CEL_TYPE_LIST) {
+		} else if (op == CEL_BINARY_ADD &&
+			   left->type == CEL_TYPE_LIST &&
+			   right->type == CEL_TYPE_LIST) {
 			/* 列表连接 */
-			cel_list_t *left_list = left.value.list_value;
-			cel_list_t *right_list = right.value.list_value;
-
-			/* 创建新列表 */
-			size_t left_size = cel_list_size(left_list);
-			size_t right_size = cel_list_size(right_list);
-			cel_list_t *new_list = cel_list_create(left_size + right_size);
-
-			if (!new_list) {
-				set_error(ctx, "Failed to create list for concatenation");
-				return false;
-			}
-
-			/* 复制左列表元素 */
-			for (size_t i = 0; i < left_size; i++) {
-				cel_value_t *elem = cel_list_get(left_list, i);
-				if (!elem) {
-					cel_list_release(new_list);
-					set_error(ctx, "Failed to get element from left list");
-					return false;
-				}
-				if (!cel_list_append(new_list, elem)) {
-					cel_list_release(new_list);
-					set_error(ctx, "Failed to append element to new list");
-					return false;
-				}
-			}
-
-			/* 复制右列表元素 */
-			for (size_t i = 0; i < right_size; i++) {
-				cel_value_t *elem = cel_list_get(right_list, i);
-				if (!elem) {
-					cel_list_release(new_list);
-					set_error(ctx, "Failed to get element from right list");
-					return false;
-				}
-				if (!cel_list_append(new_list, elem)) {
-					cel_list_release(new_list);
-					set_error(ctx, "Failed to append element to new list");
-					return false;
-				}
-			}
-
-			result->type = CEL_TYPE_LIST;
-			result->value.list_value = new_list;
-			return true;
-		} else {
-			set_error(ctx, "Type mismatch in arithmetic operation");
-			return false;
+			return list_concat(ctx, left->value.list_value,
+					   right->value.list_value, result);
 		}
+
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Type mismatch in arithmetic operation");
+		return false;
 	}
 
 	/* 比较运算 */
-	if (binary->op >= CEL_BINARY_EQ && binary->op <= CEL_BINARY_GE) {
+	if (op >= CEL_BINARY_EQ && op <= CEL_BINARY_GE) {
 		/* 相等性比较 */
-		if (binary->op == CEL_BINARY_EQ) {
-			*result = cel_value_bool(cel_value_equals(&left, &right));
+		if (op == CEL_BINARY_EQ) {
+			*result = cel_value_bool(cel_value_equals(left, right));
 			return true;
 		}
-		if (binary->op == CEL_BINARY_NE) {
-			*result = cel_value_bool(!cel_value_equals(&left, &right));
+		if (op == CEL_BINARY_NE) {
+			*result = cel_value_bool(!cel_value_equals(left, right));
 			return true;
 		}
 
 		/* 顺序比较 - 只支持数值类型 */
-		if (left.type == CEL_TYPE_INT && right.type == CEL_TYPE_INT) {
-			int64_t l = left.value.int_value;
-			int64_t r = right.value.int_value;
-			switch (binary->op) {
+		if (left->type == CEL_TYPE_INT && right->type == CEL_TYPE_INT) {
+			int64_t l = left->value.int_value;
+			int64_t r = right->value.int_value;
+			switch (op) {
 			case CEL_BINARY_LT:
 				*result = cel_value_bool(l < r);
 				return true;
@@ -405,14 +614,14 @@ static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
 			default:
 				break;
 			}
-		} else if (left.type == CEL_TYPE_DOUBLE || right.type == CEL_TYPE_DOUBLE) {
-			double l = (left.type == CEL_TYPE_DOUBLE) ?
-					   left.value.double_value :
-					   (double)left.value.int_value;
-			double r = (right.type == CEL_TYPE_DOUBLE) ?
-					   right.value.double_value :
-					   (double)right.value.int_value;
-			switch (binary->op) {
+		} else if (left->type == CEL_TYPE_DOUBLE || right->type == CEL_TYPE_DOUBLE) {
+			double l = (left->type == CEL_TYPE_DOUBLE) ?
+					   left->value.double_value :
+					   (double)left->value.int_value;
+			double r = (right->type == CEL_TYPE_DOUBLE) ?
+					   right->value.double_value :
+					   (double)right->value.int_value;
+			switch (op) {
 			case CEL_BINARY_LT:
 				*result = cel_value_bool(l < r);
 				return true;
@@ -428,40 +637,245 @@ static bool eval_binary(const cel_ast_binary_t *binary, cel_context_t *ctx,
 			default:
 				break;
 			}
-		} else {
-			set_error(ctx, "Comparison requires numeric operands");
-			return false;
 		}
+
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Comparison requires numeric operands");
+		return false;
 	}
 
 	/* in 运算符 */
-	if (binary->op == CEL_BINARY_IN) {
-		if (right.type == CEL_TYPE_LIST) {
-			cel_list_t *list = right.value.list_value;
+	if (op == CEL_BINARY_IN) {
+		if (right->type == CEL_TYPE_LIST) {
+			cel_list_t *list = right->value.list_value;
 			for (size_t i = 0; i < list->length; i++) {
 				cel_value_t *item = cel_list_get(list, i);
-				if (item && cel_value_equals(&left, item)) {
+				if (item && cel_value_equals(left, item)) {
 					*result = cel_value_bool(true);
 					return true;
 				}
 			}
 			*result = cel_value_bool(false);
 			return true;
-		} else if (right.type == CEL_TYPE_MAP) {
-			cel_map_t *map = right.value.map_value;
-			cel_value_t *found = cel_map_get(map, &left);
+		} else if (right->type == CEL_TYPE_MAP) {
+			cel_map_t *map = right->value.map_value;
+			cel_value_t *found = cel_map_get(map, left);
 			*result = cel_value_bool(found != NULL);
 			return true;
 		} else {
-			set_error(ctx, "'in' operator requires list or map");
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "'in' operator requires list or map");
 			return false;
 		}
 	}
 
-	set_error(ctx, "Unknown binary operator");
+	set_error(ctx, CEL_ERROR_INTERNAL, "Unknown binary operator");
 	return false;
 }
 
+/* ========== 左深链 ========== */
+
+/*
+ * 解析器循环构造左结合的运算，a + b + c 与 a.b.c 得到沿左操作数嵌套
+ * 的链，深度与链长相同。求值时沿左操作数收集链上的节点，从持有最左
+ * 操作数的节点开始循环求值，递归深度不随链长增加。
+ */
+
+/**
+ * @brief 链上的节点 (links[0] 为链头，最后一个持有最左的操作数)
+ */
+typedef struct {
+	const cel_ast_node_t *local[EVAL_INLINE_CHAIN];
+	const cel_ast_node_t **links;
+	size_t count;
+} eval_chain_t;
+
+static bool is_logical(cel_binary_op_e op)
+{
+	return op == CEL_BINARY_AND || op == CEL_BINARY_OR;
+}
+
+/**
+ * @brief 节点的左操作数 (二元运算的左侧、字段与索引访问的对象)
+ */
+static const cel_ast_node_t *chain_left(const cel_ast_node_t *node)
+{
+	switch (node->type) {
+	case CEL_AST_BINARY:
+		return node->as.binary.left;
+	case CEL_AST_SELECT:
+		return node->as.select.operand;
+	default:
+		return node->as.index.operand;
+	}
+}
+
+/**
+ * @brief 节点是否延续以 head 开头的链
+ *
+ * && / || 链只包括同一运算符；其他二元运算、字段与索引访问可以混合。
+ */
+static bool chain_continues(const cel_ast_node_t *head,
+			    const cel_ast_node_t *node)
+{
+	if (!node) {
+		return false;
+	}
+	if (head->type == CEL_AST_BINARY && is_logical(head->as.binary.op)) {
+		return node->type == CEL_AST_BINARY &&
+		       node->as.binary.op == head->as.binary.op;
+	}
+	return (node->type == CEL_AST_BINARY &&
+		!is_logical(node->as.binary.op)) ||
+	       node->type == CEL_AST_SELECT || node->type == CEL_AST_INDEX;
+}
+
+static void chain_release(eval_chain_t *chain)
+{
+	if (chain->links != chain->local) {
+		free(chain->links);
+	}
+}
+
+/**
+ * @brief 收集以 head 开头的链 (成功时调用者负责 chain_release)
+ */
+static bool chain_collect(eval_chain_t *chain, const cel_ast_node_t *head,
+			  cel_context_t *ctx)
+{
+	size_t capacity = EVAL_INLINE_CHAIN;
+	chain->links = chain->local;
+	chain->count = 0;
+
+	const cel_ast_node_t *link = head;
+	do {
+		if (chain->count == capacity) {
+			capacity *= 2;
+			const cel_ast_node_t **grown =
+				chain->links == chain->local ?
+					malloc(capacity * sizeof(*grown)) :
+					realloc(chain->links,
+						capacity * sizeof(*grown));
+			if (!grown) {
+				chain_release(chain);
+				set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+					  "Out of memory");
+				return false;
+			}
+			if (chain->links == chain->local) {
+				memcpy(grown, chain->local, sizeof(chain->local));
+			}
+			chain->links = grown;
+		}
+		chain->links[chain->count++] = link;
+		link = chain_left(link);
+	} while (chain_continues(head, link));
+	return true;
+}
+
+/**
+ * @brief 短路求值 && / || 链
+ *
+ * ((a || b) || c) || d 的操作数按 a, b, c, d 的顺序求值。操作数类型
+ * 错误的位置与逐层求值相同 (操作数所属的节点)。
+ */
+static bool eval_logical(const cel_ast_node_t *node, cel_context_t *ctx,
+			 cel_value_t *result)
+{
+	bool decisive = node->as.binary.op == CEL_BINARY_OR;  /* 决定结果的操作数值 */
+
+	eval_chain_t chain;
+	if (!chain_collect(&chain, node, ctx)) {
+		return false;
+	}
+
+	size_t count = chain.count;
+	bool success = true, value = !decisive;
+	for (size_t i = 0; i <= count && value != decisive; i++) {
+		const cel_ast_node_t *owner = chain.links[i ? count - i : count - 1];
+		const cel_ast_node_t *operand = i ? owner->as.binary.right :
+						    owner->as.binary.left;
+		cel_value_t operand_value;
+		if (!eval_node(operand, ctx, &operand_value)) {
+			success = false;
+			break;
+		}
+		if (operand_value.type != CEL_TYPE_BOOL) {
+			cel_value_destroy(&operand_value);
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "Logical operator requires boolean operands");
+			cel_eval_error_locate(owner->loc.line, owner->loc.column);
+			success = false;
+			break;
+		}
+		value = operand_value.value.bool_value;
+	}
+
+	chain_release(&chain);
+	if (success) {
+		*result = cel_value_bool(value);
+	}
+	return success;
+}
+
+/**
+ * @brief 以已求值的左操作数完成链上的一个节点
+ */
+static bool eval_link(const cel_ast_node_t *link, cel_context_t *ctx,
+		      const cel_value_t *operand, cel_value_t *result)
+{
+	if (link->type == CEL_AST_SELECT) {
+		return select_link(&link->as.select, ctx, operand, result);
+	}
+	if (link->type == CEL_AST_INDEX) {
+		return index_link(&link->as.index, ctx, operand, result);
+	}
+
+	cel_value_t right;
+	if (!eval_node(link->as.binary.right, ctx, &right)) {
+		return false;
+	}
+	bool success = cel_eval_binary_op(ctx, link->as.binary.op, operand,
+					  &right, result);
+	cel_value_destroy(&right);
+	return success;
+}
+
+/**
+ * @brief 求值二元运算 (&& / || 除外)、字段与索引访问的链
+ *
+ * 失败的节点与逐层求值一样记录出错位置。
+ */
+static bool eval_chain(const cel_ast_node_t *node, cel_context_t *ctx,
+		       cel_value_t *result)
+{
+	eval_chain_t chain;
+	if (!chain_collect(&chain, node, ctx)) {
+		return false;
+	}
+
+	cel_value_t value;
+	bool success = eval_node(chain_left(chain.links[chain.count - 1]), ctx,
+				 &value);
+	for (size_t i = chain.count; success && i-- > 0;) {
+		const cel_ast_node_t *link = chain.links[i];
+		cel_value_t next;
+		success = eval_link(link, ctx, &value, &next);
+		cel_value_destroy(&value);
+		if (success) {
+			value = next;
+		} else {
+			cel_eval_error_locate(link->loc.line, link->loc.column);
+		}
+	}
+
+	chain_release(&chain);
+	if (success) {
+		*result = value;
+	}
+	return success;
+}
+
 /* ========== 三元运算求值 ========== */
 
 static bool eval_ternary(const cel_ast_ternary_t *ternary, cel_context_t *ctx,
@@ -473,7 +887,9 @@ static bool eval_ternary(const cel_ast_ternary_t *ternary, cel_context_t *ctx,
 	}
 
 	if (condition.type != CEL_TYPE_BOOL) {
-		set_error(ctx, "Ternary condition must be boolean");
+		cel_value_destroy(&condition);
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Ternary condition must be boolean");
 		return false;
 	}
 
@@ -484,1534 +900,1366 @@ static bool eval_ternary(const cel_ast_ternary_t *ternary, cel_context_t *ctx,
 	}
 }
 
-/* ========== 字段访问求值 ========== */
+/* ========== 字段访问 ========== */
 
-static bool eval_select(const cel_ast_select_t *select, cel_context_t *ctx,
-			 cel_value_t *result)
+bool cel_eval_select_field(cel_context_t *ctx, const cel_value_t *operand,
+			   const cel_value_t *field, bool optional,
+			   cel_value_t *result)
 {
-	cel_value_t operand;
-	if (!eval_node(select->operand, ctx, &operand)) {
-		return false;
-	}
-
-	if (operand.type != CEL_TYPE_MAP) {
-		if (select->optional) {
+	if (operand->type != CEL_TYPE_MAP) {
+		if (optional) {
 			*result = cel_value_null();
 			return true;
 		}
-		set_error(ctx, "Field access requires map");
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Field access requires map");
 		return false;
 	}
 
-	/* 将字段名转换为字符串值 */
-	cel_value_t field_key = cel_value_string_n(select->field,
-						    select->field_length);
-
-	cel_value_t *value = cel_map_get(operand.value.map_value, &field_key);
+	cel_value_t *value = cel_map_get(operand->value.map_value, field);
 
 	if (!value) {
-		if (select->optional) {
+		if (optional) {
 			*result = cel_value_null();
 			return true;
 		}
-		char error_msg[256];
-		snprintf(error_msg, sizeof(error_msg), "Field not found: %.*s",
-			 (int)select->field_length, select->field);
-		set_error(ctx, error_msg);
+		set_error_detail(ctx, CEL_ERROR_NOT_FOUND, "Field not found",
+				 field->value.string_value->data,
+				 cel_string_length(field));
 		return false;
 	}
 
-	*result = *value;
+	*result = cel_value_retain(value);
 	return true;
 }
 
-/* ========== 索引访问求值 ========== */
-
-static bool eval_index(const cel_ast_index_t *index, cel_context_t *ctx,
-			cel_value_t *result)
+/**
+ * @brief 字段访问 (对象已求值，见 eval_chain)
+ */
+static bool select_link(const cel_ast_select_t *select, cel_context_t *ctx,
+			const cel_value_t *operand, cel_value_t *result)
 {
-	cel_value_t operand, index_val;
+	/* 将字段名转换为字符串值 */
+	cel_value_t field_key = cel_value_string_n(select->field,
+						    select->field_length);
 
-	if (!eval_node(index->operand, ctx, &operand)) {
-		return false;
-	}
-	if (!eval_node(index->index, ctx, &index_val)) {
-		return false;
-	}
+	bool success = cel_eval_select_field(ctx, operand, &field_key,
+					     select->optional, result);
+
+	cel_value_destroy(&field_key);
+	return success;
+}
 
-	if (operand.type == CEL_TYPE_LIST) {
-		if (index_val.type != CEL_TYPE_INT) {
-			set_error(ctx, "List index must be integer");
+/* ========== 索引访问 ========== */
+
+bool cel_eval_index_value(cel_context_t *ctx, const cel_value_t *operand,
+			  const cel_value_t *index, bool optional,
+			  cel_value_t *result)
+{
+	if (operand->type == CEL_TYPE_LIST) {
+		if (index->type != CEL_TYPE_INT) {
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "List index must be integer");
 			return false;
 		}
 
-		cel_list_t *list = operand.value.list_value;
-		int64_t idx = index_val.value.int_value;
+		cel_list_t *list = operand->value.list_value;
+		int64_t idx = index->value.int_value;
 
 		if (idx < 0 || (size_t)idx >= list->length) {
-			if (index->optional) {
+			if (optional) {
 				*result = cel_value_null();
 				return true;
 			}
-			set_error(ctx, "List index out of bounds");
+			set_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+				  "List index out of bounds");
 			return false;
 		}
 
 		cel_value_t *item = cel_list_get(list, (size_t)idx);
 		if (!item) {
-			set_error(ctx, "Failed to get list item");
+			set_error(ctx, CEL_ERROR_INTERNAL,
+				  "Failed to get list item");
 			return false;
 		}
-		*result = *item;
+		*result = cel_value_retain(item);
 		return true;
 
-	} else if (operand.type == CEL_TYPE_MAP) {
-		cel_value_t *value = cel_map_get(operand.value.map_value,
-						  &index_val);
+	} else if (operand->type == CEL_TYPE_MAP) {
+		cel_value_t *value = cel_map_get(operand->value.map_value, index);
 		if (!value) {
-			if (index->optional) {
+			if (optional) {
 				*result = cel_value_null();
 				return true;
 			}
-			set_error(ctx, "Map key not found");
+			set_error(ctx, CEL_ERROR_NOT_FOUND,
+				  "Map key not found");
 			return false;
 		}
 
-		*result = *value;
+		*result = cel_value_retain(value);
 		return true;
 
 	} else {
-		set_error(ctx, "Index access requires list or map");
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Index access requires list or map");
 		return false;
 	}
 }
 
-/* ========== 内置函数实现 ========== */
-
 /**
- * @brief 检查函数名是否匹配
+ * @brief 索引访问 (容器已求值，见 eval_chain)
  */
-static bool func_name_equals(const char *name, size_t length, const char *expected)
+static bool index_link(const cel_ast_index_t *index, cel_context_t *ctx,
+		       const cel_value_t *operand, cel_value_t *result)
 {
-	size_t expected_len = strlen(expected);
-	return length == expected_len && memcmp(name, expected, length) == 0;
+	cel_value_t index_val;
+	if (!eval_node(index->index, ctx, &index_val)) {
+		return false;
+	}
+
+	bool success = cel_eval_index_value(ctx, operand, &index_val,
+					    index->optional, result);
+
+	cel_value_destroy(&index_val);
+	return success;
 }
 
+/* ========== 函数调用 ========== */
+
 /**
- * @brief 内置 size() 函数
- * 支持: size(container) 或 container.size()
+ * @brief 调用上下文中注册的函数
  */
-static bool builtin_size(const cel_ast_call_t *call, cel_context_t *ctx,
-			  cel_value_t *result)
+static bool call_context_function(cel_context_t *ctx, cel_function_t *func,
+				  const char *func_name, cel_value_t *args,
+				  size_t arg_count, cel_value_t *result)
 {
-	cel_value_t arg;
-
-	/* 方法调用: container.size() */
-	if (call->target && call->arg_count == 0) {
-		if (!eval_node(call->target, ctx, &arg)) {
+	cel_value_t *local_ptrs[EVAL_INLINE_ARGS];
+	cel_value_t **arg_ptrs = local_ptrs;
+
+	if (arg_count > EVAL_INLINE_ARGS) {
+		arg_ptrs = malloc(sizeof(cel_value_t *) * arg_count);
+		if (!arg_ptrs) {
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Out of memory");
 			return false;
 		}
 	}
-	/* 函数调用: size(container) */
-	else if (!call->target && call->arg_count == 1) {
-		if (!eval_node(call->args[0], ctx, &arg)) {
-			return false;
+
+	for (size_t i = 0; i < arg_count; i++) {
+		arg_ptrs[i] = &args[i];
+	}
+
+	cel_func_context_t func_ctx = {
+		.context = ctx,
+		.func_name = func_name,
+		.call_site = NULL
+	};
+
+	cel_result_t func_result = func->func(&func_ctx, arg_ptrs, arg_count);
+
+	if (arg_ptrs != local_ptrs) {
+		free(arg_ptrs);
+	}
+
+	if (!func_result.is_ok) {
+		if (func_result.error) {
+			const char *message = func_result.error->message;
+			set_error_detail(ctx, func_result.error->code,
+					 "Function call failed", message,
+					 message ? strlen(message) : 0);
+			cel_error_destroy(func_result.error);
+		} else {
+			set_error(ctx, CEL_ERROR_INTERNAL, "Function call failed");
 		}
-	} else {
-		set_error(ctx, "size() requires exactly 1 argument");
 		return false;
 	}
 
-	if (arg.type == CEL_TYPE_STRING) {
-		*result = cel_value_int((int64_t)cel_string_length(&arg));
-		return true;
-	} else if (arg.type == CEL_TYPE_LIST) {
-		*result = cel_value_int((int64_t)arg.value.list_value->length);
-		return true;
-	} else if (arg.type == CEL_TYPE_MAP) {
-		*result = cel_value_int((int64_t)arg.value.map_value->size);
-		return true;
-	} else if (arg.type == CEL_TYPE_BYTES) {
-		*result = cel_value_int((int64_t)arg.value.bytes_value->length);
-		return true;
+	/* 从 void* 转移返回值的所有权 */
+	if (func_result.value) {
+		*result = *(cel_value_t *)func_result.value;
 	} else {
-		set_error(ctx, "size() requires string, bytes, list, or map");
-		return false;
+		*result = cel_value_null();
 	}
+	return true;
 }
 
-/**
- * @brief 内置 contains() 函数
- * 支持: contains(container, elem) 或 container.contains(elem)
- */
-static bool builtin_contains(const cel_ast_call_t *call, cel_context_t *ctx,
-			      cel_value_t *result)
+bool cel_eval_call_context_function(cel_context_t *ctx, const char *name,
+				    cel_value_t *args, size_t arg_count,
+				    cel_value_t *result)
 {
-	cel_value_t container, elem;
-
-	/* 方法调用: container.contains(elem) */
-	if (call->target && call->arg_count == 1) {
-		if (!eval_node(call->target, ctx, &container)) {
-			return false;
-		}
-		if (!eval_node(call->args[0], ctx, &elem)) {
-			return false;
-		}
-	}
-	/* 函数调用: contains(container, elem) */
-	else if (!call->target && call->arg_count == 2) {
-		if (!eval_node(call->args[0], ctx, &container)) {
-			return false;
-		}
-		if (!eval_node(call->args[1], ctx, &elem)) {
-			return false;
-		}
-	} else {
-		set_error(ctx, "contains() requires 2 arguments");
-		return false;
+	cel_function_t *func = cel_context_get_function(ctx, name);
+	if (func) {
+		return call_context_function(ctx, func, name, args, arg_count,
+					     result);
 	}
 
-	if (container.type == CEL_TYPE_LIST) {
-		cel_list_t *list = container.value.list_value;
-		for (size_t i = 0; i < list->length; i++) {
-			cel_value_t *item = cel_list_get(list, i);
-			if (item && cel_value_equals(&elem, item)) {
-				*result = cel_value_bool(true);
-				return true;
-			}
-		}
-		*result = cel_value_bool(false);
-		return true;
-	} else if (container.type == CEL_TYPE_STRING) {
-		if (elem.type != CEL_TYPE_STRING) {
-			set_error(ctx, "string.contains() requires string argument");
-			return false;
-		}
-		/* 使用 strstr 检查子串 */
-		const char *haystack = container.value.string_value->data;
-		const char *needle = elem.value.string_value->data;
-		*result = cel_value_bool(strstr(haystack, needle) != NULL);
-		return true;
+	if (cel_builtin_exists(name, strlen(name))) {
+		set_error_detail(ctx, CEL_ERROR_INVALID_ARGUMENT,
+				 "No matching overload for function", name,
+				 strlen(name));
 	} else {
-		set_error(ctx, "contains() requires list or string");
-		return false;
+		set_error_detail(ctx, CEL_ERROR_UNKNOWN_IDENTIFIER,
+				 "Unknown function", name, strlen(name));
 	}
+	return false;
 }
 
-/**
- * @brief 内置 startsWith() 函数
- * 支持: startsWith(str, prefix) 或 str.startsWith(prefix)
- */
-static bool builtin_startsWith(const cel_ast_call_t *call, cel_context_t *ctx,
-				cel_value_t *result)
+bool cel_eval_call_function(cel_context_t *ctx, const char *name,
+			    size_t name_length, cel_value_t *args,
+			    size_t arg_count, bool has_target,
+			    cel_value_t *result)
 {
-	cel_value_t str, prefix;
-
-	/* 方法调用: str.startsWith(prefix) */
-	if (call->target && call->arg_count == 1) {
-		if (!eval_node(call->target, ctx, &str)) {
-			return false;
-		}
-		if (!eval_node(call->args[0], ctx, &prefix)) {
-			return false;
-		}
+	/* 分发到内置函数 */
+	cel_function_id_e id;
+	if (cel_builtin_resolve(name, name_length, has_target, arg_count, &id)) {
+		return cel_builtin_call(id, ctx, args, result);
 	}
-	/* 函数调用: startsWith(str, prefix) */
-	else if (!call->target && call->arg_count == 2) {
-		if (!eval_node(call->args[0], ctx, &str)) {
-			return false;
-		}
-		if (!eval_node(call->args[1], ctx, &prefix)) {
+
+	/* 查找上下文中注册的函数 */
+	char local_name[EVAL_INLINE_NAME];
+	char *func_name = local_name;
+	if (name_length < sizeof(local_name)) {
+		memcpy(local_name, name, name_length);
+		local_name[name_length] = '\0';
+	} else {
+		func_name = strndup(name, name_length);
+		if (!func_name) {
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Out of memory");
 			return false;
 		}
-	} else {
-		set_error(ctx, "startsWith() requires 2 arguments");
-		return false;
-	}
-
-	if (str.type != CEL_TYPE_STRING || prefix.type != CEL_TYPE_STRING) {
-		set_error(ctx, "startsWith() requires string arguments");
-		return false;
 	}
 
-	size_t str_len = cel_string_length(&str);
-	size_t prefix_len = cel_string_length(&prefix);
+	bool success = cel_eval_call_context_function(ctx, func_name, args,
+						      arg_count, result);
 
-	if (prefix_len > str_len) {
-		*result = cel_value_bool(false);
-		return true;
+	if (func_name != local_name) {
+		free(func_name);
 	}
-
-	*result = cel_value_bool(
-		memcmp(str.value.string_value->data,
-		       prefix.value.string_value->data,
-		       prefix_len) == 0);
-	return true;
+	return success;
 }
 
-/**
- * @brief 内置 endsWith() 函数
- * 支持: endsWith(str, suffix) 或 str.endsWith(suffix)
- */
-static bool builtin_endsWith(const cel_ast_call_t *call, cel_context_t *ctx,
-			      cel_value_t *result)
+static bool eval_call(const cel_ast_call_t *call, cel_context_t *ctx,
+		      cel_value_t *result)
 {
-	cel_value_t str, suffix;
-
-	/* 方法调用: str.endsWith(suffix) */
-	if (call->target && call->arg_count == 1) {
-		if (!eval_node(call->target, ctx, &str)) {
-			return false;
-		}
-		if (!eval_node(call->args[0], ctx, &suffix)) {
+	bool has_target = call->target != NULL;
+	size_t arg_count = call->arg_count + (has_target ? 1 : 0);
+
+	cel_value_t local_args[EVAL_INLINE_ARGS];
+	cel_value_t *args = local_args;
+	if (arg_count > EVAL_INLINE_ARGS) {
+		args = malloc(sizeof(cel_value_t) * arg_count);
+		if (!args) {
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Out of memory");
 			return false;
 		}
 	}
-	/* 函数调用: endsWith(str, suffix) */
-	else if (!call->target && call->arg_count == 2) {
-		if (!eval_node(call->args[0], ctx, &str)) {
-			return false;
-		}
-		if (!eval_node(call->args[1], ctx, &suffix)) {
-			return false;
+
+	/* 求值接收者与参数 */
+	bool success = false;
+	size_t evaluated = 0;
+
+	if (has_target) {
+		if (!eval_node(call->target, ctx, &args[evaluated])) {
+			goto cleanup;
 		}
-	} else {
-		set_error(ctx, "endsWith() requires 2 arguments");
-		return false;
+		evaluated++;
 	}
 
-	if (str.type != CEL_TYPE_STRING || suffix.type != CEL_TYPE_STRING) {
-		set_error(ctx, "endsWith() requires string arguments");
-		return false;
+	for (size_t i = 0; i < call->arg_count; i++) {
+		if (!eval_node(call->args[i], ctx, &args[evaluated])) {
+			goto cleanup;
+		}
+		evaluated++;
 	}
 
-	size_t str_len = cel_string_length(&str);
-	size_t suffix_len = cel_string_length(&suffix);
+	success = cel_exec_budget_charge_call(ctx, args, arg_count) &&
+		  cel_eval_call_function(ctx, call->function,
+					 call->function_length, args,
+					 arg_count, has_target, result);
 
-	if (suffix_len > str_len) {
-		*result = cel_value_bool(false);
-		return true;
+cleanup:
+	for (size_t i = 0; i < evaluated; i++) {
+		cel_value_destroy(&args[i]);
 	}
-
-	*result = cel_value_bool(
-		memcmp(str.value.string_value->data + (str_len - suffix_len),
-		       suffix.value.string_value->data,
-		       suffix_len) == 0);
-	return true;
+	if (args != local_args) {
+		free(args);
+	}
+	return success;
 }
 
-#ifdef CEL_ENABLE_REGEX
-/**
- * @brief 内置 matches() 函数 - 正则表达式匹配
- * 支持: matches(str, pattern) 或 str.matches(pattern)
- */
-static bool builtin_matches(const cel_ast_call_t *call, cel_context_t *ctx,
-			    cel_value_t *result)
+/* ========== 列表字面量求值 ========== */
+
+static bool eval_list(const cel_ast_list_t *list, cel_context_t *ctx,
+		      cel_value_t *result)
 {
-	cel_value_t str, pattern;
+	cel_list_t *cel_list = cel_list_create(list->element_count);
+	if (!cel_list) {
+		set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+			  "Failed to create list");
+		return false;
+	}
 
-	/* 方法调用: str.matches(pattern) */
-	if (call->target && call->arg_count == 1) {
-		if (!eval_node(call->target, ctx, &str)) {
+	for (size_t i = 0; i < list->element_count; i++) {
+		cel_value_t element;
+		if (!eval_node(list->elements[i], ctx, &element)) {
+			cel_list_release(cel_list);
 			return false;
 		}
-		if (!eval_node(call->args[0], ctx, &pattern)) {
+
+		bool appended = cel_list_append(cel_list, &element);
+		cel_value_destroy(&element);
+		if (!appended) {
+			cel_list_release(cel_list);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Failed to append to list");
 			return false;
 		}
 	}
-	/* 函数调用: matches(str, pattern) */
-	else if (!call->target && call->arg_count == 2) {
-		if (!eval_node(call->args[0], ctx, &str)) {
+
+	result->type = CEL_TYPE_LIST;
+	result->value.list_value = cel_list;
+	return true;
+}
+
+/* ========== Map 字面量求值 ========== */
+
+static bool eval_map(const cel_ast_map_t *map, cel_context_t *ctx,
+		     cel_value_t *result)
+{
+	cel_map_t *cel_map = cel_map_create(map->entry_count > 0 ? map->entry_count : 16);
+	if (!cel_map) {
+		set_error(ctx, CEL_ERROR_OUT_OF_MEMORY, "Failed to create map");
+		return false;
+	}
+
+	for (size_t i = 0; i < map->entry_count; i++) {
+		cel_value_t key, value;
+
+		if (!eval_node(map->entries[i].key, ctx, &key)) {
+			cel_map_release(cel_map);
 			return false;
 		}
-		if (!eval_node(call->args[1], ctx, &pattern)) {
+
+		if (!eval_node(map->entries[i].value, ctx, &value)) {
+			cel_value_destroy(&key);
+			cel_map_release(cel_map);
 			return false;
 		}
-	} else {
-		set_error(ctx, "matches() requires 2 arguments");
-		return false;
-	}
 
-	if (str.type != CEL_TYPE_STRING || pattern.type != CEL_TYPE_STRING) {
-		set_error(ctx, "matches() requires string arguments");
-		return false;
-	}
-
-	const char *subject = str.value.string_value->data;
-	size_t subject_len = cel_string_length(&str);
-	const char *regex = pattern.value.string_value->data;
-
-	/* 编译正则表达式 */
-	int errornumber;
-	PCRE2_SIZE erroroffset;
-	pcre2_code *re = pcre2_compile(
-		(PCRE2_SPTR)regex,
-		PCRE2_ZERO_TERMINATED,
-		0,
-		&errornumber,
-		&erroroffset,
-		NULL);
-
-	if (re == NULL) {
-		PCRE2_UCHAR buffer[256];
-		pcre2_get_error_message(errornumber, buffer, sizeof(buffer));
-		char error_msg[512];
-		snprintf(error_msg, sizeof(error_msg),
-			 "regex compile error at offset %zu: %s",
-			 (size_t)erroroffset, buffer);
-		set_error(ctx, error_msg);
-		return false;
+		bool stored = cel_map_put(cel_map, &key, &value);
+		cel_value_destroy(&key);
+		cel_value_destroy(&value);
+		if (!stored) {
+			cel_map_release(cel_map);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Failed to set map entry");
+			return false;
+		}
 	}
 
-	/* 创建匹配数据 */
-	pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(re, NULL);
-	if (match_data == NULL) {
-		pcre2_code_free(re);
-		set_error(ctx, "failed to create match data");
-		return false;
-	}
+	result->type = CEL_TYPE_MAP;
+	result->value.map_value = cel_map;
+	return true;
+}
 
-	/* 执行匹配 */
-	int rc = pcre2_match(
-		re,
-		(PCRE2_SPTR)subject,
-		subject_len,
-		0,
-		0,
-		match_data,
-		NULL);
+/* ========== Comprehension 求值 ========== */
 
-	/* 清理 */
-	pcre2_match_data_free(match_data);
-	pcre2_code_free(re);
+static bool name_equals(const char *name, size_t length, const char *other,
+			size_t other_length)
+{
+	return name && length == other_length &&
+	       memcmp(name, other, length) == 0;
+}
 
-	/* 返回结果 */
-	*result = cel_value_bool(rc >= 0);
-	return true;
+static bool is_accu(const cel_ast_node_t *node,
+		    const cel_ast_comprehension_t *comp)
+{
+	return node && node->type == CEL_AST_IDENT &&
+	       name_equals(node->as.ident.name, node->as.ident.length,
+			   comp->accu_var, comp->accu_var_length);
 }
-#endif /* CEL_ENABLE_REGEX */
 
 /**
- * @brief 内置 int() 类型转换函数
+ * @brief 追加形式的循环步骤 ([G ?] @result + [E] [: @result])
+ *
+ * map / filter 宏展开的形式，按此识别后累加器原地追加，
+ * 不再每次迭代复制整个列表。
  */
-static bool builtin_int(const cel_ast_call_t *call, cel_context_t *ctx,
-			 cel_value_t *result)
-{
-	if (call->arg_count != 1) {
-		set_error(ctx, "int() requires exactly 1 argument");
-		return false;
-	}
+typedef struct {
+	const cel_ast_node_t *guard;    /* 过滤条件 (可为 NULL) */
+	const cel_ast_node_t *element;  /* 追加的元素 */
+} append_step_t;
 
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
+/**
+ * @brief 识别追加形式的循环步骤
+ *
+ * @return true 循环步骤为追加形式
+ */
+static bool match_append(const cel_ast_comprehension_t *comp,
+			 append_step_t *append)
+{
+	const cel_ast_node_t *step = comp->loop_step;
+	if (!step ||
+	    name_equals(comp->iter_var, comp->iter_var_length, comp->accu_var,
+			comp->accu_var_length) ||
+	    name_equals(comp->iter_var2, comp->iter_var2_length, comp->accu_var,
+			comp->accu_var_length)) {
+		/* 循环变量遮蔽累加器时步骤中的标识符不是累加器 */
 		return false;
 	}
 
-	switch (arg.type) {
-	case CEL_TYPE_INT:
-		*result = arg;
-		return true;
-	case CEL_TYPE_UINT:
-		/* 检查溢出 */
-		if (arg.value.uint_value > (uint64_t)INT64_MAX) {
-			set_error(ctx, "uint to int overflow");
-			return false;
-		}
-		*result = cel_value_int((int64_t)arg.value.uint_value);
-		return true;
-	case CEL_TYPE_DOUBLE:
-		*result = cel_value_int((int64_t)arg.value.double_value);
-		return true;
-	case CEL_TYPE_STRING: {
-		/* 尝试解析字符串为整数 */
-		const char *str = arg.value.string_value->data;
-		char *end;
-		long long val = strtoll(str, &end, 10);
-		if (*end != '\0') {
-			set_error(ctx, "invalid integer string");
-			return false;
-		}
-		*result = cel_value_int((int64_t)val);
-		return true;
+	append->guard = NULL;
+	if (step->type == CEL_AST_TERNARY &&
+	    is_accu(step->as.ternary.if_false, comp)) {
+		append->guard = step->as.ternary.condition;
+		step = step->as.ternary.if_true;
 	}
-	default:
-		set_error(ctx, "int() cannot convert this type");
+	if (!step || step->type != CEL_AST_BINARY ||
+	    step->as.binary.op != CEL_BINARY_ADD ||
+	    !is_accu(step->as.binary.left, comp) ||
+	    step->as.binary.right->type != CEL_AST_LIST ||
+	    step->as.binary.right->as.list.element_count != 1) {
 		return false;
 	}
+	append->element = step->as.binary.right->as.list.elements[0];
+	return true;
 }
 
 /**
- * @brief 内置 uint() 类型转换函数
+ * @brief 求值追加形式的循环步骤，原地更新累加器
+ *
+ * 求值顺序与错误信息与按 AST 求值相同。
  */
-static bool builtin_uint(const cel_ast_call_t *call, cel_context_t *ctx,
-			  cel_value_t *result)
+static bool eval_append(const append_step_t *append, cel_context_t *ctx,
+			eval_frame_t *frame)
 {
-	if (call->arg_count != 1) {
-		set_error(ctx, "uint() requires exactly 1 argument");
-		return false;
-	}
-
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
-		return false;
-	}
-
-	switch (arg.type) {
-	case CEL_TYPE_UINT:
-		*result = arg;
-		return true;
-	case CEL_TYPE_INT:
-		if (arg.value.int_value < 0) {
-			set_error(ctx, "int to uint: negative value");
+	if (append->guard) {
+		cel_value_t guard;
+		if (!eval_node(append->guard, ctx, &guard)) {
 			return false;
 		}
-		*result = cel_value_uint((uint64_t)arg.value.int_value);
-		return true;
-	case CEL_TYPE_DOUBLE:
-		if (arg.value.double_value < 0) {
-			set_error(ctx, "double to uint: negative value");
+		if (guard.type != CEL_TYPE_BOOL) {
+			cel_value_destroy(&guard);
+			set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				  "Ternary condition must be boolean");
 			return false;
 		}
-		*result = cel_value_uint((uint64_t)arg.value.double_value);
-		return true;
-	case CEL_TYPE_STRING: {
-		const char *str = arg.value.string_value->data;
-		char *end;
-		unsigned long long val = strtoull(str, &end, 10);
-		if (*end != '\0') {
-			set_error(ctx, "invalid unsigned integer string");
-			return false;
+		if (!guard.value.bool_value) {
+			return true;
 		}
-		*result = cel_value_uint((uint64_t)val);
-		return true;
 	}
-	default:
-		set_error(ctx, "uint() cannot convert this type");
+
+	cel_value_t element;
+	if (!eval_node(append->element, ctx, &element)) {
 		return false;
 	}
+	bool success = cel_eval_list_append(ctx, &frame->accu_value, &element);
+	cel_value_destroy(&element);
+	return success;
 }
 
+
 /**
- * @brief 内置 double() 类型转换函数
+ * @brief 执行推导式的一次迭代 (循环变量已绑定到帧中)
+ *
+ * @param append 追加形式的循环步骤 (不是追加形式时为 NULL)
+ * @param stop 输出循环条件为 false，迭代应结束
+ * @return true 成功，false 失败
  */
-static bool builtin_double(const cel_ast_call_t *call, cel_context_t *ctx,
-			    cel_value_t *result)
+static bool eval_iteration(const cel_ast_comprehension_t *comp,
+			   const append_step_t *append, cel_context_t *ctx,
+			   eval_frame_t *frame, bool *stop)
 {
-	if (call->arg_count != 1) {
-		set_error(ctx, "double() requires exactly 1 argument");
+	if (!cel_exec_budget_charge(ctx, CEL_COST_ITERATION)) {
 		return false;
 	}
 
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
+	/* 检查循环条件 */
+	cel_value_t cond_val;
+	if (!eval_node(comp->loop_cond, ctx, &cond_val)) {
 		return false;
 	}
 
-	switch (arg.type) {
-	case CEL_TYPE_DOUBLE:
-		*result = arg;
-		return true;
-	case CEL_TYPE_INT:
-		*result = cel_value_double((double)arg.value.int_value);
-		return true;
-	case CEL_TYPE_UINT:
-		*result = cel_value_double((double)arg.value.uint_value);
-		return true;
-	case CEL_TYPE_STRING: {
-		const char *str = arg.value.string_value->data;
-		char *end;
-		double val = strtod(str, &end);
-		if (*end != '\0') {
-			set_error(ctx, "invalid double string");
-			return false;
-		}
-		*result = cel_value_double(val);
-		return true;
-	}
-	default:
-		set_error(ctx, "double() cannot convert this type");
+	/* 条件必须是布尔值 */
+	if (cond_val.type != CEL_TYPE_BOOL) {
+		cel_value_destroy(&cond_val);
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Loop condition must be boolean");
 		return false;
 	}
-}
 
-/**
- * @brief 内置 string() 类型转换函数
- */
-static bool builtin_string(const cel_ast_call_t *call, cel_context_t *ctx,
-			    cel_value_t *result)
-{
-	if (call->arg_count != 1) {
-		set_error(ctx, "string() requires exactly 1 argument");
-		return false;
+	/* 如果条件为 false，中断循环 */
+	if (!cond_val.value.bool_value) {
+		*stop = true;
+		return true;
 	}
 
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
-		return false;
+	/* 追加形式的步骤直接向累加器追加 */
+	if (append && frame->accu_value.type == CEL_TYPE_LIST) {
+		return eval_append(append, ctx, frame);
 	}
 
-	char buf[64];
-	switch (arg.type) {
-	case CEL_TYPE_STRING:
-		*result = arg;
-		return true;
-	case CEL_TYPE_INT:
-		snprintf(buf, sizeof(buf), "%ld", (long)arg.value.int_value);
-		*result = cel_value_string(buf);
-		return true;
-	case CEL_TYPE_UINT:
-		snprintf(buf, sizeof(buf), "%lu", (unsigned long)arg.value.uint_value);
-		*result = cel_value_string(buf);
-		return true;
-	case CEL_TYPE_DOUBLE:
-		snprintf(buf, sizeof(buf), "%g", arg.value.double_value);
-		*result = cel_value_string(buf);
-		return true;
-	case CEL_TYPE_BOOL:
-		*result = cel_value_string(arg.value.bool_value ? "true" : "false");
-		return true;
-	default:
-		set_error(ctx, "string() cannot convert this type");
+	/* 求值循环步骤，原地覆盖累加器 */
+	cel_value_t new_accu_val;
+	if (!eval_node(comp->loop_step, ctx, &new_accu_val)) {
 		return false;
 	}
+	cel_value_destroy(&frame->accu_value);
+	frame->accu_value = new_accu_val;
+	return true;
 }
 
 /**
- * @brief 内置 type() 函数
+ * @brief 对 Comprehension 表达式求值
+ *
+ * Comprehension 执行模型:
+ * 1. 求值 iter_range，得到要迭代的集合（List 或 Map）
+ * 2. 求值 accu_init，初始化累加器变量
+ * 3. 对集合中的每个元素:
+ *    a. 将元素 (Map 为键) 绑定到 iter_var；双变量形式时 iter_var
+ *       绑定下标 (Map 为键)，iter_var2 绑定元素 (Map 为值)
+ *    b. 求值 loop_cond，如果为 false 则中断循环
+ *    c. 求值 loop_step，更新累加器
+ * 4. 求值 result 表达式，返回最终结果
+ *
+ * 循环变量与累加器绑定在 eval_frame_t 中 (见推导式变量帧)，
+ * 迭代过程不分配内存。map / filter 形式的循环步骤原地追加累加器
+ * (见 match_append)。安装了并行设置时，大的列表范围先在线程池上
+ * 并行求值 (见并行推导式)。
+ *
+ * @param comp Comprehension 节点
+ * @param ctx 求值上下文
+ * @param result 输出结果
+ * @return true 成功，false 失败
  */
-static bool builtin_type(const cel_ast_call_t *call, cel_context_t *ctx,
-			  cel_value_t *result)
+static bool eval_comprehension(const cel_ast_comprehension_t *comp,
+				 cel_context_t *ctx, cel_value_t *result)
 {
-	if (call->arg_count != 1) {
-		set_error(ctx, "type() requires exactly 1 argument");
+	if (!comp || !ctx || !result) {
+		set_error(ctx, CEL_ERROR_INTERNAL,
+			  "Invalid arguments to eval_comprehension");
 		return false;
 	}
 
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
+	/* 1. 求值迭代范围 */
+	cel_value_t iter_range_val;
+	if (!eval_node(comp->iter_range, ctx, &iter_range_val)) {
 		return false;
 	}
 
-	const char *type_name;
-	switch (arg.type) {
-	case CEL_TYPE_NULL:
-		type_name = "null_type";
-		break;
-	case CEL_TYPE_BOOL:
-		type_name = "bool";
-		break;
-	case CEL_TYPE_INT:
-		type_name = "int";
-		break;
-	case CEL_TYPE_UINT:
-		type_name = "uint";
-		break;
-	case CEL_TYPE_DOUBLE:
-		type_name = "double";
-		break;
-	case CEL_TYPE_STRING:
-		type_name = "string";
-		break;
-	case CEL_TYPE_BYTES:
-		type_name = "bytes";
-		break;
-	case CEL_TYPE_LIST:
-		type_name = "list";
-		break;
-	case CEL_TYPE_MAP:
-		type_name = "map";
-		break;
-	case CEL_TYPE_TIMESTAMP:
-		type_name = "google.protobuf.Timestamp";
-		break;
-	case CEL_TYPE_DURATION:
-		type_name = "google.protobuf.Duration";
-		break;
-	default:
-		type_name = "unknown";
-		break;
+	/* 检查迭代范围类型 */
+	if (iter_range_val.type != CEL_TYPE_LIST && iter_range_val.type != CEL_TYPE_MAP) {
+		set_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+			  "Comprehension iter_range must be a list or map");
+		cel_value_destroy(&iter_range_val);
+		return false;
 	}
 
-	*result = cel_value_string(type_name);
-	return true;
-}
+	/* 2. 求值累加器初始值 (此时循环变量与累加器尚不可见) */
+	eval_frame_t frame = {
+		.iter_var = comp->iter_var,
+		.iter_var_length = comp->iter_var_length,
+		.iter_value = NULL,
+		.iter_var2 = comp->iter_var2,
+		.iter_var2_length = comp->iter_var2_length,
+		.iter_value2 = NULL,
+		.accu_var = comp->accu_var,
+		.accu_var_length = comp->accu_var_length,
+		.parent = current_frame,
+	};
+	if (!eval_node(comp->accu_init, ctx, &frame.accu_value)) {
+		cel_value_destroy(&iter_range_val);
+		return false;
+	}
 
-/* ========== 时间戳方法 ========== */
+	bool success = false;
+	bool stop = false;
+	append_step_t append_step;
+	const append_step_t *append =
+		match_append(comp, &append_step) ? &append_step : NULL;
+	current_frame = &frame;
 
-/**
- * @brief 从 Unix 时间戳获取 tm 结构
- */
-static bool timestamp_to_tm(int64_t seconds, int16_t offset_minutes, struct tm *tm_out)
-{
-	time_t t = (time_t)seconds;
-	/* 应用时区偏移 */
-	t += offset_minutes * 60;
+	/* 3. 迭代处理 */
+	if (iter_range_val.type == CEL_TYPE_LIST) {
+		/* List 迭代: 单变量绑定元素，双变量绑定 (下标, 元素) */
+		cel_list_t *list = iter_range_val.value.list_value;
+		size_t list_size = cel_list_size(list);
 
-	struct tm *result;
-#ifdef _WIN32
-	result = gmtime(&t);
-	if (result) {
-		*tm_out = *result;
-	}
-#else
-	result = gmtime_r(&t, tm_out);
-#endif
-	return result != NULL;
-}
+		/* 大范围先并行求值，再从第一个决定结果的元素起顺序执行 */
+		size_t start = 0;
+		if (!comp->iter_var2 &&
+		    !eval_parallel(comp, ctx, &frame, list, &start)) {
+			goto cleanup;
+		}
 
-/**
- * @brief timestamp.getFullYear() - 获取年份
- */
-static bool builtin_getFullYear(const cel_ast_call_t *call, cel_context_t *ctx,
-				 cel_value_t *result)
-{
-	/* 只支持方法调用: ts.getFullYear() */
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getFullYear() requires no arguments");
-		return false;
+		for (size_t i = start; i < list_size && !stop; i++) {
+			const cel_value_t *element = list->items[i];
+			if (comp->iter_var2) {
+				frame.index = cel_value_int((int64_t)i);
+				frame.iter_value = &frame.index;
+				frame.iter_value2 = element;
+			} else {
+				frame.iter_value = element;
+			}
+			if (!eval_iteration(comp, append, ctx, &frame, &stop)) {
+				goto cleanup;
+			}
+		}
+	} else {
+		/* Map 迭代: 直接遍历哈希桶，单变量绑定键，双变量绑定 (键, 值) */
+		cel_map_t *map = iter_range_val.value.map_value;
+
+		for (size_t b = 0; b < map->bucket_count && !stop; b++) {
+			for (cel_map_entry_t *entry = map->buckets[b];
+			     entry && !stop; entry = entry->next) {
+				frame.iter_value = entry->key;
+				frame.iter_value2 = entry->value;
+				if (!eval_iteration(comp, append, ctx, &frame, &stop)) {
+					goto cleanup;
+				}
+			}
+		}
 	}
 
-	cel_value_t ts;
-	if (!eval_node(call->target, ctx, &ts)) {
-		return false;
-	}
+	/* 结果表达式中循环变量不可见 */
+	frame.iter_value = NULL;
 
-	if (ts.type != CEL_TYPE_TIMESTAMP) {
-		set_error(ctx, "getFullYear() requires timestamp");
-		return false;
+	/* 4. 返回结果 */
+	if (comp->result) {
+		/* 求值结果表达式 */
+		if (!eval_node(comp->result, ctx, result)) {
+			goto cleanup;
+		}
+	} else {
+		/* 没有结果表达式，转移累加器的值 */
+		*result = frame.accu_value;
+		frame.accu_value = cel_value_null();
 	}
 
-	struct tm tm;
-	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
-			     ts.value.timestamp_value.offset_minutes, &tm)) {
-		set_error(ctx, "Failed to convert timestamp");
-		return false;
-	}
+	success = true;
 
-	*result = cel_value_int(tm.tm_year + 1900);
-	return true;
+cleanup:
+	current_frame = frame.parent;
+	cel_value_destroy(&frame.accu_value);
+	cel_value_destroy(&iter_range_val);
+
+	return success;
 }
 
-/**
- * @brief timestamp.getMonth() - 获取月份 (0-11)
- */
-static bool builtin_getMonth(const cel_ast_call_t *call, cel_context_t *ctx,
-			      cel_value_t *result)
-{
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getMonth() requires no arguments");
-		return false;
-	}
+/* ========== 执行预算 ========== */
 
-	cel_value_t ts;
-	if (!eval_node(call->target, ctx, &ts)) {
-		return false;
-	}
+static uint64_t monotonic_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec;
+}
 
-	if (ts.type != CEL_TYPE_TIMESTAMP) {
-		set_error(ctx, "getMonth() requires timestamp");
-		return false;
-	}
+cel_exec_budget_t *cel_exec_budget_enter(cel_exec_budget_t *budget,
+					 uint64_t cost_limit,
+					 uint64_t timeout_ms)
+{
+	budget->cost = 0;
+	budget->cost_limit = cost_limit ? cost_limit : UINT64_MAX;
+	budget->deadline_ns = 0;
+	budget->clock_countdown = UINT32_MAX;
+	budget->exhausted = CEL_OK;
+	budget->depth_left = SIZE_MAX;
+	if (timeout_ms) {
+		/* 超时过大时截断到 UINT64_MAX，等同于不超时 */
+		uint64_t now = monotonic_ns();
+		uint64_t timeout_ns = timeout_ms > UINT64_MAX / UINT64_C(1000000) ?
+					      UINT64_MAX :
+					      timeout_ms * UINT64_C(1000000);
+		budget->deadline_ns = timeout_ns > UINT64_MAX - now ?
+					      UINT64_MAX :
+					      now + timeout_ns;
+		budget->clock_countdown = BUDGET_CLOCK_INTERVAL;
+	}
+
+	cel_exec_budget_t *previous = current_budget;
+	current_budget = budget;
+	return previous;
+}
 
-	struct tm tm;
-	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
-			     ts.value.timestamp_value.offset_minutes, &tm)) {
-		set_error(ctx, "Failed to convert timestamp");
-		return false;
-	}
+void cel_exec_budget_leave(cel_exec_budget_t *previous)
+{
+	current_budget = previous;
+}
 
-	*result = cel_value_int(tm.tm_mon);
-	return true;
+cel_exec_budget_t *cel_exec_budget_current(void)
+{
+	return current_budget;
 }
 
 /**
- * @brief timestamp.getDayOfMonth() - 获取日期 (1-31)
+ * @brief 检查限制 (代价超出上限或需要读取时钟时调用)
  */
-static bool builtin_getDayOfMonth(const cel_ast_call_t *call, cel_context_t *ctx,
-				   cel_value_t *result)
+static bool budget_check(cel_exec_budget_t *budget, cel_context_t *ctx)
 {
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getDayOfMonth() requires no arguments");
-		return false;
-	}
-
-	cel_value_t ts;
-	if (!eval_node(call->target, ctx, &ts)) {
-		return false;
-	}
-
-	if (ts.type != CEL_TYPE_TIMESTAMP) {
-		set_error(ctx, "getDayOfMonth() requires timestamp");
+	if (budget->exhausted != CEL_OK) {
 		return false;
 	}
 
-	struct tm tm;
-	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
-			     ts.value.timestamp_value.offset_minutes, &tm)) {
-		set_error(ctx, "Failed to convert timestamp");
-		return false;
+	if (budget->cost > budget->cost_limit) {
+		budget->exhausted = CEL_ERROR_COST_LIMIT;
+		set_error(ctx, CEL_ERROR_COST_LIMIT, "Cost limit exceeded");
+	} else if (budget->deadline_ns == 0) {
+		budget->clock_countdown = UINT32_MAX;
+		return true;
+	} else if (monotonic_ns() < budget->deadline_ns) {
+		budget->clock_countdown = BUDGET_CLOCK_INTERVAL;
+		return true;
+	} else {
+		budget->exhausted = CEL_ERROR_TIMEOUT;
+		set_error(ctx, CEL_ERROR_TIMEOUT, "Execution timed out");
 	}
 
-	*result = cel_value_int(tm.tm_mday);
-	return true;
+	/* 超出限制后所有检查都失败，错误不会被 && / || 吸收后继续执行 */
+	budget->cost_limit = 0;
+	return false;
 }
 
 /**
- * @brief timestamp.getDayOfWeek() - 获取星期几 (0=Sunday, 6=Saturday)
+ * @brief 消耗代价 (budget 不为 NULL)
  */
-static bool builtin_getDayOfWeek(const cel_ast_call_t *call, cel_context_t *ctx,
-				  cel_value_t *result)
+static inline bool budget_charge(cel_exec_budget_t *budget, cel_context_t *ctx,
+				 uint64_t cost)
 {
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getDayOfWeek() requires no arguments");
-		return false;
-	}
-
-	cel_value_t ts;
-	if (!eval_node(call->target, ctx, &ts)) {
-		return false;
-	}
-
-	if (ts.type != CEL_TYPE_TIMESTAMP) {
-		set_error(ctx, "getDayOfWeek() requires timestamp");
-		return false;
+	budget->cost += cost;
+	if (budget->cost > budget->cost_limit || --budget->clock_countdown == 0) {
+		return budget_check(budget, ctx);
 	}
-
-	struct tm tm;
-	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
-			     ts.value.timestamp_value.offset_minutes, &tm)) {
-		set_error(ctx, "Failed to convert timestamp");
-		return false;
-	}
-
-	*result = cel_value_int(tm.tm_wday);
 	return true;
 }
 
-/**
- * @brief timestamp.getDayOfYear() - 获取年中第几天 (0-365)
- */
-static bool builtin_getDayOfYear(const cel_ast_call_t *call, cel_context_t *ctx,
-				  cel_value_t *result)
+bool cel_exec_budget_charge(cel_context_t *ctx, uint64_t cost)
 {
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getDayOfYear() requires no arguments");
-		return false;
-	}
+	cel_exec_budget_t *budget = current_budget;
+	return !budget || budget_charge(budget, ctx, cost);
+}
 
-	cel_value_t ts;
-	if (!eval_node(call->target, ctx, &ts)) {
-		return false;
+bool cel_exec_budget_charge_call(cel_context_t *ctx, const cel_value_t *args,
+				 size_t arg_count)
+{
+	cel_exec_budget_t *budget = current_budget;
+	if (!budget) {
+		return true;
 	}
 
-	if (ts.type != CEL_TYPE_TIMESTAMP) {
-		set_error(ctx, "getDayOfYear() requires timestamp");
-		return false;
-	}
+	uint64_t size = 0;
+	for (size_t i = 0; i < arg_count; i++) {
+		const cel_value_t *arg = &args[i];
+		switch (arg->type) {
+		case CEL_TYPE_STRING:
+			size += arg->value.string_value->length;
+			break;
+		case CEL_TYPE_BYTES:
+			size += arg->value.bytes_value->length;
+			break;
+		case CEL_TYPE_LIST:
+			size += arg->value.list_value->length;
+			break;
+		case CEL_TYPE_MAP:
+			size += arg->value.map_value->size;
+			break;
+		default:
+			break;
+		}
+	}
+	return budget_charge(budget, ctx, CEL_COST_CALL + size / CEL_COST_SIZE_UNIT);
+}
 
-	struct tm tm;
-	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
-			     ts.value.timestamp_value.offset_minutes, &tm)) {
-		set_error(ctx, "Failed to convert timestamp");
-		return false;
-	}
+/* ========== 并行推导式 ========== */
 
-	*result = cel_value_int(tm.tm_yday);
-	return true;
-}
+/* 当前线程的并行设置 (NULL 表示顺序执行) */
+static _Thread_local const cel_eval_parallel_t *current_parallel = NULL;
 
-/**
- * @brief timestamp.getHours() 或 duration.getHours()
- */
-static bool builtin_getHours(const cel_ast_call_t *call, cel_context_t *ctx,
-			      cel_value_t *result)
+const cel_eval_parallel_t *cel_eval_parallel_enter(
+	const cel_eval_parallel_t *parallel)
 {
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getHours() requires no arguments");
-		return false;
-	}
-
-	cel_value_t val;
-	if (!eval_node(call->target, ctx, &val)) {
-		return false;
-	}
+	const cel_eval_parallel_t *previous = current_parallel;
+	current_parallel = parallel;
+	return previous;
+}
 
-	if (val.type == CEL_TYPE_TIMESTAMP) {
-		struct tm tm;
-		if (!timestamp_to_tm(val.value.timestamp_value.seconds,
-				     val.value.timestamp_value.offset_minutes, &tm)) {
-			set_error(ctx, "Failed to convert timestamp");
-			return false;
-		}
-		*result = cel_value_int(tm.tm_hour);
-		return true;
-	} else if (val.type == CEL_TYPE_DURATION) {
-		/* duration.getHours() 返回总小时数 */
-		int64_t total_hours = val.value.duration_value.seconds / 3600;
-		*result = cel_value_int(total_hours);
-		return true;
-	} else {
-		set_error(ctx, "getHours() requires timestamp or duration");
-		return false;
-	}
+void cel_eval_parallel_leave(const cel_eval_parallel_t *previous)
+{
+	current_parallel = previous;
 }
 
+#ifdef CEL_THREAD_SAFE
+
 /**
- * @brief timestamp.getMinutes() 或 duration.getMinutes()
+ * @brief 可并行的推导式形式
  */
-static bool builtin_getMinutes(const cel_ast_call_t *call, cel_context_t *ctx,
-				cel_value_t *result)
-{
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getMinutes() requires no arguments");
-		return false;
-	}
+typedef enum {
+	PARALLEL_ALL,      /* all: 所有元素的谓词为 true */
+	PARALLEL_EXISTS,   /* exists: 存在元素的谓词为 true */
+	PARALLEL_APPEND,   /* map / filter: 按顺序追加元素 */
+} parallel_kind_e;
 
-	cel_value_t val;
-	if (!eval_node(call->target, ctx, &val)) {
-		return false;
-	}
+/**
+ * @brief 并行求值计划
+ */
+typedef struct {
+	parallel_kind_e kind;
+	const cel_ast_node_t *predicate;  /* all / exists 的谓词，map / filter 的过滤条件 (可为 NULL) */
+	const cel_ast_node_t *element;    /* map / filter 追加的元素 */
+} parallel_plan_t;
 
-	if (val.type == CEL_TYPE_TIMESTAMP) {
-		struct tm tm;
-		if (!timestamp_to_tm(val.value.timestamp_value.seconds,
-				     val.value.timestamp_value.offset_minutes, &tm)) {
-			set_error(ctx, "Failed to convert timestamp");
-			return false;
-		}
-		*result = cel_value_int(tm.tm_min);
-		return true;
-	} else if (val.type == CEL_TYPE_DURATION) {
-		/* duration.getMinutes() 返回总分钟数 */
-		int64_t total_minutes = val.value.duration_value.seconds / 60;
-		*result = cel_value_int(total_minutes);
-		return true;
-	} else {
-		set_error(ctx, "getMinutes() requires timestamp or duration");
-		return false;
-	}
-}
+/**
+ * @brief 并行任务 (所有参与线程共享)
+ */
+typedef struct {
+	parallel_plan_t plan;
+	cel_context_t *ctx;
+	const eval_frame_t *frame;        /* 调用者的帧 (提供变量名与外层帧) */
+	cel_list_t *list;                 /* 迭代范围 */
+	size_t count;                     /* 元素数量 */
+	const cel_exec_budget_t *budget;  /* 调用者的预算 (NULL 表示不统计代价) */
+	cel_value_t *outputs;             /* map / filter 每个元素追加的值 */
+	unsigned char *present;           /* outputs[i] 是否有效 */
+	uint64_t *chunk_cost;             /* 每块中位于 stop 之前的元素的代价 */
+	atomic_size_t next;               /* 下一个待领取的元素 */
+	atomic_size_t stop;               /* 第一个决定结果或出错的元素 (count 表示没有) */
+} parallel_job_t;
 
 /**
- * @brief timestamp.getSeconds() 或 duration.getSeconds()
+ * @brief 检查子树能否在工作线程上求值
+ *
+ * 不能引用累加器 (name 为 NULL 表示已被内层推导式遮蔽)，
+ * 只能调用内置函数。
  */
-static bool builtin_getSeconds(const cel_ast_call_t *call, cel_context_t *ctx,
-				cel_value_t *result)
+static bool parallel_safe(const cel_ast_node_t *node, const char *name,
+			  size_t length)
 {
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getSeconds() requires no arguments");
-		return false;
-	}
-
-	cel_value_t val;
-	if (!eval_node(call->target, ctx, &val)) {
-		return false;
+	if (!node) {
+		return true;
 	}
 
-	if (val.type == CEL_TYPE_TIMESTAMP) {
-		struct tm tm;
-		if (!timestamp_to_tm(val.value.timestamp_value.seconds,
-				     val.value.timestamp_value.offset_minutes, &tm)) {
-			set_error(ctx, "Failed to convert timestamp");
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		return true;
+	case CEL_AST_IDENT:
+		return !name_equals(name, length, node->as.ident.name,
+				    node->as.ident.length);
+	case CEL_AST_UNARY:
+		return parallel_safe(node->as.unary.operand, name, length);
+	case CEL_AST_BINARY:
+		return parallel_safe(node->as.binary.left, name, length) &&
+		       parallel_safe(node->as.binary.right, name, length);
+	case CEL_AST_TERNARY:
+		return parallel_safe(node->as.ternary.condition, name, length) &&
+		       parallel_safe(node->as.ternary.if_true, name, length) &&
+		       parallel_safe(node->as.ternary.if_false, name, length);
+	case CEL_AST_SELECT:
+		return parallel_safe(node->as.select.operand, name, length);
+	case CEL_AST_INDEX:
+		return parallel_safe(node->as.index.operand, name, length) &&
+		       parallel_safe(node->as.index.index, name, length);
+	case CEL_AST_CALL: {
+		/* 上下文函数可能有副作用 */
+		const cel_ast_call_t *call = &node->as.call;
+		bool has_target = call->target != NULL;
+		cel_function_id_e id;
+		if (!cel_builtin_resolve(call->function, call->function_length,
+					 has_target,
+					 call->arg_count + (has_target ? 1 : 0),
+					 &id) ||
+		    !parallel_safe(call->target, name, length)) {
 			return false;
 		}
-		*result = cel_value_int(tm.tm_sec);
-		return true;
-	} else if (val.type == CEL_TYPE_DURATION) {
-		/* duration.getSeconds() 返回总秒数 */
-		*result = cel_value_int(val.value.duration_value.seconds);
+		for (size_t i = 0; i < call->arg_count; i++) {
+			if (!parallel_safe(call->args[i], name, length)) {
+				return false;
+			}
+		}
 		return true;
-	} else {
-		set_error(ctx, "getSeconds() requires timestamp or duration");
-		return false;
 	}
-}
-
-/**
- * @brief timestamp.getMilliseconds() 或 duration.getMilliseconds()
- */
-static bool builtin_getMilliseconds(const cel_ast_call_t *call, cel_context_t *ctx,
-				     cel_value_t *result)
-{
-	if (!call->target || call->arg_count != 0) {
-		set_error(ctx, "getMilliseconds() requires no arguments");
-		return false;
-	}
-
-	cel_value_t val;
-	if (!eval_node(call->target, ctx, &val)) {
-		return false;
-	}
-
-	if (val.type == CEL_TYPE_TIMESTAMP) {
-		/* timestamp 的毫秒部分 */
-		int64_t ms = val.value.timestamp_value.nanoseconds / 1000000;
-		*result = cel_value_int(ms);
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			if (!parallel_safe(node->as.list.elements[i], name, length)) {
+				return false;
+			}
+		}
 		return true;
-	} else if (val.type == CEL_TYPE_DURATION) {
-		/* duration 的总毫秒数 */
-		int64_t total_ms = val.value.duration_value.seconds * 1000 +
-				   val.value.duration_value.nanoseconds / 1000000;
-		*result = cel_value_int(total_ms);
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			if (!parallel_safe(node->as.map.entries[i].key, name, length) ||
+			    !parallel_safe(node->as.map.entries[i].value, name, length)) {
+				return false;
+			}
+		}
 		return true;
-	} else {
-		set_error(ctx, "getMilliseconds() requires timestamp or duration");
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *inner = &node->as.comprehension;
+		if (!parallel_safe(inner->iter_range, name, length) ||
+		    !parallel_safe(inner->accu_init, name, length)) {
+			return false;
+		}
+		/* 内层推导式的变量遮蔽累加器 */
+		if (name_equals(inner->iter_var, inner->iter_var_length, name, length) ||
+		    name_equals(inner->iter_var2, inner->iter_var2_length, name, length) ||
+		    name_equals(inner->accu_var, inner->accu_var_length, name, length)) {
+			name = NULL;
+		}
+		return parallel_safe(inner->loop_cond, name, length) &&
+		       parallel_safe(inner->loop_step, name, length) &&
+		       parallel_safe(inner->result, name, length);
+	}
+	default:
 		return false;
 	}
 }
 
 /**
- * @brief timestamp() 函数 - 从 RFC3339 字符串解析时间戳
+ * @brief 识别可并行的推导式形式
+ *
+ * @param accu 累加器初始值
+ * @return true 可以并行求值
  */
-static bool builtin_timestamp(const cel_ast_call_t *call, cel_context_t *ctx,
-			       cel_value_t *result)
+static bool parallel_plan(const cel_ast_comprehension_t *comp,
+			  const cel_value_t *accu, parallel_plan_t *plan)
 {
-	/* timestamp(string) 或 timestamp(int) */
-	if (call->target || call->arg_count != 1) {
-		set_error(ctx, "timestamp() requires exactly 1 argument");
-		return false;
-	}
-
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
-		return false;
-	}
-
-	if (arg.type == CEL_TYPE_INT) {
-		/* 直接从 Unix 时间戳创建 */
-		*result = cel_value_timestamp(arg.value.int_value, 0, 0);
-		return true;
-	} else if (arg.type == CEL_TYPE_STRING) {
-		/* 解析 RFC3339 格式: "2021-08-15T10:30:00Z" */
-		const char *s = arg.value.string_value->data;
-		int year, month, day, hour, min, sec;
-		char tz;
-
-		int parsed = sscanf(s, "%d-%d-%dT%d:%d:%d%c",
-				    &year, &month, &day, &hour, &min, &sec, &tz);
-
-		if (parsed < 6) {
-			set_error(ctx, "Invalid RFC3339 timestamp format");
+	const cel_ast_node_t *cond = comp->loop_cond;
+	const cel_ast_node_t *step = comp->loop_step;
+	if (!cond || !step) {
+		return false;
+	}
+
+	if (accu->type == CEL_TYPE_BOOL && step->type == CEL_AST_BINARY &&
+	    is_accu(step->as.binary.left, comp)) {
+		/* all: @result && P，exists: @result || P */
+		if (step->as.binary.op == CEL_BINARY_AND &&
+		    accu->value.bool_value && is_accu(cond, comp)) {
+			plan->kind = PARALLEL_ALL;
+		} else if (step->as.binary.op == CEL_BINARY_OR &&
+			   !accu->value.bool_value &&
+			   cond->type == CEL_AST_UNARY &&
+			   cond->as.unary.op == CEL_UNARY_NOT &&
+			   is_accu(cond->as.unary.operand, comp)) {
+			plan->kind = PARALLEL_EXISTS;
+		} else {
 			return false;
 		}
-
-		/* 转换为 Unix 时间戳 */
-		struct tm tm = {0};
-		tm.tm_year = year - 1900;
-		tm.tm_mon = month - 1;
-		tm.tm_mday = day;
-		tm.tm_hour = hour;
-		tm.tm_min = min;
-		tm.tm_sec = sec;
-
-		time_t t;
-#ifdef _WIN32
-		t = _mkgmtime(&tm);
-#else
-		t = timegm(&tm);
-#endif
-		if (t == -1) {
-			set_error(ctx, "Failed to convert timestamp");
+		plan->predicate = step->as.binary.right;
+		plan->element = NULL;
+	} else if (accu->type == CEL_TYPE_LIST && cond->type == CEL_AST_LITERAL &&
+		   cond->as.literal.value.type == CEL_TYPE_BOOL &&
+		   cond->as.literal.value.value.bool_value) {
+		/* map / filter: [F ?] @result + [E] [: @result] */
+		append_step_t append;
+		if (!match_append(comp, &append)) {
 			return false;
 		}
-
-		*result = cel_value_timestamp((int64_t)t, 0, 0);
-		return true;
+		plan->kind = PARALLEL_APPEND;
+		plan->predicate = append.guard;
+		plan->element = append.element;
 	} else {
-		set_error(ctx, "timestamp() requires int or string argument");
 		return false;
 	}
+
+	return parallel_safe(plan->predicate, comp->accu_var,
+			     comp->accu_var_length) &&
+	       parallel_safe(plan->element, comp->accu_var,
+			     comp->accu_var_length);
 }
 
 /**
- * @brief duration() 函数 - 从字符串解析时长
+ * @brief 在工作线程上求值一个元素 (循环变量已绑定)
+ *
+ * @return true 元素不影响结果 (all 的谓词为 true，exists 的谓词为
+ *         false，map / filter 已输出)，false 元素决定结果或求值出错
  */
-static bool builtin_duration(const cel_ast_call_t *call, cel_context_t *ctx,
-			      cel_value_t *result)
+static bool parallel_element(parallel_job_t *job, size_t index)
 {
-	/* duration(string) 格式: "1h30m45s" 或 "3600s" */
-	if (call->target || call->arg_count != 1) {
-		set_error(ctx, "duration() requires exactly 1 argument");
-		return false;
-	}
-
-	cel_value_t arg;
-	if (!eval_node(call->args[0], ctx, &arg)) {
-		return false;
-	}
-
-	if (arg.type != CEL_TYPE_STRING) {
-		set_error(ctx, "duration() requires string argument");
+	const parallel_plan_t *plan = &job->plan;
+	if (!cel_exec_budget_charge(job->ctx, CEL_COST_ITERATION)) {
 		return false;
 	}
 
-	const char *s = arg.value.string_value->data;
-	int64_t total_seconds = 0;
-	int64_t current_num = 0;
-	bool negative = false;
-
-	if (*s == '-') {
-		negative = true;
-		s++;
-	}
-
-	while (*s) {
-		if (*s >= '0' && *s <= '9') {
-			current_num = current_num * 10 + (*s - '0');
-		} else if (*s == 'h' || *s == 'H') {
-			total_seconds += current_num * 3600;
-			current_num = 0;
-		} else if (*s == 'm' || *s == 'M') {
-			total_seconds += current_num * 60;
-			current_num = 0;
-		} else if (*s == 's' || *s == 'S') {
-			total_seconds += current_num;
-			current_num = 0;
-		} else {
-			set_error(ctx, "Invalid duration format");
+	cel_value_t value;
+	if (plan->predicate) {
+		if (!eval_node(plan->predicate, job->ctx, &value)) {
+			return false;
+		}
+		if (value.type != CEL_TYPE_BOOL) {
+			cel_value_destroy(&value);
 			return false;
 		}
-		s++;
+		switch (plan->kind) {
+		case PARALLEL_ALL:
+			return value.value.bool_value;
+		case PARALLEL_EXISTS:
+			return !value.value.bool_value;
+		case PARALLEL_APPEND:
+			if (!value.value.bool_value) {
+				return true;
+			}
+			break;
+		}
 	}
 
-	/* 如果字符串末尾没有单位，假设为秒 */
-	total_seconds += current_num;
-
-	if (negative) {
-		total_seconds = -total_seconds;
+	if (!eval_node(plan->element, job->ctx, &job->outputs[index])) {
+		return false;
 	}
-
-	*result = cel_value_duration(total_seconds, 0);
+	job->present[index] = 1;
 	return true;
 }
 
-/* ========== 函数调用求值 ========== */
-
-static bool eval_call(const cel_ast_call_t *call, cel_context_t *ctx,
-		      cel_value_t *result)
+/**
+ * @brief 记录决定结果的元素 (保留最小下标)
+ */
+static void parallel_stop_at(parallel_job_t *job, size_t index)
 {
-	/* 分发到内置函数 */
-	if (func_name_equals(call->function, call->function_length, "size")) {
-		return builtin_size(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "contains")) {
-		return builtin_contains(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "startsWith")) {
-		return builtin_startsWith(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "endsWith")) {
-		return builtin_endsWith(call, ctx, result);
-	}
-#ifdef CEL_ENABLE_REGEX
-	if (func_name_equals(call->function, call->function_length, "matches")) {
-		return builtin_matches(call, ctx, result);
-	}
-#endif
-	if (func_name_equals(call->function, call->function_length, "int")) {
-		return builtin_int(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "uint")) {
-		return builtin_uint(call, ctx, result);
+	size_t stop = atomic_load(&job->stop);
+	while (index < stop &&
+	       !atomic_compare_exchange_weak(&job->stop, &stop, index)) {
 	}
-	if (func_name_equals(call->function, call->function_length, "double")) {
-		return builtin_double(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "string")) {
-		return builtin_string(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "type")) {
-		return builtin_type(call, ctx, result);
-	}
-
-	/* 时间函数 */
-	if (func_name_equals(call->function, call->function_length, "timestamp")) {
-		return builtin_timestamp(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "duration")) {
-		return builtin_duration(call, ctx, result);
-	}
-
-	/* 时间戳方法 */
-	if (func_name_equals(call->function, call->function_length, "getFullYear")) {
-		return builtin_getFullYear(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getMonth")) {
-		return builtin_getMonth(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getDayOfMonth")) {
-		return builtin_getDayOfMonth(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getDayOfWeek")) {
-		return builtin_getDayOfWeek(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getDayOfYear")) {
-		return builtin_getDayOfYear(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getHours")) {
-		return builtin_getHours(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getMinutes")) {
-		return builtin_getMinutes(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getSeconds")) {
-		return builtin_getSeconds(call, ctx, result);
-	}
-	if (func_name_equals(call->function, call->function_length, "getMilliseconds")) {
-		return builtin_getMilliseconds(call, ctx, result);
-	}
-
-	/* 查找上下文中注册的函数 */
-	char *func_name = strndup(call->function, call->function_length);
-	if (!func_name) {
-		set_error(ctx, "Out of memory");
-		return false;
-	}
-
-	cel_function_t *func = cel_context_get_function(ctx, func_name);
-	if (func) {
-		/* 求值所有参数 */
-		cel_value_t *args = NULL;
-		cel_value_t **arg_ptrs = NULL;
-		if (call->arg_count > 0) {
-			args = malloc(sizeof(cel_value_t) * call->arg_count);
-			arg_ptrs = malloc(sizeof(cel_value_t *) * call->arg_count);
-			if (!args || !arg_ptrs) {
-				free(func_name);
-				free(args);
-				free(arg_ptrs);
-				set_error(ctx, "Out of memory");
-				return false;
-			}
+}
 
-			for (size_t i = 0; i < call->arg_count; i++) {
-				if (!eval_node(call->args[i], ctx, &args[i])) {
-					free(func_name);
-					free(args);
-					free(arg_ptrs);
-					return false;
-				}
-				arg_ptrs[i] = &args[i];
+/**
+ * @brief 线程池任务：分块领取元素并求值
+ *
+ * 每个线程使用自己的帧与预算；预算继承调用者剩余的代价上限、
+ * 截止时间与递归深度。下标不小于 stop 的元素不再求值。
+ */
+static void parallel_worker(void *arg, size_t worker)
+{
+	(void)worker;
+	parallel_job_t *job = arg;
+
+	cel_exec_budget_t budget = {
+		.cost_limit = UINT64_MAX,
+		.clock_countdown = UINT32_MAX,
+		.exhausted = CEL_OK,
+		.depth_left = SIZE_MAX,
+	};
+	if (job->budget) {
+		const cel_exec_budget_t *caller = job->budget;
+		budget.depth_left = caller->depth_left;
+		if (caller->cost_limit != UINT64_MAX) {
+			budget.cost_limit = caller->cost_limit > caller->cost ?
+						    caller->cost_limit - caller->cost :
+						    0;
+		}
+		if (caller->deadline_ns) {
+			budget.deadline_ns = caller->deadline_ns;
+			budget.clock_countdown = BUDGET_CLOCK_INTERVAL;
+		}
+	}
+
+	/* 与调用者的帧共享变量名与外层帧，累加器不可见 */
+	eval_frame_t frame = *job->frame;
+	frame.iter_value = NULL;
+	frame.accu_value = cel_value_null();
+
+	/* 提交任务的线程也是参与线程，结束后恢复其状态 */
+	cel_exec_budget_t *previous_budget = current_budget;
+	const eval_frame_t *previous_frame = current_frame;
+	const cel_eval_parallel_t *previous_parallel = current_parallel;
+	cel_eval_error_t *previous_error = current_error;
+	current_budget = job->budget ? &budget : NULL;
+	current_frame = &frame;
+	current_parallel = NULL;
+	current_error = NULL;  /* 推测求值的错误在顺序重放时再报告 */
+
+	for (;;) {
+		size_t begin = atomic_fetch_add(&job->next, PARALLEL_CHUNK);
+		if (begin >= atomic_load(&job->stop)) {
+			break;
+		}
+
+		size_t end = job->count - begin > PARALLEL_CHUNK ?
+				     begin + PARALLEL_CHUNK :
+				     job->count;
+		uint64_t chunk_cost = 0;
+		for (size_t i = begin; i < end; i++) {
+			if (i >= atomic_load(&job->stop)) {
+				break;
 			}
-		}
-
-		/* 调用函数 */
-		cel_func_context_t func_ctx = {
-			.context = ctx,
-			.func_name = func_name,
-			.call_site = NULL
-		};
-
-		cel_result_t func_result = func->func(&func_ctx, arg_ptrs, call->arg_count);
-
-		free(func_name);
-		free(args);
-		free(arg_ptrs);
-
-		if (!func_result.is_ok) {
-			if (func_result.error) {
-				set_error(ctx, func_result.error->message);
-				cel_error_destroy(func_result.error);
-			} else {
-				set_error(ctx, "Function call failed");
+			uint64_t before = budget.cost;
+			frame.iter_value = job->list->items[i];
+			if (!parallel_element(job, i)) {
+				parallel_stop_at(job, i);
+				break;
 			}
-			return false;
+			chunk_cost += budget.cost - before;
 		}
-
-		/* 从 void* 复制返回值 */
-		if (func_result.value) {
-			*result = *(cel_value_t *)func_result.value;
-		} else {
-			*result = cel_value_null();
-		}
-		return true;
+		job->chunk_cost[begin / PARALLEL_CHUNK] = chunk_cost;
 	}
 
-	char error_msg[256];
-	snprintf(error_msg, sizeof(error_msg), "Unknown function: %s", func_name);
-	free(func_name);
-	set_error(ctx, error_msg);
-	return false;
+	current_budget = previous_budget;
+	current_frame = previous_frame;
+	current_parallel = previous_parallel;
+	current_error = previous_error;
 }
 
-/* ========== 列表字面量求值 ========== */
-
-static bool eval_list(const cel_ast_list_t *list, cel_context_t *ctx,
-		      cel_value_t *result)
+/**
+ * @brief 由初始累加器与 stop 之前的输出构造 map / filter 的累加器
+ */
+static bool parallel_collect(parallel_job_t *job, cel_context_t *ctx,
+			     eval_frame_t *frame, size_t stop)
 {
-	cel_list_t *cel_list = cel_list_create(list->element_count);
-	if (!cel_list) {
-		set_error(ctx, "Failed to create list");
-		return false;
+	cel_list_t *initial = frame->accu_value.value.list_value;
+	size_t initial_size = cel_list_size(initial);
+	size_t produced = 0;
+	for (size_t i = 0; i < stop; i++) {
+		produced += job->present[i];
 	}
 
-	for (size_t i = 0; i < list->element_count; i++) {
-		cel_value_t element;
-		if (!eval_node(list->elements[i], ctx, &element)) {
-			cel_list_release(cel_list);
-			return false;
-		}
-
-		if (!cel_list_append(cel_list, &element)) {
-			cel_list_release(cel_list);
-			set_error(ctx, "Failed to append to list");
-			return false;
-		}
-	}
-
-	result->type = CEL_TYPE_LIST;
-	result->value.list_value = cel_list;
-	return true;
-}
-
-/* ========== Map 字面量求值 ========== */
-
-static bool eval_map(const cel_ast_map_t *map, cel_context_t *ctx,
-		     cel_value_t *result)
-{
-	cel_map_t *cel_map = cel_map_create(map->entry_count > 0 ? map->entry_count : 16);
-	if (!cel_map) {
-		set_error(ctx, "Failed to create map");
+	cel_list_t *list = cel_list_create(initial_size + produced + 1);
+	if (!list) {
+		set_error(ctx, CEL_ERROR_OUT_OF_MEMORY, "Out of memory");
 		return false;
 	}
-
-	for (size_t i = 0; i < map->entry_count; i++) {
-		cel_value_t key, value;
-
-		if (!eval_node(map->entries[i].key, ctx, &key)) {
-			cel_map_release(cel_map);
-			return false;
-		}
-
-		if (!eval_node(map->entries[i].value, ctx, &value)) {
-			cel_map_release(cel_map);
+	for (size_t i = 0; i < initial_size; i++) {
+		if (!cel_list_append(list, initial->items[i])) {
+			cel_list_release(list);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Out of memory");
 			return false;
 		}
-
-		if (!cel_map_put(cel_map, &key, &value)) {
-			cel_map_release(cel_map);
-			set_error(ctx, "Failed to set map entry");
+	}
+	for (size_t i = 0; i < stop; i++) {
+		if (job->present[i] && !cel_list_append(list, &job->outputs[i])) {
+			cel_list_release(list);
+			set_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				  "Out of memory");
 			return false;
 		}
 	}
 
-	result->type = CEL_TYPE_MAP;
-	result->value.map_value = cel_map;
+	cel_value_destroy(&frame->accu_value);
+	frame->accu_value = cel_value_list(list);
 	return true;
 }
 
-/* ========== Comprehension 求值 ========== */
-
 /**
- * @brief 对 Comprehension 表达式求值
- *
- * Comprehension 执行模型:
- * 1. 求值 iter_range，得到要迭代的集合（List 或 Map）
- * 2. 求值 accu_init，初始化累加器变量
- * 3. 对集合中的每个元素:
- *    a. 将元素绑定到 iter_var
- *    b. 求值 loop_cond，如果为 false 则中断循环
- *    c. 求值 loop_step，更新累加器
- * 4. 求值 result 表达式，返回最终结果
+ * @brief 在线程池上并行求值列表推导式
  *
- * @param comp Comprehension 节点
- * @param ctx 求值上下文
- * @param result 输出结果
- * @return true 成功，false 失败
- */
-
-/**
- * @brief Comprehension 求值 (使用新的 cel_context API)
+ * 元素按块分发给参与线程；all / exists 遇到决定结果的元素、
+ * map / filter 遇到错误时记录其下标 stop，更大下标的元素不再求值。
+ * 结束后累加器为 stop 之前的元素顺序执行的结果，代价为这些元素的
+ * 代价之和，调用者从 stop 起继续顺序执行，因此结果、错误与代价都与
+ * 顺序执行相同。不满足条件 (没有线程池、范围小于阈值、形式不可
+ * 并行、线程池正忙或内存不足) 时不执行任何元素。
  *
- * Comprehension 语义:
- * 1. 求值 iter_range (列表或Map)
- * 2. 求值 accu_init (累加器初始值)
- * 3. 对集合中的每个元素:
- *    a. 将元素绑定到 iter_var
- *    b. 求值 loop_cond，如果为 false 则中断循环
- *    c. 求值 loop_step，更新累加器
- * 4. 求值 result 表达式，返回最终结果
+ * @param frame 调用者的帧 (累加器为初始值)
+ * @param resume 输出顺序执行的起始下标
+ * @return true 成功，false 超出执行预算
  */
-static bool eval_comprehension(const cel_ast_comprehension_t *comp,
-				 cel_context_t *ctx, cel_value_t *result)
+static bool eval_parallel(const cel_ast_comprehension_t *comp,
+			  cel_context_t *ctx, eval_frame_t *frame,
+			  cel_list_t *list, size_t *resume)
 {
-	if (!comp || !ctx || !result) {
-		set_error(ctx, "Invalid arguments to eval_comprehension");
-		return false;
-	}
+	*resume = 0;
 
-	/* 1. 求值迭代范围 */
-	cel_value_t iter_range_val;
-	if (!eval_node(comp->iter_range, ctx, &iter_range_val)) {
-		return false;
+	const cel_eval_parallel_t *parallel = current_parallel;
+	if (!parallel || cel_thread_pool_threads(parallel->pool) < 2) {
+		return true;
 	}
-
-	/* 检查迭代范围类型 */
-	if (iter_range_val.type != CEL_TYPE_LIST && iter_range_val.type != CEL_TYPE_MAP) {
-		set_error(ctx, "Comprehension iter_range must be a list or map");
-		cel_value_destroy(&iter_range_val);
-		return false;
+	size_t count = cel_list_size(list);
+	size_t threshold = parallel->threshold ? parallel->threshold :
+						  CEL_PARALLEL_THRESHOLD;
+	if (count < threshold) {
+		return true;
 	}
 
-	/* 2. 求值累加器初始值 */
-	cel_value_t accu_val;
-	if (!eval_node(comp->accu_init, ctx, &accu_val)) {
-		cel_value_destroy(&iter_range_val);
-		return false;
+	parallel_job_t job = {
+		.ctx = ctx,
+		.frame = frame,
+		.list = list,
+		.count = count,
+		.budget = current_budget,
+	};
+	if (!parallel_plan(comp, &frame->accu_value, &job.plan)) {
+		return true;
 	}
+	atomic_init(&job.next, 0);
+	atomic_init(&job.stop, count);
 
-	/* 创建子上下文用于管理累加器 */
-	cel_context_t *loop_ctx = cel_context_create_child(ctx);
-	if (!loop_ctx) {
-		set_error(ctx, "Failed to create loop context");
-		cel_value_destroy(&iter_range_val);
-		cel_value_destroy(&accu_val);
-		return false;
+	size_t chunks = (count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+	job.chunk_cost = calloc(chunks, sizeof(uint64_t));
+	if (job.plan.kind == PARALLEL_APPEND) {
+		job.outputs = malloc(count * sizeof(cel_value_t));
+		job.present = calloc(count, 1);
 	}
+	bool ready = job.chunk_cost && (job.plan.kind != PARALLEL_APPEND ||
+					(job.outputs && job.present));
 
-	/* 构造累加器变量名 */
-	char *accu_name = strndup(comp->accu_var, comp->accu_var_length);
-	if (!accu_name) {
-		set_error(ctx, "Out of memory");
-		cel_context_destroy(loop_ctx);
-		cel_value_destroy(&iter_range_val);
-		cel_value_destroy(&accu_val);
-		return false;
+	/* 线程池正忙时顺序执行 */
+	if (!ready ||
+	    !cel_thread_pool_run(parallel->pool, parallel_worker, &job)) {
+		free(job.chunk_cost);
+		free(job.outputs);
+		free(job.present);
+		return true;
 	}
 
-	/* 添加累加器到子上下文 */
-	if (cel_context_add_variable(loop_ctx, accu_name, &accu_val) != CEL_OK) {
-		set_error(ctx, "Failed to bind accumulator variable");
-		free(accu_name);
-		cel_context_destroy(loop_ctx);
-		cel_value_destroy(&iter_range_val);
-		cel_value_destroy(&accu_val);
-		return false;
+	size_t stop = atomic_load(&job.stop);
+	uint64_t cost = 0;
+	for (size_t c = 0; c * PARALLEL_CHUNK < stop; c++) {
+		cost = cost + job.chunk_cost[c] < cost ? UINT64_MAX :
+							  cost + job.chunk_cost[c];
 	}
 
-	bool success = false;
+	/*
+	 * 各线程的上限独立，合计代价可能超出调用者剩余的预算：此时丢弃
+	 * 并行结果，从头顺序执行，在与顺序执行相同的位置触发上限
+	 */
+	const cel_exec_budget_t *budget = job.budget;
+	bool keep = !budget || cost <= budget->cost_limit - budget->cost;
 
-	/* 3. 迭代处理 */
-	if (iter_range_val.type == CEL_TYPE_LIST) {
-		/* List 迭代 */
-		cel_list_t *list = iter_range_val.value.list_value;
-		size_t list_size = cel_list_size(list);
-
-		/* 构造循环变量名 */
-		char *iter_name = strndup(comp->iter_var, comp->iter_var_length);
-		if (!iter_name) {
-			set_error(ctx, "Out of memory");
-			goto cleanup;
+	bool success = true;
+	if (!keep) {
+		stop = 0;
+	} else if (job.plan.kind == PARALLEL_APPEND) {
+		success = parallel_collect(&job, ctx, frame, stop);
+	}
+	if (job.plan.kind == PARALLEL_APPEND) {
+		for (size_t i = 0; i < count; i++) {
+			if (job.present[i]) {
+				cel_value_destroy(&job.outputs[i]);
+			}
 		}
+	}
+	free(job.chunk_cost);
+	free(job.outputs);
+	free(job.present);
 
-		for (size_t i = 0; i < list_size; i++) {
-			/* 获取列表元素 */
-			cel_value_t *elem_ptr = cel_list_get(list, i);
-			if (!elem_ptr) {
-				set_error(ctx, "Failed to get list element");
-				free(iter_name);
-				goto cleanup;
-			}
+	if (success && keep && budget) {
+		success = budget_charge(current_budget, ctx, cost);
+	}
+	*resume = stop;
+	return success;
+}
 
-			/* 为每次迭代创建子上下文 */
-			cel_context_t *iter_ctx = cel_context_create_child(loop_ctx);
-			if (!iter_ctx) {
-				set_error(ctx, "Failed to create iteration context");
-				free(iter_name);
-				goto cleanup;
-			}
+#else /* !CEL_THREAD_SAFE */
 
-			/* 绑定循环变量 */
-			if (cel_context_add_variable(iter_ctx, iter_name, elem_ptr) != CEL_OK) {
-				set_error(ctx, "Failed to bind iteration variable");
-				cel_context_destroy(iter_ctx);
-				free(iter_name);
-				goto cleanup;
-			}
+static bool eval_parallel(const cel_ast_comprehension_t *comp,
+			  cel_context_t *ctx, eval_frame_t *frame,
+			  cel_list_t *list, size_t *resume)
+{
+	(void)comp;
+	(void)ctx;
+	(void)frame;
+	(void)list;
+	*resume = 0;
+	return true;
+}
 
-			/* 检查循环条件 */
-			cel_value_t cond_val;
-			if (!eval_node(comp->loop_cond, iter_ctx, &cond_val)) {
-				cel_context_destroy(iter_ctx);
-				free(iter_name);
-				goto cleanup;
-			}
+#endif /* CEL_THREAD_SAFE */
 
-			/* 条件必须是布尔值 */
-			if (cond_val.type != CEL_TYPE_BOOL) {
-				set_error(ctx, "Loop condition must be boolean");
-				cel_context_destroy(iter_ctx);
-				free(iter_name);
-				goto cleanup;
-			}
+/* ========== 错误处理 ========== */
 
-			/* 如果条件为 false，中断循环 */
-			if (!cond_val.value.bool_value) {
-				cel_context_destroy(iter_ctx);
-				break;
-			}
+cel_eval_error_t *cel_eval_error_enter(cel_eval_error_t *error)
+{
+	if (error) {
+		error->code = CEL_OK;
+		error->message = NULL;
+		error->detail[0] = '\0';
+		error->line = 0;
+		error->column = 0;
+	}
 
-			/* 求值循环步骤，更新累加器 */
-			cel_value_t new_accu_val;
-			if (!eval_node(comp->loop_step, iter_ctx, &new_accu_val)) {
-				cel_context_destroy(iter_ctx);
-				free(iter_name);
-				goto cleanup;
-			}
+	cel_eval_error_t *previous = current_error;
+	current_error = error;
+	return previous;
+}
 
-			/* 销毁迭代上下文 */
-			cel_context_destroy(iter_ctx);
+void cel_eval_error_leave(cel_eval_error_t *previous)
+{
+	current_error = previous;
+}
 
-			/* 更新累加器：移除旧值，添加新值 */
-			cel_context_remove_variable(loop_ctx, accu_name);
-			if (cel_context_add_variable(loop_ctx, accu_name, &new_accu_val) != CEL_OK) {
-				set_error(ctx, "Failed to update accumulator");
-				cel_value_destroy(&new_accu_val);
-				free(iter_name);
-				goto cleanup;
-			}
-		}
+void cel_eval_report_error(cel_context_t *ctx, cel_error_code_e code,
+			   const char *message)
+{
+	set_error(ctx, code, message);
+}
 
-		free(iter_name);
+void cel_eval_report_error_detail(cel_context_t *ctx, cel_error_code_e code,
+				  const char *message, const char *detail,
+				  size_t detail_length)
+{
+	set_error_detail(ctx, code, message, detail, detail_length);
+}
 
-	} else {
-		/* TODO: Map 迭代（目前只支持 List） */
-		set_error(ctx, "Map comprehension not yet implemented");
-		goto cleanup;
+void cel_eval_error_locate(size_t line, size_t column)
+{
+	cel_eval_error_t *error = current_error;
+	if (error && error->code != CEL_OK && error->line == 0) {
+		error->line = line;
+		error->column = column;
 	}
+}
 
-	/* 4. 返回结果 */
-	if (comp->result) {
-		/* 求值结果表达式 */
-		if (!eval_node(comp->result, loop_ctx, result)) {
-			goto cleanup;
-		}
-	} else {
-		/* 没有结果表达式，返回累加器的值 */
-		cel_value_t *final_accu = cel_context_get_variable(loop_ctx, accu_name);
-		if (final_accu) {
-			*result = *final_accu;
-		} else {
-			set_error(ctx, "Failed to get final accumulator value");
-			goto cleanup;
+size_t cel_eval_error_format(const cel_eval_error_t *error, char *buffer,
+			     size_t size)
+{
+	if (!buffer) {
+		size = 0;
+	}
+	if (!error || error->code == CEL_OK) {
+		if (size) {
+			buffer[0] = '\0';
 		}
+		return 0;
 	}
 
-	success = true;
+	const char *message = error->message ?
+				      error->message :
+				      cel_error_code_string(error->code);
+	int length;
+	if (error->line) {
+		length = snprintf(buffer, size, "%s%s%s (line %zu, column %zu)",
+				  message, error->detail[0] ? ": " : "",
+				  error->detail, error->line, error->column);
+	} else {
+		length = snprintf(buffer, size, "%s%s%s", message,
+				  error->detail[0] ? ": " : "", error->detail);
+	}
+	return length > 0 ? (size_t)length : 0;
+}
 
-cleanup:
-	free(accu_name);
-	cel_context_destroy(loop_ctx);
-	cel_value_destroy(&iter_range_val);
+/**
+ * @brief 记录错误 (覆盖之前的错误，位置在失败返回时补充)
+ */
+static void set_error(cel_context_t *ctx, cel_error_code_e code,
+		      const char *message)
+{
+	(void)ctx;
+	cel_eval_error_t *error = current_error;
+	if (!error) {
+		return;
+	}
 
-	return success;
+	error->code = code;
+	error->message = message;
+	error->detail[0] = '\0';
+	error->line = 0;
+	error->column = 0;
 }
 
-/* ========== 错误处理 ========== */
-
-static void set_error(cel_context_t *ctx, const char *message)
+static void set_error_detail(cel_context_t *ctx, cel_error_code_e code,
+			     const char *message, const char *detail,
+			     size_t detail_length)
 {
-	/* TODO: Task 4.2 - 实现新的错误处理机制 */
-	(void)ctx;
-	fprintf(stderr, "CEL Error: %s\n", message);
+	set_error(ctx, code, message);
+
+	cel_eval_error_t *error = current_error;
+	if (!error || !detail) {
+		return;
+	}
+
+	if (detail_length >= sizeof(error->detail)) {
+		detail_length = sizeof(error->detail) - 1;
+	}
+	memcpy(error->detail, detail, detail_length);
+	error->detail[detail_length] = '\0';
 }
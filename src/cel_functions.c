@@ -1 +1,882 @@
-// Placeholder - to be implemented
+/**
+ * @file cel_functions.c
+ * @brief CEL 内置函数实现与重载表
+ */
+
+#define _GNU_SOURCE  /* for timegm */
+
+#include "cel/cel_functions.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_regex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ========== 内置函数实现 ========== */
+
+/*
+ * 内置函数接收已求值的参数 (方法调用时 args[0] 为接收者)，
+ * 参数数量已由重载解析保证。参数由调用者持有；写入 result
+ * 的值为新引用。
+ */
+
+/**
+ * @brief 内置 size() 函数
+ * 支持: size(container) 或 container.size()
+ */
+static bool builtin_size(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t arg = args[0];
+
+	if (arg.type == CEL_TYPE_STRING) {
+		*result = cel_value_int((int64_t)cel_string_length(&arg));
+		return true;
+	} else if (arg.type == CEL_TYPE_LIST) {
+		*result = cel_value_int((int64_t)arg.value.list_value->length);
+		return true;
+	} else if (arg.type == CEL_TYPE_MAP) {
+		*result = cel_value_int((int64_t)arg.value.map_value->size);
+		return true;
+	} else if (arg.type == CEL_TYPE_BYTES) {
+		*result = cel_value_int((int64_t)arg.value.bytes_value->length);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "size() requires string, bytes, list, or map");
+		return false;
+	}
+}
+
+/**
+ * @brief 内置 contains() 函数
+ * 支持: contains(container, elem) 或 container.contains(elem)
+ */
+static bool builtin_contains(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t container = args[0];
+	cel_value_t elem = args[1];
+
+	if (container.type == CEL_TYPE_LIST) {
+		cel_list_t *list = container.value.list_value;
+		for (size_t i = 0; i < list->length; i++) {
+			cel_value_t *item = cel_list_get(list, i);
+			if (item && cel_value_equals(&elem, item)) {
+				*result = cel_value_bool(true);
+				return true;
+			}
+		}
+		*result = cel_value_bool(false);
+		return true;
+	} else if (container.type == CEL_TYPE_STRING) {
+		if (elem.type != CEL_TYPE_STRING) {
+			cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+					      "string.contains() requires string argument");
+			return false;
+		}
+		/* 使用 strstr 检查子串 */
+		const char *haystack = container.value.string_value->data;
+		const char *needle = elem.value.string_value->data;
+		*result = cel_value_bool(strstr(haystack, needle) != NULL);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "contains() requires list or string");
+		return false;
+	}
+}
+
+/**
+ * @brief 内置 startsWith() 函数
+ * 支持: startsWith(str, prefix) 或 str.startsWith(prefix)
+ */
+static bool builtin_startsWith(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t str = args[0];
+	cel_value_t prefix = args[1];
+
+	if (str.type != CEL_TYPE_STRING || prefix.type != CEL_TYPE_STRING) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "startsWith() requires string arguments");
+		return false;
+	}
+
+	size_t str_len = cel_string_length(&str);
+	size_t prefix_len = cel_string_length(&prefix);
+
+	if (prefix_len > str_len) {
+		*result = cel_value_bool(false);
+		return true;
+	}
+
+	*result = cel_value_bool(
+		memcmp(str.value.string_value->data,
+		       prefix.value.string_value->data,
+		       prefix_len) == 0);
+	return true;
+}
+
+/**
+ * @brief 内置 endsWith() 函数
+ * 支持: endsWith(str, suffix) 或 str.endsWith(suffix)
+ */
+static bool builtin_endsWith(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t str = args[0];
+	cel_value_t suffix = args[1];
+
+	if (str.type != CEL_TYPE_STRING || suffix.type != CEL_TYPE_STRING) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "endsWith() requires string arguments");
+		return false;
+	}
+
+	size_t str_len = cel_string_length(&str);
+	size_t suffix_len = cel_string_length(&suffix);
+
+	if (suffix_len > str_len) {
+		*result = cel_value_bool(false);
+		return true;
+	}
+
+	*result = cel_value_bool(
+		memcmp(str.value.string_value->data + (str_len - suffix_len),
+		       suffix.value.string_value->data,
+		       suffix_len) == 0);
+	return true;
+}
+
+#ifdef CEL_ENABLE_REGEX
+/**
+ * @brief 内置 matches() 函数 - 正则表达式匹配
+ * 支持: matches(str, pattern) 或 str.matches(pattern)
+ */
+static bool builtin_matches(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t str = args[0];
+	cel_value_t pattern = args[1];
+
+	if (str.type != CEL_TYPE_STRING || pattern.type != CEL_TYPE_STRING) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "matches() requires string arguments");
+		return false;
+	}
+
+	/* 动态模式经过全局缓存，字面量模式由字节码在编译期编译 */
+	char error_msg[512];
+	cel_regex_t *regex = cel_regex_cache_get(pattern.value.string_value->data,
+						 cel_string_length(&pattern),
+						 error_msg, sizeof(error_msg));
+	if (!regex) {
+		cel_eval_report_error_detail(ctx, CEL_ERROR_INVALID_ARGUMENT,
+					     "Invalid regular expression",
+					     error_msg, strlen(error_msg));
+		return false;
+	}
+
+	bool matched;
+	bool ok = cel_regex_match(regex, str.value.string_value->data,
+				  cel_string_length(&str), &matched);
+	cel_regex_release(regex);
+	if (!ok) {
+		cel_eval_report_error(ctx, CEL_ERROR_INTERNAL,
+				      "regex match failed");
+		return false;
+	}
+
+	*result = cel_value_bool(matched);
+	return true;
+}
+#endif /* CEL_ENABLE_REGEX */
+
+/**
+ * @brief 内置 int() 类型转换函数
+ */
+static bool builtin_int(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t arg = args[0];
+
+	switch (arg.type) {
+	case CEL_TYPE_INT:
+		*result = cel_value_retain(&arg);
+		return true;
+	case CEL_TYPE_UINT:
+		/* 检查溢出 */
+		if (arg.value.uint_value > (uint64_t)INT64_MAX) {
+			cel_eval_report_error(ctx, CEL_ERROR_OVERFLOW,
+					      "uint to int overflow");
+			return false;
+		}
+		*result = cel_value_int((int64_t)arg.value.uint_value);
+		return true;
+	case CEL_TYPE_DOUBLE:
+		*result = cel_value_int((int64_t)arg.value.double_value);
+		return true;
+	case CEL_TYPE_STRING: {
+		/* 尝试解析字符串为整数 */
+		const char *str = arg.value.string_value->data;
+		char *end;
+		long long val = strtoll(str, &end, 10);
+		if (*end != '\0') {
+			cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+					      "invalid integer string");
+			return false;
+		}
+		*result = cel_value_int((int64_t)val);
+		return true;
+	}
+	default:
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "int() cannot convert this type");
+		return false;
+	}
+}
+
+/**
+ * @brief 内置 uint() 类型转换函数
+ */
+static bool builtin_uint(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t arg = args[0];
+
+	switch (arg.type) {
+	case CEL_TYPE_UINT:
+		*result = cel_value_retain(&arg);
+		return true;
+	case CEL_TYPE_INT:
+		if (arg.value.int_value < 0) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+					      "int to uint: negative value");
+			return false;
+		}
+		*result = cel_value_uint((uint64_t)arg.value.int_value);
+		return true;
+	case CEL_TYPE_DOUBLE:
+		if (arg.value.double_value < 0) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+					      "double to uint: negative value");
+			return false;
+		}
+		*result = cel_value_uint((uint64_t)arg.value.double_value);
+		return true;
+	case CEL_TYPE_STRING: {
+		const char *str = arg.value.string_value->data;
+		char *end;
+		unsigned long long val = strtoull(str, &end, 10);
+		if (*end != '\0') {
+			cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+					      "invalid unsigned integer string");
+			return false;
+		}
+		*result = cel_value_uint((uint64_t)val);
+		return true;
+	}
+	default:
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "uint() cannot convert this type");
+		return false;
+	}
+}
+
+/**
+ * @brief 内置 double() 类型转换函数
+ */
+static bool builtin_double(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t arg = args[0];
+
+	switch (arg.type) {
+	case CEL_TYPE_DOUBLE:
+		*result = cel_value_retain(&arg);
+		return true;
+	case CEL_TYPE_INT:
+		*result = cel_value_double((double)arg.value.int_value);
+		return true;
+	case CEL_TYPE_UINT:
+		*result = cel_value_double((double)arg.value.uint_value);
+		return true;
+	case CEL_TYPE_STRING: {
+		const char *str = arg.value.string_value->data;
+		char *end;
+		double val = strtod(str, &end);
+		if (*end != '\0') {
+			cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+					      "invalid double string");
+			return false;
+		}
+		*result = cel_value_double(val);
+		return true;
+	}
+	default:
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "double() cannot convert this type");
+		return false;
+	}
+}
+
+/**
+ * @brief 内置 string() 类型转换函数
+ */
+static bool builtin_string(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t arg = args[0];
+
+	char buf[64];
+	switch (arg.type) {
+	case CEL_TYPE_STRING:
+		*result = cel_value_retain(&arg);
+		return true;
+	case CEL_TYPE_INT:
+		snprintf(buf, sizeof(buf), "%ld", (long)arg.value.int_value);
+		*result = cel_value_string(buf);
+		return true;
+	case CEL_TYPE_UINT:
+		snprintf(buf, sizeof(buf), "%lu", (unsigned long)arg.value.uint_value);
+		*result = cel_value_string(buf);
+		return true;
+	case CEL_TYPE_DOUBLE:
+		snprintf(buf, sizeof(buf), "%g", arg.value.double_value);
+		*result = cel_value_string(buf);
+		return true;
+	case CEL_TYPE_BOOL:
+		*result = cel_value_string(arg.value.bool_value ? "true" : "false");
+		return true;
+	default:
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "string() cannot convert this type");
+		return false;
+	}
+}
+
+/**
+ * @brief 内置 type() 函数
+ */
+static bool builtin_type(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	(void)ctx;
+	cel_value_t arg = args[0];
+
+	const char *type_name;
+	switch (arg.type) {
+	case CEL_TYPE_NULL:
+		type_name = "null_type";
+		break;
+	case CEL_TYPE_BOOL:
+		type_name = "bool";
+		break;
+	case CEL_TYPE_INT:
+		type_name = "int";
+		break;
+	case CEL_TYPE_UINT:
+		type_name = "uint";
+		break;
+	case CEL_TYPE_DOUBLE:
+		type_name = "double";
+		break;
+	case CEL_TYPE_STRING:
+		type_name = "string";
+		break;
+	case CEL_TYPE_BYTES:
+		type_name = "bytes";
+		break;
+	case CEL_TYPE_LIST:
+		type_name = "list";
+		break;
+	case CEL_TYPE_MAP:
+		type_name = "map";
+		break;
+	case CEL_TYPE_TIMESTAMP:
+		type_name = "google.protobuf.Timestamp";
+		break;
+	case CEL_TYPE_DURATION:
+		type_name = "google.protobuf.Duration";
+		break;
+	default:
+		type_name = "unknown";
+		break;
+	}
+
+	*result = cel_value_string(type_name);
+	return true;
+}
+
+/* ========== 时间戳方法 ========== */
+
+/**
+ * @brief 从 Unix 时间戳获取 tm 结构
+ */
+static bool timestamp_to_tm(int64_t seconds, int16_t offset_minutes, struct tm *tm_out)
+{
+	time_t t = (time_t)seconds;
+	/* 应用时区偏移 */
+	t += offset_minutes * 60;
+
+	struct tm *result;
+#ifdef _WIN32
+	result = gmtime(&t);
+	if (result) {
+		*tm_out = *result;
+	}
+#else
+	result = gmtime_r(&t, tm_out);
+#endif
+	return result != NULL;
+}
+
+/**
+ * @brief timestamp.getFullYear() - 获取年份
+ */
+static bool builtin_getFullYear(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t ts = args[0];
+
+	if (ts.type != CEL_TYPE_TIMESTAMP) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getFullYear() requires timestamp");
+		return false;
+	}
+
+	struct tm tm;
+	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
+			     ts.value.timestamp_value.offset_minutes, &tm)) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+				      "Failed to convert timestamp");
+		return false;
+	}
+
+	*result = cel_value_int(tm.tm_year + 1900);
+	return true;
+}
+
+/**
+ * @brief timestamp.getMonth() - 获取月份 (0-11)
+ */
+static bool builtin_getMonth(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t ts = args[0];
+
+	if (ts.type != CEL_TYPE_TIMESTAMP) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getMonth() requires timestamp");
+		return false;
+	}
+
+	struct tm tm;
+	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
+			     ts.value.timestamp_value.offset_minutes, &tm)) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+				      "Failed to convert timestamp");
+		return false;
+	}
+
+	*result = cel_value_int(tm.tm_mon);
+	return true;
+}
+
+/**
+ * @brief timestamp.getDayOfMonth() - 获取日期 (1-31)
+ */
+static bool builtin_getDayOfMonth(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t ts = args[0];
+
+	if (ts.type != CEL_TYPE_TIMESTAMP) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getDayOfMonth() requires timestamp");
+		return false;
+	}
+
+	struct tm tm;
+	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
+			     ts.value.timestamp_value.offset_minutes, &tm)) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+				      "Failed to convert timestamp");
+		return false;
+	}
+
+	*result = cel_value_int(tm.tm_mday);
+	return true;
+}
+
+/**
+ * @brief timestamp.getDayOfWeek() - 获取星期几 (0=Sunday, 6=Saturday)
+ */
+static bool builtin_getDayOfWeek(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t ts = args[0];
+
+	if (ts.type != CEL_TYPE_TIMESTAMP) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getDayOfWeek() requires timestamp");
+		return false;
+	}
+
+	struct tm tm;
+	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
+			     ts.value.timestamp_value.offset_minutes, &tm)) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+				      "Failed to convert timestamp");
+		return false;
+	}
+
+	*result = cel_value_int(tm.tm_wday);
+	return true;
+}
+
+/**
+ * @brief timestamp.getDayOfYear() - 获取年中第几天 (0-365)
+ */
+static bool builtin_getDayOfYear(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t ts = args[0];
+
+	if (ts.type != CEL_TYPE_TIMESTAMP) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getDayOfYear() requires timestamp");
+		return false;
+	}
+
+	struct tm tm;
+	if (!timestamp_to_tm(ts.value.timestamp_value.seconds,
+			     ts.value.timestamp_value.offset_minutes, &tm)) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+				      "Failed to convert timestamp");
+		return false;
+	}
+
+	*result = cel_value_int(tm.tm_yday);
+	return true;
+}
+
+/**
+ * @brief timestamp.getHours() 或 duration.getHours()
+ */
+static bool builtin_getHours(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t val = args[0];
+
+	if (val.type == CEL_TYPE_TIMESTAMP) {
+		struct tm tm;
+		if (!timestamp_to_tm(val.value.timestamp_value.seconds,
+				     val.value.timestamp_value.offset_minutes, &tm)) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+					      "Failed to convert timestamp");
+			return false;
+		}
+		*result = cel_value_int(tm.tm_hour);
+		return true;
+	} else if (val.type == CEL_TYPE_DURATION) {
+		/* duration.getHours() 返回总小时数 */
+		int64_t total_hours = val.value.duration_value.seconds / 3600;
+		*result = cel_value_int(total_hours);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getHours() requires timestamp or duration");
+		return false;
+	}
+}
+
+/**
+ * @brief timestamp.getMinutes() 或 duration.getMinutes()
+ */
+static bool builtin_getMinutes(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t val = args[0];
+
+	if (val.type == CEL_TYPE_TIMESTAMP) {
+		struct tm tm;
+		if (!timestamp_to_tm(val.value.timestamp_value.seconds,
+				     val.value.timestamp_value.offset_minutes, &tm)) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+					      "Failed to convert timestamp");
+			return false;
+		}
+		*result = cel_value_int(tm.tm_min);
+		return true;
+	} else if (val.type == CEL_TYPE_DURATION) {
+		/* duration.getMinutes() 返回总分钟数 */
+		int64_t total_minutes = val.value.duration_value.seconds / 60;
+		*result = cel_value_int(total_minutes);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getMinutes() requires timestamp or duration");
+		return false;
+	}
+}
+
+/**
+ * @brief timestamp.getSeconds() 或 duration.getSeconds()
+ */
+static bool builtin_getSeconds(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t val = args[0];
+
+	if (val.type == CEL_TYPE_TIMESTAMP) {
+		struct tm tm;
+		if (!timestamp_to_tm(val.value.timestamp_value.seconds,
+				     val.value.timestamp_value.offset_minutes, &tm)) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+					      "Failed to convert timestamp");
+			return false;
+		}
+		*result = cel_value_int(tm.tm_sec);
+		return true;
+	} else if (val.type == CEL_TYPE_DURATION) {
+		/* duration.getSeconds() 返回总秒数 */
+		*result = cel_value_int(val.value.duration_value.seconds);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getSeconds() requires timestamp or duration");
+		return false;
+	}
+}
+
+/**
+ * @brief timestamp.getMilliseconds() 或 duration.getMilliseconds()
+ */
+static bool builtin_getMilliseconds(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	cel_value_t val = args[0];
+
+	if (val.type == CEL_TYPE_TIMESTAMP) {
+		/* timestamp 的毫秒部分 */
+		int64_t ms = val.value.timestamp_value.nanoseconds / 1000000;
+		*result = cel_value_int(ms);
+		return true;
+	} else if (val.type == CEL_TYPE_DURATION) {
+		/* duration 的总毫秒数 */
+		int64_t total_ms = val.value.duration_value.seconds * 1000 +
+				   val.value.duration_value.nanoseconds / 1000000;
+		*result = cel_value_int(total_ms);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "getMilliseconds() requires timestamp or duration");
+		return false;
+	}
+}
+
+/**
+ * @brief timestamp() 函数 - 从 RFC3339 字符串解析时间戳
+ */
+static bool builtin_timestamp(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	/* timestamp(string) 或 timestamp(int) */
+	cel_value_t arg = args[0];
+
+	if (arg.type == CEL_TYPE_INT) {
+		/* 直接从 Unix 时间戳创建 */
+		*result = cel_value_timestamp(arg.value.int_value, 0, 0);
+		return true;
+	} else if (arg.type == CEL_TYPE_STRING) {
+		/* 解析 RFC3339 格式: "2021-08-15T10:30:00Z" */
+		const char *s = arg.value.string_value->data;
+		int year, month, day, hour, min, sec;
+		char tz;
+
+		int parsed = sscanf(s, "%d-%d-%dT%d:%d:%d%c",
+				    &year, &month, &day, &hour, &min, &sec, &tz);
+
+		if (parsed < 6) {
+			cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+					      "Invalid RFC3339 timestamp format");
+			return false;
+		}
+
+		/* 转换为 Unix 时间戳 */
+		struct tm tm = {0};
+		tm.tm_year = year - 1900;
+		tm.tm_mon = month - 1;
+		tm.tm_mday = day;
+		tm.tm_hour = hour;
+		tm.tm_min = min;
+		tm.tm_sec = sec;
+
+		time_t t;
+#ifdef _WIN32
+		t = _mkgmtime(&tm);
+#else
+		t = timegm(&tm);
+#endif
+		if (t == -1) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_RANGE,
+					      "Failed to convert timestamp");
+			return false;
+		}
+
+		*result = cel_value_timestamp((int64_t)t, 0, 0);
+		return true;
+	} else {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "timestamp() requires int or string argument");
+		return false;
+	}
+}
+
+/**
+ * @brief duration() 函数 - 从字符串解析时长
+ */
+static bool builtin_duration(cel_context_t *ctx, const cel_value_t *args,
+			  cel_value_t *result)
+{
+	/* duration(string) 格式: "1h30m45s" 或 "3600s" */
+	cel_value_t arg = args[0];
+
+	if (arg.type != CEL_TYPE_STRING) {
+		cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+				      "duration() requires string argument");
+		return false;
+	}
+
+	const char *s = arg.value.string_value->data;
+	int64_t total_seconds = 0;
+	int64_t current_num = 0;
+	bool negative = false;
+
+	if (*s == '-') {
+		negative = true;
+		s++;
+	}
+
+	while (*s) {
+		if (*s >= '0' && *s <= '9') {
+			current_num = current_num * 10 + (*s - '0');
+		} else if (*s == 'h' || *s == 'H') {
+			total_seconds += current_num * 3600;
+			current_num = 0;
+		} else if (*s == 'm' || *s == 'M') {
+			total_seconds += current_num * 60;
+			current_num = 0;
+		} else if (*s == 's' || *s == 'S') {
+			total_seconds += current_num;
+			current_num = 0;
+		} else {
+			cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+					      "Invalid duration format");
+			return false;
+		}
+		s++;
+	}
+
+	/* 如果字符串末尾没有单位，假设为秒 */
+	total_seconds += current_num;
+
+	if (negative) {
+		total_seconds = -total_seconds;
+	}
+
+	*result = cel_value_duration(total_seconds, 0);
+	return true;
+}
+
+/* ========== 重载表 ========== */
+
+#define BUILTIN(name, styles, arg_count, fn) \
+	{ name, sizeof(name) - 1, styles, arg_count, fn }
+
+#ifdef CEL_ENABLE_REGEX
+#define BUILTIN_MATCHES builtin_matches
+#else
+#define BUILTIN_MATCHES NULL
+#endif
+
+static const cel_builtin_t builtins[CEL_FUNC_COUNT] = {
+	[CEL_FUNC_SIZE] = BUILTIN("size", CEL_CALL_ANY, 1, builtin_size),
+	[CEL_FUNC_CONTAINS] = BUILTIN("contains", CEL_CALL_ANY, 2, builtin_contains),
+	[CEL_FUNC_STARTS_WITH] = BUILTIN("startsWith", CEL_CALL_ANY, 2, builtin_startsWith),
+	[CEL_FUNC_ENDS_WITH] = BUILTIN("endsWith", CEL_CALL_ANY, 2, builtin_endsWith),
+	[CEL_FUNC_MATCHES] = BUILTIN("matches", CEL_CALL_ANY, 2, BUILTIN_MATCHES),
+
+	[CEL_FUNC_INT] = BUILTIN("int", CEL_CALL_GLOBAL, 1, builtin_int),
+	[CEL_FUNC_UINT] = BUILTIN("uint", CEL_CALL_GLOBAL, 1, builtin_uint),
+	[CEL_FUNC_DOUBLE] = BUILTIN("double", CEL_CALL_GLOBAL, 1, builtin_double),
+	[CEL_FUNC_STRING] = BUILTIN("string", CEL_CALL_GLOBAL, 1, builtin_string),
+	[CEL_FUNC_TYPE] = BUILTIN("type", CEL_CALL_GLOBAL, 1, builtin_type),
+
+	[CEL_FUNC_TIMESTAMP] = BUILTIN("timestamp", CEL_CALL_GLOBAL, 1, builtin_timestamp),
+	[CEL_FUNC_DURATION] = BUILTIN("duration", CEL_CALL_GLOBAL, 1, builtin_duration),
+	[CEL_FUNC_GET_FULL_YEAR] = BUILTIN("getFullYear", CEL_CALL_METHOD, 1, builtin_getFullYear),
+	[CEL_FUNC_GET_MONTH] = BUILTIN("getMonth", CEL_CALL_METHOD, 1, builtin_getMonth),
+	[CEL_FUNC_GET_DAY_OF_MONTH] = BUILTIN("getDayOfMonth", CEL_CALL_METHOD, 1, builtin_getDayOfMonth),
+	[CEL_FUNC_GET_DAY_OF_WEEK] = BUILTIN("getDayOfWeek", CEL_CALL_METHOD, 1, builtin_getDayOfWeek),
+	[CEL_FUNC_GET_DAY_OF_YEAR] = BUILTIN("getDayOfYear", CEL_CALL_METHOD, 1, builtin_getDayOfYear),
+	[CEL_FUNC_GET_HOURS] = BUILTIN("getHours", CEL_CALL_METHOD, 1, builtin_getHours),
+	[CEL_FUNC_GET_MINUTES] = BUILTIN("getMinutes", CEL_CALL_METHOD, 1, builtin_getMinutes),
+	[CEL_FUNC_GET_SECONDS] = BUILTIN("getSeconds", CEL_CALL_METHOD, 1, builtin_getSeconds),
+	[CEL_FUNC_GET_MILLISECONDS] = BUILTIN("getMilliseconds", CEL_CALL_METHOD, 1, builtin_getMilliseconds),
+};
+
+/* ========== 解析与调用 API ========== */
+
+bool cel_builtin_resolve(const char *name, size_t name_length, bool has_target,
+			 size_t arg_count, cel_function_id_e *id)
+{
+	if (!name || !id) {
+		return false;
+	}
+
+	unsigned style = has_target ? CEL_CALL_METHOD : CEL_CALL_GLOBAL;
+	for (size_t i = 0; i < CEL_FUNC_COUNT; i++) {
+		const cel_builtin_t *builtin = &builtins[i];
+		if (builtin->fn && builtin->name_length == name_length &&
+		    builtin->arg_count == arg_count &&
+		    (builtin->styles & style) &&
+		    memcmp(builtin->name, name, name_length) == 0) {
+			*id = (cel_function_id_e)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool cel_builtin_exists(const char *name, size_t name_length)
+{
+	if (!name) {
+		return false;
+	}
+
+	for (size_t i = 0; i < CEL_FUNC_COUNT; i++) {
+		if (builtins[i].fn && builtins[i].name_length == name_length &&
+		    memcmp(builtins[i].name, name, name_length) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const cel_builtin_t *cel_builtin_get(cel_function_id_e id)
+{
+	if ((size_t)id >= CEL_FUNC_COUNT) {
+		return NULL;
+	}
+	return &builtins[id];
+}
+
+bool cel_builtin_call(cel_function_id_e id, cel_context_t *ctx,
+		      const cel_value_t *args, cel_value_t *result)
+{
+	return builtins[id].fn(ctx, args, result);
+}
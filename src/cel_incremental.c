@@ -0,0 +1,552 @@
+/**
+ * @file cel_incremental.c
+ * @brief CEL 增量求值实现
+ *
+ * 创建句柄时对 AST 副本做两次前序遍历：第一次计算每个节点依赖的
+ * 自由变量 (位图)、引用的最外层推导式变量以及是否调用上下文函数；
+ * 第二次在可缓存且依赖集合与父节点不同的节点处设置缓存点，因此
+ * 依赖相同变量的一串节点只缓存最外层的一个。缓存点按前序存放，
+ * 每个缓存点记录其子树中缓存点的范围。
+ *
+ * 缓存有效时，缓存点在 AST 中的位置被替换为持有缓存值的字面量节点，
+ * 外层缓存点与整个表达式直接使用普通的树遍历求值；缓存失效后换回
+ * 原子树。求值时由外向内检查缓存点，依赖未变化的缓存点连同其内部的
+ * 缓存点一起跳过，需要重新计算的缓存点先刷新内部的缓存点再求值。
+ */
+
+#include "cel/cel_incremental.h"
+#include "cel/cel_ast.h"
+#include "cel/cel_functions.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 依赖位图可以表示的变量数量 */
+#define INCREMENTAL_MAX_TRACKED 64
+
+/* 没有引用外层推导式变量 */
+#define NO_BINDING SIZE_MAX
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 节点的依赖信息
+ */
+typedef struct {
+	uint64_t deps;               /* 依赖的自由变量 (位图) */
+	size_t bound;                /* 引用的推导式变量的最外层作用域层级 */
+	bool opaque;                 /* 调用上下文函数或依赖未跟踪的变量 */
+} node_info_t;
+
+/**
+ * @brief 缓存点
+ */
+typedef struct {
+	cel_ast_node_t **slot;       /* 子树在 AST 中的位置 */
+	cel_ast_node_t *subtree;     /* 原子树 (内部缓存点可能已替换为字面量) */
+	cel_ast_node_t *literal;     /* 持有缓存值的字面量节点 */
+	uint64_t deps;               /* 依赖的变量 (位图) */
+	size_t end;                  /* 子树中最后一个缓存点之后的下标 */
+	bool valid;                  /* 缓存值有效 (slot 指向 literal) */
+} cache_point_t;
+
+/**
+ * @brief 增量求值句柄 (内部实现)
+ */
+struct cel_incremental {
+	cel_ast_node_t *ast;         /* AST 副本 */
+	char *source;                /* 源代码副本 (AST 中的名称指向副本) */
+	size_t eval_depth;           /* 原程序的 AST 深度 */
+	char **names;                /* 自由变量名 (null 结尾) */
+	size_t name_count;           /* 自由变量数量 */
+	size_t name_capacity;        /* 变量名数组容量 */
+	uint64_t *versions;          /* 上次求值时的变量版本 (前 64 个变量) */
+	cache_point_t *points;       /* 缓存点 (前序) */
+	size_t point_count;          /* 缓存点数量 */
+	size_t point_capacity;       /* 缓存点数组容量 */
+	size_t recomputed;           /* 上次求值重新计算的缓存点数量 */
+};
+
+/**
+ * @brief 推导式变量的作用域 (内层在前)
+ */
+typedef struct scope {
+	const cel_ast_comprehension_t *comp;
+	size_t level;                /* 嵌套层级 (最外层推导式的循环体为 1) */
+	const struct scope *parent;
+} scope_t;
+
+/**
+ * @brief 分析状态
+ */
+typedef struct {
+	cel_incremental_t *inc;
+	node_info_t *infos;          /* 节点信息 (前序) */
+	size_t info_count;           /* 节点数量 */
+	size_t info_capacity;        /* 节点信息数组容量 */
+	size_t cursor;               /* 第二次遍历的当前节点 */
+	cel_error_code_e status;     /* 第一个错误 */
+} builder_t;
+
+/**
+ * @brief 子节点访问函数
+ */
+typedef void (*visit_fn)(builder_t *b, cel_ast_node_t **slot,
+			 const scope_t *scope, void *arg);
+
+/* ========== 遍历 ========== */
+
+static bool names_equal(const char *a, size_t a_length, const char *b,
+			size_t b_length)
+{
+	return a && a_length == b_length && memcmp(a, b, a_length) == 0;
+}
+
+/**
+ * @brief 按前序依次访问子节点 (推导式的循环体位于新的作用域中)
+ */
+static void visit_children(builder_t *b, cel_ast_node_t *node,
+			   const scope_t *scope, visit_fn visit, void *arg)
+{
+	switch (node->type) {
+	case CEL_AST_UNARY:
+		visit(b, &node->as.unary.operand, scope, arg);
+		break;
+	case CEL_AST_BINARY:
+		visit(b, &node->as.binary.left, scope, arg);
+		visit(b, &node->as.binary.right, scope, arg);
+		break;
+	case CEL_AST_TERNARY:
+		visit(b, &node->as.ternary.condition, scope, arg);
+		visit(b, &node->as.ternary.if_true, scope, arg);
+		visit(b, &node->as.ternary.if_false, scope, arg);
+		break;
+	case CEL_AST_SELECT:
+		visit(b, &node->as.select.operand, scope, arg);
+		break;
+	case CEL_AST_INDEX:
+		visit(b, &node->as.index.operand, scope, arg);
+		visit(b, &node->as.index.index, scope, arg);
+		break;
+	case CEL_AST_CALL:
+		visit(b, &node->as.call.target, scope, arg);
+		for (size_t i = 0; i < node->as.call.arg_count; i++) {
+			visit(b, &node->as.call.args[i], scope, arg);
+		}
+		break;
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			visit(b, &node->as.list.elements[i], scope, arg);
+		}
+		break;
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			visit(b, &node->as.map.entries[i].key, scope, arg);
+			visit(b, &node->as.map.entries[i].value, scope, arg);
+		}
+		break;
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			visit(b, &node->as.struct_lit.fields[i].value, scope, arg);
+		}
+		break;
+	case CEL_AST_COMPREHENSION: {
+		cel_ast_comprehension_t *comp = &node->as.comprehension;
+		visit(b, &comp->iter_range, scope, arg);
+		visit(b, &comp->accu_init, scope, arg);
+		scope_t inner = {comp, (scope ? scope->level : 0) + 1, scope};
+		visit(b, &comp->loop_cond, &inner, arg);
+		visit(b, &comp->loop_step, &inner, arg);
+		visit(b, &comp->result, &inner, arg);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/* ========== 依赖分析 ========== */
+
+/**
+ * @brief 查找或登记自由变量，返回其编号
+ */
+static size_t variable_index(builder_t *b, const char *name, size_t length)
+{
+	cel_incremental_t *inc = b->inc;
+	for (size_t i = 0; i < inc->name_count; i++) {
+		if (strlen(inc->names[i]) == length &&
+		    memcmp(inc->names[i], name, length) == 0) {
+			return i;
+		}
+	}
+
+	if (inc->name_count == inc->name_capacity) {
+		size_t capacity = inc->name_capacity ? inc->name_capacity * 2 : 8;
+		char **names = realloc(inc->names, capacity * sizeof(char *));
+		if (!names) {
+			b->status = CEL_ERROR_OUT_OF_MEMORY;
+			return SIZE_MAX;
+		}
+		inc->names = names;
+		inc->name_capacity = capacity;
+	}
+
+	char *copy = malloc(length + 1);
+	if (!copy) {
+		b->status = CEL_ERROR_OUT_OF_MEMORY;
+		return SIZE_MAX;
+	}
+	memcpy(copy, name, length);
+	copy[length] = '\0';
+	inc->names[inc->name_count] = copy;
+	return inc->name_count++;
+}
+
+/**
+ * @brief 记录标识符引用 (推导式变量或自由变量)
+ */
+static void reference(builder_t *b, node_info_t *info, const scope_t *scope,
+		      const char *name, size_t length)
+{
+	for (; scope; scope = scope->parent) {
+		const cel_ast_comprehension_t *comp = scope->comp;
+		if (names_equal(comp->iter_var, comp->iter_var_length, name,
+				length) ||
+		    names_equal(comp->iter_var2, comp->iter_var2_length, name,
+				length) ||
+		    names_equal(comp->accu_var, comp->accu_var_length, name,
+				length)) {
+			info->bound = scope->level;
+			return;
+		}
+	}
+
+	size_t index = variable_index(b, name, length);
+	if (index < INCREMENTAL_MAX_TRACKED) {
+		info->deps |= UINT64_C(1) << index;
+	} else {
+		info->opaque = true;
+	}
+}
+
+/**
+ * @brief 第一次遍历：计算节点的依赖信息并合并到父节点
+ */
+static void analyze(builder_t *b, cel_ast_node_t **slot, const scope_t *scope,
+		    void *arg)
+{
+	cel_ast_node_t *node = *slot;
+	if (!node || b->status != CEL_OK) {
+		return;
+	}
+
+	if (b->info_count == b->info_capacity) {
+		size_t capacity = b->info_capacity ? b->info_capacity * 2 : 32;
+		node_info_t *infos = realloc(b->infos,
+					     capacity * sizeof(node_info_t));
+		if (!infos) {
+			b->status = CEL_ERROR_OUT_OF_MEMORY;
+			return;
+		}
+		b->infos = infos;
+		b->info_capacity = capacity;
+	}
+	size_t index = b->info_count++;
+
+	node_info_t info = {
+		.deps = 0,
+		.bound = NO_BINDING,
+		.opaque = false,
+	};
+	if (node->type == CEL_AST_IDENT) {
+		reference(b, &info, scope, node->as.ident.name,
+			  node->as.ident.length);
+	} else if (node->type == CEL_AST_CALL) {
+		/* 内置函数没有副作用，上下文函数的结果不缓存 */
+		const cel_ast_call_t *call = &node->as.call;
+		bool has_target = call->target != NULL;
+		cel_function_id_e id;
+		info.opaque = !cel_builtin_resolve(
+			call->function, call->function_length, has_target,
+			call->arg_count + (has_target ? 1 : 0), &id);
+	}
+
+	visit_children(b, node, scope, analyze, &info);
+	b->infos[index] = info;
+
+	node_info_t *parent = arg;
+	if (parent) {
+		parent->deps |= info.deps;
+		parent->opaque = parent->opaque || info.opaque;
+		if (info.bound < parent->bound) {
+			parent->bound = info.bound;
+		}
+	}
+}
+
+/* ========== 缓存点 ========== */
+
+/**
+ * @brief 父节点的缓存状态
+ */
+typedef struct {
+	uint64_t deps;
+	bool cacheable;
+} placement_t;
+
+/**
+ * @brief 求值代价不高于读取缓存的节点
+ */
+static bool is_trivial(const cel_ast_node_t *node)
+{
+	return node->type == CEL_AST_LITERAL || node->type == CEL_AST_IDENT ||
+	       (node->type == CEL_AST_SELECT &&
+		node->as.select.operand->type == CEL_AST_IDENT);
+}
+
+static size_t add_point(builder_t *b, cel_ast_node_t **slot, uint64_t deps)
+{
+	cel_incremental_t *inc = b->inc;
+	if (inc->point_count == inc->point_capacity) {
+		size_t capacity = inc->point_capacity ? inc->point_capacity * 2 : 8;
+		cache_point_t *points = realloc(inc->points,
+						capacity * sizeof(cache_point_t));
+		if (!points) {
+			b->status = CEL_ERROR_OUT_OF_MEMORY;
+			return SIZE_MAX;
+		}
+		inc->points = points;
+		inc->point_capacity = capacity;
+	}
+
+	cel_ast_node_t *literal = cel_ast_create_literal(cel_value_null(),
+							 (*slot)->loc);
+	if (!literal) {
+		b->status = CEL_ERROR_OUT_OF_MEMORY;
+		return SIZE_MAX;
+	}
+
+	inc->points[inc->point_count] = (cache_point_t){
+		.slot = slot,
+		.subtree = *slot,
+		.literal = literal,
+		.deps = deps,
+		.end = inc->point_count + 1,
+		.valid = false,
+	};
+	return inc->point_count++;
+}
+
+/**
+ * @brief 第二次遍历：在依赖集合发生变化的可缓存节点处设置缓存点
+ */
+static void place(builder_t *b, cel_ast_node_t **slot, const scope_t *scope,
+		  void *arg)
+{
+	cel_ast_node_t *node = *slot;
+	if (!node || b->status != CEL_OK) {
+		return;
+	}
+
+	const node_info_t *info = &b->infos[b->cursor++];
+	size_t level = scope ? scope->level : 0;
+	placement_t self = {
+		.deps = info->deps,
+		.cacheable = !info->opaque && info->bound > level,
+	};
+
+	/* 与可缓存的父节点依赖相同的子树随父节点一起缓存 */
+	const placement_t *parent = arg;
+	size_t point = SIZE_MAX;
+	if (self.cacheable && !is_trivial(node) &&
+	    (!parent || !parent->cacheable || parent->deps != self.deps)) {
+		point = add_point(b, slot, self.deps);
+	}
+
+	visit_children(b, node, scope, place, &self);
+	if (point != SIZE_MAX && b->status == CEL_OK) {
+		b->inc->points[point].end = b->inc->point_count;
+	}
+}
+
+/* ========== 增量求值 API ========== */
+
+cel_incremental_t *cel_incremental_create(const cel_program_t *program)
+{
+	if (!program || !program->ast || !program->source) {
+		return NULL;
+	}
+
+	cel_incremental_t *inc = calloc(1, sizeof(cel_incremental_t));
+	if (!inc) {
+		return NULL;
+	}
+
+	inc->source = malloc(program->source_length + 1);
+	if (!inc->source) {
+		free(inc);
+		return NULL;
+	}
+	memcpy(inc->source, program->source, program->source_length + 1);
+	inc->eval_depth = program->eval_depth;
+
+	inc->ast = cel_ast_copy(program->ast, program->source,
+				program->source_length, inc->source);
+	if (!inc->ast) {
+		cel_incremental_destroy(inc);
+		return NULL;
+	}
+
+	builder_t builder = {
+		.inc = inc,
+		.status = CEL_OK,
+	};
+	analyze(&builder, &inc->ast, NULL, NULL);
+	place(&builder, &inc->ast, NULL, NULL);
+	free(builder.infos);
+
+	/* 版本 0 表示尚未求值，第一次求值时所有变量都视为已变化 */
+	size_t tracked = inc->name_count < INCREMENTAL_MAX_TRACKED ?
+				 inc->name_count : INCREMENTAL_MAX_TRACKED;
+	inc->versions = calloc(tracked ? tracked : 1, sizeof(uint64_t));
+	if (builder.status != CEL_OK || !inc->versions) {
+		cel_incremental_destroy(inc);
+		return NULL;
+	}
+	return inc;
+}
+
+void cel_incremental_destroy(cel_incremental_t *incremental)
+{
+	if (!incremental) {
+		return;
+	}
+
+	/* 先换回原子树，再分别销毁字面量与 AST */
+	for (size_t i = 0; i < incremental->point_count; i++) {
+		cache_point_t *point = &incremental->points[i];
+		*point->slot = point->subtree;
+		cel_ast_destroy(point->literal);
+	}
+	free(incremental->points);
+	cel_ast_destroy(incremental->ast);
+
+	for (size_t i = 0; i < incremental->name_count; i++) {
+		free(incremental->names[i]);
+	}
+	free(incremental->names);
+	free(incremental->versions);
+	free(incremental->source);
+	free(incremental);
+}
+
+/**
+ * @brief 比较变量版本，返回自上次求值以来变化的变量 (位图)
+ */
+static uint64_t collect_changes(cel_incremental_t *inc,
+				const cel_context_t *ctx)
+{
+	uint64_t changed = 0;
+	for (size_t i = 0; i < inc->name_count && i < INCREMENTAL_MAX_TRACKED;
+	     i++) {
+		uint64_t version = cel_context_get_variable_version(
+			ctx, inc->names[i]);
+		if (version == 0 || version != inc->versions[i]) {
+			changed |= UINT64_C(1) << i;
+		}
+		inc->versions[i] = version;
+	}
+	return changed;
+}
+
+/**
+ * @brief 刷新缓存点及其内部的缓存点，返回下一个待检查的缓存点
+ */
+static size_t refresh(cel_incremental_t *inc, cel_context_t *ctx,
+		      size_t index, uint64_t changed, uint64_t *cost)
+{
+	cache_point_t *point = &inc->points[index];
+	if (point->valid && (point->deps & changed) == 0) {
+		return point->end;
+	}
+
+	for (size_t i = index + 1; i < point->end;) {
+		i = refresh(inc, ctx, i, changed, cost);
+	}
+
+	cel_program_t piece = {
+		.ast = point->subtree,
+		.eval_depth = inc->eval_depth,
+	};
+	cel_execute_result_t result = cel_execute(&piece, ctx);
+	*cost += result.cost;
+	inc->recomputed++;
+
+	if (result.success) {
+		cel_value_destroy(&point->literal->as.literal.value);
+		point->literal->as.literal.value = result.value;
+		result.value = cel_value_null();
+		*point->slot = point->literal;
+		point->valid = true;
+	} else {
+		/* 错误留待整个表达式求值时按原语义报告 */
+		*point->slot = point->subtree;
+		point->valid = false;
+	}
+	cel_execute_result_destroy(&result);
+	return point->end;
+}
+
+cel_execute_result_t cel_incremental_evaluate(cel_incremental_t *incremental,
+					      cel_context_t *ctx)
+{
+	if (!incremental || !ctx) {
+		cel_execute_result_t result = {0};
+		result.value = cel_value_null();
+		result.error = cel_error_create(
+			CEL_ERROR_INVALID_ARGUMENT,
+			"Incremental handle or context is NULL");
+		result.eval_error.code = CEL_ERROR_INVALID_ARGUMENT;
+		return result;
+	}
+
+	uint64_t changed = collect_changes(incremental, ctx);
+	uint64_t cost = 0;
+	incremental->recomputed = 0;
+	for (size_t i = 0; i < incremental->point_count;) {
+		i = refresh(incremental, ctx, i, changed, &cost);
+	}
+
+	cel_program_t root = {
+		.ast = incremental->ast,
+		.eval_depth = incremental->eval_depth,
+	};
+	cel_execute_result_t result = cel_execute(&root, ctx);
+	result.cost += cost;
+	return result;
+}
+
+void cel_incremental_invalidate(cel_incremental_t *incremental)
+{
+	if (!incremental) {
+		return;
+	}
+	for (size_t i = 0; i < incremental->point_count; i++) {
+		incremental->points[i].valid = false;
+	}
+}
+
+size_t cel_incremental_cache_count(const cel_incremental_t *incremental)
+{
+	return incremental ? incremental->point_count : 0;
+}
+
+size_t cel_incremental_variable_count(const cel_incremental_t *incremental)
+{
+	return incremental ? incremental->name_count : 0;
+}
+
+size_t cel_incremental_recomputed_count(const cel_incremental_t *incremental)
+{
+	return incremental ? incremental->recomputed : 0;
+}
@@ -357,7 +357,7 @@ cel_error_code_e cel_macro_expand_map(cel_macro_helper_t *helper,
 		cel_ast_node_t *transform = args[1];
 
 		/* 创建 [transform] 列表 */
-		cel_ast_node_t **list_elements = malloc(sizeof(cel_ast_node_t *));
+		cel_ast_node_t **list_elements = cel_ast_alloc(sizeof(cel_ast_node_t *));
 		if (!list_elements) {
 			return CEL_ERROR_OUT_OF_MEMORY;
 		}
@@ -385,7 +385,7 @@ cel_error_code_e cel_macro_expand_map(cel_macro_helper_t *helper,
 		cel_ast_node_t *transform = args[2];
 
 		/* 创建 [transform] 列表 */
-		cel_ast_node_t **list_elements = malloc(sizeof(cel_ast_node_t *));
+		cel_ast_node_t **list_elements = cel_ast_alloc(sizeof(cel_ast_node_t *));
 		if (!list_elements) {
 			return CEL_ERROR_OUT_OF_MEMORY;
 		}
@@ -450,7 +450,7 @@ cel_error_code_e cel_macro_expand_filter(cel_macro_helper_t *helper,
 	cel_token_location_t loc = {0};
 
 	/* 创建 [x] 列表 (循环变量本身) */
-	cel_ast_node_t **list_elements = malloc(sizeof(cel_ast_node_t *));
+	cel_ast_node_t **list_elements = cel_ast_alloc(sizeof(cel_ast_node_t *));
 	if (!list_elements) {
 		return CEL_ERROR_OUT_OF_MEMORY;
 	}
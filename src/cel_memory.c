@@ -191,3 +191,34 @@ void arena_stats(const arena_t *arena, size_t *total_allocated,
 		*block_count = arena->block_count;
 	}
 }
+
+/* ========== 执行期临时分配 ========== */
+
+/* 当前线程安装的临时分配区 (没有时为 NULL) */
+static _Thread_local arena_t *current_scratch = NULL;
+
+arena_t *arena_scratch_enter(arena_t *arena)
+{
+	arena_t *previous = current_scratch;
+	current_scratch = arena;
+	return previous;
+}
+
+void arena_scratch_leave(arena_t *previous)
+{
+	current_scratch = previous;
+}
+
+void *arena_scratch_alloc(size_t size, bool *scratch)
+{
+	void *ptr = current_scratch ? arena_alloc(current_scratch, size) : NULL;
+	*scratch = ptr != NULL;
+	return ptr ? ptr : malloc(size);
+}
+
+void arena_scratch_free(void *ptr, bool scratch)
+{
+	if (!scratch) {
+		free(ptr);
+	}
+}
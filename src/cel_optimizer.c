@@ -0,0 +1,941 @@
+/**
+ * @file cel_optimizer.c
+ * @brief CEL AST 优化器实现
+ *
+ * 常量折叠按后序遍历 AST: 先折叠子节点，子节点全部为字面量时
+ * 使用树遍历求值器对当前节点求值，并以结果替换该节点。
+ *
+ * 推导式融合同样按后序遍历，链式的 map / filter 由内向外逐级并入
+ * 外层推导式。
+ */
+
+#include "cel/cel_optimizer.h"
+#include "cel/cel_context.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 折叠状态
+ */
+typedef struct {
+	cel_context_t *ctx;          /* 求值上下文 (不含任何变量与函数) */
+	cel_error_code_e status;     /* 第一个错误 */
+	bool comprehensions;         /* 是否尝试对整个推导式求值 (部分求值) */
+} folder_t;
+
+static bool fold_node(folder_t *f, cel_ast_node_t **slot);
+
+/* ========== 辅助函数 ========== */
+
+/**
+ * @brief 以节点的求值结果替换节点
+ *
+ * 求值失败时保留原节点，使执行时报告相同的错误。
+ *
+ * @return true 节点已替换为字面量
+ */
+static bool replace_with_value(folder_t *f, cel_ast_node_t **slot)
+{
+	cel_value_t value;
+	if (!cel_eval(*slot, f->ctx, &value)) {
+		return false;
+	}
+
+	cel_ast_node_t *literal = cel_ast_create_literal(value, (*slot)->loc);
+	if (!literal) {
+		cel_value_destroy(&value);
+		f->status = CEL_ERROR_OUT_OF_MEMORY;
+		return false;
+	}
+
+	cel_ast_destroy(*slot);
+	*slot = literal;
+	return true;
+}
+
+/**
+ * @brief 以子节点替换节点 (子节点从原节点中摘除)
+ */
+static void replace_with_child(cel_ast_node_t **slot, cel_ast_node_t **child)
+{
+	cel_ast_node_t *node = *child;
+	*child = NULL;
+	cel_ast_destroy(*slot);
+	*slot = node;
+}
+
+/**
+ * @brief 折叠一组子节点
+ *
+ * @return true 所有子节点均为字面量
+ */
+static bool fold_nodes(folder_t *f, cel_ast_node_t **nodes, size_t count)
+{
+	bool all_constant = true;
+	for (size_t i = 0; i < count; i++) {
+		if (!fold_node(f, &nodes[i])) {
+			all_constant = false;
+		}
+	}
+	return all_constant;
+}
+
+/* ========== 各类节点 ========== */
+
+static bool fold_binary(folder_t *f, cel_ast_node_t **slot)
+{
+	cel_ast_binary_t *binary = &(*slot)->as.binary;
+	bool left = fold_node(f, &binary->left);
+	bool right = fold_node(f, &binary->right);
+
+	/* false && x => false, true || x => true (与执行时的短路语义一致) */
+	if (left && (binary->op == CEL_BINARY_AND ||
+		     binary->op == CEL_BINARY_OR)) {
+		const cel_value_t *value = &binary->left->as.literal.value;
+		bool short_circuit = binary->op == CEL_BINARY_OR;
+		if (value->type == CEL_TYPE_BOOL &&
+		    value->value.bool_value == short_circuit) {
+			replace_with_child(slot, &binary->left);
+			return true;
+		}
+	}
+
+	return left && right && replace_with_value(f, slot);
+}
+
+static bool fold_ternary(folder_t *f, cel_ast_node_t **slot)
+{
+	cel_ast_ternary_t *ternary = &(*slot)->as.ternary;
+	bool condition = fold_node(f, &ternary->condition);
+	bool if_true = fold_node(f, &ternary->if_true);
+	bool if_false = fold_node(f, &ternary->if_false);
+
+	/* 条件为常量时只保留被选中的分支 */
+	if (condition) {
+		const cel_value_t *value = &ternary->condition->as.literal.value;
+		if (value->type == CEL_TYPE_BOOL) {
+			bool taken = value->value.bool_value;
+			replace_with_child(slot, taken ? &ternary->if_true
+						       : &ternary->if_false);
+			return taken ? if_true : if_false;
+		}
+	}
+
+	return condition && if_true && if_false && replace_with_value(f, slot);
+}
+
+static bool fold_call(folder_t *f, cel_ast_node_t **slot)
+{
+	cel_ast_call_t *call = &(*slot)->as.call;
+	bool constant = true;
+
+	if (call->target && !fold_node(f, &call->target)) {
+		constant = false;
+	}
+	if (!fold_nodes(f, call->args, call->arg_count)) {
+		constant = false;
+	}
+
+	/* 只有内置函数是纯函数，上下文函数在执行时才能确定 */
+	size_t arg_count = call->arg_count + (call->target ? 1 : 0);
+	cel_function_id_e id;
+	if (!constant ||
+	    !cel_builtin_resolve(call->function, call->function_length,
+				 call->target != NULL, arg_count, &id)) {
+		return false;
+	}
+
+	return replace_with_value(f, slot);
+}
+
+static bool fold_map(folder_t *f, cel_ast_node_t **slot)
+{
+	cel_ast_map_t *map = &(*slot)->as.map;
+	bool constant = true;
+
+	for (size_t i = 0; i < map->entry_count; i++) {
+		if (!fold_node(f, &map->entries[i].key)) {
+			constant = false;
+		}
+		if (!fold_node(f, &map->entries[i].value)) {
+			constant = false;
+		}
+	}
+
+	return constant && replace_with_value(f, slot);
+}
+
+static bool fold_comprehension(folder_t *f, cel_ast_node_t **slot)
+{
+	/* 推导式依赖循环变量，只折叠其中的常量子树 */
+	cel_ast_comprehension_t *comp = &(*slot)->as.comprehension;
+	bool range = fold_node(f, &comp->iter_range);
+	fold_node(f, &comp->accu_init);
+	fold_node(f, &comp->loop_cond);
+	fold_node(f, &comp->loop_step);
+	fold_node(f, &comp->result);
+
+	/*
+	 * 部分求值时迭代范围已知的推导式整体求值一次；循环体引用未知
+	 * 变量或上下文函数时求值失败，推导式保持原样
+	 */
+	return f->comprehensions && range && replace_with_value(f, slot);
+}
+
+/**
+ * @brief 折叠节点
+ *
+ * @param slot 指向节点的指针 (节点可能被替换)
+ * @return true 折叠后的节点为字面量
+ */
+static bool fold_node(folder_t *f, cel_ast_node_t **slot)
+{
+	cel_ast_node_t *node = *slot;
+	if (!node || f->status != CEL_OK) {
+		return false;
+	}
+
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		return true;
+
+	case CEL_AST_IDENT:
+		return false;
+
+	case CEL_AST_UNARY:
+		return fold_node(f, &node->as.unary.operand) &&
+		       replace_with_value(f, slot);
+
+	case CEL_AST_BINARY:
+		return fold_binary(f, slot);
+
+	case CEL_AST_TERNARY:
+		return fold_ternary(f, slot);
+
+	case CEL_AST_SELECT:
+		return fold_node(f, &node->as.select.operand) &&
+		       replace_with_value(f, slot);
+
+	case CEL_AST_INDEX: {
+		bool operand = fold_node(f, &node->as.index.operand);
+		bool index = fold_node(f, &node->as.index.index);
+		return operand && index && replace_with_value(f, slot);
+	}
+
+	case CEL_AST_CALL:
+		return fold_call(f, slot);
+
+	case CEL_AST_LIST:
+		return fold_nodes(f, node->as.list.elements,
+				  node->as.list.element_count) &&
+		       replace_with_value(f, slot);
+
+	case CEL_AST_MAP:
+		return fold_map(f, slot);
+
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			fold_node(f, &node->as.struct_lit.fields[i].value);
+		}
+		return false;
+
+	case CEL_AST_COMPREHENSION:
+		return fold_comprehension(f, slot);
+
+	default:
+		return false;
+	}
+}
+
+/* ========== 推导式融合 ========== */
+
+/**
+ * @brief map / filter 形式的推导式中可替换部分的位置
+ */
+typedef struct {
+	cel_ast_node_t **guard;     /* 过滤条件 (NULL 表示 map) */
+	cel_ast_node_t **element;   /* 追加的元素 */
+} append_parts_t;
+
+static bool names_equal(const char *name, size_t length, const char *other,
+			size_t other_length)
+{
+	return name && other && length == other_length &&
+	       memcmp(name, other, length) == 0;
+}
+
+static bool is_ident(const cel_ast_node_t *node, const char *name,
+		     size_t length)
+{
+	return node && node->type == CEL_AST_IDENT &&
+	       names_equal(node->as.ident.name, node->as.ident.length, name,
+			   length);
+}
+
+static bool is_bool_literal(const cel_ast_node_t *node)
+{
+	return node && node->type == CEL_AST_LITERAL &&
+	       node->as.literal.value.type == CEL_TYPE_BOOL;
+}
+
+static bool is_empty_list(const cel_ast_node_t *node)
+{
+	if (!node) {
+		return false;
+	}
+	if (node->type == CEL_AST_LIST) {
+		return node->as.list.element_count == 0;
+	}
+	return node->type == CEL_AST_LITERAL &&
+	       node->as.literal.value.type == CEL_TYPE_LIST &&
+	       cel_list_size(node->as.literal.value.value.list_value) == 0;
+}
+
+/**
+ * @brief 识别 map / filter 形式
+ *
+ * 累加器初始为 []，循环条件为 true，结果为累加器，
+ * 步骤为 @result + [E] 或 G ? @result + [E] : @result。
+ */
+static bool match_append(cel_ast_comprehension_t *comp, append_parts_t *parts)
+{
+	const char *accu = comp->accu_var;
+	size_t accu_length = comp->accu_var_length;
+	if (comp->iter_var2 || !is_empty_list(comp->accu_init) ||
+	    !is_bool_literal(comp->loop_cond) ||
+	    !comp->loop_cond->as.literal.value.value.bool_value ||
+	    !is_ident(comp->result, accu, accu_length) || !comp->loop_step) {
+		return false;
+	}
+
+	cel_ast_node_t **step = &comp->loop_step;
+	parts->guard = NULL;
+	if ((*step)->type == CEL_AST_TERNARY &&
+	    is_ident((*step)->as.ternary.if_false, accu, accu_length)) {
+		parts->guard = &(*step)->as.ternary.condition;
+		step = &(*step)->as.ternary.if_true;
+	}
+
+	cel_ast_node_t *append = *step;
+	if (append->type != CEL_AST_BINARY ||
+	    append->as.binary.op != CEL_BINARY_ADD ||
+	    !is_ident(append->as.binary.left, accu, accu_length) ||
+	    append->as.binary.right->type != CEL_AST_LIST ||
+	    append->as.binary.right->as.list.element_count != 1) {
+		return false;
+	}
+	parts->element = &append->as.binary.right->as.list.elements[0];
+	return true;
+}
+
+/**
+ * @brief 统计名称的自由出现次数
+ *
+ * @param nested 输出是否有出现位于内层推导式的循环体中 (可为 NULL)
+ */
+static size_t count_free(const cel_ast_node_t *node, const char *name,
+			 size_t length, bool *nested)
+{
+	if (!node) {
+		return 0;
+	}
+
+	size_t count = 0;
+	switch (node->type) {
+	case CEL_AST_IDENT:
+		return is_ident(node, name, length) ? 1 : 0;
+	case CEL_AST_UNARY:
+		return count_free(node->as.unary.operand, name, length, nested);
+	case CEL_AST_BINARY:
+		return count_free(node->as.binary.left, name, length, nested) +
+		       count_free(node->as.binary.right, name, length, nested);
+	case CEL_AST_TERNARY:
+		return count_free(node->as.ternary.condition, name, length, nested) +
+		       count_free(node->as.ternary.if_true, name, length, nested) +
+		       count_free(node->as.ternary.if_false, name, length, nested);
+	case CEL_AST_SELECT:
+		return count_free(node->as.select.operand, name, length, nested);
+	case CEL_AST_INDEX:
+		return count_free(node->as.index.operand, name, length, nested) +
+		       count_free(node->as.index.index, name, length, nested);
+	case CEL_AST_CALL:
+		count = count_free(node->as.call.target, name, length, nested);
+		for (size_t i = 0; i < node->as.call.arg_count; i++) {
+			count += count_free(node->as.call.args[i], name, length,
+					    nested);
+		}
+		return count;
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			count += count_free(node->as.list.elements[i], name, length,
+					    nested);
+		}
+		return count;
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			count += count_free(node->as.map.entries[i].key, name,
+					    length, nested) +
+				 count_free(node->as.map.entries[i].value, name,
+					    length, nested);
+		}
+		return count;
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			count += count_free(node->as.struct_lit.fields[i].value,
+					    name, length, nested);
+		}
+		return count;
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *comp = &node->as.comprehension;
+		count = count_free(comp->iter_range, name, length, nested) +
+			count_free(comp->accu_init, name, length, nested);
+		if (names_equal(comp->iter_var, comp->iter_var_length, name, length) ||
+		    names_equal(comp->iter_var2, comp->iter_var2_length, name, length) ||
+		    names_equal(comp->accu_var, comp->accu_var_length, name, length)) {
+			return count;
+		}
+		size_t body = count_free(comp->loop_cond, name, length, nested) +
+			      count_free(comp->loop_step, name, length, nested) +
+			      count_free(comp->result, name, length, nested);
+		if (body > 0 && nested) {
+			*nested = true;
+		}
+		return count + body;
+	}
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief 是否可以复制而不重复计算 (标识符或其字段访问)
+ */
+static bool is_copyable(const cel_ast_node_t *node)
+{
+	while (node && node->type == CEL_AST_SELECT) {
+		node = node->as.select.operand;
+	}
+	return node && node->type == CEL_AST_IDENT;
+}
+
+static cel_ast_node_t *copy_node(const cel_ast_node_t *node)
+{
+	if (node->type == CEL_AST_IDENT) {
+		return cel_ast_create_ident(node->as.ident.name,
+					    node->as.ident.length, node->loc);
+	}
+
+	cel_ast_node_t *operand = copy_node(node->as.select.operand);
+	if (!operand) {
+		return NULL;
+	}
+	cel_ast_node_t *copy = cel_ast_create_select(
+		operand, node->as.select.field, node->as.select.field_length,
+		node->as.select.optional, node->loc);
+	if (!copy) {
+		cel_ast_destroy(operand);
+	}
+	return copy;
+}
+
+/**
+ * @brief 依次以 replacements 替换名称的自由出现
+ *
+ * 调用者保证没有出现位于内层推导式的循环体中，因此不进入循环体。
+ */
+static void substitute(cel_ast_node_t **slot, const char *name, size_t length,
+		       cel_ast_node_t ***replacements)
+{
+	cel_ast_node_t *node = *slot;
+	if (!node) {
+		return;
+	}
+
+	switch (node->type) {
+	case CEL_AST_IDENT:
+		if (is_ident(node, name, length)) {
+			*slot = **replacements;
+			(*replacements)++;
+			cel_ast_destroy(node);
+		}
+		break;
+	case CEL_AST_UNARY:
+		substitute(&node->as.unary.operand, name, length, replacements);
+		break;
+	case CEL_AST_BINARY:
+		substitute(&node->as.binary.left, name, length, replacements);
+		substitute(&node->as.binary.right, name, length, replacements);
+		break;
+	case CEL_AST_TERNARY:
+		substitute(&node->as.ternary.condition, name, length, replacements);
+		substitute(&node->as.ternary.if_true, name, length, replacements);
+		substitute(&node->as.ternary.if_false, name, length, replacements);
+		break;
+	case CEL_AST_SELECT:
+		substitute(&node->as.select.operand, name, length, replacements);
+		break;
+	case CEL_AST_INDEX:
+		substitute(&node->as.index.operand, name, length, replacements);
+		substitute(&node->as.index.index, name, length, replacements);
+		break;
+	case CEL_AST_CALL:
+		substitute(&node->as.call.target, name, length, replacements);
+		for (size_t i = 0; i < node->as.call.arg_count; i++) {
+			substitute(&node->as.call.args[i], name, length,
+				   replacements);
+		}
+		break;
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			substitute(&node->as.list.elements[i], name, length,
+				   replacements);
+		}
+		break;
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			substitute(&node->as.map.entries[i].key, name, length,
+				   replacements);
+			substitute(&node->as.map.entries[i].value, name, length,
+				   replacements);
+		}
+		break;
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			substitute(&node->as.struct_lit.fields[i].value, name,
+				   length, replacements);
+		}
+		break;
+	case CEL_AST_COMPREHENSION:
+		substitute(&node->as.comprehension.iter_range, name, length,
+			   replacements);
+		substitute(&node->as.comprehension.accu_init, name, length,
+			   replacements);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * @brief 外层推导式的循环条件在融合后对被过滤的元素也会求值，
+ *        只接受不会出错的形式: true、@result 或 !@result (累加器为布尔值)
+ */
+static bool is_safe_condition(const cel_ast_comprehension_t *comp)
+{
+	const cel_ast_node_t *cond = comp->loop_cond;
+	if (is_bool_literal(cond) && cond->as.literal.value.value.bool_value) {
+		return true;
+	}
+	if (cond && cond->type == CEL_AST_UNARY &&
+	    cond->as.unary.op == CEL_UNARY_NOT) {
+		cond = cond->as.unary.operand;
+	}
+	return is_ident(cond, comp->accu_var, comp->accu_var_length) &&
+	       is_bool_literal(comp->accu_init);
+}
+
+/**
+ * @brief 将迭代范围为 map / filter 推导式的推导式融合为一个推导式
+ *
+ * outer 迭代 inner 的结果 (循环变量 y)，inner 迭代 R (循环变量 x，
+ * 守卫 G，元素 E)。融合后 outer 直接迭代 R，循环变量为 x，
+ * 步骤 S 改写为 G ? S[y := E] : @result；outer 也是 map / filter 时
+ * 两个守卫合并为 G && G'，结果仍是 map / filter 形式，可继续融合。
+ *
+ * @return CEL_OK 已融合或不满足条件 (AST 不变)，CEL_ERROR_OUT_OF_MEMORY 内存不足 (AST 不变)
+ */
+static cel_error_code_e fuse_comprehension(cel_ast_node_t *node)
+{
+	cel_ast_comprehension_t *outer = &node->as.comprehension;
+	cel_ast_node_t *range = outer->iter_range;
+	append_parts_t inner_parts, outer_parts;
+	if (outer->iter_var2 || !range || range->type != CEL_AST_COMPREHENSION ||
+	    !match_append(&range->as.comprehension, &inner_parts) ||
+	    !is_safe_condition(outer)) {
+		return CEL_OK;
+	}
+	cel_ast_comprehension_t *inner = &range->as.comprehension;
+	cel_ast_node_t *guard = inner_parts.guard ? *inner_parts.guard : NULL;
+	cel_ast_node_t *element = *inner_parts.element;
+	const char *y = outer->iter_var;
+	size_t y_length = outer->iter_var_length;
+
+	/* 守卫与元素不能引用任一累加器 (融合后被外层累加器捕获) */
+	if (count_free(guard, inner->accu_var, inner->accu_var_length, NULL) ||
+	    count_free(element, inner->accu_var, inner->accu_var_length, NULL) ||
+	    count_free(guard, outer->accu_var, outer->accu_var_length, NULL) ||
+	    count_free(element, outer->accu_var, outer->accu_var_length, NULL)) {
+		return CEL_OK;
+	}
+
+	/* 外层步骤中的 x 会被融合后的循环变量捕获 */
+	if (!names_equal(inner->iter_var, inner->iter_var_length, y, y_length) &&
+	    count_free(outer->loop_step, inner->iter_var,
+		       inner->iter_var_length, NULL)) {
+		return CEL_OK;
+	}
+
+	/* y 恰好出现一次时转移 E，多次出现时只复制标识符或字段访问 */
+	bool nested = false;
+	size_t uses = count_free(outer->loop_step, y, y_length, &nested);
+	if (uses == 0 || nested || (uses > 1 && !is_copyable(element))) {
+		return CEL_OK;
+	}
+
+	/* 先分配所有新节点，之后的改写不会失败 */
+	cel_ast_node_t **replacements = malloc(uses * sizeof(cel_ast_node_t *));
+	if (!replacements) {
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+	replacements[0] = element;
+	size_t copies = 1;
+	for (; copies < uses; copies++) {
+		replacements[copies] = copy_node(element);
+		if (!replacements[copies]) {
+			break;
+		}
+	}
+
+	bool outer_append = match_append(outer, &outer_parts);
+	cel_ast_node_t *wrapper = NULL;
+	if (copies == uses && guard) {
+		if (outer_append && outer_parts.guard) {
+			wrapper = cel_ast_create_binary(CEL_BINARY_AND, guard, NULL,
+							guard->loc);
+		} else {
+			cel_ast_node_t *accu = cel_ast_create_ident(
+				outer->accu_var, outer->accu_var_length, node->loc);
+			wrapper = accu ? cel_ast_create_ternary(guard, NULL, accu,
+								guard->loc) :
+					 NULL;
+			if (accu && !wrapper) {
+				cel_ast_destroy(accu);
+			}
+		}
+	}
+	if (copies < uses || (guard && !wrapper)) {
+		for (size_t i = 1; i < copies; i++) {
+			cel_ast_destroy(replacements[i]);
+		}
+		free(replacements);
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+
+	/* 改写外层步骤 */
+	cel_ast_node_t **cursor = replacements;
+	substitute(&outer->loop_step, y, y_length, &cursor);
+	free(replacements);
+	if (wrapper && wrapper->type == CEL_AST_BINARY) {
+		wrapper->as.binary.right = *outer_parts.guard;
+		*outer_parts.guard = wrapper;
+	} else if (wrapper) {
+		wrapper->as.ternary.if_true = outer->loop_step;
+		outer->loop_step = wrapper;
+	}
+
+	/* 直接迭代内层范围 */
+	outer->iter_range = inner->iter_range;
+	outer->iter_var = inner->iter_var;
+	outer->iter_var_length = inner->iter_var_length;
+	inner->iter_range = NULL;
+	*inner_parts.element = NULL;
+	if (inner_parts.guard) {
+		*inner_parts.guard = NULL;
+	}
+	cel_ast_destroy(range);
+	return CEL_OK;
+}
+
+/**
+ * @brief 后序遍历 AST，融合每个推导式
+ */
+static cel_error_code_e fuse_node(cel_ast_node_t *node)
+{
+	if (!node) {
+		return CEL_OK;
+	}
+
+	cel_error_code_e status = CEL_OK;
+	switch (node->type) {
+	case CEL_AST_UNARY:
+		return fuse_node(node->as.unary.operand);
+	case CEL_AST_BINARY:
+		status = fuse_node(node->as.binary.left);
+		return status != CEL_OK ? status : fuse_node(node->as.binary.right);
+	case CEL_AST_TERNARY:
+		status = fuse_node(node->as.ternary.condition);
+		if (status == CEL_OK) {
+			status = fuse_node(node->as.ternary.if_true);
+		}
+		return status != CEL_OK ? status :
+					  fuse_node(node->as.ternary.if_false);
+	case CEL_AST_SELECT:
+		return fuse_node(node->as.select.operand);
+	case CEL_AST_INDEX:
+		status = fuse_node(node->as.index.operand);
+		return status != CEL_OK ? status : fuse_node(node->as.index.index);
+	case CEL_AST_CALL:
+		status = fuse_node(node->as.call.target);
+		for (size_t i = 0; i < node->as.call.arg_count && status == CEL_OK;
+		     i++) {
+			status = fuse_node(node->as.call.args[i]);
+		}
+		return status;
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count && status == CEL_OK;
+		     i++) {
+			status = fuse_node(node->as.list.elements[i]);
+		}
+		return status;
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count && status == CEL_OK;
+		     i++) {
+			status = fuse_node(node->as.map.entries[i].key);
+			if (status == CEL_OK) {
+				status = fuse_node(node->as.map.entries[i].value);
+			}
+		}
+		return status;
+	case CEL_AST_STRUCT:
+		for (size_t i = 0;
+		     i < node->as.struct_lit.field_count && status == CEL_OK; i++) {
+			status = fuse_node(node->as.struct_lit.fields[i].value);
+		}
+		return status;
+	case CEL_AST_COMPREHENSION: {
+		cel_ast_comprehension_t *comp = &node->as.comprehension;
+		cel_ast_node_t *parts[] = {comp->iter_range, comp->accu_init,
+					   comp->loop_cond, comp->loop_step,
+					   comp->result};
+		for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]) &&
+				   status == CEL_OK;
+		     i++) {
+			status = fuse_node(parts[i]);
+		}
+		return status != CEL_OK ? status : fuse_comprehension(node);
+	}
+	default:
+		return CEL_OK;
+	}
+}
+
+/* ========== 部分求值 ========== */
+
+/* 变量名的栈上缓冲区大小，超过时使用堆分配 */
+#define PARTIAL_INLINE_NAME 64
+
+/**
+ * @brief 推导式变量的作用域 (内层在前)
+ */
+typedef struct scope {
+	const cel_ast_comprehension_t *comp;
+	const struct scope *parent;
+} scope_t;
+
+/**
+ * @brief 部分求值状态
+ */
+typedef struct {
+	const cel_context_t *known;  /* 已知变量 */
+	cel_error_code_e status;     /* 第一个错误 */
+} binder_t;
+
+static bool is_bound(const scope_t *scope, const char *name, size_t length)
+{
+	for (; scope; scope = scope->parent) {
+		const cel_ast_comprehension_t *comp = scope->comp;
+		if (names_equal(comp->iter_var, comp->iter_var_length, name,
+				length) ||
+		    names_equal(comp->iter_var2, comp->iter_var2_length, name,
+				length) ||
+		    names_equal(comp->accu_var, comp->accu_var_length, name,
+				length)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief 查找已知变量 (名称不要求 null 结尾)
+ */
+static const cel_value_t *lookup_known(binder_t *b, const char *name,
+				       size_t length)
+{
+	char local_name[PARTIAL_INLINE_NAME];
+	char *var_name = local_name;
+	if (length < sizeof(local_name)) {
+		memcpy(local_name, name, length);
+		local_name[length] = '\0';
+	} else {
+		var_name = malloc(length + 1);
+		if (!var_name) {
+			b->status = CEL_ERROR_OUT_OF_MEMORY;
+			return NULL;
+		}
+		memcpy(var_name, name, length);
+		var_name[length] = '\0';
+	}
+
+	const cel_value_t *value = cel_context_get_variable(b->known, var_name);
+	if (var_name != local_name) {
+		free(var_name);
+	}
+	return value;
+}
+
+/**
+ * @brief 以已知变量的值替换自由标识符
+ */
+static void bind_known(binder_t *b, cel_ast_node_t **slot,
+		       const scope_t *scope)
+{
+	cel_ast_node_t *node = *slot;
+	if (!node || b->status != CEL_OK) {
+		return;
+	}
+
+	switch (node->type) {
+	case CEL_AST_IDENT: {
+		const cel_ast_ident_t *ident = &node->as.ident;
+		if (is_bound(scope, ident->name, ident->length)) {
+			break;
+		}
+		const cel_value_t *value =
+			lookup_known(b, ident->name, ident->length);
+		if (!value) {
+			break;
+		}
+		cel_value_t copy = cel_value_retain(value);
+		cel_ast_node_t *literal = cel_ast_create_literal(copy, node->loc);
+		if (!literal) {
+			cel_value_destroy(&copy);
+			b->status = CEL_ERROR_OUT_OF_MEMORY;
+			break;
+		}
+		cel_ast_destroy(node);
+		*slot = literal;
+		break;
+	}
+	case CEL_AST_UNARY:
+		bind_known(b, &node->as.unary.operand, scope);
+		break;
+	case CEL_AST_BINARY:
+		bind_known(b, &node->as.binary.left, scope);
+		bind_known(b, &node->as.binary.right, scope);
+		break;
+	case CEL_AST_TERNARY:
+		bind_known(b, &node->as.ternary.condition, scope);
+		bind_known(b, &node->as.ternary.if_true, scope);
+		bind_known(b, &node->as.ternary.if_false, scope);
+		break;
+	case CEL_AST_SELECT:
+		bind_known(b, &node->as.select.operand, scope);
+		break;
+	case CEL_AST_INDEX:
+		bind_known(b, &node->as.index.operand, scope);
+		bind_known(b, &node->as.index.index, scope);
+		break;
+	case CEL_AST_CALL:
+		bind_known(b, &node->as.call.target, scope);
+		for (size_t i = 0; i < node->as.call.arg_count; i++) {
+			bind_known(b, &node->as.call.args[i], scope);
+		}
+		break;
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			bind_known(b, &node->as.list.elements[i], scope);
+		}
+		break;
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			bind_known(b, &node->as.map.entries[i].key, scope);
+			bind_known(b, &node->as.map.entries[i].value, scope);
+		}
+		break;
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			bind_known(b, &node->as.struct_lit.fields[i].value, scope);
+		}
+		break;
+	case CEL_AST_COMPREHENSION: {
+		/* 迭代范围与初始值位于外层作用域，其余部分可见推导式变量 */
+		cel_ast_comprehension_t *comp = &node->as.comprehension;
+		bind_known(b, &comp->iter_range, scope);
+		bind_known(b, &comp->accu_init, scope);
+		scope_t inner = {comp, scope};
+		bind_known(b, &comp->loop_cond, &inner);
+		bind_known(b, &comp->loop_step, &inner);
+		bind_known(b, &comp->result, &inner);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/* ========== 优化 API ========== */
+
+cel_error_code_e cel_optimize_fold_constants(cel_ast_node_t **ast)
+{
+	if (!ast || !*ast) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	folder_t folder = {
+		.ctx = cel_context_create(),
+		.status = CEL_OK,
+		.comprehensions = false,
+	};
+	if (!folder.ctx) {
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+
+	fold_node(&folder, ast);
+
+	cel_context_destroy(folder.ctx);
+	return folder.status;
+}
+
+cel_error_code_e cel_optimize_partial_eval(cel_ast_node_t **ast,
+					   const cel_context_t *known)
+{
+	if (!ast || !*ast || !known) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	binder_t binder = {
+		.known = known,
+		.status = CEL_OK,
+	};
+	bind_known(&binder, ast, NULL);
+	if (binder.status != CEL_OK) {
+		return binder.status;
+	}
+
+	folder_t folder = {
+		.ctx = cel_context_create(),
+		.status = CEL_OK,
+		.comprehensions = true,
+	};
+	if (!folder.ctx) {
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+
+	fold_node(&folder, ast);
+
+	cel_context_destroy(folder.ctx);
+	return folder.status;
+}
+
+cel_error_code_e cel_optimize_fuse_comprehensions(cel_ast_node_t **ast)
+{
+	if (!ast || !*ast) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+	return fuse_node(*ast);
+}
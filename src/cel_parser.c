@@ -383,13 +383,14 @@ static cel_ast_node_t *parse_postfix(cel_parser_t *parser,
 				/* 扩展参数数组 */
 				if (arg_count >= arg_capacity) {
 					arg_capacity = arg_capacity == 0 ? 4 : arg_capacity * 2;
-					cel_ast_node_t **new_args = realloc(
-						args, arg_capacity * sizeof(cel_ast_node_t *));
+					cel_ast_node_t **new_args = cel_ast_grow(
+						args, arg_count * sizeof(cel_ast_node_t *),
+						arg_capacity * sizeof(cel_ast_node_t *));
 					if (!new_args) {
 						for (size_t i = 0; i < arg_count; i++) {
 							cel_ast_destroy(args[i]);
 						}
-						free(args);
+						cel_ast_free(args);
 						cel_ast_destroy(left);
 						error_at_current(parser, "Out of memory");
 						return NULL;
@@ -403,7 +404,7 @@ static cel_ast_node_t *parse_postfix(cel_parser_t *parser,
 					for (size_t i = 0; i < arg_count; i++) {
 						cel_ast_destroy(args[i]);
 					}
-					free(args);
+					cel_ast_free(args);
 					cel_ast_destroy(left);
 					return NULL;
 				}
@@ -422,7 +423,7 @@ static cel_ast_node_t *parse_postfix(cel_parser_t *parser,
 			size_t func_length = left->as.ident.length;
 			cel_token_location_t func_loc = left->loc;
 
-			free(left); /* 释放标识符节点 */
+			cel_ast_free(left); /* 释放标识符节点 */
 
 			return cel_ast_create_call(func_name, func_length, NULL,
 						   args, arg_count, func_loc);
@@ -437,7 +438,7 @@ static cel_ast_node_t *parse_postfix(cel_parser_t *parser,
 			/* 将 SELECT 节点转换为 CALL 节点 */
 			/* target 已被保存，无需单独复制 */
 			left->as.select.operand = NULL; /* 防止 destroy 时释放 */
-			free(left); /* 释放 SELECT 节点本身 (field 是指向原始数据的指针) */
+			cel_ast_free(left); /* 释放 SELECT 节点本身 (field 是指向原始数据的指针) */
 
 			return cel_ast_create_call(method_name, method_length, target,
 						   args, arg_count, call_loc);
@@ -448,7 +449,7 @@ static cel_ast_node_t *parse_postfix(cel_parser_t *parser,
 			for (size_t i = 0; i < arg_count; i++) {
 				cel_ast_destroy(args[i]);
 			}
-			free(args);
+			cel_ast_free(args);
 			cel_ast_destroy(left);
 			return NULL;
 		}
@@ -571,13 +572,14 @@ static cel_ast_node_t *parse_list(cel_parser_t *parser)
 			/* 扩展元素数组 */
 			if (element_count >= element_capacity) {
 				element_capacity = element_capacity == 0 ? 4 : element_capacity * 2;
-				cel_ast_node_t **new_elements = realloc(
-					elements, element_capacity * sizeof(cel_ast_node_t *));
+				cel_ast_node_t **new_elements = cel_ast_grow(
+					elements, element_count * sizeof(cel_ast_node_t *),
+					element_capacity * sizeof(cel_ast_node_t *));
 				if (!new_elements) {
 					for (size_t i = 0; i < element_count; i++) {
 						cel_ast_destroy(elements[i]);
 					}
-					free(elements);
+					cel_ast_free(elements);
 					error_at_current(parser, "Out of memory");
 					return NULL;
 				}
@@ -590,7 +592,7 @@ static cel_ast_node_t *parse_list(cel_parser_t *parser)
 				for (size_t i = 0; i < element_count; i++) {
 					cel_ast_destroy(elements[i]);
 				}
-				free(elements);
+				cel_ast_free(elements);
 				return NULL;
 			}
 
@@ -619,14 +621,15 @@ static cel_ast_node_t *parse_map(cel_parser_t *parser)
 			/* 扩展条目数组 */
 			if (entry_count >= entry_capacity) {
 				entry_capacity = entry_capacity == 0 ? 4 : entry_capacity * 2;
-				cel_ast_map_entry_t *new_entries = realloc(
-					entries, entry_capacity * sizeof(cel_ast_map_entry_t));
+				cel_ast_map_entry_t *new_entries = cel_ast_grow(
+					entries, entry_count * sizeof(cel_ast_map_entry_t),
+					entry_capacity * sizeof(cel_ast_map_entry_t));
 				if (!new_entries) {
 					for (size_t i = 0; i < entry_count; i++) {
 						cel_ast_destroy(entries[i].key);
 						cel_ast_destroy(entries[i].value);
 					}
-					free(entries);
+					cel_ast_free(entries);
 					error_at_current(parser, "Out of memory");
 					return NULL;
 				}
@@ -640,7 +643,7 @@ static cel_ast_node_t *parse_map(cel_parser_t *parser)
 					cel_ast_destroy(entries[i].key);
 					cel_ast_destroy(entries[i].value);
 				}
-				free(entries);
+				cel_ast_free(entries);
 				return NULL;
 			}
 
@@ -654,7 +657,7 @@ static cel_ast_node_t *parse_map(cel_parser_t *parser)
 					cel_ast_destroy(entries[i].key);
 					cel_ast_destroy(entries[i].value);
 				}
-				free(entries);
+				cel_ast_free(entries);
 				return NULL;
 			}
 
@@ -0,0 +1,205 @@
+/**
+ * @file cel_pool.c
+ * @brief CEL 工作线程池实现
+ *
+ * 工作线程在条件变量上等待任务代数 (generation) 变化，执行任务后
+ * 递减未完成计数，最后一个完成的线程唤醒提交者。提交者自身作为
+ * 0 号线程参与执行。提交使用 trylock，线程池正忙时立即返回失败。
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* for pthread */
+
+#include "cel/cel_pool.h"
+#include <stdlib.h>
+
+#ifdef CEL_THREAD_SAFE
+
+#include <pthread.h>
+
+/* ========== 内部结构 ========== */
+
+struct cel_thread_pool {
+	pthread_t *workers;          /* 工作线程 (threads - 1 个) */
+	size_t threads;              /* 参与线程总数 */
+
+	pthread_mutex_t submit;      /* 同一时刻只允许一个任务 */
+	pthread_mutex_t lock;        /* 保护以下字段 */
+	pthread_cond_t wake;         /* 新任务或退出 */
+	pthread_cond_t done;         /* 所有工作线程完成 */
+	cel_pool_task_fn task;       /* 当前任务 */
+	void *arg;                   /* 当前任务参数 */
+	unsigned long generation;    /* 任务代数 */
+	size_t pending;              /* 尚未完成当前任务的工作线程数 */
+	bool shutdown;               /* 线程池正在销毁 */
+};
+
+/**
+ * @brief 工作线程参数
+ */
+typedef struct {
+	cel_thread_pool_t *pool;
+	size_t index;
+} worker_arg_t;
+
+/* ========== 工作线程 ========== */
+
+static void *worker_main(void *arg)
+{
+	worker_arg_t *worker = arg;
+	cel_thread_pool_t *pool = worker->pool;
+	size_t index = worker->index;
+	free(worker);
+
+	unsigned long seen = 0;
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->shutdown && pool->generation == seen) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		if (pool->shutdown) {
+			break;
+		}
+		seen = pool->generation;
+		cel_pool_task_fn task = pool->task;
+		void *task_arg = pool->arg;
+		pthread_mutex_unlock(&pool->lock);
+
+		task(task_arg, index);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->pending == 0) {
+			pthread_cond_signal(&pool->done);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/* ========== 线程池 API ========== */
+
+cel_thread_pool_t *cel_thread_pool_create(size_t threads)
+{
+	if (threads == 0) {
+		return NULL;
+	}
+
+	cel_thread_pool_t *pool = calloc(1, sizeof(cel_thread_pool_t));
+	if (!pool) {
+		return NULL;
+	}
+	pool->workers = calloc(threads, sizeof(pthread_t));
+	if (!pool->workers) {
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->submit, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	/* 0 号线程是提交者，只需创建 threads - 1 个工作线程 */
+	for (size_t i = 1; i < threads; i++) {
+		worker_arg_t *worker = malloc(sizeof(worker_arg_t));
+		if (!worker) {
+			break;
+		}
+		*worker = (worker_arg_t){pool, i};
+		if (pthread_create(&pool->workers[i - 1], NULL, worker_main,
+				   worker) != 0) {
+			free(worker);
+			break;
+		}
+		pool->threads = i;
+	}
+	pool->threads++;
+
+	return pool;
+}
+
+void cel_thread_pool_destroy(cel_thread_pool_t *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i + 1 < pool->threads; i++) {
+		pthread_join(pool->workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->submit);
+	free(pool->workers);
+	free(pool);
+}
+
+size_t cel_thread_pool_threads(const cel_thread_pool_t *pool)
+{
+	return pool ? pool->threads : 0;
+}
+
+bool cel_thread_pool_run(cel_thread_pool_t *pool, cel_pool_task_fn task,
+			 void *arg)
+{
+	if (!pool || !task || pthread_mutex_trylock(&pool->submit) != 0) {
+		return false;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->task = task;
+	pool->arg = arg;
+	pool->pending = pool->threads - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	task(arg, 0);
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0) {
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	pthread_mutex_unlock(&pool->submit);
+	return true;
+}
+
+#else /* !CEL_THREAD_SAFE */
+
+/* 引用计数不是原子的，不能跨线程共享值 */
+
+cel_thread_pool_t *cel_thread_pool_create(size_t threads)
+{
+	(void)threads;
+	return NULL;
+}
+
+void cel_thread_pool_destroy(cel_thread_pool_t *pool)
+{
+	(void)pool;
+}
+
+size_t cel_thread_pool_threads(const cel_thread_pool_t *pool)
+{
+	(void)pool;
+	return 0;
+}
+
+bool cel_thread_pool_run(cel_thread_pool_t *pool, cel_pool_task_fn task,
+			 void *arg)
+{
+	(void)pool;
+	(void)task;
+	(void)arg;
+	return false;
+}
+
+#endif /* CEL_THREAD_SAFE */
@@ -7,6 +7,10 @@
 
 #include "cel/cel_program.h"
 #include "cel/cel_eval.h"
+#include "cel/cel_optimizer.h"
+#include "cel/cel_program_cache.h"
+#include "cel/cel_serialize.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,6 +21,10 @@ cel_compile_options_t cel_default_compile_options(void)
 	cel_compile_options_t options = {
 		.max_recursion_depth = 100,
 		.enable_macros = true,
+		.engine = CEL_ENGINE_BYTECODE,
+		.schema = NULL,
+		.fold_constants = true,
+		.fuse_comprehensions = true,
 	};
 	return options;
 }
@@ -26,19 +34,170 @@ cel_execute_options_t cel_default_execute_options(void)
 	cel_execute_options_t options = {
 		.max_eval_recursion = 100,
 		.timeout_ms = 0,
+		.max_cost = 0,
+		.pool = NULL,
+		.parallel_threshold = 0,
+		.scratch = NULL,
 	};
 	return options;
 }
 
 /* ========== 编译 API ========== */
 
+/**
+ * @brief 计算 AST 深度 (树遍历求值的最大递归深度)
+ */
+static size_t ast_depth(const cel_ast_node_t *node)
+{
+	if (!node) {
+		return 0;
+	}
+
+	size_t depth = 0, child;
+	switch (node->type) {
+	case CEL_AST_UNARY:
+		depth = ast_depth(node->as.unary.operand);
+		break;
+	case CEL_AST_BINARY:
+		depth = ast_depth(node->as.binary.left);
+		child = ast_depth(node->as.binary.right);
+		depth = child > depth ? child : depth;
+		break;
+	case CEL_AST_TERNARY:
+		depth = ast_depth(node->as.ternary.condition);
+		child = ast_depth(node->as.ternary.if_true);
+		depth = child > depth ? child : depth;
+		child = ast_depth(node->as.ternary.if_false);
+		depth = child > depth ? child : depth;
+		break;
+	case CEL_AST_SELECT:
+		depth = ast_depth(node->as.select.operand);
+		break;
+	case CEL_AST_INDEX:
+		depth = ast_depth(node->as.index.operand);
+		child = ast_depth(node->as.index.index);
+		depth = child > depth ? child : depth;
+		break;
+	case CEL_AST_CALL:
+		depth = ast_depth(node->as.call.target);
+		for (size_t i = 0; i < node->as.call.arg_count; i++) {
+			child = ast_depth(node->as.call.args[i]);
+			depth = child > depth ? child : depth;
+		}
+		break;
+	case CEL_AST_LIST:
+		for (size_t i = 0; i < node->as.list.element_count; i++) {
+			child = ast_depth(node->as.list.elements[i]);
+			depth = child > depth ? child : depth;
+		}
+		break;
+	case CEL_AST_MAP:
+		for (size_t i = 0; i < node->as.map.entry_count; i++) {
+			child = ast_depth(node->as.map.entries[i].key);
+			depth = child > depth ? child : depth;
+			child = ast_depth(node->as.map.entries[i].value);
+			depth = child > depth ? child : depth;
+		}
+		break;
+	case CEL_AST_STRUCT:
+		for (size_t i = 0; i < node->as.struct_lit.field_count; i++) {
+			child = ast_depth(node->as.struct_lit.fields[i].value);
+			depth = child > depth ? child : depth;
+		}
+		break;
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *comp = &node->as.comprehension;
+		const cel_ast_node_t *parts[] = {comp->iter_range, comp->accu_init,
+						 comp->loop_cond, comp->loop_step,
+						 comp->result};
+		for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+			child = ast_depth(parts[i]);
+			depth = child > depth ? child : depth;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return depth + 1;
+}
+
+/* 预计每个源字符对应的 AST 字节数 (节点约 140 字节，平均每四五个字符
+ * 一个节点)，用于选择 AST 分配区的块大小 */
+#define AST_BYTES_PER_CHAR 32
+
+/**
+ * @brief 新程序持有一个引用
+ */
+static void init_ref_count(cel_program_t *program)
+{
+#ifdef CEL_THREAD_SAFE
+	atomic_init(&program->ref_count, 1);
+#else
+	program->ref_count = 1;
+#endif
+}
+
+/**
+ * @brief 内存不足的编译结果
+ */
+static cel_compile_result_t out_of_memory_result(void)
+{
+	cel_compile_result_t result = {0};
+	result.has_errors = true;
+	result.error_count = 1;
+	result.errors = malloc(sizeof(cel_parse_error_t));
+	if (result.errors) {
+		result.errors->message = strdup("Out of memory");
+		result.errors->next = NULL;
+		memset(&result.errors->location, 0,
+		       sizeof(result.errors->location));
+	}
+	return result;
+}
+
 cel_compile_result_t cel_compile(const char *source)
 {
 	return cel_compile_with_options(source, NULL);
 }
 
-cel_compile_result_t cel_compile_with_options(const char *source,
-					       const cel_compile_options_t *options)
+/**
+ * @brief 编译期间卸下的线程状态
+ *
+ * 常量折叠与部分求值在编译时调用求值器。程序可能在执行期间编译
+ * (例如自定义函数通过程序缓存编译)，这时调用线程安装着外层执行的
+ * 临时分配区、预算与错误通道：折叠产生的字面量必须分配在堆上，
+ * 折叠的代价与错误也不能计入外层执行。
+ */
+typedef struct {
+	arena_t *previous_scratch;
+	cel_exec_budget_t budget;                    /* 不限制的空预算 */
+	cel_exec_budget_t *previous_budget;
+	cel_eval_error_t *previous_error;
+	const cel_eval_parallel_t *previous_parallel;
+} compile_scope_t;
+
+static void compile_scope_enter(compile_scope_t *scope)
+{
+	scope->previous_scratch = arena_scratch_enter(NULL);
+	scope->previous_budget = cel_exec_budget_enter(&scope->budget, 0, 0);
+	scope->previous_error = cel_eval_error_enter(NULL);
+	scope->previous_parallel = cel_eval_parallel_enter(NULL);
+}
+
+static void compile_scope_leave(const compile_scope_t *scope)
+{
+	cel_eval_parallel_leave(scope->previous_parallel);
+	cel_eval_error_leave(scope->previous_error);
+	cel_exec_budget_leave(scope->previous_budget);
+	arena_scratch_leave(scope->previous_scratch);
+}
+
+/**
+ * @brief 编译程序 (调用者已卸下线程状态，见 compile_scope_t)
+ */
+static cel_compile_result_t compile_program(const char *source,
+					    const cel_compile_options_t *options)
 {
 	cel_compile_result_t result = {0};
 
@@ -54,38 +213,77 @@ cel_compile_result_t cel_compile_with_options(const char *source,
 		return result;
 	}
 
+	/* 解析程序持有的源代码副本 (AST 中的名称指向源代码) */
+	char *copy = strdup(source);
+	cel_ast_arena_t *arena = copy ?
+		cel_ast_arena_create(AST_BYTES_PER_CHAR * strlen(source)) : NULL;
+	if (!arena) {
+		free(copy);
+		return out_of_memory_result();
+	}
+
+	/* AST (包括优化改写产生的节点) 分配在程序的分配区中 */
+	cel_ast_arena_t *previous_arena = cel_ast_arena_enter(arena);
+
 	/* 使用解析选项 */
 	size_t max_recursion = options ? options->max_recursion_depth : 100;
-	cel_parse_result_t parse_result = cel_parse_with_options(source, max_recursion);
+	cel_parse_result_t parse_result = cel_parse_with_options(copy, max_recursion);
 
 	if (parse_result.has_errors) {
+		cel_ast_arena_leave(previous_arena);
 		result.has_errors = true;
 		result.errors = parse_result.errors;
 		result.error_count = parse_result.error_count;
 		/* AST 不需要，保留错误信息 */
-		if (parse_result.ast) {
-			cel_ast_destroy(parse_result.ast);
-		}
+		cel_ast_arena_destroy(arena);
+		free(copy);
 		return result;
 	}
 
 	/* 创建程序对象 */
 	cel_program_t *program = malloc(sizeof(cel_program_t));
 	if (!program) {
-		result.has_errors = true;
-		result.error_count = 1;
-		result.errors = malloc(sizeof(cel_parse_error_t));
-		if (result.errors) {
-			result.errors->message = strdup("Out of memory");
-			result.errors->next = NULL;
-		}
-		cel_ast_destroy(parse_result.ast);
-		return result;
+		cel_ast_arena_leave(previous_arena);
+		cel_ast_arena_destroy(arena);
+		free(copy);
+		return out_of_memory_result();
 	}
 
+	init_ref_count(program);
 	program->ast = parse_result.ast;
-	program->source = strdup(source);
+	program->ast_arena = arena;
+	program->bytecode = NULL;
+	program->compact = NULL;
+	program->schema = options ? options->schema : NULL;
+	program->source = copy;
 	program->source_length = strlen(source);
+	program->bundle = NULL;
+
+	/* 推导式融合与常量折叠 (失败时 AST 仍然完整，按未优化的程序执行) */
+	if (!options || options->fuse_comprehensions) {
+		cel_optimize_fuse_comprehensions(&program->ast);
+	}
+	if (!options || options->fold_constants) {
+		cel_optimize_fold_constants(&program->ast);
+	}
+	cel_ast_arena_leave(previous_arena);
+	program->eval_depth = ast_depth(program->ast);
+
+	/* 编译为字节码 (失败时保留 AST 供树遍历求值使用) */
+	cel_engine_e engine = options ? options->engine : CEL_ENGINE_BYTECODE;
+	if (engine == CEL_ENGINE_BYTECODE) {
+		program->bytecode = cel_bytecode_compile(program->ast,
+							 program->schema);
+	} else if (engine == CEL_ENGINE_COMPACT) {
+		/* 转换为紧凑 AST 后释放 AST (失败时保留 AST 供树遍历求值使用) */
+		program->compact = cel_compact_ast_build(program->ast);
+		if (program->compact) {
+			cel_ast_destroy(program->ast);
+			cel_ast_arena_destroy(program->ast_arena);
+			program->ast = NULL;
+			program->ast_arena = NULL;
+		}
+	}
 
 	result.program = program;
 	result.has_errors = false;
@@ -95,6 +293,16 @@ cel_compile_result_t cel_compile_with_options(const char *source,
 	return result;
 }
 
+cel_compile_result_t cel_compile_with_options(const char *source,
+					       const cel_compile_options_t *options)
+{
+	compile_scope_t scope;
+	compile_scope_enter(&scope);
+	cel_compile_result_t result = compile_program(source, options);
+	compile_scope_leave(&scope);
+	return result;
+}
+
 void cel_compile_result_destroy(cel_compile_result_t *result)
 {
 	if (!result) {
@@ -122,21 +330,57 @@ void cel_compile_result_destroy(cel_compile_result_t *result)
 
 /* ========== 程序管理 ========== */
 
+cel_program_t *cel_program_retain(cel_program_t *program)
+{
+	if (!program) {
+		return NULL;
+	}
+
+#ifdef CEL_THREAD_SAFE
+	atomic_fetch_add(&program->ref_count, 1);
+#else
+	program->ref_count++;
+#endif
+
+	return program;
+}
+
 void cel_program_destroy(cel_program_t *program)
 {
 	if (!program) {
 		return;
 	}
 
-	if (program->ast) {
-		cel_ast_destroy(program->ast);
-		program->ast = NULL;
+#ifdef CEL_THREAD_SAFE
+	if (atomic_fetch_sub(&program->ref_count, 1) != 1) {
+		return;
+	}
+#else
+	program->ref_count--;
+	if (program->ref_count > 0) {
+		return;
+	}
+#endif
+
+	if (program->bytecode) {
+		cel_bytecode_destroy(program->bytecode);
+		program->bytecode = NULL;
 	}
+	cel_compact_ast_destroy(program->compact);
+	program->compact = NULL;
 
-	if (program->source) {
+	/* 分配区中的 AST 随分配区一次释放 */
+	cel_ast_destroy(program->ast);
+	cel_ast_arena_destroy(program->ast_arena);
+	program->ast = NULL;
+
+	/* 从程序包加载的程序的源代码位于程序包中 */
+	if (program->bundle) {
+		cel_bundle_close(program->bundle);
+	} else {
 		free(program->source);
-		program->source = NULL;
 	}
+	program->source = NULL;
 
 	free(program);
 }
@@ -149,6 +393,72 @@ const char *cel_program_get_source(const cel_program_t *program)
 	return program->source;
 }
 
+/* ========== 部分求值 API ========== */
+
+/**
+ * @brief 生成剩余程序 (调用者已卸下线程状态，见 compile_scope_t)
+ */
+static cel_program_t *partial_eval_program(const cel_program_t *program,
+					   const cel_context_t *known)
+{
+	if (!program || !program->ast || !program->source || !known) {
+		return NULL;
+	}
+
+	cel_program_t *residual = calloc(1, sizeof(cel_program_t));
+	if (!residual) {
+		return NULL;
+	}
+	init_ref_count(residual);
+
+	/* 剩余程序持有自己的源代码副本，AST 中的名称改为指向副本 */
+	residual->source = malloc(program->source_length + 1);
+	if (!residual->source) {
+		free(residual);
+		return NULL;
+	}
+	memcpy(residual->source, program->source, program->source_length + 1);
+	residual->source_length = program->source_length;
+	residual->schema = program->schema;
+
+	residual->ast_arena = cel_ast_arena_create(
+		cel_ast_arena_used(program->ast_arena));
+	if (!residual->ast_arena) {
+		cel_program_destroy(residual);
+		return NULL;
+	}
+	cel_ast_arena_t *previous_arena = cel_ast_arena_enter(residual->ast_arena);
+	residual->ast = cel_ast_copy(program->ast, program->source,
+				     program->source_length, residual->source);
+	cel_error_code_e status = residual->ast ?
+		cel_optimize_partial_eval(&residual->ast, known) :
+		CEL_ERROR_OUT_OF_MEMORY;
+	cel_ast_arena_leave(previous_arena);
+	if (status != CEL_OK) {
+		cel_program_destroy(residual);
+		return NULL;
+	}
+
+	residual->eval_depth = ast_depth(residual->ast);
+
+	/* 与原程序使用相同的执行引擎 */
+	if (program->bytecode) {
+		residual->bytecode = cel_bytecode_compile(residual->ast,
+							  residual->schema);
+	}
+	return residual;
+}
+
+cel_program_t *cel_partial_eval(const cel_program_t *program,
+				const cel_context_t *known)
+{
+	compile_scope_t scope;
+	compile_scope_enter(&scope);
+	cel_program_t *residual = partial_eval_program(program, known);
+	compile_scope_leave(&scope);
+	return residual;
+}
+
 /* ========== 执行 API ========== */
 
 cel_execute_result_t cel_execute(const cel_program_t *program, cel_context_t *ctx)
@@ -156,51 +466,452 @@ cel_execute_result_t cel_execute(const cel_program_t *program, cel_context_t *ct
 	return cel_execute_with_options(program, ctx, NULL);
 }
 
-cel_execute_result_t cel_execute_with_options(const cel_program_t *program,
-					       cel_context_t *ctx,
-					       const cel_execute_options_t *options)
+/**
+ * @brief 按 AST 或紧凑 AST 求值
+ */
+static bool eval_ast(const cel_program_t *program, cel_context_t *ctx,
+		     cel_value_t *result)
+{
+	if (program->compact) {
+		return cel_compact_eval(program->compact, ctx, result);
+	}
+	return cel_eval(program->ast, ctx, result);
+}
+
+/**
+ * @brief 树遍历求值 (激活记录中的变量通过子上下文按名称提供)
+ */
+static bool eval_tree(const cel_program_t *program, cel_context_t *ctx,
+		      const cel_activation_t *activation, cel_value_t *result)
+{
+	if (!activation) {
+		return eval_ast(program, ctx, result);
+	}
+
+	cel_context_t *scope = cel_context_create_child(ctx);
+	if (!scope) {
+		return false;
+	}
+
+	bool success = true;
+	for (size_t i = 0; i < activation->count && success; i++) {
+		if (activation->bound[i]) {
+			const char *name = cel_schema_get_name(activation->schema, i);
+			success = cel_context_add_variable(scope, name,
+							   &activation->values[i]) == CEL_OK;
+		}
+	}
+
+	success = success && eval_ast(program, scope, result);
+	cel_context_destroy(scope);
+	return success;
+}
+
+/**
+ * @brief 执行状态结构 (内部实现)
+ */
+struct cel_exec_state {
+	cel_vm_frame_t frame;          /* 复用的寄存器文件 */
+	cel_execute_options_t options; /* 执行选项 */
+};
+
+/**
+ * @brief 树遍历求值的最大递归深度
+ *
+ * @param max_recursion 执行选项中的设置 (0 = 使用上下文的设置)
+ */
+static size_t max_depth(const cel_context_t *ctx, size_t max_recursion)
+{
+	return max_recursion ? max_recursion : cel_context_get_max_recursion(ctx);
+}
+
+/**
+ * @brief 记录参数错误 (错误码同时写入 eval_error)
+ */
+static cel_execute_result_t invalid_result(cel_error_t *error)
 {
 	cel_execute_result_t result = {0};
+	result.success = false;
+	result.error = error;
+	result.eval_error.code = error ? error->code : CEL_ERROR_OUT_OF_MEMORY;
+	return result;
+}
 
-	if (!program || !program->ast) {
-		result.success = false;
-		result.error = cel_error_create(CEL_ERROR_INVALID_ARGUMENT,
-						"Program is NULL or invalid");
-		return result;
+/**
+ * @brief 整理失败执行的 eval_error
+ *
+ * 没有报告错误的失败 (例如内存不足) 按内部错误报告；被 && / || 吸收
+ * 后超出限制的执行按限制错误报告。
+ */
+static void finish_error(cel_eval_error_t *error, cel_error_code_e exhausted)
+{
+	if (exhausted != CEL_OK && error->code != exhausted) {
+		error->code = exhausted;
+		error->message = exhausted == CEL_ERROR_TIMEOUT ?
+					 "Execution timed out" :
+					 "Cost limit exceeded";
+		error->detail[0] = '\0';
+		error->line = 0;
+		error->column = 0;
+	} else if (error->code == CEL_OK) {
+		error->code = CEL_ERROR_INTERNAL;
+		error->message = "Expression evaluation failed";
+	}
+}
+
+/**
+ * @brief 执行程序 (公共实现)
+ *
+ * 只读取程序与上下文，可变状态全部位于 frame 与栈上的执行预算中。
+ *
+ * @param options 执行选项 (为 NULL 时使用上下文的递归深度，不限制代价与时间)
+ * @param frame 复用的寄存器文件 (为 NULL 时使用临时寄存器)
+ */
+static cel_execute_result_t execute_program(const cel_program_t *program,
+					    cel_context_t *ctx,
+					    const cel_activation_t *activation,
+					    const cel_execute_options_t *options,
+					    cel_vm_frame_t *frame)
+{
+	if (!program || (!program->ast && !program->compact)) {
+		return invalid_result(cel_error_create(
+			CEL_ERROR_INVALID_ARGUMENT, "Program is NULL or invalid"));
 	}
 
 	if (!ctx) {
-		result.success = false;
-		result.error = cel_error_create(CEL_ERROR_INVALID_ARGUMENT,
-						"Context is NULL");
-		return result;
+		return invalid_result(cel_error_create(
+			CEL_ERROR_INVALID_ARGUMENT, "Context is NULL"));
 	}
 
-	/* 设置执行选项 */
-	if (options && options->max_eval_recursion > 0) {
-		cel_context_set_max_recursion(ctx, options->max_eval_recursion);
+	if (activation && activation->schema != program->schema) {
+		return invalid_result(cel_error_create(
+			CEL_ERROR_INVALID_ARGUMENT,
+			"Activation does not match program schema"));
 	}
 
-	/* TODO: 实现超时机制 (options->timeout_ms) */
+	cel_execute_result_t result = {0};
+
+	/* 安装错误通道 (求值错误只记录错误码与位置) */
+	cel_eval_error_t *previous_error =
+		cel_eval_error_enter(&result.eval_error);
+
+	/* 安装执行预算 (总是统计代价，限制由选项决定) */
+	cel_exec_budget_t budget;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(
+		&budget, options ? options->max_cost : 0,
+		options ? options->timeout_ms : 0);
+	budget.depth_left = max_depth(
+		ctx, options ? options->max_eval_recursion : 0);
+
+	/* 安装并行设置 (并行推导式只在树遍历求值中实现) */
+	cel_eval_parallel_t parallel = {
+		.pool = options ? options->pool : NULL,
+		.threshold = options ? options->parallel_threshold : 0,
+	};
+	const cel_eval_parallel_t *previous_parallel =
+		cel_eval_parallel_enter(parallel.pool ? &parallel : NULL);
+
+	/* 安装临时分配区 */
+	arena_t *scratch = options ? options->scratch : NULL;
+	arena_t *previous_scratch = arena_scratch_enter(scratch);
 
 	/* 执行求值 */
 	cel_value_t eval_result;
-	bool success = cel_eval(program->ast, ctx, &eval_result);
+	bool success;
+	if (parallel.pool) {
+		success = eval_tree(program, ctx, activation, &eval_result);
+	} else if (program->bytecode && frame) {
+		success = cel_vm_execute_frame(program->bytecode, ctx, activation,
+					       frame, &eval_result);
+	} else if (program->bytecode) {
+		success = cel_vm_execute(program->bytecode, ctx, activation,
+					 &eval_result);
+	} else {
+		success = eval_tree(program, ctx, activation, &eval_result);
+	}
+
+	arena_scratch_leave(previous_scratch);
+	cel_eval_parallel_leave(previous_parallel);
+	cel_exec_budget_leave(previous);
+	cel_eval_error_leave(previous_error);
+	result.cost = budget.cost;
+
+	/* 结果值离开临时分配区 */
+	if (success && scratch && !cel_value_promote(&eval_result)) {
+		cel_value_destroy(&eval_result);
+		result.eval_error = (cel_eval_error_t){
+			.code = CEL_ERROR_OUT_OF_MEMORY,
+			.message = "Out of memory",
+		};
+		success = false;
+	}
+
+	/* 超出限制后的错误可能被 && / || 吸收，仍按限制错误报告 */
+	if (success && budget.exhausted != CEL_OK) {
+		cel_value_destroy(&eval_result);
+		success = false;
+	}
 
 	if (success) {
 		result.success = true;
 		result.value = eval_result;
-		result.error = NULL;
+		result.eval_error.code = CEL_OK;
 	} else {
 		result.success = false;
-		result.error = cel_error_create(CEL_ERROR_INTERNAL,
-						"Expression evaluation failed");
 		result.value = cel_value_null();
+		finish_error(&result.eval_error, budget.exhausted);
+	}
+
+	/* 中间值均已释放；嵌套执行使用同一分配区时由最外层重置 */
+	if (scratch && scratch != previous_scratch) {
+		arena_reset(scratch);
 	}
 
 	return result;
 }
 
+cel_execute_result_t cel_execute_with_options(const cel_program_t *program,
+					       cel_context_t *ctx,
+					       const cel_execute_options_t *options)
+{
+	return execute_program(program, ctx, NULL, options, NULL);
+}
+
+cel_execute_result_t cel_execute_with_activation(const cel_program_t *program,
+						  cel_context_t *ctx,
+						  const cel_activation_t *activation)
+{
+	return execute_program(program, ctx, activation, NULL, NULL);
+}
+
+/* ========== 执行状态 ========== */
+
+cel_exec_state_t *cel_exec_state_create(void)
+{
+	cel_exec_state_t *state = calloc(1, sizeof(cel_exec_state_t));
+	if (!state) {
+		return NULL;
+	}
+
+	cel_exec_state_set_options(state, NULL);
+	return state;
+}
+
+void cel_exec_state_destroy(cel_exec_state_t *state)
+{
+	if (!state) {
+		return;
+	}
+
+	cel_vm_frame_destroy(&state->frame);
+	free(state);
+}
+
+void cel_exec_state_set_options(cel_exec_state_t *state,
+				const cel_execute_options_t *options)
+{
+	if (!state) {
+		return;
+	}
+
+	state->options = options ? *options : cel_default_execute_options();
+}
+
+cel_execute_result_t cel_execute_with_state(const cel_program_t *program,
+					     cel_context_t *ctx,
+					     const cel_activation_t *activation,
+					     cel_exec_state_t *state)
+{
+	if (!state) {
+		return invalid_result(cel_error_create(
+			CEL_ERROR_INVALID_ARGUMENT, "Execution state is NULL"));
+	}
+
+	return execute_program(program, ctx, activation, &state->options,
+			       &state->frame);
+}
+
+/* ========== 批量执行 ========== */
+
+/**
+ * @brief 检查批量执行的公共参数
+ *
+ * @return 错误对象，参数有效时返回 NULL
+ */
+static cel_error_t *check_batch(const cel_program_t *program,
+				cel_context_t *ctx)
+{
+	if (!program || (!program->ast && !program->compact)) {
+		return cel_error_create(CEL_ERROR_INVALID_ARGUMENT,
+					"Program is NULL or invalid");
+	}
+	if (!ctx) {
+		return cel_error_create(CEL_ERROR_INVALID_ARGUMENT,
+					"Context is NULL");
+	}
+	return NULL;
+}
+
+/**
+ * @brief 执行批量中的一行
+ *
+ * @param error 输出错误码 (失败时)
+ */
+static bool execute_row(const cel_program_t *program, cel_context_t *ctx,
+			const cel_activation_t *activation,
+			cel_vm_frame_t *frame, cel_value_t *value,
+			cel_error_code_e *error)
+{
+	if (activation && activation->schema != program->schema) {
+		*error = CEL_ERROR_INVALID_ARGUMENT;
+		return false;
+	}
+
+	bool success;
+	if (program->bytecode) {
+		success = cel_vm_execute_frame(program->bytecode, ctx,
+					       activation, frame, value);
+	} else {
+		success = eval_tree(program, ctx, activation, value);
+	}
+
+	*error = CEL_ERROR_INTERNAL;
+	return success;
+}
+
+size_t cel_execute_batch(const cel_program_t *program, cel_context_t *ctx,
+			 const cel_activation_t *const *activations,
+			 size_t count, cel_execute_result_t *results)
+{
+	if (!results) {
+		return 0;
+	}
+
+	cel_error_t *invalid = check_batch(program, ctx);
+	if (invalid) {
+		for (size_t i = 0; i < count; i++) {
+			results[i] = invalid_result(cel_error_create(
+				invalid->code, invalid->message));
+			results[i].value = cel_value_null();
+		}
+		cel_error_destroy(invalid);
+		return 0;
+	}
+
+	cel_vm_frame_t frame = {0};
+	size_t succeeded = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		const cel_activation_t *activation =
+			activations ? activations[i] : NULL;
+		cel_execute_result_t *result = &results[i];
+		cel_error_code_e error;
+
+		/* 不限制代价，只统计 */
+		cel_exec_budget_t budget;
+		cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+		budget.depth_left = max_depth(ctx, 0);
+		cel_eval_error_t *previous_error =
+			cel_eval_error_enter(&result->eval_error);
+
+		result->error = NULL;
+		result->success = execute_row(program, ctx, activation, &frame,
+					      &result->value, &error);
+		result->cost = budget.cost;
+		cel_eval_error_leave(previous_error);
+		cel_exec_budget_leave(previous);
+		if (result->success) {
+			result->eval_error.code = CEL_OK;
+			succeeded++;
+			continue;
+		}
+
+		result->value = cel_value_null();
+		if (error == CEL_ERROR_INVALID_ARGUMENT) {
+			result->error = cel_error_create(
+				error, "Activation does not match program schema");
+			result->eval_error.code = error;
+		} else {
+			finish_error(&result->eval_error, CEL_OK);
+		}
+	}
+
+	cel_vm_frame_destroy(&frame);
+	return succeeded;
+}
+
+size_t cel_execute_batch_select(const cel_program_t *program,
+				cel_context_t *ctx,
+				const cel_activation_t *const *activations,
+				size_t count, uint64_t *selection)
+{
+	if (!selection) {
+		return 0;
+	}
+
+	memset(selection, 0, CEL_SELECTION_WORDS(count) * sizeof(uint64_t));
+
+	cel_error_t *invalid = check_batch(program, ctx);
+	if (invalid) {
+		cel_error_destroy(invalid);
+		return 0;
+	}
+
+	/* 失败的行只是不被选中，错误直接丢弃 */
+	cel_eval_error_t *previous_error = cel_eval_error_enter(NULL);
+	cel_vm_frame_t frame = {0};
+	size_t selected = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		const cel_activation_t *activation =
+			activations ? activations[i] : NULL;
+		cel_value_t value;
+		cel_error_code_e error;
+
+		/* 与 cel_execute_batch 相同，每行使用独立的深度预算 */
+		cel_exec_budget_t budget;
+		cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+		budget.depth_left = max_depth(ctx, 0);
+		bool success = execute_row(program, ctx, activation, &frame,
+					   &value, &error);
+		cel_exec_budget_leave(previous);
+		if (!success) {
+			continue;
+		}
+
+		if (value.type == CEL_TYPE_BOOL) {
+			if (value.value.bool_value) {
+				selection[i / 64] |= UINT64_C(1) << (i % 64);
+				selected++;
+			}
+		} else {
+			cel_value_destroy(&value);
+		}
+	}
+
+	cel_vm_frame_destroy(&frame);
+	cel_eval_error_leave(previous_error);
+	return selected;
+}
+
+size_t cel_execute_result_message(const cel_execute_result_t *result,
+				  char *buffer, size_t size)
+{
+	if (buffer && size) {
+		buffer[0] = '\0';
+	}
+	if (!result || result->success) {
+		return 0;
+	}
+
+	if (result->error && result->error->message) {
+		int length = snprintf(buffer, buffer ? size : 0, "%s",
+				      result->error->message);
+		return length > 0 ? (size_t)length : 0;
+	}
+	return cel_eval_error_format(&result->eval_error, buffer, size);
+}
+
 void cel_execute_result_destroy(cel_execute_result_t *result)
 {
 	if (!result) {
@@ -221,28 +932,26 @@ void cel_execute_result_destroy(cel_execute_result_t *result)
 
 cel_execute_result_t cel_eval_expression(const char *source, cel_context_t *ctx)
 {
-	cel_execute_result_t result = {0};
-
-	/* 编译 */
-	cel_compile_result_t compile_result = cel_compile(source);
+	/* 编译 (安装了程序缓存时复用缓存的程序) */
+	cel_program_cache_t *cache = cel_program_cache_installed();
+	cel_compile_result_t compile_result =
+		cache ? cel_program_cache_get(cache, source, NULL) :
+			cel_compile(source);
 	if (compile_result.has_errors) {
-		result.success = false;
 		/* 转换第一个编译错误为执行错误 */
-		if (compile_result.errors && compile_result.errors->message) {
-			result.error = cel_error_create(CEL_ERROR_SYNTAX,
-							compile_result.errors->message);
-		} else {
-			result.error = cel_error_create(CEL_ERROR_SYNTAX,
-							"Compilation failed");
-		}
+		cel_execute_result_t result = invalid_result(cel_error_create(
+			CEL_ERROR_SYNTAX,
+			compile_result.errors && compile_result.errors->message ?
+				compile_result.errors->message :
+				"Compilation failed"));
 		cel_compile_result_destroy(&compile_result);
 		return result;
 	}
 
 	/* 执行 */
-	result = cel_execute(compile_result.program, ctx);
+	cel_execute_result_t result = cel_execute(compile_result.program, ctx);
 
-	/* 清理程序 (不需要保留) */
+	/* 释放程序的引用 (缓存中的程序由缓存保留) */
 	cel_program_destroy(compile_result.program);
 	compile_result.program = NULL;
 
@@ -0,0 +1,323 @@
+/**
+ * @file cel_program_cache.c
+ * @brief CEL 程序缓存实现
+ *
+ * 键由编译选项与源代码拼接而成，按键的 FNV-1a 哈希选择分片。
+ * 与正则表达式缓存相同，每个分片使用 uthash 的插入顺序实现 LRU:
+ * 命中时将条目移到表尾，淘汰时从表头开始删除。
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* for pthread */
+
+#include "cel/cel_program_cache.h"
+#include "uthash/uthash.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CEL_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 键中的编译选项部分 (定长，没有填充字节)
+ */
+typedef struct {
+	uint64_t max_recursion_depth;  /* 最大解析递归深度 */
+	uint64_t schema;               /* 变量布局地址 */
+	uint64_t flags;                /* 宏 / 折叠 / 融合开关与执行引擎 */
+} key_options_t;
+
+/**
+ * @brief 缓存条目 (uthash, 按键索引)
+ */
+typedef struct {
+	char *key;                     /* 键 (编译选项 + 源代码) */
+	size_t length;                 /* 键长度 */
+	cel_program_t *program;        /* 程序 (条目持有引用) */
+	UT_hash_handle hh;             /* uthash 句柄 */
+} cache_entry_t;
+
+/**
+ * @brief 分片
+ */
+typedef struct {
+#ifdef CEL_THREAD_SAFE
+	pthread_mutex_t lock;          /* 保护本分片的条目与统计 */
+#endif
+	cache_entry_t *entries;        /* 条目 (插入顺序即 LRU 顺序) */
+	size_t capacity;               /* 容量 */
+	uint64_t hits;                 /* 命中次数 */
+	uint64_t misses;               /* 未命中次数 */
+	uint64_t evictions;            /* 淘汰次数 */
+} shard_t;
+
+/**
+ * @brief 程序缓存 (内部实现)
+ */
+struct cel_program_cache {
+	shard_t shards[CEL_PROGRAM_CACHE_SHARDS];
+};
+
+#ifdef CEL_THREAD_SAFE
+#define SHARD_LOCK(shard) pthread_mutex_lock(&(shard)->lock)
+#define SHARD_UNLOCK(shard) pthread_mutex_unlock(&(shard)->lock)
+static _Atomic(cel_program_cache_t *) installed_cache = NULL;
+#else
+#define SHARD_LOCK(shard) ((void)0)
+#define SHARD_UNLOCK(shard) ((void)0)
+static cel_program_cache_t *installed_cache = NULL;
+#endif
+
+/* ========== 键 ========== */
+
+/**
+ * @brief 构造键 (编译选项 + 源代码，调用者释放)
+ */
+static char *make_key(const char *source, const cel_compile_options_t *options,
+		      size_t *length)
+{
+	key_options_t prefix;
+	memset(&prefix, 0, sizeof(prefix));
+	prefix.max_recursion_depth = options->max_recursion_depth;
+	prefix.schema = (uint64_t)(uintptr_t)options->schema;
+	prefix.flags = (options->enable_macros ? 1u : 0u) |
+		       (options->fold_constants ? 2u : 0u) |
+		       (options->fuse_comprehensions ? 4u : 0u) |
+		       ((uint64_t)options->engine << 8);
+
+	size_t source_length = strlen(source);
+	char *key = malloc(sizeof(prefix) + source_length);
+	if (!key) {
+		return NULL;
+	}
+	memcpy(key, &prefix, sizeof(prefix));
+	memcpy(key + sizeof(prefix), source, source_length);
+	*length = sizeof(prefix) + source_length;
+	return key;
+}
+
+/**
+ * @brief FNV-1a 哈希 (用于选择分片)
+ */
+static uint64_t hash_key(const char *key, size_t length)
+{
+	uint64_t hash = UINT64_C(14695981039346656037);
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= UINT64_C(1099511628211);
+	}
+	return hash;
+}
+
+/* ========== 分片 ========== */
+
+/**
+ * @brief 删除条目并释放其引用 (调用者持有锁)
+ */
+static void drop_entry(shard_t *shard, cache_entry_t *entry)
+{
+	HASH_DEL(shard->entries, entry);
+	cel_program_destroy(entry->program);
+	free(entry->key);
+	free(entry);
+}
+
+/**
+ * @brief 淘汰最久未使用的条目直到不超过容量 (调用者持有锁)
+ */
+static void shard_evict(shard_t *shard)
+{
+	while (HASH_COUNT(shard->entries) > shard->capacity) {
+		drop_entry(shard, shard->entries);
+		shard->evictions++;
+	}
+}
+
+/**
+ * @brief 查找条目并标记为最近使用 (调用者持有锁)
+ *
+ * @return 程序 (新引用)，未命中返回 NULL
+ */
+static cel_program_t *shard_lookup(shard_t *shard, const char *key,
+				   size_t length)
+{
+	cache_entry_t *entry = NULL;
+	HASH_FIND(hh, shard->entries, key, length, entry);
+	if (!entry) {
+		return NULL;
+	}
+
+	HASH_DEL(shard->entries, entry);
+	HASH_ADD_KEYPTR(hh, shard->entries, entry->key, entry->length, entry);
+	return cel_program_retain(entry->program);
+}
+
+/* ========== 程序缓存 API ========== */
+
+cel_program_cache_t *cel_program_cache_create(size_t capacity)
+{
+	cel_program_cache_t *cache = calloc(1, sizeof(cel_program_cache_t));
+	if (!cache) {
+		return NULL;
+	}
+
+	size_t per_shard = (capacity + CEL_PROGRAM_CACHE_SHARDS - 1) /
+			   CEL_PROGRAM_CACHE_SHARDS;
+	for (size_t i = 0; i < CEL_PROGRAM_CACHE_SHARDS; i++) {
+		cache->shards[i].capacity = per_shard;
+#ifdef CEL_THREAD_SAFE
+		pthread_mutex_init(&cache->shards[i].lock, NULL);
+#endif
+	}
+	return cache;
+}
+
+void cel_program_cache_destroy(cel_program_cache_t *cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	cel_program_cache_clear(cache);
+#ifdef CEL_THREAD_SAFE
+	for (size_t i = 0; i < CEL_PROGRAM_CACHE_SHARDS; i++) {
+		pthread_mutex_destroy(&cache->shards[i].lock);
+	}
+#endif
+	free(cache);
+}
+
+cel_compile_result_t cel_program_cache_get(cel_program_cache_t *cache,
+					   const char *source,
+					   const cel_compile_options_t *options)
+{
+	if (!cache || !source) {
+		return cel_compile_with_options(source, options);
+	}
+
+	cel_compile_options_t defaults = cel_default_compile_options();
+	if (!options) {
+		options = &defaults;
+	}
+
+	size_t length = 0;
+	char *key = make_key(source, options, &length);
+	if (!key) {
+		/* 无法缓存时仍然编译 */
+		return cel_compile_with_options(source, options);
+	}
+
+	shard_t *shard = &cache->shards[hash_key(key, length) %
+					CEL_PROGRAM_CACHE_SHARDS];
+	SHARD_LOCK(shard);
+	cel_program_t *program = shard_lookup(shard, key, length);
+	if (program) {
+		shard->hits++;
+	} else {
+		shard->misses++;
+	}
+	SHARD_UNLOCK(shard);
+	if (program) {
+		free(key);
+		return (cel_compile_result_t){.program = program};
+	}
+
+	/* 在锁外编译，避免慢速编译阻塞同一分片上的命中 */
+	cel_compile_result_t result = cel_compile_with_options(source, options);
+	if (result.has_errors || shard->capacity == 0) {
+		free(key);
+		return result;
+	}
+
+	cache_entry_t *entry = malloc(sizeof(cache_entry_t));
+	if (!entry) {
+		free(key);
+		return result;
+	}
+	entry->key = key;
+	entry->length = length;
+	entry->program = cel_program_retain(result.program);
+
+	SHARD_LOCK(shard);
+	/* 其他线程可能已经编译并缓存了同一程序 */
+	cel_program_t *existing = shard_lookup(shard, key, length);
+	if (!existing) {
+		HASH_ADD_KEYPTR(hh, shard->entries, entry->key, entry->length,
+				entry);
+		shard_evict(shard);
+		entry = NULL;
+	}
+	SHARD_UNLOCK(shard);
+
+	if (entry) {
+		cel_program_destroy(entry->program);
+		free(entry->key);
+		free(entry);
+	}
+	if (existing) {
+		cel_program_destroy(result.program);
+		result.program = existing;
+	}
+	return result;
+}
+
+void cel_program_cache_stats(cel_program_cache_t *cache,
+			     cel_program_cache_stats_t *stats)
+{
+	if (!stats) {
+		return;
+	}
+	memset(stats, 0, sizeof(*stats));
+	if (!cache) {
+		return;
+	}
+
+	for (size_t i = 0; i < CEL_PROGRAM_CACHE_SHARDS; i++) {
+		shard_t *shard = &cache->shards[i];
+		SHARD_LOCK(shard);
+		stats->hits += shard->hits;
+		stats->misses += shard->misses;
+		stats->evictions += shard->evictions;
+		stats->size += HASH_COUNT(shard->entries);
+		stats->capacity += shard->capacity;
+		SHARD_UNLOCK(shard);
+	}
+}
+
+void cel_program_cache_clear(cel_program_cache_t *cache)
+{
+	if (!cache) {
+		return;
+	}
+
+	for (size_t i = 0; i < CEL_PROGRAM_CACHE_SHARDS; i++) {
+		shard_t *shard = &cache->shards[i];
+		SHARD_LOCK(shard);
+		while (shard->entries) {
+			drop_entry(shard, shard->entries);
+		}
+		SHARD_UNLOCK(shard);
+	}
+}
+
+cel_program_cache_t *cel_program_cache_install(cel_program_cache_t *cache)
+{
+#ifdef CEL_THREAD_SAFE
+	return atomic_exchange(&installed_cache, cache);
+#else
+	cel_program_cache_t *previous = installed_cache;
+	installed_cache = cache;
+	return previous;
+#endif
+}
+
+cel_program_cache_t *cel_program_cache_installed(void)
+{
+#ifdef CEL_THREAD_SAFE
+	return atomic_load(&installed_cache);
+#else
+	return installed_cache;
+#endif
+}
@@ -0,0 +1,386 @@
+/**
+ * @file cel_regex.c
+ * @brief CEL 正则表达式编译与缓存实现
+ *
+ * 缓存使用 uthash 的插入顺序实现 LRU: 命中时将条目移到表尾，
+ * 淘汰时从表头开始删除。缓存条目持有正则表达式的一个引用。
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* for pthread */
+
+#include "cel/cel_regex.h"
+#include "cel/cel_value.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CEL_ENABLE_REGEX
+
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#include "uthash/uthash.h"
+
+#ifdef CEL_THREAD_SAFE
+#include <pthread.h>
+#endif
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief 编译后的正则表达式
+ */
+struct cel_regex {
+	pcre2_code *code;            /* PCRE2 编译结果 (只读，可并发匹配) */
+#ifdef CEL_THREAD_SAFE
+	atomic_int ref_count;        /* 引用计数 */
+#else
+	int ref_count;               /* 引用计数 */
+#endif
+};
+
+/**
+ * @brief 缓存条目 (uthash, 按模式索引)
+ */
+typedef struct {
+	char *pattern;               /* 键 (模式副本) */
+	size_t length;               /* 模式长度 */
+	cel_regex_t *regex;          /* 正则表达式 (条目持有引用) */
+	UT_hash_handle hh;           /* uthash 句柄 */
+} regex_cache_entry_t;
+
+static regex_cache_entry_t *cache = NULL;
+static size_t cache_capacity = CEL_REGEX_CACHE_CAPACITY;
+
+#ifdef CEL_THREAD_SAFE
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_LOCK() pthread_mutex_lock(&cache_lock)
+#define CACHE_UNLOCK() pthread_mutex_unlock(&cache_lock)
+#else
+#define CACHE_LOCK() ((void)0)
+#define CACHE_UNLOCK() ((void)0)
+#endif
+
+/* ========== 线程私有匹配数据 ========== */
+
+/*
+ * matches() 只需要判断是否匹配，不需要捕获组，因此所有模式共用
+ * 一个只有一组偏移的匹配数据。每个线程一份，线程退出时释放。
+ */
+#ifdef CEL_THREAD_SAFE
+static pthread_key_t match_data_key;
+static pthread_once_t match_data_once = PTHREAD_ONCE_INIT;
+
+static void match_data_free(void *data)
+{
+	pcre2_match_data_free(data);
+}
+
+static void match_data_key_create(void)
+{
+	pthread_key_create(&match_data_key, match_data_free);
+}
+
+static pcre2_match_data *thread_match_data(void)
+{
+	pthread_once(&match_data_once, match_data_key_create);
+
+	pcre2_match_data *data = pthread_getspecific(match_data_key);
+	if (!data) {
+		data = pcre2_match_data_create(1, NULL);
+		if (data && pthread_setspecific(match_data_key, data) != 0) {
+			pcre2_match_data_free(data);
+			data = NULL;
+		}
+	}
+	return data;
+}
+#else
+static pcre2_match_data *thread_match_data(void)
+{
+	static pcre2_match_data *data = NULL;
+	if (!data) {
+		data = pcre2_match_data_create(1, NULL);
+	}
+	return data;
+}
+#endif
+
+/* ========== 编译与匹配 ========== */
+
+cel_regex_t *cel_regex_compile(const char *pattern, size_t length,
+			       char *error, size_t error_size)
+{
+	if (!pattern) {
+		if (error && error_size > 0) {
+			snprintf(error, error_size, "regex pattern is NULL");
+		}
+		return NULL;
+	}
+
+	int errornumber;
+	PCRE2_SIZE erroroffset;
+	pcre2_code *code = pcre2_compile((PCRE2_SPTR)pattern, length, 0,
+					 &errornumber, &erroroffset, NULL);
+	if (!code) {
+		if (error && error_size > 0) {
+			PCRE2_UCHAR buffer[256];
+			pcre2_get_error_message(errornumber, buffer,
+						sizeof(buffer));
+			snprintf(error, error_size,
+				 "regex compile error at offset %zu: %s",
+				 (size_t)erroroffset, (const char *)buffer);
+		}
+		return NULL;
+	}
+
+	/* JIT 不可用时 (例如不支持的平台) 回退到解释执行 */
+	pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+
+	cel_regex_t *regex = malloc(sizeof(cel_regex_t));
+	if (!regex) {
+		pcre2_code_free(code);
+		if (error && error_size > 0) {
+			snprintf(error, error_size, "Out of memory");
+		}
+		return NULL;
+	}
+
+	regex->code = code;
+#ifdef CEL_THREAD_SAFE
+	atomic_init(&regex->ref_count, 1);
+#else
+	regex->ref_count = 1;
+#endif
+	return regex;
+}
+
+cel_regex_t *cel_regex_retain(cel_regex_t *regex)
+{
+	if (!regex) {
+		return NULL;
+	}
+
+#ifdef CEL_THREAD_SAFE
+	atomic_fetch_add(&regex->ref_count, 1);
+#else
+	regex->ref_count++;
+#endif
+
+	return regex;
+}
+
+void cel_regex_release(cel_regex_t *regex)
+{
+	if (!regex) {
+		return;
+	}
+
+#ifdef CEL_THREAD_SAFE
+	if (atomic_fetch_sub(&regex->ref_count, 1) != 1) {
+		return;
+	}
+#else
+	regex->ref_count--;
+	if (regex->ref_count > 0) {
+		return;
+	}
+#endif
+
+	pcre2_code_free(regex->code);
+	free(regex);
+}
+
+bool cel_regex_match(const cel_regex_t *regex, const char *subject,
+		     size_t length, bool *matched)
+{
+	if (!regex || !subject || !matched) {
+		return false;
+	}
+
+	pcre2_match_data *data = thread_match_data();
+	if (!data) {
+		return false;
+	}
+
+	int rc = pcre2_match(regex->code, (PCRE2_SPTR)subject, length, 0, 0,
+			     data, NULL);
+	if (rc == PCRE2_ERROR_NOMATCH) {
+		*matched = false;
+		return true;
+	}
+
+	/* rc == 0 表示匹配成功但偏移向量不足以容纳捕获组 */
+	*matched = rc >= 0;
+	return rc >= 0;
+}
+
+/* ========== 缓存 ========== */
+
+/**
+ * @brief 淘汰最久未使用的条目直到不超过容量 (调用者持有锁)
+ */
+static void cache_evict(size_t capacity)
+{
+	while (HASH_COUNT(cache) > capacity) {
+		regex_cache_entry_t *oldest = cache;
+		HASH_DEL(cache, oldest);
+		cel_regex_release(oldest->regex);
+		free(oldest->pattern);
+		free(oldest);
+	}
+}
+
+/**
+ * @brief 查找条目并标记为最近使用 (调用者持有锁)
+ *
+ * @return 正则表达式 (新引用)，未命中返回 NULL
+ */
+static cel_regex_t *cache_lookup(const char *pattern, size_t length)
+{
+	regex_cache_entry_t *entry = NULL;
+	HASH_FIND(hh, cache, pattern, length, entry);
+	if (!entry) {
+		return NULL;
+	}
+
+	HASH_DEL(cache, entry);
+	HASH_ADD_KEYPTR(hh, cache, entry->pattern, entry->length, entry);
+	return cel_regex_retain(entry->regex);
+}
+
+cel_regex_t *cel_regex_cache_get(const char *pattern, size_t length,
+				 char *error, size_t error_size)
+{
+	if (!pattern) {
+		return cel_regex_compile(pattern, length, error, error_size);
+	}
+
+	CACHE_LOCK();
+	cel_regex_t *regex = cache_lookup(pattern, length);
+	CACHE_UNLOCK();
+	if (regex) {
+		return regex;
+	}
+
+	/* 在锁外编译，避免慢速编译阻塞其他线程的命中 */
+	regex = cel_regex_compile(pattern, length, error, error_size);
+	if (!regex) {
+		return NULL;
+	}
+
+	regex_cache_entry_t *entry = malloc(sizeof(regex_cache_entry_t));
+	char *key = malloc(length + 1);
+	if (!entry || !key) {
+		/* 无法缓存时仍然返回编译结果 */
+		free(entry);
+		free(key);
+		return regex;
+	}
+	memcpy(key, pattern, length);
+	key[length] = '\0';
+	entry->pattern = key;
+	entry->length = length;
+	entry->regex = cel_regex_retain(regex);
+
+	CACHE_LOCK();
+	/* 其他线程可能已经编译并缓存了同一模式 */
+	cel_regex_t *existing = cache_lookup(pattern, length);
+	if (!existing && cache_capacity > 0) {
+		HASH_ADD_KEYPTR(hh, cache, entry->pattern, entry->length,
+				entry);
+		cache_evict(cache_capacity);
+		entry = NULL;
+	}
+	CACHE_UNLOCK();
+
+	if (entry) {
+		cel_regex_release(entry->regex);
+		free(entry->pattern);
+		free(entry);
+	}
+	if (existing) {
+		cel_regex_release(regex);
+		return existing;
+	}
+	return regex;
+}
+
+void cel_regex_cache_set_capacity(size_t capacity)
+{
+	CACHE_LOCK();
+	cache_capacity = capacity;
+	cache_evict(capacity);
+	CACHE_UNLOCK();
+}
+
+size_t cel_regex_cache_size(void)
+{
+	CACHE_LOCK();
+	size_t size = HASH_COUNT(cache);
+	CACHE_UNLOCK();
+	return size;
+}
+
+void cel_regex_cache_clear(void)
+{
+	CACHE_LOCK();
+	cache_evict(0);
+	CACHE_UNLOCK();
+}
+
+#else /* !CEL_ENABLE_REGEX */
+
+/* ========== 未启用正则表达式 ========== */
+
+cel_regex_t *cel_regex_compile(const char *pattern, size_t length,
+			       char *error, size_t error_size)
+{
+	(void)pattern;
+	(void)length;
+	if (error && error_size > 0) {
+		snprintf(error, error_size, "regex support is not enabled");
+	}
+	return NULL;
+}
+
+cel_regex_t *cel_regex_retain(cel_regex_t *regex)
+{
+	return regex;
+}
+
+void cel_regex_release(cel_regex_t *regex)
+{
+	(void)regex;
+}
+
+bool cel_regex_match(const cel_regex_t *regex, const char *subject,
+		     size_t length, bool *matched)
+{
+	(void)regex;
+	(void)subject;
+	(void)length;
+	(void)matched;
+	return false;
+}
+
+cel_regex_t *cel_regex_cache_get(const char *pattern, size_t length,
+				 char *error, size_t error_size)
+{
+	return cel_regex_compile(pattern, length, error, error_size);
+}
+
+void cel_regex_cache_set_capacity(size_t capacity)
+{
+	(void)capacity;
+}
+
+size_t cel_regex_cache_size(void)
+{
+	return 0;
+}
+
+void cel_regex_cache_clear(void)
+{
+}
+
+#endif /* CEL_ENABLE_REGEX */
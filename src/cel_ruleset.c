@@ -0,0 +1,1445 @@
+/**
+ * @file cel_ruleset.c
+ * @brief CEL 规则集实现
+ *
+ * 加入规则时按后序遍历 AST，每个节点在子节点编号确定后进行
+ * 哈希合并 (hash consing)：种类、运算符、子节点编号与字面量均相同的
+ * 节点复用已有编号。由于子节点先于父节点合并，结构相同的子树必然
+ * 得到相同的编号，比较只需一层。
+ *
+ * 求值时按需递归计算节点，结果缓存在每次求值私有的数组中。
+ *
+ * 谓词索引: 每条规则的顶层合取项 (a && b && ...) 都是规则匹配的必要
+ * 条件。加入规则时从中选出一个形如 field == 字面量 或 field < 字面量
+ * 的守卫 (field 为标识符或字段访问链)，等值守卫放入哈希索引，范围
+ * 守卫放入按界限排序的数组。求值时每个被索引的字段只求值一次，
+ * 通过查表与二分查找得到候选规则，只有候选规则 (以及没有可索引
+ * 守卫的规则) 被完整求值。索引只用于排除守卫不可能为 true 的规则，
+ * 守卫本身仍在规则求值时按原语义计算。
+ */
+
+#include "cel/cel_ruleset.h"
+#include "cel/cel_bytecode.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include "uthash/uthash.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 调用参数少于此数量时使用栈缓冲区 */
+#define RULESET_INLINE_ARGS 8
+
+/* 未在 schema 中声明的标识符 */
+#define NO_SLOT SIZE_MAX
+
+/* ========== 内部结构 ========== */
+
+/**
+ * @brief DAG 节点
+ */
+typedef struct {
+	cel_ast_node_type_e kind;    /* 节点种类 */
+	int op;                      /* 运算符 / 内置函数编号 (上下文函数为 -1) */
+	bool flag;                   /* 可选访问 / 方法调用形式 */
+	size_t child_start;          /* 子节点在 edges 中的起始位置 */
+	size_t child_count;          /* 子节点数量 */
+	cel_value_t value;           /* 字面量值 / 字段名 (节点持有) */
+	char *name;                  /* 标识符名 / 函数名 (null 结尾) */
+	size_t name_length;          /* 名称长度 */
+	size_t slot;                 /* 激活记录槽位 (未声明为 NO_SLOT) */
+	cel_bytecode_t *bytecode;    /* 不合并的子表达式 (推导式等) */
+	uint64_t hash;               /* 结构哈希 */
+} dag_node_t;
+
+/**
+ * @brief 规则
+ */
+typedef struct {
+	size_t root;                 /* 根节点编号 */
+	int priority;                /* 优先级 */
+} rule_t;
+
+/**
+ * @brief 范围守卫 (field op bound)
+ */
+typedef struct {
+	double bound;                /* 界限 (int 字面量转换为 double) */
+	size_t rule;                 /* 规则编号 */
+} range_entry_t;
+
+/**
+ * @brief 按界限升序排列的范围守卫
+ */
+typedef struct {
+	range_entry_t *items;
+	size_t count;
+	size_t capacity;
+} range_list_t;
+
+/**
+ * @brief 一个字段上的索引
+ */
+typedef struct {
+	size_t field;                /* 字段节点编号 */
+	bool has_equality;           /* 是否有等值守卫 */
+	range_list_t lower;          /* field > c、field >= c */
+	range_list_t upper;          /* field < c、field <= c */
+	range_list_t untyped;        /* double 字面量的范围守卫 (字段不是数值时仍为候选) */
+} field_index_t;
+
+/**
+ * @brief 等值索引桶 (uthash, 键为字段编号 + 值类型 + 值)
+ */
+typedef struct {
+	size_t *rules;               /* 规则编号 */
+	size_t count;
+	size_t capacity;
+	size_t key_length;           /* 键长度 */
+	unsigned char *key;          /* 键 */
+	UT_hash_handle hh;           /* uthash 句柄 */
+} eq_bucket_t;
+
+/**
+ * @brief 规则集
+ */
+struct cel_ruleset {
+	const cel_schema_t *schema;  /* 变量布局 (不持有) */
+
+	dag_node_t *nodes;           /* DAG 节点 (子节点编号小于父节点) */
+	size_t node_count;
+	size_t node_capacity;
+
+	size_t *edges;               /* 所有节点的子节点编号 */
+	size_t edge_count;
+	size_t edge_capacity;
+
+	size_t *table;               /* 开放寻址哈希表 (节点编号 + 1，0 为空) */
+	size_t table_capacity;       /* 2 的幂 */
+	size_t table_count;
+
+	rule_t *rules;               /* 规则 (按规则编号) */
+	size_t rule_count;
+	size_t rule_capacity;
+	size_t *order;               /* 按优先级降序排列的规则编号 */
+	size_t *rank;                /* 规则在 order 中的位置 */
+
+	field_index_t *fields;       /* 被索引的字段 */
+	size_t field_count;
+	size_t field_capacity;
+	eq_bucket_t *buckets;        /* 等值索引 */
+	size_t *unindexed;           /* 没有可索引守卫的规则 (容量同 rules) */
+	size_t unindexed_count;
+};
+
+/* ========== 结构哈希 ========== */
+
+static uint64_t hash_mix(uint64_t hash, uint64_t value)
+{
+	hash ^= value;
+	hash *= UINT64_C(0x100000001b3);
+	return hash;
+}
+
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t length)
+{
+	const unsigned char *p = data;
+	for (size_t i = 0; i < length; i++) {
+		hash = hash_mix(hash, p[i]);
+	}
+	return hash;
+}
+
+static uint64_t hash_value(uint64_t hash, const cel_value_t *value)
+{
+	hash = hash_mix(hash, (uint64_t)value->type);
+
+	switch (value->type) {
+	case CEL_TYPE_BOOL:
+		return hash_mix(hash, value->value.bool_value);
+	case CEL_TYPE_INT:
+		return hash_mix(hash, (uint64_t)value->value.int_value);
+	case CEL_TYPE_UINT:
+		return hash_mix(hash, value->value.uint_value);
+	case CEL_TYPE_DOUBLE:
+		return hash_bytes(hash, &value->value.double_value,
+				  sizeof(double));
+	case CEL_TYPE_STRING:
+		return hash_bytes(hash, value->value.string_value->data,
+				  value->value.string_value->length);
+	case CEL_TYPE_BYTES:
+		return hash_bytes(hash, value->value.bytes_value->data,
+				  value->value.bytes_value->length);
+	default:
+		/* 聚合与时间类型只按类型哈希，由 values_identical 区分 */
+		return hash;
+	}
+}
+
+/**
+ * @brief 字面量是否可以互相替换
+ *
+ * double 按位比较: 0.0 与 -0.0 不可互换，NaN 与自身可以互换。
+ */
+static bool values_identical(const cel_value_t *a, const cel_value_t *b)
+{
+	if (a->type != b->type) {
+		return false;
+	}
+	if (a->type == CEL_TYPE_DOUBLE) {
+		return memcmp(&a->value.double_value, &b->value.double_value,
+			      sizeof(double)) == 0;
+	}
+	return cel_value_equals(a, b);
+}
+
+static uint64_t hash_node(const dag_node_t *node, const size_t *children)
+{
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	hash = hash_mix(hash, (uint64_t)node->kind);
+	hash = hash_mix(hash, (uint64_t)(int64_t)node->op);
+	hash = hash_mix(hash, node->flag);
+	hash = hash_value(hash, &node->value);
+	if (node->name) {
+		hash = hash_bytes(hash, node->name, node->name_length);
+	}
+	for (size_t i = 0; i < node->child_count; i++) {
+		hash = hash_mix(hash, children[i]);
+	}
+	return hash;
+}
+
+static bool nodes_identical(const cel_ruleset_t *rs, const dag_node_t *existing,
+			    const dag_node_t *node, const size_t *children)
+{
+	if (existing->hash != node->hash || existing->kind != node->kind ||
+	    existing->op != node->op || existing->flag != node->flag ||
+	    existing->child_count != node->child_count ||
+	    existing->name_length != node->name_length ||
+	    !values_identical(&existing->value, &node->value)) {
+		return false;
+	}
+	if (node->name && memcmp(existing->name, node->name,
+				 node->name_length) != 0) {
+		return false;
+	}
+	return node->child_count == 0 ||
+	       memcmp(&rs->edges[existing->child_start], children,
+		      node->child_count * sizeof(size_t)) == 0;
+}
+
+/* ========== 节点表 ========== */
+
+static bool table_insert(cel_ruleset_t *rs, size_t id);
+
+static bool table_grow(cel_ruleset_t *rs)
+{
+	size_t *old = rs->table;
+	size_t old_capacity = rs->table_capacity;
+
+	rs->table_capacity = old_capacity ? old_capacity * 2 : 64;
+	rs->table = calloc(rs->table_capacity, sizeof(size_t));
+	if (!rs->table) {
+		rs->table = old;
+		rs->table_capacity = old_capacity;
+		return false;
+	}
+
+	rs->table_count = 0;
+	for (size_t i = 0; i < old_capacity; i++) {
+		if (old[i]) {
+			table_insert(rs, old[i] - 1);
+		}
+	}
+	free(old);
+	return true;
+}
+
+static bool table_insert(cel_ruleset_t *rs, size_t id)
+{
+	if ((rs->table_count + 1) * 2 > rs->table_capacity && !table_grow(rs)) {
+		return false;
+	}
+
+	size_t mask = rs->table_capacity - 1;
+	size_t i = (size_t)rs->nodes[id].hash & mask;
+	while (rs->table[i]) {
+		i = (i + 1) & mask;
+	}
+	rs->table[i] = id + 1;
+	rs->table_count++;
+	return true;
+}
+
+static bool table_find(const cel_ruleset_t *rs, const dag_node_t *node,
+		       const size_t *children, size_t *id)
+{
+	if (!rs->table_capacity) {
+		return false;
+	}
+
+	size_t mask = rs->table_capacity - 1;
+	for (size_t i = (size_t)node->hash & mask; rs->table[i];
+	     i = (i + 1) & mask) {
+		const dag_node_t *existing = &rs->nodes[rs->table[i] - 1];
+		if (nodes_identical(rs, existing, node, children)) {
+			*id = rs->table[i] - 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void node_release(dag_node_t *node)
+{
+	cel_value_destroy(&node->value);
+	free(node->name);
+	cel_bytecode_destroy(node->bytecode);
+}
+
+/**
+ * @brief 加入节点，结构相同的节点已存在时复用 (node 的资源被释放)
+ *
+ * @param merge 是否参与合并
+ */
+static bool add_node(cel_ruleset_t *rs, dag_node_t *node,
+		     const size_t *children, bool merge, size_t *id)
+{
+	node->hash = hash_node(node, children);
+	if (merge && table_find(rs, node, children, id)) {
+		node_release(node);
+		return true;
+	}
+
+	if (rs->node_count == rs->node_capacity) {
+		size_t capacity = rs->node_capacity ? rs->node_capacity * 2 : 64;
+		dag_node_t *nodes = realloc(rs->nodes, capacity * sizeof(dag_node_t));
+		if (!nodes) {
+			goto fail;
+		}
+		rs->nodes = nodes;
+		rs->node_capacity = capacity;
+	}
+
+	if (rs->edge_count + node->child_count > rs->edge_capacity) {
+		size_t capacity = rs->edge_capacity ? rs->edge_capacity * 2 : 64;
+		while (capacity < rs->edge_count + node->child_count) {
+			capacity *= 2;
+		}
+		size_t *edges = realloc(rs->edges, capacity * sizeof(size_t));
+		if (!edges) {
+			goto fail;
+		}
+		rs->edges = edges;
+		rs->edge_capacity = capacity;
+	}
+
+	node->child_start = rs->edge_count;
+	if (node->child_count > 0) {
+		memcpy(&rs->edges[rs->edge_count], children,
+		       node->child_count * sizeof(size_t));
+	}
+	rs->edge_count += node->child_count;
+
+	*id = rs->node_count;
+	rs->nodes[rs->node_count++] = *node;
+	if (merge) {
+		/* 插入失败时节点仍然有效，只是不能被后续规则复用 */
+		table_insert(rs, *id);
+	}
+	return true;
+
+fail:
+	node_release(node);
+	return false;
+}
+
+/* ========== AST 合并 ========== */
+
+static cel_error_code_e build_node(cel_ruleset_t *rs,
+				   const cel_ast_node_t *ast, size_t *id);
+
+/**
+ * @brief 合并子节点后加入父节点
+ */
+static cel_error_code_e build_with_children(cel_ruleset_t *rs,
+					    dag_node_t *node,
+					    const cel_ast_node_t *const *asts,
+					    size_t count, size_t *id)
+{
+	size_t local[RULESET_INLINE_ARGS] = {0};
+	size_t *children = local;
+	if (count > RULESET_INLINE_ARGS) {
+		children = malloc(count * sizeof(size_t));
+		if (!children) {
+			node_release(node);
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+	}
+
+	cel_error_code_e err = CEL_OK;
+	for (size_t i = 0; i < count && err == CEL_OK; i++) {
+		err = build_node(rs, asts[i], &children[i]);
+	}
+
+	node->child_count = count;
+	if (err == CEL_OK && !add_node(rs, node, children, true, id)) {
+		err = CEL_ERROR_OUT_OF_MEMORY;
+	} else if (err != CEL_OK) {
+		node_release(node);
+	}
+
+	if (children != local) {
+		free(children);
+	}
+	return err;
+}
+
+static char *copy_name(const char *name, size_t length)
+{
+	char *copy = malloc(length + 1);
+	if (copy) {
+		memcpy(copy, name, length);
+		copy[length] = '\0';
+	}
+	return copy;
+}
+
+static cel_error_code_e build_call(cel_ruleset_t *rs, dag_node_t *node,
+				   const cel_ast_call_t *call, size_t *id)
+{
+	bool has_target = call->target != NULL;
+	size_t count = call->arg_count + (has_target ? 1 : 0);
+
+	cel_function_id_e builtin;
+	node->flag = has_target;
+	node->op = cel_builtin_resolve(call->function, call->function_length,
+				       has_target, count, &builtin) ?
+			   (int)builtin : -1;
+	node->name = copy_name(call->function, call->function_length);
+	node->name_length = call->function_length;
+	if (!node->name) {
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+
+	const cel_ast_node_t *local[RULESET_INLINE_ARGS];
+	const cel_ast_node_t **asts = local;
+	if (count > RULESET_INLINE_ARGS) {
+		asts = malloc(count * sizeof(cel_ast_node_t *));
+		if (!asts) {
+			node_release(node);
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+	}
+
+	size_t n = 0;
+	if (has_target) {
+		asts[n++] = call->target;
+	}
+	for (size_t i = 0; i < call->arg_count; i++) {
+		asts[n++] = call->args[i];
+	}
+
+	cel_error_code_e err = build_with_children(rs, node, asts, count, id);
+	if (asts != local) {
+		free(asts);
+	}
+	return err;
+}
+
+static cel_error_code_e build_map(cel_ruleset_t *rs, dag_node_t *node,
+				  const cel_ast_map_t *map, size_t *id)
+{
+	size_t count = map->entry_count * 2;
+	const cel_ast_node_t **asts = malloc((count ? count : 1) *
+					     sizeof(cel_ast_node_t *));
+	if (!asts) {
+		return CEL_ERROR_OUT_OF_MEMORY;
+	}
+
+	for (size_t i = 0; i < map->entry_count; i++) {
+		asts[2 * i] = map->entries[i].key;
+		asts[2 * i + 1] = map->entries[i].value;
+	}
+
+	cel_error_code_e err = build_with_children(rs, node, asts, count, id);
+	free(asts);
+	return err;
+}
+
+static cel_error_code_e build_node(cel_ruleset_t *rs,
+				   const cel_ast_node_t *ast, size_t *id)
+{
+	dag_node_t node = {
+		.kind = ast->type,
+		.value = cel_value_null(),
+		.slot = NO_SLOT,
+	};
+
+	switch (ast->type) {
+	case CEL_AST_LITERAL:
+		node.value = cel_value_retain(&ast->as.literal.value);
+		return add_node(rs, &node, NULL, true, id) ?
+			       CEL_OK : CEL_ERROR_OUT_OF_MEMORY;
+
+	case CEL_AST_IDENT:
+		node.name = copy_name(ast->as.ident.name, ast->as.ident.length);
+		node.name_length = ast->as.ident.length;
+		if (!node.name) {
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+		if (rs->schema &&
+		    !cel_schema_find(rs->schema, ast->as.ident.name,
+				     ast->as.ident.length, &node.slot)) {
+			node.slot = NO_SLOT;
+		}
+		return add_node(rs, &node, NULL, true, id) ?
+			       CEL_OK : CEL_ERROR_OUT_OF_MEMORY;
+
+	case CEL_AST_UNARY: {
+		const cel_ast_node_t *child = ast->as.unary.operand;
+		node.op = (int)ast->as.unary.op;
+		return build_with_children(rs, &node, &child, 1, id);
+	}
+
+	case CEL_AST_BINARY: {
+		const cel_ast_node_t *children[2] = {ast->as.binary.left,
+						     ast->as.binary.right};
+		node.op = (int)ast->as.binary.op;
+		return build_with_children(rs, &node, children, 2, id);
+	}
+
+	case CEL_AST_TERNARY: {
+		const cel_ast_node_t *children[3] = {
+			ast->as.ternary.condition, ast->as.ternary.if_true,
+			ast->as.ternary.if_false};
+		return build_with_children(rs, &node, children, 3, id);
+	}
+
+	case CEL_AST_SELECT: {
+		const cel_ast_node_t *child = ast->as.select.operand;
+		node.flag = ast->as.select.optional;
+		node.value = cel_value_string_n(ast->as.select.field,
+						ast->as.select.field_length);
+		return build_with_children(rs, &node, &child, 1, id);
+	}
+
+	case CEL_AST_INDEX: {
+		const cel_ast_node_t *children[2] = {ast->as.index.operand,
+						     ast->as.index.index};
+		node.flag = ast->as.index.optional;
+		return build_with_children(rs, &node, children, 2, id);
+	}
+
+	case CEL_AST_CALL:
+		return build_call(rs, &node, &ast->as.call, id);
+
+	case CEL_AST_LIST:
+		return build_with_children(
+			rs, &node,
+			(const cel_ast_node_t *const *)ast->as.list.elements,
+			ast->as.list.element_count, id);
+
+	case CEL_AST_MAP:
+		return build_map(rs, &node, &ast->as.map, id);
+
+	default:
+		/* 推导式的循环变量使子表达式的值依赖于迭代，不参与合并；
+		 * 无法编译的节点 (结构体字面量) 求值时总是失败 */
+		node.bytecode = cel_bytecode_compile(ast, rs->schema);
+		return add_node(rs, &node, NULL, false, id) ?
+			       CEL_OK : CEL_ERROR_OUT_OF_MEMORY;
+	}
+}
+
+/* ========== 谓词索引 ========== */
+
+/* 等值索引键的栈缓冲区大小 (更长的字符串键动态分配) */
+#define INDEX_INLINE_KEY 64
+
+/**
+ * @brief 节点是否为字段路径 (标识符或其上的字段访问链)
+ */
+static bool is_field_path(const cel_ruleset_t *rs, size_t id)
+{
+	const dag_node_t *node = &rs->nodes[id];
+	while (node->kind == CEL_AST_SELECT) {
+		node = &rs->nodes[rs->edges[node->child_start]];
+	}
+	return node->kind == CEL_AST_IDENT;
+}
+
+/**
+ * @brief 构造等值索引键
+ *
+ * 等值比较要求类型相同，因此键包含值类型。0.0 与 -0.0 相等，
+ * 统一为 0.0；NaN 与任何值都不相等，不能索引。
+ *
+ * @return 键长度 (大于 capacity 时需要更大的缓冲区重新构造)，
+ *         值不能索引时返回 0
+ */
+static size_t eq_key(size_t field, const cel_value_t *value,
+		     unsigned char *buffer, size_t capacity)
+{
+	const void *payload = NULL;
+	size_t payload_length = 0;
+	double number;
+
+	switch (value->type) {
+	case CEL_TYPE_NULL:
+		break;
+	case CEL_TYPE_BOOL:
+		payload = &value->value.bool_value;
+		payload_length = sizeof(bool);
+		break;
+	case CEL_TYPE_INT:
+		payload = &value->value.int_value;
+		payload_length = sizeof(int64_t);
+		break;
+	case CEL_TYPE_UINT:
+		payload = &value->value.uint_value;
+		payload_length = sizeof(uint64_t);
+		break;
+	case CEL_TYPE_DOUBLE:
+		if (isnan(value->value.double_value)) {
+			return 0;
+		}
+		number = value->value.double_value == 0.0 ?
+				 0.0 : value->value.double_value;
+		payload = &number;
+		payload_length = sizeof(double);
+		break;
+	case CEL_TYPE_STRING:
+		payload = value->value.string_value->data;
+		payload_length = value->value.string_value->length;
+		break;
+	case CEL_TYPE_BYTES:
+		payload = value->value.bytes_value->data;
+		payload_length = value->value.bytes_value->length;
+		break;
+	default:
+		return 0;
+	}
+
+	unsigned char type = (unsigned char)value->type;
+	size_t length = sizeof(size_t) + 1 + payload_length;
+	if (length <= capacity) {
+		memcpy(buffer, &field, sizeof(size_t));
+		buffer[sizeof(size_t)] = type;
+		if (payload_length > 0) {
+			memcpy(buffer + sizeof(size_t) + 1, payload, payload_length);
+		}
+	}
+	return length;
+}
+
+static bool append_rule(size_t **rules, size_t *count, size_t *capacity,
+			size_t rule)
+{
+	if (*count == *capacity) {
+		size_t new_capacity = *capacity ? *capacity * 2 : 4;
+		size_t *new_rules = realloc(*rules, new_capacity * sizeof(size_t));
+		if (!new_rules) {
+			return false;
+		}
+		*rules = new_rules;
+		*capacity = new_capacity;
+	}
+	(*rules)[(*count)++] = rule;
+	return true;
+}
+
+/**
+ * @brief 按界限有序插入范围守卫
+ */
+static bool range_insert(range_list_t *list, double bound, size_t rule)
+{
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity ? list->capacity * 2 : 4;
+		range_entry_t *items = realloc(list->items,
+					       capacity * sizeof(range_entry_t));
+		if (!items) {
+			return false;
+		}
+		list->items = items;
+		list->capacity = capacity;
+	}
+
+	size_t pos = list->count++;
+	while (pos > 0 && list->items[pos - 1].bound > bound) {
+		list->items[pos] = list->items[pos - 1];
+		pos--;
+	}
+	list->items[pos].bound = bound;
+	list->items[pos].rule = rule;
+	return true;
+}
+
+static field_index_t *field_index(cel_ruleset_t *rs, size_t field)
+{
+	for (size_t i = 0; i < rs->field_count; i++) {
+		if (rs->fields[i].field == field) {
+			return &rs->fields[i];
+		}
+	}
+
+	if (rs->field_count == rs->field_capacity) {
+		size_t capacity = rs->field_capacity ? rs->field_capacity * 2 : 8;
+		field_index_t *fields = realloc(rs->fields,
+						capacity * sizeof(field_index_t));
+		if (!fields) {
+			return NULL;
+		}
+		rs->fields = fields;
+		rs->field_capacity = capacity;
+	}
+
+	field_index_t *index = &rs->fields[rs->field_count++];
+	memset(index, 0, sizeof(field_index_t));
+	index->field = field;
+	return index;
+}
+
+/**
+ * @brief 守卫 (field op literal)
+ */
+typedef struct {
+	bool found;
+	size_t field;                /* 字段节点编号 */
+	cel_binary_op_e op;          /* 运算符 (字段在左侧) */
+	const cel_value_t *literal;  /* 字面量 */
+} guard_t;
+
+static bool range_literal(const cel_value_t *literal)
+{
+	return literal->type == CEL_TYPE_INT ||
+	       (literal->type == CEL_TYPE_DOUBLE &&
+		!isnan(literal->value.double_value));
+}
+
+/**
+ * @brief 在顶层合取项中选择守卫 (等值守卫优先)
+ */
+static void find_guard(const cel_ruleset_t *rs, size_t id, guard_t *guard)
+{
+	const dag_node_t *node = &rs->nodes[id];
+	if (node->kind != CEL_AST_BINARY) {
+		return;
+	}
+
+	cel_binary_op_e op = (cel_binary_op_e)node->op;
+	size_t left = rs->edges[node->child_start];
+	size_t right = rs->edges[node->child_start + 1];
+
+	if (op == CEL_BINARY_AND) {
+		find_guard(rs, left, guard);
+		find_guard(rs, right, guard);
+		return;
+	}
+	if (op != CEL_BINARY_EQ && (op < CEL_BINARY_LT || op > CEL_BINARY_GE)) {
+		return;
+	}
+
+	/* 字面量在左侧时交换操作数 */
+	if (rs->nodes[left].kind == CEL_AST_LITERAL) {
+		size_t tmp = left;
+		left = right;
+		right = tmp;
+		switch (op) {
+		case CEL_BINARY_LT:
+			op = CEL_BINARY_GT;
+			break;
+		case CEL_BINARY_LE:
+			op = CEL_BINARY_GE;
+			break;
+		case CEL_BINARY_GT:
+			op = CEL_BINARY_LT;
+			break;
+		case CEL_BINARY_GE:
+			op = CEL_BINARY_LE;
+			break;
+		default:
+			break;
+		}
+	}
+	if (rs->nodes[right].kind != CEL_AST_LITERAL || !is_field_path(rs, left)) {
+		return;
+	}
+
+	const cel_value_t *literal = &rs->nodes[right].value;
+	bool equality = op == CEL_BINARY_EQ;
+	if (equality ? eq_key(left, literal, NULL, 0) == 0 : !range_literal(literal)) {
+		return;
+	}
+	if (guard->found && (!equality || guard->op == CEL_BINARY_EQ)) {
+		return;
+	}
+
+	guard->found = true;
+	guard->field = left;
+	guard->op = op;
+	guard->literal = literal;
+}
+
+static bool index_equality(cel_ruleset_t *rs, const guard_t *guard,
+			   size_t rule)
+{
+	size_t length = eq_key(guard->field, guard->literal, NULL, 0);
+	unsigned char *key = malloc(length);
+	if (!key) {
+		return false;
+	}
+	eq_key(guard->field, guard->literal, key, length);
+
+	eq_bucket_t *bucket = NULL;
+	HASH_FIND(hh, rs->buckets, key, length, bucket);
+	if (bucket) {
+		free(key);
+		return append_rule(&bucket->rules, &bucket->count,
+				   &bucket->capacity, rule);
+	}
+
+	bucket = calloc(1, sizeof(eq_bucket_t));
+	if (!bucket || !append_rule(&bucket->rules, &bucket->count,
+				    &bucket->capacity, rule)) {
+		free(bucket);
+		free(key);
+		return false;
+	}
+	bucket->key = key;
+	bucket->key_length = length;
+	HASH_ADD_KEYPTR(hh, rs->buckets, bucket->key, bucket->key_length,
+			bucket);
+	return true;
+}
+
+/**
+ * @brief 将规则加入索引，没有可索引守卫时加入 unindexed
+ */
+static void index_rule(cel_ruleset_t *rs, size_t rule)
+{
+	guard_t guard = {0};
+	find_guard(rs, rs->rules[rule].root, &guard);
+
+	field_index_t *index = guard.found ? field_index(rs, guard.field) : NULL;
+	bool indexed = false;
+
+	if (index && guard.op == CEL_BINARY_EQ) {
+		indexed = index_equality(rs, &guard, rule);
+		index->has_equality = index->has_equality || indexed;
+	} else if (index) {
+		/* int 字面量转换为 double 是单调的，比较时使用非严格不等式，
+		 * 因此不会排除守卫为 true 的规则 */
+		double bound = guard.literal->type == CEL_TYPE_INT ?
+				       (double)guard.literal->value.int_value :
+				       guard.literal->value.double_value;
+		range_list_t *list = guard.op == CEL_BINARY_GT ||
+						     guard.op == CEL_BINARY_GE ?
+					     &index->lower : &index->upper;
+		indexed = range_insert(list, bound, rule);
+
+		/* double 字面量与非数值字段比较时不报错，需要保留为候选 */
+		if (indexed && guard.literal->type == CEL_TYPE_DOUBLE &&
+		    !range_insert(&index->untyped, bound, rule)) {
+			/* 从有序数组中移除，改为不索引 */
+			for (size_t i = 0; i < list->count; i++) {
+				if (list->items[i].rule == rule) {
+					memmove(&list->items[i], &list->items[i + 1],
+						(list->count - i - 1) *
+							sizeof(range_entry_t));
+					list->count--;
+					break;
+				}
+			}
+			indexed = false;
+		}
+	}
+
+	if (!indexed) {
+		rs->unindexed[rs->unindexed_count++] = rule;
+	}
+}
+
+static void index_destroy(cel_ruleset_t *rs)
+{
+	for (size_t i = 0; i < rs->field_count; i++) {
+		free(rs->fields[i].lower.items);
+		free(rs->fields[i].upper.items);
+		free(rs->fields[i].untyped.items);
+	}
+	free(rs->fields);
+
+	eq_bucket_t *bucket, *tmp;
+	HASH_ITER(hh, rs->buckets, bucket, tmp)
+	{
+		HASH_DEL(rs->buckets, bucket);
+		free(bucket->rules);
+		free(bucket->key);
+		free(bucket);
+	}
+}
+
+/* ========== 规则集 API ========== */
+
+cel_ruleset_t *cel_ruleset_create(const cel_schema_t *schema)
+{
+	cel_ruleset_t *rs = calloc(1, sizeof(cel_ruleset_t));
+	if (!rs) {
+		return NULL;
+	}
+
+	rs->schema = schema;
+	return rs;
+}
+
+void cel_ruleset_destroy(cel_ruleset_t *ruleset)
+{
+	if (!ruleset) {
+		return;
+	}
+
+	index_destroy(ruleset);
+	for (size_t i = 0; i < ruleset->node_count; i++) {
+		node_release(&ruleset->nodes[i]);
+	}
+	free(ruleset->nodes);
+	free(ruleset->edges);
+	free(ruleset->table);
+	free(ruleset->rules);
+	free(ruleset->order);
+	free(ruleset->rank);
+	free(ruleset->unindexed);
+	free(ruleset);
+}
+
+cel_error_code_e cel_ruleset_add(cel_ruleset_t *ruleset,
+				 const cel_program_t *program, int priority,
+				 size_t *rule_id)
+{
+	if (!ruleset || !program || !program->ast) {
+		return CEL_ERROR_NULL_POINTER;
+	}
+	if (program->schema != ruleset->schema) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	if (ruleset->rule_count == ruleset->rule_capacity) {
+		size_t capacity = ruleset->rule_capacity ?
+					  ruleset->rule_capacity * 2 : 16;
+		rule_t *rules = realloc(ruleset->rules, capacity * sizeof(rule_t));
+		if (!rules) {
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+		ruleset->rules = rules;
+
+		size_t *order = realloc(ruleset->order, capacity * sizeof(size_t));
+		if (!order) {
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+		ruleset->order = order;
+
+		size_t *rank = realloc(ruleset->rank, capacity * sizeof(size_t));
+		if (!rank) {
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+		ruleset->rank = rank;
+
+		size_t *unindexed = realloc(ruleset->unindexed,
+					    capacity * sizeof(size_t));
+		if (!unindexed) {
+			return CEL_ERROR_OUT_OF_MEMORY;
+		}
+		ruleset->unindexed = unindexed;
+		ruleset->rule_capacity = capacity;
+	}
+
+	size_t root;
+	cel_error_code_e err = build_node(ruleset, program->ast, &root);
+	if (err != CEL_OK) {
+		return err;
+	}
+
+	size_t id = ruleset->rule_count++;
+	ruleset->rules[id].root = root;
+	ruleset->rules[id].priority = priority;
+
+	/* 插入到优先级顺序中 (同优先级保持加入顺序) */
+	size_t pos = id;
+	while (pos > 0 && ruleset->rules[ruleset->order[pos - 1]].priority <
+				  priority) {
+		ruleset->order[pos] = ruleset->order[pos - 1];
+		pos--;
+	}
+	ruleset->order[pos] = id;
+	for (size_t i = pos; i <= id; i++) {
+		ruleset->rank[ruleset->order[i]] = i;
+	}
+
+	index_rule(ruleset, id);
+
+	if (rule_id) {
+		*rule_id = id;
+	}
+	return CEL_OK;
+}
+
+size_t cel_ruleset_rule_count(const cel_ruleset_t *ruleset)
+{
+	return ruleset ? ruleset->rule_count : 0;
+}
+
+size_t cel_ruleset_node_count(const cel_ruleset_t *ruleset)
+{
+	return ruleset ? ruleset->node_count : 0;
+}
+
+size_t cel_ruleset_indexed_count(const cel_ruleset_t *ruleset)
+{
+	return ruleset ? ruleset->rule_count - ruleset->unindexed_count : 0;
+}
+
+/* ========== 求值 ========== */
+
+/**
+ * @brief 节点求值状态
+ */
+enum {
+	NODE_PENDING = 0,            /* 尚未求值 */
+	NODE_DONE,                   /* 已求值，值在 values 中 */
+	NODE_FAILED,                 /* 求值失败 */
+};
+
+/**
+ * @brief 一次求值的状态
+ */
+typedef struct {
+	const cel_ruleset_t *rs;
+	cel_context_t *ctx;
+	const cel_activation_t *activation;
+	cel_value_t *values;         /* 节点值 (state 为 NODE_DONE 时有效) */
+	unsigned char *state;        /* 节点求值状态 */
+} dag_eval_t;
+
+static const cel_value_t *eval_dag(dag_eval_t *e, size_t id);
+
+static const cel_value_t *eval_child(dag_eval_t *e, const dag_node_t *node,
+				     size_t i)
+{
+	return eval_dag(e, e->rs->edges[node->child_start + i]);
+}
+
+static bool eval_ident(dag_eval_t *e, const dag_node_t *node,
+		       cel_value_t *out)
+{
+	const cel_activation_t *activation = e->activation;
+	if (activation && node->slot < activation->count &&
+	    activation->bound[node->slot]) {
+		*out = cel_value_retain(&activation->values[node->slot]);
+		return true;
+	}
+
+	cel_value_t *value = cel_context_get_variable(e->ctx, node->name);
+	if (!value) {
+		cel_eval_report_error_detail(e->ctx,
+					     CEL_ERROR_UNKNOWN_IDENTIFIER,
+					     "Undefined variable", node->name,
+					     strlen(node->name));
+		return false;
+	}
+
+	*out = cel_value_retain(value);
+	return true;
+}
+
+/**
+ * @brief 求值 bool 操作数 (&&、|| 与三元条件)
+ */
+static bool eval_bool(dag_eval_t *e, const dag_node_t *node, size_t i,
+		      const char *message, bool *out)
+{
+	const cel_value_t *value = eval_child(e, node, i);
+	if (!value) {
+		return false;
+	}
+	if (value->type != CEL_TYPE_BOOL) {
+		cel_eval_report_error(e->ctx, CEL_ERROR_TYPE_MISMATCH, message);
+		return false;
+	}
+
+	*out = value->value.bool_value;
+	return true;
+}
+
+static bool eval_binary(dag_eval_t *e, const dag_node_t *node,
+			cel_value_t *out)
+{
+	cel_binary_op_e op = (cel_binary_op_e)node->op;
+
+	if (op == CEL_BINARY_AND || op == CEL_BINARY_OR) {
+		const char *message = "Logical operator requires boolean operands";
+		bool left, right;
+		if (!eval_bool(e, node, 0, message, &left)) {
+			return false;
+		}
+		/* 短路 */
+		if (left == (op == CEL_BINARY_OR)) {
+			*out = cel_value_bool(left);
+			return true;
+		}
+		if (!eval_bool(e, node, 1, message, &right)) {
+			return false;
+		}
+		*out = cel_value_bool(right);
+		return true;
+	}
+
+	const cel_value_t *left = eval_child(e, node, 0);
+	const cel_value_t *right = left ? eval_child(e, node, 1) : NULL;
+	return right && cel_eval_binary_op(e->ctx, op, left, right, out);
+}
+
+/**
+ * @brief 求值所有子节点，结果浅拷贝到 args (值由缓存持有)
+ */
+static bool eval_children(dag_eval_t *e, const dag_node_t *node,
+			  cel_value_t *args)
+{
+	for (size_t i = 0; i < node->child_count; i++) {
+		const cel_value_t *value = eval_child(e, node, i);
+		if (!value) {
+			return false;
+		}
+		args[i] = *value;
+	}
+	return true;
+}
+
+static bool eval_aggregate(dag_eval_t *e, const dag_node_t *node,
+			   cel_value_t *out)
+{
+	cel_value_t local[RULESET_INLINE_ARGS];
+	cel_value_t *items = local;
+	if (node->child_count > RULESET_INLINE_ARGS) {
+		items = malloc(node->child_count * sizeof(cel_value_t));
+		if (!items) {
+			cel_eval_report_error(e->ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Out of memory");
+			return false;
+		}
+	}
+
+	bool success = eval_children(e, node, items);
+	if (success && node->kind == CEL_AST_CALL) {
+		success = node->op >= 0 ?
+				  cel_builtin_call((cel_function_id_e)node->op,
+						   e->ctx, items, out) :
+				  cel_eval_call_context_function(
+					  e->ctx, node->name, items,
+					  node->child_count, out);
+	} else if (success && node->kind == CEL_AST_LIST) {
+		cel_list_t *list = cel_list_create(node->child_count);
+		for (size_t i = 0; list && i < node->child_count; i++) {
+			if (!cel_list_append(list, &items[i])) {
+				cel_list_release(list);
+				list = NULL;
+			}
+		}
+		success = list != NULL;
+		if (success) {
+			*out = cel_value_list(list);
+		} else {
+			cel_eval_report_error(e->ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Failed to create list");
+		}
+	} else if (success) {
+		size_t entries = node->child_count / 2;
+		cel_map_t *map = cel_map_create(entries > 0 ? entries : 16);
+		for (size_t i = 0; map && i < entries; i++) {
+			if (!cel_map_put(map, &items[2 * i], &items[2 * i + 1])) {
+				cel_map_release(map);
+				map = NULL;
+			}
+		}
+		success = map != NULL;
+		if (success) {
+			*out = cel_value_map(map);
+		} else {
+			cel_eval_report_error(e->ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Failed to create map");
+		}
+	}
+
+	if (items != local) {
+		free(items);
+	}
+	return success;
+}
+
+static bool eval_node(dag_eval_t *e, const dag_node_t *node, cel_value_t *out)
+{
+	const cel_value_t *a;
+	const cel_value_t *b;
+
+	switch (node->kind) {
+	case CEL_AST_LITERAL:
+		*out = cel_value_retain(&node->value);
+		return true;
+
+	case CEL_AST_IDENT:
+		return eval_ident(e, node, out);
+
+	case CEL_AST_UNARY:
+		a = eval_child(e, node, 0);
+		return a && cel_eval_unary_op(e->ctx, (cel_unary_op_e)node->op,
+					      a, out);
+
+	case CEL_AST_BINARY:
+		return eval_binary(e, node, out);
+
+	case CEL_AST_TERNARY: {
+		bool condition;
+		if (!eval_bool(e, node, 0, "Ternary condition must be boolean",
+			       &condition)) {
+			return false;
+		}
+		a = eval_child(e, node, condition ? 1 : 2);
+		if (!a) {
+			return false;
+		}
+		*out = cel_value_retain(a);
+		return true;
+	}
+
+	case CEL_AST_SELECT:
+		a = eval_child(e, node, 0);
+		return a && cel_eval_select_field(e->ctx, a, &node->value,
+						  node->flag, out);
+
+	case CEL_AST_INDEX:
+		a = eval_child(e, node, 0);
+		b = a ? eval_child(e, node, 1) : NULL;
+		return b && cel_eval_index_value(e->ctx, a, b, node->flag, out);
+
+	case CEL_AST_CALL:
+	case CEL_AST_LIST:
+	case CEL_AST_MAP:
+		return eval_aggregate(e, node, out);
+
+	default:
+		if (!node->bytecode) {
+			cel_eval_report_error(e->ctx, CEL_ERROR_UNSUPPORTED,
+					      "Unsupported expression");
+			return false;
+		}
+		return cel_vm_execute(node->bytecode, e->ctx, e->activation, out);
+	}
+}
+
+/**
+ * @brief 求值节点 (每次求值中每个节点最多计算一次)
+ *
+ * @return 节点值 (由缓存持有)，失败返回 NULL
+ */
+static const cel_value_t *eval_dag(dag_eval_t *e, size_t id)
+{
+	switch (e->state[id]) {
+	case NODE_DONE:
+		return &e->values[id];
+	case NODE_FAILED:
+		return NULL;
+	default:
+		break;
+	}
+
+	bool success = eval_node(e, &e->rs->nodes[id], &e->values[id]);
+	e->state[id] = success ? NODE_DONE : NODE_FAILED;
+	return success ? &e->values[id] : NULL;
+}
+
+static bool rule_matches(dag_eval_t *e, size_t rule)
+{
+	const cel_value_t *value = eval_dag(e, e->rs->rules[rule].root);
+	return value && value->type == CEL_TYPE_BOOL && value->value.bool_value;
+}
+
+static int compare_size(const void *a, const void *b)
+{
+	size_t x = *(const size_t *)a;
+	size_t y = *(const size_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void append_range(const range_list_t *list, size_t begin, size_t end,
+			 size_t *candidates, size_t *count)
+{
+	for (size_t i = begin; i < end; i++) {
+		candidates[(*count)++] = list->items[i].rule;
+	}
+}
+
+/**
+ * @brief 界限不大于 value 的条目数量 (lower 列表的候选前缀)
+ */
+static size_t range_upper_bound(const range_list_t *list, double value)
+{
+	size_t lo = 0, hi = list->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (list->items[mid].bound <= value) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * @brief 界限小于 value 的条目数量 (upper 列表候选后缀的起点)
+ */
+static size_t range_lower_bound(const range_list_t *list, double value)
+{
+	size_t lo = 0, hi = list->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (list->items[mid].bound < value) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * @brief 根据守卫字段的值收集候选规则
+ *
+ * 每条规则最多按一个守卫索引，因此候选规则不会重复。
+ * 守卫字段求值失败时守卫不可能为 true，该字段下的规则都不是候选。
+ */
+static size_t collect_candidates(dag_eval_t *e, size_t *candidates)
+{
+	const cel_ruleset_t *rs = e->rs;
+	size_t count = rs->unindexed_count;
+	if (count > 0) {
+		memcpy(candidates, rs->unindexed, count * sizeof(size_t));
+	}
+
+	unsigned char local[INDEX_INLINE_KEY];
+	for (size_t f = 0; f < rs->field_count; f++) {
+		const field_index_t *index = &rs->fields[f];
+		const cel_value_t *value = eval_dag(e, index->field);
+		if (!value) {
+			continue;
+		}
+
+		if (index->has_equality) {
+			size_t length = eq_key(index->field, value, local,
+					       sizeof(local));
+			unsigned char *key = local;
+			if (length > sizeof(local)) {
+				key = malloc(length);
+				if (key) {
+					eq_key(index->field, value, key, length);
+				}
+			}
+
+			eq_bucket_t *bucket = NULL;
+			if (length > 0 && key) {
+				HASH_FIND(hh, rs->buckets, key, length, bucket);
+			}
+			if (key != local) {
+				free(key);
+			}
+			if (bucket) {
+				memcpy(candidates + count, bucket->rules,
+				       bucket->count * sizeof(size_t));
+				count += bucket->count;
+			}
+		}
+
+		if (value->type == CEL_TYPE_INT || value->type == CEL_TYPE_DOUBLE) {
+			double d = value->type == CEL_TYPE_INT ?
+					   (double)value->value.int_value :
+					   value->value.double_value;
+			if (isnan(d)) {
+				continue;
+			}
+			append_range(&index->lower, 0,
+				     range_upper_bound(&index->lower, d),
+				     candidates, &count);
+			append_range(&index->upper,
+				     range_lower_bound(&index->upper, d),
+				     index->upper.count, candidates, &count);
+		} else {
+			append_range(&index->untyped, 0, index->untyped.count,
+				     candidates, &count);
+		}
+	}
+
+	return count;
+}
+
+size_t cel_ruleset_evaluate(const cel_ruleset_t *ruleset, cel_context_t *ctx,
+			    const cel_activation_t *activation,
+			    cel_ruleset_mode_e mode, size_t *matches)
+{
+	if (!ruleset || !ctx || !matches || ruleset->rule_count == 0) {
+		return 0;
+	}
+	if (activation && activation->schema != ruleset->schema) {
+		return 0;
+	}
+
+	dag_eval_t e = {
+		.rs = ruleset,
+		.ctx = ctx,
+		.activation = activation,
+		.values = malloc(ruleset->node_count * sizeof(cel_value_t)),
+		.state = calloc(ruleset->node_count, 1),
+	};
+	size_t *candidates = malloc(ruleset->rule_count * sizeof(size_t));
+	size_t matched = 0;
+	if (!e.values || !e.state || !candidates) {
+		goto cleanup;
+	}
+
+	size_t count = collect_candidates(&e, candidates);
+
+	if (mode == CEL_RULESET_FIRST_MATCH) {
+		/* 按优先级顺序 (rank) 检查候选规则 */
+		for (size_t i = 0; i < count; i++) {
+			candidates[i] = ruleset->rank[candidates[i]];
+		}
+		qsort(candidates, count, sizeof(size_t), compare_size);
+		for (size_t i = 0; i < count; i++) {
+			size_t rule = ruleset->order[candidates[i]];
+			if (rule_matches(&e, rule)) {
+				matches[matched++] = rule;
+				break;
+			}
+		}
+	} else {
+		qsort(candidates, count, sizeof(size_t), compare_size);
+		for (size_t i = 0; i < count; i++) {
+			if (rule_matches(&e, candidates[i])) {
+				matches[matched++] = candidates[i];
+			}
+		}
+	}
+
+cleanup:
+	if (e.values && e.state) {
+		for (size_t i = 0; i < ruleset->node_count; i++) {
+			if (e.state[i] == NODE_DONE) {
+				cel_value_destroy(&e.values[i]);
+			}
+		}
+	}
+	free(e.values);
+	free(e.state);
+	free(candidates);
+	return matched;
+}
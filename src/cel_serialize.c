@@ -0,0 +1,1396 @@
+/**
+ * @file cel_serialize.c
+ * @brief CEL 程序序列化与程序包实现
+ *
+ * 程序映像 = 头部 + 8 字节对齐的各节。AST 与值编码为 32 位字流:
+ * 每个节点以 (类型 | 运算符 << 8 | 标志 << 16) 开头，随后是源码位置
+ * (行、列、偏移、长度) 与节点特有的字段，子节点按前序紧随其后。
+ * 名称与字符串以 (文本节偏移, 长度) 表示，NULL 名称的偏移为
+ * NULL_NAME。字面量与常量以值表下标表示，AST 与字节码共享的值
+ * (例如折叠后的列表) 只写入一次，加载时也只构造一次。
+ *
+ * 程序包 = 头部 + (count + 1) 个映像偏移 + 各映像 (8 字节对齐)。
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* for mmap, fstat */
+
+#include "cel/cel_serialize.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ========== 格式定义 ========== */
+
+#define IMAGE_MAGIC "CELP"
+#define BUNDLE_MAGIC "CELB"
+#define BYTE_ORDER_MARK 0x01020304u
+#define NULL_NAME UINT32_MAX
+#define MAX_VALUE_DEPTH 1024
+
+/* 映像标志 */
+#define IMAGE_HAS_BYTECODE 0x01  /* 包含字节码 */
+#define IMAGE_HAS_SCHEMA 0x02    /* 以 schema 编译 */
+
+/* 节点标志 */
+#define NODE_OPTIONAL 0x01       /* 可选访问 (.? 与 [?]) */
+#define NODE_HAS_TARGET 0x02     /* 方法调用 */
+
+/* 每个 AST 字对应的节点字节数估计 (节点至少占 6 个字)，用于选择 AST
+ * 分配区的块大小 */
+#define AST_BYTES_PER_WORD 24
+
+/**
+ * @brief 节 (相对映像起点的偏移与字节数)
+ */
+typedef struct {
+	uint64_t offset;
+	uint64_t length;
+} section_t;
+
+/**
+ * @brief 程序映像头部
+ */
+typedef struct {
+	char magic[4];               /* "CELP" */
+	uint16_t version;            /* CEL_PROGRAM_FORMAT_VERSION */
+	uint16_t flags;              /* IMAGE_HAS_* */
+	uint32_t byte_order;         /* BYTE_ORDER_MARK (按本机字节序写入) */
+	uint32_t instr_size;         /* sizeof(cel_instr_t) */
+	uint64_t size;               /* 映像大小 */
+	uint64_t eval_depth;         /* AST 深度 (加载时的解码深度上限) */
+	uint64_t register_count;     /* 寄存器数量 */
+	uint64_t value_count;        /* 值表中的值数量 */
+	section_t text;              /* 源代码与名称 (null 结尾) */
+	section_t values;            /* 值表字流 */
+	section_t ast;               /* AST 字流 */
+	section_t code;              /* 指令 */
+	section_t locs;              /* 指令的源码位置 */
+	section_t constants;         /* 常量 (值表下标) */
+	section_t names;             /* 变量名 (文本偏移) */
+	section_t calls;             /* 调用点 (文本偏移、长度、是否方法调用) */
+	section_t patterns;          /* 正则表达式模式 (常量下标) */
+} image_header_t;
+
+/**
+ * @brief 程序包头部 (其后是 count + 1 个 uint64_t 映像偏移)
+ */
+typedef struct {
+	char magic[4];               /* "CELB" */
+	uint16_t version;            /* CEL_PROGRAM_FORMAT_VERSION */
+	uint16_t reserved;
+	uint32_t byte_order;         /* BYTE_ORDER_MARK */
+	uint32_t reserved2;
+	uint64_t count;              /* 程序数量 */
+} bundle_header_t;
+
+/**
+ * @brief 程序包 (内部实现)
+ */
+struct cel_bundle {
+	unsigned char *data;         /* 内容 (mmap 映射或堆内存) */
+	size_t size;                 /* 内容大小 */
+	bool mapped;                 /* data 是否由 mmap 映射 */
+	const uint64_t *offsets;     /* 各映像的偏移 (count + 1 项) */
+	size_t count;                /* 程序数量 */
+#ifdef CEL_THREAD_SAFE
+	atomic_int ref_count;        /* 引用计数 (打开者与加载的程序) */
+#else
+	int ref_count;               /* 引用计数 (打开者与加载的程序) */
+#endif
+};
+
+/* ========== 缓冲区 ========== */
+
+/**
+ * @brief 可增长的字节缓冲区
+ */
+typedef struct {
+	unsigned char *data;
+	size_t length;
+	size_t capacity;
+} buffer_t;
+
+static bool buffer_append(buffer_t *buffer, const void *data, size_t length)
+{
+	if (buffer->length + length > buffer->capacity) {
+		size_t capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+		while (capacity < buffer->length + length) {
+			capacity *= 2;
+		}
+		unsigned char *grown = realloc(buffer->data, capacity);
+		if (!grown) {
+			return false;
+		}
+		buffer->data = grown;
+		buffer->capacity = capacity;
+	}
+	if (length) {
+		memcpy(buffer->data + buffer->length, data, length);
+	}
+	buffer->length += length;
+	return true;
+}
+
+static bool put_word(buffer_t *buffer, uint32_t word)
+{
+	return buffer_append(buffer, &word, sizeof(word));
+}
+
+static bool put_u64(buffer_t *buffer, uint64_t value)
+{
+	return buffer_append(buffer, &value, sizeof(value));
+}
+
+/**
+ * @brief 以 32 位字写入 size_t (超出范围时失败)
+ */
+static bool put_size(buffer_t *buffer, size_t value)
+{
+	return value <= UINT32_MAX && put_word(buffer, (uint32_t)value);
+}
+
+/* ========== 写入 ========== */
+
+/**
+ * @brief 已写入值表的引用计数值
+ */
+typedef struct {
+	const void *pointer;         /* 字符串、字节数组、列表或映射 */
+	uint32_t index;              /* 值表下标 */
+} shared_value_t;
+
+/**
+ * @brief 映像写入器
+ */
+typedef struct {
+	const cel_program_t *program;
+	buffer_t text;               /* 文本节 */
+	buffer_t values;             /* 值表字流 */
+	size_t value_count;          /* 值表中的值数量 */
+	buffer_t shared;             /* 已写入的引用计数值 (shared_value_t) */
+	buffer_t ast;                /* AST 字流 */
+	buffer_t constants;          /* 常量 (值表下标) */
+	buffer_t names;              /* 变量名偏移 */
+	buffer_t calls;              /* 调用点 */
+} writer_t;
+
+/**
+ * @brief 取得字符串在文本节中的偏移 (必要时追加)
+ *
+ * 源代码中的名称直接使用其偏移；其余字符串先在文本节中查找相同的
+ * 字节序列，找不到时追加。terminated 要求字符串之后是 '\0'。
+ */
+static bool intern(writer_t *w, const char *data, size_t length,
+		   bool terminated, uint32_t *offset)
+{
+	uintptr_t source = (uintptr_t)w->program->source;
+	uintptr_t address = (uintptr_t)data;
+	if (!terminated && address >= source &&
+	    address + length <= source + w->program->source_length) {
+		*offset = (uint32_t)(address - source);
+		return true;
+	}
+
+	size_t needle = length + (terminated ? 1 : 0);
+	const char *text = (const char *)w->text.data;
+	for (size_t i = 0; i + needle <= w->text.length; i++) {
+		if (memcmp(text + i, data, length) == 0 &&
+		    (!terminated || text[i + length] == '\0')) {
+			*offset = (uint32_t)i;
+			return true;
+		}
+	}
+
+	if (w->text.length + needle > UINT32_MAX) {
+		return false;
+	}
+	*offset = (uint32_t)w->text.length;
+	return buffer_append(&w->text, data, length) &&
+	       buffer_append(&w->text, "", 1);
+}
+
+/**
+ * @brief 写入名称 (偏移与长度)
+ */
+static bool put_name(writer_t *w, buffer_t *out, const char *name,
+		     size_t length)
+{
+	uint32_t offset = NULL_NAME;
+	if (name && !intern(w, name, length, false, &offset)) {
+		return false;
+	}
+	return put_word(out, offset) && put_size(out, name ? length : 0);
+}
+
+static bool put_value(writer_t *w, buffer_t *out, const cel_value_t *value,
+		      size_t depth)
+{
+	if (depth > MAX_VALUE_DEPTH || !put_word(out, (uint32_t)value->type)) {
+		return false;
+	}
+
+	switch (value->type) {
+	case CEL_TYPE_NULL:
+		return true;
+	case CEL_TYPE_BOOL:
+		return put_word(out, value->value.bool_value ? 1 : 0);
+	case CEL_TYPE_INT:
+		return put_u64(out, (uint64_t)value->value.int_value);
+	case CEL_TYPE_UINT:
+		return put_u64(out, value->value.uint_value);
+	case CEL_TYPE_DOUBLE:
+		return buffer_append(out, &value->value.double_value,
+				     sizeof(double));
+	case CEL_TYPE_STRING:
+		return put_name(w, out, value->value.string_value->data,
+				value->value.string_value->length);
+	case CEL_TYPE_BYTES:
+		return put_name(w, out,
+				(const char *)value->value.bytes_value->data,
+				value->value.bytes_value->length);
+	case CEL_TYPE_TIMESTAMP:
+		return put_u64(out, (uint64_t)value->value.timestamp_value.seconds) &&
+		       put_word(out, (uint32_t)value->value.timestamp_value.nanoseconds) &&
+		       put_word(out, (uint32_t)(int32_t)
+				value->value.timestamp_value.offset_minutes);
+	case CEL_TYPE_DURATION:
+		return put_u64(out, (uint64_t)value->value.duration_value.seconds) &&
+		       put_word(out, (uint32_t)value->value.duration_value.nanoseconds);
+
+	case CEL_TYPE_LIST: {
+		const cel_list_t *list = value->value.list_value;
+		bool ok = put_size(out, list->length);
+		for (size_t i = 0; ok && i < list->length; i++) {
+			ok = put_value(w, out, list->items[i], depth + 1);
+		}
+		return ok;
+	}
+
+	case CEL_TYPE_MAP: {
+		/* 加载时以相同的桶数量按写入顺序插入，新条目位于链表头部，
+		 * 因此每个桶的链表逆序写入以保持迭代顺序 */
+		const cel_map_t *map = value->value.map_value;
+		const cel_map_entry_t **chain =
+			malloc((map->size + 1) * sizeof(cel_map_entry_t *));
+		bool ok = chain && put_size(out, map->bucket_count) &&
+			  put_size(out, map->size);
+		for (size_t i = 0; ok && i < map->bucket_count; i++) {
+			size_t length = 0;
+			for (const cel_map_entry_t *entry = map->buckets[i]; entry;
+			     entry = entry->next) {
+				chain[length++] = entry;
+			}
+			while (ok && length > 0) {
+				const cel_map_entry_t *entry = chain[--length];
+				ok = put_value(w, out, entry->key, depth + 1) &&
+				     put_value(w, out, entry->value, depth + 1);
+			}
+		}
+		free(chain);
+		return ok;
+	}
+
+	default:
+		/* type 与 error 值不会出现在编译后的程序中 */
+		return false;
+	}
+}
+
+/**
+ * @brief 写入值表下标 (同一引用计数值只写入值表一次)
+ */
+static bool put_value_index(writer_t *w, buffer_t *out,
+			    const cel_value_t *value)
+{
+	const void *pointer = NULL;
+	switch (value->type) {
+	case CEL_TYPE_STRING:
+	case CEL_TYPE_BYTES:
+	case CEL_TYPE_LIST:
+	case CEL_TYPE_MAP:
+		pointer = value->value.ptr_value;
+		break;
+	default:
+		break;
+	}
+
+	const shared_value_t *shared = (const shared_value_t *)w->shared.data;
+	size_t shared_count = w->shared.length / sizeof(shared_value_t);
+	for (size_t i = 0; pointer && i < shared_count; i++) {
+		if (shared[i].pointer == pointer) {
+			return put_word(out, shared[i].index);
+		}
+	}
+
+	shared_value_t entry = {pointer, (uint32_t)w->value_count};
+	if (w->value_count >= UINT32_MAX ||
+	    !put_value(w, &w->values, value, 0) ||
+	    (pointer && !buffer_append(&w->shared, &entry, sizeof(entry)))) {
+		return false;
+	}
+	w->value_count++;
+	return put_word(out, entry.index);
+}
+
+static bool put_node(writer_t *w, const cel_ast_node_t *node);
+
+static bool put_nodes(writer_t *w, cel_ast_node_t *const *nodes, size_t count)
+{
+	bool ok = put_size(&w->ast, count);
+	for (size_t i = 0; ok && i < count; i++) {
+		ok = put_node(w, nodes[i]);
+	}
+	return ok;
+}
+
+static bool put_node(writer_t *w, const cel_ast_node_t *node)
+{
+	buffer_t *out = &w->ast;
+	uint32_t op = 0;
+	uint32_t flags = 0;
+	switch (node->type) {
+	case CEL_AST_UNARY:
+		op = (uint32_t)node->as.unary.op;
+		break;
+	case CEL_AST_BINARY:
+		op = (uint32_t)node->as.binary.op;
+		break;
+	case CEL_AST_SELECT:
+		flags = node->as.select.optional ? NODE_OPTIONAL : 0;
+		break;
+	case CEL_AST_INDEX:
+		flags = node->as.index.optional ? NODE_OPTIONAL : 0;
+		break;
+	case CEL_AST_CALL:
+		flags = node->as.call.target ? NODE_HAS_TARGET : 0;
+		break;
+	default:
+		break;
+	}
+
+	if (!put_word(out, (uint32_t)node->type | op << 8 | flags << 16) ||
+	    !put_size(out, node->loc.line) || !put_size(out, node->loc.column) ||
+	    !put_size(out, node->loc.offset) || !put_size(out, node->loc.length)) {
+		return false;
+	}
+
+	switch (node->type) {
+	case CEL_AST_LITERAL:
+		return put_value_index(w, out, &node->as.literal.value);
+
+	case CEL_AST_IDENT:
+		return put_name(w, out, node->as.ident.name, node->as.ident.length);
+
+	case CEL_AST_UNARY:
+		return put_node(w, node->as.unary.operand);
+
+	case CEL_AST_BINARY:
+		return put_node(w, node->as.binary.left) &&
+		       put_node(w, node->as.binary.right);
+
+	case CEL_AST_TERNARY:
+		return put_node(w, node->as.ternary.condition) &&
+		       put_node(w, node->as.ternary.if_true) &&
+		       put_node(w, node->as.ternary.if_false);
+
+	case CEL_AST_SELECT:
+		return put_name(w, out, node->as.select.field,
+				node->as.select.field_length) &&
+		       put_node(w, node->as.select.operand);
+
+	case CEL_AST_INDEX:
+		return put_node(w, node->as.index.operand) &&
+		       put_node(w, node->as.index.index);
+
+	case CEL_AST_CALL:
+		return put_name(w, out, node->as.call.function,
+				node->as.call.function_length) &&
+		       (!node->as.call.target ||
+			put_node(w, node->as.call.target)) &&
+		       put_nodes(w, node->as.call.args, node->as.call.arg_count);
+
+	case CEL_AST_LIST:
+		return put_nodes(w, node->as.list.elements,
+				 node->as.list.element_count);
+
+	case CEL_AST_MAP: {
+		bool ok = put_size(out, node->as.map.entry_count);
+		for (size_t i = 0; ok && i < node->as.map.entry_count; i++) {
+			ok = put_node(w, node->as.map.entries[i].key) &&
+			     put_node(w, node->as.map.entries[i].value);
+		}
+		return ok;
+	}
+
+	case CEL_AST_STRUCT: {
+		const cel_ast_struct_t *lit = &node->as.struct_lit;
+		bool ok = put_name(w, out, lit->type_name, lit->type_name_length) &&
+			  put_size(out, lit->field_count);
+		for (size_t i = 0; ok && i < lit->field_count; i++) {
+			ok = put_name(w, out, lit->fields[i].name,
+				      lit->fields[i].name_length) &&
+			     put_node(w, lit->fields[i].value);
+		}
+		return ok;
+	}
+
+	case CEL_AST_COMPREHENSION: {
+		const cel_ast_comprehension_t *comp = &node->as.comprehension;
+		return put_name(w, out, comp->iter_var, comp->iter_var_length) &&
+		       put_name(w, out, comp->iter_var2, comp->iter_var2_length) &&
+		       put_name(w, out, comp->accu_var, comp->accu_var_length) &&
+		       put_node(w, comp->iter_range) &&
+		       put_node(w, comp->accu_init) &&
+		       put_node(w, comp->loop_cond) &&
+		       put_node(w, comp->loop_step) &&
+		       put_node(w, comp->result);
+	}
+	}
+	return false;
+}
+
+/**
+ * @brief 写入字节码的各表 (指令与源码位置在组装映像时原样复制)
+ */
+static bool put_bytecode(writer_t *w, const cel_bytecode_t *bc)
+{
+	bool ok = true;
+	for (size_t i = 0; ok && i < bc->constant_count; i++) {
+		ok = put_value_index(w, &w->constants, &bc->constants[i]);
+	}
+
+	for (size_t i = 0; ok && i < bc->name_count; i++) {
+		uint32_t offset;
+		ok = intern(w, bc->names[i], strlen(bc->names[i]), true, &offset) &&
+		     put_word(&w->names, offset);
+	}
+
+	for (size_t i = 0; ok && i < bc->call_count; i++) {
+		uint32_t offset;
+		ok = intern(w, bc->calls[i].name, bc->calls[i].name_length, true,
+			    &offset) &&
+		     put_word(&w->calls, offset) &&
+		     put_size(&w->calls, bc->calls[i].name_length) &&
+		     put_word(&w->calls, bc->calls[i].has_target ? 1 : 0);
+	}
+	return ok;
+}
+
+/**
+ * @brief 按 8 字节对齐追加一个节
+ */
+static bool put_section(buffer_t *image, section_t *section, const void *data,
+			size_t length)
+{
+	static const unsigned char padding[8] = {0};
+	size_t pad = (8 - image->length % 8) % 8;
+	if (!buffer_append(image, padding, pad)) {
+		return false;
+	}
+	section->offset = image->length;
+	section->length = length;
+	return buffer_append(image, data, length);
+}
+
+/**
+ * @brief 构建程序映像
+ *
+ * @return 成功返回 true，image 为映像 (调用者释放 image->data)
+ */
+static bool build_image(const cel_program_t *program, buffer_t *image)
+{
+	memset(image, 0, sizeof(*image));
+	if (!program || !program->ast || !program->source) {
+		return false;
+	}
+
+	writer_t w = {.program = program};
+	const cel_bytecode_t *bc = program->bytecode;
+
+	/* 文本节以源代码开头 (已加载的程序包括其名称表) */
+	bool ok = program->source_length < UINT32_MAX &&
+		  buffer_append(&w.text, program->source,
+				program->source_length) &&
+		  buffer_append(&w.text, "", 1) &&
+		  put_node(&w, program->ast) &&
+		  (!bc || put_bytecode(&w, bc));
+
+	image_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, IMAGE_MAGIC, 4);
+	header.version = CEL_PROGRAM_FORMAT_VERSION;
+	header.flags = (bc ? IMAGE_HAS_BYTECODE : 0) |
+		       (program->schema ? IMAGE_HAS_SCHEMA : 0);
+	header.byte_order = BYTE_ORDER_MARK;
+	header.instr_size = sizeof(cel_instr_t);
+	header.eval_depth = program->eval_depth;
+
+	header.value_count = w.value_count;
+
+	ok = ok && buffer_append(image, &header, sizeof(header)) &&
+	     put_section(image, &header.text, w.text.data, w.text.length) &&
+	     put_section(image, &header.values, w.values.data,
+			 w.values.length) &&
+	     put_section(image, &header.ast, w.ast.data, w.ast.length);
+	if (ok && bc) {
+		header.register_count = bc->register_count;
+		ok = put_section(image, &header.code, bc->code,
+				 bc->code_length * sizeof(cel_instr_t)) &&
+		     put_section(image, &header.locs, bc->locs,
+				 bc->code_length * sizeof(cel_instr_loc_t)) &&
+		     put_section(image, &header.constants, w.constants.data,
+				 w.constants.length) &&
+		     put_section(image, &header.names, w.names.data,
+				 w.names.length) &&
+		     put_section(image, &header.calls, w.calls.data,
+				 w.calls.length) &&
+		     put_section(image, &header.patterns, bc->patterns,
+				 bc->regex_count * sizeof(uint32_t));
+	}
+
+	free(w.text.data);
+	free(w.values.data);
+	free(w.shared.data);
+	free(w.ast.data);
+	free(w.constants.data);
+	free(w.names.data);
+	free(w.calls.data);
+
+	if (!ok) {
+		free(image->data);
+		memset(image, 0, sizeof(*image));
+		return false;
+	}
+	header.size = image->length;
+	memcpy(image->data, &header, sizeof(header));
+	return true;
+}
+
+/* ========== 读取 ========== */
+
+/**
+ * @brief 字流读取器 (越界时置 failed 并返回 0)
+ */
+typedef struct {
+	const uint32_t *words;
+	size_t count;
+	size_t pos;
+	const char *text;            /* 文本节 */
+	size_t text_length;          /* 文本节长度 */
+	bool failed;
+} reader_t;
+
+static uint32_t get_word(reader_t *r)
+{
+	if (r->pos >= r->count) {
+		r->failed = true;
+		return 0;
+	}
+	return r->words[r->pos++];
+}
+
+static uint64_t get_u64(reader_t *r)
+{
+	uint32_t words[2] = {get_word(r), get_word(r)};
+	uint64_t value;
+	memcpy(&value, words, sizeof(value));
+	return value;
+}
+
+/**
+ * @brief 读取名称 (指向文本节)
+ */
+static const char *get_name(reader_t *r, size_t *length)
+{
+	uint32_t offset = get_word(r);
+	*length = get_word(r);
+	if (offset == NULL_NAME) {
+		*length = 0;
+		return NULL;
+	}
+	if (r->failed || offset > r->text_length ||
+	    *length > r->text_length - offset) {
+		r->failed = true;
+		*length = 0;
+		return NULL;
+	}
+	return r->text + offset;
+}
+
+static bool get_value(reader_t *r, cel_value_t *value, size_t depth)
+{
+	*value = cel_value_null();
+	uint32_t type = get_word(r);
+	if (r->failed || depth > MAX_VALUE_DEPTH) {
+		return false;
+	}
+
+	switch ((cel_type_e)type) {
+	case CEL_TYPE_NULL:
+		return true;
+	case CEL_TYPE_BOOL:
+		*value = cel_value_bool(get_word(r) != 0);
+		return !r->failed;
+	case CEL_TYPE_INT:
+		*value = cel_value_int((int64_t)get_u64(r));
+		return !r->failed;
+	case CEL_TYPE_UINT:
+		*value = cel_value_uint(get_u64(r));
+		return !r->failed;
+	case CEL_TYPE_DOUBLE: {
+		uint64_t bits = get_u64(r);
+		double number;
+		memcpy(&number, &bits, sizeof(number));
+		*value = cel_value_double(number);
+		return !r->failed;
+	}
+	case CEL_TYPE_STRING:
+	case CEL_TYPE_BYTES: {
+		size_t length;
+		const char *data = get_name(r, &length);
+		if (!data) {
+			return false;
+		}
+		*value = type == CEL_TYPE_STRING ?
+			cel_value_string_n(data, length) :
+			cel_value_bytes((const unsigned char *)data, length);
+		return value->type == (cel_type_e)type;
+	}
+	case CEL_TYPE_TIMESTAMP: {
+		int64_t seconds = (int64_t)get_u64(r);
+		int32_t nanoseconds = (int32_t)get_word(r);
+		int16_t offset = (int16_t)(int32_t)get_word(r);
+		*value = cel_value_timestamp(seconds, nanoseconds, offset);
+		return !r->failed;
+	}
+	case CEL_TYPE_DURATION: {
+		int64_t seconds = (int64_t)get_u64(r);
+		*value = cel_value_duration(seconds, (int32_t)get_word(r));
+		return !r->failed;
+	}
+
+	case CEL_TYPE_LIST: {
+		size_t length = get_word(r);
+		cel_list_t *list = r->failed || length > r->count ? NULL :
+				   cel_list_create(length);
+		if (!list) {
+			return false;
+		}
+		*value = cel_value_list(list);
+		for (size_t i = 0; i < length; i++) {
+			cel_value_t item;
+			bool ok = get_value(r, &item, depth + 1) &&
+				  cel_list_append(list, &item);
+			cel_value_destroy(&item);
+			if (!ok) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	case CEL_TYPE_MAP: {
+		size_t bucket_count = get_word(r);
+		size_t size = get_word(r);
+		cel_map_t *map = r->failed ? NULL : cel_map_create(bucket_count);
+		if (!map) {
+			return false;
+		}
+		*value = cel_value_map(map);
+		for (size_t i = 0; i < size; i++) {
+			cel_value_t key, item = cel_value_null();
+			bool ok = get_value(r, &key, depth + 1) &&
+				  get_value(r, &item, depth + 1) &&
+				  cel_map_put(map, &key, &item);
+			cel_value_destroy(&key);
+			cel_value_destroy(&item);
+			if (!ok) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	default:
+		r->failed = true;
+		return false;
+	}
+}
+
+/**
+ * @brief 解码器 (AST 节点的源码位置指向程序的文本)
+ */
+typedef struct {
+	reader_t reader;
+	const char *source;
+	size_t max_depth;            /* 最大节点深度 (映像记录的 AST 深度) */
+	const cel_value_t *values;   /* 值表 */
+	size_t value_count;          /* 值表大小 */
+} decoder_t;
+
+static cel_ast_node_t *get_node(decoder_t *d, size_t depth);
+
+/**
+ * @brief 读取子节点列表
+ */
+static bool get_nodes(decoder_t *d, cel_ast_node_t ***nodes, size_t *count,
+		      size_t depth)
+{
+	size_t length = get_word(&d->reader);
+	if (d->reader.failed || length > d->reader.count) {
+		d->reader.failed = true;
+		return false;
+	}
+	if (length == 0) {
+		return true;
+	}
+
+	*nodes = cel_ast_alloc(length * sizeof(cel_ast_node_t *));
+	if (!*nodes) {
+		return false;
+	}
+	*count = length;
+	for (size_t i = 0; i < length; i++) {
+		(*nodes)[i] = get_node(d, depth + 1);
+		if (!(*nodes)[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static cel_ast_node_t *get_node(decoder_t *d, size_t depth)
+{
+	reader_t *r = &d->reader;
+	uint32_t head = get_word(r);
+	cel_ast_node_type_e type = (cel_ast_node_type_e)(head & 0xff);
+	uint32_t op = (head >> 8) & 0xff;
+	uint32_t flags = head >> 16;
+	if (r->failed || depth > d->max_depth || type > CEL_AST_COMPREHENSION) {
+		r->failed = true;
+		return NULL;
+	}
+
+	/* 零初始化的节点可以在任何时候交给 cel_ast_destroy() */
+	cel_token_location_t loc = {.source = d->source};
+	loc.line = get_word(r);
+	loc.column = get_word(r);
+	loc.offset = get_word(r);
+	loc.length = get_word(r);
+	cel_ast_node_t *node = cel_ast_create_node(type, loc);
+	if (!node) {
+		return NULL;
+	}
+
+	bool ok = !r->failed;
+	switch (type) {
+	case CEL_AST_LITERAL: {
+		uint32_t index = get_word(r);
+		ok = ok && !r->failed && index < d->value_count;
+		if (ok) {
+			node->as.literal.value = cel_value_retain(&d->values[index]);
+		}
+		break;
+	}
+
+	case CEL_AST_IDENT:
+		node->as.ident.name = get_name(r, &node->as.ident.length);
+		break;
+
+	case CEL_AST_UNARY:
+		node->as.unary.op = (cel_unary_op_e)op;
+		ok = ok && (node->as.unary.operand = get_node(d, depth + 1));
+		break;
+
+	case CEL_AST_BINARY:
+		node->as.binary.op = (cel_binary_op_e)op;
+		ok = ok && (node->as.binary.left = get_node(d, depth + 1)) &&
+		     (node->as.binary.right = get_node(d, depth + 1));
+		break;
+
+	case CEL_AST_TERNARY:
+		ok = ok && (node->as.ternary.condition = get_node(d, depth + 1)) &&
+		     (node->as.ternary.if_true = get_node(d, depth + 1)) &&
+		     (node->as.ternary.if_false = get_node(d, depth + 1));
+		break;
+
+	case CEL_AST_SELECT:
+		node->as.select.optional = flags & NODE_OPTIONAL;
+		node->as.select.field = get_name(r, &node->as.select.field_length);
+		ok = ok && (node->as.select.operand = get_node(d, depth + 1));
+		break;
+
+	case CEL_AST_INDEX:
+		node->as.index.optional = flags & NODE_OPTIONAL;
+		ok = ok && (node->as.index.operand = get_node(d, depth + 1)) &&
+		     (node->as.index.index = get_node(d, depth + 1));
+		break;
+
+	case CEL_AST_CALL:
+		node->as.call.function = get_name(r,
+						  &node->as.call.function_length);
+		if (flags & NODE_HAS_TARGET) {
+			ok = ok && (node->as.call.target = get_node(d, depth + 1));
+		}
+		ok = ok && get_nodes(d, &node->as.call.args,
+				     &node->as.call.arg_count, depth);
+		break;
+
+	case CEL_AST_LIST:
+		ok = ok && get_nodes(d, &node->as.list.elements,
+				     &node->as.list.element_count, depth);
+		break;
+
+	case CEL_AST_MAP: {
+		size_t count = get_word(r);
+		ok = ok && !r->failed && count <= r->count;
+		if (ok && count) {
+			node->as.map.entries = cel_ast_alloc(
+				count * sizeof(cel_ast_map_entry_t));
+			ok = node->as.map.entries != NULL;
+			node->as.map.entry_count = ok ? count : 0;
+		}
+		for (size_t i = 0; ok && i < count; i++) {
+			cel_ast_map_entry_t *entry = &node->as.map.entries[i];
+			ok = (entry->key = get_node(d, depth + 1)) &&
+			     (entry->value = get_node(d, depth + 1));
+		}
+		break;
+	}
+
+	case CEL_AST_STRUCT: {
+		cel_ast_struct_t *lit = &node->as.struct_lit;
+		lit->type_name = get_name(r, &lit->type_name_length);
+		size_t count = get_word(r);
+		ok = ok && !r->failed && count <= r->count;
+		if (ok && count) {
+			lit->fields = cel_ast_alloc(
+				count * sizeof(cel_ast_struct_field_t));
+			ok = lit->fields != NULL;
+			lit->field_count = ok ? count : 0;
+		}
+		for (size_t i = 0; ok && i < count; i++) {
+			cel_ast_struct_field_t *field = &lit->fields[i];
+			field->name = get_name(r, &field->name_length);
+			ok = (field->value = get_node(d, depth + 1)) != NULL;
+		}
+		break;
+	}
+
+	case CEL_AST_COMPREHENSION: {
+		cel_ast_comprehension_t *comp = &node->as.comprehension;
+		comp->iter_var = get_name(r, &comp->iter_var_length);
+		comp->iter_var2 = get_name(r, &comp->iter_var2_length);
+		comp->accu_var = get_name(r, &comp->accu_var_length);
+		ok = ok && (comp->iter_range = get_node(d, depth + 1)) &&
+		     (comp->accu_init = get_node(d, depth + 1)) &&
+		     (comp->loop_cond = get_node(d, depth + 1)) &&
+		     (comp->loop_step = get_node(d, depth + 1)) &&
+		     (comp->result = get_node(d, depth + 1));
+		break;
+	}
+	}
+
+	if (!ok || r->failed) {
+		r->failed = true;
+		cel_ast_destroy(node);
+		return NULL;
+	}
+	return node;
+}
+
+/**
+ * @brief 检查节位于映像内、按 8 字节对齐且由整数个元素组成
+ */
+static bool section_valid(const section_t *section, uint64_t size,
+			  size_t element_size)
+{
+	return section->offset <= size &&
+	       section->length <= size - section->offset &&
+	       section->offset % 8 == 0 &&
+	       section->length % element_size == 0;
+}
+
+/**
+ * @brief 字节码中的槽位访问与 schema 一致
+ */
+static bool schema_matches(const cel_bytecode_t *bc, const cel_schema_t *schema)
+{
+	for (size_t i = 0; i < bc->code_length; i++) {
+		const cel_instr_t *ins = &bc->code[i];
+		if (ins->op != CEL_OP_LOAD_SLOT) {
+			continue;
+		}
+		size_t slot;
+		if (ins->a >= bc->name_count ||
+		    !cel_schema_find(schema, bc->names[ins->a],
+				     strlen(bc->names[ins->a]), &slot) ||
+		    slot != ins->imm) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief 加载字节码 (指令、源码位置与名称借用映像)
+ */
+static cel_bytecode_t *load_bytecode(const unsigned char *image,
+				     const image_header_t *header,
+				     const char *text, size_t text_length,
+				     const cel_value_t *values, size_t value_count,
+				     const cel_schema_t *schema)
+{
+	cel_bytecode_t *bc = calloc(1, sizeof(cel_bytecode_t));
+	if (!bc) {
+		return NULL;
+	}
+	bc->borrowed = true;
+	bc->schema = schema;
+	bc->register_count = header->register_count;
+	bc->code = (cel_instr_t *)(image + header->code.offset);
+	bc->code_length = header->code.length / sizeof(cel_instr_t);
+	bc->locs = (cel_instr_loc_t *)(image + header->locs.offset);
+
+	size_t name_count = header->names.length / sizeof(uint32_t);
+	size_t call_count = header->calls.length / (3 * sizeof(uint32_t));
+	size_t regex_count = header->patterns.length / sizeof(uint32_t);
+	size_t constant_count = header->constants.length / sizeof(uint32_t);
+	bool ok = header->locs.length ==
+			  bc->code_length * sizeof(cel_instr_loc_t) &&
+		  header->calls.length % (3 * sizeof(uint32_t)) == 0;
+	if (ok) {
+		bc->names = calloc(name_count + 1, sizeof(char *));
+		bc->calls = calloc(call_count + 1, sizeof(cel_call_site_t));
+		bc->constants = calloc(constant_count + 1, sizeof(cel_value_t));
+		bc->regexes = calloc(regex_count + 1, sizeof(cel_regex_t *));
+		bc->patterns = calloc(regex_count + 1, sizeof(uint32_t));
+		ok = bc->names && bc->calls && bc->constants && bc->regexes &&
+		     bc->patterns;
+	}
+
+	const uint32_t *names = (const uint32_t *)(image + header->names.offset);
+	for (size_t i = 0; ok && i < name_count; i++) {
+		ok = names[i] < text_length;
+		bc->names[i] = (char *)text + names[i];
+		bc->name_count = i + 1;
+	}
+
+	const uint32_t *calls = (const uint32_t *)(image + header->calls.offset);
+	for (size_t i = 0; ok && i < call_count; i++) {
+		const uint32_t *site = &calls[3 * i];
+		ok = site[0] < text_length && site[1] < text_length - site[0];
+		bc->calls[i].name = (char *)text + site[0];
+		bc->calls[i].name_length = site[1];
+		bc->calls[i].has_target = site[2] != 0;
+		bc->call_count = i + 1;
+	}
+
+	/* 常量是值表的下标 */
+	const uint32_t *constants =
+		(const uint32_t *)(image + header->constants.offset);
+	for (size_t i = 0; ok && i < constant_count; i++) {
+		ok = constants[i] < value_count;
+		if (ok) {
+			bc->constants[i] = cel_value_retain(&values[constants[i]]);
+			bc->constant_count = i + 1;
+		}
+	}
+
+	/* 正则表达式按模式重新编译 (相同的模式共享缓存中的编译结果) */
+	const uint32_t *patterns =
+		(const uint32_t *)(image + header->patterns.offset);
+	for (size_t i = 0; ok && i < regex_count; i++) {
+		const cel_value_t *pattern = patterns[i] < bc->constant_count ?
+			&bc->constants[patterns[i]] : NULL;
+		ok = pattern && pattern->type == CEL_TYPE_STRING;
+		if (ok) {
+			bc->regexes[i] = cel_regex_cache_get(
+				pattern->value.string_value->data,
+				pattern->value.string_value->length, NULL, 0);
+			ok = bc->regexes[i] != NULL;
+		}
+		bc->patterns[i] = patterns[i];
+		bc->regex_count = ok ? i + 1 : i;
+	}
+
+	if (!ok || (schema && !schema_matches(bc, schema))) {
+		cel_bytecode_destroy(bc);
+		return NULL;
+	}
+	return bc;
+}
+
+/**
+ * @brief 解码程序映像 (程序持有程序包的引用)
+ */
+static cel_program_t *decode_image(cel_bundle_t *bundle,
+				 const unsigned char *image, size_t size,
+				 const cel_schema_t *schema)
+{
+	image_header_t header;
+	if (size < sizeof(header)) {
+		return NULL;
+	}
+	memcpy(&header, image, sizeof(header));
+
+	bool has_bytecode = header.flags & IMAGE_HAS_BYTECODE;
+	bool has_schema = header.flags & IMAGE_HAS_SCHEMA;
+	if (memcmp(header.magic, IMAGE_MAGIC, 4) != 0 ||
+	    header.version != CEL_PROGRAM_FORMAT_VERSION ||
+	    header.byte_order != BYTE_ORDER_MARK ||
+	    header.instr_size != sizeof(cel_instr_t) || header.size > size ||
+	    has_schema != (schema != NULL) ||
+	    !section_valid(&header.text, header.size, 1) ||
+	    !section_valid(&header.values, header.size, sizeof(uint32_t)) ||
+	    !section_valid(&header.ast, header.size, sizeof(uint32_t)) ||
+	    !section_valid(&header.code, header.size, sizeof(cel_instr_t)) ||
+	    !section_valid(&header.locs, header.size, sizeof(cel_instr_loc_t)) ||
+	    !section_valid(&header.constants, header.size, sizeof(uint32_t)) ||
+	    !section_valid(&header.names, header.size, sizeof(uint32_t)) ||
+	    !section_valid(&header.calls, header.size, sizeof(uint32_t)) ||
+	    !section_valid(&header.patterns, header.size, sizeof(uint32_t))) {
+		return NULL;
+	}
+
+	/* 文本节以 '\0' 结尾，偏移在其范围内的名称都是 null 结尾的 */
+	const char *text = (const char *)image + header.text.offset;
+	size_t text_length = header.text.length;
+	if (text_length == 0 || text[text_length - 1] != '\0') {
+		return NULL;
+	}
+
+	cel_program_t *program = calloc(1, sizeof(cel_program_t));
+	if (!program) {
+		return NULL;
+	}
+#ifdef CEL_THREAD_SAFE
+	atomic_init(&program->ref_count, 1);
+#else
+	program->ref_count = 1;
+#endif
+	program->source = (char *)text;
+	program->source_length = text_length - 1;
+	program->bundle = cel_bundle_retain(bundle);
+	program->schema = schema;
+	program->eval_depth = header.eval_depth;
+
+	/* 字面量与常量共享的值只解码一次 */
+	size_t value_count = header.values.length / sizeof(uint32_t) >=
+					     header.value_count ?
+				     (size_t)header.value_count : 0;
+	cel_value_t *values = calloc(value_count + 1, sizeof(cel_value_t));
+	reader_t r = {
+		.words = (const uint32_t *)(image + header.values.offset),
+		.count = header.values.length / sizeof(uint32_t),
+		.text = text,
+		.text_length = text_length,
+	};
+	bool ok = values && value_count == header.value_count;
+	for (size_t i = 0; ok && i < value_count; i++) {
+		ok = get_value(&r, &values[i], 0);
+	}
+
+	decoder_t d = {
+		.reader = {
+			.words = (const uint32_t *)(image + header.ast.offset),
+			.count = header.ast.length / sizeof(uint32_t),
+			.text = text,
+			.text_length = text_length,
+		},
+		.source = text,
+		.max_depth = header.eval_depth,
+		.values = values,
+		.value_count = value_count,
+	};
+	/* AST 节点解码到程序的分配区 */
+	program->ast_arena = ok ? cel_ast_arena_create(
+		header.ast.length / sizeof(uint32_t) * AST_BYTES_PER_WORD) :
+		NULL;
+	if (program->ast_arena) {
+		cel_ast_arena_t *previous = cel_ast_arena_enter(program->ast_arena);
+		program->ast = get_node(&d, 1);
+		cel_ast_arena_leave(previous);
+	}
+	if (program->ast && has_bytecode) {
+		program->bytecode = load_bytecode(image, &header, text,
+						  text_length, values,
+						  value_count, schema);
+	}
+
+	for (size_t i = 0; values && i < value_count; i++) {
+		cel_value_destroy(&values[i]);
+	}
+	free(values);
+
+	if (!program->ast || (has_bytecode && !program->bytecode)) {
+		cel_program_destroy(program);
+		return NULL;
+	}
+	return program;
+}
+
+/**
+ * @brief 加载程序映像
+ *
+ * 重建的字面量与正则表达式由程序持有，在卸下调用线程的临时分配区后解码。
+ */
+static cel_program_t *load_image(cel_bundle_t *bundle,
+				 const unsigned char *image, size_t size,
+				 const cel_schema_t *schema)
+{
+	arena_t *previous_scratch = arena_scratch_enter(NULL);
+	cel_program_t *program = decode_image(bundle, image, size, schema);
+	arena_scratch_leave(previous_scratch);
+	return program;
+}
+
+/* ========== 程序序列化 API ========== */
+
+size_t cel_program_serialize(const cel_program_t *program, void *buffer,
+			     size_t size)
+{
+	buffer_t image;
+	if (!build_image(program, &image)) {
+		return 0;
+	}
+	if (buffer && size >= image.length) {
+		memcpy(buffer, image.data, image.length);
+	}
+	free(image.data);
+	return image.length;
+}
+
+/**
+ * @brief 创建程序包对象 (引用计数 = 1)
+ */
+static cel_bundle_t *bundle_create(unsigned char *data, size_t size,
+				   bool mapped)
+{
+	cel_bundle_t *bundle = calloc(1, sizeof(cel_bundle_t));
+	if (!bundle) {
+		return NULL;
+	}
+	bundle->data = data;
+	bundle->size = size;
+	bundle->mapped = mapped;
+#ifdef CEL_THREAD_SAFE
+	atomic_init(&bundle->ref_count, 1);
+#else
+	bundle->ref_count = 1;
+#endif
+	return bundle;
+}
+
+cel_program_t *cel_program_deserialize(const void *data, size_t size,
+				       const cel_schema_t *schema)
+{
+	if (!data || size == 0) {
+		return NULL;
+	}
+
+	/* 复制到按 malloc 对齐的私有程序包中 */
+	unsigned char *copy = malloc(size);
+	if (!copy) {
+		return NULL;
+	}
+	memcpy(copy, data, size);
+	cel_bundle_t *bundle = bundle_create(copy, size, false);
+	if (!bundle) {
+		free(copy);
+		return NULL;
+	}
+
+	cel_program_t *program = load_image(bundle, copy, size, schema);
+	cel_bundle_close(bundle);
+	return program;
+}
+
+/* ========== 程序包 API ========== */
+
+/**
+ * @brief 写入零字节使文件偏移按 8 字节对齐
+ */
+static bool write_padding(FILE *file, uint64_t *offset)
+{
+	static const unsigned char padding[8] = {0};
+	size_t pad = (size_t)((8 - *offset % 8) % 8);
+	*offset += pad;
+	return fwrite(padding, 1, pad, file) == pad;
+}
+
+cel_error_code_e cel_bundle_write(const char *path,
+				  cel_program_t *const *programs,
+				  size_t count)
+{
+	if (!path || (!programs && count > 0)) {
+		return CEL_ERROR_INVALID_ARGUMENT;
+	}
+
+	buffer_t *images = calloc(count + 1, sizeof(buffer_t));
+	uint64_t *offsets = calloc(count + 1, sizeof(uint64_t));
+	size_t tmp_size = strlen(path) + sizeof(".tmp");
+	char *tmp = malloc(tmp_size);
+	cel_error_code_e code = images && offsets && tmp ? CEL_OK :
+							   CEL_ERROR_OUT_OF_MEMORY;
+
+	/* 先构建所有映像以确定偏移 */
+	bundle_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BUNDLE_MAGIC, 4);
+	header.version = CEL_PROGRAM_FORMAT_VERSION;
+	header.byte_order = BYTE_ORDER_MARK;
+	header.count = count;
+	uint64_t offset = sizeof(header) + (count + 1) * sizeof(uint64_t);
+	for (size_t i = 0; code == CEL_OK && i < count; i++) {
+		if (!build_image(programs[i], &images[i])) {
+			code = CEL_ERROR_UNSUPPORTED;
+			break;
+		}
+		offset += (8 - offset % 8) % 8;
+		offsets[i] = offset;
+		offset += images[i].length;
+	}
+	if (code == CEL_OK) {
+		offsets[count] = offset;
+	}
+
+	FILE *file = NULL;
+	if (code == CEL_OK) {
+		snprintf(tmp, tmp_size, "%s.tmp", path);
+		file = fopen(tmp, "wb");
+		code = file ? CEL_OK : CEL_ERROR_INVALID_ARGUMENT;
+	}
+	if (file) {
+		uint64_t written = sizeof(header) + (count + 1) * sizeof(uint64_t);
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			  fwrite(offsets, sizeof(uint64_t), count + 1, file) ==
+				  count + 1;
+		for (size_t i = 0; ok && i < count; i++) {
+			ok = write_padding(file, &written) &&
+			     fwrite(images[i].data, 1, images[i].length, file) ==
+				     images[i].length;
+			written += images[i].length;
+		}
+		ok = fclose(file) == 0 && ok && rename(tmp, path) == 0;
+		if (!ok) {
+			remove(tmp);
+			code = CEL_ERROR_INVALID_ARGUMENT;
+		}
+	}
+
+	for (size_t i = 0; images && i < count; i++) {
+		free(images[i].data);
+	}
+	free(images);
+	free(offsets);
+	free(tmp);
+	return code;
+}
+
+cel_bundle_t *cel_bundle_open(const char *path)
+{
+	if (!path) {
+		return NULL;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(bundle_header_t)) {
+		close(fd);
+		return NULL;
+	}
+	size_t size = (size_t)st.st_size;
+	void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+
+	/* 检查头部与偏移表 */
+	bundle_header_t header;
+	memcpy(&header, data, sizeof(header));
+	const uint64_t *offsets =
+		(const uint64_t *)((unsigned char *)data + sizeof(header));
+	bool ok = memcmp(header.magic, BUNDLE_MAGIC, 4) == 0 &&
+		  header.version == CEL_PROGRAM_FORMAT_VERSION &&
+		  header.byte_order == BYTE_ORDER_MARK &&
+		  header.count < (size - sizeof(header)) / sizeof(uint64_t);
+	for (size_t i = 0; ok && i <= header.count; i++) {
+		ok = (i == header.count || offsets[i] % 8 == 0) &&
+		     offsets[i] <= size && (i == 0 || offsets[i] >= offsets[i - 1]);
+	}
+
+	cel_bundle_t *bundle = ok ? bundle_create(data, size, true) : NULL;
+	if (!bundle) {
+		munmap(data, size);
+		return NULL;
+	}
+	bundle->offsets = offsets;
+	bundle->count = (size_t)header.count;
+	return bundle;
+}
+
+cel_bundle_t *cel_bundle_retain(cel_bundle_t *bundle)
+{
+	if (!bundle) {
+		return NULL;
+	}
+
+#ifdef CEL_THREAD_SAFE
+	atomic_fetch_add(&bundle->ref_count, 1);
+#else
+	bundle->ref_count++;
+#endif
+
+	return bundle;
+}
+
+void cel_bundle_close(cel_bundle_t *bundle)
+{
+	if (!bundle) {
+		return;
+	}
+
+#ifdef CEL_THREAD_SAFE
+	if (atomic_fetch_sub(&bundle->ref_count, 1) != 1) {
+		return;
+	}
+#else
+	bundle->ref_count--;
+	if (bundle->ref_count > 0) {
+		return;
+	}
+#endif
+
+	if (bundle->mapped) {
+		munmap(bundle->data, bundle->size);
+	} else {
+		free(bundle->data);
+	}
+	free(bundle);
+}
+
+size_t cel_bundle_count(const cel_bundle_t *bundle)
+{
+	return bundle ? bundle->count : 0;
+}
+
+cel_program_t *cel_bundle_load(cel_bundle_t *bundle, size_t index,
+			       const cel_schema_t *schema)
+{
+	if (!bundle || index >= bundle->count) {
+		return NULL;
+	}
+
+	uint64_t offset = bundle->offsets[index];
+	return load_image(bundle, bundle->data + offset,
+			  (size_t)(bundle->offsets[index + 1] - offset), schema);
+}
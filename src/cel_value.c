@@ -21,13 +21,15 @@ cel_string_t *cel_string_create(const char *str, size_t length)
 	}
 
 	/* 分配字符串结构 + 数据 + \0 */
-	cel_string_t *string = (cel_string_t *)malloc(
-		sizeof(cel_string_t) + length + 1);
+	bool scratch;
+	cel_string_t *string = (cel_string_t *)arena_scratch_alloc(
+		sizeof(cel_string_t) + length + 1, &scratch);
 	if (!string) {
 		return NULL;
 	}
 
 	string->ref_count = 1;
+	string->scratch = scratch;
 	string->length = length;
 
 	if (length > 0) {
@@ -61,12 +63,12 @@ void cel_string_release(cel_string_t *str)
 
 #ifdef CEL_THREAD_SAFE
 	if (atomic_fetch_sub(&str->ref_count, 1) == 1) {
-		free(str);
+		arena_scratch_free(str, str->scratch);
 	}
 #else
 	str->ref_count--;
 	if (str->ref_count == 0) {
-		free(str);
+		arena_scratch_free(str, str->scratch);
 	}
 #endif
 }
@@ -80,13 +82,15 @@ cel_bytes_t *cel_bytes_create(const unsigned char *data, size_t length)
 	}
 
 	/* 分配字节数组结构 + 数据 */
-	cel_bytes_t *bytes = (cel_bytes_t *)malloc(
-		sizeof(cel_bytes_t) + length);
+	bool scratch;
+	cel_bytes_t *bytes = (cel_bytes_t *)arena_scratch_alloc(
+		sizeof(cel_bytes_t) + length, &scratch);
 	if (!bytes) {
 		return NULL;
 	}
 
 	bytes->ref_count = 1;
+	bytes->scratch = scratch;
 	bytes->length = length;
 
 	if (length > 0) {
@@ -119,12 +123,12 @@ void cel_bytes_release(cel_bytes_t *bytes)
 
 #ifdef CEL_THREAD_SAFE
 	if (atomic_fetch_sub(&bytes->ref_count, 1) == 1) {
-		free(bytes);
+		arena_scratch_free(bytes, bytes->scratch);
 	}
 #else
 	bytes->ref_count--;
 	if (bytes->ref_count == 0) {
-		free(bytes);
+		arena_scratch_free(bytes, bytes->scratch);
 	}
 #endif
 }
@@ -261,6 +265,197 @@ void cel_value_destroy(cel_value_t *value)
 	value->value.ptr_value = NULL;
 }
 
+cel_value_t cel_value_retain(const cel_value_t *value)
+{
+	if (!value) {
+		return cel_value_null();
+	}
+
+	switch (value->type) {
+	case CEL_TYPE_STRING:
+		cel_string_retain(value->value.string_value);
+		break;
+
+	case CEL_TYPE_BYTES:
+		cel_bytes_retain(value->value.bytes_value);
+		break;
+
+	case CEL_TYPE_LIST:
+		cel_list_retain(value->value.list_value);
+		break;
+
+	case CEL_TYPE_MAP:
+		cel_map_retain(value->value.map_value);
+		break;
+
+	default:
+		/* 基本类型无需引用计数 */
+		break;
+	}
+
+	return *value;
+}
+
+/**
+ * @brief 检查值是否引用了临时分配区中的对象
+ */
+static bool value_in_scratch(const cel_value_t *value)
+{
+	switch (value->type) {
+	case CEL_TYPE_STRING:
+		return value->value.string_value->scratch;
+
+	case CEL_TYPE_BYTES:
+		return value->value.bytes_value->scratch;
+
+	case CEL_TYPE_LIST: {
+		const cel_list_t *list = value->value.list_value;
+		if (list->scratch) {
+			return true;
+		}
+		for (size_t i = 0; i < list->length; i++) {
+			if (value_in_scratch(list->items[i])) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	case CEL_TYPE_MAP: {
+		const cel_map_t *map = value->value.map_value;
+		if (map->scratch) {
+			return true;
+		}
+		for (size_t i = 0; i < map->bucket_count; i++) {
+			for (const cel_map_entry_t *entry = map->buckets[i]; entry;
+			     entry = entry->next) {
+				if (value_in_scratch(entry->key) ||
+				    value_in_scratch(entry->value)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief 构造值的堆上副本 (调用时没有安装临时分配区)
+ */
+static bool value_heap_copy(const cel_value_t *value, cel_value_t *out)
+{
+	if (!value_in_scratch(value)) {
+		*out = cel_value_retain(value);
+		return true;
+	}
+
+	switch (value->type) {
+	case CEL_TYPE_STRING:
+		*out = cel_value_string_n(value->value.string_value->data,
+					  value->value.string_value->length);
+		return out->type == CEL_TYPE_STRING;
+
+	case CEL_TYPE_BYTES:
+		*out = cel_value_bytes(value->value.bytes_value->data,
+				       value->value.bytes_value->length);
+		return out->type == CEL_TYPE_BYTES;
+
+	case CEL_TYPE_LIST: {
+		const cel_list_t *list = value->value.list_value;
+		cel_list_t *copy = cel_list_create(list->length);
+		if (!copy) {
+			return false;
+		}
+		for (size_t i = 0; i < list->length; i++) {
+			cel_value_t element;
+			if (!value_heap_copy(list->items[i], &element)) {
+				cel_list_release(copy);
+				return false;
+			}
+			bool appended = cel_list_append(copy, &element);
+			cel_value_destroy(&element);
+			if (!appended) {
+				cel_list_release(copy);
+				return false;
+			}
+		}
+		*out = cel_value_list(copy);
+		return true;
+	}
+
+	case CEL_TYPE_MAP: {
+		const cel_map_t *map = value->value.map_value;
+		cel_map_t *copy = cel_map_create(map->bucket_count);
+		const cel_map_entry_t **chain =
+			malloc((map->size + 1) * sizeof(cel_map_entry_t *));
+		if (!copy || !chain) {
+			cel_map_release(copy);
+			free(chain);
+			return false;
+		}
+
+		/* 新条目插入到链表头部，逆序插入以保持迭代顺序 */
+		bool success = true;
+		for (size_t i = 0; i < map->bucket_count && success; i++) {
+			size_t length = 0;
+			for (const cel_map_entry_t *entry = map->buckets[i]; entry;
+			     entry = entry->next) {
+				chain[length++] = entry;
+			}
+			while (length > 0 && success) {
+				const cel_map_entry_t *entry = chain[--length];
+				cel_value_t key, val;
+				if (!value_heap_copy(entry->key, &key)) {
+					success = false;
+				} else if (!value_heap_copy(entry->value, &val)) {
+					cel_value_destroy(&key);
+					success = false;
+				} else {
+					success = cel_map_put(copy, &key, &val);
+					cel_value_destroy(&key);
+					cel_value_destroy(&val);
+				}
+			}
+		}
+		free(chain);
+
+		if (!success) {
+			cel_map_release(copy);
+			return false;
+		}
+		*out = cel_value_map(copy);
+		return true;
+	}
+
+	default:
+		*out = *value;
+		return true;
+	}
+}
+
+bool cel_value_promote(cel_value_t *value)
+{
+	if (!value || !value_in_scratch(value)) {
+		return true;
+	}
+
+	/* 副本必须分配在堆上 */
+	arena_t *previous = arena_scratch_enter(NULL);
+	cel_value_t copy;
+	bool success = value_heap_copy(value, &copy);
+	arena_scratch_leave(previous);
+
+	if (success) {
+		cel_value_destroy(value);
+		*value = copy;
+	}
+	return success;
+}
+
 /* ========== 值访问 API ========== */
 
 bool cel_value_get_bool(const cel_value_t *value, bool *out)
@@ -1156,13 +1351,15 @@ cel_value_t cel_string_concat(const cel_value_t *a, const cel_value_t *b)
 
 	/* 分配新字符串 */
 	size_t new_length = str_a->length + str_b->length;
-	cel_string_t *result = (cel_string_t *)malloc(
-		sizeof(cel_string_t) + new_length + 1);
+	bool scratch;
+	cel_string_t *result = (cel_string_t *)arena_scratch_alloc(
+		sizeof(cel_string_t) + new_length + 1, &scratch);
 	if (!result) {
 		return cel_value_null();
 	}
 
 	result->ref_count = 1;
+	result->scratch = scratch;
 	result->length = new_length;
 
 	/* 复制两个字符串 */
@@ -0,0 +1,637 @@
+/**
+ * @file cel_vm.c
+ * @brief CEL 寄存器虚拟机实现
+ *
+ * 每个寄存器持有其值的一个引用；写入寄存器时释放旧值，
+ * 执行结束时释放全部寄存器。常见的 int/double 运算在指令内
+ * 直接完成，其余情况复用求值器的值级运算。
+ */
+
+#include "cel/cel_bytecode.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* 寄存器的栈上缓冲区大小，超过时使用堆分配 */
+#define VM_INLINE_REGISTERS 32
+
+static const char *const bool_check_messages[] = {
+	[CEL_BOOL_CHECK_LOGICAL] = "Logical operator requires boolean operands",
+	[CEL_BOOL_CHECK_TERNARY] = "Ternary condition must be boolean",
+	[CEL_BOOL_CHECK_LOOP] = "Loop condition must be boolean",
+};
+
+/**
+ * @brief 是否为引用计数类型 (string/bytes/list/map 在枚举中连续)
+ */
+static inline bool vm_is_refcounted(cel_type_e type)
+{
+	return type >= CEL_TYPE_STRING && type <= CEL_TYPE_MAP;
+}
+
+/**
+ * @brief 释放寄存器持有的引用 (标量无需调用 cel_value_destroy)
+ */
+static inline void vm_release(cel_value_t *reg)
+{
+	if (vm_is_refcounted(reg->type)) {
+		cel_value_destroy(reg);
+	}
+}
+
+/**
+ * @brief 写入寄存器 (转移 value 的所有权)
+ */
+static inline void vm_store(cel_value_t *reg, cel_value_t value)
+{
+	vm_release(reg);
+	*reg = value;
+}
+
+/**
+ * @brief 将 src 的一个新引用载入寄存器
+ */
+static inline void vm_load(cel_value_t *reg, const cel_value_t *src)
+{
+	if (vm_is_refcounted(src->type)) {
+		vm_store(reg, cel_value_retain(src));
+	} else {
+		vm_release(reg);
+		*reg = *src;
+	}
+}
+
+/*
+ * 标量结果直接写入寄存器字段，避免经由按值返回的临时结构体
+ * 中转 (窄写入后紧跟宽读取会导致存储转发失败)。
+ */
+static inline void vm_set_int(cel_value_t *reg, int64_t value)
+{
+	vm_release(reg);
+	reg->type = CEL_TYPE_INT;
+	reg->value.int_value = value;
+}
+
+static inline void vm_set_double(cel_value_t *reg, double value)
+{
+	vm_release(reg);
+	reg->type = CEL_TYPE_DOUBLE;
+	reg->value.double_value = value;
+}
+
+static inline void vm_set_bool(cel_value_t *reg, bool value)
+{
+	vm_release(reg);
+	reg->type = CEL_TYPE_BOOL;
+	reg->value.bool_value = value;
+}
+
+/**
+ * @brief 二元运算快速路径 (int/double)
+ *
+ * 结果直接写入 dst (dst 可以与操作数是同一寄存器)。
+ *
+ * @return 已处理返回 true，需要通用路径时返回 false
+ */
+static inline bool vm_fast_binary(cel_opcode_e op, const cel_value_t *l,
+				  const cel_value_t *r, cel_value_t *dst)
+{
+	if (l->type == CEL_TYPE_INT && r->type == CEL_TYPE_INT) {
+		int64_t x = l->value.int_value;
+		int64_t y = r->value.int_value;
+		switch (op) {
+		case CEL_OP_ADD:
+			vm_set_int(dst, x + y);
+			return true;
+		case CEL_OP_SUB:
+			vm_set_int(dst, x - y);
+			return true;
+		case CEL_OP_MUL:
+			vm_set_int(dst, x * y);
+			return true;
+		case CEL_OP_EQ:
+			vm_set_bool(dst, x == y);
+			return true;
+		case CEL_OP_NE:
+			vm_set_bool(dst, x != y);
+			return true;
+		case CEL_OP_LT:
+			vm_set_bool(dst, x < y);
+			return true;
+		case CEL_OP_LE:
+			vm_set_bool(dst, x <= y);
+			return true;
+		case CEL_OP_GT:
+			vm_set_bool(dst, x > y);
+			return true;
+		case CEL_OP_GE:
+			vm_set_bool(dst, x >= y);
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	if (l->type == CEL_TYPE_DOUBLE && r->type == CEL_TYPE_DOUBLE) {
+		double x = l->value.double_value;
+		double y = r->value.double_value;
+		switch (op) {
+		case CEL_OP_ADD:
+			vm_set_double(dst, x + y);
+			return true;
+		case CEL_OP_SUB:
+			vm_set_double(dst, x - y);
+			return true;
+		case CEL_OP_MUL:
+			vm_set_double(dst, x * y);
+			return true;
+		case CEL_OP_LT:
+			vm_set_bool(dst, x < y);
+			return true;
+		case CEL_OP_LE:
+			vm_set_bool(dst, x <= y);
+			return true;
+		case CEL_OP_GT:
+			vm_set_bool(dst, x > y);
+			return true;
+		case CEL_OP_GE:
+			vm_set_bool(dst, x >= y);
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief 操作码对应的二元运算符 (ADD..GE 与 AST 运算符顺序一致)
+ */
+static cel_binary_op_e binary_op_of(cel_opcode_e op)
+{
+	if (op == CEL_OP_IN) {
+		return CEL_BINARY_IN;
+	}
+	return (cel_binary_op_e)(CEL_BINARY_ADD + (op - CEL_OP_ADD));
+}
+
+/**
+ * @brief 构造列表
+ */
+static bool vm_make_list(cel_context_t *ctx, cel_value_t *items,
+			 size_t count, cel_value_t *out)
+{
+	cel_list_t *list = cel_list_create(count);
+	if (!list) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				      "Failed to create list");
+		return false;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!cel_list_append(list, &items[i])) {
+			cel_list_release(list);
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Failed to append to list");
+			return false;
+		}
+	}
+
+	*out = cel_value_list(list);
+	return true;
+}
+
+/**
+ * @brief 构造 Map (items 为交替的键与值)
+ */
+static bool vm_make_map(cel_context_t *ctx, cel_value_t *items,
+			size_t count, cel_value_t *out)
+{
+	cel_map_t *map = cel_map_create(count > 0 ? count : 16);
+	if (!map) {
+		cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+				      "Failed to create map");
+		return false;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (!cel_map_put(map, &items[2 * i], &items[2 * i + 1])) {
+			cel_map_release(map);
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Failed to set map entry");
+			return false;
+		}
+	}
+
+	*out = cel_value_map(map);
+	return true;
+}
+
+/**
+ * @brief 推导式迭代前进一步
+ *
+ * 列表的游标为下标；Map 的游标为桶编号与桶内链表位置，直接遍历
+ * 哈希桶，不复制键。
+ *
+ * @param range 迭代范围 (列表或 Map)
+ * @param cursor 游标寄存器 (两个)
+ * @param element 输出元素 (Map 为键)
+ * @param value 输出 Map 的值 (列表为 NULL)
+ * @return false 迭代结束
+ */
+static bool vm_iter_next(const cel_value_t *range, cel_value_t *cursor,
+			 const cel_value_t **element, const cel_value_t **value)
+{
+	if (range->type == CEL_TYPE_LIST) {
+		const cel_list_t *list = range->value.list_value;
+		int64_t index = cursor[0].value.int_value;
+		if ((size_t)index >= list->length) {
+			return false;
+		}
+		*element = list->items[index];
+		*value = NULL;
+		cursor[0].value.int_value = index + 1;
+		return true;
+	}
+
+	const cel_map_t *map = range->value.map_value;
+	size_t bucket = (size_t)cursor[0].value.int_value;
+	int64_t position = cursor[1].value.int_value;
+	for (; bucket < map->bucket_count; bucket++, position = 0) {
+		const cel_map_entry_t *entry = map->buckets[bucket];
+		for (int64_t i = 0; entry && i < position; i++) {
+			entry = entry->next;
+		}
+		if (entry) {
+			*element = entry->key;
+			*value = entry->value;
+			cursor[0].value.int_value = (int64_t)bucket;
+			cursor[1].value.int_value = position + 1;
+			return true;
+		}
+	}
+	cursor[0].value.int_value = (int64_t)bucket;
+	return false;
+}
+
+/**
+ * @brief 按名称从上下文载入变量
+ *
+ * 独立为函数，避免错误缓冲区占用执行循环的栈帧。
+ */
+static bool vm_load_variable(cel_context_t *ctx, const char *name,
+			     cel_value_t *reg)
+{
+	cel_value_t *value = cel_context_get_variable(ctx, name);
+	if (!value) {
+		cel_eval_report_error_detail(ctx, CEL_ERROR_UNKNOWN_IDENTIFIER,
+					     "Undefined variable", name,
+					     strlen(name));
+		return false;
+	}
+
+	vm_load(reg, value);
+	return true;
+}
+
+/* ========== 执行循环 ========== */
+
+/**
+ * @brief 执行字节码
+ *
+ * 进入时所有寄存器必须为 null；返回时释放所有寄存器并重置为 null，
+ * 因此寄存器文件可以直接用于下一次执行。
+ */
+static bool vm_run(const cel_bytecode_t *bytecode, cel_context_t *ctx,
+		   const cel_activation_t *activation, cel_value_t *regs,
+		   cel_value_t *result)
+{
+	size_t reg_count = bytecode->register_count;
+	const cel_instr_t *code = bytecode->code;
+	const cel_value_t *constants = bytecode->constants;
+	size_t pc = 0;
+	bool success = false;
+
+	for (;;) {
+		const cel_instr_t *ins = &code[pc++];
+		cel_value_t out;
+
+		switch ((cel_opcode_e)ins->op) {
+		case CEL_OP_LOAD_CONST:
+			vm_load(&regs[ins->dst], &constants[ins->imm]);
+			break;
+
+		case CEL_OP_LOAD_SLOT:
+			if (activation && ins->imm < activation->count &&
+			    activation->bound[ins->imm]) {
+				vm_load(&regs[ins->dst], &activation->values[ins->imm]);
+				break;
+			}
+			/* 槽位未设置，按名称在上下文中查找 */
+			if (!vm_load_variable(ctx, bytecode->names[ins->a],
+					      &regs[ins->dst])) {
+				goto done;
+			}
+			break;
+
+		case CEL_OP_LOAD_VAR:
+			if (!vm_load_variable(ctx, bytecode->names[ins->imm],
+					      &regs[ins->dst])) {
+				goto done;
+			}
+			break;
+
+		case CEL_OP_MOVE:
+			if (ins->dst != ins->a) {
+				vm_load(&regs[ins->dst], &regs[ins->a]);
+			}
+			break;
+
+		case CEL_OP_NEG:
+		case CEL_OP_NOT:
+			if (!cel_eval_unary_op(ctx,
+					       ins->op == CEL_OP_NEG ?
+						       CEL_UNARY_NEG : CEL_UNARY_NOT,
+					       &regs[ins->a], &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_ADD:
+		case CEL_OP_SUB:
+		case CEL_OP_MUL:
+		case CEL_OP_DIV:
+		case CEL_OP_MOD:
+		case CEL_OP_EQ:
+		case CEL_OP_NE:
+		case CEL_OP_LT:
+		case CEL_OP_LE:
+		case CEL_OP_GT:
+		case CEL_OP_GE:
+		case CEL_OP_IN:
+			if (vm_fast_binary((cel_opcode_e)ins->op, &regs[ins->a],
+					   &regs[ins->b], &regs[ins->dst])) {
+				break;
+			}
+			if (!cel_eval_binary_op(ctx, binary_op_of((cel_opcode_e)ins->op),
+						&regs[ins->a], &regs[ins->b], &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_JUMP:
+			pc = ins->imm;
+			break;
+
+		case CEL_OP_JUMP_IF_FALSE:
+		case CEL_OP_JUMP_IF_TRUE:
+		case CEL_OP_CHECK_BOOL: {
+			const cel_value_t *cond = &regs[ins->a];
+			if (cond->type != CEL_TYPE_BOOL) {
+				cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+						      bool_check_messages[ins->flags]);
+				goto done;
+			}
+			if ((ins->op == CEL_OP_JUMP_IF_FALSE && !cond->value.bool_value) ||
+			    (ins->op == CEL_OP_JUMP_IF_TRUE && cond->value.bool_value)) {
+				pc = ins->imm;
+			}
+			break;
+		}
+
+		case CEL_OP_SELECT:
+			if (!cel_eval_select_field(ctx, &regs[ins->a],
+						   &constants[ins->imm],
+						   ins->flags & CEL_INSTR_OPTIONAL,
+						   &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_INDEX:
+			if (!cel_eval_index_value(ctx, &regs[ins->a], &regs[ins->b],
+						  ins->flags & CEL_INSTR_OPTIONAL,
+						  &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_LIST:
+			if (!vm_make_list(ctx, &regs[ins->a], ins->imm, &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_MAP:
+			if (!vm_make_map(ctx, &regs[ins->a], ins->imm, &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_CALL:
+			if (!cel_exec_budget_charge_call(ctx, &regs[ins->a], ins->b) ||
+			    !cel_eval_call_context_function(ctx,
+							    bytecode->calls[ins->imm].name,
+							    &regs[ins->a], ins->b,
+							    &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_CALL_BUILTIN:
+			if (!cel_exec_budget_charge_call(ctx, &regs[ins->a], ins->b) ||
+			    !cel_builtin_call((cel_function_id_e)ins->imm, ctx,
+					      &regs[ins->a], &out)) {
+				goto done;
+			}
+			vm_store(&regs[ins->dst], out);
+			break;
+
+		case CEL_OP_MATCH: {
+			const cel_value_t *subject = &regs[ins->a];
+			bool matched;
+			if (!cel_exec_budget_charge(
+				    ctx, CEL_COST_CALL +
+						 (cel_string_length(subject) + ins->b) /
+							 CEL_COST_SIZE_UNIT)) {
+				goto done;
+			}
+			if (subject->type != CEL_TYPE_STRING) {
+				cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+						      "matches() requires string arguments");
+				goto done;
+			}
+			if (!cel_regex_match(bytecode->regexes[ins->imm],
+					     subject->value.string_value->data,
+					     cel_string_length(subject), &matched)) {
+				cel_eval_report_error(ctx, CEL_ERROR_INTERNAL,
+						      "regex match failed");
+				goto done;
+			}
+			vm_set_bool(&regs[ins->dst], matched);
+			break;
+		}
+
+		case CEL_OP_ITER_INIT: {
+			cel_type_e type = regs[ins->a].type;
+			if (type != CEL_TYPE_LIST && type != CEL_TYPE_MAP) {
+				cel_eval_report_error(ctx, CEL_ERROR_TYPE_MISMATCH,
+						      "Comprehension iter_range must be a list or map");
+				goto done;
+			}
+			vm_set_int(&regs[ins->dst], 0);
+			vm_set_int(&regs[ins->dst + 1], 0);
+			break;
+		}
+
+		case CEL_OP_ITER_NEXT: {
+			const cel_value_t *element;
+			const cel_value_t *value;
+			if (!vm_iter_next(&regs[ins->a], &regs[ins->b], &element,
+					  &value)) {
+				pc = ins->imm;
+				break;
+			}
+			if (!cel_exec_budget_charge(ctx, CEL_COST_ITERATION)) {
+				goto done;
+			}
+			if (!(ins->flags & CEL_ITER_PAIR)) {
+				vm_load(&regs[ins->dst], element);
+			} else if (regs[ins->a].type == CEL_TYPE_LIST) {
+				/* 游标已前进，下标为游标减一 */
+				vm_set_int(&regs[ins->dst], regs[ins->b].value.int_value - 1);
+				vm_load(&regs[ins->dst + 1], element);
+			} else {
+				vm_load(&regs[ins->dst], element);
+				vm_load(&regs[ins->dst + 1], value);
+			}
+			break;
+		}
+
+		case CEL_OP_APPEND:
+			if (!cel_eval_list_append(ctx, &regs[ins->dst],
+						  &regs[ins->a])) {
+				goto done;
+			}
+			break;
+
+		case CEL_OP_RETURN:
+			/* 转移结果寄存器的所有权 */
+			*result = regs[ins->a];
+			regs[ins->a].type = CEL_TYPE_NULL;
+			success = true;
+			goto done;
+
+		default:
+			cel_eval_report_error(ctx, CEL_ERROR_INTERNAL,
+					      "Invalid bytecode instruction");
+			goto done;
+		}
+	}
+
+done:
+	if (!success) {
+		/* 出错指令 (pc 已指向下一条) 对应的表达式位置 */
+		const cel_instr_loc_t *loc = &bytecode->locs[pc - 1];
+		cel_eval_error_locate(loc->line, loc->column);
+	}
+	for (size_t i = 0; i < reg_count; i++) {
+		vm_release(&regs[i]);
+		regs[i].type = CEL_TYPE_NULL;
+	}
+	return success;
+}
+
+/* ========== 执行 API ========== */
+
+bool cel_vm_execute(const cel_bytecode_t *bytecode, cel_context_t *ctx,
+		    const cel_activation_t *activation, cel_value_t *result)
+{
+	if (!bytecode || !ctx || !result) {
+		return false;
+	}
+
+	if (activation && activation->schema != bytecode->schema) {
+		cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+				      "Activation does not match program schema");
+		return false;
+	}
+
+	cel_value_t local_regs[VM_INLINE_REGISTERS];
+	cel_value_t *regs = local_regs;
+	size_t reg_count = bytecode->register_count;
+
+	if (reg_count > VM_INLINE_REGISTERS) {
+		regs = malloc(sizeof(cel_value_t) * reg_count);
+		if (!regs) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Out of memory");
+			return false;
+		}
+	}
+	for (size_t i = 0; i < reg_count; i++) {
+		regs[i].type = CEL_TYPE_NULL;
+		regs[i].value.ptr_value = NULL;
+	}
+
+	bool success = vm_run(bytecode, ctx, activation, regs, result);
+
+	if (regs != local_regs) {
+		free(regs);
+	}
+	return success;
+}
+
+bool cel_vm_execute_frame(const cel_bytecode_t *bytecode, cel_context_t *ctx,
+			  const cel_activation_t *activation,
+			  cel_vm_frame_t *frame, cel_value_t *result)
+{
+	if (!bytecode || !ctx || !frame || !result) {
+		return false;
+	}
+
+	if (activation && activation->schema != bytecode->schema) {
+		cel_eval_report_error(ctx, CEL_ERROR_INVALID_ARGUMENT,
+				      "Activation does not match program schema");
+		return false;
+	}
+
+	size_t reg_count = bytecode->register_count;
+	if (reg_count > frame->capacity) {
+		cel_value_t *regs = realloc(frame->registers,
+					    sizeof(cel_value_t) * reg_count);
+		if (!regs) {
+			cel_eval_report_error(ctx, CEL_ERROR_OUT_OF_MEMORY,
+					      "Out of memory");
+			return false;
+		}
+		for (size_t i = frame->capacity; i < reg_count; i++) {
+			regs[i].type = CEL_TYPE_NULL;
+			regs[i].value.ptr_value = NULL;
+		}
+		frame->registers = regs;
+		frame->capacity = reg_count;
+	}
+
+	return vm_run(bytecode, ctx, activation, frame->registers, result);
+}
+
+void cel_vm_frame_destroy(cel_vm_frame_t *frame)
+{
+	if (!frame) {
+		return;
+	}
+
+	free(frame->registers);
+	frame->registers = NULL;
+	frame->capacity = 0;
+}
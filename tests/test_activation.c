@@ -0,0 +1,419 @@
+/**
+ * @file test_activation.c
+ * @brief CEL 变量布局 (schema) 与激活记录单元测试
+ */
+
+#include "cel/cel_activation.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static cel_schema_t *schema = NULL;
+static size_t x_slot, y_slot, name_slot;
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+
+	schema = cel_schema_create();
+	TEST_ASSERT_NOT_NULL(schema);
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_schema_add_variable(schema, "x", &x_slot));
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_schema_add_variable(schema, "y", &y_slot));
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_schema_add_variable(schema, "name", &name_slot));
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+	cel_schema_destroy(schema);
+	schema = NULL;
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_program_t *compile_with_schema(const char *expr, cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	options.engine = engine;
+
+	cel_compile_result_t result = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE(result.has_errors);
+
+	cel_program_t *program = result.program;
+	result.program = NULL;
+	cel_compile_result_destroy(&result);
+	return program;
+}
+
+/**
+ * @brief 字节码中是否包含指定操作码
+ */
+static bool bytecode_has_op(const cel_program_t *program, cel_opcode_e op)
+{
+	const cel_bytecode_t *bc = program->bytecode;
+	for (size_t i = 0; i < bc->code_length; i++) {
+		if (bc->code[i].op == op) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* ========== Schema 测试 ========== */
+
+void test_schema_assigns_stable_slots(void)
+{
+	TEST_ASSERT_EQUAL_size_t(0, x_slot);
+	TEST_ASSERT_EQUAL_size_t(1, y_slot);
+	TEST_ASSERT_EQUAL_size_t(3, cel_schema_size(schema));
+
+	/* 重复声明返回已有槽位 */
+	size_t slot;
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_schema_add_variable(schema, "y", &slot));
+	TEST_ASSERT_EQUAL_size_t(y_slot, slot);
+	TEST_ASSERT_EQUAL_size_t(3, cel_schema_size(schema));
+
+	TEST_ASSERT_TRUE(cel_schema_find(schema, "name_suffix", 4, &slot));
+	TEST_ASSERT_EQUAL_size_t(name_slot, slot);
+	TEST_ASSERT_FALSE(cel_schema_find(schema, "z", 1, &slot));
+	TEST_ASSERT_EQUAL_STRING("name", cel_schema_get_name(schema, name_slot));
+	TEST_ASSERT_NULL(cel_schema_get_name(schema, 3));
+}
+
+/* ========== 激活记录测试 ========== */
+
+void test_activation_set_get_clear(void)
+{
+	cel_activation_t *activation = cel_activation_create(schema);
+	TEST_ASSERT_NOT_NULL(activation);
+	TEST_ASSERT_NULL(cel_activation_get(activation, x_slot));
+
+	cel_value_t x = cel_value_int(5);
+	cel_value_t name = cel_value_string("alice");
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_activation_set(activation, x_slot, &x));
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_activation_set_variable(activation, "name", &name));
+	cel_value_destroy(&name);
+
+	TEST_ASSERT_EQUAL_INT64(5, cel_activation_get(activation, x_slot)
+					   ->value.int_value);
+	TEST_ASSERT_EQUAL_STRING("alice", cel_activation_get(activation, name_slot)
+						  ->value.string_value->data);
+
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_OUT_OF_RANGE,
+			      cel_activation_set(activation, 3, &x));
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_NOT_FOUND,
+			      cel_activation_set_variable(activation, "z", &x));
+
+	cel_activation_clear(activation);
+	TEST_ASSERT_NULL(cel_activation_get(activation, x_slot));
+	TEST_ASSERT_NULL(cel_activation_get(activation, name_slot));
+
+	cel_activation_destroy(activation);
+}
+
+/* ========== 执行测试 ========== */
+
+void test_identifiers_compile_to_slots(void)
+{
+	cel_program_t *program = compile_with_schema("x + y", CEL_ENGINE_BYTECODE);
+	TEST_ASSERT_NOT_NULL(program->bytecode);
+	TEST_ASSERT_TRUE(bytecode_has_op(program, CEL_OP_LOAD_SLOT));
+	TEST_ASSERT_FALSE(bytecode_has_op(program, CEL_OP_LOAD_VAR));
+	cel_program_destroy(program);
+
+	/* 未声明的变量仍按名称查找 */
+	program = compile_with_schema("x + z", CEL_ENGINE_BYTECODE);
+	TEST_ASSERT_TRUE(bytecode_has_op(program, CEL_OP_LOAD_SLOT));
+	TEST_ASSERT_TRUE(bytecode_has_op(program, CEL_OP_LOAD_VAR));
+	cel_program_destroy(program);
+}
+
+void test_execute_with_activation(void)
+{
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+
+	for (size_t e = 0; e < 2; e++) {
+		cel_program_t *program = compile_with_schema(
+			"name + \":\" + string(x * y)", engines[e]);
+		cel_activation_t *activation = cel_activation_create(schema);
+
+		/* 同一激活记录在多个请求之间复用 */
+		for (int64_t i = 1; i <= 3; i++) {
+			cel_value_t x = cel_value_int(i);
+			cel_value_t y = cel_value_int(10);
+			cel_value_t name = cel_value_string("req");
+			cel_activation_set(activation, x_slot, &x);
+			cel_activation_set(activation, y_slot, &y);
+			cel_activation_set(activation, name_slot, &name);
+			cel_value_destroy(&name);
+
+			cel_execute_result_t result =
+				cel_execute_with_activation(program, ctx, activation);
+			TEST_ASSERT_TRUE(result.success);
+
+			char expected[32];
+			snprintf(expected, sizeof(expected), "req:%d", (int)(i * 10));
+			TEST_ASSERT_EQUAL_STRING(expected,
+						 result.value.value.string_value->data);
+
+			cel_execute_result_destroy(&result);
+			cel_activation_clear(activation);
+		}
+
+		cel_activation_destroy(activation);
+		cel_program_destroy(program);
+	}
+}
+
+void test_unbound_slot_falls_back_to_context(void)
+{
+	cel_program_t *program = compile_with_schema("x + y", CEL_ENGINE_BYTECODE);
+	cel_activation_t *activation = cel_activation_create(schema);
+
+	cel_value_t x = cel_value_int(1);
+	cel_value_t y = cel_value_int(100);
+	cel_activation_set(activation, x_slot, &x);
+	cel_context_add_variable(ctx, "y", &y);
+
+	/* 槽位优先于上下文中的同名变量 */
+	cel_value_t ctx_x = cel_value_int(1000);
+	cel_context_add_variable(ctx, "x", &ctx_x);
+
+	cel_execute_result_t result =
+		cel_execute_with_activation(program, ctx, activation);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(101, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+
+	/* 不提供激活记录时完全按名称查找 */
+	result = cel_execute(program, ctx);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(1100, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+
+	cel_activation_destroy(activation);
+	cel_program_destroy(program);
+}
+
+void test_unbound_undeclared_variable_fails(void)
+{
+	cel_program_t *program = compile_with_schema("x + 1", CEL_ENGINE_BYTECODE);
+	cel_activation_t *activation = cel_activation_create(schema);
+
+	cel_execute_result_t result =
+		cel_execute_with_activation(program, ctx, activation);
+	TEST_ASSERT_FALSE(result.success);
+	cel_execute_result_destroy(&result);
+
+	cel_activation_destroy(activation);
+	cel_program_destroy(program);
+}
+
+void test_schema_mismatch_is_rejected(void)
+{
+	cel_schema_t *other = cel_schema_create();
+	cel_schema_add_variable(other, "x", NULL);
+	cel_activation_t *activation = cel_activation_create(other);
+
+	cel_program_t *program = compile_with_schema("x", CEL_ENGINE_BYTECODE);
+	cel_execute_result_t result =
+		cel_execute_with_activation(program, ctx, activation);
+	TEST_ASSERT_FALSE(result.success);
+	TEST_ASSERT_NOT_NULL(result.error);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT, result.error->code);
+	cel_execute_result_destroy(&result);
+
+	cel_program_destroy(program);
+	cel_activation_destroy(activation);
+	cel_schema_destroy(other);
+}
+
+/* ========== 批量执行测试 ========== */
+
+#define BATCH_ROWS 130
+
+/**
+ * @brief 创建 BATCH_ROWS 个激活记录: x = i, y = 3
+ *
+ * 第 7 行不设置 x (执行失败)，第 8 行的 x 为字符串。
+ */
+static void create_batch(cel_activation_t **activations)
+{
+	for (size_t i = 0; i < BATCH_ROWS; i++) {
+		activations[i] = cel_activation_create(schema);
+		cel_value_t x = cel_value_int((int64_t)i);
+		cel_value_t y = cel_value_int(3);
+		if (i == 8) {
+			x = cel_value_string("eight");
+		}
+		if (i != 7) {
+			cel_activation_set(activations[i], x_slot, &x);
+		}
+		cel_activation_set(activations[i], y_slot, &y);
+		cel_value_destroy(&x);
+	}
+}
+
+static void destroy_batch(cel_activation_t **activations)
+{
+	for (size_t i = 0; i < BATCH_ROWS; i++) {
+		cel_activation_destroy(activations[i]);
+	}
+}
+
+void test_execute_batch_matches_single_shot(void)
+{
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	cel_activation_t *activations[BATCH_ROWS];
+	cel_execute_result_t results[BATCH_ROWS];
+	create_batch(activations);
+
+	for (size_t e = 0; e < 2; e++) {
+		cel_program_t *program = compile_with_schema("x * y + 1", engines[e]);
+
+		size_t succeeded = cel_execute_batch(
+			program, ctx, (const cel_activation_t *const *)activations,
+			BATCH_ROWS, results);
+		TEST_ASSERT_EQUAL_size_t(BATCH_ROWS - 2, succeeded);
+
+		for (size_t i = 0; i < BATCH_ROWS; i++) {
+			cel_execute_result_t single =
+				cel_execute_with_activation(program, ctx,
+							    activations[i]);
+			TEST_ASSERT_EQUAL(single.success, results[i].success);
+			if (single.success) {
+				TEST_ASSERT_TRUE(cel_value_equals(&single.value,
+								  &results[i].value));
+			} else {
+				TEST_ASSERT_EQUAL_INT(single.eval_error.code,
+						      results[i].eval_error.code);
+				TEST_ASSERT_NOT_EQUAL(CEL_OK,
+						      results[i].eval_error.code);
+			}
+			cel_execute_result_destroy(&single);
+			cel_execute_result_destroy(&results[i]);
+		}
+
+		cel_program_destroy(program);
+	}
+
+	destroy_batch(activations);
+}
+
+void test_execute_batch_select(void)
+{
+	cel_activation_t *activations[BATCH_ROWS];
+	uint64_t selection[CEL_SELECTION_WORDS(BATCH_ROWS)];
+	create_batch(activations);
+
+	/* 非 bool 结果 (第 0 行) 与执行失败的行 (第 7、8 行) 不被选中 */
+	cel_program_t *program = compile_with_schema(
+		"x == 0 ? 1 : x % 2 == 1", CEL_ENGINE_BYTECODE);
+	size_t selected = cel_execute_batch_select(
+		program, ctx, (const cel_activation_t *const *)activations,
+		BATCH_ROWS, selection);
+
+	size_t expected = 0;
+	for (size_t i = 0; i < BATCH_ROWS; i++) {
+		bool bit = (selection[i / 64] >> (i % 64)) & 1;
+		bool want = i % 2 == 1 && i != 7;
+		TEST_ASSERT_EQUAL(want, bit);
+		expected += want;
+	}
+	TEST_ASSERT_EQUAL_size_t(expected, selected);
+
+	cel_program_destroy(program);
+	destroy_batch(activations);
+}
+
+void test_execute_batch_select_limits_recursion(void)
+{
+	cel_activation_t *activations[BATCH_ROWS];
+	uint64_t selection[CEL_SELECTION_WORDS(BATCH_ROWS)];
+	create_batch(activations);
+
+	/* 右嵌套需要 5 层求值深度，树遍历逐行受上下文的递归深度限制 */
+	cel_program_t *program = compile_with_schema(
+		"x + (x + (x + (x + x))) > 0", CEL_ENGINE_TREE_WALK);
+	size_t limits[] = {4, 5};
+	for (size_t l = 0; l < 2; l++) {
+		cel_context_set_max_recursion(ctx, limits[l]);
+		size_t selected = cel_execute_batch_select(
+			program, ctx, (const cel_activation_t *const *)activations,
+			BATCH_ROWS, selection);
+		TEST_ASSERT_EQUAL_size_t(l == 0 ? 0 : BATCH_ROWS - 3, selected);
+	}
+
+	cel_program_destroy(program);
+	destroy_batch(activations);
+}
+
+void test_execute_batch_rejects_foreign_activation(void)
+{
+	cel_schema_t *other = cel_schema_create();
+	cel_schema_add_variable(other, "x", NULL);
+
+	cel_activation_t *rows[2] = {cel_activation_create(schema),
+				     cel_activation_create(other)};
+	cel_value_t x = cel_value_int(1);
+	cel_activation_set(rows[0], x_slot, &x);
+	cel_activation_set(rows[1], 0, &x);
+
+	cel_program_t *program = compile_with_schema("x", CEL_ENGINE_BYTECODE);
+	cel_execute_result_t results[2];
+	TEST_ASSERT_EQUAL_size_t(
+		1, cel_execute_batch(program, ctx,
+				     (const cel_activation_t *const *)rows, 2,
+				     results));
+	TEST_ASSERT_TRUE(results[0].success);
+	TEST_ASSERT_FALSE(results[1].success);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT, results[1].error->code);
+	cel_execute_result_destroy(&results[0]);
+	cel_execute_result_destroy(&results[1]);
+
+	cel_program_destroy(program);
+	cel_activation_destroy(rows[0]);
+	cel_activation_destroy(rows[1]);
+	cel_schema_destroy(other);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* Schema 测试 */
+	RUN_TEST(test_schema_assigns_stable_slots);
+
+	/* 激活记录测试 */
+	RUN_TEST(test_activation_set_get_clear);
+
+	/* 执行测试 */
+	RUN_TEST(test_identifiers_compile_to_slots);
+	RUN_TEST(test_execute_with_activation);
+	RUN_TEST(test_unbound_slot_falls_back_to_context);
+	RUN_TEST(test_unbound_undeclared_variable_fails);
+	RUN_TEST(test_schema_mismatch_is_rejected);
+
+	/* 批量执行测试 */
+	RUN_TEST(test_execute_batch_matches_single_shot);
+	RUN_TEST(test_execute_batch_select);
+	RUN_TEST(test_execute_batch_select_limits_recursion);
+	RUN_TEST(test_execute_batch_rejects_foreign_activation);
+
+	return UNITY_END();
+}
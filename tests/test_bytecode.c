@@ -0,0 +1,731 @@
+/**
+ * @file test_bytecode.c
+ * @brief CEL 字节码编译器与虚拟机单元测试
+ *
+ * 以树遍历求值器为参考实现，对比两种执行引擎的结果。
+ */
+
+#include "cel/cel_bytecode.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+
+	cel_value_t x = cel_value_int(42);
+	cel_value_t y = cel_value_int(10);
+	cel_value_t d = cel_value_double(2.5);
+	cel_value_t s = cel_value_string("hello");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "y", &y);
+	cel_context_add_variable(ctx, "d", &d);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	/* l = [1, 2, 3] */
+	cel_list_t *list = cel_list_create(3);
+	for (int64_t i = 1; i <= 3; i++) {
+		cel_value_t v = cel_value_int(i);
+		cel_list_append(list, &v);
+	}
+	cel_value_t l = cel_value_list(list);
+	cel_context_add_variable(ctx, "l", &l);
+	cel_value_destroy(&l);
+
+	/* m = {"name": "cel", "age": 7} */
+	cel_map_t *map = cel_map_create(4);
+	cel_value_t k1 = cel_value_string("name");
+	cel_value_t v1 = cel_value_string("cel");
+	cel_value_t k2 = cel_value_string("age");
+	cel_value_t v2 = cel_value_int(7);
+	cel_map_put(map, &k1, &v1);
+	cel_map_put(map, &k2, &v2);
+	cel_value_destroy(&k1);
+	cel_value_destroy(&v1);
+	cel_value_destroy(&k2);
+	cel_value_t m = cel_value_map(map);
+	cel_context_add_variable(ctx, "m", &m);
+	cel_value_destroy(&m);
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_execute_result_t run_with_engine(const char *expr,
+					    cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = engine;
+
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+
+	if (engine == CEL_ENGINE_BYTECODE) {
+		TEST_ASSERT_NOT_NULL_MESSAGE(compile.program->bytecode, expr);
+	} else {
+		TEST_ASSERT_NULL(compile.program->bytecode);
+	}
+
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	cel_compile_result_destroy(&compile);
+	return result;
+}
+
+/**
+ * @brief 两种引擎的结果 (成功与否、值) 必须一致
+ */
+static void assert_engines_agree(const char *expr)
+{
+	cel_execute_result_t tree = run_with_engine(expr, CEL_ENGINE_TREE_WALK);
+	cel_execute_result_t vm = run_with_engine(expr, CEL_ENGINE_BYTECODE);
+
+	TEST_ASSERT_EQUAL_MESSAGE(tree.success, vm.success, expr);
+	if (tree.success) {
+		TEST_ASSERT_EQUAL_INT_MESSAGE(tree.value.type, vm.value.type, expr);
+		TEST_ASSERT_TRUE_MESSAGE(cel_value_equals(&tree.value, &vm.value),
+					 expr);
+	}
+
+	cel_execute_result_destroy(&tree);
+	cel_execute_result_destroy(&vm);
+}
+
+/**
+ * @brief 编译表达式并统计指定操作码的数量
+ */
+static size_t count_op(const char *expr, cel_opcode_e op, uint32_t *imm)
+{
+	cel_compile_result_t compile = cel_compile(expr);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+	TEST_ASSERT_NOT_NULL_MESSAGE(compile.program->bytecode, expr);
+
+	const cel_bytecode_t *bc = compile.program->bytecode;
+	size_t count = 0;
+	for (size_t i = 0; i < bc->code_length; i++) {
+		if (bc->code[i].op == op) {
+			if (imm) {
+				*imm = bc->code[i].imm;
+			}
+			count++;
+		}
+	}
+
+	cel_compile_result_destroy(&compile);
+	return count;
+}
+
+/**
+ * @brief 上下文函数: twice(n) = n * 2
+ */
+static cel_value_t twice_value;
+
+static cel_result_t fn_twice(cel_func_context_t *fctx, cel_value_t **args,
+			     size_t arg_count)
+{
+	(void)fctx;
+	(void)arg_count;
+	twice_value = cel_value_int(args[0]->value.int_value * 2);
+	return cel_ok_result(&twice_value);
+}
+
+static cel_ast_node_t *create_ident(const char *name)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_ident(name, strlen(name), loc);
+}
+
+static cel_ast_node_t *create_int(int64_t value)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_literal(cel_value_int(value), loc);
+}
+
+static cel_ast_node_t *create_binary(cel_binary_op_e op, cel_ast_node_t *left,
+				      cel_ast_node_t *right)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_binary(op, left, right, loc);
+}
+
+/**
+ * @brief 创建 range.map(var, var * factor) 形式的推导式
+ */
+static cel_ast_node_t *create_map_comprehension(cel_ast_node_t *range,
+						const char *var,
+						cel_ast_node_t *factor)
+{
+	cel_token_location_t loc = {0};
+
+	cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+	elements[0] = create_binary(CEL_BINARY_MUL, create_ident(var), factor);
+
+	return cel_ast_create_comprehension(
+		var, strlen(var),
+		NULL, 0,
+		range,
+		"@result", 7,
+		cel_ast_create_list(NULL, 0, loc),
+		cel_ast_create_literal(cel_value_bool(true), loc),
+		create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			      cel_ast_create_list(elements, 1, loc)),
+		create_ident("@result"),
+		loc);
+}
+
+/* ========== 引擎选择测试 ========== */
+
+void test_bytecode_is_default_engine(void)
+{
+	cel_compile_result_t compile = cel_compile("x + y");
+	TEST_ASSERT_FALSE(compile.has_errors);
+	TEST_ASSERT_NOT_NULL(compile.program->bytecode);
+	TEST_ASSERT_GREATER_THAN(0, compile.program->bytecode->code_length);
+
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(52, result.value.value.int_value);
+
+	cel_execute_result_destroy(&result);
+	cel_compile_result_destroy(&compile);
+}
+
+void test_tree_walk_engine_option(void)
+{
+	cel_execute_result_t result = run_with_engine("x * 2",
+						      CEL_ENGINE_TREE_WALK);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(84, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+}
+
+void test_unsupported_node_returns_null(void)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *ast = cel_ast_create_struct("Msg", 3, NULL, 0, loc);
+
+	TEST_ASSERT_NULL(cel_bytecode_compile(ast, NULL));
+
+	cel_ast_destroy(ast);
+}
+
+/* ========== 引擎一致性测试 ========== */
+
+void test_engines_agree_arithmetic(void)
+{
+	assert_engines_agree("1 + 2 * 3 - 4 / 2");
+	assert_engines_agree("x % 5 + -y");
+	assert_engines_agree("d * 2.0 + 1.5");
+	assert_engines_agree("d + x");
+	assert_engines_agree("x < y || x >= 42");
+	assert_engines_agree("x == 42 && y != 10");
+	assert_engines_agree("!(x > y)");
+	assert_engines_agree("x / 0");
+	assert_engines_agree("\"a\" + \"b\"");
+	assert_engines_agree("[1, 2] + [3]");
+}
+
+void test_engines_agree_access(void)
+{
+	assert_engines_agree("m.name");
+	assert_engines_agree("m.age + l[2]");
+	assert_engines_agree("m[\"age\"]");
+	assert_engines_agree("m.missing");
+	assert_engines_agree("l[5]");
+	assert_engines_agree("2 in l");
+	assert_engines_agree("\"name\" in m");
+	assert_engines_agree("{\"k\": [x, y]}.k[1]");
+	assert_engines_agree("[[1, 2], [3, 4]][1][0]");
+}
+
+void test_engines_agree_calls(void)
+{
+	assert_engines_agree("size(s) + size(l)");
+	assert_engines_agree("s.startsWith(\"he\") && s.endsWith(\"lo\")");
+	assert_engines_agree("l.contains(2)");
+	assert_engines_agree("string(x) + s");
+	assert_engines_agree("int(\"12\") + uint(3) == 15");
+	assert_engines_agree("type(m)");
+	assert_engines_agree("unknown_function(1)");
+}
+
+void test_engines_agree_control_flow(void)
+{
+	assert_engines_agree("x > 0 ? \"pos\" : \"neg\"");
+	assert_engines_agree("x < 0 ? 1 : y > 5 ? 2 : 3");
+	assert_engines_agree("x ? 1 : 2");
+	assert_engines_agree("false && undefined_var");
+	assert_engines_agree("true || undefined_var");
+	assert_engines_agree("true && undefined_var");
+	assert_engines_agree("true && 1");
+	assert_engines_agree("1 || true");
+}
+
+/* ========== 函数解析测试 ========== */
+
+void test_builtin_calls_resolve_at_compile_time(void)
+{
+	uint32_t id = 0;
+	TEST_ASSERT_EQUAL_size_t(1, count_op("s.startsWith(\"he\")",
+					     CEL_OP_CALL_BUILTIN, &id));
+	TEST_ASSERT_EQUAL_UINT32(CEL_FUNC_STARTS_WITH, id);
+	TEST_ASSERT_EQUAL_size_t(0, count_op("s.startsWith(\"he\")",
+					     CEL_OP_CALL, NULL));
+
+	/* 全局与方法形式解析到同一重载 */
+	TEST_ASSERT_EQUAL_size_t(2, count_op("size(s) + l.size()",
+					     CEL_OP_CALL_BUILTIN, &id));
+	TEST_ASSERT_EQUAL_UINT32(CEL_FUNC_SIZE, id);
+
+	/* 调用形式或参数数量不匹配时保留为按名称调用 */
+	TEST_ASSERT_EQUAL_size_t(1, count_op("s.int()", CEL_OP_CALL, NULL));
+	TEST_ASSERT_EQUAL_size_t(1, count_op("size(s, 1)", CEL_OP_CALL, NULL));
+	TEST_ASSERT_EQUAL_size_t(1, count_op("twice(x)", CEL_OP_CALL, NULL));
+}
+
+void test_builtin_resolve_api(void)
+{
+	cel_function_id_e id;
+	TEST_ASSERT_TRUE(cel_builtin_resolve("endsWith", 8, true, 2, &id));
+	TEST_ASSERT_EQUAL_INT(CEL_FUNC_ENDS_WITH, id);
+	TEST_ASSERT_EQUAL_STRING("endsWith", cel_builtin_get(id)->name);
+
+	/* 名称不要求 null 结尾 */
+	TEST_ASSERT_TRUE(cel_builtin_resolve("getHours()", 8, true, 1, &id));
+	TEST_ASSERT_EQUAL_INT(CEL_FUNC_GET_HOURS, id);
+
+	TEST_ASSERT_FALSE(cel_builtin_resolve("getHours", 8, false, 1, &id));
+	TEST_ASSERT_FALSE(cel_builtin_resolve("size", 4, false, 2, &id));
+	TEST_ASSERT_TRUE(cel_builtin_exists("size", 4));
+	TEST_ASSERT_FALSE(cel_builtin_exists("sizes", 5));
+	TEST_ASSERT_NULL(cel_builtin_get(CEL_FUNC_COUNT));
+}
+
+void test_unresolved_call_errors(void)
+{
+	assert_engines_agree("size(s, 1)");
+	assert_engines_agree("s.int()");
+	assert_engines_agree("nope(1)");
+
+	cel_execute_result_t result = run_with_engine("size(s, 1)",
+						      CEL_ENGINE_BYTECODE);
+	TEST_ASSERT_FALSE(result.success);
+	cel_execute_result_destroy(&result);
+}
+
+void test_context_function_call(void)
+{
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_context_add_function(ctx, "twice", fn_twice, 1, 1));
+
+	cel_execute_result_t result = run_with_engine("twice(x) + size(s)",
+						      CEL_ENGINE_BYTECODE);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(89, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+
+	assert_engines_agree("twice(y)");
+}
+
+/* ========== 推导式测试 ========== */
+
+void test_comprehension_list_map(void)
+{
+	/* l.map(v, v * 10) => [10, 20, 30] */
+	cel_ast_node_t *ast = create_map_comprehension(create_ident("l"), "v",
+						       create_int(10));
+
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+
+	cel_value_t vm_result, tree_result;
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &vm_result));
+	TEST_ASSERT_TRUE(cel_eval(ast, ctx, &tree_result));
+
+	TEST_ASSERT_EQUAL_INT(CEL_TYPE_LIST, vm_result.type);
+	TEST_ASSERT_EQUAL_size_t(3, cel_list_size(vm_result.value.list_value));
+	TEST_ASSERT_EQUAL_INT64(30, cel_list_get(vm_result.value.list_value, 2)
+					    ->value.int_value);
+	TEST_ASSERT_TRUE(cel_value_equals(&vm_result, &tree_result));
+
+	cel_value_destroy(&vm_result);
+	cel_value_destroy(&tree_result);
+	cel_bytecode_destroy(bc);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_nested_scopes(void)
+{
+	/* l.map(v, l.map(w, w * v)) — 内层推导式引用外层循环变量 */
+	cel_ast_node_t *inner = create_map_comprehension(create_ident("l"), "w",
+							 create_ident("v"));
+	cel_ast_node_t *ast = create_map_comprehension(create_ident("l"), "v",
+						       create_int(1));
+
+	/* 将外层步骤中的 v * 1 替换为内层推导式 */
+	cel_ast_node_t *elem = ast->as.comprehension.loop_step->as.binary.right
+				       ->as.list.elements[0];
+	cel_ast_destroy(elem);
+	ast->as.comprehension.loop_step->as.binary.right->as.list.elements[0] = inner;
+
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+
+	cel_value_t vm_result, tree_result;
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &vm_result));
+	TEST_ASSERT_TRUE(cel_eval(ast, ctx, &tree_result));
+
+	/* [[1, 2, 3], [2, 4, 6], [3, 6, 9]] */
+	TEST_ASSERT_EQUAL_INT(CEL_TYPE_LIST, vm_result.type);
+	cel_value_t *row = cel_list_get(vm_result.value.list_value, 2);
+	TEST_ASSERT_EQUAL_INT64(9, cel_list_get(row->value.list_value, 2)
+					   ->value.int_value);
+	TEST_ASSERT_TRUE(cel_value_equals(&vm_result, &tree_result));
+
+	/* 循环变量不会泄漏到上下文 */
+	TEST_ASSERT_NULL(cel_context_get_variable(ctx, "v"));
+
+	cel_value_destroy(&vm_result);
+	cel_value_destroy(&tree_result);
+	cel_bytecode_destroy(bc);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_invalid_range(void)
+{
+	cel_ast_node_t *ast = create_map_comprehension(create_ident("x"), "v",
+						       create_int(2));
+
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+
+	cel_value_t result;
+	TEST_ASSERT_FALSE(cel_vm_execute(bc, ctx, NULL, &result));
+
+	cel_bytecode_destroy(bc);
+	cel_ast_destroy(ast);
+}
+
+/**
+ * @brief 创建 range 上的推导式 (循环条件恒为 true 时 cond 传 NULL)
+ */
+static cel_ast_node_t *create_fold(const char *range, const char *var,
+				   const char *var2, cel_ast_node_t *init,
+				   cel_ast_node_t *cond, cel_ast_node_t *step)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_comprehension(
+		var, strlen(var),
+		var2, var2 ? strlen(var2) : 0,
+		create_ident(range),
+		"@result", 7,
+		init,
+		cond ? cond : cel_ast_create_literal(cel_value_bool(true), loc),
+		step,
+		create_ident("@result"),
+		loc);
+}
+
+/**
+ * @brief 在两种引擎上执行 AST，检查结果一致并返回字节码的结果
+ */
+static cel_value_t run_both_engines(cel_ast_node_t *ast)
+{
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+
+	cel_value_t vm_result, tree_result;
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &vm_result));
+	TEST_ASSERT_TRUE(cel_eval(ast, ctx, &tree_result));
+	TEST_ASSERT_TRUE(cel_value_equals(&vm_result, &tree_result));
+
+	cel_value_destroy(&tree_result);
+	cel_bytecode_destroy(bc);
+	return vm_result;
+}
+
+static cel_ast_node_t *create_append(const char *element)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+	elements[0] = create_ident(element);
+	return create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			     cel_ast_create_list(elements, 1, loc));
+}
+
+void test_comprehension_map_range(void)
+{
+	cel_token_location_t loc = {0};
+
+	/* 单变量形式遍历键 */
+	cel_ast_node_t *ast = create_fold("m", "k", NULL,
+					  cel_ast_create_list(NULL, 0, loc),
+					  NULL, create_append("k"));
+	cel_value_t keys = run_both_engines(ast);
+	TEST_ASSERT_EQUAL_INT(CEL_TYPE_LIST, keys.type);
+	TEST_ASSERT_EQUAL_INT(2, (int)cel_list_size(keys.value.list_value));
+	cel_ast_destroy(ast);
+
+	/* 双变量形式遍历 (键, 值)，值的顺序与键一致 */
+	ast = create_fold("m", "k", "v", cel_ast_create_list(NULL, 0, loc),
+			  NULL, create_append("v"));
+	cel_value_t values = run_both_engines(ast);
+	TEST_ASSERT_EQUAL_INT(2, (int)cel_list_size(values.value.list_value));
+	for (size_t i = 0; i < 2; i++) {
+		cel_value_t *key = cel_list_get(keys.value.list_value, i);
+		TEST_ASSERT_TRUE(cel_value_equals(
+			cel_map_get(cel_context_get_variable(ctx, "m")->value.map_value,
+				    key),
+			cel_list_get(values.value.list_value, i)));
+	}
+	cel_ast_destroy(ast);
+	cel_value_destroy(&keys);
+	cel_value_destroy(&values);
+
+	/* exists(k, true) 在第二次迭代检查条件时停止 */
+	ast = create_fold("m", "k", NULL,
+			  cel_ast_create_literal(cel_value_bool(false), loc),
+			  cel_ast_create_unary(CEL_UNARY_NOT,
+					       create_ident("@result"), loc),
+			  create_binary(CEL_BINARY_OR, create_ident("@result"),
+					cel_ast_create_literal(cel_value_bool(true),
+							       loc)));
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	cel_exec_budget_t budget;
+	cel_value_t result;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_TRUE(result.value.bool_value);
+	TEST_ASSERT_EQUAL_UINT64(2 * CEL_COST_ITERATION, budget.cost);
+	cel_bytecode_destroy(bc);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_list_pair(void)
+{
+	/* l 的双变量形式: sum(i * v) = 0 * 1 + 1 * 2 + 2 * 3 */
+	cel_ast_node_t *ast = create_fold(
+		"l", "i", "v", create_int(0), NULL,
+		create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			      create_binary(CEL_BINARY_MUL, create_ident("i"),
+					    create_ident("v"))));
+	cel_value_t result = run_both_engines(ast);
+	TEST_ASSERT_EQUAL_INT64(8, result.value.int_value);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_budget(void)
+{
+	/* l.map(v, l.map(w, w * v))：外层 3 次迭代，内层共 9 次 */
+	cel_ast_node_t *inner = create_map_comprehension(create_ident("l"), "w",
+							 create_ident("v"));
+	cel_ast_node_t *ast = create_map_comprehension(create_ident("l"), "v",
+						       create_int(1));
+	cel_ast_node_t *elem = ast->as.comprehension.loop_step->as.binary.right
+				       ->as.list.elements[0];
+	cel_ast_destroy(elem);
+	ast->as.comprehension.loop_step->as.binary.right->as.list.elements[0] = inner;
+
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+
+	cel_exec_budget_t budget;
+	cel_value_t result;
+
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_EQUAL_UINT64(12 * CEL_COST_ITERATION, budget.cost);
+	cel_value_destroy(&result);
+
+	previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_eval(ast, ctx, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_EQUAL_UINT64(12 * CEL_COST_ITERATION, budget.cost);
+	cel_value_destroy(&result);
+
+	/* 超出预算时两种引擎都失败 */
+	previous = cel_exec_budget_enter(&budget, 5, 0);
+	TEST_ASSERT_FALSE(cel_vm_execute(bc, ctx, NULL, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_COST_LIMIT, budget.exhausted);
+
+	previous = cel_exec_budget_enter(&budget, 5, 0);
+	TEST_ASSERT_FALSE(cel_eval(ast, ctx, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_COST_LIMIT, budget.exhausted);
+
+	cel_bytecode_destroy(bc);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_append_in_place(void)
+{
+	/* big.map(v, v * 2)，50000 个元素：累加器原地追加，线性时间完成 */
+	enum { COUNT = 50000 };
+	cel_list_t *list = cel_list_create(COUNT);
+	for (int64_t i = 0; i < COUNT; i++) {
+		cel_value_t v = cel_value_int(i);
+		cel_list_append(list, &v);
+	}
+	cel_value_t big = cel_value_list(list);
+	cel_context_add_variable(ctx, "big", &big);
+	cel_value_destroy(&big);
+
+	cel_ast_node_t *ast = create_map_comprehension(create_ident("big"), "v",
+						       create_int(2));
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+	size_t appends = 0;
+	for (size_t i = 0; i < bc->code_length; i++) {
+		appends += bc->code[i].op == CEL_OP_APPEND;
+	}
+	TEST_ASSERT_EQUAL_size_t(1, appends);
+	cel_bytecode_destroy(bc);
+
+	cel_value_t result = run_both_engines(ast);
+	TEST_ASSERT_EQUAL_size_t(COUNT, cel_list_size(result.value.list_value));
+	TEST_ASSERT_EQUAL_INT64(2 * (COUNT - 1),
+				cel_list_get(result.value.list_value, COUNT - 1)
+					->value.int_value);
+	cel_value_destroy(&result);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_append_shared_accu(void)
+{
+	cel_token_location_t loc = {0};
+
+	/* 累加器初始值为变量 l: 先复制再追加，l 保持不变 */
+	cel_ast_node_t *ast = create_fold(
+		"l", "v", NULL, create_ident("l"), NULL,
+		cel_ast_create_ternary(
+			create_binary(CEL_BINARY_GT, create_ident("v"),
+				      create_int(1)),
+			create_append("v"), create_ident("@result"), loc));
+	for (int round = 0; round < 2; round++) {
+		cel_value_t result = run_both_engines(ast);
+		TEST_ASSERT_EQUAL_size_t(5, cel_list_size(result.value.list_value));
+		TEST_ASSERT_EQUAL_INT64(3, cel_list_get(result.value.list_value, 4)
+						   ->value.int_value);
+		cel_value_destroy(&result);
+	}
+	TEST_ASSERT_EQUAL_size_t(
+		3, cel_list_size(cel_context_get_variable(ctx, "l")
+					 ->value.list_value));
+	cel_ast_destroy(ast);
+
+	/* 追加的元素引用累加器: [[], [[]], ...] 中的元素不随后续追加改变 */
+	ast = create_fold("l", "v", NULL, cel_ast_create_list(NULL, 0, loc),
+			  NULL, create_append("@result"));
+	cel_value_t result = run_both_engines(ast);
+	TEST_ASSERT_EQUAL_size_t(3, cel_list_size(result.value.list_value));
+	for (size_t i = 0; i < 3; i++) {
+		cel_value_t *elem = cel_list_get(result.value.list_value, i);
+		TEST_ASSERT_EQUAL_size_t(i, cel_list_size(elem->value.list_value));
+	}
+	cel_value_destroy(&result);
+	cel_ast_destroy(ast);
+
+	/* 累加器不是列表时报告类型错误 */
+	ast = create_fold("l", "v", NULL, create_int(0), NULL,
+			  create_append("v"));
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_FALSE(cel_vm_execute(bc, ctx, NULL, &result));
+	TEST_ASSERT_FALSE(cel_eval(ast, ctx, &result));
+	cel_bytecode_destroy(bc);
+	cel_ast_destroy(ast);
+}
+
+/* ========== 所有权测试 ========== */
+
+void test_result_outlives_program(void)
+{
+	cel_compile_result_t compile = cel_compile("\"literal\"");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	cel_compile_result_destroy(&compile);
+
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_STRING("literal", result.value.value.string_value->data);
+	cel_execute_result_destroy(&result);
+}
+
+void test_repeated_execution(void)
+{
+	cel_compile_result_t compile = cel_compile("s + \"!\"");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	for (int i = 0; i < 3; i++) {
+		cel_execute_result_t result = cel_execute(compile.program, ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_STRING("hello!",
+					 result.value.value.string_value->data);
+		cel_execute_result_destroy(&result);
+	}
+
+	/* 变量值保持不变 */
+	cel_value_t *s = cel_context_get_variable(ctx, "s");
+	TEST_ASSERT_EQUAL_STRING("hello", s->value.string_value->data);
+
+	cel_compile_result_destroy(&compile);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 引擎选择测试 */
+	RUN_TEST(test_bytecode_is_default_engine);
+	RUN_TEST(test_tree_walk_engine_option);
+	RUN_TEST(test_unsupported_node_returns_null);
+
+	/* 引擎一致性测试 */
+	RUN_TEST(test_engines_agree_arithmetic);
+	RUN_TEST(test_engines_agree_access);
+	RUN_TEST(test_engines_agree_calls);
+	RUN_TEST(test_engines_agree_control_flow);
+
+	/* 函数解析测试 */
+	RUN_TEST(test_builtin_calls_resolve_at_compile_time);
+	RUN_TEST(test_builtin_resolve_api);
+	RUN_TEST(test_unresolved_call_errors);
+	RUN_TEST(test_context_function_call);
+
+	/* 推导式测试 */
+	RUN_TEST(test_comprehension_list_map);
+	RUN_TEST(test_comprehension_nested_scopes);
+	RUN_TEST(test_comprehension_invalid_range);
+	RUN_TEST(test_comprehension_map_range);
+	RUN_TEST(test_comprehension_list_pair);
+	RUN_TEST(test_comprehension_budget);
+	RUN_TEST(test_comprehension_append_in_place);
+	RUN_TEST(test_comprehension_append_shared_accu);
+
+	/* 所有权测试 */
+	RUN_TEST(test_result_outlives_program);
+	RUN_TEST(test_repeated_execution);
+
+	return UNITY_END();
+}
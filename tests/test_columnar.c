@@ -0,0 +1,238 @@
+/**
+ * @file test_columnar.c
+ * @brief CEL 列式 (向量化) 执行单元测试
+ */
+
+#include "cel/cel_columnar.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* 跨越多个执行段 (每段 1024 行)，最后一段不满 */
+#define ROWS 3000
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static cel_schema_t *schema = NULL;
+static size_t a_slot, b_slot, flag_slot;
+
+static int64_t a_data[ROWS];
+static double b_data[ROWS];
+static bool flag_data[ROWS];
+static uint32_t selection[ROWS];
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+
+	/* tag 不在 schema 中，由上下文提供 */
+	cel_value_t tag = cel_value_string("abc");
+	cel_context_add_variable(ctx, "tag", &tag);
+	cel_value_destroy(&tag);
+
+	schema = cel_schema_create();
+	TEST_ASSERT_NOT_NULL(schema);
+	cel_schema_add_variable(schema, "a", &a_slot);
+	cel_schema_add_variable(schema, "b", &b_slot);
+	cel_schema_add_variable(schema, "flag", &flag_slot);
+
+	for (size_t i = 0; i < ROWS; i++) {
+		a_data[i] = (int64_t)(i % 20) - 3;
+		b_data[i] = (double)(i % 7) * 0.75;
+		flag_data[i] = i % 3 == 0;
+	}
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+	cel_schema_destroy(schema);
+	schema = NULL;
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_program_t *compile_with_schema(const char *expr, cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	options.engine = engine;
+
+	cel_compile_result_t result = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(result.has_errors, expr);
+
+	cel_program_t *program = result.program;
+	result.program = NULL;
+	cel_compile_result_destroy(&result);
+	return program;
+}
+
+/**
+ * @brief 逐行执行，返回结果是否为 true
+ */
+static bool row_matches(const cel_program_t *program, size_t row)
+{
+	cel_activation_t *activation = cel_activation_create(schema);
+	cel_value_t a = cel_value_int(a_data[row]);
+	cel_value_t b = cel_value_double(b_data[row]);
+	cel_value_t flag = cel_value_bool(flag_data[row]);
+	cel_activation_set(activation, a_slot, &a);
+	cel_activation_set(activation, b_slot, &b);
+	cel_activation_set(activation, flag_slot, &flag);
+
+	cel_execute_result_t result =
+		cel_execute_with_activation(program, ctx, activation);
+	bool match = result.success && result.value.type == CEL_TYPE_BOOL &&
+		     result.value.value.bool_value;
+
+	cel_execute_result_destroy(&result);
+	cel_activation_destroy(activation);
+	return match;
+}
+
+/**
+ * @brief 列式执行的选择向量必须与逐行执行一致 (两种引擎)
+ *
+ * @return 列式执行计划是否完全向量化
+ */
+static bool assert_same_selection(const char *expr)
+{
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	cel_column_t columns[3];
+	columns[a_slot] = (cel_column_t){CEL_COLUMN_INT, a_data};
+	columns[b_slot] = (cel_column_t){CEL_COLUMN_DOUBLE, b_data};
+	columns[flag_slot] = (cel_column_t){CEL_COLUMN_BOOL, flag_data};
+	bool vectorized = false;
+
+	for (size_t e = 0; e < 2; e++) {
+		cel_program_t *program = compile_with_schema(expr, engines[e]);
+		cel_columnar_program_t *columnar = cel_columnar_compile(program);
+		TEST_ASSERT_NOT_NULL_MESSAGE(columnar, expr);
+		vectorized = cel_columnar_is_vectorized(columnar);
+
+		size_t selected = cel_columnar_select(columnar, ctx, columns,
+						      ROWS, selection);
+
+		size_t expected = 0;
+		for (size_t i = 0; i < ROWS; i++) {
+			if (!row_matches(program, i)) {
+				continue;
+			}
+			TEST_ASSERT_TRUE_MESSAGE(expected < selected, expr);
+			TEST_ASSERT_EQUAL_INT_MESSAGE(i, selection[expected], expr);
+			expected++;
+		}
+		TEST_ASSERT_EQUAL_INT_MESSAGE(expected, selected, expr);
+
+		cel_columnar_destroy(columnar);
+		cel_program_destroy(program);
+	}
+
+	return vectorized;
+}
+
+/* ========== 向量化测试 ========== */
+
+void test_vectorized_predicates(void)
+{
+	TEST_ASSERT_TRUE(assert_same_selection("a > 10 && b < 3.5"));
+	TEST_ASSERT_TRUE(assert_same_selection("a * 2 - 1 >= 7 || b == 0.0"));
+	TEST_ASSERT_TRUE(assert_same_selection("!flag || a % 3 == 0"));
+	TEST_ASSERT_TRUE(assert_same_selection("-a < -5 && flag != false"));
+}
+
+void test_mixed_numeric_types(void)
+{
+	/* int 与 double 比较按 double 进行，== 要求类型相同 */
+	TEST_ASSERT_TRUE(assert_same_selection("a + b > 12"));
+	TEST_ASSERT_TRUE(assert_same_selection("a < b"));
+	TEST_ASSERT_TRUE(assert_same_selection("a == b || a / 2.0 > 4.0"));
+}
+
+void test_non_bool_result_selects_nothing(void)
+{
+	assert_same_selection("a + 1");
+	assert_same_selection("a > 0 && a");
+}
+
+/* ========== 回退测试 ========== */
+
+void test_unsupported_nodes_run_row_by_row(void)
+{
+	TEST_ASSERT_FALSE(assert_same_selection("a > 10 && size(tag) == 3"));
+	TEST_ASSERT_FALSE(assert_same_selection("a > 0 ? b < 2.0 : flag"));
+	TEST_ASSERT_FALSE(assert_same_selection("tag == \"abc\" && b > 1.0"));
+}
+
+void test_errors_fall_back_per_chunk(void)
+{
+	/* a == 0 的行除零失败，其他行仍然正常选择 */
+	assert_same_selection("10 / a > 2");
+	assert_same_selection("b > 1.0 || 7 % a == 1");
+}
+
+void test_missing_column_uses_context(void)
+{
+	cel_program_t *program = compile_with_schema("a > 10 && flag",
+						     CEL_ENGINE_BYTECODE);
+	cel_columnar_program_t *columnar = cel_columnar_compile(program);
+	TEST_ASSERT_NOT_NULL(columnar);
+
+	cel_value_t flag = cel_value_bool(true);
+	cel_context_add_variable(ctx, "flag", &flag);
+
+	cel_column_t columns[3] = {{CEL_COLUMN_INT, NULL}};
+	columns[a_slot] = (cel_column_t){CEL_COLUMN_INT, a_data};
+	columns[b_slot] = (cel_column_t){CEL_COLUMN_DOUBLE, NULL};
+	columns[flag_slot] = (cel_column_t){CEL_COLUMN_BOOL, NULL};
+
+	size_t selected = cel_columnar_select(columnar, ctx, columns, ROWS,
+					      selection);
+	size_t expected = 0;
+	for (size_t i = 0; i < ROWS; i++) {
+		if (a_data[i] > 10) {
+			TEST_ASSERT_EQUAL_UINT32(i, selection[expected++]);
+		}
+	}
+	TEST_ASSERT_EQUAL_size_t(expected, selected);
+
+	cel_columnar_destroy(columnar);
+	cel_program_destroy(program);
+}
+
+void test_requires_schema(void)
+{
+	cel_compile_result_t result = cel_compile("1 > 0");
+	TEST_ASSERT_FALSE(result.has_errors);
+	TEST_ASSERT_NULL(cel_columnar_compile(result.program));
+	cel_compile_result_destroy(&result);
+
+	TEST_ASSERT_NOT_NULL(cel_columnar_simd_level());
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 向量化测试 */
+	RUN_TEST(test_vectorized_predicates);
+	RUN_TEST(test_mixed_numeric_types);
+	RUN_TEST(test_non_bool_result_selects_nothing);
+
+	/* 回退测试 */
+	RUN_TEST(test_unsupported_nodes_run_row_by_row);
+	RUN_TEST(test_errors_fall_back_per_chunk);
+	RUN_TEST(test_missing_column_uses_context);
+	RUN_TEST(test_requires_schema);
+
+	return UNITY_END();
+}
@@ -0,0 +1,517 @@
+/**
+ * @file test_compact.c
+ * @brief CEL 紧凑 AST 单元测试
+ *
+ * 以树遍历求值器为参考实现，对比紧凑 AST 求值的结果与错误。
+ */
+
+#include "cel/cel_compact.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_functions.h"
+#include "cel/cel_program.h"
+#include "cel/cel_serialize.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+
+	cel_value_t x = cel_value_int(42);
+	cel_value_t y = cel_value_int(10);
+	cel_value_t s = cel_value_string("hello");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "y", &y);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	/* l = [1, 2, 3] */
+	cel_list_t *list = cel_list_create(3);
+	for (int64_t i = 1; i <= 3; i++) {
+		cel_value_t v = cel_value_int(i);
+		cel_list_append(list, &v);
+	}
+	cel_value_t l = cel_value_list(list);
+	cel_context_add_variable(ctx, "l", &l);
+	cel_value_destroy(&l);
+
+	/* m = {"name": "cel", "age": 7} */
+	cel_map_t *map = cel_map_create(4);
+	cel_value_t k1 = cel_value_string("name");
+	cel_value_t v1 = cel_value_string("cel");
+	cel_value_t k2 = cel_value_string("age");
+	cel_value_t v2 = cel_value_int(7);
+	cel_map_put(map, &k1, &v1);
+	cel_map_put(map, &k2, &v2);
+	cel_value_destroy(&k1);
+	cel_value_destroy(&v1);
+	cel_value_destroy(&k2);
+	cel_value_t m = cel_value_map(map);
+	cel_context_add_variable(ctx, "m", &m);
+	cel_value_destroy(&m);
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_compile_result_t compile_compact(const char *expr)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = CEL_ENGINE_COMPACT;
+
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+	TEST_ASSERT_NOT_NULL_MESSAGE(compile.program->compact, expr);
+	TEST_ASSERT_NULL(compile.program->ast);
+	TEST_ASSERT_NULL(compile.program->ast_arena);
+	TEST_ASSERT_NULL(compile.program->bytecode);
+	return compile;
+}
+
+static cel_execute_result_t run_with_engine(const char *expr,
+					    cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = engine;
+
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	cel_compile_result_destroy(&compile);
+	return result;
+}
+
+/**
+ * @brief 两种求值器的结果、错误码、出错位置与代价必须一致
+ */
+static void assert_engines_agree(const char *expr)
+{
+	cel_execute_result_t tree = run_with_engine(expr, CEL_ENGINE_TREE_WALK);
+	cel_execute_result_t compact = run_with_engine(expr, CEL_ENGINE_COMPACT);
+
+	TEST_ASSERT_EQUAL_MESSAGE(tree.success, compact.success, expr);
+	TEST_ASSERT_TRUE_MESSAGE(tree.cost == compact.cost, expr);
+	if (tree.success) {
+		TEST_ASSERT_EQUAL_INT_MESSAGE(tree.value.type, compact.value.type,
+					      expr);
+		TEST_ASSERT_TRUE_MESSAGE(
+			cel_value_equals(&tree.value, &compact.value), expr);
+	} else {
+		const cel_eval_error_t *a = &tree.eval_error;
+		const cel_eval_error_t *b = &compact.eval_error;
+		TEST_ASSERT_EQUAL_INT_MESSAGE(a->code, b->code, expr);
+		TEST_ASSERT_TRUE_MESSAGE(strcmp(a->message, b->message) == 0, expr);
+		TEST_ASSERT_TRUE_MESSAGE(strcmp(a->detail, b->detail) == 0, expr);
+		TEST_ASSERT_TRUE_MESSAGE(a->line == b->line &&
+						 a->column == b->column, expr);
+	}
+
+	cel_execute_result_destroy(&tree);
+	cel_execute_result_destroy(&compact);
+}
+
+/**
+ * @brief 上下文函数: twice(n) = n * 2
+ */
+static cel_value_t twice_value;
+
+static cel_result_t fn_twice(cel_func_context_t *fctx, cel_value_t **args,
+			     size_t arg_count)
+{
+	(void)fctx;
+	(void)arg_count;
+	twice_value = cel_value_int(args[0]->value.int_value * 2);
+	return cel_ok_result(&twice_value);
+}
+
+static cel_ast_node_t *create_ident(const char *name)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_ident(name, strlen(name), loc);
+}
+
+static cel_ast_node_t *create_int(int64_t value)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_literal(cel_value_int(value), loc);
+}
+
+static cel_ast_node_t *create_binary(cel_binary_op_e op, cel_ast_node_t *left,
+				      cel_ast_node_t *right)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_binary(op, left, right, loc);
+}
+
+/**
+ * @brief 创建 @result + [element] 形式的循环步骤
+ */
+static cel_ast_node_t *create_append(cel_ast_node_t *element)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+	elements[0] = element;
+	return create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			     cel_ast_create_list(elements, 1, loc));
+}
+
+/**
+ * @brief 创建以 @result 为累加器、循环条件为 true 的推导式
+ */
+static cel_ast_node_t *create_fold(cel_ast_node_t *range, const char *var,
+				   const char *var2, cel_ast_node_t *init,
+				   cel_ast_node_t *step)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_comprehension(
+		var, strlen(var), var2, var2 ? strlen(var2) : 0, range,
+		"@result", 7, init,
+		cel_ast_create_literal(cel_value_bool(true), loc), step,
+		create_ident("@result"), loc);
+}
+
+/**
+ * @brief 转换 AST，对比紧凑 AST 与树遍历的结果并返回结果
+ */
+static cel_value_t eval_both(const cel_ast_node_t *ast, bool expect_success)
+{
+	cel_compact_ast_t *compact = cel_compact_ast_build(ast);
+	TEST_ASSERT_NOT_NULL(compact);
+
+	cel_value_t tree_result = cel_value_null();
+	cel_value_t compact_result = cel_value_null();
+	TEST_ASSERT_EQUAL(expect_success, cel_eval(ast, ctx, &tree_result));
+	TEST_ASSERT_EQUAL(expect_success,
+			  cel_compact_eval(compact, ctx, &compact_result));
+	if (expect_success) {
+		TEST_ASSERT_TRUE(cel_value_equals(&tree_result, &compact_result));
+	}
+
+	cel_value_destroy(&tree_result);
+	cel_compact_ast_destroy(compact);
+	return compact_result;
+}
+
+/* ========== 布局测试 ========== */
+
+void test_node_layout(void)
+{
+	TEST_ASSERT_EQUAL_size_t(16, sizeof(cel_compact_node_t));
+
+	/* 前序: + (0), x (1), * (2), y (3), 2 (4) */
+	cel_compile_result_t compile = compile_compact("x + y * 2");
+	const cel_compact_ast_t *ast = compile.program->compact;
+	TEST_ASSERT_EQUAL_UINT32(5, ast->node_count);
+	TEST_ASSERT_EQUAL_UINT32(0, ast->child_count);
+	TEST_ASSERT_EQUAL_UINT32(1, ast->value_count);
+
+	const cel_compact_node_t *root = &ast->nodes[0];
+	TEST_ASSERT_EQUAL_INT(CEL_AST_BINARY, root->type);
+	TEST_ASSERT_EQUAL_INT(CEL_BINARY_ADD, root->op);
+	TEST_ASSERT_EQUAL_UINT32(1, root->a);
+	TEST_ASSERT_EQUAL_UINT32(2, root->b);
+	TEST_ASSERT_EQUAL_STRING("x", ast->names + ast->nodes[1].a);
+	TEST_ASSERT_EQUAL_UINT32(3, ast->nodes[2].a);
+	TEST_ASSERT_EQUAL_UINT32(4, ast->nodes[2].b);
+	TEST_ASSERT_EQUAL_INT64(2, ast->values[ast->nodes[4].a].value.int_value);
+
+	/* 位置在旁表中 */
+	TEST_ASSERT_EQUAL_UINT32(1, ast->locs[3].line);
+	TEST_ASSERT_EQUAL_UINT32(5, ast->locs[3].column);
+
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(62, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+	cel_compile_result_destroy(&compile);
+}
+
+void test_names_and_calls(void)
+{
+	/* 名称去重，字段名转换为字符串值 */
+	cel_compile_result_t compile = compile_compact("x + x * x + m.age");
+	const cel_compact_ast_t *ast = compile.program->compact;
+	TEST_ASSERT_EQUAL_UINT32(4, ast->names_length);  /* "x\0m\0" */
+	TEST_ASSERT_EQUAL_UINT32(1, ast->value_count);
+	TEST_ASSERT_EQUAL_INT(CEL_TYPE_STRING, ast->values[0].type);
+	cel_compile_result_destroy(&compile);
+
+	/* 内置函数转换为重载编号，其余按名称调用 */
+	compile = compile_compact("s.size() + twice(x)");
+	ast = compile.program->compact;
+	TEST_ASSERT_EQUAL_UINT32(2, ast->child_count);
+	const cel_compact_node_t *size_call = &ast->nodes[1];
+	TEST_ASSERT_EQUAL_INT(CEL_AST_CALL, size_call->type);
+	TEST_ASSERT_TRUE(size_call->flags & CEL_COMPACT_BUILTIN);
+	TEST_ASSERT_EQUAL_UINT32(CEL_FUNC_SIZE, size_call->c);
+	TEST_ASSERT_EQUAL_UINT32(1, size_call->b);
+	const cel_compact_node_t *twice_call = &ast->nodes[3];
+	TEST_ASSERT_FALSE(twice_call->flags & CEL_COMPACT_BUILTIN);
+	TEST_ASSERT_EQUAL_STRING("twice", ast->names + twice_call->c);
+	cel_compile_result_destroy(&compile);
+}
+
+void test_unsupported_node(void)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *ast = cel_ast_create_struct("Msg", 3, NULL, 0, loc);
+	TEST_ASSERT_NULL(cel_compact_ast_build(NULL));
+
+	cel_value_t result = eval_both(ast, false);
+	cel_value_destroy(&result);
+	cel_ast_destroy(ast);
+}
+
+/* ========== 求值一致性测试 ========== */
+
+void test_engines_agree_arithmetic(void)
+{
+	assert_engines_agree("1 + 2 * 3 - 4 / 2");
+	assert_engines_agree("x % 5 + -y");
+	assert_engines_agree("x < y || x >= 42");
+	assert_engines_agree("x == 42 && y != 10");
+	assert_engines_agree("!(x > y)");
+	assert_engines_agree("x / 0");
+	assert_engines_agree("\"a\" + s");
+	assert_engines_agree("[1, 2] + [3]");
+}
+
+void test_engines_agree_access(void)
+{
+	assert_engines_agree("m.name");
+	assert_engines_agree("m.age + l[2]");
+	assert_engines_agree("m[\"age\"]");
+	assert_engines_agree("m.missing");
+	assert_engines_agree("l[5]");
+	assert_engines_agree("2 in l");
+	assert_engines_agree("{\"k\": [x, y]}.k[1]");
+	assert_engines_agree("[[1, 2], [3, 4]][1][0]");
+	assert_engines_agree("x.field");
+}
+
+void test_engines_agree_calls(void)
+{
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_context_add_function(ctx, "twice", fn_twice, 1, 1));
+
+	assert_engines_agree("size(s) + size(l)");
+	assert_engines_agree("s.startsWith(\"he\") && s.endsWith(\"lo\")");
+	assert_engines_agree("string(x) + s");
+	assert_engines_agree("twice(y) + twice(twice(1))");
+	assert_engines_agree("size(s, 1)");
+	assert_engines_agree("nope(1)");
+}
+
+void test_engines_agree_control_flow(void)
+{
+	assert_engines_agree("x > 0 ? \"pos\" : \"neg\"");
+	assert_engines_agree("x < 0 ? 1 : y > 5 ? 2 : 3");
+	assert_engines_agree("x ? 1 : 2");
+	assert_engines_agree("false && undefined_var");
+	assert_engines_agree("true || undefined_var");
+	assert_engines_agree("true && undefined_var");
+	assert_engines_agree("true && 1");
+	assert_engines_agree("1 || true");
+}
+
+void test_error_location(void)
+{
+	cel_compile_result_t compile = compile_compact("x +\n  undefined_var");
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	TEST_ASSERT_FALSE(result.success);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_UNKNOWN_IDENTIFIER, result.eval_error.code);
+	TEST_ASSERT_EQUAL_STRING("undefined_var", result.eval_error.detail);
+	TEST_ASSERT_EQUAL_size_t(2, result.eval_error.line);
+	TEST_ASSERT_EQUAL_size_t(3, result.eval_error.column);
+	cel_execute_result_destroy(&result);
+	cel_compile_result_destroy(&compile);
+
+	assert_engines_agree("x +\n  undefined_var");
+	assert_engines_agree("[1, 2,\n m.missing]");
+}
+
+/* ========== 推导式测试 ========== */
+
+void test_comprehension_map_and_filter(void)
+{
+	cel_token_location_t loc = {0};
+
+	/* l.map(v, v * 10) => [10, 20, 30] */
+	cel_ast_node_t *ast = create_fold(
+		create_ident("l"), "v", NULL, cel_ast_create_list(NULL, 0, loc),
+		create_append(create_binary(CEL_BINARY_MUL, create_ident("v"),
+					    create_int(10))));
+	cel_value_t result = eval_both(ast, true);
+	TEST_ASSERT_EQUAL_size_t(3, cel_list_size(result.value.list_value));
+	TEST_ASSERT_EQUAL_INT64(30, cel_list_get(result.value.list_value, 2)
+					    ->value.int_value);
+	cel_value_destroy(&result);
+	cel_ast_destroy(ast);
+
+	/* l.filter(v, v > 1) => [2, 3] */
+	ast = create_fold(
+		create_ident("l"), "v", NULL, cel_ast_create_list(NULL, 0, loc),
+		cel_ast_create_ternary(
+			create_binary(CEL_BINARY_GT, create_ident("v"),
+				      create_int(1)),
+			create_append(create_ident("v")),
+			create_ident("@result"), loc));
+	result = eval_both(ast, true);
+	TEST_ASSERT_EQUAL_size_t(2, cel_list_size(result.value.list_value));
+	cel_value_destroy(&result);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_scopes(void)
+{
+	cel_token_location_t loc = {0};
+
+	/* l.map(x, l.map(w, w * x))：循环变量 x 遮蔽上下文变量 x */
+	cel_ast_node_t *inner = create_fold(
+		create_ident("l"), "w", NULL, cel_ast_create_list(NULL, 0, loc),
+		create_append(create_binary(CEL_BINARY_MUL, create_ident("w"),
+					    create_ident("x"))));
+	cel_ast_node_t *ast = create_fold(
+		create_ident("l"), "x", NULL, cel_ast_create_list(NULL, 0, loc),
+		create_append(inner));
+	cel_value_t result = eval_both(ast, true);
+	cel_value_t *row = cel_list_get(result.value.list_value, 2);
+	TEST_ASSERT_EQUAL_INT64(9, cel_list_get(row->value.list_value, 2)
+					   ->value.int_value);
+	cel_value_destroy(&result);
+	cel_ast_destroy(ast);
+
+	/* Map 的双变量形式: 值之和 */
+	ast = create_fold(create_ident("m"), "k", "v", create_int(0),
+			  cel_ast_create_ternary(
+				  create_binary(CEL_BINARY_EQ, create_ident("k"),
+						cel_ast_create_literal(
+							cel_value_string("age"),
+							loc)),
+				  create_binary(CEL_BINARY_ADD,
+						create_ident("@result"),
+						create_ident("v")),
+				  create_ident("@result"), loc));
+	result = eval_both(ast, true);
+	TEST_ASSERT_EQUAL_INT64(7, result.value.int_value);
+	cel_ast_destroy(ast);
+
+	/* 列表的双变量形式: sum(i * v) = 0 * 1 + 1 * 2 + 2 * 3 */
+	ast = create_fold(create_ident("l"), "i", "v", create_int(0),
+			  create_binary(CEL_BINARY_ADD, create_ident("@result"),
+					create_binary(CEL_BINARY_MUL,
+						      create_ident("i"),
+						      create_ident("v"))));
+	result = eval_both(ast, true);
+	TEST_ASSERT_EQUAL_INT64(8, result.value.int_value);
+	cel_ast_destroy(ast);
+
+	/* 迭代范围不是列表或 Map */
+	ast = create_fold(create_ident("x"), "v", NULL, create_int(0),
+			  create_ident("v"));
+	result = eval_both(ast, false);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_budget(void)
+{
+	cel_token_location_t loc = {0};
+
+	/* l.map(v, l.map(w, w * v))：外层 3 次迭代，内层共 9 次 */
+	cel_ast_node_t *inner = create_fold(
+		create_ident("l"), "w", NULL, cel_ast_create_list(NULL, 0, loc),
+		create_append(create_binary(CEL_BINARY_MUL, create_ident("w"),
+					    create_ident("v"))));
+	cel_ast_node_t *ast = create_fold(
+		create_ident("l"), "v", NULL, cel_ast_create_list(NULL, 0, loc),
+		create_append(inner));
+	cel_compact_ast_t *compact = cel_compact_ast_build(ast);
+
+	cel_exec_budget_t budget;
+	cel_value_t result;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_compact_eval(compact, ctx, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_EQUAL_UINT64(12 * CEL_COST_ITERATION, budget.cost);
+	cel_value_destroy(&result);
+
+	previous = cel_exec_budget_enter(&budget, 5, 0);
+	TEST_ASSERT_FALSE(cel_compact_eval(compact, ctx, &result));
+	cel_exec_budget_leave(previous);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_COST_LIMIT, budget.exhausted);
+
+	cel_compact_ast_destroy(compact);
+	cel_ast_destroy(ast);
+}
+
+/* ========== 程序测试 ========== */
+
+void test_program_without_ast(void)
+{
+	cel_compile_result_t compile = compile_compact("x * 2");
+
+	/* 程序只保留紧凑 AST，需要 AST 的接口不接受 */
+	TEST_ASSERT_EQUAL_size_t(0, cel_program_serialize(compile.program,
+							  NULL, 0));
+	TEST_ASSERT_NULL(cel_partial_eval(compile.program, ctx));
+
+	/* 结果不引用程序 */
+	cel_compile_result_t literal = compile_compact("\"literal\"");
+	cel_execute_result_t result = cel_execute(literal.program, ctx);
+	cel_compile_result_destroy(&literal);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_STRING("literal", result.value.value.string_value->data);
+	cel_execute_result_destroy(&result);
+
+	for (int i = 0; i < 3; i++) {
+		result = cel_execute(compile.program, ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT64(84, result.value.value.int_value);
+		cel_execute_result_destroy(&result);
+	}
+	cel_compile_result_destroy(&compile);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 布局测试 */
+	RUN_TEST(test_node_layout);
+	RUN_TEST(test_names_and_calls);
+	RUN_TEST(test_unsupported_node);
+
+	/* 求值一致性测试 */
+	RUN_TEST(test_engines_agree_arithmetic);
+	RUN_TEST(test_engines_agree_access);
+	RUN_TEST(test_engines_agree_calls);
+	RUN_TEST(test_engines_agree_control_flow);
+	RUN_TEST(test_error_location);
+
+	/* 推导式测试 */
+	RUN_TEST(test_comprehension_map_and_filter);
+	RUN_TEST(test_comprehension_scopes);
+	RUN_TEST(test_comprehension_budget);
+
+	/* 程序测试 */
+	RUN_TEST(test_program_without_ast);
+
+	return UNITY_END();
+}
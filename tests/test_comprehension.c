@@ -8,6 +8,7 @@
 #include "cel/cel_value.h"
 #include "cel/cel_context.h"
 #include "unity.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -566,6 +567,309 @@ void test_comprehension_invalid_iter_range(void)
 	cel_ast_destroy(comp);
 }
 
+/* ========== 变量作用域测试 ========== */
+
+/**
+ * @brief 创建 range 上的求和推导式: range.fold(var, accu = 0, accu + var)
+ */
+static cel_ast_node_t *create_sum(cel_ast_node_t *range, const char *var,
+				  const char *accu)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_comprehension(
+		var, strlen(var),
+		NULL, 0,
+		range,
+		accu, strlen(accu),
+		create_int(0),
+		create_bool(true),
+		create_binary(CEL_BINARY_ADD, create_ident(accu), create_ident(var)),
+		create_ident(accu),
+		loc);
+}
+
+void test_comprehension_nested_shadowing(void)
+{
+	/* 外层: mylist 上求和 (inner * x)，inner 与外层使用相同的变量名 */
+	int64_t values[] = {1, 2, 3};
+	cel_value_t *list_val = create_list_value(values, 3);
+	add_binding(ctx, "mylist", list_val);
+
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *inner = create_sum(create_ident("mylist"), "x", "@result");
+	cel_ast_node_t *comp = cel_ast_create_comprehension(
+		"x", 1,
+		NULL, 0,
+		create_ident("mylist"),
+		"@result", 7,
+		create_int(0),
+		create_bool(true),
+		/* inner 求值结束后 x 与 @result 恢复为外层的绑定 */
+		create_binary(CEL_BINARY_ADD,
+			      create_binary(CEL_BINARY_MUL, inner, create_ident("x")),
+			      create_ident("@result")),
+		create_ident("@result"),
+		loc);
+
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(comp, ctx, &result));
+	TEST_ASSERT_EQUAL_INT(CEL_TYPE_INT, result.type);
+	TEST_ASSERT_EQUAL_INT64(6 * (1 + 2 + 3), result.value.int_value);
+
+	cel_ast_destroy(comp);
+	cel_value_destroy(list_val);
+	free(list_val);
+}
+
+void test_comprehension_iter_var_scope(void)
+{
+	/* 结果表达式中循环变量不可见，同名的上下文变量不受影响 */
+	int64_t values[] = {1, 2, 3};
+	cel_value_t *list_val = create_list_value(values, 3);
+	add_binding(ctx, "mylist", list_val);
+	cel_value_t outer = cel_value_int(100);
+	add_binding(ctx, "x", &outer);
+
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *comp = cel_ast_create_comprehension(
+		"x", 1,
+		NULL, 0,
+		create_ident("mylist"),
+		"@result", 7,
+		create_int(0),
+		create_bool(true),
+		create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			      create_ident("x")),
+		create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			      create_ident("x")),
+		loc);
+
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(comp, ctx, &result));
+	TEST_ASSERT_EQUAL_INT64(6 + 100, result.value.int_value);
+
+	cel_ast_node_t *x = create_ident("x");
+	TEST_ASSERT_TRUE(cel_eval(x, ctx, &result));
+	TEST_ASSERT_EQUAL_INT64(100, result.value.int_value);
+
+	cel_ast_destroy(x);
+	cel_ast_destroy(comp);
+	cel_value_destroy(list_val);
+	free(list_val);
+}
+
+void test_comprehension_large_list(void)
+{
+	/* 10000 个元素: all(x, x >= 0) 与求和 */
+	enum { COUNT = 10000 };
+	int64_t *values = malloc(sizeof(int64_t) * COUNT);
+	for (int64_t i = 0; i < COUNT; i++) {
+		values[i] = i;
+	}
+	cel_value_t *list_val = create_list_value(values, COUNT);
+	add_binding(ctx, "mylist", list_val);
+	free(values);
+
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *all = cel_ast_create_comprehension(
+		"x", 1,
+		NULL, 0,
+		create_ident("mylist"),
+		"@result", 7,
+		create_bool(true),
+		create_ident("@result"),
+		create_binary(CEL_BINARY_AND, create_ident("@result"),
+			      create_binary(CEL_BINARY_GE, create_ident("x"),
+					    create_int(0))),
+		create_ident("@result"),
+		loc);
+
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(all, ctx, &result));
+	TEST_ASSERT_TRUE(result.value.bool_value);
+
+	cel_ast_node_t *sum = create_sum(create_ident("mylist"), "x", "@result");
+	TEST_ASSERT_TRUE(cel_eval(sum, ctx, &result));
+	TEST_ASSERT_EQUAL_INT64((int64_t)COUNT * (COUNT - 1) / 2,
+				result.value.int_value);
+
+	cel_ast_destroy(sum);
+	cel_ast_destroy(all);
+	cel_value_destroy(list_val);
+	free(list_val);
+}
+
+/* ========== Map 推导式测试 ========== */
+
+/**
+ * @brief 创建 {"k0": 0, "k1": 1, ...} 并绑定到上下文的 labels
+ */
+static void bind_label_map(size_t count)
+{
+	cel_map_t *map = cel_map_create(count);
+	for (size_t i = 0; i < count; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "k%zu", i);
+		cel_value_t key = cel_value_string(name);
+		cel_value_t value = cel_value_int((int64_t)i);
+		cel_map_put(map, &key, &value);
+		cel_value_destroy(&key);
+	}
+	cel_value_t map_val = cel_value_map(map);
+	add_binding(ctx, "labels", &map_val);
+	cel_value_destroy(&map_val);
+}
+
+static cel_ast_node_t *create_string(const char *value)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_literal(cel_value_string(value), loc);
+}
+
+/**
+ * @brief 创建 labels.exists(k, k == key)
+ */
+static cel_ast_node_t *create_key_exists(const char *key)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_comprehension(
+		"k", 1,
+		NULL, 0,
+		create_ident("labels"),
+		"@result", 7,
+		create_bool(false),
+		cel_ast_create_unary(CEL_UNARY_NOT, create_ident("@result"), loc),
+		create_binary(CEL_BINARY_OR, create_ident("@result"),
+			      create_binary(CEL_BINARY_EQ, create_ident("k"),
+					    create_string(key))),
+		create_ident("@result"),
+		loc);
+}
+
+void test_comprehension_map_keys(void)
+{
+	bind_label_map(100);
+
+	cel_ast_node_t *found = create_key_exists("k42");
+	cel_ast_node_t *missing = create_key_exists("k100");
+
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(found, ctx, &result));
+	TEST_ASSERT_TRUE(result.value.bool_value);
+	TEST_ASSERT_TRUE(cel_eval(missing, ctx, &result));
+	TEST_ASSERT_FALSE(result.value.bool_value);
+
+	cel_ast_destroy(found);
+	cel_ast_destroy(missing);
+}
+
+void test_comprehension_map_key_value(void)
+{
+	bind_label_map(100);
+
+	/* labels.all(k, v, v >= 0 && v < 100) */
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *all = cel_ast_create_comprehension(
+		"k", 1,
+		"v", 1,
+		create_ident("labels"),
+		"@result", 7,
+		create_bool(true),
+		create_ident("@result"),
+		create_binary(CEL_BINARY_AND, create_ident("@result"),
+			      create_binary(CEL_BINARY_AND,
+					    create_binary(CEL_BINARY_GE,
+							  create_ident("v"),
+							  create_int(0)),
+					    create_binary(CEL_BINARY_LT,
+							  create_ident("v"),
+							  create_int(100)))),
+		create_ident("@result"),
+		loc);
+
+	/* 对值求和: 0 + 1 + ... + 99 */
+	cel_ast_node_t *sum = cel_ast_create_comprehension(
+		"k", 1,
+		"v", 1,
+		create_ident("labels"),
+		"@result", 7,
+		create_int(0),
+		create_bool(true),
+		create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			      create_ident("v")),
+		create_ident("@result"),
+		loc);
+
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(all, ctx, &result));
+	TEST_ASSERT_TRUE(result.value.bool_value);
+	TEST_ASSERT_TRUE(cel_eval(sum, ctx, &result));
+	TEST_ASSERT_EQUAL_INT64(4950, result.value.int_value);
+
+	cel_ast_destroy(all);
+	cel_ast_destroy(sum);
+}
+
+void test_comprehension_map_early_stop(void)
+{
+	bind_label_map(1000);
+
+	/* exists(k, true): 第一次迭代后结果为 true，第二次迭代检查条件时停止 */
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *comp = cel_ast_create_comprehension(
+		"k", 1,
+		NULL, 0,
+		create_ident("labels"),
+		"@result", 7,
+		create_bool(false),
+		cel_ast_create_unary(CEL_UNARY_NOT, create_ident("@result"), loc),
+		create_binary(CEL_BINARY_OR, create_ident("@result"),
+			      create_bool(true)),
+		create_ident("@result"),
+		loc);
+
+	cel_exec_budget_t budget;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(comp, ctx, &result));
+	cel_exec_budget_leave(previous);
+
+	TEST_ASSERT_TRUE(result.value.bool_value);
+	TEST_ASSERT_EQUAL_UINT64(2 * CEL_COST_ITERATION, budget.cost);
+
+	cel_ast_destroy(comp);
+}
+
+void test_comprehension_list_index_value(void)
+{
+	/* [10, 20, 30] 的双变量形式: sum(i * v) = 0 * 10 + 1 * 20 + 2 * 30 */
+	int64_t values[] = {10, 20, 30};
+	cel_value_t *list_val = create_list_value(values, 3);
+	add_binding(ctx, "mylist", list_val);
+
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *comp = cel_ast_create_comprehension(
+		"i", 1,
+		"v", 1,
+		create_ident("mylist"),
+		"@result", 7,
+		create_int(0),
+		create_bool(true),
+		create_binary(CEL_BINARY_ADD, create_ident("@result"),
+			      create_binary(CEL_BINARY_MUL, create_ident("i"),
+					    create_ident("v"))),
+		create_ident("@result"),
+		loc);
+
+	cel_value_t result;
+	TEST_ASSERT_TRUE(cel_eval(comp, ctx, &result));
+	TEST_ASSERT_EQUAL_INT64(80, result.value.int_value);
+
+	cel_ast_destroy(comp);
+	cel_value_destroy(list_val);
+	free(list_val);
+}
+
 /* ========== Main 测试运行器 ========== */
 
 int main(void)
@@ -597,5 +901,16 @@ int main(void)
 	/* 错误处理测试 */
 	RUN_TEST(test_comprehension_invalid_iter_range);
 
+	/* 变量作用域测试 */
+	RUN_TEST(test_comprehension_nested_shadowing);
+	RUN_TEST(test_comprehension_iter_var_scope);
+	RUN_TEST(test_comprehension_large_list);
+
+	/* Map 推导式测试 */
+	RUN_TEST(test_comprehension_map_keys);
+	RUN_TEST(test_comprehension_map_key_value);
+	RUN_TEST(test_comprehension_map_early_stop);
+	RUN_TEST(test_comprehension_list_index_value);
+
 	return UNITY_END();
 }
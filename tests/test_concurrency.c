@@ -0,0 +1,182 @@
+/**
+ * @file test_concurrency.c
+ * @brief CEL 程序并发执行测试
+ *
+ * 多个线程共享同一程序与上下文，各自使用自己的执行状态与激活记录。
+ */
+
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define THREADS 8
+#define ITERATIONS 2000
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static cel_schema_t *schema = NULL;
+static size_t x_slot, name_slot;
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+
+	/* 共享的引用计数值: 执行时被所有线程读取 */
+	cel_value_t prefix = cel_value_string("user-");
+	cel_context_add_variable(ctx, "prefix", &prefix);
+	cel_value_destroy(&prefix);
+
+	cel_list_t *limits = cel_list_create(3);
+	for (int64_t i = 1; i <= 3; i++) {
+		cel_value_t limit = cel_value_int(i * 100);
+		cel_list_append(limits, &limit);
+	}
+	cel_value_t value = cel_value_list(limits);
+	cel_context_add_variable(ctx, "limits", &value);
+	cel_value_destroy(&value);
+
+	schema = cel_schema_create();
+	TEST_ASSERT_NOT_NULL(schema);
+	cel_schema_add_variable(schema, "x", &x_slot);
+	cel_schema_add_variable(schema, "name", &name_slot);
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+	cel_schema_destroy(schema);
+	schema = NULL;
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_program_t *compile_with_schema(const char *expr, cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	options.engine = engine;
+
+	cel_compile_result_t result = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(result.has_errors, expr);
+
+	cel_program_t *program = result.program;
+	result.program = NULL;
+	cel_compile_result_destroy(&result);
+	return program;
+}
+
+/**
+ * @brief 工作线程参数
+ */
+typedef struct {
+	const cel_program_t *program;
+	int64_t seed;
+	size_t failures;
+} worker_t;
+
+/**
+ * @brief 期望结果: x > limits[x % 3] && name.startsWith(prefix) ? x * 2 : -x
+ */
+static int64_t expected_value(int64_t x)
+{
+	return x > (x % 3 + 1) * 100 ? x * 2 : -x;
+}
+
+static void *worker_main(void *arg)
+{
+	worker_t *worker = arg;
+	cel_exec_state_t *state = cel_exec_state_create();
+	cel_activation_t *activation = cel_activation_create(schema);
+	cel_value_t name = cel_value_string("user-42");
+	cel_activation_set(activation, name_slot, &name);
+	cel_value_destroy(&name);
+
+	for (int64_t i = 0; i < ITERATIONS; i++) {
+		int64_t x = (worker->seed * 7919 + i * 31) % 400;
+		cel_value_t vx = cel_value_int(x);
+		cel_activation_set(activation, x_slot, &vx);
+
+		cel_execute_result_t result = cel_execute_with_state(
+			worker->program, ctx, activation, state);
+		if (!result.success || result.value.type != CEL_TYPE_INT ||
+		    result.value.value.int_value != expected_value(x)) {
+			worker->failures++;
+		}
+		cel_execute_result_destroy(&result);
+	}
+
+	cel_activation_destroy(activation);
+	cel_exec_state_destroy(state);
+	return NULL;
+}
+
+static void run_workers(cel_engine_e engine)
+{
+	cel_program_t *program = compile_with_schema(
+		"x > limits[x % 3] && name.startsWith(prefix) ? x * 2 : -x", engine);
+
+	pthread_t threads[THREADS];
+	worker_t workers[THREADS];
+	for (int i = 0; i < THREADS; i++) {
+		workers[i] = (worker_t){program, i, 0};
+		TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL,
+							worker_main, &workers[i]));
+	}
+	for (int i = 0; i < THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		TEST_ASSERT_EQUAL_INT(0, (int)workers[i].failures);
+	}
+
+	cel_program_destroy(program);
+}
+
+/* ========== 并发测试 ========== */
+
+void test_shared_program_bytecode(void)
+{
+	run_workers(CEL_ENGINE_BYTECODE);
+}
+
+void test_shared_program_tree_walk(void)
+{
+	run_workers(CEL_ENGINE_TREE_WALK);
+}
+
+void test_shared_values_survive(void)
+{
+	cel_value_t *prefix = cel_context_get_variable(ctx, "prefix");
+	cel_value_t *limits = cel_context_get_variable(ctx, "limits");
+	TEST_ASSERT_NOT_NULL(prefix);
+	TEST_ASSERT_NOT_NULL(limits);
+	int prefix_refs = prefix->value.string_value->ref_count;
+	int limits_refs = limits->value.list_value->ref_count;
+
+	run_workers(CEL_ENGINE_BYTECODE);
+
+	/* 所有线程结束后共享值的引用计数回到原值 */
+	TEST_ASSERT_EQUAL_INT(prefix_refs, prefix->value.string_value->ref_count);
+	TEST_ASSERT_EQUAL_INT(limits_refs, limits->value.list_value->ref_count);
+	TEST_ASSERT_EQUAL_STRING("user-", prefix->value.string_value->data);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 并发测试 */
+	RUN_TEST(test_shared_program_bytecode);
+	RUN_TEST(test_shared_program_tree_walk);
+	RUN_TEST(test_shared_values_survive);
+
+	return UNITY_END();
+}
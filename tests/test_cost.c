@@ -0,0 +1,390 @@
+/**
+ * @file test_cost.c
+ * @brief CEL 静态代价估算单元测试
+ */
+
+#include "cel/cel_cost.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "cel/cel_bytecode.h"
+#include "cel/cel_eval.h"
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+
+static void set_string(const char *name, size_t length)
+{
+	char *text = malloc(length + 1);
+	memset(text, 'a', length);
+	text[length] = '\0';
+	cel_value_t value = cel_value_string(text);
+	cel_context_add_variable(ctx, name, &value);
+	cel_value_destroy(&value);
+	free(text);
+}
+
+static void set_list(const char *name, size_t length)
+{
+	cel_list_t *list = cel_list_create(length);
+	for (size_t i = 0; i < length; i++) {
+		cel_value_t element = cel_value_int((int64_t)i);
+		cel_list_append(list, &element);
+	}
+	cel_value_t value = cel_value_list(list);
+	cel_context_add_variable(ctx, name, &value);
+	cel_value_destroy(&value);
+}
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_cost_estimate_t estimate(const char *expr,
+				    const cel_cost_options_t *options)
+{
+	cel_compile_result_t compile = cel_compile(expr);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+
+	cel_cost_estimate_t result;
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_program_estimate_cost(compile.program,
+								 options, &result));
+	cel_compile_result_destroy(&compile);
+	return result;
+}
+
+/**
+ * @brief 检查两种引擎的实际代价都落在估算区间内
+ */
+static void assert_within(const char *expr, const cel_cost_options_t *options)
+{
+	cel_cost_estimate_t bound = estimate(expr, options);
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		cel_compile_options_t compile_options = cel_default_compile_options();
+		compile_options.engine = engines[e];
+		cel_compile_result_t compile =
+			cel_compile_with_options(expr, &compile_options);
+		TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+
+		cel_execute_result_t result = cel_execute(compile.program, ctx);
+		TEST_ASSERT_TRUE_MESSAGE(result.success, expr);
+		TEST_ASSERT_TRUE_MESSAGE(result.cost >= bound.min, expr);
+		TEST_ASSERT_TRUE_MESSAGE(result.cost <= bound.max, expr);
+
+		cel_execute_result_destroy(&result);
+		cel_compile_result_destroy(&compile);
+	}
+}
+
+static cel_ast_node_t *create_ident(const char *name)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_ident(name, strlen(name), loc);
+}
+
+static cel_ast_node_t *create_size_call(cel_ast_node_t *arg)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t **args = malloc(sizeof(cel_ast_node_t *));
+	args[0] = arg;
+	return cel_ast_create_call("size", 4, NULL, args, 1, loc);
+}
+
+/**
+ * @brief 创建 range.map(var, element) 形式的推导式 (range 为任意表达式)
+ */
+static cel_ast_node_t *create_map_over(cel_ast_node_t *range, const char *var,
+				       cel_ast_node_t *element)
+{
+	cel_token_location_t loc = {0};
+
+	cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+	elements[0] = element;
+
+	return cel_ast_create_comprehension(
+		var, strlen(var),
+		NULL, 0,
+		range,
+		"@result", 7,
+		cel_ast_create_list(NULL, 0, loc),
+		cel_ast_create_literal(cel_value_bool(true), loc),
+		cel_ast_create_binary(CEL_BINARY_ADD, create_ident("@result"),
+				      cel_ast_create_list(elements, 1, loc), loc),
+		create_ident("@result"),
+		loc);
+}
+
+/**
+ * @brief 创建 range.map(var, element) 形式的推导式
+ */
+static cel_ast_node_t *create_map_comprehension(const char *range,
+						const char *var,
+						cel_ast_node_t *element)
+{
+	return create_map_over(create_ident(range), var, element);
+}
+
+/**
+ * @brief 估算手工构造的 AST，并检查两种引擎的实际代价
+ */
+static cel_cost_estimate_t estimate_ast(cel_ast_node_t *ast,
+					const cel_cost_options_t *options)
+{
+	cel_program_t program = {.ast = ast};
+	cel_cost_estimate_t bound;
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_program_estimate_cost(&program, options, &bound));
+
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+
+	cel_exec_budget_t budget;
+	cel_value_t value;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &value));
+	cel_exec_budget_leave(previous);
+	cel_value_destroy(&value);
+	TEST_ASSERT_TRUE(budget.cost >= bound.min && budget.cost <= bound.max);
+
+	uint64_t vm_cost = budget.cost;
+	previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_eval(ast, ctx, &value));
+	cel_exec_budget_leave(previous);
+	cel_value_destroy(&value);
+	TEST_ASSERT_EQUAL_UINT64(vm_cost, budget.cost);
+
+	cel_bytecode_destroy(bc);
+	return bound;
+}
+
+/* ========== 基本估算测试 ========== */
+
+void test_call_free_expression(void)
+{
+	cel_cost_estimate_t bound = estimate("1 + 2 * x > y ? x : -y", NULL);
+	TEST_ASSERT_EQUAL_UINT64(0, bound.min);
+	TEST_ASSERT_EQUAL_UINT64(0, bound.max);
+}
+
+void test_invalid_arguments(void)
+{
+	cel_cost_estimate_t bound;
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT,
+			      cel_program_estimate_cost(NULL, NULL, &bound));
+
+	cel_compile_result_t compile = cel_compile("1");
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT,
+			      cel_program_estimate_cost(compile.program, NULL, NULL));
+	cel_compile_result_destroy(&compile);
+}
+
+void test_undeclared_input_is_unbounded(void)
+{
+	cel_cost_estimate_t bound = estimate("size(s) > 3", NULL);
+	TEST_ASSERT_EQUAL_UINT64(CEL_COST_CALL, bound.min);
+	TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, bound.max);
+
+	cel_cost_options_t options = cel_default_cost_options();
+	options.default_max_size = 128;
+	bound = estimate("size(s) > 3", &options);
+	TEST_ASSERT_EQUAL_UINT64(CEL_COST_CALL + 128 / CEL_COST_SIZE_UNIT, bound.max);
+}
+
+/* ========== 字符串函数测试 ========== */
+
+void test_string_cost_scales_with_declared_length(void)
+{
+	const char *expr = "s.startsWith(\"ab\") && size(s) > 3";
+	cel_size_hint_t hints[] = {{"s", 640}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 1;
+
+	/* startsWith: 1 + (640 + 2) / 64，size: 1 + 640 / 64；&& 可能短路 */
+	cel_cost_estimate_t bound = estimate(expr, &options);
+	TEST_ASSERT_EQUAL_UINT64(1, bound.min);
+	TEST_ASSERT_EQUAL_UINT64(11 + 11, bound.max);
+
+	hints[0].max_size = 64;
+	bound = estimate(expr, &options);
+	TEST_ASSERT_EQUAL_UINT64(2 + 2, bound.max);
+
+	set_string("s", 640);
+	hints[0].max_size = 640;
+	assert_within(expr, &options);
+	assert_within("s.endsWith(\"a\") || s.contains(\"b\")", &options);
+}
+
+void test_field_path_hint(void)
+{
+	cel_size_hint_t hints[] = {{"request.path", 128}, {"request", 4}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 2;
+
+	/* 字段路径的声明优先于根变量的声明 */
+	cel_cost_estimate_t bound =
+		estimate("request.path.startsWith(\"/api\")", &options);
+	TEST_ASSERT_EQUAL_UINT64(1 + (128 + 4) / CEL_COST_SIZE_UNIT, bound.max);
+
+	bound = estimate("size(request) + size(request.host)", &options);
+	TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, bound.max);
+}
+
+void test_regex_cost(void)
+{
+	cel_size_hint_t hints[] = {{"s", 120}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 1;
+
+	/* 正则匹配按主体与模式的总长度计价 */
+	cel_cost_estimate_t bound = estimate("s.matches(\"^a+$\")", &options);
+	TEST_ASSERT_EQUAL_UINT64(CEL_COST_CALL + (120 + 4) / CEL_COST_SIZE_UNIT,
+				 bound.max);
+	TEST_ASSERT_EQUAL_UINT64(CEL_COST_CALL, bound.min);
+}
+
+void test_ternary_and_concatenation(void)
+{
+	cel_size_hint_t hints[] = {{"a", 100}, {"b", 100}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 2;
+
+	/* 拼接结果长度为两者之和 */
+	cel_cost_estimate_t bound = estimate("size(a + b)", &options);
+	TEST_ASSERT_EQUAL_UINT64(1 + 200 / CEL_COST_SIZE_UNIT, bound.max);
+
+	bound = estimate("size(a) > 3 ? size(b) : 0", &options);
+	TEST_ASSERT_EQUAL_UINT64(1, bound.min);
+	TEST_ASSERT_EQUAL_UINT64(4, bound.max);
+
+	set_string("a", 100);
+	set_string("b", 90);
+	assert_within("size(a + b) > 0 && (size(a) > 3 ? size(b) : 0) > 0", &options);
+}
+
+/* ========== 推导式测试 ========== */
+
+void test_comprehension_nesting(void)
+{
+	cel_size_hint_t hints[] = {{"l", 10}, {"s", 128}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 2;
+	set_list("l", 3);
+	set_string("s", 100);
+
+	/* l.map(v, size(s))：每次迭代 1 + (1 + 128 / 64) */
+	cel_ast_node_t *ast = create_map_comprehension(
+		"l", "v", create_size_call(create_ident("s")));
+	cel_cost_estimate_t bound = estimate_ast(ast, &options);
+	TEST_ASSERT_EQUAL_UINT64(0, bound.min);
+	TEST_ASSERT_EQUAL_UINT64(10 * 4, bound.max);
+	cel_ast_destroy(ast);
+
+	/* l.map(v, l.map(w, size(s)))：嵌套推导式代价相乘 */
+	ast = create_map_comprehension(
+		"l", "v",
+		create_map_comprehension("l", "w",
+					 create_size_call(create_ident("s"))));
+	bound = estimate_ast(ast, &options);
+	TEST_ASSERT_EQUAL_UINT64(10 * (1 + 10 * 4), bound.max);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_accumulator_growth(void)
+{
+	cel_size_hint_t hints[] = {{"l", 128}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 1;
+	set_list("l", 128);
+
+	/* l.map(v, size(@result))：累加器每次迭代增长一个元素 */
+	cel_ast_node_t *ast = create_map_comprehension(
+		"l", "v", create_size_call(create_ident("@result")));
+	cel_cost_estimate_t bound = estimate_ast(ast, &options);
+	TEST_ASSERT_EQUAL_UINT64(128 * (1 + 1 + 128 / CEL_COST_SIZE_UNIT),
+				 bound.max);
+	cel_ast_destroy(ast);
+}
+
+void test_comprehension_derived_elements(void)
+{
+	cel_size_hint_t hints[] = {{"s", 100}, {"l", 50}};
+	cel_cost_options_t options = cel_default_cost_options();
+	options.hints = hints;
+	options.hint_count = 2;
+	options.default_max_size = 100;
+	set_list("l", 50);
+	set_string("s", 100);
+
+	/*
+	 * l.map(x, s + s + s).map(y, size(y))：y 的长度来自第一次 map
+	 * 追加的元素 (300)，而不是默认最大长度；实际代价
+	 * 50 + 50 * (1 + 1 + 300 / 64) = 350
+	 */
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *tripled = cel_ast_create_binary(
+		CEL_BINARY_ADD,
+		cel_ast_create_binary(CEL_BINARY_ADD, create_ident("s"),
+				      create_ident("s"), loc),
+		create_ident("s"), loc);
+	cel_ast_node_t *ast = create_map_over(
+		create_map_comprehension("l", "x", tripled), "y",
+		create_size_call(create_ident("y")));
+	cel_cost_estimate_t bound = estimate_ast(ast, &options);
+	TEST_ASSERT_EQUAL_UINT64(50 + 50 * (1 + 1 + 300 / CEL_COST_SIZE_UNIT),
+				 bound.max);
+	cel_ast_destroy(ast);
+
+	/* 字面量列表的元素长度同样参与估算 */
+	assert_within("[s + s, \"abc\"][0].size() > 0 && "
+		      "size([s + s + s][0]) > 0", &options);
+	cel_cost_estimate_t literal = estimate("size([s + s, \"abc\"][0])", &options);
+	TEST_ASSERT_EQUAL_UINT64(1 + 200 / CEL_COST_SIZE_UNIT, literal.max);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 基本估算测试 */
+	RUN_TEST(test_call_free_expression);
+	RUN_TEST(test_invalid_arguments);
+	RUN_TEST(test_undeclared_input_is_unbounded);
+
+	/* 字符串函数测试 */
+	RUN_TEST(test_string_cost_scales_with_declared_length);
+	RUN_TEST(test_field_path_hint);
+	RUN_TEST(test_regex_cost);
+	RUN_TEST(test_ternary_and_concatenation);
+
+	/* 推导式测试 */
+	RUN_TEST(test_comprehension_nesting);
+	RUN_TEST(test_comprehension_accumulator_growth);
+	RUN_TEST(test_comprehension_derived_elements);
+
+	return UNITY_END();
+}
@@ -0,0 +1,322 @@
+/**
+ * @file test_incremental.c
+ * @brief CEL 增量求值单元测试
+ */
+
+#include "cel/cel_incremental.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static int tick_calls = 0;
+
+static cel_value_t tick_value;
+
+/**
+ * @brief 上下文函数 tick() 返回调用次数
+ */
+static cel_result_t fn_tick(cel_func_context_t *fctx, cel_value_t **args,
+			    size_t arg_count)
+{
+	(void)fctx;
+	(void)args;
+	(void)arg_count;
+	tick_calls++;
+	tick_value = cel_value_int(tick_calls);
+	return cel_ok_result(&tick_value);
+}
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+	tick_calls = 0;
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static void set_int(cel_context_t *context, const char *name, int64_t value)
+{
+	cel_value_t v = cel_value_int(value);
+	cel_context_add_variable(context, name, &v);
+}
+
+static void set_string(cel_context_t *context, const char *name,
+		       const char *value)
+{
+	cel_value_t v = cel_value_string(value);
+	cel_context_add_variable(context, name, &v);
+	cel_value_destroy(&v);
+}
+
+static cel_program_t *compile(const char *expr)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = CEL_ENGINE_TREE_WALK;
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+	cel_program_t *program = compile.program;
+	compile.program = NULL;
+	cel_compile_result_destroy(&compile);
+	return program;
+}
+
+/**
+ * @brief 增量求值的结果与完整执行相同，返回增量求值的代价
+ */
+static uint64_t assert_agrees(cel_incremental_t *inc,
+			      const cel_program_t *program,
+			      cel_context_t *context)
+{
+	cel_execute_result_t expected = cel_execute(program, context);
+	cel_execute_result_t actual = cel_incremental_evaluate(inc, context);
+	TEST_ASSERT_EQUAL(expected.success, actual.success);
+	TEST_ASSERT_EQUAL_INT(expected.eval_error.code, actual.eval_error.code);
+	if (expected.success) {
+		TEST_ASSERT_TRUE(cel_value_equals(&expected.value, &actual.value));
+	} else {
+		char expected_message[128], actual_message[128];
+		cel_execute_result_message(&expected, expected_message,
+					   sizeof(expected_message));
+		cel_execute_result_message(&actual, actual_message,
+					   sizeof(actual_message));
+		TEST_ASSERT_EQUAL_STRING(expected_message, actual_message);
+	}
+
+	uint64_t cost = actual.cost;
+	cel_execute_result_destroy(&expected);
+	cel_execute_result_destroy(&actual);
+	return cost;
+}
+
+/* ========== 依赖跟踪测试 ========== */
+
+void test_recomputes_changed_subtrees(void)
+{
+	set_string(ctx, "a", "xx");
+	set_string(ctx, "b", "yyy");
+	set_int(ctx, "c", 5);
+
+	cel_program_t *program = compile("size(a) + size(b) * 2 > c");
+	cel_incremental_t *inc = cel_incremental_create(program);
+	TEST_ASSERT_NOT_NULL(inc);
+	TEST_ASSERT_EQUAL_size_t(3, cel_incremental_variable_count(inc));
+	/* 整个表达式、加法、size(a)、size(b) * 2 */
+	TEST_ASSERT_EQUAL_size_t(4, cel_incremental_cache_count(inc));
+
+	TEST_ASSERT_EQUAL_UINT64(2, assert_agrees(inc, program, ctx));
+	TEST_ASSERT_EQUAL_size_t(4, cel_incremental_recomputed_count(inc));
+
+	/* 没有变量变化：直接使用缓存 */
+	TEST_ASSERT_EQUAL_UINT64(0, assert_agrees(inc, program, ctx));
+	TEST_ASSERT_EQUAL_size_t(0, cel_incremental_recomputed_count(inc));
+
+	/* 只有 c 变化：只重新计算比较 */
+	set_int(ctx, "c", 100);
+	TEST_ASSERT_EQUAL_UINT64(0, assert_agrees(inc, program, ctx));
+	TEST_ASSERT_EQUAL_size_t(1, cel_incremental_recomputed_count(inc));
+
+	/* b 变化：size(a) 保持缓存 */
+	set_string(ctx, "b", "y");
+	TEST_ASSERT_EQUAL_UINT64(1, assert_agrees(inc, program, ctx));
+	TEST_ASSERT_EQUAL_size_t(3, cel_incremental_recomputed_count(inc));
+
+	/* 重新赋予相同的值同样视为变化 */
+	set_string(ctx, "a", "xx");
+	assert_agrees(inc, program, ctx);
+	TEST_ASSERT_EQUAL_size_t(3, cel_incremental_recomputed_count(inc));
+
+	cel_incremental_invalidate(inc);
+	TEST_ASSERT_EQUAL_UINT64(2, assert_agrees(inc, program, ctx));
+	TEST_ASSERT_EQUAL_size_t(4, cel_incremental_recomputed_count(inc));
+
+	cel_incremental_destroy(inc);
+	cel_program_destroy(program);
+}
+
+void test_errors_keep_semantics(void)
+{
+	/* 短路跳过的除零不影响结果 */
+	set_int(ctx, "x", 0);
+	cel_program_t *program = compile("x != 0 && 10 / x > 1");
+	cel_incremental_t *inc = cel_incremental_create(program);
+	assert_agrees(inc, program, ctx);
+	set_int(ctx, "x", 5);
+	assert_agrees(inc, program, ctx);
+	set_int(ctx, "x", 0);
+	assert_agrees(inc, program, ctx);
+	cel_incremental_destroy(inc);
+	cel_program_destroy(program);
+
+	/* 未定义的变量按原位置报告，定义后正常求值 */
+	program = compile("size(s) +\n  missing * 2");
+	set_string(ctx, "s", "abc");
+	inc = cel_incremental_create(program);
+	assert_agrees(inc, program, ctx);
+	assert_agrees(inc, program, ctx);
+	set_int(ctx, "missing", 4);
+	assert_agrees(inc, program, ctx);
+	TEST_ASSERT_TRUE(cel_context_remove_variable(ctx, "missing"));
+	assert_agrees(inc, program, ctx);
+	cel_incremental_destroy(inc);
+	cel_program_destroy(program);
+}
+
+void test_context_functions_not_cached(void)
+{
+	cel_context_add_function(ctx, "tick", fn_tick, 0, 0);
+	set_string(ctx, "s", "abc");
+
+	cel_program_t *program = compile("tick() + size(s)");
+	cel_incremental_t *inc = cel_incremental_create(program);
+	TEST_ASSERT_EQUAL_size_t(1, cel_incremental_cache_count(inc));
+
+	for (int64_t i = 1; i <= 3; i++) {
+		cel_execute_result_t result = cel_incremental_evaluate(inc, ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT64(i + 3, result.value.value.int_value);
+		TEST_ASSERT_EQUAL_size_t(i == 1 ? 1 : 0,
+					 cel_incremental_recomputed_count(inc));
+		cel_execute_result_destroy(&result);
+	}
+	TEST_ASSERT_EQUAL_INT(3, tick_calls);
+
+	cel_incremental_destroy(inc);
+	cel_program_destroy(program);
+}
+
+/**
+ * @brief items.exists(x, x == a + 1) (宏展开形式)
+ */
+static cel_ast_node_t *exists_ast(void)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *predicate = cel_ast_create_binary(
+		CEL_BINARY_EQ, cel_ast_create_ident("x", 1, loc),
+		cel_ast_create_binary(CEL_BINARY_ADD,
+				      cel_ast_create_ident("a", 1, loc),
+				      cel_ast_create_literal(cel_value_int(1), loc),
+				      loc),
+		loc);
+	return cel_ast_create_comprehension(
+		"x", 1, NULL, 0, cel_ast_create_ident("items", 5, loc),
+		"@result", 7, cel_ast_create_literal(cel_value_bool(false), loc),
+		cel_ast_create_unary(CEL_UNARY_NOT,
+				     cel_ast_create_ident("@result", 7, loc), loc),
+		cel_ast_create_binary(CEL_BINARY_OR,
+				      cel_ast_create_ident("@result", 7, loc),
+				      predicate, loc),
+		cel_ast_create_ident("@result", 7, loc), loc);
+}
+
+void test_comprehension_invariants(void)
+{
+	char source[] = "";
+	cel_program_t program = {
+		.ast = exists_ast(),
+		.eval_depth = 10,
+		.source = source,
+	};
+
+	cel_list_t *items = cel_list_create(3);
+	for (int64_t i = 1; i <= 3; i++) {
+		cel_value_t v = cel_value_int(i);
+		cel_list_append(items, &v);
+	}
+	cel_value_t list = cel_value_list(items);
+	cel_context_add_variable(ctx, "items", &list);
+	cel_value_destroy(&list);
+	set_int(ctx, "a", 2);
+	/* 循环变量遮蔽同名的上下文变量 */
+	set_int(ctx, "x", 3);
+
+	cel_incremental_t *inc = cel_incremental_create(&program);
+	cel_ast_destroy(program.ast);
+	program.ast = exists_ast();
+	/* 整个推导式与循环体中的 a + 1 */
+	TEST_ASSERT_EQUAL_size_t(2, cel_incremental_cache_count(inc));
+	TEST_ASSERT_EQUAL_size_t(2, cel_incremental_variable_count(inc));
+
+	assert_agrees(inc, &program, ctx);
+	set_int(ctx, "a", 3);
+	assert_agrees(inc, &program, ctx);
+	TEST_ASSERT_EQUAL_size_t(2, cel_incremental_recomputed_count(inc));
+
+	items = cel_list_create(1);
+	cel_value_t four = cel_value_int(4);
+	cel_list_append(items, &four);
+	list = cel_value_list(items);
+	cel_context_add_variable(ctx, "items", &list);
+	cel_value_destroy(&list);
+	assert_agrees(inc, &program, ctx);
+	TEST_ASSERT_EQUAL_size_t(1, cel_incremental_recomputed_count(inc));
+
+	/* x 不是程序的依赖 */
+	set_int(ctx, "x", 4);
+	assert_agrees(inc, &program, ctx);
+	TEST_ASSERT_EQUAL_size_t(0, cel_incremental_recomputed_count(inc));
+
+	cel_incremental_destroy(inc);
+	cel_ast_destroy(program.ast);
+}
+
+void test_context_switch(void)
+{
+	set_string(ctx, "s", "abc");
+	cel_context_t *other = cel_context_create();
+	set_string(other, "s", "abcdef");
+	/* 子上下文中的同名变量遮蔽父上下文 */
+	cel_context_t *child = cel_context_create_child(ctx);
+	set_string(child, "s", "a");
+
+	cel_program_t *program = compile("size(s) * 10");
+	cel_incremental_t *inc = cel_incremental_create(program);
+	cel_program_destroy(program);
+	program = compile("size(s) * 10");
+
+	cel_context_t *contexts[] = {ctx, other, ctx, child, ctx};
+	for (size_t i = 0; i < sizeof(contexts) / sizeof(contexts[0]); i++) {
+		assert_agrees(inc, program, contexts[i]);
+		TEST_ASSERT_EQUAL_size_t(1, cel_incremental_recomputed_count(inc));
+	}
+
+	TEST_ASSERT_NULL(cel_incremental_create(NULL));
+	cel_execute_result_t result = cel_incremental_evaluate(NULL, ctx);
+	TEST_ASSERT_FALSE(result.success);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT, result.eval_error.code);
+	cel_execute_result_destroy(&result);
+
+	cel_incremental_destroy(inc);
+	cel_program_destroy(program);
+	cel_context_destroy(child);
+	cel_context_destroy(other);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 依赖跟踪测试 */
+	RUN_TEST(test_recomputes_changed_subtrees);
+	RUN_TEST(test_errors_keep_semantics);
+	RUN_TEST(test_context_functions_not_cached);
+	RUN_TEST(test_comprehension_invariants);
+	RUN_TEST(test_context_switch);
+
+	return UNITY_END();
+}
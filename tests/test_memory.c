@@ -267,6 +267,42 @@ void test_macro_arena_alloc_array(void)
 	arena_destroy(arena);
 }
 
+/* ========== 临时分配区测试 ========== */
+
+void test_arena_scratch_alloc(void)
+{
+	arena_t *arena = arena_create(1024);
+	TEST_ASSERT_NOT_NULL(arena);
+	bool scratch = true;
+
+	/* 未安装时使用堆分配 */
+	void *heap = arena_scratch_alloc(64, &scratch);
+	TEST_ASSERT_NOT_NULL(heap);
+	TEST_ASSERT_FALSE(scratch);
+	arena_scratch_free(heap, scratch);
+
+	arena_t *previous = arena_scratch_enter(arena);
+	TEST_ASSERT_NULL(previous);
+	void *ptr = arena_scratch_alloc(64, &scratch);
+	TEST_ASSERT_NOT_NULL(ptr);
+	TEST_ASSERT_TRUE(scratch);
+	arena_scratch_free(ptr, scratch);
+
+	/* 嵌套安装 NULL 恢复为堆分配 */
+	TEST_ASSERT_EQUAL_PTR(arena, arena_scratch_enter(NULL));
+	heap = arena_scratch_alloc(64, &scratch);
+	TEST_ASSERT_FALSE(scratch);
+	arena_scratch_free(heap, scratch);
+	arena_scratch_leave(arena);
+	arena_scratch_leave(previous);
+
+	size_t total_used = 0;
+	arena_stats(arena, NULL, &total_used, NULL);
+	TEST_ASSERT_EQUAL(64, total_used);
+
+	arena_destroy(arena);
+}
+
 /* ========== Unity 主函数 ========== */
 
 int main(void)
@@ -299,5 +335,8 @@ int main(void)
 	RUN_TEST(test_macro_arena_alloc);
 	RUN_TEST(test_macro_arena_alloc_array);
 
+	/* 临时分配区测试 */
+	RUN_TEST(test_arena_scratch_alloc);
+
 	return UNITY_END();
 }
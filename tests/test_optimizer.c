@@ -0,0 +1,586 @@
+/**
+ * @file test_optimizer.c
+ * @brief CEL 常量折叠、推导式融合与部分求值单元测试
+ */
+
+#include "cel/cel_optimizer.h"
+#include "cel/cel_bytecode.h"
+#include "cel/cel_eval.h"
+#include "cel/cel_parser.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+
+	cel_value_t x = cel_value_int(7);
+	cel_value_t s = cel_value_string("b");
+	cel_context_add_variable(ctx, "x", &x);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+/**
+ * @brief 解析并折叠表达式 (调用者负责销毁返回的 AST)
+ */
+static cel_ast_node_t *fold(const char *expr)
+{
+	cel_parse_result_t parsed = cel_parse(expr);
+	TEST_ASSERT_FALSE_MESSAGE(parsed.has_errors, expr);
+
+	cel_ast_node_t *ast = parsed.ast;
+	parsed.ast = NULL;
+	cel_parse_result_destroy(&parsed);
+
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_fold_constants(&ast));
+	return ast;
+}
+
+/**
+ * @brief 折叠结果为指定类型的字面量
+ */
+static void assert_folds_to(const char *expr, cel_type_e type)
+{
+	cel_ast_node_t *ast = fold(expr);
+	TEST_ASSERT_EQUAL_INT_MESSAGE(CEL_AST_LITERAL, ast->type, expr);
+	TEST_ASSERT_EQUAL_INT_MESSAGE(type, ast->as.literal.value.type, expr);
+	cel_ast_destroy(ast);
+}
+
+/**
+ * @brief 以指定选项编译并执行
+ */
+static cel_execute_result_t run(const char *expr, bool fold_constants,
+				cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.fold_constants = fold_constants;
+	options.engine = engine;
+
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+
+	cel_execute_result_t result = cel_execute(compile.program, ctx);
+	cel_compile_result_destroy(&compile);
+	return result;
+}
+
+/**
+ * @brief 折叠前后、两种引擎的执行结果必须一致
+ */
+static void assert_same_result(const char *expr)
+{
+	cel_execute_result_t expected = run(expr, false, CEL_ENGINE_TREE_WALK);
+	cel_engine_e engines[] = {CEL_ENGINE_TREE_WALK, CEL_ENGINE_BYTECODE};
+
+	for (size_t i = 0; i < 2; i++) {
+		cel_execute_result_t actual = run(expr, true, engines[i]);
+		TEST_ASSERT_EQUAL_MESSAGE(expected.success, actual.success, expr);
+		if (expected.success) {
+			TEST_ASSERT_TRUE_MESSAGE(
+				cel_value_equals(&expected.value, &actual.value),
+				expr);
+		}
+		cel_execute_result_destroy(&actual);
+	}
+
+	cel_execute_result_destroy(&expected);
+}
+
+/* ========== 折叠测试 ========== */
+
+void test_fold_arithmetic(void)
+{
+	cel_ast_node_t *ast = fold("1024 * 1024");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LITERAL, ast->type);
+	TEST_ASSERT_EQUAL_INT64(1048576, ast->as.literal.value.value.int_value);
+	cel_ast_destroy(ast);
+
+	assert_folds_to("(1 + 2) * 3 > 8 && \"a\" + \"b\" == \"ab\"",
+			CEL_TYPE_BOOL);
+	assert_folds_to("-2.5", CEL_TYPE_DOUBLE);
+	assert_folds_to("size(\"hello\") + int(\"1\")", CEL_TYPE_INT);
+	assert_folds_to("\"hello\".startsWith(\"he\")", CEL_TYPE_BOOL);
+}
+
+void test_fold_aggregates(void)
+{
+	assert_folds_to("[\"a\", \"b\", \"c\"]", CEL_TYPE_LIST);
+	assert_folds_to("{\"k\": 1, \"n\": [1, 2]}", CEL_TYPE_MAP);
+	assert_folds_to("{\"k\": 1}.k + [1, 2][1]", CEL_TYPE_INT);
+
+	/* 常量列表在 in 表达式中折叠为一个字面量 */
+	cel_ast_node_t *ast = fold("s in [\"a\", \"b\", \"c\"]");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_BINARY, ast->type);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LITERAL, ast->as.binary.right->type);
+	TEST_ASSERT_EQUAL_size_t(
+		3, cel_list_size(ast->as.binary.right->as.literal.value.value
+					 .list_value));
+	cel_ast_destroy(ast);
+
+	/* 包含变量的列表只折叠常量元素 */
+	ast = fold("[x, 1 + 1]");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LIST, ast->type);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LITERAL, ast->as.list.elements[1]->type);
+	cel_ast_destroy(ast);
+}
+
+void test_fold_control_flow(void)
+{
+	cel_ast_node_t *ast = fold("1 > 0 ? x : x + 1");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_IDENT, ast->type);
+	cel_ast_destroy(ast);
+
+	assert_folds_to("false && x", CEL_TYPE_BOOL);
+	assert_folds_to("true || x", CEL_TYPE_BOOL);
+
+	ast = fold("true && x");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_BINARY, ast->type);
+	cel_ast_destroy(ast);
+}
+
+void test_errors_are_not_folded(void)
+{
+	cel_ast_node_t *ast = fold("1 / 0");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_BINARY, ast->type);
+	cel_ast_destroy(ast);
+
+	/* INT64_MIN / -1 溢出，保留原节点由执行时报告 */
+	const char *overflows[] = {"(-9223372036854775807 - 1) / -1",
+				   "(-9223372036854775807 - 1) % -1"};
+	for (size_t i = 0; i < 2; i++) {
+		ast = fold(overflows[i]);
+		TEST_ASSERT_EQUAL_INT(CEL_AST_BINARY, ast->type);
+		cel_ast_destroy(ast);
+
+		cel_compile_result_t compile = cel_compile(overflows[i]);
+		TEST_ASSERT_FALSE(compile.has_errors);
+		cel_execute_result_t result = cel_execute(compile.program, ctx);
+		TEST_ASSERT_FALSE(result.success);
+		TEST_ASSERT_EQUAL_INT(CEL_ERROR_OVERFLOW, result.eval_error.code);
+		cel_execute_result_destroy(&result);
+		cel_compile_result_destroy(&compile);
+	}
+
+	/* 上下文函数不是纯函数 */
+	ast = fold("custom(1)");
+	TEST_ASSERT_EQUAL_INT(CEL_AST_CALL, ast->type);
+	cel_ast_destroy(ast);
+}
+
+/* ========== 执行测试 ========== */
+
+void test_folded_programs_agree(void)
+{
+	assert_same_result("1024 * 1024");
+	assert_same_result("s in [\"a\", \"b\", \"c\"]");
+	assert_same_result("x in [1, 2, 3] || {\"k\": x}.k == 7");
+	assert_same_result("1 > 0 ? x : undefined_var");
+	assert_same_result("false && undefined_var");
+	assert_same_result("1 / 0");
+	assert_same_result("x + 1 / 0");
+	assert_same_result("1 || true");
+}
+
+void test_shared_constant_survives_executions(void)
+{
+	cel_compile_result_t compile =
+		cel_compile("[\"a\", \"b\", s] + [\"c\"]");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	for (int i = 0; i < 3; i++) {
+		cel_execute_result_t result = cel_execute(compile.program, ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_size_t(
+			4, cel_list_size(result.value.value.list_value));
+		cel_execute_result_destroy(&result);
+	}
+
+	cel_compile_result_destroy(&compile);
+}
+
+/* ========== 推导式融合测试 ========== */
+
+static cel_ast_node_t *ident(const char *name)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_ident(name, strlen(name), loc);
+}
+
+static cel_ast_node_t *int_literal(int64_t value)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_literal(cel_value_int(value), loc);
+}
+
+static cel_ast_node_t *binary(cel_binary_op_e op, cel_ast_node_t *left,
+			      cel_ast_node_t *right)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_binary(op, left, right, loc);
+}
+
+static cel_ast_node_t *field(cel_ast_node_t *operand, const char *name)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_select(operand, name, strlen(name), false, loc);
+}
+
+/**
+ * @brief range.map(var, element) 或 range.filter(var, guard) (宏展开形式)
+ */
+static cel_ast_node_t *append_macro(cel_ast_node_t *range, const char *var,
+				    cel_ast_node_t *guard,
+				    cel_ast_node_t *element)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+	elements[0] = element;
+	cel_ast_node_t *step = binary(CEL_BINARY_ADD, ident("@result"),
+				      cel_ast_create_list(elements, 1, loc));
+	if (guard) {
+		step = cel_ast_create_ternary(guard, step, ident("@result"), loc);
+	}
+	return cel_ast_create_comprehension(
+		var, strlen(var), NULL, 0, range, "@result", 7,
+		cel_ast_create_list(NULL, 0, loc),
+		cel_ast_create_literal(cel_value_bool(true), loc), step,
+		ident("@result"), loc);
+}
+
+/**
+ * @brief range.exists(var, predicate) (宏展开形式)
+ */
+static cel_ast_node_t *exists_macro(cel_ast_node_t *range, const char *var,
+				    cel_ast_node_t *predicate)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_comprehension(
+		var, strlen(var), NULL, 0, range, "@result", 7,
+		cel_ast_create_literal(cel_value_bool(false), loc),
+		cel_ast_create_unary(CEL_UNARY_NOT, ident("@result"), loc),
+		binary(CEL_BINARY_OR, ident("@result"), predicate),
+		ident("@result"), loc);
+}
+
+/**
+ * @brief 绑定 items = [{"active": i % 2 == 0, "id": i}, ...]
+ */
+static void bind_items(int64_t count)
+{
+	cel_list_t *items = cel_list_create((size_t)count);
+	for (int64_t i = 0; i < count; i++) {
+		cel_map_t *item = cel_map_create(4);
+		cel_value_t key = cel_value_string("active");
+		cel_value_t value = cel_value_bool(i % 2 == 0);
+		cel_map_put(item, &key, &value);
+		cel_value_destroy(&key);
+		key = cel_value_string("id");
+		value = cel_value_int(i);
+		cel_map_put(item, &key, &value);
+		cel_value_destroy(&key);
+
+		cel_value_t element = cel_value_map(item);
+		cel_list_append(items, &element);
+		cel_value_destroy(&element);
+	}
+	cel_value_t value = cel_value_list(items);
+	cel_context_add_variable(ctx, "items", &value);
+	cel_value_destroy(&value);
+}
+
+/**
+ * @brief items.filter(x, x.active).map(x, x.id).exists(id, id == target)
+ */
+static cel_ast_node_t *filter_map_exists(int64_t target)
+{
+	return exists_macro(
+		append_macro(append_macro(ident("items"), "x",
+					  field(ident("x"), "active"), ident("x")),
+			     "x", NULL, field(ident("x"), "id")),
+		"id", binary(CEL_BINARY_EQ, ident("id"), int_literal(target)));
+}
+
+/**
+ * @brief 以树遍历求值并返回代价，同时检查字节码执行的结果相同
+ */
+static uint64_t eval_with_cost(const cel_ast_node_t *ast, cel_value_t *value)
+{
+	cel_exec_budget_t budget;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, 0, 0);
+	TEST_ASSERT_TRUE(cel_eval(ast, ctx, value));
+	cel_exec_budget_leave(previous);
+
+	cel_bytecode_t *bc = cel_bytecode_compile(ast, NULL);
+	TEST_ASSERT_NOT_NULL(bc);
+	cel_value_t vm_value;
+	TEST_ASSERT_TRUE(cel_vm_execute(bc, ctx, NULL, &vm_value));
+	TEST_ASSERT_TRUE(cel_value_equals(value, &vm_value));
+	cel_value_destroy(&vm_value);
+	cel_bytecode_destroy(bc);
+	return budget.cost;
+}
+
+/**
+ * @brief 融合前后结果相同，返回融合后的 AST
+ */
+static cel_ast_node_t *assert_fusion_agrees(cel_ast_node_t *(*build)(void))
+{
+	cel_ast_node_t *plain = build();
+	cel_ast_node_t *fused = build();
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_fuse_comprehensions(&fused));
+
+	cel_value_t expected, actual;
+	eval_with_cost(plain, &expected);
+	eval_with_cost(fused, &actual);
+	TEST_ASSERT_TRUE(cel_value_equals(&expected, &actual));
+
+	cel_value_destroy(&expected);
+	cel_value_destroy(&actual);
+	cel_ast_destroy(plain);
+	return fused;
+}
+
+void test_fuse_filter_map_exists(void)
+{
+	bind_items(1000);
+
+	/* 融合为对 items 的一次迭代 */
+	cel_ast_node_t *ast = filter_map_exists(10);
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_fuse_comprehensions(&ast));
+	TEST_ASSERT_EQUAL_INT(CEL_AST_COMPREHENSION, ast->type);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_IDENT, ast->as.comprehension.iter_range->type);
+
+	/* exists 命中后立即结束，不再构造中间列表 */
+	cel_ast_node_t *plain = filter_map_exists(10);
+	cel_value_t expected, actual;
+	uint64_t plain_cost = eval_with_cost(plain, &expected);
+	uint64_t fused_cost = eval_with_cost(ast, &actual);
+	TEST_ASSERT_TRUE(expected.value.bool_value);
+	TEST_ASSERT_TRUE(actual.value.bool_value);
+	/* 命中之后还有一次检查循环条件的迭代 */
+	TEST_ASSERT_EQUAL_UINT64(1000 + 500 + 7, plain_cost);
+	TEST_ASSERT_EQUAL_UINT64(11 + 1, fused_cost);
+	cel_ast_destroy(plain);
+	cel_ast_destroy(ast);
+
+	/* 被过滤的元素不会命中 */
+	plain = filter_map_exists(11);
+	ast = filter_map_exists(11);
+	cel_optimize_fuse_comprehensions(&ast);
+	eval_with_cost(plain, &expected);
+	eval_with_cost(ast, &actual);
+	TEST_ASSERT_FALSE(expected.value.bool_value);
+	TEST_ASSERT_FALSE(actual.value.bool_value);
+	cel_ast_destroy(plain);
+	cel_ast_destroy(ast);
+}
+
+/**
+ * @brief items.map(x, x.id).filter(y, y > 5).map(z, z * 2)
+ */
+static cel_ast_node_t *map_filter_map(void)
+{
+	return append_macro(
+		append_macro(append_macro(ident("items"), "x", NULL,
+					  field(ident("x"), "id")),
+			     "y", binary(CEL_BINARY_GT, ident("y"), int_literal(5)),
+			     ident("y")),
+		"z", NULL, binary(CEL_BINARY_MUL, ident("z"), int_literal(2)));
+}
+
+/**
+ * @brief items.filter(x, x.active).filter(x, x.id % 3 == 0)
+ */
+static cel_ast_node_t *filter_filter(void)
+{
+	return append_macro(
+		append_macro(ident("items"), "x", field(ident("x"), "active"),
+			     ident("x")),
+		"x",
+		binary(CEL_BINARY_EQ,
+		       binary(CEL_BINARY_MOD, field(ident("x"), "id"),
+			      int_literal(3)),
+		       int_literal(0)),
+		ident("x"));
+}
+
+void test_fuse_map_filter_chain(void)
+{
+	bind_items(50);
+
+	/* 三级链融合为一个推导式，守卫合并后仍可继续融合 */
+	cel_ast_node_t *ast = assert_fusion_agrees(map_filter_map);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_IDENT, ast->as.comprehension.iter_range->type);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_TERNARY, ast->as.comprehension.loop_step->type);
+	cel_ast_destroy(ast);
+
+	ast = assert_fusion_agrees(filter_filter);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_IDENT, ast->as.comprehension.iter_range->type);
+	cel_ast_node_t *guard = ast->as.comprehension.loop_step->as.ternary.condition;
+	TEST_ASSERT_EQUAL_INT(CEL_AST_BINARY, guard->type);
+	TEST_ASSERT_EQUAL_INT(CEL_BINARY_AND, guard->as.binary.op);
+	cel_ast_destroy(ast);
+}
+
+/**
+ * @brief items.map(x, x.id + 1).exists(y, y > 3 && y < 10)
+ */
+static cel_ast_node_t *computed_used_twice(void)
+{
+	return exists_macro(
+		append_macro(ident("items"), "x", NULL,
+			     binary(CEL_BINARY_ADD, field(ident("x"), "id"),
+				    int_literal(1))),
+		"y",
+		binary(CEL_BINARY_AND, binary(CEL_BINARY_GT, ident("y"), int_literal(3)),
+		       binary(CEL_BINARY_LT, ident("y"), int_literal(10))));
+}
+
+/**
+ * @brief items.map(x, x.id).exists(y, y > 3 && y < 10)
+ */
+static cel_ast_node_t *field_used_twice(void)
+{
+	return exists_macro(
+		append_macro(ident("items"), "x", NULL, field(ident("x"), "id")),
+		"y",
+		binary(CEL_BINARY_AND, binary(CEL_BINARY_GT, ident("y"), int_literal(3)),
+		       binary(CEL_BINARY_LT, ident("y"), int_literal(10))));
+}
+
+void test_fuse_preconditions(void)
+{
+	bind_items(20);
+
+	/* 计算得到的元素出现多次：不融合 (避免重复求值) */
+	cel_ast_node_t *ast = assert_fusion_agrees(computed_used_twice);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_COMPREHENSION,
+			      ast->as.comprehension.iter_range->type);
+	cel_ast_destroy(ast);
+
+	/* 字段访问可以复制 */
+	ast = assert_fusion_agrees(field_used_twice);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_IDENT, ast->as.comprehension.iter_range->type);
+	cel_ast_destroy(ast);
+
+	/* 外层步骤引用的 x 会被融合后的循环变量捕获：不融合 */
+	ast = exists_macro(append_macro(ident("items"), "x", NULL,
+					field(ident("x"), "id")),
+			   "y", binary(CEL_BINARY_EQ, ident("y"), ident("x")));
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_fuse_comprehensions(&ast));
+	TEST_ASSERT_EQUAL_INT(CEL_AST_COMPREHENSION,
+			      ast->as.comprehension.iter_range->type);
+	cel_ast_destroy(ast);
+
+	/* 元素引用累加器：不融合 */
+	ast = exists_macro(append_macro(ident("items"), "x", NULL,
+					ident("@result")),
+			   "y", ident("y"));
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_fuse_comprehensions(&ast));
+	TEST_ASSERT_EQUAL_INT(CEL_AST_COMPREHENSION,
+			      ast->as.comprehension.iter_range->type);
+	cel_ast_destroy(ast);
+}
+
+/* ========== 部分求值测试 ========== */
+
+void test_partial_eval_comprehensions(void)
+{
+	bind_items(20);
+
+	/* 迭代范围已知：整个推导式链求值为字面量 */
+	cel_ast_node_t *ast = filter_map_exists(10);
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_partial_eval(&ast, ctx));
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LITERAL, ast->type);
+	TEST_ASSERT_TRUE(ast->as.literal.value.value.bool_value);
+	cel_ast_destroy(ast);
+
+	/* 循环体引用未知变量 target：只代入迭代范围，x 是循环变量 */
+	ast = exists_macro(ident("items"), "x",
+			   binary(CEL_BINARY_EQ, field(ident("x"), "id"),
+				  ident("target")));
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_optimize_partial_eval(&ast, ctx));
+	TEST_ASSERT_EQUAL_INT(CEL_AST_COMPREHENSION, ast->type);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LITERAL,
+			      ast->as.comprehension.iter_range->type);
+
+	/* 迭代范围未知：循环体中的已知变量 s 被代入，遮蔽已知变量的 x 保留 */
+	cel_ast_node_t *unknown_range = exists_macro(
+		ident("tags"), "x",
+		binary(CEL_BINARY_EQ, ident("x"), ident("s")));
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_optimize_partial_eval(&unknown_range, ctx));
+	const cel_ast_node_t *step = unknown_range->as.comprehension.loop_step;
+	const cel_ast_node_t *predicate = step->as.binary.right;
+	TEST_ASSERT_EQUAL_INT(CEL_AST_IDENT, predicate->as.binary.left->type);
+	TEST_ASSERT_EQUAL_INT(CEL_AST_LITERAL, predicate->as.binary.right->type);
+
+	/* 剩余 AST 在补全变量后求值 */
+	cel_value_t target = cel_value_int(3);
+	cel_context_add_variable(ctx, "target", &target);
+	cel_list_t *tags = cel_list_create(2);
+	cel_value_t a = cel_value_string("a");
+	cel_value_t b = cel_value_string("b");
+	cel_list_append(tags, &a);
+	cel_list_append(tags, &b);
+	cel_value_destroy(&a);
+	cel_value_destroy(&b);
+	cel_value_t tags_value = cel_value_list(tags);
+	cel_context_add_variable(ctx, "tags", &tags_value);
+	cel_value_destroy(&tags_value);
+
+	cel_value_t value;
+	eval_with_cost(ast, &value);
+	TEST_ASSERT_TRUE(value.value.bool_value);
+	eval_with_cost(unknown_range, &value);
+	TEST_ASSERT_TRUE(value.value.bool_value);
+	cel_ast_destroy(ast);
+	cel_ast_destroy(unknown_range);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 折叠测试 */
+	RUN_TEST(test_fold_arithmetic);
+	RUN_TEST(test_fold_aggregates);
+	RUN_TEST(test_fold_control_flow);
+	RUN_TEST(test_errors_are_not_folded);
+
+	/* 执行测试 */
+	RUN_TEST(test_folded_programs_agree);
+	RUN_TEST(test_shared_constant_survives_executions);
+
+	/* 推导式融合测试 */
+	RUN_TEST(test_fuse_filter_map_exists);
+	RUN_TEST(test_fuse_map_filter_chain);
+	RUN_TEST(test_fuse_preconditions);
+
+	/* 部分求值测试 */
+	RUN_TEST(test_partial_eval_comprehensions);
+
+	return UNITY_END();
+}
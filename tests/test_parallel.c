@@ -0,0 +1,462 @@
+/**
+ * @file test_parallel.c
+ * @brief CEL 并行推导式测试
+ *
+ * 同一推导式分别顺序与并行求值，结果、错误与代价必须相同。
+ */
+
+#include "cel/cel_eval.h"
+#include "cel/cel_pool.h"
+#include "cel/cel_program.h"
+#include "cel/cel_ast.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define THREADS 4
+#define LARGE 100000
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static cel_thread_pool_t *pool = NULL;
+
+/* 解析器记录调用它的线程，用于确认元素在多个线程上求值 */
+static pthread_mutex_t seen_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t seen[THREADS + 1];
+static size_t seen_count = 0;
+static cel_value_t limit_value;
+
+static cel_value_t *resolve_limit(const char *name, void *user_data)
+{
+	(void)user_data;
+	if (strcmp(name, "limit") != 0) {
+		return NULL;
+	}
+
+	pthread_mutex_lock(&seen_lock);
+	bool found = false;
+	for (size_t i = 0; i < seen_count; i++) {
+		found = found || pthread_equal(seen[i], pthread_self());
+	}
+	if (!found && seen_count < THREADS + 1) {
+		seen[seen_count++] = pthread_self();
+	}
+	pthread_mutex_unlock(&seen_lock);
+	return &limit_value;
+}
+
+static void set_range(const char *name, size_t length)
+{
+	cel_list_t *list = cel_list_create(length);
+	for (size_t i = 0; i < length; i++) {
+		cel_value_t element = cel_value_int((int64_t)i);
+		cel_list_append(list, &element);
+	}
+	cel_value_t value = cel_value_list(list);
+	cel_context_add_variable(ctx, name, &value);
+	cel_value_destroy(&value);
+}
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+	set_range("l", LARGE);
+	limit_value = cel_value_int(LARGE);
+	cel_context_set_resolver(ctx, resolve_limit, NULL);
+	seen_count = 0;
+
+	pool = cel_thread_pool_create(THREADS);
+}
+
+void tearDown(void)
+{
+	cel_thread_pool_destroy(pool);
+	pool = NULL;
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_ast_node_t *create_ident(const char *name)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_ident(name, strlen(name), loc);
+}
+
+static cel_ast_node_t *create_int(int64_t value)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_literal(cel_value_int(value), loc);
+}
+
+static cel_ast_node_t *create_bool(bool value)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_literal(cel_value_bool(value), loc);
+}
+
+static cel_ast_node_t *create_binary(cel_binary_op_e op, cel_ast_node_t *left,
+				      cel_ast_node_t *right)
+{
+	cel_token_location_t loc = {0};
+	return cel_ast_create_binary(op, left, right, loc);
+}
+
+/**
+ * @brief 创建 l.all(x, P) 或 l.exists(x, P)
+ */
+static cel_ast_node_t *create_quantifier(bool all, cel_ast_node_t *predicate)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *cond = create_ident("@result");
+	if (!all) {
+		cond = cel_ast_create_unary(CEL_UNARY_NOT, cond, loc);
+	}
+	return cel_ast_create_comprehension(
+		"x", 1, NULL, 0, create_ident("l"), "@result", 7,
+		create_bool(all), cond,
+		create_binary(all ? CEL_BINARY_AND : CEL_BINARY_OR,
+			      create_ident("@result"), predicate),
+		create_ident("@result"), loc);
+}
+
+/**
+ * @brief 创建 l.map(x, E) 或 l.filter(x, F) (filter 时 element 为 x)
+ */
+static cel_ast_node_t *create_append(cel_ast_node_t *filter,
+				     cel_ast_node_t *element)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t **elements = malloc(sizeof(cel_ast_node_t *));
+	elements[0] = element;
+	cel_ast_node_t *step = create_binary(
+		CEL_BINARY_ADD, create_ident("@result"),
+		cel_ast_create_list(elements, 1, loc));
+	if (filter) {
+		step = cel_ast_create_ternary(filter, step,
+					      create_ident("@result"), loc);
+	}
+	return cel_ast_create_comprehension(
+		"x", 1, NULL, 0, create_ident("l"), "@result", 7,
+		cel_ast_create_list(NULL, 0, loc), create_bool(true), step,
+		create_ident("@result"), loc);
+}
+
+/**
+ * @brief 求值 (pool 为 NULL 时顺序执行)
+ */
+static bool run(const cel_ast_node_t *ast, cel_thread_pool_t *with_pool,
+		size_t threshold, uint64_t max_cost, cel_value_t *value,
+		uint64_t *cost)
+{
+	cel_eval_parallel_t parallel = {with_pool, threshold};
+	const cel_eval_parallel_t *previous_parallel =
+		cel_eval_parallel_enter(with_pool ? &parallel : NULL);
+	cel_exec_budget_t budget;
+	cel_exec_budget_t *previous = cel_exec_budget_enter(&budget, max_cost, 0);
+
+	bool success = cel_eval(ast, ctx, value);
+
+	cel_exec_budget_leave(previous);
+	cel_eval_parallel_leave(previous_parallel);
+	*cost = budget.cost;
+	return success;
+}
+
+/**
+ * @brief 顺序与并行求值，检查结果与代价相同
+ */
+static bool assert_same(cel_ast_node_t *ast, uint64_t max_cost,
+			cel_value_t *value)
+{
+	cel_value_t expected;
+	uint64_t expected_cost, cost;
+	bool expected_success = run(ast, NULL, 0, max_cost, &expected,
+				    &expected_cost);
+	bool success = run(ast, pool, 1024, max_cost, value, &cost);
+
+	TEST_ASSERT_EQUAL(expected_success, success);
+	TEST_ASSERT_EQUAL_UINT64(expected_cost, cost);
+	if (success) {
+		TEST_ASSERT_TRUE(cel_value_equals(&expected, value));
+		cel_value_destroy(&expected);
+	}
+	cel_ast_destroy(ast);
+	return success;
+}
+
+/* ========== all / exists 测试 ========== */
+
+void test_parallel_all(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	cel_value_t value;
+
+	/* l.all(x, x < limit) */
+	TEST_ASSERT_TRUE(assert_same(
+		create_quantifier(true, create_binary(CEL_BINARY_LT,
+						      create_ident("x"),
+						      create_ident("limit"))),
+		0, &value));
+	TEST_ASSERT_TRUE(value.value.bool_value);
+	TEST_ASSERT_TRUE(seen_count > 1);
+
+	/* l.all(x, x < 70000)：在 70000 处结束 */
+	TEST_ASSERT_TRUE(assert_same(
+		create_quantifier(true, create_binary(CEL_BINARY_LT,
+						      create_ident("x"),
+						      create_int(70000))),
+		0, &value));
+	TEST_ASSERT_FALSE(value.value.bool_value);
+}
+
+void test_parallel_exists(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	cel_value_t value;
+
+	/* l.exists(x, x == 99999)：最后一个元素 */
+	TEST_ASSERT_TRUE(assert_same(
+		create_quantifier(false, create_binary(CEL_BINARY_EQ,
+						       create_ident("x"),
+						       create_int(LARGE - 1))),
+		0, &value));
+	TEST_ASSERT_TRUE(value.value.bool_value);
+
+	/* l.exists(x, x < 0) */
+	TEST_ASSERT_TRUE(assert_same(
+		create_quantifier(false, create_binary(CEL_BINARY_LT,
+						       create_ident("x"),
+						       create_int(0))),
+		0, &value));
+	TEST_ASSERT_FALSE(value.value.bool_value);
+}
+
+/* ========== map / filter 测试 ========== */
+
+void test_parallel_map_preserves_order(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	set_range("l", 8000);
+
+	/* l.map(x, x * 2) */
+	cel_value_t value;
+	TEST_ASSERT_TRUE(assert_same(
+		create_append(NULL, create_binary(CEL_BINARY_MUL,
+						  create_ident("x"),
+						  create_int(2))),
+		0, &value));
+	TEST_ASSERT_EQUAL_INT(8000, cel_list_size(value.value.list_value));
+	for (size_t i = 0; i < 8000; i++) {
+		TEST_ASSERT_EQUAL_INT64(2 * (int64_t)i,
+					value.value.list_value->items[i]->value.int_value);
+	}
+	cel_value_destroy(&value);
+}
+
+void test_parallel_filter_preserves_order(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	set_range("l", 8000);
+
+	/* l.filter(x, x % 3 == 0) */
+	cel_value_t value;
+	TEST_ASSERT_TRUE(assert_same(
+		create_append(create_binary(CEL_BINARY_EQ,
+					    create_binary(CEL_BINARY_MOD,
+							  create_ident("x"),
+							  create_int(3)),
+					    create_int(0)),
+			      create_ident("x")),
+		0, &value));
+	TEST_ASSERT_EQUAL_INT(2667, cel_list_size(value.value.list_value));
+	for (size_t i = 0; i < 2667; i++) {
+		TEST_ASSERT_EQUAL_INT64(3 * (int64_t)i,
+					value.value.list_value->items[i]->value.int_value);
+	}
+	cel_value_destroy(&value);
+}
+
+/* ========== 错误与预算测试 ========== */
+
+/**
+ * @brief 创建 10 / (x - zero) == expected (x 为 zero 时除零)
+ */
+static cel_ast_node_t *create_divide_check(int64_t zero, int64_t expected)
+{
+	return create_binary(
+		CEL_BINARY_EQ,
+		create_binary(CEL_BINARY_DIV, create_int(10),
+			      create_binary(CEL_BINARY_SUB, create_ident("x"),
+					    create_int(zero))),
+		create_int(expected));
+}
+
+void test_parallel_errors_match_sequential(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	cel_value_t value;
+
+	/* 除零之前没有满足条件的元素：失败 */
+	TEST_ASSERT_FALSE(assert_same(
+		create_quantifier(false, create_divide_check(50000, 10)), 0,
+		&value));
+
+	/* x = 49999 满足条件，在除零之前结束 */
+	TEST_ASSERT_TRUE(assert_same(
+		create_quantifier(false, create_divide_check(50000, -10)), 0,
+		&value));
+	TEST_ASSERT_TRUE(value.value.bool_value);
+
+	/* map 在除零处失败 */
+	set_range("l", 8000);
+	TEST_ASSERT_FALSE(assert_same(
+		create_append(NULL, create_divide_check(5000, 0)), 0, &value));
+}
+
+void test_parallel_cost_limit(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	cel_value_t value;
+
+	/* 代价上限在范围中间触发，代价与顺序执行相同 */
+	TEST_ASSERT_FALSE(assert_same(
+		create_quantifier(true, create_binary(CEL_BINARY_GE,
+						      create_ident("x"),
+						      create_int(0))),
+		30000, &value));
+
+	TEST_ASSERT_TRUE(assert_same(
+		create_quantifier(true, create_binary(CEL_BINARY_GE,
+						      create_ident("x"),
+						      create_int(0))),
+		LARGE, &value));
+}
+
+/* ========== 回退测试 ========== */
+
+void test_parallel_below_threshold(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	cel_ast_node_t *ast = create_quantifier(
+		true, create_binary(CEL_BINARY_LT, create_ident("x"),
+				    create_ident("limit")));
+
+	/* 范围小于阈值：只在当前线程求值 */
+	cel_value_t value;
+	uint64_t cost;
+	TEST_ASSERT_TRUE(run(ast, pool, LARGE + 1, 0, &value, &cost));
+	TEST_ASSERT_TRUE(value.value.bool_value);
+	TEST_ASSERT_EQUAL_INT(1, seen_count);
+	TEST_ASSERT_TRUE(pthread_equal(seen[0], pthread_self()));
+	cel_ast_destroy(ast);
+}
+
+static atomic_bool blocker_entered;
+static atomic_bool blocker_release;
+
+static void block_task(void *arg, size_t worker)
+{
+	(void)arg;
+	if (worker == 0) {
+		atomic_store(&blocker_entered, true);
+	}
+	while (!atomic_load(&blocker_release)) {
+	}
+}
+
+static void *block_pool(void *arg)
+{
+	cel_thread_pool_run(arg, block_task, NULL);
+	return NULL;
+}
+
+void test_parallel_busy_pool_runs_sequentially(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	atomic_store(&blocker_entered, false);
+	atomic_store(&blocker_release, false);
+
+	/* 另一个线程占用线程池 */
+	pthread_t thread;
+	TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, block_pool, pool));
+	while (!atomic_load(&blocker_entered)) {
+	}
+
+	cel_ast_node_t *ast = create_quantifier(
+		true, create_binary(CEL_BINARY_LT, create_ident("x"),
+				    create_ident("limit")));
+	cel_value_t value;
+	uint64_t cost;
+	TEST_ASSERT_TRUE(run(ast, pool, 1024, 0, &value, &cost));
+	TEST_ASSERT_TRUE(value.value.bool_value);
+	TEST_ASSERT_EQUAL_UINT64(LARGE, cost);
+	TEST_ASSERT_EQUAL_INT(1, seen_count);
+
+	atomic_store(&blocker_release, true);
+	pthread_join(thread, NULL);
+
+	/* 线程池空闲后恢复并行 */
+	TEST_ASSERT_TRUE(run(ast, pool, 1024, 0, &value, &cost));
+	TEST_ASSERT_EQUAL_UINT64(LARGE, cost);
+	TEST_ASSERT_TRUE(seen_count > 1);
+	cel_ast_destroy(ast);
+}
+
+void test_parallel_execute_options(void)
+{
+	TEST_ASSERT_NOT_NULL(pool);
+	cel_program_t program = {
+		.ast = create_quantifier(false,
+					 create_binary(CEL_BINARY_EQ,
+						       create_ident("x"),
+						       create_int(LARGE / 2))),
+	};
+
+	cel_execute_options_t options = cel_default_execute_options();
+	options.pool = pool;
+	options.parallel_threshold = 1024;
+	cel_execute_result_t result =
+		cel_execute_with_options(&program, ctx, &options);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_TRUE(result.value.value.bool_value);
+	/* 命中之后还有一次检查循环条件的迭代 */
+	TEST_ASSERT_EQUAL_UINT64(LARGE / 2 + 2, result.cost);
+
+	cel_execute_result_destroy(&result);
+	cel_ast_destroy(program.ast);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* all / exists 测试 */
+	RUN_TEST(test_parallel_all);
+	RUN_TEST(test_parallel_exists);
+
+	/* map / filter 测试 */
+	RUN_TEST(test_parallel_map_preserves_order);
+	RUN_TEST(test_parallel_filter_preserves_order);
+
+	/* 错误与预算测试 */
+	RUN_TEST(test_parallel_errors_match_sequential);
+	RUN_TEST(test_parallel_cost_limit);
+
+	/* 回退测试 */
+	RUN_TEST(test_parallel_below_threshold);
+	RUN_TEST(test_parallel_busy_pool_runs_sequentially);
+	RUN_TEST(test_parallel_execute_options);
+
+	return UNITY_END();
+}
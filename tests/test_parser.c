@@ -406,6 +406,60 @@ void test_parse_error_unexpected_token(void)
 	TEST_ASSERT_NULL(ast);
 }
 
+/* ========== AST 分配区测试 ========== */
+
+void test_parse_into_arena(void)
+{
+	cel_ast_arena_t *arena = cel_ast_arena_create(0);
+	TEST_ASSERT_NOT_NULL(arena);
+
+	/* 列表超过初始容量 4，数组在分配区中扩大 */
+	cel_ast_arena_t *previous = cel_ast_arena_enter(arena);
+	cel_ast_node_t *ast = parse_expr("f(x, [\"a\", 2, 3, 4, 5], {\"k\": x.y})");
+	cel_ast_arena_leave(previous);
+	TEST_ASSERT_NULL(previous);
+
+	TEST_ASSERT_NOT_NULL(ast);
+	TEST_ASSERT_TRUE(ast->in_arena);
+	TEST_ASSERT_EQUAL_size_t(3, ast->as.call.arg_count);
+	cel_ast_node_t *list = ast->as.call.args[1];
+	TEST_ASSERT_TRUE(list->in_arena);
+	TEST_ASSERT_EQUAL_size_t(5, list->as.list.element_count);
+	TEST_ASSERT_EQUAL_INT64(5, list->as.list.elements[4]->as.literal.value.value.int_value);
+	TEST_ASSERT_TRUE(cel_ast_arena_used(arena) >= 9 * sizeof(cel_ast_node_t));
+
+	/* 复制到堆上的 AST 与分配区无关 (字面量值共享引用) */
+	cel_ast_node_t *copy = cel_ast_copy(ast, NULL, 0, NULL);
+	TEST_ASSERT_NOT_NULL(copy);
+	TEST_ASSERT_FALSE(copy->in_arena);
+
+	/* 分配区中的节点不单独释放 */
+	cel_ast_destroy(ast);
+	cel_ast_arena_destroy(arena);
+
+	cel_ast_node_t *element = copy->as.call.args[1]->as.list.elements[0];
+	TEST_ASSERT_EQUAL_STRING("a", element->as.literal.value.value.string_value->data);
+	cel_ast_destroy(copy);
+
+	/* 没有安装分配区时分配在堆上 */
+	ast = parse_expr("[1, 2]");
+	TEST_ASSERT_FALSE(ast->in_arena);
+	cel_ast_destroy(ast);
+}
+
+void test_parse_error_into_arena(void)
+{
+	cel_ast_arena_t *arena = cel_ast_arena_create(512);
+	cel_ast_arena_t *previous = cel_ast_arena_enter(arena);
+	cel_ast_node_t *ast = parse_expr("f(\"a\", [1, 2, 3, 4, 5], +)");
+	cel_ast_arena_leave(previous);
+
+	/* 解析失败时的部分 AST 随分配区释放 */
+	TEST_ASSERT_NULL(ast);
+	cel_ast_arena_destroy(arena);
+	cel_ast_arena_destroy(NULL);
+}
+
 /* ========== Unity 主函数 ========== */
 
 int main(void)
@@ -469,5 +523,9 @@ int main(void)
 	RUN_TEST(test_parse_error_empty);
 	RUN_TEST(test_parse_error_unexpected_token);
 
+	/* AST 分配区测试 */
+	RUN_TEST(test_parse_into_arena);
+	RUN_TEST(test_parse_error_into_arena);
+
 	return UNITY_END();
 }
@@ -3,11 +3,15 @@
  * @brief CEL Program API 单元测试
  */
 
+#define _POSIX_C_SOURCE 200809L  /* for clock_gettime */
+
 #include "cel/cel_program.h"
 #include "cel/cel_context.h"
 #include "unity.h"
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 /* ========== Unity 设置 ========== */
 
@@ -39,6 +43,10 @@ void test_compile_simple(void)
 	TEST_ASSERT_NOT_NULL(result.program->source);
 	TEST_ASSERT_EQUAL_STRING("1 + 2", result.program->source);
 
+	/* AST 位于程序的分配区中 */
+	TEST_ASSERT_NOT_NULL(result.program->ast_arena);
+	TEST_ASSERT_TRUE(result.program->ast->in_arena);
+
 	cel_compile_result_destroy(&result);
 }
 
@@ -226,6 +234,637 @@ void test_program_reuse(void)
 	cel_compile_result_destroy(&compile);
 }
 
+/* ========== 执行状态测试 ========== */
+
+void test_options_do_not_modify_context(void)
+{
+	cel_compile_result_t compile = cel_compile("1 + 2");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	size_t before = cel_context_get_max_recursion(ctx);
+	cel_execute_options_t options = cel_default_execute_options();
+	options.max_eval_recursion = before + 50;
+	cel_execute_result_t result =
+		cel_execute_with_options(compile.program, ctx, &options);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_size_t(before, cel_context_get_max_recursion(ctx));
+
+	cel_execute_result_destroy(&result);
+	cel_compile_result_destroy(&compile);
+}
+
+void test_recursion_limit(void)
+{
+	cel_value_t x = cel_value_int(1);
+	cel_context_add_variable(ctx, "x", &x);
+
+	/* 深度为 5 的右嵌套 AST (变量阻止常量折叠，左深链按循环求值不计深度)，
+	 * 虚拟机不递归，不受限制 */
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK,
+				  CEL_ENGINE_COMPACT};
+	for (size_t e = 0; e < 3; e++) {
+		cel_compile_options_t compile_options = cel_default_compile_options();
+		compile_options.engine = engines[e];
+		cel_compile_result_t compile = cel_compile_with_options(
+			"x + (x + (x + (x + x)))", &compile_options);
+		TEST_ASSERT_FALSE(compile.has_errors);
+		TEST_ASSERT_EQUAL_size_t(5, compile.program->eval_depth);
+
+		cel_execute_options_t options = cel_default_execute_options();
+		options.max_eval_recursion = 4;
+		cel_execute_result_t result =
+			cel_execute_with_options(compile.program, ctx, &options);
+		TEST_ASSERT_EQUAL(e == 0, result.success);
+		if (!result.success) {
+			TEST_ASSERT_EQUAL_INT(CEL_ERROR_OUT_OF_RANGE,
+					      result.eval_error.code);
+		}
+		cel_execute_result_destroy(&result);
+
+		options.max_eval_recursion = 5;
+		result = cel_execute_with_options(compile.program, ctx, &options);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT64(5, result.value.value.int_value);
+		cel_execute_result_destroy(&result);
+
+		cel_compile_result_destroy(&compile);
+	}
+}
+
+/* 以三种引擎编译 source，并分别在有无线程池时执行 (线程池时总是使用树遍历) */
+static void check_long_chain(const char *source, const cel_value_t *expected,
+			     size_t terms)
+{
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK,
+				  CEL_ENGINE_COMPACT};
+	cel_thread_pool_t *pool = cel_thread_pool_create(2);
+	for (size_t e = 0; e < 3; e++) {
+		cel_compile_options_t options = cel_default_compile_options();
+		options.engine = engines[e];
+		cel_compile_result_t compile =
+			cel_compile_with_options(source, &options);
+		TEST_ASSERT_FALSE(compile.has_errors);
+		TEST_ASSERT_TRUE(compile.program->eval_depth >= terms);
+
+		for (size_t p = 0; p < 2; p++) {
+			cel_execute_options_t exec = cel_default_execute_options();
+			exec.pool = p == 0 ? NULL : pool;
+			cel_execute_result_t result = cel_execute_with_options(
+				compile.program, ctx, &exec);
+			TEST_ASSERT_TRUE(result.success);
+			TEST_ASSERT_TRUE(cel_value_equals(expected, &result.value));
+			cel_execute_result_destroy(&result);
+		}
+		cel_compile_result_destroy(&compile);
+	}
+	if (pool) {
+		cel_thread_pool_destroy(pool);
+	}
+}
+
+void test_long_logical_chain(void)
+{
+	/* a == 0 || a == 1 || ... 的深度远超默认限制，树遍历按循环求值 */
+	enum { TERMS = 1000 };
+	char *source = malloc(TERMS * 16);
+	TEST_ASSERT_NOT_NULL(source);
+	const char *ops[] = {" || ", " && "};
+	const char *cmps[] = {"a == %d", "a != %d"};
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK,
+				  CEL_ENGINE_COMPACT};
+	for (size_t k = 0; k < 2; k++) {
+		size_t length = 0;
+		for (int i = 0; i < TERMS; i++) {
+			if (i > 0) {
+				length += (size_t)sprintf(source + length, "%s", ops[k]);
+			}
+			length += (size_t)sprintf(source + length, cmps[k], i);
+		}
+
+		/* 最后一项决定结果；不在范围内时求值全部操作数 */
+		int64_t values[] = {TERMS - 1, TERMS};
+		for (size_t v = 0; v < 2; v++) {
+			cel_value_t a = cel_value_int(values[v]);
+			cel_context_add_variable(ctx, "a", &a);
+			cel_value_t expected =
+				cel_value_bool(k == 0 ? v == 0 : v == 1);
+			check_long_chain(source, &expected, TERMS);
+		}
+	}
+
+	/* a + a + ... 与 m.n["n"].n... 同样是解析器循环构造的左深链 */
+	size_t length = 0;
+	for (int i = 0; i < TERMS; i++) {
+		length += (size_t)sprintf(source + length, i > 0 ? " + a" : "a");
+	}
+	cel_value_t a = cel_value_int(3);
+	cel_context_add_variable(ctx, "a", &a);
+	cel_value_t sum = cel_value_int(3 * TERMS);
+	check_long_chain(source, &sum, TERMS);
+
+	cel_value_t key = cel_value_string("n");
+	cel_value_t m = cel_value_int(7);
+	for (int i = 0; i < TERMS; i++) {
+		cel_map_t *map = cel_map_create(1);
+		TEST_ASSERT_NOT_NULL(map);
+		TEST_ASSERT_TRUE(cel_map_put(map, &key, &m));
+		cel_value_destroy(&m);
+		m = cel_value_map(map);
+	}
+	cel_context_add_variable(ctx, "m", &m);
+	cel_value_destroy(&m);
+	cel_value_destroy(&key);
+	length = (size_t)sprintf(source, "m");
+	for (int i = 0; i < TERMS; i++) {
+		length += (size_t)sprintf(source + length, i % 2 ? "[\"n\"]" : ".n");
+	}
+	cel_value_t leaf = cel_value_int(7);
+	check_long_chain(source, &leaf, TERMS);
+	free(source);
+
+	/* 链中的类型错误与虚拟机一样定位到操作数所属的节点 */
+	a = cel_value_int(5);
+	cel_context_add_variable(ctx, "a", &a);
+	size_t line = 0, column = 0;
+	for (size_t e = 0; e < 3; e++) {
+		cel_compile_options_t options = cel_default_compile_options();
+		options.engine = engines[e];
+		cel_compile_result_t compile = cel_compile_with_options(
+			"a == 1 || a == 2 ||\n  a || a == 5", &options);
+		TEST_ASSERT_FALSE(compile.has_errors);
+		cel_execute_result_t result = cel_execute(compile.program, ctx);
+		TEST_ASSERT_FALSE(result.success);
+		TEST_ASSERT_EQUAL_INT(CEL_ERROR_TYPE_MISMATCH,
+				      result.eval_error.code);
+		if (e == 0) {
+			line = result.eval_error.line;
+			column = result.eval_error.column;
+			TEST_ASSERT_TRUE(line > 0);
+		}
+		TEST_ASSERT_EQUAL_size_t(line, result.eval_error.line);
+		TEST_ASSERT_EQUAL_size_t(column, result.eval_error.column);
+		cel_execute_result_destroy(&result);
+		cel_compile_result_destroy(&compile);
+	}
+}
+
+void test_exec_state_reuse(void)
+{
+	cel_compile_result_t compile = cel_compile("[x, x * 2, x * 3][x % 3] + size(s)");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	cel_value_t s = cel_value_string("abc");
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	cel_exec_state_t *state = cel_exec_state_create();
+	TEST_ASSERT_NOT_NULL(state);
+
+	for (int64_t i = 0; i < 20; i++) {
+		cel_value_t x = cel_value_int(i);
+		cel_context_add_variable(ctx, "x", &x);
+
+		cel_execute_result_t expected = cel_execute(compile.program, ctx);
+		cel_execute_result_t result = cel_execute_with_state(
+			compile.program, ctx, NULL, state);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT64(expected.value.value.int_value,
+					result.value.value.int_value);
+		cel_execute_result_destroy(&expected);
+		cel_execute_result_destroy(&result);
+	}
+
+	/* 执行状态中的选项同样生效 (递归深度只限制树遍历求值) */
+	cel_compile_options_t compile_options = cel_default_compile_options();
+	compile_options.engine = CEL_ENGINE_TREE_WALK;
+	cel_compile_result_t tree = cel_compile_with_options(
+		"[x, x * 2, x * 3][x % 3] + size(s)", &compile_options);
+	TEST_ASSERT_FALSE(tree.has_errors);
+	cel_execute_options_t options = cel_default_execute_options();
+	options.max_eval_recursion = 2;
+	cel_exec_state_set_options(state, &options);
+	cel_execute_result_t result = cel_execute_with_state(tree.program, ctx,
+							      NULL, state);
+	TEST_ASSERT_FALSE(result.success);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_OUT_OF_RANGE, result.eval_error.code);
+	cel_execute_result_destroy(&result);
+	cel_compile_result_destroy(&tree);
+
+	result = cel_execute_with_state(compile.program, ctx, NULL, NULL);
+	TEST_ASSERT_FALSE(result.success);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT, result.error->code);
+	cel_execute_result_destroy(&result);
+
+	cel_exec_state_destroy(state);
+	cel_compile_result_destroy(&compile);
+}
+
+/* ========== 执行预算测试 ========== */
+
+/**
+ * @brief 上下文函数 spin()：忙等约 200 微秒
+ */
+static cel_result_t fn_spin(cel_func_context_t *fctx, cel_value_t **args,
+			    size_t arg_count)
+{
+	(void)fctx;
+	(void)args;
+	(void)arg_count;
+	static cel_value_t spin_value;
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000000000L +
+			 (now.tv_nsec - start.tv_nsec) < 200000L);
+	spin_value = cel_value_int(1);
+	return cel_ok_result(&spin_value);
+}
+
+static cel_program_t *compile_engine(const char *expr, cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = engine;
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+	cel_program_t *program = compile.program;
+	compile.program = NULL;
+	cel_compile_result_destroy(&compile);
+	return program;
+}
+
+void test_cost_reported(void)
+{
+	/* 每个调用点计 1，字符串参数每 64 字节再计 1 */
+	char text[201];
+	memset(text, 'a', 200);
+	text[200] = '\0';
+	cel_value_t s = cel_value_string(text);
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		cel_program_t *program = compile_engine(
+			"size(s) > 0 && s.startsWith(\"a\") && 1 + 2 == 3", engines[e]);
+		cel_execute_result_t result = cel_execute(program, ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_UINT64((1 + 200 / 64) + (1 + 201 / 64), result.cost);
+		cel_execute_result_destroy(&result);
+		cel_program_destroy(program);
+	}
+}
+
+void test_cost_limit(void)
+{
+	cel_value_t s = cel_value_string("abc");
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		/* 超出限制的错误不会被 || 吸收 */
+		cel_program_t *program = compile_engine(
+			"size(s) + size(s) + size(s) > 0 || true", engines[e]);
+		cel_execute_options_t options = cel_default_execute_options();
+		options.max_cost = 2;
+
+		cel_execute_result_t result =
+			cel_execute_with_options(program, ctx, &options);
+		TEST_ASSERT_FALSE(result.success);
+		TEST_ASSERT_NULL(result.error);
+		TEST_ASSERT_EQUAL_INT(CEL_ERROR_COST_LIMIT, result.eval_error.code);
+		TEST_ASSERT_EQUAL_UINT64(3, result.cost);
+		cel_execute_result_destroy(&result);
+
+		options.max_cost = 3;
+		result = cel_execute_with_options(program, ctx, &options);
+		TEST_ASSERT_TRUE(result.success);
+		cel_execute_result_destroy(&result);
+		cel_program_destroy(program);
+	}
+}
+
+void test_timeout(void)
+{
+	cel_context_add_function(ctx, "spin", fn_spin, 0, 0);
+
+	/* 200 次调用约 40 毫秒，超时 1 毫秒 */
+	char expr[1700] = "[";
+	for (int i = 0; i < 200; i++) {
+		strcat(expr, i ? ", spin()" : "spin()");
+	}
+	strcat(expr, "]");
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		cel_program_t *program = compile_engine(expr, engines[e]);
+		cel_exec_state_t *state = cel_exec_state_create();
+		cel_execute_options_t options = cel_default_execute_options();
+		options.timeout_ms = 1;
+		cel_exec_state_set_options(state, &options);
+
+		cel_execute_result_t result =
+			cel_execute_with_state(program, ctx, NULL, state);
+		TEST_ASSERT_FALSE(result.success);
+		TEST_ASSERT_EQUAL_INT(CEL_ERROR_TIMEOUT, result.eval_error.code);
+		TEST_ASSERT_TRUE(result.cost < 200);
+		cel_execute_result_destroy(&result);
+
+		/* 截止时间计算时截断而不是回绕 */
+		options.timeout_ms = SIZE_MAX;
+		cel_exec_state_set_options(state, &options);
+		result = cel_execute_with_state(program, ctx, NULL, state);
+		TEST_ASSERT_TRUE(result.success);
+		cel_execute_result_destroy(&result);
+
+		cel_exec_state_destroy(state);
+		cel_program_destroy(program);
+	}
+}
+
+/**
+ * @brief 上下文函数 in_scratch(s)：字符串是否来自临时分配区
+ */
+static cel_result_t fn_in_scratch(cel_func_context_t *fctx, cel_value_t **args,
+				  size_t arg_count)
+{
+	(void)fctx;
+	(void)arg_count;
+	static cel_value_t scratch_value;
+	scratch_value = cel_value_bool(args[0]->value.string_value->scratch);
+	return cel_ok_result(&scratch_value);
+}
+
+/* ========== 错误通道测试 ========== */
+
+void test_error_channel(void)
+{
+	cel_value_t zero = cel_value_int(0);
+	cel_context_add_variable(ctx, "zero", &zero);
+
+	static const struct {
+		const char *source;
+		cel_error_code_e code;
+		const char *message;
+	} cases[] = {
+		{"1 +\n  missing", CEL_ERROR_UNKNOWN_IDENTIFIER,
+		 "Undefined variable: missing (line 2, column 3)"},
+		{"{\"a\": 1}.b", CEL_ERROR_NOT_FOUND,
+		 "Field not found: b (line 1, column 9)"},
+		{"[1, 2][zero + 5]", CEL_ERROR_OUT_OF_RANGE,
+		 "List index out of bounds (line 1, column 7)"},
+		{"1 / zero", CEL_ERROR_DIVISION_BY_ZERO,
+		 "Division by zero (line 1, column 3)"},
+		{"nope(1)", CEL_ERROR_UNKNOWN_IDENTIFIER,
+		 "Unknown function: nope (line 1, column 1)"},
+	};
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+			cel_program_t *program =
+				compile_engine(cases[i].source, engines[e]);
+			cel_execute_result_t result = cel_execute(program, ctx);
+			TEST_ASSERT_FALSE(result.success);
+			TEST_ASSERT_NULL(result.error);
+			TEST_ASSERT_EQUAL_INT(cases[i].code, result.eval_error.code);
+
+			char message[128];
+			size_t length = cel_execute_result_message(
+				&result, message, sizeof(message));
+			TEST_ASSERT_EQUAL_STRING(cases[i].message, message);
+			TEST_ASSERT_EQUAL_size_t(strlen(cases[i].message), length);
+
+			/* 缓冲区不足时截断，返回完整长度 */
+			char small[8];
+			TEST_ASSERT_EQUAL_size_t(
+				length, cel_execute_result_message(
+						&result, small, sizeof(small)));
+			TEST_ASSERT_EQUAL_size_t(7, strlen(small));
+			TEST_ASSERT_EQUAL_INT(0, memcmp(cases[i].message, small, 7));
+
+			cel_execute_result_destroy(&result);
+			cel_program_destroy(program);
+		}
+
+		cel_program_t *program = compile_engine("1 + 1", engines[e]);
+		cel_execute_result_t result = cel_execute(program, ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT(CEL_OK, result.eval_error.code);
+		TEST_ASSERT_EQUAL_size_t(
+			0, cel_execute_result_message(&result, NULL, 0));
+		cel_execute_result_destroy(&result);
+		cel_program_destroy(program);
+	}
+
+	/* 参数错误仍给出错误对象 */
+	cel_execute_result_t result = cel_execute(NULL, ctx);
+	TEST_ASSERT_NOT_NULL(result.error);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT, result.eval_error.code);
+	char message[64];
+	cel_execute_result_message(&result, message, sizeof(message));
+	TEST_ASSERT_EQUAL_STRING("Program is NULL or invalid", message);
+	cel_execute_result_destroy(&result);
+}
+
+void test_scratch_arena(void)
+{
+	cel_value_t s = cel_value_string("abc");
+	cel_context_add_variable(ctx, "s", &s);
+	cel_value_destroy(&s);
+	cel_context_add_function(ctx, "in_scratch", fn_in_scratch, 1, 1);
+
+	const char *expressions[] = {
+		"s + \"!\"",
+		"[s + \"1\", [s + \"2\"], size(s)]",
+		"{\"k\": s + \"x\", s + \"y\": [s, s + s]}",
+		"string(size(s)) + s == \"3abc\"",
+		"in_scratch(s + \"!\") || in_scratch(s)",
+	};
+	enum { COUNT = sizeof(expressions) / sizeof(expressions[0]) };
+	cel_execute_result_t results[2][COUNT];
+	cel_value_t expected[COUNT];
+
+	arena_t *arena = arena_create(0);
+	cel_exec_state_t *state = cel_exec_state_create();
+	cel_execute_options_t options = cel_default_execute_options();
+	options.scratch = arena;
+	cel_exec_state_set_options(state, &options);
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		for (size_t i = 0; i < COUNT; i++) {
+			cel_program_t *program = compile_engine(expressions[i], engines[e]);
+			cel_execute_result_t plain = cel_execute(program, ctx);
+			TEST_ASSERT_TRUE(plain.success);
+			if (e == 0) {
+				expected[i] = cel_value_retain(&plain.value);
+			}
+			cel_execute_result_destroy(&plain);
+
+			/* 执行结束后分配区已重置，重复执行不再扩展分配区 */
+			size_t blocks = 0, used = 1, blocks_after = 0;
+			for (int round = 0; round < 50; round++) {
+				if (round > 0) {
+					cel_execute_result_destroy(&results[e][i]);
+				}
+				results[e][i] = round % 2 ?
+					cel_execute_with_options(program, ctx, &options) :
+					cel_execute_with_state(program, ctx, NULL, state);
+				TEST_ASSERT_TRUE(results[e][i].success);
+				arena_stats(arena, NULL, &used, &blocks_after);
+				TEST_ASSERT_EQUAL_size_t(0, used);
+				if (round == 0) {
+					blocks = blocks_after;
+				}
+			}
+			TEST_ASSERT_EQUAL_size_t(blocks, blocks_after);
+			cel_program_destroy(program);
+		}
+	}
+
+	/* 中间值来自临时分配区，上下文变量仍在堆上 */
+	TEST_ASSERT_FALSE(expected[COUNT - 1].value.bool_value);
+	expected[COUNT - 1] = cel_value_bool(true);
+
+	/* 结果已复制到堆上，不受分配区销毁影响 */
+	cel_exec_state_destroy(state);
+	arena_destroy(arena);
+	for (size_t e = 0; e < 2; e++) {
+		for (size_t i = 0; i < COUNT; i++) {
+			TEST_ASSERT_TRUE_MESSAGE(
+				cel_value_equals(&results[e][i].value, &expected[i]),
+				expressions[i]);
+			cel_execute_result_destroy(&results[e][i]);
+		}
+	}
+	for (size_t i = 0; i < COUNT; i++) {
+		cel_value_destroy(&expected[i]);
+	}
+}
+
+/* ========== 部分求值测试 ========== */
+
+/**
+ * @brief 向 map 中添加字符串键
+ */
+static void map_put(cel_map_t *map, const char *key, cel_value_t value)
+{
+	cel_value_t k = cel_value_string(key);
+	cel_map_put(map, &k, &value);
+	cel_value_destroy(&k);
+	cel_value_destroy(&value);
+}
+
+/**
+ * @brief 向上下文添加变量并释放调用者的引用
+ */
+static void add_owned(cel_context_t *context, const char *name,
+		      cel_value_t value)
+{
+	cel_context_add_variable(context, name, &value);
+	cel_value_destroy(&value);
+}
+
+void test_partial_eval(void)
+{
+	/* tenant = {"limit": 100, "regions": ["eu", "us"]}，r = "zz" */
+	cel_list_t *regions = cel_list_create(2);
+	cel_value_t eu = cel_value_string("eu");
+	cel_value_t us = cel_value_string("us");
+	cel_list_append(regions, &eu);
+	cel_list_append(regions, &us);
+	cel_value_destroy(&eu);
+	cel_value_destroy(&us);
+	cel_map_t *tenant = cel_map_create(2);
+	map_put(tenant, "limit", cel_value_int(100));
+	map_put(tenant, "regions", cel_value_list(regions));
+	cel_value_t tenant_value = cel_value_map(tenant);
+
+	/* request = {"amount": 42, "region": "us"} */
+	cel_map_t *request = cel_map_create(2);
+	map_put(request, "amount", cel_value_int(42));
+	map_put(request, "region", cel_value_string("us"));
+
+	cel_context_t *known = cel_context_create();
+	cel_context_add_variable(known, "tenant", &tenant_value);
+	add_owned(known, "r", cel_value_string("zz"));
+	cel_context_add_variable(ctx, "tenant", &tenant_value);
+	add_owned(ctx, "r", cel_value_string("zz"));
+	add_owned(ctx, "request", cel_value_map(request));
+	cel_value_destroy(&tenant_value);
+
+	static const struct {
+		const char *source;
+		bool literal;          /* 剩余程序是否为单个字面量 */
+	} cases[] = {
+		{"request.amount < tenant.limit && "
+		 "request.region in tenant.regions", false},
+		{"size(tenant.regions) * request.amount + tenant.limit", false},
+		{"request.amount > 10 ? tenant.regions[0] : r", false},
+		{"{\"ok\": request.amount <= tenant.limit, \"n\": r + \"!\"}",
+		 false},
+		/* 全部已知 */
+		{"\"us\" in tenant.regions && tenant.limit > size(r)", true},
+		{"[tenant.limit, r, tenant.regions]", true},
+	};
+
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+			cel_program_t *program =
+				compile_engine(cases[i].source, engines[e]);
+			cel_execute_result_t full = cel_execute(program, ctx);
+			TEST_ASSERT_TRUE_MESSAGE(full.success, cases[i].source);
+
+			/* 剩余程序独立于原程序 */
+			cel_program_t *residual = cel_partial_eval(program, known);
+			TEST_ASSERT_NOT_NULL(residual);
+			bool bytecode = program->bytecode != NULL;
+			cel_program_destroy(program);
+			TEST_ASSERT_EQUAL(bytecode, residual->bytecode != NULL);
+			TEST_ASSERT_EQUAL_MESSAGE(
+				cases[i].literal,
+				residual->ast->type == CEL_AST_LITERAL,
+				cases[i].source);
+
+			cel_execute_result_t partial = cel_execute(residual, ctx);
+			TEST_ASSERT_TRUE_MESSAGE(partial.success, cases[i].source);
+			TEST_ASSERT_TRUE_MESSAGE(
+				cel_value_equals(&full.value, &partial.value),
+				cases[i].source);
+			TEST_ASSERT_TRUE(partial.cost <= full.cost);
+			if (cases[i].literal) {
+				TEST_ASSERT_EQUAL_UINT64(0, partial.cost);
+			}
+
+			cel_execute_result_destroy(&partial);
+			cel_execute_result_destroy(&full);
+			cel_program_destroy(residual);
+		}
+	}
+
+	/* 已知部分的函数调用不再计入代价 */
+	cel_program_t *program = compile_engine(
+		"size(tenant.regions) > 1 && string(tenant.limit) != r && "
+		"request.amount > 0", CEL_ENGINE_BYTECODE);
+	cel_program_t *residual = cel_partial_eval(program, known);
+	cel_execute_result_t full = cel_execute(program, ctx);
+	cel_execute_result_t partial = cel_execute(residual, ctx);
+	TEST_ASSERT_TRUE(full.success && partial.success);
+	TEST_ASSERT_EQUAL_UINT64(2, full.cost);
+	TEST_ASSERT_EQUAL_UINT64(0, partial.cost);
+	cel_execute_result_destroy(&partial);
+	cel_execute_result_destroy(&full);
+	cel_program_destroy(residual);
+	cel_program_destroy(program);
+
+	TEST_ASSERT_NULL(cel_partial_eval(NULL, known));
+	cel_context_destroy(known);
+}
+
 /* ========== Main 测试运行器 ========== */
 
 int main(void)
@@ -259,5 +898,21 @@ int main(void)
 	/* 复用测试 */
 	RUN_TEST(test_program_reuse);
 
+	/* 执行状态测试 */
+	RUN_TEST(test_options_do_not_modify_context);
+	RUN_TEST(test_recursion_limit);
+	RUN_TEST(test_long_logical_chain);
+	RUN_TEST(test_exec_state_reuse);
+
+	/* 执行预算测试 */
+	RUN_TEST(test_cost_reported);
+	RUN_TEST(test_cost_limit);
+	RUN_TEST(test_timeout);
+	RUN_TEST(test_error_channel);
+	RUN_TEST(test_scratch_arena);
+
+	/* 部分求值测试 */
+	RUN_TEST(test_partial_eval);
+
 	return UNITY_END();
 }
@@ -0,0 +1,349 @@
+/**
+ * @file test_program_cache.c
+ * @brief CEL 程序缓存单元测试
+ */
+
+#include "cel/cel_program_cache.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define THREADS 8
+#define ITERATIONS 500
+#define SOURCES 40
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static cel_program_cache_t *cache = NULL;
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+	cel_value_t x = cel_value_int(1000);
+	cel_context_add_variable(ctx, "x", &x);
+	cache = NULL;
+}
+
+void tearDown(void)
+{
+	cel_program_cache_destroy(cache);
+	cache = NULL;
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_program_cache_stats_t stats(void)
+{
+	cel_program_cache_stats_t result;
+	cel_program_cache_stats(cache, &result);
+	return result;
+}
+
+/**
+ * @brief 执行程序并检查整数结果
+ */
+static void assert_int_result(const cel_program_t *program, int64_t expected)
+{
+	cel_execute_result_t result = cel_execute(program, ctx);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(expected, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+}
+
+/**
+ * @brief 上下文函数 nested()：在执行期间通过已安装的缓存编译并求值
+ */
+static cel_result_t fn_nested(cel_func_context_t *fctx, cel_value_t **args,
+			      size_t arg_count)
+{
+	(void)args;
+	(void)arg_count;
+	static cel_value_t matched;
+	cel_execute_result_t result =
+		cel_eval_expression("\"ab\" + \"cd\"", fctx->context);
+	matched = cel_value_bool(result.success &&
+				 result.value.type == CEL_TYPE_STRING &&
+				 strcmp(result.value.value.string_value->data,
+					"abcd") == 0);
+	cel_execute_result_destroy(&result);
+	return cel_ok_result(&matched);
+}
+
+/**
+ * @brief 上下文函数 folded()：通过已安装的缓存编译含常量调用的表达式
+ */
+static cel_result_t fn_folded(cel_func_context_t *fctx, cel_value_t **args,
+			      size_t arg_count)
+{
+	(void)args;
+	(void)arg_count;
+	static cel_value_t value;
+	cel_execute_result_t result = cel_eval_expression(
+		"size(\"abcd\") + size(\"ef\") + x", fctx->context);
+	value = result.success ? result.value : cel_value_int(-1);
+	cel_execute_result_destroy(&result);
+	return cel_ok_result(&value);
+}
+
+/* ========== 缓存测试 ========== */
+
+void test_hits_and_misses(void)
+{
+	cache = cel_program_cache_create(64);
+	TEST_ASSERT_EQUAL_size_t(64, stats().capacity);
+
+	cel_compile_result_t first = cel_program_cache_get(cache, "x + 1", NULL);
+	cel_compile_result_t second = cel_program_cache_get(cache, "x + 1", NULL);
+	TEST_ASSERT_FALSE(first.has_errors);
+	TEST_ASSERT_EQUAL_PTR(first.program, second.program);
+	assert_int_result(second.program, 1001);
+
+	/* 编译选项是键的一部分 */
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = CEL_ENGINE_TREE_WALK;
+	cel_compile_result_t tree = cel_program_cache_get(cache, "x + 1", &options);
+	TEST_ASSERT_NOT_EQUAL(first.program, tree.program);
+	TEST_ASSERT_NULL(tree.program->bytecode);
+	assert_int_result(tree.program, 1001);
+
+	cel_program_cache_stats_t s = stats();
+	TEST_ASSERT_EQUAL_UINT64(1, s.hits);
+	TEST_ASSERT_EQUAL_UINT64(2, s.misses);
+	TEST_ASSERT_EQUAL_size_t(2, s.size);
+
+	/* 编译错误不缓存 */
+	cel_compile_result_t bad = cel_program_cache_get(cache, "x +", NULL);
+	TEST_ASSERT_TRUE(bad.has_errors);
+	TEST_ASSERT_NULL(bad.program);
+	cel_compile_result_destroy(&bad);
+	bad = cel_program_cache_get(cache, "x +", NULL);
+	TEST_ASSERT_TRUE(bad.has_errors);
+	cel_compile_result_destroy(&bad);
+	s = stats();
+	TEST_ASSERT_EQUAL_UINT64(4, s.misses);
+	TEST_ASSERT_EQUAL_size_t(2, s.size);
+
+	cel_compile_result_destroy(&first);
+	cel_compile_result_destroy(&second);
+	cel_compile_result_destroy(&tree);
+}
+
+void test_lru_eviction(void)
+{
+	/* 每个分片容量为 2 */
+	cache = cel_program_cache_create(2 * CEL_PROGRAM_CACHE_SHARDS);
+
+	/* 每次插入之后都使用 x，x 始终最近使用，不会被淘汰 */
+	for (int i = 0; i < 200; i++) {
+		char source[32];
+		snprintf(source, sizeof(source), "x + %d", i);
+		cel_compile_result_t other = cel_program_cache_get(cache, source, NULL);
+		cel_compile_result_destroy(&other);
+
+		cel_compile_result_t hot = cel_program_cache_get(cache, "x", NULL);
+		assert_int_result(hot.program, 1000);
+		cel_compile_result_destroy(&hot);
+	}
+
+	cel_program_cache_stats_t s = stats();
+	TEST_ASSERT_EQUAL_UINT64(199, s.hits);
+	TEST_ASSERT_EQUAL_UINT64(201, s.misses);
+	TEST_ASSERT_TRUE(s.size <= s.capacity);
+	TEST_ASSERT_EQUAL_UINT64(201 - s.size, s.evictions);
+}
+
+void test_programs_outlive_cache(void)
+{
+	cache = cel_program_cache_create(CEL_PROGRAM_CACHE_SHARDS);
+	cel_compile_result_t held = cel_program_cache_get(cache, "x * 2", NULL);
+
+	cel_program_cache_clear(cache);
+	TEST_ASSERT_EQUAL_size_t(0, stats().size);
+	assert_int_result(held.program, 2000);
+
+	/* 清空后重新编译 */
+	cel_compile_result_t again = cel_program_cache_get(cache, "x * 2", NULL);
+	TEST_ASSERT_NOT_EQUAL(held.program, again.program);
+
+	cel_program_cache_destroy(cache);
+	cache = NULL;
+	assert_int_result(held.program, 2000);
+	assert_int_result(again.program, 2000);
+	cel_compile_result_destroy(&held);
+	cel_compile_result_destroy(&again);
+
+	/* 容量为 0 时每次都编译 */
+	cache = cel_program_cache_create(0);
+	held = cel_program_cache_get(cache, "x * 2", NULL);
+	assert_int_result(held.program, 2000);
+	cel_compile_result_destroy(&held);
+	TEST_ASSERT_EQUAL_size_t(0, stats().size);
+}
+
+void test_eval_expression_uses_installed_cache(void)
+{
+	cache = cel_program_cache_create(64);
+	TEST_ASSERT_NULL(cel_program_cache_install(cache));
+	TEST_ASSERT_EQUAL_PTR(cache, cel_program_cache_installed());
+
+	for (int i = 0; i < 3; i++) {
+		cel_execute_result_t result = cel_eval_expression("x - 1", ctx);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT64(999, result.value.value.int_value);
+		cel_execute_result_destroy(&result);
+	}
+	cel_execute_result_t result = cel_eval_expression("x -", ctx);
+	TEST_ASSERT_FALSE(result.success);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_SYNTAX, result.eval_error.code);
+	cel_execute_result_destroy(&result);
+
+	TEST_ASSERT_EQUAL_PTR(cache, cel_program_cache_install(NULL));
+	cel_program_cache_stats_t s = stats();
+	TEST_ASSERT_EQUAL_UINT64(2, s.hits);
+	TEST_ASSERT_EQUAL_UINT64(2, s.misses);
+	TEST_ASSERT_EQUAL_size_t(1, s.size);
+}
+
+void test_compile_inside_scratch_execution(void)
+{
+	cache = cel_program_cache_create(64);
+	TEST_ASSERT_NULL(cel_program_cache_install(cache));
+	cel_context_add_function(ctx, "nested", fn_nested, 0, 0);
+
+	/* 缓存的程序在外层执行的临时分配区中编译 */
+	arena_t *arena = arena_create(0);
+	cel_execute_options_t options = cel_default_execute_options();
+	options.scratch = arena;
+	cel_compile_result_t outer = cel_compile("nested()");
+	TEST_ASSERT_FALSE(outer.has_errors);
+	cel_execute_result_t result =
+		cel_execute_with_options(outer.program, ctx, &options);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_TRUE(result.value.value.bool_value);
+	cel_execute_result_destroy(&result);
+	cel_compile_result_destroy(&outer);
+	arena_destroy(arena);
+
+	/* 折叠产生的字面量不在已销毁的分配区中 */
+	result = cel_eval_expression("\"ab\" + \"cd\"", ctx);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_STRING("abcd", result.value.value.string_value->data);
+	TEST_ASSERT_FALSE(result.value.value.string_value->scratch);
+	cel_execute_result_destroy(&result);
+
+	TEST_ASSERT_EQUAL_PTR(cache, cel_program_cache_install(NULL));
+	TEST_ASSERT_EQUAL_UINT64(1, stats().hits);
+}
+
+void test_compile_outside_caller_budget(void)
+{
+	cache = cel_program_cache_create(64);
+	TEST_ASSERT_NULL(cel_program_cache_install(cache));
+	cel_context_add_function(ctx, "folded", fn_folded, 0, 0);
+
+	cel_compile_result_t outer = cel_compile("folded()");
+	TEST_ASSERT_FALSE(outer.has_errors);
+
+	/* 折叠的两次调用不计入外层执行：首次 (缓存未命中) 与再次执行代价相同 */
+	cel_execute_options_t options = cel_default_execute_options();
+	options.max_cost = 1;
+	for (int round = 0; round < 2; round++) {
+		cel_execute_result_t result =
+			cel_execute_with_options(outer.program, ctx, &options);
+		TEST_ASSERT_TRUE(result.success);
+		TEST_ASSERT_EQUAL_INT64(1006, result.value.value.int_value);
+		TEST_ASSERT_EQUAL_UINT64(1, result.cost);
+		cel_execute_result_destroy(&result);
+	}
+	cel_compile_result_destroy(&outer);
+
+	TEST_ASSERT_EQUAL_PTR(cache, cel_program_cache_install(NULL));
+	TEST_ASSERT_EQUAL_UINT64(1, stats().misses);
+	TEST_ASSERT_EQUAL_UINT64(1, stats().hits);
+}
+
+/* ========== 并发测试 ========== */
+
+static void *worker(void *arg)
+{
+	int offset = *(int *)arg;
+	int failures = 0;
+	for (int i = 0; i < ITERATIONS; i++) {
+		int n = (i + offset) % SOURCES;
+		char source[32];
+		snprintf(source, sizeof(source), "x + %d", n);
+
+		cel_compile_result_t compiled = cel_program_cache_get(cache, source, NULL);
+		cel_execute_result_t result = cel_execute(compiled.program, ctx);
+		if (!result.success || result.value.value.int_value != 1000 + n) {
+			failures++;
+		}
+		cel_execute_result_destroy(&result);
+		cel_compile_result_destroy(&compiled);
+	}
+	return (void *)(intptr_t)failures;
+}
+
+static void run_workers(void)
+{
+	pthread_t threads[THREADS];
+	int offsets[THREADS];
+	for (int t = 0; t < THREADS; t++) {
+		offsets[t] = t * 7;
+		TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[t], NULL, worker,
+							&offsets[t]));
+	}
+	for (int t = 0; t < THREADS; t++) {
+		void *failures = NULL;
+		pthread_join(threads[t], &failures);
+		TEST_ASSERT_EQUAL_INT(0, (int)(intptr_t)failures);
+	}
+}
+
+void test_concurrent_access(void)
+{
+	cache = cel_program_cache_create(4 * CEL_PROGRAM_CACHE_SHARDS);
+	run_workers();
+
+	cel_program_cache_stats_t s = stats();
+	TEST_ASSERT_EQUAL_UINT64(THREADS * ITERATIONS, s.hits + s.misses);
+	TEST_ASSERT_TRUE(s.misses >= SOURCES);
+
+	/* 容量不足时淘汰与使用并发进行 */
+	cel_program_cache_destroy(cache);
+	cache = cel_program_cache_create(CEL_PROGRAM_CACHE_SHARDS);
+	run_workers();
+	s = stats();
+	TEST_ASSERT_TRUE(s.size <= s.capacity);
+	TEST_ASSERT_TRUE(s.evictions > 0);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 缓存测试 */
+	RUN_TEST(test_hits_and_misses);
+	RUN_TEST(test_lru_eviction);
+	RUN_TEST(test_programs_outlive_cache);
+	RUN_TEST(test_eval_expression_uses_installed_cache);
+	RUN_TEST(test_compile_inside_scratch_execution);
+	RUN_TEST(test_compile_outside_caller_budget);
+
+	/* 并发测试 */
+	RUN_TEST(test_concurrent_access);
+
+	return UNITY_END();
+}
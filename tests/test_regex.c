@@ -3,9 +3,12 @@
  * @brief CEL 正则表达式 matches() 函数单元测试
  */
 
+#include "cel/cel_bytecode.h"
 #include "cel/cel_eval.h"
 #include "cel/cel_parser.h"
+#include "cel/cel_program.h"
 #include "cel/cel_context.h"
+#include "cel/cel_regex.h"
 #include "unity.h"
 #include <string.h>
 #include <stdlib.h>
@@ -22,6 +25,9 @@ void setUp(void)
 
 void tearDown(void)
 {
+	cel_regex_cache_clear();
+	cel_regex_cache_set_capacity(CEL_REGEX_CACHE_CAPACITY);
+
 	if (ctx) {
 		cel_context_destroy(ctx);
 		ctx = NULL;
@@ -204,6 +210,128 @@ void test_matches_empty_pattern(void)
 	TEST_ASSERT_TRUE(result.value.bool_value);
 }
 
+/* ========== 预编译与缓存测试 ========== */
+
+/**
+ * @brief 编译并执行程序，返回 bool 结果
+ */
+static bool run_program(const cel_program_t *program, bool *value)
+{
+	cel_execute_result_t result = cel_execute(program, ctx);
+	bool success = result.success;
+	if (success) {
+		TEST_ASSERT_EQUAL_INT(CEL_TYPE_BOOL, result.value.type);
+		*value = result.value.value.bool_value;
+	}
+	cel_execute_result_destroy(&result);
+	return success;
+}
+
+void test_literal_pattern_compiled_once(void)
+{
+	cel_compile_result_t compile = cel_compile("text.matches(\"^a+b$\")");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	const cel_bytecode_t *bc = compile.program->bytecode;
+	TEST_ASSERT_NOT_NULL(bc);
+	TEST_ASSERT_EQUAL_size_t(1, bc->regex_count);
+	TEST_ASSERT_EQUAL_INT(CEL_OP_MATCH, bc->code[bc->code_length - 2].op);
+
+	const char *subjects[] = {"aaab", "ab", "b", "aab!"};
+	const bool expected[] = {true, true, false, false};
+	for (size_t i = 0; i < 4; i++) {
+		cel_value_t text = cel_value_string(subjects[i]);
+		cel_context_add_variable(ctx, "text", &text);
+		cel_value_destroy(&text);
+
+		bool value;
+		TEST_ASSERT_TRUE(run_program(compile.program, &value));
+		TEST_ASSERT_EQUAL(expected[i], value);
+	}
+
+	/* 字面量模式不经过动态缓存 */
+	TEST_ASSERT_EQUAL_size_t(0, cel_regex_cache_size());
+
+	cel_compile_result_destroy(&compile);
+}
+
+void test_literal_pattern_errors_at_runtime(void)
+{
+	cel_value_t text = cel_value_string("abc");
+	cel_value_t number = cel_value_int(1);
+	cel_context_add_variable(ctx, "text", &text);
+	cel_context_add_variable(ctx, "number", &number);
+	cel_value_destroy(&text);
+
+	/* 无效模式按普通调用编译，执行时报告错误 */
+	cel_compile_result_t compile = cel_compile("text.matches(\"(\")");
+	TEST_ASSERT_FALSE(compile.has_errors);
+	TEST_ASSERT_EQUAL_size_t(0, compile.program->bytecode->regex_count);
+	bool value;
+	TEST_ASSERT_FALSE(run_program(compile.program, &value));
+	cel_compile_result_destroy(&compile);
+
+	compile = cel_compile("number.matches(\"a\")");
+	TEST_ASSERT_FALSE(compile.has_errors);
+	TEST_ASSERT_FALSE(run_program(compile.program, &value));
+	cel_compile_result_destroy(&compile);
+}
+
+void test_dynamic_pattern_uses_cache(void)
+{
+	cel_value_t text = cel_value_string("hello");
+	cel_context_add_variable(ctx, "text", &text);
+	cel_value_destroy(&text);
+
+	cel_compile_result_t compile = cel_compile("text.matches(pattern)");
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	const char *patterns[] = {"h.*o", "^x", "h.*o"};
+	const bool expected[] = {true, false, true};
+	for (size_t i = 0; i < 3; i++) {
+		cel_value_t pattern = cel_value_string(patterns[i]);
+		cel_context_add_variable(ctx, "pattern", &pattern);
+		cel_value_destroy(&pattern);
+
+		bool value;
+		TEST_ASSERT_TRUE(run_program(compile.program, &value));
+		TEST_ASSERT_EQUAL(expected[i], value);
+	}
+	TEST_ASSERT_EQUAL_size_t(2, cel_regex_cache_size());
+
+	cel_compile_result_destroy(&compile);
+}
+
+void test_cache_capacity_is_bounded(void)
+{
+	cel_regex_cache_set_capacity(2);
+
+	cel_regex_t *held = cel_regex_cache_get("a+", 2, NULL, 0);
+	TEST_ASSERT_NOT_NULL(held);
+
+	const char *patterns[] = {"b+", "c+", "d+"};
+	for (size_t i = 0; i < 3; i++) {
+		cel_regex_t *regex = cel_regex_cache_get(patterns[i], 2, NULL, 0);
+		TEST_ASSERT_NOT_NULL(regex);
+		cel_regex_release(regex);
+		TEST_ASSERT_LESS_OR_EQUAL(2, cel_regex_cache_size());
+	}
+
+	/* 已淘汰的模式在调用者释放之前仍然有效 */
+	bool matched = false;
+	TEST_ASSERT_TRUE(cel_regex_match(held, "xaay", 4, &matched));
+	TEST_ASSERT_TRUE(matched);
+	cel_regex_release(held);
+
+	/* 编译错误不进入缓存 */
+	char error[128] = "";
+	TEST_ASSERT_NULL(cel_regex_cache_get("(", 1, error, sizeof(error)));
+	TEST_ASSERT_TRUE(strlen(error) > 0);
+
+	cel_regex_cache_set_capacity(0);
+	TEST_ASSERT_EQUAL_size_t(0, cel_regex_cache_size());
+}
+
 /* ========== Main 测试运行器 ========== */
 
 int main(void)
@@ -239,5 +367,11 @@ int main(void)
 	RUN_TEST(test_matches_empty_string);
 	RUN_TEST(test_matches_empty_pattern);
 
+	/* 预编译与缓存测试 */
+	RUN_TEST(test_literal_pattern_compiled_once);
+	RUN_TEST(test_literal_pattern_errors_at_runtime);
+	RUN_TEST(test_dynamic_pattern_uses_cache);
+	RUN_TEST(test_cache_capacity_is_bounded);
+
 	return UNITY_END();
 }
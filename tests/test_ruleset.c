@@ -0,0 +1,387 @@
+/**
+ * @file test_ruleset.c
+ * @brief CEL 规则集单元测试
+ */
+
+#include "cel/cel_ruleset.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static cel_schema_t *schema = NULL;
+static cel_ruleset_t *ruleset = NULL;
+static size_t x_slot, y_slot, name_slot;
+static int lookup_calls = 0;
+
+static cel_value_t lookup_value;
+
+/**
+ * @brief 上下文函数 lookup(x) = x * 10，记录调用次数
+ */
+static cel_result_t fn_lookup(cel_func_context_t *fctx, cel_value_t **args,
+			      size_t arg_count)
+{
+	(void)fctx;
+	(void)arg_count;
+	lookup_calls++;
+	lookup_value = cel_value_int(args[0]->value.int_value * 10);
+	return cel_ok_result(&lookup_value);
+}
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+	cel_context_add_function(ctx, "lookup", fn_lookup, 1, 1);
+
+	/* req = {"user": {"email": "bob@example.com", "level": 3}} */
+	cel_map_t *user = cel_map_create(4);
+	cel_value_t key = cel_value_string("email");
+	cel_value_t value = cel_value_string("bob@example.com");
+	cel_map_put(user, &key, &value);
+	cel_value_destroy(&key);
+	cel_value_destroy(&value);
+	key = cel_value_string("level");
+	value = cel_value_int(3);
+	cel_map_put(user, &key, &value);
+	cel_value_destroy(&key);
+
+	cel_map_t *req = cel_map_create(4);
+	key = cel_value_string("user");
+	value = cel_value_map(user);
+	cel_map_put(req, &key, &value);
+	cel_value_destroy(&key);
+	cel_value_destroy(&value);
+
+	value = cel_value_map(req);
+	cel_context_add_variable(ctx, "req", &value);
+	cel_value_destroy(&value);
+
+	schema = cel_schema_create();
+	TEST_ASSERT_NOT_NULL(schema);
+	cel_schema_add_variable(schema, "x", &x_slot);
+	cel_schema_add_variable(schema, "y", &y_slot);
+	cel_schema_add_variable(schema, "name", &name_slot);
+
+	ruleset = cel_ruleset_create(schema);
+	TEST_ASSERT_NOT_NULL(ruleset);
+	lookup_calls = 0;
+}
+
+void tearDown(void)
+{
+	cel_ruleset_destroy(ruleset);
+	ruleset = NULL;
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+	cel_schema_destroy(schema);
+	schema = NULL;
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_program_t *compile_with_schema(const char *expr, cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	options.engine = engine;
+
+	cel_compile_result_t result = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(result.has_errors, expr);
+
+	cel_program_t *program = result.program;
+	result.program = NULL;
+	cel_compile_result_destroy(&result);
+	return program;
+}
+
+/**
+ * @brief 加入规则 (程序加入后立即销毁)
+ */
+static size_t add_rule(const char *expr, int priority)
+{
+	cel_program_t *program = compile_with_schema(expr, CEL_ENGINE_BYTECODE);
+	size_t id;
+	TEST_ASSERT_EQUAL_INT(CEL_OK,
+			      cel_ruleset_add(ruleset, program, priority, &id));
+	cel_program_destroy(program);
+	return id;
+}
+
+static cel_activation_t *make_row(int64_t x, int64_t y, const char *name)
+{
+	cel_activation_t *activation = cel_activation_create(schema);
+	cel_value_t vx = cel_value_int(x);
+	cel_value_t vy = cel_value_int(y);
+	cel_value_t vname = cel_value_string(name);
+	cel_activation_set(activation, x_slot, &vx);
+	cel_activation_set(activation, y_slot, &vy);
+	cel_activation_set(activation, name_slot, &vname);
+	cel_value_destroy(&vname);
+	return activation;
+}
+
+/* ========== 合并测试 ========== */
+
+void test_shared_subexpressions_are_merged(void)
+{
+	add_rule("req.user.level == 1", 0);
+	size_t after_first = cel_ruleset_node_count(ruleset);
+	TEST_ASSERT_EQUAL_size_t(5, after_first);
+
+	/* req, req.user, req.user.level 复用，只新增字面量与比较 */
+	add_rule("req.user.level == 2", 0);
+	TEST_ASSERT_EQUAL_size_t(after_first + 2, cel_ruleset_node_count(ruleset));
+
+	/* 完全相同的规则不新增节点 */
+	add_rule("req.user.level == 2", 0);
+	TEST_ASSERT_EQUAL_size_t(after_first + 2, cel_ruleset_node_count(ruleset));
+	TEST_ASSERT_EQUAL_size_t(3, cel_ruleset_rule_count(ruleset));
+}
+
+void test_shared_call_evaluated_once(void)
+{
+	add_rule("lookup(x) > 10", 0);
+	add_rule("lookup(x) < 100", 0);
+	add_rule("lookup(x) == 50 || lookup(y) == 50", 0);
+
+	cel_activation_t *row = make_row(5, 1, "a");
+	size_t matches[3];
+	size_t matched = cel_ruleset_evaluate(ruleset, ctx, row,
+					      CEL_RULESET_ALL_MATCH, matches);
+
+	TEST_ASSERT_EQUAL_size_t(3, matched);
+	TEST_ASSERT_EQUAL_INT(1, lookup_calls);
+	cel_activation_destroy(row);
+}
+
+/* ========== 求值测试 ========== */
+
+void test_matches_agree_with_programs(void)
+{
+	const char *rules[] = {
+		"x > 10 && y < 3",
+		"x > 10 || name == \"admin\"",
+		"req.user.email.endsWith(\"@example.com\") && x % 2 == 0",
+		"req.user.level >= x",
+		"y != 0 && 100 / y > 20",
+		"100 / y > 20",
+		"x > 0 ? name.startsWith(\"a\") : y == 0",
+		"[x, y, 3].size() == 3 && x in [1, 2, 3]",
+		"{\"k\": x}.k == req.user.level",
+		"x + y",
+		"undefined_var == 1",
+		"x > 10 && y < 3",
+	};
+	size_t rule_count = sizeof(rules) / sizeof(rules[0]);
+	for (size_t i = 0; i < rule_count; i++) {
+		add_rule(rules[i], 0);
+	}
+
+	const char *names[] = {"admin", "alice", "bob"};
+	size_t matches[sizeof(rules) / sizeof(rules[0])];
+
+	for (int64_t x = -2; x < 16; x += 3) {
+		for (int64_t y = 0; y < 6; y += 2) {
+			cel_activation_t *row =
+				make_row(x, y, names[(size_t)(x + 2 + y) % 3]);
+			size_t matched = cel_ruleset_evaluate(
+				ruleset, ctx, row, CEL_RULESET_ALL_MATCH, matches);
+
+			size_t expected = 0;
+			for (size_t i = 0; i < rule_count; i++) {
+				cel_program_t *program =
+					compile_with_schema(rules[i], CEL_ENGINE_TREE_WALK);
+				cel_execute_result_t result =
+					cel_execute_with_activation(program, ctx, row);
+				bool match = result.success &&
+					     result.value.type == CEL_TYPE_BOOL &&
+					     result.value.value.bool_value;
+				if (match) {
+					TEST_ASSERT_TRUE_MESSAGE(expected < matched, rules[i]);
+					TEST_ASSERT_EQUAL_INT_MESSAGE(i, matches[expected], rules[i]);
+					expected++;
+				}
+				cel_execute_result_destroy(&result);
+				cel_program_destroy(program);
+			}
+			TEST_ASSERT_EQUAL_INT(expected, matched);
+			cel_activation_destroy(row);
+		}
+	}
+}
+
+void test_first_match_by_priority(void)
+{
+	size_t low = add_rule("x > 0", 1);
+	size_t high = add_rule("x > 5", 10);
+	size_t tie = add_rule("x > 1", 10);
+	(void)low;
+
+	size_t match;
+	cel_activation_t *row = make_row(7, 0, "a");
+	TEST_ASSERT_EQUAL_size_t(1, cel_ruleset_evaluate(ruleset, ctx, row,
+							 CEL_RULESET_FIRST_MATCH,
+							 &match));
+	TEST_ASSERT_EQUAL_size_t(high, match);
+	cel_activation_destroy(row);
+
+	/* 相同优先级先加入者优先 */
+	row = make_row(3, 0, "a");
+	TEST_ASSERT_EQUAL_size_t(1, cel_ruleset_evaluate(ruleset, ctx, row,
+							 CEL_RULESET_FIRST_MATCH,
+							 &match));
+	TEST_ASSERT_EQUAL_size_t(tie, match);
+	cel_activation_destroy(row);
+
+	row = make_row(-1, 0, "a");
+	TEST_ASSERT_EQUAL_size_t(0, cel_ruleset_evaluate(ruleset, ctx, row,
+							 CEL_RULESET_FIRST_MATCH,
+							 &match));
+	cel_activation_destroy(row);
+}
+
+void test_schema_mismatch(void)
+{
+	cel_compile_result_t result = cel_compile("x > 1");
+	TEST_ASSERT_FALSE(result.has_errors);
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT,
+			      cel_ruleset_add(ruleset, result.program, 0, NULL));
+	cel_compile_result_destroy(&result);
+	TEST_ASSERT_EQUAL_size_t(0, cel_ruleset_rule_count(ruleset));
+}
+
+/* ========== 谓词索引测试 ========== */
+
+void test_guards_prune_candidates(void)
+{
+	char expr[64];
+	for (int i = 0; i < 50; i++) {
+		snprintf(expr, sizeof(expr), "name == \"t%d\" && lookup(%d) > 0", i, i);
+		add_rule(expr, 0);
+	}
+	for (int i = 0; i < 50; i++) {
+		snprintf(expr, sizeof(expr), "%d <= x && lookup(%d) > 0", i, 100 + i);
+		add_rule(expr, 0);
+	}
+	size_t unguarded = add_rule("lookup(y) > 0", 0);
+	TEST_ASSERT_EQUAL_size_t(100, cel_ruleset_indexed_count(ruleset));
+
+	/* 等值守卫只命中 t7，范围守卫命中 0 <= x .. 2 <= x */
+	size_t matches[101];
+	cel_activation_t *row = make_row(2, 1, "t7");
+	size_t matched = cel_ruleset_evaluate(ruleset, ctx, row,
+					      CEL_RULESET_ALL_MATCH, matches);
+	TEST_ASSERT_EQUAL_size_t(5, matched);
+	TEST_ASSERT_EQUAL_INT(5, lookup_calls);
+	TEST_ASSERT_EQUAL_size_t(7, matches[0]);
+	TEST_ASSERT_EQUAL_size_t(50, matches[1]);
+	TEST_ASSERT_EQUAL_size_t(52, matches[3]);
+	TEST_ASSERT_EQUAL_size_t(unguarded, matches[4]);
+	cel_activation_destroy(row);
+
+	/* 守卫字段类型不符时没有候选 */
+	lookup_calls = 0;
+	row = make_row(-1, 1, "nobody");
+	matched = cel_ruleset_evaluate(ruleset, ctx, row, CEL_RULESET_ALL_MATCH,
+				       matches);
+	TEST_ASSERT_EQUAL_size_t(1, matched);
+	TEST_ASSERT_EQUAL_INT(1, lookup_calls);
+	cel_activation_destroy(row);
+}
+
+void test_indexed_matches_agree_with_programs(void)
+{
+	const char *rules[] = {
+		"x >= 3",
+		"3 < x && y > 0",
+		"x < 2.5",
+		"x == 4 && name != \"bob\"",
+		"y == 2.0",
+		"name == \"bob\" && x > 0",
+		"x > 1.5 && name == \"alice\"",
+		"req.user.level == 3 && x > 0",
+		"-1.0 > x",
+		"x <= 4 && y >= 2",
+		"2 >= y && x == -2",
+		"name == \"alice\" || x == 1",
+		"x == 7 && x == 1",
+	};
+	size_t rule_count = sizeof(rules) / sizeof(rules[0]);
+	for (size_t i = 0; i < rule_count; i++) {
+		add_rule(rules[i], (int)(i % 3));
+	}
+
+	const char *names[] = {"admin", "alice", "bob"};
+	size_t matches[sizeof(rules) / sizeof(rules[0])];
+
+	for (int64_t x = -2; x < 8; x++) {
+		for (int64_t y = 0; y < 4; y++) {
+			cel_activation_t *row =
+				make_row(x, y, names[(size_t)(x + 2 + y) % 3]);
+			size_t matched = cel_ruleset_evaluate(
+				ruleset, ctx, row, CEL_RULESET_ALL_MATCH, matches);
+
+			size_t expected = 0;
+			size_t first = rule_count;
+			for (size_t i = 0; i < rule_count; i++) {
+				cel_program_t *program =
+					compile_with_schema(rules[i], CEL_ENGINE_TREE_WALK);
+				cel_execute_result_t result =
+					cel_execute_with_activation(program, ctx, row);
+				bool match = result.success &&
+					     result.value.type == CEL_TYPE_BOOL &&
+					     result.value.value.bool_value;
+				if (match) {
+					TEST_ASSERT_TRUE_MESSAGE(expected < matched, rules[i]);
+					TEST_ASSERT_EQUAL_INT_MESSAGE(i, matches[expected], rules[i]);
+					expected++;
+					if (first == rule_count || i % 3 > first % 3) {
+						first = i;
+					}
+				}
+				cel_execute_result_destroy(&result);
+				cel_program_destroy(program);
+			}
+			TEST_ASSERT_EQUAL_INT(expected, matched);
+
+			matched = cel_ruleset_evaluate(ruleset, ctx, row,
+						       CEL_RULESET_FIRST_MATCH, matches);
+			TEST_ASSERT_EQUAL_size_t(expected > 0 ? 1 : 0, matched);
+			if (matched) {
+				TEST_ASSERT_EQUAL_size_t(first, matches[0]);
+			}
+			cel_activation_destroy(row);
+		}
+	}
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 合并测试 */
+	RUN_TEST(test_shared_subexpressions_are_merged);
+	RUN_TEST(test_shared_call_evaluated_once);
+
+	/* 求值测试 */
+	RUN_TEST(test_matches_agree_with_programs);
+	RUN_TEST(test_first_match_by_priority);
+	RUN_TEST(test_schema_mismatch);
+
+	/* 谓词索引测试 */
+	RUN_TEST(test_guards_prune_candidates);
+	RUN_TEST(test_indexed_matches_agree_with_programs);
+
+	return UNITY_END();
+}
@@ -0,0 +1,395 @@
+/**
+ * @file test_serialize.c
+ * @brief CEL 程序序列化与程序包单元测试
+ */
+
+#define _POSIX_C_SOURCE 200809L  /* for mkstemp */
+
+#include "cel/cel_serialize.h"
+#include "cel/cel_incremental.h"
+#include "cel/cel_program.h"
+#include "cel/cel_context.h"
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* ========== Unity 设置 ========== */
+
+static cel_context_t *ctx = NULL;
+static char bundle_path[] = "/tmp/cel_bundle_XXXXXX";
+
+static cel_value_t seven_value;
+
+/**
+ * @brief 上下文函数 seven() 返回 7
+ */
+static cel_result_t fn_seven(cel_func_context_t *fctx, cel_value_t **args,
+			     size_t arg_count)
+{
+	(void)fctx;
+	(void)args;
+	(void)arg_count;
+	seven_value = cel_value_int(7);
+	return cel_ok_result(&seven_value);
+}
+
+static void add_owned(cel_context_t *context, const char *name,
+		      cel_value_t value)
+{
+	cel_context_add_variable(context, name, &value);
+	cel_value_destroy(&value);
+}
+
+void setUp(void)
+{
+	ctx = cel_context_create();
+	TEST_ASSERT_NOT_NULL(ctx);
+	add_owned(ctx, "x", cel_value_int(7));
+	add_owned(ctx, "s", cel_value_string("abc"));
+
+	cel_list_t *items = cel_list_create(3);
+	for (int64_t i = 1; i <= 3; i++) {
+		cel_value_t v = cel_value_int(i);
+		cel_list_append(items, &v);
+	}
+	add_owned(ctx, "items", cel_value_list(items));
+	cel_context_add_function(ctx, "seven", fn_seven, 0, 0);
+}
+
+void tearDown(void)
+{
+	if (ctx) {
+		cel_context_destroy(ctx);
+		ctx = NULL;
+	}
+}
+
+/* ========== 辅助函数 ========== */
+
+static cel_program_t *compile_engine(const char *expr, cel_engine_e engine)
+{
+	cel_compile_options_t options = cel_default_compile_options();
+	options.engine = engine;
+	cel_compile_result_t compile = cel_compile_with_options(expr, &options);
+	TEST_ASSERT_FALSE_MESSAGE(compile.has_errors, expr);
+	cel_program_t *program = compile.program;
+	compile.program = NULL;
+	cel_compile_result_destroy(&compile);
+	return program;
+}
+
+/**
+ * @brief 序列化后以复制方式加载
+ */
+static cel_program_t *round_trip(const cel_program_t *program)
+{
+	size_t size = cel_program_serialize(program, NULL, 0);
+	TEST_ASSERT_TRUE(size > 0);
+	void *image = malloc(size);
+	TEST_ASSERT_EQUAL_size_t(size, cel_program_serialize(program, image, size));
+	cel_program_t *loaded = cel_program_deserialize(image, size, NULL);
+	free(image);
+	TEST_ASSERT_NOT_NULL(loaded);
+	return loaded;
+}
+
+/**
+ * @brief 两个程序的执行结果 (包括错误与位置) 相同
+ */
+static void assert_same_result(const cel_program_t *expected_program,
+			       const cel_program_t *actual_program,
+			       const char *source)
+{
+	cel_execute_result_t expected = cel_execute(expected_program, ctx);
+	cel_execute_result_t actual = cel_execute(actual_program, ctx);
+	TEST_ASSERT_EQUAL_MESSAGE(expected.success, actual.success, source);
+	TEST_ASSERT_EQUAL_INT(expected.eval_error.code, actual.eval_error.code);
+	TEST_ASSERT_EQUAL_UINT64(expected.cost, actual.cost);
+	if (expected.success) {
+		TEST_ASSERT_TRUE_MESSAGE(cel_value_equals(&expected.value,
+							  &actual.value),
+					 source);
+	} else {
+		char expected_message[128], actual_message[128];
+		cel_execute_result_message(&expected, expected_message,
+					   sizeof(expected_message));
+		cel_execute_result_message(&actual, actual_message,
+					   sizeof(actual_message));
+		TEST_ASSERT_EQUAL_STRING(expected_message, actual_message);
+	}
+	cel_execute_result_destroy(&expected);
+	cel_execute_result_destroy(&actual);
+}
+
+static const char *sources[] = {
+	"x * 6 + 1",
+	"\"a\\tb\" + s + \"c\"",
+	"b\"\\x00\\x01\" == b\"\\x00\\x01\"",
+	"[1, 2u, 3.5, null, true, \"str\"][x - 6]",
+	"{\"k\": [1, 2], \"m\": {\"n\": x}}[\"m\"][\"n\"] > 5",
+	"size(s) > 2 ? s.startsWith(\"ab\") : s.endsWith(\"z\")",
+	"s.contains(\"b\") && x in items || seven() == x",
+	"duration(\"1h30m\") > duration(\"90s\") && int(timestamp(\"2024-01-01T00:00:00Z\")) > 0",
+	"s.matches(\"^a.c$\")",
+	"x > 0 &&\n  10 / (x - 7) > 1",
+	"missing + 1",
+};
+
+/* ========== 序列化测试 ========== */
+
+void test_round_trip(void)
+{
+	cel_engine_e engines[] = {CEL_ENGINE_BYTECODE, CEL_ENGINE_TREE_WALK};
+	for (size_t e = 0; e < 2; e++) {
+		for (size_t i = 0; i < sizeof(sources) / sizeof(sources[0]); i++) {
+			cel_program_t *program = compile_engine(sources[i], engines[e]);
+			cel_program_t *loaded = round_trip(program);
+			TEST_ASSERT_EQUAL(program->bytecode != NULL,
+					  loaded->bytecode != NULL);
+			TEST_ASSERT_EQUAL_STRING(sources[i],
+						 cel_program_get_source(loaded));
+			TEST_ASSERT_EQUAL_size_t(program->eval_depth,
+						 loaded->eval_depth);
+			assert_same_result(program, loaded, sources[i]);
+
+			/* 加载的程序可以再次序列化 */
+			cel_program_t *again = round_trip(loaded);
+			assert_same_result(program, again, sources[i]);
+
+			cel_program_destroy(program);
+			cel_program_destroy(loaded);
+			cel_program_destroy(again);
+		}
+	}
+}
+
+void test_size_query_and_invalid_images(void)
+{
+	cel_program_t *program = compile_engine("x + size(s)",
+						CEL_ENGINE_BYTECODE);
+	size_t size = cel_program_serialize(program, NULL, 0);
+	TEST_ASSERT_TRUE(size > 0);
+
+	/* 缓冲区不足时不写入 */
+	unsigned char *image = calloc(1, size);
+	TEST_ASSERT_EQUAL_size_t(size, cel_program_serialize(program, image,
+							     size - 1));
+	TEST_ASSERT_EQUAL_INT(0, image[0]);
+	TEST_ASSERT_EQUAL_INT(0, image[size - 2]);
+	cel_program_serialize(program, image, size);
+
+	/* 截断、魔数与版本 */
+	TEST_ASSERT_NULL(cel_program_deserialize(image, size / 2, NULL));
+	TEST_ASSERT_NULL(cel_program_deserialize(image, 8, NULL));
+	image[0] ^= 0xff;
+	TEST_ASSERT_NULL(cel_program_deserialize(image, size, NULL));
+	image[0] ^= 0xff;
+	image[4]++;
+	TEST_ASSERT_NULL(cel_program_deserialize(image, size, NULL));
+	image[4]--;
+
+	/* 没有使用 schema 编译的程序不能以 schema 加载 */
+	cel_schema_t *schema = cel_schema_create();
+	TEST_ASSERT_NULL(cel_program_deserialize(image, size, schema));
+	cel_schema_destroy(schema);
+
+	cel_program_t *loaded = cel_program_deserialize(image, size, NULL);
+	TEST_ASSERT_NOT_NULL(loaded);
+	assert_same_result(program, loaded, "x + size(s)");
+
+	TEST_ASSERT_EQUAL_size_t(0, cel_program_serialize(NULL, NULL, 0));
+	TEST_ASSERT_NULL(cel_program_deserialize(NULL, size, NULL));
+
+	free(image);
+	cel_program_destroy(loaded);
+	cel_program_destroy(program);
+}
+
+void test_schema(void)
+{
+	cel_schema_t *schema = cel_schema_create();
+	size_t slot;
+	cel_schema_add_variable(schema, "a", &slot);
+	cel_schema_add_variable(schema, "b", &slot);
+	cel_compile_options_t options = cel_default_compile_options();
+	options.schema = schema;
+	cel_compile_result_t compile = cel_compile_with_options("a * 10 + b",
+								&options);
+	TEST_ASSERT_FALSE(compile.has_errors);
+
+	size_t size = cel_program_serialize(compile.program, NULL, 0);
+	void *image = malloc(size);
+	cel_program_serialize(compile.program, image, size);
+
+	/* 声明顺序不同的 schema 槽位不一致 */
+	cel_schema_t *reordered = cel_schema_create();
+	cel_schema_add_variable(reordered, "b", &slot);
+	cel_schema_add_variable(reordered, "a", &slot);
+	TEST_ASSERT_NULL(cel_program_deserialize(image, size, reordered));
+	TEST_ASSERT_NULL(cel_program_deserialize(image, size, NULL));
+
+	cel_program_t *loaded = cel_program_deserialize(image, size, schema);
+	TEST_ASSERT_NOT_NULL(loaded);
+	cel_activation_t *activation = cel_activation_create(schema);
+	cel_value_t a = cel_value_int(4), b = cel_value_int(2);
+	cel_activation_set_variable(activation, "a", &a);
+	cel_activation_set_variable(activation, "b", &b);
+	cel_execute_result_t result =
+		cel_execute_with_activation(loaded, ctx, activation);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_EQUAL_INT64(42, result.value.value.int_value);
+	cel_execute_result_destroy(&result);
+
+	cel_activation_destroy(activation);
+	cel_program_destroy(loaded);
+	free(image);
+	cel_compile_result_destroy(&compile);
+	cel_schema_destroy(reordered);
+	cel_schema_destroy(schema);
+}
+
+/**
+ * @brief items.exists(x, x == a + 1) (宏展开形式)
+ */
+static cel_ast_node_t *exists_ast(void)
+{
+	cel_token_location_t loc = {0};
+	cel_ast_node_t *predicate = cel_ast_create_binary(
+		CEL_BINARY_EQ, cel_ast_create_ident("x", 1, loc),
+		cel_ast_create_binary(CEL_BINARY_ADD,
+				      cel_ast_create_ident("a", 1, loc),
+				      cel_ast_create_literal(cel_value_int(1), loc),
+				      loc),
+		loc);
+	return cel_ast_create_comprehension(
+		"x", 1, NULL, 0, cel_ast_create_ident("items", 5, loc),
+		"@result", 7, cel_ast_create_literal(cel_value_bool(false), loc),
+		cel_ast_create_unary(CEL_UNARY_NOT,
+				     cel_ast_create_ident("@result", 7, loc), loc),
+		cel_ast_create_binary(CEL_BINARY_OR,
+				      cel_ast_create_ident("@result", 7, loc),
+				      predicate, loc),
+		cel_ast_create_ident("@result", 7, loc), loc);
+}
+
+void test_names_outside_source(void)
+{
+	/* 推导式的名称不在源代码中，保存在映像的名称表里 */
+	char source[] = "";
+	cel_program_t program = {
+		.ast = exists_ast(),
+		.eval_depth = 10,
+		.source = source,
+	};
+	program.bytecode = cel_bytecode_compile(program.ast, NULL);
+	TEST_ASSERT_NOT_NULL(program.bytecode);
+	add_owned(ctx, "a", cel_value_int(2));
+
+	cel_program_t *loaded = round_trip(&program);
+	TEST_ASSERT_EQUAL_STRING("", cel_program_get_source(loaded));
+	assert_same_result(&program, loaded, "exists");
+
+	/* 部分求值与增量求值的结果独立于加载的程序 */
+	cel_context_t *known = cel_context_create();
+	add_owned(known, "a", cel_value_int(2));
+	cel_program_t *residual = cel_partial_eval(loaded, known);
+	cel_incremental_t *inc = cel_incremental_create(loaded);
+	TEST_ASSERT_NOT_NULL(residual);
+	TEST_ASSERT_NOT_NULL(inc);
+	cel_program_destroy(loaded);
+
+	assert_same_result(&program, residual, "residual");
+	cel_execute_result_t result = cel_incremental_evaluate(inc, ctx);
+	TEST_ASSERT_TRUE(result.success);
+	TEST_ASSERT_TRUE(result.value.value.bool_value);
+	cel_execute_result_destroy(&result);
+
+	cel_incremental_destroy(inc);
+	cel_program_destroy(residual);
+	cel_context_destroy(known);
+	cel_bytecode_destroy(program.bytecode);
+	cel_ast_destroy(program.ast);
+}
+
+/* ========== 程序包测试 ========== */
+
+void test_bundle(void)
+{
+	int fd = mkstemp(bundle_path);
+	TEST_ASSERT_TRUE(fd >= 0);
+	close(fd);
+
+	size_t count = sizeof(sources) / sizeof(sources[0]);
+	cel_program_t *programs[sizeof(sources) / sizeof(sources[0])];
+	for (size_t i = 0; i < count; i++) {
+		programs[i] = compile_engine(sources[i], i % 3 == 0 ?
+						 CEL_ENGINE_TREE_WALK :
+						 CEL_ENGINE_BYTECODE);
+	}
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_bundle_write(bundle_path, programs,
+						       count));
+
+	cel_bundle_t *bundle = cel_bundle_open(bundle_path);
+	TEST_ASSERT_NOT_NULL(bundle);
+	TEST_ASSERT_EQUAL_size_t(count, cel_bundle_count(bundle));
+	TEST_ASSERT_NULL(cel_bundle_load(bundle, count, NULL));
+
+	cel_program_t *loaded[sizeof(sources) / sizeof(sources[0])];
+	for (size_t i = 0; i < count; i++) {
+		loaded[i] = cel_bundle_load(bundle, i, NULL);
+		TEST_ASSERT_NOT_NULL(loaded[i]);
+		TEST_ASSERT_EQUAL_PTR(bundle, loaded[i]->bundle);
+		if (loaded[i]->bytecode) {
+			TEST_ASSERT_TRUE(loaded[i]->bytecode->borrowed);
+		}
+	}
+
+	/* 程序持有程序包的引用，替换文件不影响已映射的内容 */
+	cel_bundle_close(bundle);
+	TEST_ASSERT_EQUAL_INT(CEL_OK, cel_bundle_write(bundle_path, programs, 1));
+	for (size_t i = 0; i < count; i++) {
+		TEST_ASSERT_EQUAL_STRING(sources[i],
+					 cel_program_get_source(loaded[i]));
+		assert_same_result(programs[i], loaded[i], sources[i]);
+		cel_program_destroy(loaded[i]);
+	}
+
+	bundle = cel_bundle_open(bundle_path);
+	TEST_ASSERT_EQUAL_size_t(1, cel_bundle_count(bundle));
+	cel_bundle_close(bundle);
+
+	/* 无效的文件 */
+	TEST_ASSERT_NULL(cel_bundle_open("/nonexistent/cel.bundle"));
+	FILE *file = fopen(bundle_path, "wb");
+	fputs("not a bundle, just some text padding it out", file);
+	fclose(file);
+	TEST_ASSERT_NULL(cel_bundle_open(bundle_path));
+	TEST_ASSERT_EQUAL_INT(CEL_ERROR_INVALID_ARGUMENT,
+			      cel_bundle_write("/nonexistent/cel.bundle",
+					       programs, count));
+
+	for (size_t i = 0; i < count; i++) {
+		cel_program_destroy(programs[i]);
+	}
+	remove(bundle_path);
+}
+
+/* ========== Main 测试运行器 ========== */
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	/* 序列化测试 */
+	RUN_TEST(test_round_trip);
+	RUN_TEST(test_size_query_and_invalid_images);
+	RUN_TEST(test_schema);
+	RUN_TEST(test_names_outside_source);
+
+	/* 程序包测试 */
+	RUN_TEST(test_bundle);
+
+	return UNITY_END();
+}